@@ -178,6 +178,41 @@ namespace Loki
         typedef TList ConcreteProductList;
     };
 
+////////////////////////////////////////////////////////////////////////////////
+// class template FlatConcreteFactory
+// Implements an AbstractFactory interface with compile-time flat dispatch.
+// ConcreteFactory resolves Create<T> through the chain of Fields casts and
+// one virtual DoCreate per unit, so the cost of a creation grows with the
+// product typelist and nothing inlines.  Here the concrete product for T is
+// looked up with TL::IndexOf / TL::TypeAt at compile time instead, so a
+// direct Create<T> call compiles down to a plain new-expression regardless
+// of family size.  Only the stateless OpNewFactoryUnit creator can be
+// bypassed this way - a prototype unit carries per-product state in the
+// hierarchy - which is why this factory does not take a Creator parameter.
+// Calls through the AbstractFact interface still dispatch virtually.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class AbstractFact,
+        class TList = typename AbstractFact::ProductList
+    >
+    class FlatConcreteFactory
+        : public ConcreteFactory<AbstractFact, OpNewFactoryUnit, TList>
+    {
+    public:
+        typedef typename AbstractFact::ProductList ProductList;
+        typedef TList ConcreteProductList;
+
+        // Shadows AbstractFactory::Create for calls on the concrete type.
+        template <class T> T* Create()
+        {
+            typedef typename TL::TypeAt<ConcreteProductList,
+                TL::IndexOf<ProductList, T>::value>::Result ConcreteProduct;
+            return new ConcreteProduct;
+        }
+    };
+
 } // namespace Loki
 
 
@@ -20,10 +20,271 @@
 
 #include <loki/SmallObj.h>
 
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+#include <typeinfo>
+#endif
+
+/** @par Macro: LOKI_ALLOCATOR_TRACK_USAGE
+ Define this macro to make every LokiAllocator instantiation count its
+ allocations, bytes and refusals (requests above the small-object threshold
+ that fall through to the default allocator).  Each instantiation - each
+ (element type, allocator singleton) pair, which for node containers means
+ each container instantiation after rebind - keeps its own counters, read
+ through LokiAllocator::GetUsage.  Counting is plain increments, so totals
+ are approximate when several threads share one instantiation; without the
+ macro the counters do not exist and allocate stays as it always was.
+ */
+#ifndef LOKI_ALLOCATOR_TRACK_USAGE
+//#define LOKI_ALLOCATOR_TRACK_USAGE
+#endif
+
+/** @par Macro: LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+ Define this macro to give LokiAllocator a cache tier for requests too big
+ for the small-object allocator: sizes up to
+ LOKI_ALLOCATOR_LARGE_BLOCK_MAX are rounded to the next power of two and
+ served from a per-size free list of previously released blocks, so
+ recurring mid-size allocations - hash-table bucket arrays being the
+ classic case - stop going through the heap on every rehash.  Retention is
+ bounded: each size class keeps at most
+ LOKI_ALLOCATOR_LARGE_BLOCK_RETENTION blocks, anything beyond that is
+ returned to the heap at once.  Without the macro oversized requests fall
+ through to the default allocator exactly as before.
+ */
+#ifndef LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+//#define LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+#endif
+
+/// Largest request, in bytes, served by the large-block cache.
+#ifndef LOKI_ALLOCATOR_LARGE_BLOCK_MAX
+#define LOKI_ALLOCATOR_LARGE_BLOCK_MAX ( 1024 * 1024 )
+#endif
+
+/// Blocks each power-of-two size class may retain while idle.
+#ifndef LOKI_ALLOCATOR_LARGE_BLOCK_RETENTION
+#define LOKI_ALLOCATOR_LARGE_BLOCK_RETENTION 8
+#endif
+
 
 namespace Loki
 {
 
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+
+/** @class AllocatorUsage
+ What one LokiAllocator instantiation did since start-up (or the last
+ Reset): how often it allocated, how many bytes it asked for, and how many
+ requests were too big for the small-object allocator and went to the
+ default allocator instead.  A high refusal share means the instantiation
+ gains nothing from LokiAllocator.
+ */
+struct AllocatorUsage
+{
+    AllocatorUsage( void ) :
+        allocations( 0 ), deallocations( 0 ), bytes( 0 ), refusals( 0 ),
+        elementName( 0 ), elementSize( 0 ), next( 0 ), listed( false ) {}
+
+    void Reset( void )
+    {
+        allocations = 0;
+        deallocations = 0;
+        bytes = 0;
+        refusals = 0;
+    }
+
+    ::std::size_t allocations;   ///< # of calls to allocate
+    ::std::size_t deallocations; ///< # of calls to deallocate
+    ::std::size_t bytes;         ///< total bytes requested via allocate
+    ::std::size_t refusals;      ///< requests above the small-object limit
+
+    const char * elementName;    ///< type_info name of the element type
+    ::std::size_t elementSize;   ///< sizeof the element type
+    AllocatorUsage * next;       ///< next instantiation in the usage list
+    bool listed;                 ///< already on the usage list
+};
+
+/** Head of the list of all LokiAllocator instantiations that allocated at
+ least once.  Containers rebind their allocator to internal node types one
+ cannot name portably, so the way to see what std::list<T, LokiAllocator<T>>
+ really did is to walk this list; elementName and elementSize identify each
+ entry.  Registration happens on an instantiation's first allocation and is
+ not synchronized - like the counters themselves it is meant for profiling
+ runs, not bookkeeping.
+ */
+inline AllocatorUsage * & AllocatorUsageHead( void )
+{
+    static AllocatorUsage * head = 0;
+    return head;
+}
+
+#endif // LOKI_ALLOCATOR_TRACK_USAGE
+
+
+//-----------------------------------------------------------------------------
+
+#ifdef LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+
+/** @class LargeBlockCache
+ Free lists of power-of-two blocks between the small-object limit and
+ LOKI_ALLOCATOR_LARGE_BLOCK_MAX, shared by all LokiAllocator
+ instantiations.  A request is rounded up to its size class and served
+ from the class's list when a block is available; a release pushes the
+ block back unless the class already retains
+ LOKI_ALLOCATOR_LARGE_BLOCK_RETENTION blocks, in which case it goes back
+ to the heap.  The worst case held while idle is therefore the retention
+ count times the sum of the class sizes.  Guarded by a Loki::Mutex, so it
+ is safe under the library's threading macros and free of cost without
+ them.  The free-list link lives inside each cached block, so the cache
+ itself allocates nothing.
+ */
+class LargeBlockCache
+{
+public:
+
+    static LargeBlockCache & Instance( void )
+    {
+        static LargeBlockCache cache;
+        return cache;
+    }
+
+    /// Smallest power of two covering bytes; the common size class of an
+    /// allocation and its later release.
+    static ::std::size_t ClassSize( ::std::size_t bytes )
+    {
+        ::std::size_t size = minBlockSize;
+        while ( size < bytes )
+            size <<= 1;
+        return size;
+    }
+
+    void * Allocate( ::std::size_t bytes )
+    {
+        const ::std::size_t size = ClassSize( bytes );
+        {
+            MutexLocker guard( mutex_ );
+            (void)guard;
+            FreeList & blocks = lists_[ ClassIndex( size ) ];
+            if ( 0 != blocks.head )
+            {
+                FreeBlock * block = blocks.head;
+                blocks.head = block->next;
+                --blocks.count;
+                return block;
+            }
+        }
+        return ::operator new( size );
+    }
+
+    void Deallocate( void * p, ::std::size_t bytes )
+    {
+        const ::std::size_t size = ClassSize( bytes );
+        {
+            MutexLocker guard( mutex_ );
+            (void)guard;
+            FreeList & blocks = lists_[ ClassIndex( size ) ];
+            if ( blocks.count < LOKI_ALLOCATOR_LARGE_BLOCK_RETENTION )
+            {
+                FreeBlock * block = reinterpret_cast< FreeBlock * >( p );
+                block->next = blocks.head;
+                blocks.head = block;
+                ++blocks.count;
+                return;
+            }
+        }
+        ::operator delete( p );
+    }
+
+    /// Returns every retained block to the heap, e.g. under memory pressure.
+    void Flush( void )
+    {
+        MutexLocker guard( mutex_ );
+        (void)guard;
+        for ( ::std::size_t i = 0; i < classCount; ++i )
+        {
+            while ( 0 != lists_[ i ].head )
+            {
+                FreeBlock * block = lists_[ i ].head;
+                lists_[ i ].head = block->next;
+                ::operator delete( block );
+            }
+            lists_[ i ].count = 0;
+        }
+    }
+
+private:
+
+    enum
+    {
+        // first class that can hold anything past the small-object limit
+        minBlockSize = LOKI_MAX_SMALL_OBJECT_SIZE * 2,
+        maxBlockSize = LOKI_ALLOCATOR_LARGE_BLOCK_MAX
+    };
+
+    struct FreeBlock
+    {
+        FreeBlock * next;
+    };
+
+    struct FreeList
+    {
+        FreeBlock * head;
+        ::std::size_t count;
+    };
+
+    class MutexLocker
+    {
+    public:
+        MutexLocker( Mutex & mutex ) : mutex_( mutex ) { mutex_.Lock(); }
+        ~MutexLocker() { mutex_.Unlock(); }
+    private:
+        MutexLocker( const MutexLocker & );
+        MutexLocker & operator = ( const MutexLocker & );
+        Mutex & mutex_;
+    };
+
+    // # of power-of-two classes in (minBlockSize/2, maxBlockSize]
+    static ::std::size_t CountClasses( void )
+    {
+        ::std::size_t count = 0;
+        for ( ::std::size_t size = minBlockSize; size <= maxBlockSize;
+            size <<= 1 )
+            ++count;
+        return count;
+    }
+
+    static ::std::size_t ClassIndex( ::std::size_t size )
+    {
+        ::std::size_t index = 0;
+        for ( ::std::size_t s = minBlockSize; s < size; s <<= 1 )
+            ++index;
+        return index;
+    }
+
+    // enough classes for any minBlockSize/maxBlockSize configuration on a
+    // 64 bit size_t
+    enum { classCount = 64 };
+
+    LargeBlockCache( void )
+    {
+        for ( ::std::size_t i = 0; i < classCount; ++i )
+        {
+            lists_[ i ].head = 0;
+            lists_[ i ].count = 0;
+        }
+    }
+
+    ~LargeBlockCache( void )
+    {
+        Flush();
+    }
+
+    LargeBlockCache( const LargeBlockCache & );
+    LargeBlockCache & operator = ( const LargeBlockCache & );
+
+    FreeList lists_[ classCount ];
+    Mutex mutex_;
+};
+
+#endif // LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
 
 //-----------------------------------------------------------------------------
 
@@ -87,14 +348,95 @@ public:
     pointer allocate( size_type count, const void * hint = 0 )
     {
         (void)hint;  // Ignore the hint.
-        void * p = AllocT::Instance().Allocate( count * sizeof( Type ), true );
+        const size_type bytes = count * sizeof( Type );
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+        if ( !usage_.listed )
+        {
+            usage_.listed = true;
+            usage_.elementName = typeid( Type ).name();
+            usage_.elementSize = sizeof( Type );
+            usage_.next = AllocatorUsageHead();
+            AllocatorUsageHead() = &usage_;
+        }
+        ++usage_.allocations;
+        usage_.bytes += bytes;
+        if ( AllocT::Instance().GetMaxObjectSize() < bytes )
+            ++usage_.refusals;
+#endif
+#ifdef LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+        if ( ( AllocT::Instance().GetMaxObjectSize() < bytes )
+            && ( bytes <= LOKI_ALLOCATOR_LARGE_BLOCK_MAX ) )
+            return reinterpret_cast< pointer >(
+                LargeBlockCache::Instance().Allocate( bytes ) );
+#endif
+        void * p = AllocT::Instance().Allocate( bytes, true );
         return reinterpret_cast< pointer >( p );
     }
 
     /// Ask allocator to release memory at pointer with size bytes.
     void deallocate( pointer p, size_type size )
     {
-        AllocT::Instance().Deallocate( p, size * sizeof( Type ) );
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+        ++usage_.deallocations;
+#endif
+        const size_type bytes = size * sizeof( Type );
+#ifdef LOKI_ALLOCATOR_LARGE_BLOCK_CACHE
+        if ( ( AllocT::Instance().GetMaxObjectSize() < bytes )
+            && ( bytes <= LOKI_ALLOCATOR_LARGE_BLOCK_MAX ) )
+        {
+            LargeBlockCache::Instance().Deallocate( p, bytes );
+            return;
+        }
+#endif
+        AllocT::Instance().Deallocate( p, bytes );
+    }
+
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+
+    /// Usage counters of this instantiation; see AllocatorUsage.
+    static const AllocatorUsage & GetUsage( void ) throw()
+    {
+        return usage_;
+    }
+
+    /// Restarts this instantiation's counters, e.g. between benchmark runs.
+    static void ResetUsage( void ) throw()
+    {
+        usage_.Reset();
+    }
+
+private:
+
+    static AllocatorUsage usage_;
+
+public:
+
+#endif // LOKI_ALLOCATOR_TRACK_USAGE
+
+    /** Allocate count separate single-element blocks in one call.  Unlike
+     allocate( count ), which returns one contiguous array, this fills out
+     with count pointers to individually deallocatable elements, paying the
+     allocator's per-call overhead once per batch.  The true parameter means
+     this can throw std::bad_alloc - in which case no blocks are leaked.
+     @param count # of single-element blocks requested.
+     @param out Caller-supplied array with room for count pointers.
+     @return # of blocks allocated, which is always count since this throws
+      on failure.
+     */
+    size_type allocate_batch( size_type count, pointer * out )
+    {
+        return AllocT::Instance().AllocateBatch( sizeof( Type ), count,
+            reinterpret_cast< void ** >( out ), true );
+    }
+
+    /** Release count single-element blocks in one call.  The blocks need not
+     come from one allocate_batch call - any group of blocks obtained one
+     element at a time may be released together.  NULL entries are ignored.
+     */
+    void deallocate_batch( pointer * blocks, size_type count )
+    {
+        AllocT::Instance().DeallocateBatch(
+            reinterpret_cast< void ** >( blocks ), count, sizeof( Type ) );
     }
 
     /// Calculate max # of elements allocator can handle.
@@ -126,6 +468,13 @@ public:
 
 };
 
+#ifdef LOKI_ALLOCATOR_TRACK_USAGE
+
+template < typename Type, typename AllocT >
+AllocatorUsage LokiAllocator< Type, AllocT >::usage_;
+
+#endif // LOKI_ALLOCATOR_TRACK_USAGE
+
 //-----------------------------------------------------------------------------
 
 /** All equality operators return true since LokiAllocator is basically a
@@ -19,10 +19,19 @@
 
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <vector>
 #include <utility>
 
+#include <loki/Threads.h>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) \
+    || defined(_M_X64)
+    #define LOKI_ASSOCVECTOR_SSE2 1
+    #include <emmintrin.h>
+#endif
+
 namespace Loki
 {
 ////////////////////////////////////////////////////////////////////////////////
@@ -61,6 +70,161 @@ namespace Loki
                 const Data& rhs) const
             { return operator()(lhs, rhs.first); }
         };
+
+        // Hint the hardware to start loading a line we will probe soon;
+        // a no-op on compilers without an intrinsic for it.
+        inline void AssocVectorPrefetch(const void* p)
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(p);
+#else
+            (void)p;
+#endif
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+// function template BranchlessLowerBound
+// Binary search kernel used by AssocVector and AssocVectorSoA. Unlike
+//     std::lower_bound it halves a fixed-length range so the compiler can
+//     turn the midpoint choice into a conditional move instead of a
+//     mispredicted branch, and it prefetches both possible next midpoints
+//     before comparing. Same requirements and result as std::lower_bound;
+//     performs ceil(log2(n))+1 comparisons.
+////////////////////////////////////////////////////////////////////////////////
+
+        template <class T, class Key, class Comp>
+        inline std::size_t BranchlessLowerBound(const T* data, std::size_t n,
+            const Key& key, const Comp& comp)
+        {
+            if (n == 0) return 0;
+            std::size_t i = 0;
+            std::size_t len = n;
+            while (len > 1)
+            {
+                const std::size_t half = len / 2;
+                AssocVectorPrefetch(data + i + half / 2);
+                AssocVectorPrefetch(data + i + half + (len - half) / 2);
+                if (comp(data[i + half - 1], key))
+                    i += half;
+                len -= half;
+            }
+            return i + (comp(data[i], key) ? 1 : 0);
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+// class template AssocVectorScan
+// Tail-scan trait used on dense key arrays: once a binary search has
+//     narrowed its range below 'tail' elements, scan() counts the keys
+//     ordered before the probe in one linear sweep. The primary template
+//     compares one element at a time; specializations below vectorize the
+//     count for 4-byte integral keys under their natural ordering,
+//     selected at compile time the way yasli/platform.h switches on the
+//     platform. Other instruction sets slot in as further
+//     specializations.
+////////////////////////////////////////////////////////////////////////////////
+
+        template <class K, class C>
+        struct AssocVectorScan
+        {
+            enum { tail = 1 };
+            static std::size_t scan(const K* keys, std::size_t n,
+                const K& key, const C& comp)
+            {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < n; ++i)
+                    count += comp(keys[i], key) ? 1 : 0;
+                return count;
+            }
+        };
+
+#if defined(LOKI_ASSOCVECTOR_SSE2)
+
+        inline std::size_t AssocVectorScanCount(__m128i lt)
+        {
+            static const unsigned char pop[16] =
+                { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+            return pop[_mm_movemask_ps(_mm_castsi128_ps(lt))];
+        }
+
+        template <>
+        struct AssocVectorScan<int, std::less<int> >
+        {
+            enum { tail = 16 };
+            static std::size_t scan(const int* keys, std::size_t n,
+                const int& key, const std::less<int>&)
+            {
+                const __m128i probe = _mm_set1_epi32(key);
+                std::size_t count = 0;
+                std::size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m128i four = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(keys + i));
+                    count += AssocVectorScanCount(
+                        _mm_cmplt_epi32(four, probe));
+                }
+                for (; i < n; ++i)
+                    count += keys[i] < key ? 1 : 0;
+                return count;
+            }
+        };
+
+        template <>
+        struct AssocVectorScan<unsigned int, std::less<unsigned int> >
+        {
+            enum { tail = 16 };
+            static std::size_t scan(const unsigned int* keys, std::size_t n,
+                const unsigned int& key, const std::less<unsigned int>&)
+            {
+                // SSE2 only compares signed; flipping the sign bit maps
+                // the unsigned order onto the signed one
+                const __m128i bias = _mm_set1_epi32(
+                    static_cast<int>(0x80000000u));
+                const __m128i probe = _mm_xor_si128(
+                    _mm_set1_epi32(static_cast<int>(key)), bias);
+                std::size_t count = 0;
+                std::size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m128i four = _mm_xor_si128(_mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(keys + i)), bias);
+                    count += AssocVectorScanCount(
+                        _mm_cmplt_epi32(four, probe));
+                }
+                for (; i < n; ++i)
+                    count += keys[i] < key ? 1 : 0;
+                return count;
+            }
+        };
+
+#endif // LOKI_ASSOCVECTOR_SSE2
+
+////////////////////////////////////////////////////////////////////////////////
+// function template DenseLowerBound
+// BranchlessLowerBound over a dense key array: the halving stops as soon
+//     as the range fits the AssocVectorScan tail width and the remainder
+//     is resolved by the (possibly vectorized) linear count.
+////////////////////////////////////////////////////////////////////////////////
+
+        template <class K, class C>
+        inline std::size_t DenseLowerBound(const K* keys, std::size_t n,
+            const K& key, const C& comp)
+        {
+            typedef AssocVectorScan<K, C> Scan;
+            if (n == 0) return 0;
+            std::size_t i = 0;
+            std::size_t len = n;
+            while (len > std::size_t(Scan::tail))
+            {
+                const std::size_t half = len / 2;
+                AssocVectorPrefetch(keys + i + half / 2);
+                AssocVectorPrefetch(keys + i + half + (len - half) / 2);
+                if (comp(keys[i + half - 1], key))
+                    i += half;
+                len -= half;
+            }
+            return i + Scan::scan(keys + i, len, key, comp);
+        }
     }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -89,6 +253,16 @@ namespace Loki
         typedef std::vector<std::pair<K, V>, A> Base;
         typedef Private::AssocVectorCompare<V, C> MyCompare;
 
+        // equivalence expressed through the comparator, for unique()
+        struct NotLess
+        {
+            NotLess(const MyCompare& comp) : comp_(comp) {}
+            bool operator()(const typename Base::value_type& lhs,
+                const typename Base::value_type& rhs) const
+            { return !comp_(lhs, rhs) && !comp_(rhs, lhs); }
+            const MyCompare& comp_;
+        };
+
     public:
         typedef K key_type;
         typedef V mapped_type;
@@ -126,17 +300,16 @@ namespace Loki
 
         explicit AssocVector(const key_compare& comp = key_compare(), 
             const A& alloc = A())
-        : Base(alloc), MyCompare(comp)
+        : Base(alloc), MyCompare(comp), deadCount_(0), lazyThreshold_(0)
         {}
         
         template <class InputIterator>
-        AssocVector(InputIterator first, InputIterator last, 
-            const key_compare& comp = key_compare(), 
+        AssocVector(InputIterator first, InputIterator last,
+            const key_compare& comp = key_compare(),
             const A& alloc = A())
-        : Base(first, last, alloc), MyCompare(comp)
+        : Base(alloc), MyCompare(comp), deadCount_(0), lazyThreshold_(0)
         {
-            MyCompare& me = *this;
-            std::sort(begin(), end(), me);
+            insert(first, last);
         }
         
         AssocVector& operator=(const AssocVector& rhs)
@@ -157,9 +330,11 @@ namespace Loki
         const_reverse_iterator rend() const { return Base::rend(); }
         
         // capacity:
-        bool empty() const { return Base::empty(); }
-        size_type size() const { return Base::size(); }
+        bool empty() const { return size() == 0; }
+        size_type size() const { return Base::size() - deadCount_; }
         size_type max_size() { return Base::max_size(); }
+        size_type capacity() const { return Base::capacity(); }
+        void reserve(size_type n) { Base::reserve(n); }
 
         // 23.3.1.2 element access:
         mapped_type& operator[](const key_type& key)
@@ -173,9 +348,19 @@ namespace Loki
 
             if (i == end() || this->operator()(val.first, i->first))
             {
+                if (deadCount_ != 0)
+                    dead_.insert(dead_.begin() + (i - begin()), false);
                 i = Base::insert(i, val);
                 found = false;
             }
+            else if (deadCount_ != 0 && dead_[i - begin()])
+            {
+                // reviving a tombstoned slot overwrites it in place
+                *i = val;
+                dead_[i - begin()] = false;
+                if (--deadCount_ == 0) dead_.clear();
+                found = false;
+            }
             return std::make_pair(i, !found);
         }
         //Section [23.1.2], Table 69
@@ -185,17 +370,148 @@ namespace Loki
             if( (pos == begin() || this->operator()(*(pos-1),val)) && 
                 (pos == end()    || this->operator()(val, *pos)) )
             {
+                if (deadCount_ != 0)
+                    dead_.insert(dead_.begin() + (pos - begin()), false);
                 return Base::insert(pos, val);
             }
             return insert(val).first;
         }
        
+        // Bulk insert: appends the range, sorts it once (skipped when the
+        // input is already sorted) and merges in a single pass, so loading
+        // n elements is O(n log n) instead of the O(n^2) of repeated
+        // one-element inserts. As with map::insert, existing elements win
+        // over incoming ones and the first of equivalent inputs wins.
         template <class InputIterator>
         void insert(InputIterator first, InputIterator last)
-        { for (; first != last; ++first) insert(*first); }
-        
+        {
+            if (deadCount_ != 0) compact();
+            const size_type oldSize = size();
+            Base::insert(Base::end(), first, last);
+            if (size() == oldSize) return;
+
+            MyCompare& me = *this;
+            const iterator middle = begin() + oldSize;
+            bool sorted = true;
+            for (iterator i = middle + 1; i != end(); ++i)
+            {
+                if (me(*i, *(i - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::stable_sort(middle, end(), me);
+            std::inplace_merge(begin(), middle, end(), me);
+            Base::erase(std::unique(begin(), end(), NotLess(me)), end());
+        }
+
+        // Batch upsert: merges a change set of pairs against the existing
+        // contents in one linear pass into fresh storage, so applying m
+        // changes to n elements is O(n + m log m) -- O(n + m) when the
+        // change set is already sorted -- instead of m O(n) inserts.
+        // Unlike insert, incoming values overwrite existing ones, and the
+        // last of equivalent inputs wins, as repeated map assignment would.
+        template <class InputIterator>
+        void update(InputIterator first, InputIterator last)
+        {
+            if (deadCount_ != 0) compact();
+            Base incoming(first, last);
+            if (incoming.empty()) return;
+
+            const MyCompare& me = *this;
+            bool sorted = true;
+            for (iterator i = incoming.begin() + 1; i != incoming.end(); ++i)
+            {
+                if (me(*i, *(i - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::stable_sort(incoming.begin(), incoming.end(), me);
+
+            Base merged;
+            merged.reserve(size() + incoming.size());
+            const_iterator i = begin();
+            iterator in = incoming.begin();
+            while (i != end() || in != incoming.end())
+            {
+                bool takeNew;
+                if (in == incoming.end()) takeNew = false;
+                else if (i == end()) takeNew = true;
+                else takeNew = !me(*i, *in); // incoming wins ties
+                if (takeNew)
+                {
+                    while (in + 1 != incoming.end() && !me(*in, *(in + 1)))
+                        ++in; // last of equivalent inputs wins
+                    merged.push_back(*in);
+                    if (i != end() && !me(*in, *i))
+                        ++i; // replaced the existing element
+                    ++in;
+                }
+                else
+                {
+                    merged.push_back(*i);
+                    ++i;
+                }
+            }
+            Base& base = *this;
+            base.swap(merged);
+        }
+
+        // Batch erase by key range, same single-sweep strategy as update;
+        // keys absent from the table are ignored.
+        template <class InputIterator>
+        void erase(InputIterator first, InputIterator last)
+        {
+            if (deadCount_ != 0) compact();
+            std::vector<key_type> victims(first, last);
+            if (victims.empty()) return;
+
+            const MyCompare& me = *this;
+            bool sorted = true;
+            for (typename std::vector<key_type>::iterator v =
+                victims.begin() + 1; v != victims.end(); ++v)
+            {
+                if (me(*v, *(v - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::sort(victims.begin(), victims.end(), key_comp());
+
+            Base kept;
+            kept.reserve(size());
+            typename std::vector<key_type>::const_iterator v =
+                victims.begin();
+            for (const_iterator i = begin(); i != end(); ++i)
+            {
+                while (v != victims.end() && me(*v, *i))
+                    ++v;
+                if (v != victims.end() && !me(*i, *v))
+                    continue; // equivalent: erased
+                kept.push_back(*i);
+            }
+            Base& base = *this;
+            base.swap(kept);
+        }
+
         void erase(iterator pos)
-        { Base::erase(pos); }
+        {
+            if (deadCount_ != 0)
+            {
+                const size_type idx = pos - begin();
+                if (dead_[idx]) --deadCount_;
+                if (deadCount_ == 0) dead_.clear();
+                else dead_.erase(dead_.begin() + idx);
+            }
+            Base::erase(pos);
+        }
 
         size_type erase(const key_type& k)
         {
@@ -206,7 +522,61 @@ namespace Loki
         }
 
         void erase(iterator first, iterator last)
-        { Base::erase(first, last); }
+        {
+            if (deadCount_ != 0)
+            {
+                const size_type b = first - begin();
+                const size_type e = last - begin();
+                for (size_type i = b; i != e; ++i)
+                    if (dead_[i]) --deadCount_;
+                if (deadCount_ == 0) dead_.clear();
+                else dead_.erase(dead_.begin() + b, dead_.begin() + e);
+            }
+            Base::erase(first, last);
+        }
+
+        // Lazy erase: marks the element dead in a side bitmap instead of
+        // shifting the tail, so n expiring entries cost n O(log n) marks
+        // plus one O(n) sweep instead of n O(n) memmoves.  Lookups -
+        // find, count, operator[], insert - skip and revive dead slots;
+        // raw iteration, equal_range and the relational operators still
+        // see them until compact() runs, so call compact() before
+        // walking the sequence while tombstones are outstanding.
+        size_type erase_lazy(const key_type& k)
+        {
+            iterator i(find(k));
+            if (i == end()) return 0;
+            if (dead_.empty()) dead_.assign(Base::size(), false);
+            dead_[i - begin()] = true;
+            ++deadCount_;
+            MaybeCompact();
+            return 1;
+        }
+
+        // Removes every tombstoned slot in one linear pass.  Runs on its
+        // own once tombstones outnumber live elements, or past the count
+        // set by lazy_erase_threshold.
+        void compact()
+        {
+            if (deadCount_ == 0) return;
+            const size_type n = Base::size();
+            size_type out = 0;
+            for (size_type i = 0; i != n; ++i)
+            {
+                if (dead_[i]) continue;
+                if (out != i) Base::operator[](out) = Base::operator[](i);
+                ++out;
+            }
+            Base::erase(Base::begin() + out, Base::end());
+            dead_.clear();
+            deadCount_ = 0;
+        }
+
+        // Outstanding tombstones; when they cross the threshold the next
+        // erase_lazy compacts.  Zero restores the default of compacting
+        // once dead slots outnumber live ones.
+        size_type tombstones() const { return deadCount_; }
+        void lazy_erase_threshold(size_type n) { lazyThreshold_ = n; }
 
         void swap(AssocVector& other)
         {
@@ -214,10 +584,17 @@ namespace Loki
             MyCompare& me = *this;
             MyCompare& rhs = other;
             std::swap(me, rhs);
+            dead_.swap(other.dead_);
+            std::swap(deadCount_, other.deadCount_);
+            std::swap(lazyThreshold_, other.lazyThreshold_);
         }
         
         void clear()
-        { Base::clear(); }
+        {
+            Base::clear();
+            dead_.clear();
+            deadCount_ = 0;
+        }
 
         // observers:
         key_compare key_comp() const
@@ -233,7 +610,8 @@ namespace Loki
         iterator find(const key_type& k)
         {
             iterator i(lower_bound(k));
-            if (i != end() && this->operator()(k, i->first))
+            if (i != end() && (this->operator()(k, i->first) ||
+                (deadCount_ != 0 && dead_[i - begin()])))
             {
                 i = end();
             }
@@ -243,7 +621,8 @@ namespace Loki
         const_iterator find(const key_type& k) const
         {       
             const_iterator i(lower_bound(k));
-            if (i != end() && this->operator()(k, i->first))
+            if (i != end() && (this->operator()(k, i->first) ||
+                (deadCount_ != 0 && dead_[i - begin()])))
             {
                 i = end();
             }
@@ -255,14 +634,18 @@ namespace Loki
 
         iterator lower_bound(const key_type& k)
         {
-            MyCompare& me = *this;
-            return std::lower_bound(begin(), end(), k, me);
+            const MyCompare& me = *this;
+            if (Base::empty()) return end();
+            return begin() +
+                Private::BranchlessLowerBound(&*begin(), Base::size(), k, me);
         }
 
         const_iterator lower_bound(const key_type& k) const
         {
             const MyCompare& me = *this;
-            return std::lower_bound(begin(), end(), k, me);
+            if (Base::empty()) return end();
+            return begin() +
+                Private::BranchlessLowerBound(&*begin(), Base::size(), k, me);
         }
 
         iterator upper_bound(const key_type& k)
@@ -316,6 +699,23 @@ namespace Loki
         template <class K1, class V1, class C1, class A1>
         friend bool operator<=(const AssocVector<K1, V1, C1, A1>& lhs,
                                const AssocVector<K1, V1, C1, A1>& rhs);
+
+    private:
+        void MaybeCompact()
+        {
+            if (lazyThreshold_ != 0 ? deadCount_ >= lazyThreshold_
+                : deadCount_ * 2 > Base::size())
+            {
+                compact();
+            }
+        }
+
+        // erase_lazy state: dead_ is empty while no tombstones are
+        // outstanding, otherwise sized to the stored sequence with one
+        // bit per slot; deadCount_ counts the set bits.
+        std::vector<bool> dead_;
+        size_type deadCount_;
+        size_type lazyThreshold_;
     };
 
     template <class K, class V, class C, class A>
@@ -351,7 +751,564 @@ namespace Loki
     template <class K, class V, class C, class A>
     void swap(AssocVector<K, V, C, A>& lhs, AssocVector<K, V, C, A>& rhs)
     { lhs.swap(rhs); }
-    
+
+////////////////////////////////////////////////////////////////////////////////
+// Search policies for AssocVectorSoA
+// A policy answers lowerBound() over the dense key array and is told via
+//     invalidate() whenever the container changes, so it may keep derived
+//     search structures of its own.
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// class template BranchlessSearch
+// Default search policy: the branchless, prefetching binary search over
+//     the sorted key array. Stateless.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class K, class C>
+    class BranchlessSearch
+    {
+    protected:
+        void invalidate()
+        {}
+
+        std::size_t lowerBound(const K* keys, std::size_t n, const K& key,
+            const C& comp) const
+        {
+            return Private::DenseLowerBound(keys, n, key, comp);
+        }
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// class template EytzingerSearch
+// Search policy for read-mostly tables: keeps a mirror of the keys in
+//     Eytzinger (breadth-first heap) order, so the probe sequence of a
+//     lookup walks the mirror top-down and the first few levels of the
+//     tree share a handful of hot cache lines; descendants are prefetched
+//     ahead of the compare. The mirror is rebuilt lazily -- on the first
+//     lookup after a modification -- at O(n) cost, so it only pays off
+//     when lookups far outnumber changes.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class K, class C>
+    class EytzingerSearch
+    {
+    protected:
+        EytzingerSearch() : dirty_(true)
+        {}
+
+        void invalidate()
+        { dirty_ = true; }
+
+        std::size_t lowerBound(const K* keys, std::size_t n, const K& key,
+            const C& comp) const
+        {
+            if (dirty_ || mirror_.size() != n)
+                rebuild(keys, n);
+            std::size_t result = n;
+            std::size_t slot = 1;
+            while (slot <= n)
+            {
+                if (slot * 8 <= n)
+                    Private::AssocVectorPrefetch(&mirror_[slot * 8 - 1]);
+                if (comp(mirror_[slot - 1], key))
+                    slot = 2 * slot + 1;
+                else
+                {
+                    result = rank_[slot - 1];
+                    slot = 2 * slot;
+                }
+            }
+            return result;
+        }
+
+    private:
+        void rebuild(const K* keys, std::size_t n) const
+        {
+            mirror_.assign(n, K());
+            rank_.assign(n, 0);
+            std::size_t pos = 0;
+            fill(keys, n, 1, pos);
+            dirty_ = false;
+        }
+
+        // In-order walk of the implicit tree assigns the sorted keys to
+        // their breadth-first slots; recursion depth is the tree height.
+        void fill(const K* keys, std::size_t n, std::size_t slot,
+            std::size_t& pos) const
+        {
+            if (slot > n) return;
+            fill(keys, n, 2 * slot, pos);
+            mirror_[slot - 1] = keys[pos];
+            rank_[slot - 1] = pos;
+            ++pos;
+            fill(keys, n, 2 * slot + 1, pos);
+        }
+
+        mutable std::vector<K> mirror_;
+        mutable std::vector<std::size_t> rank_;
+        mutable bool dirty_;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// class template AssocVectorSoA
+// A sorted associative array that keeps keys and values in two parallel
+//     vectors (structure of arrays) instead of one vector of pairs. The
+//     binary search then probes a dense key-only array -- many keys per
+//     cache line regardless of how big the mapped type is -- which makes
+//     lookups considerably faster than AssocVector when V is large.
+// The split layout cannot hand out pair references, so this is not a map
+//     drop-in like AssocVector:
+// * find returns a pointer to the mapped value (0 when absent)
+// * lower_bound returns an index; keyAt/valueAt access by index
+// * insert/erase invalidate indices the same way they invalidate
+//     AssocVector iterators
+// The search policy S picks the lookup kernel: BranchlessSearch (default)
+//     or EytzingerSearch for read-mostly tables.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class K,
+        class V,
+        class C = std::less<K>,
+        class A = std::allocator<K>,
+        template <class, class> class S = BranchlessSearch
+    >
+    class AssocVectorSoA : private C, private S<K, C>
+    {
+        typedef std::vector<K, A> KeyStore;
+        typedef std::vector<V, typename A::template rebind<V>::other>
+            ValueStore;
+        typedef S<K, C> MySearch;
+
+    public:
+        typedef K key_type;
+        typedef V mapped_type;
+        typedef C key_compare;
+        typedef typename KeyStore::size_type size_type;
+
+        explicit AssocVectorSoA(const key_compare& comp = key_compare())
+        : C(comp)
+        {}
+
+        template <class InputIterator>
+        AssocVectorSoA(InputIterator first, InputIterator last,
+            const key_compare& comp = key_compare())
+        : C(comp)
+        {
+            insert(first, last);
+        }
+
+        // capacity:
+        bool empty() const { return keys_.empty(); }
+        size_type size() const { return keys_.size(); }
+        size_type capacity() const { return keys_.capacity(); }
+        void reserve(size_type n)
+        {
+            keys_.reserve(n);
+            values_.reserve(n);
+        }
+
+        // element access:
+        mapped_type& operator[](const key_type& key)
+        {
+            size_type i = lower_bound(key);
+            if (i == size() || comp()(key, keys_[i]))
+            {
+                keys_.insert(keys_.begin() + i, key);
+                values_.insert(values_.begin() + i, mapped_type());
+                MySearch::invalidate();
+            }
+            return values_[i];
+        }
+
+        const key_type& keyAt(size_type i) const { return keys_[i]; }
+        mapped_type& valueAt(size_type i) { return values_[i]; }
+        const mapped_type& valueAt(size_type i) const { return values_[i]; }
+
+        // modifiers:
+        bool insert(const key_type& key, const mapped_type& value)
+        {
+            const size_type i = lower_bound(key);
+            if (i != size() && !comp()(key, keys_[i]))
+                return false;
+            keys_.insert(keys_.begin() + i, key);
+            values_.insert(values_.begin() + i, value);
+            MySearch::invalidate();
+            return true;
+        }
+
+        // Bulk insert of a range of pairs; one sort (skipped on sorted
+        // input) and one merge pass, same complexity and duplicate rules
+        // as AssocVector::insert(first, last).
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        {
+            typedef std::pair<K, V> Pair;
+            std::vector<Pair> incoming(first, last);
+            if (incoming.empty()) return;
+
+            Private::AssocVectorCompare<V, C> pairComp(comp());
+            bool sorted = true;
+            for (typename std::vector<Pair>::iterator i =
+                incoming.begin() + 1; i != incoming.end(); ++i)
+            {
+                if (pairComp(*i, *(i - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::stable_sort(incoming.begin(), incoming.end(), pairComp);
+
+            KeyStore mergedKeys;
+            ValueStore mergedValues;
+            mergedKeys.reserve(size() + incoming.size());
+            mergedValues.reserve(size() + incoming.size());
+            size_type i = 0;
+            typename std::vector<Pair>::const_iterator in = incoming.begin();
+            while (i < size() || in != incoming.end())
+            {
+                bool takeOld;
+                if (i == size()) takeOld = false;
+                else if (in == incoming.end()) takeOld = true;
+                else takeOld = !comp()(in->first, keys_[i]); // old wins ties
+                const key_type& k = takeOld ? keys_[i] : in->first;
+                if (mergedKeys.empty() || comp()(mergedKeys.back(), k))
+                {
+                    mergedKeys.push_back(k);
+                    mergedValues.push_back(takeOld ? values_[i] : in->second);
+                }
+                if (takeOld) ++i; else ++in;
+            }
+            keys_.swap(mergedKeys);
+            values_.swap(mergedValues);
+            MySearch::invalidate();
+        }
+
+        // Batch upsert over a range of pairs, one linear merge into fresh
+        // storage; incoming values overwrite existing ones and the last of
+        // equivalent inputs wins, mirroring AssocVector::update.
+        template <class InputIterator>
+        void update(InputIterator first, InputIterator last)
+        {
+            typedef std::pair<K, V> Pair;
+            std::vector<Pair> incoming(first, last);
+            if (incoming.empty()) return;
+
+            Private::AssocVectorCompare<V, C> pairComp(comp());
+            bool sorted = true;
+            for (typename std::vector<Pair>::iterator i =
+                incoming.begin() + 1; i != incoming.end(); ++i)
+            {
+                if (pairComp(*i, *(i - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::stable_sort(incoming.begin(), incoming.end(), pairComp);
+
+            KeyStore mergedKeys;
+            ValueStore mergedValues;
+            mergedKeys.reserve(size() + incoming.size());
+            mergedValues.reserve(size() + incoming.size());
+            size_type i = 0;
+            typename std::vector<Pair>::const_iterator in = incoming.begin();
+            while (i < size() || in != incoming.end())
+            {
+                bool takeNew;
+                if (in == incoming.end()) takeNew = false;
+                else if (i == size()) takeNew = true;
+                else takeNew = !comp()(keys_[i], in->first); // new wins ties
+                if (takeNew)
+                {
+                    while (in + 1 != incoming.end()
+                        && !comp()(in->first, (in + 1)->first))
+                        ++in; // last of equivalent inputs wins
+                    mergedKeys.push_back(in->first);
+                    mergedValues.push_back(in->second);
+                    if (i < size() && !comp()(in->first, keys_[i]))
+                        ++i; // replaced the existing element
+                    ++in;
+                }
+                else
+                {
+                    mergedKeys.push_back(keys_[i]);
+                    mergedValues.push_back(values_[i]);
+                    ++i;
+                }
+            }
+            keys_.swap(mergedKeys);
+            values_.swap(mergedValues);
+            MySearch::invalidate();
+        }
+
+        // Batch erase by key range, single sweep; absent keys are ignored.
+        template <class InputIterator>
+        void erase(InputIterator first, InputIterator last)
+        {
+            std::vector<key_type> victims(first, last);
+            if (victims.empty()) return;
+
+            bool sorted = true;
+            for (typename std::vector<key_type>::iterator v =
+                victims.begin() + 1; v != victims.end(); ++v)
+            {
+                if (comp()(*v, *(v - 1)))
+                {
+                    sorted = false;
+                    break;
+                }
+            }
+            if (!sorted)
+                std::sort(victims.begin(), victims.end(), comp());
+
+            KeyStore keptKeys;
+            ValueStore keptValues;
+            keptKeys.reserve(size());
+            keptValues.reserve(size());
+            typename std::vector<key_type>::const_iterator v =
+                victims.begin();
+            for (size_type i = 0; i < size(); ++i)
+            {
+                while (v != victims.end() && comp()(*v, keys_[i]))
+                    ++v;
+                if (v != victims.end() && !comp()(keys_[i], *v))
+                    continue; // equivalent: erased
+                keptKeys.push_back(keys_[i]);
+                keptValues.push_back(values_[i]);
+            }
+            keys_.swap(keptKeys);
+            values_.swap(keptValues);
+            MySearch::invalidate();
+        }
+
+        size_type erase(const key_type& key)
+        {
+            const size_type i = lower_bound(key);
+            if (i == size() || comp()(key, keys_[i]))
+                return 0;
+            keys_.erase(keys_.begin() + i);
+            values_.erase(values_.begin() + i);
+            MySearch::invalidate();
+            return 1;
+        }
+
+        void swap(AssocVectorSoA& other)
+        {
+            keys_.swap(other.keys_);
+            values_.swap(other.values_);
+            key_compare& me = *this;
+            key_compare& rhs = other;
+            std::swap(me, rhs);
+            MySearch::invalidate();
+            other.MySearch::invalidate();
+        }
+
+        void clear()
+        {
+            keys_.clear();
+            values_.clear();
+            MySearch::invalidate();
+        }
+
+        // observers:
+        key_compare key_comp() const
+        { return *this; }
+
+        // map operations:
+        mapped_type* find(const key_type& key)
+        {
+            const size_type i = lower_bound(key);
+            if (i == size() || comp()(key, keys_[i]))
+                return 0;
+            return &values_[i];
+        }
+
+        const mapped_type* find(const key_type& key) const
+        {
+            const size_type i = lower_bound(key);
+            if (i == size() || comp()(key, keys_[i]))
+                return 0;
+            return &values_[i];
+        }
+
+        size_type count(const key_type& key) const
+        { return find(key) != 0; }
+
+        size_type lower_bound(const key_type& key) const
+        {
+            if (keys_.empty()) return 0;
+            return MySearch::lowerBound(&keys_[0], keys_.size(), key, comp());
+        }
+
+        size_type upper_bound(const key_type& key) const
+        {
+            return std::upper_bound(keys_.begin(), keys_.end(), key, comp())
+                - keys_.begin();
+        }
+
+    private:
+        const key_compare& comp() const { return *this; }
+
+        KeyStore keys_;
+        ValueStore values_;
+    };
+
+    // specialized algorithms:
+    template <class K, class V, class C, class A,
+        template <class, class> class S>
+    void swap(AssocVectorSoA<K, V, C, A, S>& lhs,
+        AssocVectorSoA<K, V, C, A, S>& rhs)
+    { lhs.swap(rhs); }
+
+////////////////////////////////////////////////////////////////////////////////
+// class template SnapshotAssocVector
+// Publishes an AssocVector through refcounted immutable versions, so
+//     readers can keep querying a stable snapshot while a writer builds
+//     and publishes the next one, with no lock around the lookups.
+// A reader grabs a Snapshot handle and performs any number of find/
+//     lower_bound calls against it; the version a handle refers to is
+//     never modified, only replaced, so those lookups need no
+//     synchronization at all. A writer prepares the next table off-line
+//     and swaps it in with Publish or SwapIn; current readers keep their
+//     old version alive through its refcount and new readers see the new
+//     one.
+// Only the pointer handoff -- taking or dropping a handle, publishing a
+//     version -- is serialized, by the same Loki::Mutex the rest of the
+//     library uses (a no-op unless a LOKI_*_THREADING macro is defined).
+//     Keeping that handoff truly wait-free would take hazard pointers,
+//     which portable C++ cannot express; grabbing one handle per batch of
+//     lookups makes the cost disappear in practice.
+// Snapshots must not outlive the SnapshotAssocVector they came from.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class K,
+        class V,
+        class C = std::less<K>,
+        class A = std::allocator< std::pair<K, V> >
+    >
+    class SnapshotAssocVector
+    {
+    public:
+        typedef AssocVector<K, V, C, A> Table;
+
+    private:
+        SnapshotAssocVector(const SnapshotAssocVector&);
+        SnapshotAssocVector& operator=(const SnapshotAssocVector&);
+
+        struct Version
+        {
+            Version() : refs(1) {}
+            explicit Version(const Table& t) : table(t), refs(1) {}
+            Table table;
+            unsigned refs;
+        };
+
+        // drops one reference; called with lock_ held
+        void release(Version* version) const
+        {
+            if (--version->refs == 0)
+                delete version;
+        }
+
+        mutable Mutex lock_;
+        Version* current_;
+
+    public:
+        class Snapshot
+        {
+        public:
+            Snapshot(const Snapshot& rhs)
+            : owner_(rhs.owner_), version_(rhs.version_)
+            {
+                owner_->lock_.Lock();
+                ++version_->refs;
+                owner_->lock_.Unlock();
+            }
+
+            Snapshot& operator=(const Snapshot& rhs)
+            {
+                Snapshot copy(rhs);
+                std::swap(owner_, copy.owner_);
+                std::swap(version_, copy.version_);
+                return *this;
+            }
+
+            ~Snapshot()
+            {
+                owner_->lock_.Lock();
+                owner_->release(version_);
+                owner_->lock_.Unlock();
+            }
+
+            const Table& operator*() const { return version_->table; }
+            const Table* operator->() const { return &version_->table; }
+
+        private:
+            friend class SnapshotAssocVector;
+
+            Snapshot(const SnapshotAssocVector* owner, Version* version)
+            : owner_(owner), version_(version)
+            {}
+
+            const SnapshotAssocVector* owner_;
+            Version* version_;
+        };
+
+        SnapshotAssocVector() : current_(new Version)
+        {}
+
+        explicit SnapshotAssocVector(const Table& initial)
+        : current_(new Version(initial))
+        {}
+
+        ~SnapshotAssocVector()
+        {
+            release(current_);
+        }
+
+        /// Stable read handle on the current version.
+        Snapshot GetSnapshot() const
+        {
+            lock_.Lock();
+            Version* version = current_;
+            ++version->refs;
+            lock_.Unlock();
+            return Snapshot(this, version);
+        }
+
+        /// Publishes a copy of \a next as the new current version.
+        void Publish(const Table& next)
+        {
+            Version* fresh = new Version(next);
+            lock_.Lock();
+            Version* old = current_;
+            current_ = fresh;
+            release(old);
+            lock_.Unlock();
+        }
+
+        /// Like Publish but swallows \a next instead of copying it,
+        /// leaving \a next empty.
+        void SwapIn(Table& next)
+        {
+            Version* fresh = new Version;
+            fresh->table.swap(next);
+            lock_.Lock();
+            Version* old = current_;
+            current_ = fresh;
+            release(old);
+            lock_.Unlock();
+        }
+    };
+
 } // namespace Loki
 
 #endif // end file guardian
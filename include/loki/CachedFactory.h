@@ -30,6 +30,7 @@
 #include <map>
 #include <cassert>
 #include <loki/Key.h>
+#include <loki/Threads.h>
 
 #ifdef DO_EXTRA_LOKI_TESTS
 	#define D( x ) x
@@ -84,6 +85,12 @@ namespace Loki
                 pProduct=NULL;
                 return pPointer;
            }
+
+           // A plain pointer has nowhere to carry the release handle the
+           // storage may hand out; releases go through the by-object search.
+           void attachHandle(ProductReturn&, void*){}
+           void* takeHandle(ProductReturn&){ return 0; }
+
            const char* name(){return "pointer";}
      };
 
@@ -240,6 +247,797 @@ namespace Loki
             }
      };
      
+#ifndef LOKI_CACHED_FACTORY_SHARDS
+//  Shard count of ShardedCacheStorage, must be a power of two.
+#define LOKI_CACHED_FACTORY_SHARDS 8
+#endif
+
+    namespace Private
+    {
+        ////////////////////////////////////////////////////////////////////////
+        //  Scoped lock used by the cache storage policies and by the policy
+        //  callbacks of CachedFactory.  Loki::Mutex compiles down to a no-op
+        //  unless one of the LOKI_*_THREADING macros is defined, so the
+        //  single-threaded default pays nothing for it.
+        ////////////////////////////////////////////////////////////////////////
+        class CachedFactoryLocker
+        {
+        public:
+            CachedFactoryLocker(Mutex& mutex) : mutex_(mutex)
+            {
+                mutex_.Lock();
+            }
+            ~CachedFactoryLocker()
+            {
+                mutex_.Unlock();
+            }
+        private:
+            CachedFactoryLocker(const CachedFactoryLocker&);
+            CachedFactoryLocker& operator=(const CachedFactoryLocker&);
+            Mutex& mutex_;
+        };
+    }
+
+	/**
+	 * \defgroup	CacheStorageCachedFactoryGroup		Cache storage policies
+	 * \ingroup	CachedFactoryGroup
+	 * \brief		Decides how the cache bookkeeping is stored and locked.
+	 *
+	 * The storage policy owns the two indexes CachedFactory works with: the
+	 * availability pool (key to vector of idle objects) and the map from
+	 * fetched object back to its key.
+	 *
+	 * \class		SimpleCacheStorage
+	 * \ingroup	CacheStorageCachedFactoryGroup
+	 * \brief		Default storage: two std::maps, no locking.
+	 */
+
+	/**
+	 * \class	CacheSlotted
+	 * \ingroup	CacheStorageCachedFactoryGroup
+	 * \brief	Intrusive base required by SlottedCacheStorage.
+	 *
+	 * Derive the AbstractProduct of a cache from CacheSlotted to use
+	 * SlottedCacheStorage: the two words added here carry the object's pool
+	 * slot, which is what lets Fetch and Release run without any search.
+	 * The members belong to the storage policy; products never touch them.
+	 */
+    class CacheSlotted
+    {
+    public:
+        CacheSlotted() : cacheHome_(0), cacheSlot_(0) {}
+    private:
+        template<class, class, class> friend class SlottedCacheStorage;
+        void*        cacheHome_;
+        std::size_t  cacheSlot_;
+    };
+
+    namespace Private
+    {
+        // Index of the lowest set bit; word must not be zero.
+        inline unsigned int CacheSlotLowestBit(unsigned long word)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned int>(__builtin_ctzl(word));
+#elif defined(_MSC_VER)
+            unsigned long index = 0;
+            ::_BitScanForward(&index, static_cast<unsigned long>(word));
+            return static_cast<unsigned int>(index);
+#else
+            unsigned int index = 0;
+            while(0 == (word & 1ul))
+            {
+                word >>= 1;
+                ++index;
+            }
+            return index;
+#endif
+        }
+    }
+    template
+    <
+        class MyKey,
+        class AbstractProduct,
+        class ObjVector
+    >
+    class SimpleCacheStorage
+    {
+    private:
+        typedef std::map< MyKey, ObjVector >  KeyToObjVectorMap;
+        typedef std::map< AbstractProduct*, MyKey >  FetchedObjToKeyMap;
+
+        // Wraps the map iterator of one fetched object, so a caller which
+        // kept the handle releases with an iterator erase instead of a
+        // tree search.  Nodes are recycled through a free list.
+        struct HandleNode
+        {
+            typename FetchedObjToKeyMap::iterator where;
+            HandleNode* next;
+        };
+
+        KeyToObjVectorMap   fromKeyToObjVector;
+        FetchedObjToKeyMap  providedObjects;
+        HandleNode*         freeHandles_;
+
+    public:
+        SimpleCacheStorage() : freeHandles_(0)
+        {}
+
+        ~SimpleCacheStorage()
+        {
+            while(freeHandles_ != 0)
+            {
+                HandleNode* const node = freeHandles_;
+                freeHandles_ = node->next;
+                delete node;
+            }
+        }
+
+        // Pops an idle object for key, NULL if the pool is empty.
+        AbstractProduct* FetchFromPool(const MyKey& key)
+        {
+            ObjVector &entry(fromKeyToObjVector[key]);
+            if(entry.empty())
+                return NULL;
+            AbstractProduct* pObject(entry.back());
+            assert(pObject!=NULL);
+            entry.pop_back();
+            return pObject;
+        }
+
+        void ReturnToPool(const MyKey& key, AbstractProduct* const pObject)
+        {
+            fromKeyToObjVector[key].push_back(pObject);
+        }
+
+        // Records a fetched object and returns a handle the encapsulation
+        // policy may carry, turning the matching release into constant
+        // time through TakeProvidedAt.
+        void* PutProvided(AbstractProduct* const pObject, const MyKey& key)
+        {
+            const std::pair<typename FetchedObjToKeyMap::iterator, bool>
+                where(providedObjects.insert(std::make_pair(pObject, key)));
+            HandleNode* node = freeHandles_;
+            if(node != 0)
+                freeHandles_ = node->next;
+            else
+                node = new HandleNode;
+            node->where = where.first;
+            return node;
+        }
+
+        // Constant-time TakeProvided for a caller presenting the handle
+        // PutProvided returned: the wrapped iterator erases the entry
+        // without a search.  The handle dies with this call.
+        bool TakeProvidedAt(void* const handle,
+            AbstractProduct* const pObject, MyKey& key)
+        {
+            if(handle == 0 || pObject == 0)
+                return false;
+            HandleNode* const node = static_cast<HandleNode*>(handle);
+            if((*node->where).first != pObject)
+                return false;
+            key = (*node->where).second;
+            providedObjects.erase(node->where);
+            node->next = freeHandles_;
+            freeHandles_ = node;
+            return true;
+        }
+
+        // Forgets a fetched object and hands back its key.
+        bool TakeProvided(AbstractProduct* const pObject, MyKey& key)
+        {
+            typename FetchedObjToKeyMap::iterator itr = providedObjects.find(pObject);
+            if(itr == providedObjects.end())
+                return false;
+            key = (*itr).second;
+            providedObjects.erase(itr);
+            return true;
+        }
+
+        bool IsProvided(AbstractProduct* const pObject)
+        {
+            return providedObjects.find(pObject) != providedObjects.end();
+        }
+
+        bool RemoveFromPool(AbstractProduct* const pObject)
+        {
+            typename KeyToObjVectorMap::iterator objVectorItr;
+            typename ObjVector::iterator objItr;
+            for(objVectorItr=fromKeyToObjVector.begin();objVectorItr!=fromKeyToObjVector.end();++objVectorItr)
+            {
+                ObjVector &v((*objVectorItr).second);
+                objItr = std::remove_if(v.begin(), v.end(), std::bind2nd(std::equal_to<AbstractProduct*>(), pObject));
+                if(objItr != v.end()) // we found the vector containing pObject and removed it
+                {
+                    v.erase(objItr, v.end()); // real removing
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::size_t PooledCount(const MyKey& key)
+        {
+            typename KeyToObjVectorMap::iterator i = fromKeyToObjVector.find(key);
+            if(i == fromKeyToObjVector.end())
+                return 0;
+            return (*i).second.size();
+        }
+
+        void CollectPooled(std::vector<AbstractProduct*>& objects)
+        {
+            for(typename KeyToObjVectorMap::iterator i = fromKeyToObjVector.begin();
+                i != fromKeyToObjVector.end(); ++i)
+            {
+                ObjVector &v((*i).second);
+                std::copy(v.begin(), v.end(), std::back_inserter(objects));
+            }
+        }
+
+        void CollectProvided(std::vector<AbstractProduct*>& objects)
+        {
+            for(typename FetchedObjToKeyMap::iterator i = providedObjects.begin();
+                i != providedObjects.end(); ++i)
+                objects.push_back((*i).first);
+        }
+    };
+
+	/**
+	 * \class		ShardedCacheStorage
+	 * \ingroup	CacheStorageCachedFactoryGroup
+	 * \brief		Locked shards for concurrent Fetch/Release.
+	 *
+	 * The bookkeeping is split over LOKI_CACHED_FACTORY_SHARDS shards, each
+	 * with its own Loki::Mutex, so threads working on different keys or
+	 * objects do not serialize on one lock.  Both indexes are
+	 * open-addressing hash tables: the availability pool of a key lives in
+	 * the shard selected by the hash the Key precomputed at construction,
+	 * the fetched-object index in the shard selected by the object
+	 * address, so Fetch and Release are one integer hash plus a short
+	 * probe instead of a tree walk.  Loki has no portable reader-writer
+	 * lock and nearly every
+	 * cache operation writes anyway, so plain mutexes are used.
+	 *
+	 * Register all creators before going multithreaded: the underlying
+	 * Factory itself is not locked.  Define a LOKI_*_THREADING macro to make
+	 * the mutexes real.
+	 */
+    template
+    <
+        class MyKey,
+        class AbstractProduct,
+        class ObjVector
+    >
+    class ShardedCacheStorage
+    {
+    private:
+        enum { shards = LOKI_CACHED_FACTORY_SHARDS };
+
+        // both indexes are open-addressing hash tables; the pool reuses
+        // the hash the Key computed at construction
+        typedef OpenHashFactoryStorage< MyKey, ObjVector >  KeyToObjVectorMap;
+        typedef OpenHashFactoryStorage< AbstractProduct*, MyKey >  FetchedObjToKeyMap;
+        typedef Private::CachedFactoryLocker Locker;
+
+        struct Shard
+        {
+            Mutex               lock;
+            KeyToObjVectorMap   pool;
+            FetchedObjToKeyMap  provided;
+        };
+
+        Shard shards_[shards];
+
+        template<typename IdentifierType>
+        static std::size_t hashOf(const IdentifierType& id)
+        {
+            return FactoryIdHash<IdentifierType>()(id);
+        }
+
+        Shard& shardForKey(const MyKey& key)
+        {
+            return shards_[key.hash & (shards - 1)];
+        }
+
+        Shard& shardForObject(AbstractProduct* const pObject)
+        {
+            return shards_[hashOf(pObject) & (shards - 1)];
+        }
+
+    public:
+        AbstractProduct* FetchFromPool(const MyKey& key)
+        {
+            Shard &shard(shardForKey(key));
+            Locker guard(shard.lock);
+            ObjVector* entry = shard.pool.Find(key);
+            if(entry == 0 || entry->empty())
+                return NULL;
+            AbstractProduct* pObject(entry->back());
+            assert(pObject!=NULL);
+            entry->pop_back();
+            return pObject;
+        }
+
+        void ReturnToPool(const MyKey& key, AbstractProduct* const pObject)
+        {
+            Shard &shard(shardForKey(key));
+            Locker guard(shard.lock);
+            ObjVector* entry = shard.pool.Find(key);
+            if(entry != 0)
+                entry->push_back(pObject);
+            else
+            {
+                ObjVector fresh;
+                fresh.push_back(pObject);
+                shard.pool.Insert(key, fresh);
+            }
+        }
+
+        // No handles: the open-addressing tables rehash, so entry
+        // addresses are not stable, and the hashed lookup TakeProvided
+        // does is already constant time.
+        void* PutProvided(AbstractProduct* const pObject, const MyKey& key)
+        {
+            Shard &shard(shardForObject(pObject));
+            Locker guard(shard.lock);
+            shard.provided.Insert(pObject, key);
+            return 0;
+        }
+
+        bool TakeProvidedAt(void* const,
+            AbstractProduct* const pObject, MyKey& key)
+        {
+            return TakeProvided(pObject, key);
+        }
+
+        bool TakeProvided(AbstractProduct* const pObject, MyKey& key)
+        {
+            Shard &shard(shardForObject(pObject));
+            Locker guard(shard.lock);
+            MyKey* found = shard.provided.Find(pObject);
+            if(found == 0)
+                return false;
+            key = *found;
+            shard.provided.Erase(pObject);
+            return true;
+        }
+
+        bool IsProvided(AbstractProduct* const pObject)
+        {
+            Shard &shard(shardForObject(pObject));
+            Locker guard(shard.lock);
+            return shard.provided.Find(pObject) != 0;
+        }
+
+        bool RemoveFromPool(AbstractProduct* const pObject)
+        {
+            for(int s = 0; s < static_cast<int>(shards); ++s)
+            {
+                Shard &shard(shards_[s]);
+                Locker guard(shard.lock);
+                std::vector<MyKey> keys;
+                shard.pool.CollectIds(keys);
+                for(std::size_t k = 0; k != keys.size(); ++k)
+                {
+                    ObjVector &v(*shard.pool.Find(keys[k]));
+                    typename ObjVector::iterator j = std::remove_if(v.begin(), v.end(),
+                        std::bind2nd(std::equal_to<AbstractProduct*>(), pObject));
+                    if(j != v.end())
+                    {
+                        v.erase(j, v.end());
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        std::size_t PooledCount(const MyKey& key)
+        {
+            Shard &shard(shardForKey(key));
+            Locker guard(shard.lock);
+            ObjVector* entry = shard.pool.Find(key);
+            return entry == 0 ? 0 : entry->size();
+        }
+
+        void CollectPooled(std::vector<AbstractProduct*>& objects)
+        {
+            for(int s = 0; s < static_cast<int>(shards); ++s)
+            {
+                Shard &shard(shards_[s]);
+                Locker guard(shard.lock);
+                std::vector<MyKey> keys;
+                shard.pool.CollectIds(keys);
+                for(std::size_t k = 0; k != keys.size(); ++k)
+                {
+                    ObjVector &v(*shard.pool.Find(keys[k]));
+                    std::copy(v.begin(), v.end(), std::back_inserter(objects));
+                }
+            }
+        }
+
+        void CollectProvided(std::vector<AbstractProduct*>& objects)
+        {
+            for(int s = 0; s < static_cast<int>(shards); ++s)
+            {
+                Shard &shard(shards_[s]);
+                Locker guard(shard.lock);
+                std::vector<AbstractProduct*> ids;
+                shard.provided.CollectIds(ids);
+                std::copy(ids.begin(), ids.end(), std::back_inserter(objects));
+            }
+        }
+    };
+
+	/**
+	 * \class		SlottedCacheStorage
+	 * \ingroup	CacheStorageCachedFactoryGroup
+	 * \brief		Constant-time Fetch and Release via intrusive slots.
+	 *
+	 * The map-based storages pay a lookup keyed on the object pointer for
+	 * every Release and a full scan for every eviction.  Here each object
+	 * carries its own bookkeeping instead: the AbstractProduct must derive
+	 * from CacheSlotted, whose two words point at the object's key table
+	 * and hold its slot index.  Availability is a bitmap over the slots of
+	 * a key - claiming an idle object finds the first set bit with the
+	 * processor's bit-scan, releasing sets the object's own bit, and
+	 * eviction tombstones the object's own slot - so Fetch, Release and
+	 * eviction removal are all constant time with no search.  Slots of
+	 * destroyed objects are reused before the table grows.
+	 *
+	 * Like SimpleCacheStorage this policy does no locking of its own; the
+	 * per-key table is found with one std::map lookup on the key, and only
+	 * on the paths that do not already know the object's table.
+	 */
+    template
+    <
+        class MyKey,
+        class AbstractProduct,
+        class ObjVector
+    >
+    class SlottedCacheStorage
+    {
+    private:
+        enum SlotState
+        {
+            slotEmpty = 0,   ///< tombstone, index waits on the free list
+            slotAvailable,   ///< idle in the pool, bitmap bit set
+            slotProvided     ///< fetched and not yet released
+        };
+
+        enum { bitsPerWord = 8 * sizeof(unsigned long) };
+
+        struct KeySlots
+        {
+            explicit KeySlots(const MyKey& k) : key(k), searchHint(0) {}
+            MyKey key;
+            std::vector<AbstractProduct*> slots;
+            std::vector<unsigned char>    states;
+            std::vector<unsigned long>    bitmap;     ///< 1 bit per slot, set = available
+            std::vector<std::size_t>      freeSlots;  ///< tombstoned indexes for reuse
+            std::size_t searchHint;                   ///< first bitmap word worth scanning
+        };
+
+        typedef std::map< MyKey, KeySlots > KeyToSlotsMap;
+        KeyToSlotsMap table;
+
+        static CacheSlotted* Intrusive(AbstractProduct* const pObject)
+        {
+            // implicit upcast: compiles only when AbstractProduct derives
+            // from CacheSlotted, which this policy requires
+            CacheSlotted* const slotted = pObject;
+            return slotted;
+        }
+
+        // Gives the object a slot in key's table unless it already has one.
+        KeySlots& AssignSlot(const MyKey& key, AbstractProduct* const pObject)
+        {
+            CacheSlotted* const slotted = Intrusive(pObject);
+            if(slotted->cacheHome_ != 0)
+                return *static_cast<KeySlots*>(slotted->cacheHome_);
+            typename KeyToSlotsMap::iterator itr = table.find(key);
+            if(itr == table.end())
+                itr = table.insert(std::make_pair(key, KeySlots(key))).first;
+            KeySlots &entry((*itr).second);
+            std::size_t index;
+            if(!entry.freeSlots.empty())
+            {
+                index = entry.freeSlots.back();
+                entry.freeSlots.pop_back();
+            }
+            else
+            {
+                index = entry.slots.size();
+                entry.slots.push_back(NULL);
+                entry.states.push_back(slotEmpty);
+                if(entry.bitmap.size() * bitsPerWord < entry.slots.size())
+                    entry.bitmap.push_back(0);
+            }
+            entry.slots[index] = pObject;
+            slotted->cacheHome_ = &entry;
+            slotted->cacheSlot_ = index;
+            return entry;
+        }
+
+    public:
+        // Claims an idle object of key with one bit-scan, NULL if none.
+        AbstractProduct* FetchFromPool(const MyKey& key)
+        {
+            typename KeyToSlotsMap::iterator itr = table.find(key);
+            if(itr == table.end())
+                return NULL;
+            KeySlots &entry((*itr).second);
+            for(std::size_t w = entry.searchHint; w < entry.bitmap.size(); ++w)
+            {
+                if(0 == entry.bitmap[w])
+                    continue;
+                entry.searchHint = w;
+                const unsigned int bit = Private::CacheSlotLowestBit(entry.bitmap[w]);
+                const std::size_t index = w * bitsPerWord + bit;
+                entry.bitmap[w] &= ~(1ul << bit);
+                entry.states[index] = slotProvided;
+                AbstractProduct* const pObject = entry.slots[index];
+                assert(pObject != NULL);
+                return pObject;
+            }
+            entry.searchHint = entry.bitmap.size();
+            return NULL;
+        }
+
+        // Sets the object's own availability bit; no search.
+        void ReturnToPool(const MyKey& key, AbstractProduct* const pObject)
+        {
+            KeySlots &entry(AssignSlot(key, pObject));
+            const std::size_t index = Intrusive(pObject)->cacheSlot_;
+            entry.states[index] = slotAvailable;
+            entry.bitmap[index / bitsPerWord] |= (1ul << (index % bitsPerWord));
+            if(index / bitsPerWord < entry.searchHint)
+                entry.searchHint = index / bitsPerWord;
+        }
+
+        // No handles: the object itself carries its slot, so the plain
+        // TakeProvided is already constant time.
+        void* PutProvided(AbstractProduct* const pObject, const MyKey& key)
+        {
+            KeySlots &entry(AssignSlot(key, pObject));
+            entry.states[Intrusive(pObject)->cacheSlot_] = slotProvided;
+            return 0;
+        }
+
+        bool TakeProvidedAt(void* const,
+            AbstractProduct* const pObject, MyKey& key)
+        {
+            return TakeProvided(pObject, key);
+        }
+
+        // Reads the key out of the object's own slot; no search.
+        bool TakeProvided(AbstractProduct* const pObject, MyKey& key)
+        {
+            if(pObject == NULL)
+                return false;
+            CacheSlotted* const slotted = Intrusive(pObject);
+            if(slotted->cacheHome_ == 0)
+                return false;
+            KeySlots &entry(*static_cast<KeySlots*>(slotted->cacheHome_));
+            if(entry.states[slotted->cacheSlot_] != slotProvided)
+                return false;
+            key = entry.key;
+            entry.states[slotted->cacheSlot_] = slotEmpty;
+            return true;
+        }
+
+        bool IsProvided(AbstractProduct* const pObject)
+        {
+            if(pObject == NULL)
+                return false;
+            CacheSlotted* const slotted = Intrusive(pObject);
+            if(slotted->cacheHome_ == 0)
+                return false;
+            KeySlots &entry(*static_cast<KeySlots*>(slotted->cacheHome_));
+            return entry.states[slotted->cacheSlot_] == slotProvided;
+        }
+
+        // Tombstones the object's own slot; no search.
+        bool RemoveFromPool(AbstractProduct* const pObject)
+        {
+            if(pObject == NULL)
+                return false;
+            CacheSlotted* const slotted = Intrusive(pObject);
+            if(slotted->cacheHome_ == 0)
+                return false;
+            KeySlots &entry(*static_cast<KeySlots*>(slotted->cacheHome_));
+            const std::size_t index = slotted->cacheSlot_;
+            if(entry.states[index] != slotAvailable)
+                return false;
+            entry.bitmap[index / bitsPerWord] &= ~(1ul << (index % bitsPerWord));
+            entry.states[index] = slotEmpty;
+            entry.slots[index] = NULL;
+            entry.freeSlots.push_back(index);
+            slotted->cacheHome_ = 0;
+            slotted->cacheSlot_ = 0;
+            return true;
+        }
+
+        std::size_t PooledCount(const MyKey& key)
+        {
+            typename KeyToSlotsMap::iterator itr = table.find(key);
+            if(itr == table.end())
+                return 0;
+            KeySlots &entry((*itr).second);
+            std::size_t count = 0;
+            for(std::size_t i = 0; i < entry.states.size(); ++i)
+                if(entry.states[i] == slotAvailable)
+                    ++count;
+            return count;
+        }
+
+        void CollectPooled(std::vector<AbstractProduct*>& objects)
+        {
+            for(typename KeyToSlotsMap::iterator itr = table.begin();
+                itr != table.end(); ++itr)
+            {
+                KeySlots &entry((*itr).second);
+                for(std::size_t i = 0; i < entry.states.size(); ++i)
+                    if(entry.states[i] == slotAvailable)
+                        objects.push_back(entry.slots[i]);
+            }
+        }
+
+        void CollectProvided(std::vector<AbstractProduct*>& objects)
+        {
+            for(typename KeyToSlotsMap::iterator itr = table.begin();
+                itr != table.end(); ++itr)
+            {
+                KeySlots &entry((*itr).second);
+                for(std::size_t i = 0; i < entry.states.size(); ++i)
+                    if(entry.states[i] == slotProvided)
+                        objects.push_back(entry.slots[i]);
+            }
+        }
+    };
+
+	/**
+	 * \class	SampledStatisticPolicy
+	 * \ingroup	StatisticPolicyCachedFactoryGroup
+	 * \brief	Telemetry cheap enough to leave on in production.
+	 * 
+	 * SimpleStatisticPolicy bumps one set of shared counters, which makes
+	 * every thread of a sharded cache write the same cache line.  This
+	 * policy spreads the counters over padded slots, one cache line each;
+	 * a thread picks its slot from the page address of its own stack, so
+	 * concurrent threads land on different lines without any thread-local
+	 * machinery.  The getters aggregate over the slots.
+	 * 
+	 * setSamplingRate(N) (N a power of two, default 1) makes the fetch
+	 * path count only every Nth event and scale the result back up, so
+	 * the hit-ratio numbers stay meaningful while the hot path does next
+	 * to nothing.  The counters are updated without locks: under heavy
+	 * contention an increment can occasionally be lost, which is the
+	 * accepted price for zero synchronization on telemetry.
+	 */
+    class SampledStatisticPolicy
+    {
+    private:
+        enum { slotCount = 16 }; // power of two
+
+        struct Slot
+        {
+            Slot() : tick(0), fetched(0), created(0), destroyed(0), out(0)
+            {}
+            unsigned tick;
+            unsigned fetched;
+            unsigned created;
+            unsigned destroyed;
+            int      out;
+            // one slot per cache line, so threads do not false-share
+            char     padding_[64 - 4 * sizeof(unsigned) - sizeof(int)];
+        };
+
+        Slot      slots_[slotCount];
+        unsigned  rate_;
+
+        Slot& slot()
+        {
+            // Thread stacks live pages apart: hashing the page address of
+            // a local spreads concurrent threads over the slots.
+            int probe;
+            return slots_[(reinterpret_cast<std::size_t>(&probe) >> 12)
+                & (slotCount - 1)];
+        }
+
+    protected:
+        SampledStatisticPolicy() : rate_(1)
+        {
+        }
+
+        void onDebug()
+        {
+        	using namespace std;
+            cout << "############################" << endl;
+            cout << "## About this cache " << this << endl;
+            cout << "## + Created objects     : " << getCreated() << endl;
+            cout << "## + Fetched objects     : " << getFetched() << endl;
+            cout << "## + Destroyed objects   : " << getDestroyed() << endl;
+            cout << "## + Cache hit           : " << getHit() << endl;
+            cout << "## + Cache miss          : " << getMissed() << endl;
+            cout << "## + Currently allocated : " << getAllocated() << endl;
+            cout << "## + Currently out       : " << getOut() << endl;
+            cout << "## + Sampling rate       : " << rate_ << endl;
+            cout << "############################" << endl;
+            if(getFetched()!=0){
+                cout << "## Overall efficiency " << 100*double(getHit())/getFetched() <<"%"<< endl;
+                cout << "############################" << endl;
+            }
+            cout << endl;
+        }
+
+        void onFetch()
+        {
+            Slot& s(slot());
+            if(rate_ == 1 || (++s.tick & (rate_ - 1)) == 0)
+                ++s.fetched;
+            ++s.out;
+        }
+        void onRelease()
+        {
+            --slot().out;
+        }
+        void onCreate()
+        {
+            // creations are rare and each one is a miss: count them exactly
+            ++slot().created;
+        }
+        void onDestroy()
+        {
+            ++slot().destroyed;
+        }
+
+        const char* name(){return "sampled";}
+    public:
+        /// N must be a power of two; 1 (the default) counts everything.
+        void setSamplingRate(unsigned rate){rate_ = rate;}
+        unsigned getSamplingRate(){return rate_;}
+
+        unsigned getCreated()
+        {
+            unsigned created = 0;
+            for(int i = 0; i < slotCount; ++i)
+                created += slots_[i].created;
+            return created;
+        }
+        unsigned getFetched()
+        {
+            unsigned fetched = 0;
+            for(int i = 0; i < slotCount; ++i)
+                fetched += slots_[i].fetched;
+            return fetched * rate_;
+        }
+        unsigned getDestroyed()
+        {
+            unsigned destroyed = 0;
+            for(int i = 0; i < slotCount; ++i)
+                destroyed += slots_[i].destroyed;
+            return destroyed;
+        }
+        /// every miss on the fetch path creates an object
+        unsigned getMissed(){return getCreated();}
+        unsigned getHit()
+        {
+            const unsigned fetched = getFetched();
+            const unsigned missed = getMissed();
+            return fetched > missed ? fetched - missed : 0;
+        }
+        unsigned getAllocated(){return getCreated() - getDestroyed();}
+        unsigned getOut()
+        {
+            long out = 0;
+            for(int i = 0; i < slotCount; ++i)
+                out += slots_[i].out;
+            return static_cast<unsigned>(out);
+        }
+    };
+
     /**
      * \class	AmountLimitedCreation
      * \ingroup	CreationPolicyCachedFactoryGroup
@@ -419,7 +1217,10 @@ namespace Loki
 		template<class T> struct updateCounter : public std::unary_function<T, void>
 		{
 			updateCounter(const DT& key): key_(key){}
-			void operator()(T x)
+			// the pair must come in by reference : a by value parameter
+			// would shift a copy and leave every counter at 0, and the
+			// first eviction would then throw EvictionException
+			void operator()(T& x)
 			{
 				x.second = (x.first == key_ ? (x.second >> 1) | ( 1 << ((sizeof(ST)-1)*8) ) : x.second >> 1);
     			D( std::cout <<  x.second << std::endl; )
@@ -466,9 +1267,309 @@ namespace Loki
     	{
     		remove(EH::getLowerBound());
     	}
-        const char* name(){return "LRU with aging";}
+        const char* name(){return "LRU with aging";}
+    };
+    
+	/**
+	 * \class	EvictLRUList
+	 * \ingroup	EvictionPolicyCachedFactoryGroup
+	 * \brief	Constant-time LRU over the released objects.
+	 * 
+	 * EvictLRU scores every object in a map and evicts by sorting the
+	 * scores, which is O(n log n) per eviction.  EvictLRUList instead keeps
+	 * the released (evictable) objects in a doubly-linked list ordered by
+	 * release time, indexed by an open-addressing hash table, so release,
+	 * fetch and evict are all constant time.  A fetched object leaves the
+	 * list and cannot be evicted while in use; evict pops the object whose
+	 * release is oldest and throws EvictionException when nothing is
+	 * available.  The data type must be hashable through FactoryIdHash,
+	 * which is a given for the object pointers CachedFactory evicts.
+	 */
+    template
+    <
+    	typename DT, // Data Type (AbstractProduct*)
+    	typename ST = unsigned // default data type to use as Score Type
+    >
+    class EvictLRUList
+    {
+    private:
+        EvictLRUList(const EvictLRUList&);
+        EvictLRUList& operator=(const EvictLRUList&);
+
+        struct Node
+        {
+            Node(const DT& k) : key(k), prev(NULL), next(NULL) {}
+            DT      key;
+            Node*   prev;
+            Node*   next;
+        };
+
+        typedef OpenHashFactoryStorage< DT, Node* >  NodeIndex;
+
+        Node*       head_;  // most recently released
+        Node*       tail_;  // least recently released, evicted first
+        NodeIndex   index_;
+
+        void unlink(Node* const node)
+        {
+            if(node->prev != NULL)
+                node->prev->next = node->next;
+            else
+                head_ = node->next;
+            if(node->next != NULL)
+                node->next->prev = node->prev;
+            else
+                tail_ = node->prev;
+        }
+
+        void takeOut(const DT& key)
+        {
+            Node** found = index_.Find(key);
+            if(found == NULL)
+                return;
+            Node* node = *found;
+            index_.Erase(key);
+            unlink(node);
+            delete node;
+        }
+
+    protected:
+        EvictLRUList() : head_(NULL), tail_(NULL), index_()
+        {}
+
+        virtual ~EvictLRUList()
+        {
+            Node* node = head_;
+            while(node != NULL)
+            {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+        void onCreate(const DT&)
+        {
+        }
+
+        // The object goes out: it leaves the evictable list.
+        void onFetch(const DT& key)
+        {
+            takeOut(key);
+        }
+
+        // The object comes back: it becomes the most recently used.
+        void onRelease(const DT& key)
+        {
+            Node* node = new Node(key);
+            node->next = head_;
+            if(head_ != NULL)
+                head_->prev = node;
+            head_ = node;
+            if(tail_ == NULL)
+                tail_ = node;
+            index_.Insert(key, node);
+        }
+
+        void onDestroy(const DT& key)
+        {
+            takeOut(key);
+        }
+
+    	// this function is implemented in Cache and redirected
+    	// to the Storage Policy
+    	virtual void remove(DT const key)=0;
+
+    	// Evicts the least recently released object
+    	void evict()
+    	{
+    		if(tail_ == NULL) // everything is in use
+    		    throw EvictionException();
+    		remove(tail_->key);
+    	}
+        const char* name(){return "LRU list";}
+    };
+
+	/**
+	 * \class	EvictTTL
+	 * \ingroup	EvictionPolicyCachedFactoryGroup
+	 * \brief	Expires idle pooled objects after a time to live.
+	 * 
+	 * Released objects are filed into a hashed timer wheel by their
+	 * deadline (release time plus the TTL set with setTTL).  A sweep --
+	 * run by calling CachedFactory::EvictExpired() from the application's
+	 * timer -- only visits the wheel slots whose time has come, so the
+	 * work per tick is proportional to the objects expiring, not to the
+	 * cache size.  A fetched object leaves the index and its wheel entry
+	 * goes stale; stale entries are dropped when their slot is next swept.
+	 * Time is measured with clock(), like RateLimitedCreation does.
+	 * 
+	 * When the CreationPolicy refuses a creation the policy first sweeps;
+	 * if nothing has expired yet it evicts the available object closest
+	 * to its deadline, which scans the wheel and is the only operation
+	 * not proportional to the expiring count.
+	 */
+    template
+    <
+    	typename DT, // Data Type (AbstractProduct*)
+    	typename ST = unsigned // default data type to use as Score Type
+    >
+    class EvictTTL
+    {
+    private:
+        EvictTTL(const EvictTTL&);
+        EvictTTL& operator=(const EvictTTL&);
+
+        enum { wheelSize = 64 }; // power of two
+
+        struct Entry
+        {
+            Entry() : key(), deadline(0) {}
+            Entry(const DT& k, clock_t d) : key(k), deadline(d) {}
+            DT      key;
+            clock_t deadline;
+        };
+
+        typedef std::vector<Entry>                  Slot;
+        typedef OpenHashFactoryStorage< DT, clock_t >  DeadlineIndex;
+
+        Slot            wheel_[wheelSize];
+        DeadlineIndex   index_; // deadline of every released object
+        clock_t         ttl_;
+        clock_t         granularity_;
+        clock_t         lastRun_;
+
+        Slot& slotFor(clock_t deadline)
+        {
+            return wheel_[(deadline / granularity_) & (wheelSize - 1)];
+        }
+
+        // true when the entry still describes a released, unexpired object
+        bool valid(const Entry& entry)
+        {
+            clock_t* current = index_.Find(entry.key);
+            return current != NULL && *current == entry.deadline;
+        }
+
+    protected:
+        EvictTTL() :
+            index_(),
+            ttl_(60 * CLOCKS_PER_SEC), // a minute, see setTTL
+            granularity_(CLOCKS_PER_SEC / 100 > 0 ? CLOCKS_PER_SEC / 100 : 1),
+            lastRun_(clock())
+        {}
+
+        virtual ~EvictTTL(){}
+
+        void onCreate(const DT&)
+        {
+        }
+
+        void onFetch(const DT& key)
+        {
+            index_.Erase(key); // in use: the wheel entry goes stale
+        }
+
+        void onRelease(const DT& key)
+        {
+            const clock_t deadline = clock() + ttl_;
+            clock_t* current = index_.Find(key);
+            if(current != NULL)
+                *current = deadline; // re-release: old entry goes stale
+            else
+                index_.Insert(key, deadline);
+            slotFor(deadline).push_back(Entry(key, deadline));
+        }
+
+        void onDestroy(const DT& key)
+        {
+            index_.Erase(key);
+        }
+
+    	// this function is implemented in Cache and redirected
+    	// to the Storage Policy
+    	virtual void remove(DT const key)=0;
+
+        /// Sweeps the slots due since the last run, evicting every
+        /// released object whose deadline has passed; returns how many.
+        unsigned evictExpired()
+        {
+            const clock_t now = clock();
+            unsigned evicted = 0;
+            long slot = lastRun_ / granularity_;
+            const long lastSlot = now / granularity_;
+            if(lastSlot - slot >= static_cast<long>(wheelSize))
+                slot = lastSlot - wheelSize + 1; // one full turn is enough
+            for(; slot <= lastSlot; ++slot)
+            {
+                Slot& entries = wheel_[slot & (wheelSize - 1)];
+                for(typename Slot::size_type i = 0; i < entries.size(); )
+                {
+                    const Entry entry = entries[i];
+                    if(valid(entry) == false)
+                    {   // fetched, destroyed or re-released meanwhile
+                        entries[i] = entries.back();
+                        entries.pop_back();
+                        continue;
+                    }
+                    if(entry.deadline <= now)
+                    {
+                        entries[i] = entries.back();
+                        entries.pop_back();
+                        index_.Erase(entry.key);
+                        remove(entry.key);
+                        ++evicted;
+                        continue;
+                    }
+                    ++i; // due on a later turn of the wheel
+                }
+            }
+            lastRun_ = now;
+            return evicted;
+        }
+
+    	// TTL Eviction policy
+    	void evict()
+    	{
+    		if(evictExpired() > 0)
+    		    return;
+    		// nothing has expired: sacrifice the object closest to its
+    		// deadline
+    		bool found = false;
+    		Entry soonest;
+    		for(int s = 0; s < static_cast<int>(wheelSize); ++s)
+    		{
+    		    Slot& entries = wheel_[s];
+    		    for(typename Slot::size_type i = 0; i < entries.size(); ++i)
+    		    {
+    		        if(valid(entries[i]) == false)
+    		            continue;
+    		        if(found == false || entries[i].deadline < soonest.deadline)
+    		        {
+    		            soonest = entries[i];
+    		            found = true;
+    		        }
+    		    }
+    		}
+    		if(found == false)
+    		    throw EvictionException();
+    		index_.Erase(soonest.key);
+    		remove(soonest.key);
+    	}
+
+        const char* name(){return "TTL";}
+
+    public:
+        /// Time to live of a released object, in milliseconds.
+        void setTTL(unsigned milliseconds)
+        {
+            ttl_ = static_cast<clock_t>(
+                (double(milliseconds) / 1000) * CLOCKS_PER_SEC);
+            if(ttl_ < 1)
+                ttl_ = 1;
+        }
     };
-    
+
 	/**
 	 * \class	EvictRandom
 	 * \ingroup	EvictionPolicyCachedFactoryGroup
@@ -625,6 +1726,54 @@ namespace Loki
         unsigned getDestroyed(){return created-allocated;}
     }; 
     
+/**
+ * \defgroup	RecyclePolicyCachedFactoryGroup		Recycle policies
+ * \ingroup	CachedFactoryGroup
+ * \brief	Scrubs an object before it reenters the availability pool.
+ *
+ * When a client releases an object the cache keeps it for the next
+ * fetch, but the object may carry state from its previous use (a filled
+ * buffer, a transaction left open on a connection). The recycle policy
+ * is invoked from ReleaseObject with the object about to enter the
+ * availability pool; a cheap reset here spares the cache from
+ * destroying and recreating products whose construction is expensive.
+ */
+	/**
+	 * \class	NoRecycling
+	 * \ingroup	RecyclePolicyCachedFactoryGroup
+	 * \brief	Do nothing
+	 *
+	 * The default : released objects reenter the pool as they are.
+	 */
+    template<class AbstractProduct>
+    class NoRecycling
+    {
+    protected:
+        void onRecycle(AbstractProduct*){}
+        const char* name(){return "no";}
+    };
+
+	/**
+	 * \class	ResetRecycling
+	 * \ingroup	RecyclePolicyCachedFactoryGroup
+	 * \brief	Calls reset() on the released object
+	 *
+	 * The product must expose a reset() member function returning the
+	 * object to its freshly constructed state. Use this for pooled
+	 * buffers or connections whose reset is much cheaper than a
+	 * destroy-and-recreate cycle.
+	 */
+    template<class AbstractProduct>
+    class ResetRecycling
+    {
+    protected:
+        void onRecycle(AbstractProduct* pProduct)
+        {
+            pProduct->reset();
+        }
+        const char* name(){return "reset";}
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // Cache Factory definition
     ///////////////////////////////////////////////////////////////////////////
@@ -644,6 +1793,10 @@ namespace Loki
      * long constructions time.
 	 * 
 	 * Note this implementation do not retain ownership.
+	 *
+	 * The bookkeeping lives in a StoragePolicy, SimpleCacheStorage by
+	 * default.  Pass ShardedCacheStorage (and define a LOKI_*_THREADING
+	 * macro) to let several threads fetch and release concurrently.
 	 */
 	 template
      <
@@ -655,11 +1808,14 @@ namespace Loki
         template <typename , typename> class EvictionPolicy = EvictRandom,
         class StatisticPolicy = NoStatisticPolicy,
         template<typename, class> class FactoryErrorPolicy = DefaultFactoryError,
-        class ObjVector = std::vector<AbstractProduct*>
+        class ObjVector = std::vector<AbstractProduct*>,
+        template<class, class, class> class StoragePolicy = SimpleCacheStorage,
+        template<class> class RecyclePolicy = NoRecycling
      >
 	 class CachedFactory : 
             protected EncapsulationPolicy<AbstractProduct>,
-            public CreationPolicy, public StatisticPolicy, EvictionPolicy< AbstractProduct * , unsigned >
+            public CreationPolicy, public StatisticPolicy, EvictionPolicy< AbstractProduct * , unsigned >,
+            protected RecyclePolicy<AbstractProduct>
 	 {
      private:
         typedef Factory< AbstractProduct, IdentifierType, CreatorParmTList, FactoryErrorPolicy> MyFactory;
@@ -669,6 +1825,7 @@ namespace Loki
         typedef CreationPolicy  CP;
         typedef StatisticPolicy SP;
         typedef EvictionPolicy< AbstractProduct* , unsigned > EP;
+        typedef RecyclePolicy<AbstractProduct> RP;
                 
         typedef typename Impl::Parm1 Parm1;
         typedef typename Impl::Parm2 Parm2;
@@ -690,50 +1847,27 @@ namespace Loki
         typedef typename NP::ProductReturn ProductReturn;
      private:
         typedef Key< Impl, IdentifierType > MyKey;
-        typedef std::map< MyKey, ObjVector >  KeyToObjVectorMap;
-        typedef std::map< AbstractProduct*, MyKey >  FetchedObjToKeyMap;
+        typedef StoragePolicy< MyKey, AbstractProduct, ObjVector >  MyStorage;
         
         MyFactory			factory;
-        KeyToObjVectorMap   fromKeyToObjVector;
-        FetchedObjToKeyMap  providedObjects;
+        MyStorage           storage;
         unsigned            outObjects;
+        // Guards the policy objects (creation, statistic, eviction) and
+        // outObjects; a no-op unless a LOKI_*_THREADING macro is defined.
+        Mutex               policyLock;
 
-        ObjVector& getContainerFromKey(MyKey key){
-            return fromKeyToObjVector[key];
-        }
-
-        AbstractProduct* const getPointerToObjectInContainer(ObjVector &entry)
-        {
-            if(entry.empty()) // No object available
-            {   // the object will be created in the calling function.
-                // It has to be created in the calling function because of
-                // the variable number of parameters for CreateObject(...) method
-                return NULL;
-            }
-            else
-            {   // returning the found object
-				AbstractProduct* pObject(entry.back());
-				assert(pObject!=NULL);
-				entry.pop_back();
-                return pObject;
-            }
-        }
-        
         bool shouldCreateObject(AbstractProduct * const pProduct){
             if(pProduct!=NULL) // object already exists
                 return false;
+            Private::CachedFactoryLocker guard(policyLock);
             if(CP::canCreate()==false) // Are we allowed to Create ?
                 EP::evict(); // calling Eviction Policy to clean up
             return true;
         }
         
-        void ReleaseObjectFromContainer(ObjVector &entry, AbstractProduct * const object)
-        {
-            entry.push_back(object);
-        }
-        
         void onFetch(AbstractProduct * const pProduct)
         {
+            Private::CachedFactoryLocker guard(policyLock);
             SP::onFetch();
             EP::onFetch(pProduct);
             ++outObjects;
@@ -741,6 +1875,7 @@ namespace Loki
         
         void onRelease(AbstractProduct * const pProduct)
         {
+            Private::CachedFactoryLocker guard(policyLock);
             SP::onRelease();
             EP::onRelease(pProduct);
             --outObjects;
@@ -748,11 +1883,14 @@ namespace Loki
         
         void onCreate(AbstractProduct * const pProduct)
         {
+            Private::CachedFactoryLocker guard(policyLock);
             CP::onCreate();
             SP::onCreate();
             EP::onCreate(pProduct);
         }
         
+        // Runs with policyLock already held: the only caller is remove(),
+        // reached through EP::evict() from shouldCreateObject().
         void onDestroy(AbstractProduct * const pProduct)
         {
             CP::onDestroy();
@@ -766,49 +1904,19 @@ namespace Loki
 			void operator()(T x){ delete x; }
 		};
 
-		// delete the objects in the vector
-		template<class T> struct deleteVectorObjects : public std::unary_function<T, void>
-		{
-			void operator()(T x){
-				ObjVector &vec(x.second);
-				std::for_each(vec.begin(), vec.end(), deleteObject< typename ObjVector::value_type>());
-			}
-		};
-
-		// delete the keys of the map
-		template<class T> struct deleteMapKeys : public std::unary_function<T, void>
-		{
-			void operator()(T x){ delete x.first; }
-		};            
-
      protected:
         virtual void remove(AbstractProduct * const pProduct)
         {
-            typename FetchedObjToKeyMap::iterator fetchedItr = providedObjects.find(pProduct);
-            if(fetchedItr!=providedObjects.end()) // object is unreleased.
+            if(storage.IsProvided(pProduct)) // object is unreleased.
                 throw CacheException();
-            bool productRemoved = false;
-            typename KeyToObjVectorMap::iterator objVectorItr;
-            typename ObjVector::iterator objItr;
-            for(objVectorItr=fromKeyToObjVector.begin();objVectorItr!=fromKeyToObjVector.end();++objVectorItr)
-            {
-                ObjVector &v((*objVectorItr).second);
-                objItr = remove_if(v.begin(), v.end(), std::bind2nd(std::equal_to<AbstractProduct*>(), pProduct));
-                if(objItr != v.end()) // we found the vector containing pProduct and removed it
-                {
-                    onDestroy(pProduct); // warning policies we are about to destroy an object
-                    v.erase(objItr, v.end()); // real removing
-                    productRemoved = true;
-                    break;
-                }
-            }
-            if(productRemoved==false)
+            if(storage.RemoveFromPool(pProduct)==false)
                 throw CacheException(); // the product is not in the cache ?!
+            onDestroy(pProduct); // warning policies we are about to destroy an object
             delete pProduct; // deleting it
         }
 
      public:
-        CachedFactory() : factory(), fromKeyToObjVector(), providedObjects(), outObjects(0)
+        CachedFactory() : factory(), storage(), outObjects(0)
         {
         }
 
@@ -818,19 +1926,23 @@ namespace Loki
             // debug information
             SP::onDebug();
             // cleaning the Cache
-            for_each(fromKeyToObjVector.begin(), fromKeyToObjVector.end(),
-            	deleteVectorObjects< typename KeyToObjVectorMap::value_type >()
+            std::vector<AbstractProduct*> objects;
+            storage.CollectPooled(objects);
+            for_each(objects.begin(), objects.end(),
+            	deleteObject< AbstractProduct* >()
             );
-            if(!providedObjects.empty())
+            objects.clear();
+            storage.CollectProvided(objects);
+            if(!objects.empty())
             {
 				// The factory is responsible for the creation and destruction of objects.
 				// If objects are out during the destruction of the Factory : deleting anyway.
 				// This might not be a good idea. But throwing an exception in a destructor is
 				// considered as a bad pratice and asserting might be too much.
 				// What to do ? Leaking memory or corrupting in use pointers ? hmm...
-                D( cout << "====>>  Cache destructor : deleting "<< providedObjects.size()<<" in use objects  <<====" << endl << endl; )
-                for_each(providedObjects.begin(), providedObjects.end(),
-	                deleteMapKeys< typename FetchedObjToKeyMap::value_type >()
+                D( cout << "====>>  Cache destructor : deleting "<< objects.size()<<" in use objects  <<====" << endl << endl; )
+                for_each(objects.begin(), objects.end(),
+	                deleteObject< AbstractProduct* >()
                 );
             }
         }
@@ -865,67 +1977,75 @@ namespace Loki
         ProductReturn CreateObject(const IdentifierType& id)
         {
             MyKey key(id);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
         
         ProductReturn CreateObject(const IdentifierType& id,
 				    Parm1 p1)
         {
             MyKey key(id,p1);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
 				    Parm1 p1, Parm2 p2)
         {
             MyKey key(id,p1,p2);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
 				    Parm1 p1, Parm2 p2, Parm3 p3)
         {
             MyKey key(id,p1,p2,p3);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
 				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
         {
             MyKey key(id,p1,p2,p3,p4);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -933,15 +2053,17 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
 				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
         {
             MyKey key(id,p1,p2,p3,p4,p5);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -949,8 +2071,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -958,7 +2082,7 @@ namespace Loki
 				    Parm6 p6)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -966,8 +2090,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -975,7 +2101,7 @@ namespace Loki
 				    Parm6 p6, Parm7 p7 )
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -983,8 +2109,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -992,7 +2120,7 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1000,8 +2128,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1009,7 +2139,7 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1017,8 +2147,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
         
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1026,7 +2158,7 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9,Parm10 p10)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1034,8 +2166,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1044,7 +2178,7 @@ namespace Loki
 				    Parm11 p11)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1052,8 +2186,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1062,7 +2198,7 @@ namespace Loki
 				    Parm11 p11, Parm12 p12)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1070,8 +2206,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1080,7 +2218,7 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1089,8 +2227,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1099,7 +2239,7 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1108,8 +2248,10 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
         }
 
         ProductReturn CreateObject(const IdentifierType& id,
@@ -1118,7 +2260,7 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            AbstractProduct *pProduct(storage.FetchFromPool(key));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1127,8 +2269,478 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
-            return NP::encapsulate(pProduct);
+            void* const handle = storage.PutProvided(pProduct, key);
+            ProductReturn product(NP::encapsulate(pProduct));
+            NP::attachHandle(product, handle);
+            return product;
+        }
+
+        ///////////////////////////////////
+        // Background creation support   //
+        ///////////////////////////////////
+
+		/// Creates one object and parks it in the availability pool
+		/**
+		 * Unlike CreateObject the product is not handed out: the next
+		 * matching CreateObject will hit it without paying the
+		 * construction time.  The CreationPolicy accounting is honoured
+		 * (AmountLimitedCreation caps prefetching like any creation) but
+		 * no eviction is triggered: when creation is not allowed Prefetch
+		 * simply returns false.
+		 */
+        bool Prefetch(const IdentifierType& id)
+        {
+            MyKey key(id);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1)
+        {
+            MyKey key(id,p1);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2)
+        {
+            MyKey key(id,p1,p2);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3)
+        {
+            MyKey key(id,p1,p2,p3);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
+        {
+            MyKey key(id,p1,p2,p3,p4);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10,key.p11));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10,key.p11,key.p12));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10,key.p11,key.p12,key.p13));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10,key.p11,key.p12,key.p13,key.p14));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+        bool Prefetch(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
+        {
+            MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                if(CP::canCreate()==false) // Are we allowed to Create ?
+                    return false;
+            }
+            AbstractProduct* pProduct(factory.CreateObject(key.id,key.p1,key.p2,key.p3,key.p4,key.p5,key.p6,key.p7,key.p8,key.p9,key.p10,key.p11,key.p12,key.p13,key.p14,key.p15));
+            onCreate(pProduct);
+            {
+                Private::CachedFactoryLocker guard(policyLock);
+                // The construction was paid here, off the hot path: let the
+                // statistics see one fetched-and-released miss so the hit
+                // counter stays balanced, and tell the eviction policy the
+                // object is available.
+                SP::onFetch();
+                SP::onRelease();
+                EP::onRelease(pProduct);
+            }
+            storage.ReturnToPool(key, pProduct);
+            return true;
+        }
+
+		/// Tops up the availability pool of id to the watermark
+		/**
+		 * Creates objects until the pool of id holds watermark idle
+		 * instances or the CreationPolicy refuses; returns how many were
+		 * created.  With ShardedCacheStorage and a LOKI_*_THREADING macro
+		 * this is safe to run from a background worker thread while other
+		 * threads fetch and release, so the hot path almost always finds
+		 * a ready object.  Only products without creation parameters can
+		 * be topped up this way; parametrized products are prefetched one
+		 * by one through Prefetch.
+		 */
+        unsigned PrefetchUpTo(const IdentifierType& id, unsigned watermark)
+        {
+            MyKey key(id);
+            unsigned created = 0;
+            while(storage.PooledCount(key) < watermark)
+            {
+                if(Prefetch(id)==false) // creation limit reached
+                    break;
+                ++created;
+            }
+            return created;
+        }
+
+		/// Time to live of pooled objects; needs the EvictTTL policy
+        void setTTL(unsigned milliseconds)
+        {
+            EP::setTTL(milliseconds);
+        }
+
+		/// Evicts the pooled objects whose TTL has passed
+		/**
+		 * Call this from the application's periodic timer; it needs the
+		 * EvictTTL policy and returns the number of objects destroyed.
+		 */
+        unsigned EvictExpired()
+        {
+            Private::CachedFactoryLocker guard(policyLock);
+            return EP::evictExpired();
         }
 
 		/// Use this function to release the object
@@ -1139,13 +2751,20 @@ namespace Loki
 		 */
         void ReleaseObject(ProductReturn &object)
         {
+            // An encapsulation policy which carried the handle PutProvided
+            // returned releases straight into the owning record, without
+            // the by-object search.
+            void* const handle = NP::takeHandle(object);
             AbstractProduct* pProduct(NP::release(object));
-            typename FetchedObjToKeyMap::iterator itr = providedObjects.find(pProduct);
-            if(itr == providedObjects.end())
+            MyKey key;
+            const bool taken = (handle != 0)
+                ? storage.TakeProvidedAt(handle, pProduct, key)
+                : storage.TakeProvided(pProduct, key);
+            if(taken==false)
                 throw CacheException();
             onRelease(pProduct);
-            ReleaseObjectFromContainer(getContainerFromKey((*itr).second), pProduct);
-            providedObjects.erase(itr);
+            RP::onRecycle(pProduct);
+            storage.ReturnToPool(key, pProduct);
         }
         
         /// display the cache configuration
@@ -1158,6 +2777,7 @@ namespace Loki
             cout << "## + Creating      " << CP::name() << endl;
             cout << "## + Eviction      " << EP::name() << endl;
             cout << "## + Statistics    " << SP::name() << endl;
+            cout << "## + Recycling     " << RP::name() << endl;
             cout << "############################" << endl;
         }
      };
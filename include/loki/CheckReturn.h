@@ -59,6 +59,17 @@ namespace Loki
 ///  - FprintfStderr Prints out an error message if the caller ignores the return value.
 ///  - ThrowTheValue Throws the ignored value as an exception.
 ///  - ThrowLogicError Throws a logic_error exception to indicate a programming error.
+///
+/// @par Disabling the check
+///  Define the macro
+///  \code LOKI_CHECK_RETURN_DISABLED \endcode
+///  (typically in release builds, alongside NDEBUG) to compile CheckReturn
+///  down to a transparent pass-through: it then holds nothing but the value
+///  itself, has no checked flag and a trivial destructor, so functions
+///  annotated with it return exactly what they would return unwrapped and
+///  copy elision applies as usual.  The checking semantics - and any cost of
+///  the OnError policy - exist only in builds without the macro, so the
+///  annotation can stay on every hot function permanently.
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -109,6 +120,40 @@ struct FprintfStderr
 
 
 
+#ifdef LOKI_CHECK_RETURN_DISABLED
+
+template < class Value , template<class> class OnError = TriggerAssert >
+class CheckReturn
+{
+public:
+
+	/// Conversion constructor changes Value type to CheckReturn type.
+	inline CheckReturn( const Value & value ) : m_value( value ) {}
+
+	/// Copy-constructor allows functions to call another function within the
+	/// return statement.
+	inline CheckReturn( const CheckReturn & that ) : m_value( that.m_value ) {}
+
+	/// Conversion operator changes CheckReturn back to Value type.  Nothing
+	/// is recorded: in this configuration ignoring the value is not detected.
+	inline operator Value ( void )
+	{
+		return m_value;
+	}
+
+private:
+	/// Default constructor not implemented.
+	CheckReturn( void );
+
+	/// Copy-assignment operator not implemented.
+	CheckReturn & operator = ( const CheckReturn & that );
+
+	/// Copy of returned value.
+	Value m_value;
+};
+
+#else // LOKI_CHECK_RETURN_DISABLED
+
 template < class Value , template<class> class OnError = TriggerAssert >
 class CheckReturn
 {
@@ -155,6 +200,8 @@ private:
 	mutable bool m_checked;
 };
 
+#endif // LOKI_CHECK_RETURN_DISABLED
+
 // ----------------------------------------------------------------------------
 
 } // namespace Loki
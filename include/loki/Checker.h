@@ -26,6 +26,18 @@
 
 #include <exception>  // needed for calls to uncaught_exception.
 #include <assert.h>
+#include <new>  // needed for placement new in sampled checkers.
+
+/// Thread-local storage keyword for the sampling counters.  Without a known
+/// thread-local mechanism the counters are shared, so sampling still bounds
+/// the cost but the 1-in-N spacing becomes approximate across threads.
+#if defined( _MSC_VER )
+    #define LOKI_CHECKER_TLS __declspec( thread )
+#elif defined( __GNUC__ )
+    #define LOKI_CHECKER_TLS __thread
+#else
+    #define LOKI_CHECKER_TLS
+#endif
 
 
 namespace Loki
@@ -225,6 +237,70 @@ public:
 
 // ----------------------------------------------------------------------------
 
+/** @par Checking Levels
+ ContractChecker and StaticChecker accept an optional checking-level policy
+ which decides at compile time how often a checker actually checks:
+ - CheckAlways: every invocation checks.  This is the default, and the
+   historic behavior.
+ - CheckSampled< N >: one in every N invocations on each thread checks; the
+   rest construct nothing - not even the exception policy's copy of the host -
+   and cost one thread-local decrement.  This keeps invariant checking alive
+   in release builds at a bounded, tunable cost.
+ - CheckNever: the checker is an empty object and every call compiles away,
+   for functions whose checks are too hot even to sample.
+ Because the level is a type, a build can select it per call site, or
+ centrally through a project-wide typedef.
+ */
+
+/** @class CheckAlways
+ Checking-level policy which checks on every invocation.
+ */
+class CheckAlways
+{
+public:
+    inline static bool ShouldCheck( void ) { return true; }
+};
+
+/** @class CheckSampled
+ Checking-level policy which checks one in every samplePeriod invocations on
+ each thread.  The counter is thread-local, so threads sample independently
+ and the decision costs no synchronization.
+ */
+template < unsigned int samplePeriod >
+class CheckSampled
+{
+public:
+
+    inline static bool ShouldCheck( void )
+    {
+        typedef char period_must_be_positive[ ( samplePeriod > 0 ) ? 1 : -1 ];
+        if ( 0 != --countdown_ )
+            return false;
+        countdown_ = samplePeriod;
+        return true;
+    }
+
+private:
+    /// Invocations left on this thread until the next check.  Starts at one
+    /// so each thread's first invocation gets checked.
+    static LOKI_CHECKER_TLS unsigned int countdown_;
+};
+
+template < unsigned int samplePeriod >
+LOKI_CHECKER_TLS unsigned int CheckSampled< samplePeriod >::countdown_ = 1;
+
+/** @class CheckNever
+ Checking-level policy which never checks.  The matching checker
+ specializations are empty, so the checks compile away entirely.
+ */
+class CheckNever
+{
+public:
+    inline static bool ShouldCheck( void ) { return false; }
+};
+
+// ----------------------------------------------------------------------------
+
 /** @class ContractChecker
  This class determines if a function violated any class invariant, but it also
  determines if a function fulfills its contract with client code.  In the
@@ -272,7 +348,8 @@ public:
 template
 <
     class Host,
-    template < class > class ExceptionPolicy
+    template < class > class ExceptionPolicy,
+    class CheckingLevel = CheckAlways
 >
 class ContractChecker : public ExceptionPolicy< Host >
 {
@@ -362,6 +439,147 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/** @class ContractChecker< Host, ExceptionPolicy, CheckSampled< samplePeriod > >
+ Specialization for sampled checking.  One invocation in every samplePeriod
+ per thread behaves exactly like the primary template; the others skip the
+ validators and do not even construct the exception policy, so a sampled-out
+ call with CheckForNoChange never copies the host.
+ */
+
+template
+<
+    class Host,
+    template < class > class ExceptionPolicy,
+    unsigned int samplePeriod
+>
+class ContractChecker< Host, ExceptionPolicy, CheckSampled< samplePeriod > >
+{
+    /// Shorthand for the ExceptionPolicy class.
+    typedef ExceptionPolicy< Host > Ep;
+
+public:
+
+    /// Signature for the validation function.
+    typedef bool ( Host:: * Validator )( void ) const;
+
+    inline ContractChecker( const Host * host, Validator validator,
+        Validator pre = 0, Validator post = 0 ) :
+        m_host( host ),
+        m_validator( validator ),
+        m_pre( pre ),
+        m_post( post ),
+        m_active( CheckSampled< samplePeriod >::ShouldCheck() )
+    {
+        if ( !m_active )
+            return;
+        new ( m_policy.space ) Ep( host );
+        assert( Check() );
+        if ( 0 != m_pre )
+            assert( ( m_host->*( m_pre ) )() );
+    }
+
+    inline ~ContractChecker( void )
+    {
+        if ( !m_active )
+            return;
+        assert( Check() );
+        if ( 0 != m_post )
+            assert( ( m_host->*( m_post ) )() );
+        assert( GetPolicy()->Check( m_host ) );
+        GetPolicy()->~Ep();
+    }
+
+    /** Checks the invariants just as the primary template does, but quietly
+     passes for the invocations sampling skipped.
+     */
+    inline bool Check( void ) const
+    {
+        if ( !m_active )
+            return true;
+        assert( 0 != this );
+        assert( 0 != m_host );
+        assert( 0 != m_validator );
+        const bool okay = ( m_host->*( m_validator ) )();
+        assert( okay );
+        return okay;
+    }
+
+private:
+
+    /// Default constructor is not implemented.
+    ContractChecker( void );
+    /// Copy constructor is not implemented.
+    ContractChecker( const ContractChecker & );
+    /// Copy-assignment operator is not implemented.
+    ContractChecker & operator = ( const ContractChecker & );
+
+    inline Ep * GetPolicy( void )
+    {
+        return reinterpret_cast< Ep * >( m_policy.space );
+    }
+
+    /// Pointer to the host object.
+    const Host * m_host;
+
+    /// Pointer to member function that checks Host object's invariants.
+    Validator m_validator;
+
+    /// Pointer to member function that checks Host object's pre-conditions.
+    Validator m_pre;
+
+    /// Pointer to member function that checks Host object's post-conditions.
+    Validator m_post;
+
+    /// Room for the ExceptionPolicy, constructed only when this invocation
+    /// got sampled in.
+    union
+    {
+        double alignment;
+        char space[ sizeof( Ep ) ];
+    } m_policy;
+
+    /// True when this invocation checks.
+    const bool m_active;
+
+};
+
+// ----------------------------------------------------------------------------
+
+/** @class ContractChecker< Host, ExceptionPolicy, CheckNever >
+ Specialization for disabled checking.  The object is empty and every member
+ is a no-op, so the optimizer removes the checker altogether.
+ */
+
+template
+<
+    class Host,
+    template < class > class ExceptionPolicy
+>
+class ContractChecker< Host, ExceptionPolicy, CheckNever >
+{
+public:
+
+    /// Signature for the validation function.
+    typedef bool ( Host:: * Validator )( void ) const;
+
+    inline ContractChecker( const Host *, Validator,
+        Validator = 0, Validator = 0 ) {}
+
+    inline bool Check( void ) const { return true; }
+
+private:
+
+    /// Default constructor is not implemented.
+    ContractChecker( void );
+    /// Copy constructor is not implemented.
+    ContractChecker( const ContractChecker & );
+    /// Copy-assignment operator is not implemented.
+    ContractChecker & operator = ( const ContractChecker & );
+
+};
+
+// ----------------------------------------------------------------------------
+
 /** @class CheckStaticForNoThrow
 
  @par Exception Safety Level:
@@ -428,7 +646,8 @@ public:
 
 template
 <
-    class ExceptionPolicy
+    class ExceptionPolicy,
+    class CheckingLevel = CheckAlways
 >
 class StaticChecker : public ExceptionPolicy
 {
@@ -511,6 +730,125 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/** @class StaticChecker< ExceptionPolicy, CheckSampled< samplePeriod > >
+ Specialization for sampled checking of static functions.  One invocation in
+ every samplePeriod per thread checks; the rest cost one thread-local
+ decrement.
+ */
+
+template
+<
+    class ExceptionPolicy,
+    unsigned int samplePeriod
+>
+class StaticChecker< ExceptionPolicy, CheckSampled< samplePeriod > >
+    : public ExceptionPolicy
+{
+    /// Shorthand for the ExceptionPolicy class.
+    typedef ExceptionPolicy Ep;
+
+public:
+
+    /// Signature for the validation function.
+    typedef bool ( * Validator )( void );
+
+    inline explicit StaticChecker( Validator validator,
+        Validator pre = 0, Validator post = 0 ) :
+        Ep(),
+        m_validator( validator ),
+        m_pre( pre ),
+        m_post( post ),
+        m_active( CheckSampled< samplePeriod >::ShouldCheck() )
+    {
+        if ( !m_active )
+            return;
+        assert( Check() );
+        if ( 0 != m_pre )
+            assert( m_pre() );
+    }
+
+    inline ~StaticChecker( void )
+    {
+        if ( !m_active )
+            return;
+        assert( Check() );
+        if ( 0 != m_post )
+            assert( m_post() );
+        assert( Ep::Check() );
+    }
+
+    /** Checks the invariants just as the primary template does, but quietly
+     passes for the invocations sampling skipped.
+     */
+    inline bool Check( void ) const
+    {
+        if ( !m_active )
+            return true;
+        assert( 0 != this );
+        assert( 0 != m_validator );
+        const bool okay = m_validator();
+        assert( okay );
+        return okay;
+    }
+
+private:
+
+    /// Default constructor is not implemented.
+    StaticChecker( void );
+    /// Copy constructor is not implemented.
+    StaticChecker( const StaticChecker & );
+    /// Copy-assignment operator is not implemented.
+    StaticChecker & operator = ( const StaticChecker & );
+
+    /// Pointer to member function that checks Host object's invariants.
+    Validator m_validator;
+
+    /// Pointer to member function that checks Host object's pre-conditions.
+    Validator m_pre;
+
+    /// Pointer to member function that checks Host object's post-conditions.
+    Validator m_post;
+
+    /// True when this invocation checks.
+    const bool m_active;
+
+};
+
+// ----------------------------------------------------------------------------
+
+/** @class StaticChecker< ExceptionPolicy, CheckNever >
+ Specialization for disabled checking of static functions.  Empty, so the
+ checker compiles away.
+ */
+
+template
+<
+    class ExceptionPolicy
+>
+class StaticChecker< ExceptionPolicy, CheckNever >
+{
+public:
+
+    /// Signature for the validation function.
+    typedef bool ( * Validator )( void );
+
+    inline explicit StaticChecker( Validator, Validator = 0, Validator = 0 ) {}
+
+    inline bool Check( void ) const { return true; }
+
+private:
+
+    /// Default constructor is not implemented.
+    StaticChecker( void );
+    /// Copy constructor is not implemented.
+    StaticChecker( const StaticChecker & );
+    /// Copy-assignment operator is not implemented.
+    StaticChecker & operator = ( const StaticChecker & );
+
+};
+
+// ----------------------------------------------------------------------------
+
 }; // end namespace Loki
 
 #endif
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Copyright (c) 2009 Loki project
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The authors make no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LOKI_CONCURRENT_QUEUE_INC_
+#define LOKI_CONCURRENT_QUEUE_INC_
+
+// $Id$
+
+#include <loki/Threads.h>
+
+#include <cassert>
+#include <cstddef>
+
+
+namespace Loki
+{
+
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class ConcurrentQueue
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  A bounded multi-producer multi-consumer queue over a ring of
+    ///  slots, synchronized with the atomic operations of the default
+    ///  threading model instead of a mutex.  Each slot carries a sequence
+    ///  number that tells producers and consumers whose turn it is; a
+    ///  thread claims a slot with one compare-and-swap on its cursor and
+    ///  publishes it with one release store, so an uncontended handoff
+    ///  costs two atomic operations and no kernel transition.
+    ///
+    ///  Push and Pop never block: they return false when the ring is
+    ///  full or empty and leave waiting strategy to the caller, who
+    ///  knows whether spinning, yielding or backing off fits the load.
+    ///
+    ///  The element type must be default constructible and assignable;
+    ///  the ring constructs all slots up front and moves values in and
+    ///  out by assignment.  Capacity is rounded up to a power of two so
+    ///  slot selection is a mask, not a division.
+    ///
+    ///  Under the single threaded model the atomics collapse to plain
+    ///  operations and the queue degenerates to a cheap ring buffer.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template < class T >
+    class ConcurrentQueue
+    {
+        typedef LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL< ConcurrentQueue > Atomics;
+
+    public:
+
+        typedef typename Atomics::IntType IntType;
+        typedef T ValueType;
+
+        /// Makes a queue holding at least capacity elements; the actual
+        /// capacity is the next power of two.
+        explicit ConcurrentQueue( unsigned int capacity )
+        {
+            IntType size = 2;
+            while ( size < static_cast< IntType >( capacity ) )
+                size *= 2;
+            slots_ = new Slot[ size ];
+            mask_ = size - 1;
+            for ( IntType i = 0; i < size; ++i )
+                slots_[ i ].sequence = i;
+            pushCursor_.pos = 0;
+            popCursor_.pos = 0;
+        }
+
+        ~ConcurrentQueue()
+        {
+            delete [] slots_;
+        }
+
+        /// Copies value into the queue.  Returns false, without
+        /// blocking, when the ring is full.
+        bool Push( const T & value )
+        {
+            IntType pos = Atomics::AtomicLoadRelaxed( pushCursor_.pos );
+            for ( ;; )
+            {
+                Slot & slot = slots_[ pos & mask_ ];
+                const IntType seq = Atomics::AtomicLoadAcquire( slot.sequence );
+                const IntType diff = seq - pos;
+                if ( 0 == diff )
+                {
+                    // our turn - claim the slot by advancing the cursor
+                    if ( Atomics::AtomicCompareAndSwap( pushCursor_.pos, pos, pos + 1 ) )
+                    {
+                        slot.value = value;
+                        // hands the slot to the consumer expecting pos + 1
+                        Atomics::AtomicAssignRelease( slot.sequence, pos + 1 );
+                        return true;
+                    }
+                    // another producer took it; reload and retry
+                    pos = Atomics::AtomicLoadRelaxed( pushCursor_.pos );
+                }
+                else if ( diff < 0 )
+                {
+                    // the consumer a full lap behind has not freed it yet
+                    return false;
+                }
+                else
+                {
+                    pos = Atomics::AtomicLoadRelaxed( pushCursor_.pos );
+                }
+            }
+        }
+
+        /// Moves the oldest element into value.  Returns false, without
+        /// blocking, when the ring is empty.
+        bool Pop( T & value )
+        {
+            IntType pos = Atomics::AtomicLoadRelaxed( popCursor_.pos );
+            for ( ;; )
+            {
+                Slot & slot = slots_[ pos & mask_ ];
+                const IntType seq = Atomics::AtomicLoadAcquire( slot.sequence );
+                const IntType diff = seq - ( pos + 1 );
+                if ( 0 == diff )
+                {
+                    if ( Atomics::AtomicCompareAndSwap( popCursor_.pos, pos, pos + 1 ) )
+                    {
+                        value = slot.value;
+                        // frees the slot for the producer one lap ahead
+                        Atomics::AtomicAssignRelease( slot.sequence, pos + mask_ + 1 );
+                        return true;
+                    }
+                    pos = Atomics::AtomicLoadRelaxed( popCursor_.pos );
+                }
+                else if ( diff < 0 )
+                {
+                    // the producer has not published this slot yet
+                    return false;
+                }
+                else
+                {
+                    pos = Atomics::AtomicLoadRelaxed( popCursor_.pos );
+                }
+            }
+        }
+
+        /// The number of elements the ring can hold.
+        unsigned int Capacity( void ) const
+        {
+            return static_cast< unsigned int >( mask_ + 1 );
+        }
+
+        /// A snapshot of the element count - by the time it returns, the
+        /// count may have changed; use it for monitoring, not decisions.
+        unsigned int Size( void ) const
+        {
+            const IntType pushes = Atomics::AtomicLoadRelaxed( pushCursor_.pos );
+            const IntType pops   = Atomics::AtomicLoadRelaxed( popCursor_.pos );
+            return ( pushes < pops ) ? 0
+                : static_cast< unsigned int >( pushes - pops );
+        }
+
+    private:
+
+        /// Not implemented.
+        ConcurrentQueue( const ConcurrentQueue & );
+        /// Not implemented.
+        ConcurrentQueue & operator = ( const ConcurrentQueue & );
+
+        struct Slot
+        {
+            volatile IntType sequence;
+            T value;
+        };
+
+        ///  Each cursor sits in its own cache line, as the slots of
+        ///  DistributedCounter do, so producers hammering the push side
+        ///  do not invalidate the line the consumers read.
+        struct PaddedCursor
+        {
+            volatile IntType pos;
+            char padding[ 64 - sizeof(IntType) ];
+        };
+
+        Slot * slots_;
+        IntType mask_;
+        PaddedCursor pushCursor_;
+        PaddedCursor popCursor_;
+    };
+
+} // namespace Loki
+
+#endif // end file guardian
@@ -17,6 +17,9 @@
 
 #include "Typelist.h"
 
+#include <cstddef>
+#include <typeinfo>
+
 //Reference version
 
 /************************************************************************************
@@ -49,6 +52,7 @@ namespace Loki
         template<typename T>
         struct nameof_type
             {
+            typedef const char* result_type;
             const char* operator()()
                 {
                 return typeid(T).name();
@@ -57,6 +61,7 @@ namespace Loki
         template<typename T>
         struct sizeof_type
             {
+            typedef size_t result_type;
             size_t operator()()
                 {
                 return sizeof(T);
@@ -106,6 +111,66 @@ namespace Loki
         Loki::TL::IterateTypes<Types, UnitFunc> it;
         it(ii);
         }
+
+/************************************************************************************
+// class template GenDataTable
+// Materializes the generated data into a fixed-size static array instead
+// of re-running the iteration into an output iterator on every call.
+// The array size comes from TL::Length at compile time; the entries are
+// filled exactly once, on the first call to table(), and every later
+// call just returns the same pointer.  Lookup tables built from
+// typelists are therefore generated once per process, not once per use.
+//
+// The generator functor must expose a result_type typedef naming the
+// element type (see nameof_type and sizeof_type above).  The typelist
+// must not be empty - an empty table has no element type to deduce.
+//
+
+Example Use
+
+typedef Loki::TL::GenDataTable<parameter_tl, Loki::TL::nameof_type> NameTable;
+const char* const* names = NameTable::table();
+for(size_t i=0; i<NameTable::size; ++i)
+    register_name(names[i]);
+*******************************************************************************/
+    template
+        <
+        typename Types,
+        template <class> class UnitFunc,
+        typename ResultType =
+            typename UnitFunc<typename TypeAt<Types, 0>::Result>::result_type
+        >
+    struct GenDataTable
+        {
+        typedef ResultType value_type;
+        enum { size = Length<Types>::value };
+        static const value_type* table()
+            {
+            static const Holder holder;
+            return holder.values;
+            }
+    private:
+        // IterateTypes passes the output iterator by value, so a raw
+        // pointer would rewind between sublists; this cursor advances a
+        // shared position, like a back_inserter over the array.
+        struct Filler
+            {
+            value_type** pCursor;
+            explicit Filler(value_type** p) : pCursor(p) {}
+            Filler& operator*() { return *this; }
+            Filler& operator++() { return *this; }
+            void operator=(value_type value) { *(*pCursor)++ = value; }
+            };
+        struct Holder
+            {
+            value_type values[size];
+            Holder()
+                {
+                value_type* cursor = values;
+                iterate_types<Types, UnitFunc>(Filler(&cursor));
+                }
+            };
+        };
     }//ns TL
 }//ns Loki
 
@@ -22,6 +22,11 @@
 #include "SmallObj.h"
 #include "Sequence.h"
 
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4702)
@@ -101,6 +106,28 @@ namespace Loki
         }
     };
 
+/**
+ * \class NullFactoryError
+ * \ingroup	FactoryErrorPoliciesGroup
+ * \brief	Policy that answers an unknown identifier with a null product
+ *
+ * For factories where unknown identifiers are part of normal traffic -
+ * a protocol bridge dropping message types it does not speak, say - the
+ * default policy's throw/unwind cycle dominates the miss path.  With
+ * this policy CreateObject returns 0 on a miss instead, so callers must
+ * check the result.  See also Factory::TryCreateObject, which skips the
+ * error policy altogether regardless of which policy is installed.
+ */
+
+    template <typename IdentifierType, class AbstractProduct>
+    struct NullFactoryError
+    {
+        static AbstractProduct* OnUnknownType(IdentifierType)
+        {
+            return 0;
+        }
+    };
+
 
 #define LOKI_ENABLE_NEW_FACTORY_CODE
 #ifdef LOKI_ENABLE_NEW_FACTORY_CODE
@@ -726,6 +753,810 @@ template <typename AP, typename Id, typename P1 >
 #endif //LOKI_DISABLE_TYPELIST_MACROS
 
 
+///  \def LOKI_FACTORY_FLAT_CREATORS
+///  \ingroup FactoryGroup
+///  Stores each creator flattened inside the factory's lookup structure -
+///  the callable itself lives next to its id, invoked through a stored
+///  stub - instead of as a Functor whose implementation sits on the heap.
+///  CreateObject then reads contiguous memory and makes one call.  Off by
+///  default because the record is wider than a Functor.
+#ifndef LOKI_FACTORY_FLAT_CREATORS
+//#define LOKI_FACTORY_FLAT_CREATORS
+#endif
+
+///  \def LOKI_FACTORY_FLAT_CREATOR_SIZE
+///  \ingroup FactoryGroup
+///  Room reserved for the callable inside each flattened creator record.
+///  Callables that do not fit are wrapped in a Functor, which always does.
+#ifndef LOKI_FACTORY_FLAT_CREATOR_SIZE
+#define LOKI_FACTORY_FLAT_CREATOR_SIZE ( 4 * sizeof(void *) )
+#endif
+
+
+/**
+ * \defgroup	FactoryStoragePoliciesGroup Factory Storage Policies
+ * \ingroup		FactoryGroup
+ * \brief		Selects the associative container a Factory keeps its
+ *  creators in.
+ *
+ *  A storage policy maps IdentifierType to ProductCreator and must provide
+ *  Insert, Erase, Find and CollectIds.  The default, AssocVectorFactoryStorage,
+ *  preserves the historical sorted-vector behaviour.  OpenHashFactoryStorage
+ *  trades ordered iteration for O(1) lookup and is the better choice when
+ *  CreateObject sits on a hot path with many registered ids.
+ *  SnapshotFactoryStorage lets CreateObject run lock-free on many threads
+ *  while Register stays possible at runtime.
+ */
+
+/**
+ * \class		FactoryIdHash
+ * \ingroup		FactoryStoragePoliciesGroup
+ * \brief		Hash function used by OpenHashFactoryStorage.
+ *
+ *  The primary template handles ids convertible to an integer; a
+ *  specialization covers std::string.  Specialize FactoryIdHash for your own
+ *  IdentifierType to use it with OpenHashFactoryStorage.
+ */
+
+    template <typename IdentifierType>
+    struct FactoryIdHash
+    {
+        std::size_t operator()(const IdentifierType& id) const
+        {
+            // Knuth's multiplicative step spreads small integer ids.
+            return static_cast<std::size_t>(id) * 2654435761u;
+        }
+    };
+
+    template <typename T>
+    struct FactoryIdHash<T*>
+    {
+        std::size_t operator()(const T* id) const
+        {
+            // Shift out the alignment zeroes before spreading.
+            return (reinterpret_cast<std::size_t>(id) >> 4) * 2654435761u;
+        }
+    };
+
+    template <>
+    struct FactoryIdHash<std::string>
+    {
+        std::size_t operator()(const std::string& id) const
+        {
+            // FNV-1a
+            std::size_t hash = 2166136261u;
+            for (std::string::size_type i = 0; i != id.size(); ++i)
+            {
+                hash ^= static_cast<unsigned char>(id[i]);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    };
+
+/**
+ * \class		AssocVectorFactoryStorage
+ * \ingroup		FactoryStoragePoliciesGroup
+ * \brief		Default storage policy: a sorted vector with binary search.
+ */
+
+    template <typename IdentifierType, class ProductCreator>
+    class AssocVectorFactoryStorage
+    {
+        typedef AssocVector<IdentifierType, ProductCreator> Map;
+
+        Map map_;
+
+    public:
+
+        bool Insert(const IdentifierType& id, const ProductCreator& creator)
+        {
+            return map_.insert(
+                typename Map::value_type(id, creator)).second != 0;
+        }
+
+        bool Erase(const IdentifierType& id)
+        {
+            return map_.erase(id) != 0;
+        }
+
+        ProductCreator* Find(const IdentifierType& id)
+        {
+            typename Map::iterator i = map_.find(id);
+            if (i == map_.end())
+                return 0;
+            return &i->second;
+        }
+
+        void CollectIds(std::vector<IdentifierType>& ids) const
+        {
+            for (typename Map::const_iterator i = map_.begin();
+                i != map_.end(); ++i)
+            {
+                ids.push_back(i->first);
+            }
+        }
+    };
+
+/**
+ * \class		OpenHashFactoryStorage
+ * \ingroup		FactoryStoragePoliciesGroup
+ * \brief		Open-addressing hash table with precomputed id hashes.
+ *
+ *  Each bucket stores the hash of its id next to the id itself, so a lookup
+ *  compares hashes before touching the id and a rehash never recomputes a
+ *  hash; with string ids CreateObject costs one hash plus, typically, one
+ *  probe instead of a cascade of string comparisons.  Linear probing over a
+ *  power-of-two table, erased slots are tombstoned and reclaimed on the next
+ *  rehash.  Requires IdentifierType to be default constructible and
+ *  equality comparable; ids come back from RegisteredIds in no particular
+ *  order.
+ */
+
+    template <typename IdentifierType, class ProductCreator>
+    class OpenHashFactoryStorage
+    {
+        enum { bucketEmpty = 0, bucketUsed = 1, bucketErased = 2 };
+
+        struct Bucket
+        {
+            Bucket() : hash(0), state(bucketEmpty), id(), creator()
+            {}
+
+            std::size_t hash;
+            unsigned char state;
+            IdentifierType id;
+            ProductCreator creator;
+        };
+
+        typedef std::vector<Bucket> Buckets;
+
+        Buckets buckets_;
+        std::size_t used_;   // live entries
+        std::size_t filled_; // live entries plus tombstones
+
+    public:
+
+        OpenHashFactoryStorage() : buckets_(), used_(0), filled_(0)
+        {}
+
+        bool Insert(const IdentifierType& id, const ProductCreator& creator)
+        {
+            // Keep at least a quarter of the table empty so probe chains
+            // stay short and Lookup always hits an empty bucket.
+            if (buckets_.empty() || (filled_ + 1) * 4 >= buckets_.size() * 3)
+                Rehash();
+            const std::size_t hash = FactoryIdHash<IdentifierType>()(id);
+            const std::size_t mask = buckets_.size() - 1;
+            std::size_t insertAt = buckets_.size();
+            for (std::size_t i = hash & mask; ; i = (i + 1) & mask)
+            {
+                Bucket& bucket = buckets_[i];
+                if (bucket.state == bucketEmpty)
+                {
+                    if (insertAt == buckets_.size())
+                        insertAt = i;
+                    break;
+                }
+                if (bucket.state == bucketErased)
+                {
+                    if (insertAt == buckets_.size())
+                        insertAt = i;
+                }
+                else if (bucket.hash == hash && bucket.id == id)
+                    return false;
+            }
+            Bucket& bucket = buckets_[insertAt];
+            if (bucket.state == bucketEmpty)
+                ++filled_;
+            bucket.hash = hash;
+            bucket.state = bucketUsed;
+            bucket.id = id;
+            bucket.creator = creator;
+            ++used_;
+            return true;
+        }
+
+        bool Erase(const IdentifierType& id)
+        {
+            Bucket* bucket = Lookup(id);
+            if (bucket == 0)
+                return false;
+            bucket->state = bucketErased;
+            bucket->id = IdentifierType();
+            bucket->creator = ProductCreator();
+            --used_;
+            return true;
+        }
+
+        ProductCreator* Find(const IdentifierType& id)
+        {
+            Bucket* bucket = Lookup(id);
+            if (bucket == 0)
+                return 0;
+            return &bucket->creator;
+        }
+
+        void CollectIds(std::vector<IdentifierType>& ids) const
+        {
+            for (std::size_t i = 0; i != buckets_.size(); ++i)
+            {
+                if (buckets_[i].state == bucketUsed)
+                    ids.push_back(buckets_[i].id);
+            }
+        }
+
+    private:
+
+        Bucket* Lookup(const IdentifierType& id)
+        {
+            if (buckets_.empty())
+                return 0;
+            const std::size_t hash = FactoryIdHash<IdentifierType>()(id);
+            const std::size_t mask = buckets_.size() - 1;
+            for (std::size_t i = hash & mask; ; i = (i + 1) & mask)
+            {
+                Bucket& bucket = buckets_[i];
+                if (bucket.state == bucketEmpty)
+                    return 0;
+                if (bucket.state == bucketUsed &&
+                    bucket.hash == hash && bucket.id == id)
+                    return &bucket;
+            }
+        }
+
+        void Rehash()
+        {
+            std::size_t newSize = buckets_.empty() ? 8 : buckets_.size();
+            if ((used_ + 1) * 2 >= newSize)
+                newSize *= 2;
+            Buckets old;
+            old.swap(buckets_);
+            buckets_.resize(newSize);
+            filled_ = used_;
+            const std::size_t mask = newSize - 1;
+            for (std::size_t k = 0; k != old.size(); ++k)
+            {
+                if (old[k].state != bucketUsed)
+                    continue;
+                // Placement reuses the hash stored at registration time.
+                std::size_t i = old[k].hash & mask;
+                while (buckets_[i].state == bucketUsed)
+                    i = (i + 1) & mask;
+                buckets_[i] = old[k];
+            }
+        }
+    };
+
+/**
+ * \class		SnapshotFactoryStorage
+ * \ingroup		FactoryStoragePoliciesGroup
+ * \brief		Immutable snapshots: lock-free Find, locked Register.
+ *
+ *  The creator map is an immutable AssocVector published through an atomic
+ *  pointer.  Find loads the pointer with acquire ordering and searches the
+ *  snapshot without any lock, so any number of threads can call
+ *  CreateObject concurrently at full speed.  Insert and Erase serialize on
+ *  a mutex, copy the current snapshot, apply the change to the copy and
+ *  publish it with a release store - so registration (plugin loading)
+ *  stays possible while creators run.
+ *
+ *  Readers may still be inside a snapshot when it is replaced, so retired
+ *  snapshots are kept until the factory is destroyed instead of being
+ *  freed on the spot.  Memory is therefore bounded by the number of
+ *  registrations over the factory's lifetime, which is the usual RCU
+ *  trade: registration is rare, creation is hot.  Requires a
+ *  LOKI_*_THREADING macro for the atomicity and the mutex to be real; in a
+ *  single-threaded build everything degrades to plain loads and stores.
+ */
+
+    template <typename IdentifierType, class ProductCreator>
+    class SnapshotFactoryStorage
+    {
+        typedef AssocVector<IdentifierType, ProductCreator> Map;
+        typedef LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL<Map*> PublishGuard;
+
+        class WriteLocker
+        {
+        public:
+            WriteLocker(Mutex& mutex) : mutex_(mutex)
+            {
+                mutex_.Lock();
+            }
+            ~WriteLocker()
+            {
+                mutex_.Unlock();
+            }
+        private:
+            WriteLocker(const WriteLocker&);
+            WriteLocker& operator=(const WriteLocker&);
+            Mutex& mutex_;
+        };
+
+        // Readers may still hold the outgoing snapshot; it joins the
+        // retired list and dies with the factory.
+        void Publish(Map* fresh)
+        {
+            Map* outgoing = current_;
+            retired_.push_back(outgoing);
+            PublishGuard::AtomicAssignPtrRelease(current_, fresh);
+        }
+
+        // Plain read of the current snapshot; call with writeLock_ held.
+        Map* Current() const
+        {
+            return current_;
+        }
+
+        mutable typename PublishGuard::VolatileType current_;
+        std::vector<Map*> retired_;
+        Mutex writeLock_;
+
+    public:
+
+        SnapshotFactoryStorage() : current_(new Map), retired_(), writeLock_()
+        {}
+
+        SnapshotFactoryStorage(const SnapshotFactoryStorage& rhs)
+            : current_(new Map(*PublishGuard::AtomicLoadPtrAcquire(rhs.current_)))
+            , retired_(), writeLock_()
+        {}
+
+        SnapshotFactoryStorage& operator=(const SnapshotFactoryStorage& rhs)
+        {
+            if (this != &rhs)
+            {
+                Map* fresh =
+                    new Map(*PublishGuard::AtomicLoadPtrAcquire(rhs.current_));
+                WriteLocker guard(writeLock_);
+                Publish(fresh);
+            }
+            return *this;
+        }
+
+        ~SnapshotFactoryStorage()
+        {
+            delete Current();
+            for (std::size_t i = 0; i != retired_.size(); ++i)
+                delete retired_[i];
+        }
+
+        bool Insert(const IdentifierType& id, const ProductCreator& creator)
+        {
+            WriteLocker guard(writeLock_);
+            Map* fresh = new Map(*Current());
+            const bool inserted = fresh->insert(
+                typename Map::value_type(id, creator)).second != 0;
+            if (!inserted)
+            {
+                delete fresh;
+                return false;
+            }
+            Publish(fresh);
+            return true;
+        }
+
+        bool Erase(const IdentifierType& id)
+        {
+            WriteLocker guard(writeLock_);
+            Map* fresh = new Map(*Current());
+            if (fresh->erase(id) == 0)
+            {
+                delete fresh;
+                return false;
+            }
+            Publish(fresh);
+            return true;
+        }
+
+        ProductCreator* Find(const IdentifierType& id)
+        {
+            Map* snapshot = PublishGuard::AtomicLoadPtrAcquire(current_);
+            typename Map::iterator i = snapshot->find(id);
+            if (i == snapshot->end())
+                return 0;
+            return &i->second;
+        }
+
+        void CollectIds(std::vector<IdentifierType>& ids) const
+        {
+            Map* snapshot = PublishGuard::AtomicLoadPtrAcquire(current_);
+            for (typename Map::const_iterator i = snapshot->begin();
+                i != snapshot->end(); ++i)
+            {
+                ids.push_back(i->first);
+            }
+        }
+    };
+
+
+    namespace Private
+    {
+        ////////////////////////////////////////////////////////////////////////
+        //  Number of creator parameters in a CreatorParmTList, whether it is
+        //  NullType, a Seq<...> or a LOKI_TYPELIST_n.
+        ////////////////////////////////////////////////////////////////////////
+        template <class TList>
+        struct CreatorParmCount
+        {
+            // Seq<...> exposes its typelist as Type
+            enum { value = TL::Length<typename TList::Type>::value };
+        };
+
+        template <>
+        struct CreatorParmCount<NullType>
+        {
+            enum { value = 0 };
+        };
+
+        template <class Head, class Tail>
+        struct CreatorParmCount< Typelist<Head, Tail> >
+        {
+            enum { value = TL::Length< Typelist<Head, Tail> >::value };
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        //  Calls the callable stored inside a FlatCreator's buffer with the
+        //  factory's parameter types; one specialization per arity, selected
+        //  by CreatorParmCount.  Creator supplies the Parm typedefs.
+        ////////////////////////////////////////////////////////////////////////
+        template <class AbstractProduct, class Creator, typename Fn, int parms>
+        struct FlatCreatorInvoker;
+
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 0>
+        {
+            static AbstractProduct* Invoke(void* space)
+            {
+                return (*static_cast<Fn*>(space))();
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 1>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1)
+            {
+                return (*static_cast<Fn*>(space))( p1 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 2>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 3>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 4>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 5>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 6>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 7>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 8>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 9>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 10>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 11>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10, typename Creator::Parm11 p11)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 12>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10, typename Creator::Parm11 p11, typename Creator::Parm12 p12)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 13>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10, typename Creator::Parm11 p11, typename Creator::Parm12 p12, typename Creator::Parm13 p13)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 14>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10, typename Creator::Parm11 p11, typename Creator::Parm12 p12, typename Creator::Parm13 p13, typename Creator::Parm14 p14)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14 );
+            }
+        };
+        template <class AbstractProduct, class Creator, typename Fn>
+        struct FlatCreatorInvoker<AbstractProduct, Creator, Fn, 15>
+        {
+            static AbstractProduct* Invoke(void* space,
+            typename Creator::Parm1 p1, typename Creator::Parm2 p2, typename Creator::Parm3 p3, typename Creator::Parm4 p4, typename Creator::Parm5 p5, typename Creator::Parm6 p6, typename Creator::Parm7 p7, typename Creator::Parm8 p8, typename Creator::Parm9 p9, typename Creator::Parm10 p10, typename Creator::Parm11 p11, typename Creator::Parm12 p12, typename Creator::Parm13 p13, typename Creator::Parm14 p14, typename Creator::Parm15 p15)
+            {
+                return (*static_cast<Fn*>(space))( p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15 );
+            }
+        };
+
+/**
+ * \class		FlatCreator
+ * \ingroup		FactoryGroup
+ * \brief		Creator record with the callable stored inline.
+ *
+ *  Holds the registered callable in a buffer inside the record itself,
+ *  next to its id in whatever container the storage policy uses, plus the
+ *  stub that invokes it.  A dispatch is therefore a read of the stub and
+ *  the callable from memory the id lookup already touched, then one call -
+ *  no hop to a heap-allocated FunctorImpl and no virtual dispatch.
+ *  Callables wider than the buffer are wrapped in a Functor, restoring the
+ *  old layout for them; the buffer is sized so the wrapper always fits.
+ *  Selected by defining LOKI_FACTORY_FLAT_CREATORS.
+ */
+        template <class AbstractProduct, class ParmTList>
+        class FlatCreator
+        {
+            typedef Functor<AbstractProduct*, ParmTList> WrappedCreator;
+            typedef AbstractProduct* (*GenericStub)();
+
+            enum { parmCount = CreatorParmCount<ParmTList>::value };
+            enum
+            {
+                bufferSize =
+                    sizeof(WrappedCreator) > LOKI_FACTORY_FLAT_CREATOR_SIZE
+                        ? sizeof(WrappedCreator)
+                        : LOKI_FACTORY_FLAT_CREATOR_SIZE
+            };
+
+            GenericStub stub_;
+            void (*destroy_)(void*);
+            void (*clone_)(void*, const void*);
+            union
+            {
+                double forAlignment_;
+                char space_[bufferSize];
+            };
+
+            template <typename Fn>
+            static void Destroy(void* space)
+            {
+                static_cast<Fn*>(space)->~Fn();
+            }
+
+            template <typename Fn>
+            static void Clone(void* space, const void* source)
+            {
+                ::new (space) Fn(*static_cast<const Fn*>(source));
+            }
+
+            template <typename Fn>
+            void Bind(const Fn& fn, Int2Type<true>)
+            {
+                ::new (static_cast<void*>(space_)) Fn(fn);
+                stub_ = reinterpret_cast<GenericStub>(
+                    &FlatCreatorInvoker<AbstractProduct, WrappedCreator, Fn,
+                        parmCount>::Invoke);
+                destroy_ = &Destroy<Fn>;
+                clone_ = &Clone<Fn>;
+            }
+
+            // too wide for the inline space: wrap in a Functor, whose own
+            // size the buffer is guaranteed to cover
+            template <typename Fn>
+            void Bind(const Fn& fn, Int2Type<false>)
+            {
+                WrappedCreator wrapped(fn);
+                Bind(wrapped, Int2Type<true>());
+            }
+
+        public:
+
+            typedef typename WrappedCreator::Parm1 Parm1;
+            typedef typename WrappedCreator::Parm2 Parm2;
+            typedef typename WrappedCreator::Parm3 Parm3;
+            typedef typename WrappedCreator::Parm4 Parm4;
+            typedef typename WrappedCreator::Parm5 Parm5;
+            typedef typename WrappedCreator::Parm6 Parm6;
+            typedef typename WrappedCreator::Parm7 Parm7;
+            typedef typename WrappedCreator::Parm8 Parm8;
+            typedef typename WrappedCreator::Parm9 Parm9;
+            typedef typename WrappedCreator::Parm10 Parm10;
+            typedef typename WrappedCreator::Parm11 Parm11;
+            typedef typename WrappedCreator::Parm12 Parm12;
+            typedef typename WrappedCreator::Parm13 Parm13;
+            typedef typename WrappedCreator::Parm14 Parm14;
+            typedef typename WrappedCreator::Parm15 Parm15;
+
+            FlatCreator() : stub_(0), destroy_(0), clone_(0)
+            {}
+
+            template <typename Fn>
+            FlatCreator(Fn fn) : stub_(0), destroy_(0), clone_(0)
+            {
+                Bind(fn,
+                    Int2Type<sizeof(Fn) <= static_cast<size_t>(bufferSize)>());
+            }
+
+            FlatCreator(const FlatCreator& rhs)
+                : stub_(rhs.stub_), destroy_(rhs.destroy_), clone_(rhs.clone_)
+            {
+                if (clone_)
+                    clone_(space_, rhs.space_);
+            }
+
+            FlatCreator& operator=(const FlatCreator& rhs)
+            {
+                if (this != &rhs)
+                {
+                    if (destroy_)
+                        destroy_(space_);
+                    stub_ = rhs.stub_;
+                    destroy_ = rhs.destroy_;
+                    clone_ = rhs.clone_;
+                    if (clone_)
+                        clone_(space_, rhs.space_);
+                }
+                return *this;
+            }
+
+            ~FlatCreator()
+            {
+                if (destroy_)
+                    destroy_(space_);
+            }
+
+        AbstractProduct* operator()()
+        {
+            typedef AbstractProduct* (*Stub)(void*);
+            return reinterpret_cast<Stub>(stub_)(space_);
+        }
+        AbstractProduct* operator()( Parm1 p1 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1);
+            return reinterpret_cast<Stub>(stub_)(space_, p1);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10, Parm11);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11, Parm12 p12 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10, Parm11, Parm12);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10, Parm11, Parm12, Parm13);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10, Parm11, Parm12, Parm13, Parm14);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);
+        }
+        AbstractProduct* operator()( Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15 )
+        {
+            typedef AbstractProduct* (*Stub)(void*, Parm1, Parm2, Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10, Parm11, Parm12, Parm13, Parm14, Parm15);
+            return reinterpret_cast<Stub>(stub_)(space_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15);
+        }
+        };
+
+    } // namespace Private
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class Factory
 ///
@@ -741,13 +1572,20 @@ template <typename AP, typename Id, typename P1 >
 ///  Alternatively you could suppress for Functor the inheritance
 ///  from SmallObject by defining the macro:
 /// \code LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT \endcode
+///
+///  \par Storage
+///  The creators live in a storage policy, AssocVectorFactoryStorage by
+///  default.  Pass OpenHashFactoryStorage to turn the lookup in CreateObject
+///  into one hash plus a short probe, see
+///  \ref FactoryStoragePoliciesGroup "Factory Storage Policies".
 ////////////////////////////////////////////////////////////////////////////////
     template
     <
         class AbstractProduct,
         typename IdentifierType,
         typename CreatorParmTList = NullType,
-        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError
+        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError,
+        template<typename, class> class StoragePolicy = AssocVectorFactoryStorage
     >
     class Factory : public FactoryErrorPolicy<IdentifierType, AbstractProduct>
     {
@@ -771,7 +1609,14 @@ template <typename AP, typename Id, typename P1 >
 
         typedef Functor<AbstractProduct*, CreatorParmTList> ProductCreator;
 
-        typedef AssocVector<IdentifierType, ProductCreator> IdToProductMap;
+#ifdef LOKI_FACTORY_FLAT_CREATORS
+        typedef Private::FlatCreator<AbstractProduct, CreatorParmTList>
+            CreatorRecord;
+#else
+        typedef ProductCreator CreatorRecord;
+#endif
+
+        typedef StoragePolicy<IdentifierType, CreatorRecord> IdToProductMap;
 
         IdToProductMap associations_;
 
@@ -784,89 +1629,90 @@ template <typename AP, typename Id, typename P1 >
 
         ~Factory()
         {
-            associations_.erase(associations_.begin(), associations_.end());
         }
 
         bool Register(const IdentifierType& id, ProductCreator creator)
         {
-            return associations_.insert(
-                         typename IdToProductMap::value_type(id, creator)).second != 0;
+            return associations_.Insert(id, CreatorRecord(creator));
+        }
+
+        // Deducing the callable's real type here is what lets the flat
+        // record store and call it directly, without a Functor in between.
+        template <typename Fn>
+        bool Register(const IdentifierType& id, Fn fn)
+        {
+            return associations_.Insert(id, CreatorRecord(fn));
         }
 
         template <class PtrObj, typename CreaFn>
         bool Register(const IdentifierType& id, const PtrObj& p, CreaFn fn)
         {
             ProductCreator creator( p, fn );
-            return associations_.insert(
-                typename IdToProductMap::value_type(id, creator)).second != 0;
+            return associations_.Insert(id, CreatorRecord(creator));
         }
 
         bool Unregister(const IdentifierType& id)
         {
-            return associations_.erase(id) != 0;
+            return associations_.Erase(id);
         }
 
         std::vector<IdentifierType> RegisteredIds()
         {
             std::vector<IdentifierType> ids;
-            for(typename IdToProductMap::iterator it = associations_.begin();
-                it != associations_.end(); ++it)
-            {
-                ids.push_back(it->first);
-            }
+            associations_.CollectIds(ids);
             return ids;
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( );
             return this->OnUnknownType(id);
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1 );
             return this->OnUnknownType(id);
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1, Parm2 p2)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2 );
             return this->OnUnknownType(id);
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1, Parm2 p2, Parm3 p3)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3 );
             return this->OnUnknownType(id);
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4 );
             return this->OnUnknownType(id);
         }
 
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5 );
             return this->OnUnknownType(id);
         }
 
@@ -874,9 +1720,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
                                             Parm6 p6)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6 );
             return this->OnUnknownType(id);
         }
 
@@ -884,9 +1730,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
                                             Parm6 p6, Parm7 p7 )
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7 );
             return this->OnUnknownType(id);
         }
 
@@ -894,9 +1740,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
                                             Parm6 p6, Parm7 p7, Parm8 p8)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8 );
             return this->OnUnknownType(id);
         }
 
@@ -904,18 +1750,18 @@ template <typename AP, typename Id, typename P1 >
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
                                             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9 );
             return this->OnUnknownType(id);
         }
         AbstractProduct* CreateObject(const IdentifierType& id,
                                             Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
                                             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9,Parm10 p10)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10 );
             return this->OnUnknownType(id);
         }
 
@@ -924,9 +1770,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm6  p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
                                             Parm11 p11)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11 );
             return this->OnUnknownType(id);
         }
 
@@ -935,9 +1781,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm6  p6,  Parm7  p7, Parm8 p8, Parm9 p9, Parm10 p10,
                                             Parm11 p11, Parm12 p12)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12 );
             return this->OnUnknownType(id);
         }
 
@@ -946,9 +1792,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm6  p6,  Parm7  p7,  Parm8  p8, Parm9 p9, Parm10 p10,
                                             Parm11 p11, Parm12 p12, Parm13 p13)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13 );
             return this->OnUnknownType(id);
         }
 
@@ -957,9 +1803,9 @@ template <typename AP, typename Id, typename P1 >
                                             Parm6  p6,  Parm7  p7,  Parm8  p8,  Parm9  p9, Parm10 p10,
                                             Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14 );
             return this->OnUnknownType(id);
         }
 
@@ -968,12 +1814,174 @@ template <typename AP, typename Id, typename P1 >
                                             Parm6  p6,  Parm7  p7,  Parm8  p8,  Parm9  p9,  Parm10 p10,
                                             Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
         {
-            typename IdToProductMap::iterator i = associations_.find(id);
-            if (i != associations_.end())
-                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15 );
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15 );
             return this->OnUnknownType(id);
         }
 
+        /// Like CreateObject, but an unknown identifier returns a null
+        /// product without consulting the error policy, so a miss that is
+        /// part of normal traffic costs one failed lookup instead of the
+        /// throw/unwind cycle of the default policy.  The overload set
+        /// mirrors CreateObject's.
+        AbstractProduct* TryCreateObject(const IdentifierType& id)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7 )
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9 );
+            return 0;
+        }
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9,Parm10 p10)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1  p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5  p5,
+                                            Parm6  p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1  p1,  Parm2  p2, Parm3 p3, Parm4 p4, Parm5  p5,
+                                            Parm6  p6,  Parm7  p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1  p1,  Parm2  p2,  Parm3  p3, Parm4 p4, Parm5  p5,
+                                            Parm6  p6,  Parm7  p7,  Parm8  p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1  p1,  Parm2  p2,  Parm3  p3,  Parm4  p4, Parm5  p5,
+                                            Parm6  p6,  Parm7  p7,  Parm8  p8,  Parm9  p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14 );
+            return 0;
+        }
+
+        AbstractProduct* TryCreateObject(const IdentifierType& id,
+                                            Parm1  p1,  Parm2  p2,  Parm3  p3,  Parm4  p4,  Parm5  p5,
+                                            Parm6  p6,  Parm7  p7,  Parm8  p8,  Parm9  p9,  Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
+        {
+            CreatorRecord* creator = associations_.Find(id);
+            if (creator)
+                return (*creator)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15 );
+            return 0;
+        }
+
     };
 
 #else
@@ -1018,11 +2026,131 @@ template <typename AP, typename Id, typename P1 >
 
 #endif //#define ENABLE_NEW_FACTORY_CODE
 
+/**
+ * \defgroup	StaticFactoryGroup Static Factory
+ * \ingroup		FactoriesGroup
+ * \brief		Object factory over a product set fixed at compile time.
+ *
+ * \class		StaticFactory
+ * \ingroup		StaticFactoryGroup
+ * \brief		Creates products of a Typelist from a dense integer id.
+ *
+ *  When every product is known at build time -- the situation
+ *  RegisterOnCreateSet caters for -- filling an associative container at
+ *  startup only to search it again on every creation is wasted work.
+ *  StaticFactory takes the product Typelist directly; the id of a product
+ *  is its zero-based position in the list, available at compile time
+ *  through IdOf.  Dispatch expands to a dense comparison chain over
+ *  consecutive ids which optimizing compilers emit as a single indexed
+ *  jump, there is no registration step and no per-factory state.
+ *
+ *  Products must be default constructible.  Out-of-range ids go to the
+ *  usual FactoryErrorPolicy.
+ *
+ *  \par Usage
+ *  \code
+ *  typedef StaticFactory< Base, LOKI_TYPELIST_3(A, B, C) > MyFactory;
+ *  MyFactory factory;
+ *  Base* b = factory.CreateObject( MyFactory::IdOf<B>::value );
+ *  \endcode
+ */
+
+    namespace Private
+    {
+        template <class AbstractProduct, class TList>
+        struct StaticFactoryDispatcher;
+
+        template <class AbstractProduct>
+        struct StaticFactoryDispatcher<AbstractProduct, NullType>
+        {
+            // Not reached: StaticFactory bounds-checks the id first.
+            static AbstractProduct* Create(int)
+            {
+                return 0;
+            }
+        };
+
+        template <class AbstractProduct, class Head, class Tail>
+        struct StaticFactoryDispatcher<AbstractProduct, Typelist<Head, Tail> >
+        {
+            static AbstractProduct* Create(int id)
+            {
+                if (id == 0)
+                    return new Head;
+                return StaticFactoryDispatcher<AbstractProduct, Tail>::
+                    Create(id - 1);
+            }
+        };
+    }
+
+    template
+    <
+        class AbstractProduct,
+        class ProductList,
+        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError
+    >
+    class StaticFactory
+        : public FactoryErrorPolicy<int, AbstractProduct>
+    {
+    public:
+
+        enum { size = TL::Length<ProductList>::value };
+
+        /// Compile-time id of a product: its position in ProductList.
+        template <class ConcreteProduct>
+        struct IdOf
+        {
+            enum { value = TL::IndexOf<ProductList, ConcreteProduct>::value };
+        };
+
+        AbstractProduct* CreateObject(int id)
+        {
+            if (id < 0 || id >= static_cast<int>(size))
+                return this->OnUnknownType(id);
+            return Private::StaticFactoryDispatcher<AbstractProduct,
+                ProductList>::Create(id);
+        }
+    };
+
+
 /**
  *   \defgroup	CloneFactoryGroup Clone Factory
  *   \ingroup	FactoriesGroup
  *   \brief		Creates a copy from a polymorphic object.
  *
+ *   \class		CloneSlotted
+ *   \ingroup	CloneFactoryGroup
+ *   \brief		Opt-in base caching a CloneFactory slot in each object.
+ *
+ *   Derive AbstractProduct from CloneSlotted and CloneFactory dispatches
+ *   through a flat cloner table instead of the ordered TypeInfo map: each
+ *   registered type gets a small integer slot at Register time, the first
+ *   clone of an object caches that slot inside the object, and later
+ *   clones index the table directly - one type_info equality check to
+ *   guard against a stale slot, no before() comparisons.  Hierarchies
+ *   that do not derive from CloneSlotted keep the old lookup unchanged.
+ */
+
+    class CloneSlotted
+    {
+    public:
+        CloneSlotted() : cloneSlot_(0) {}
+    protected:
+        ~CloneSlotted() {}
+    private:
+        template
+        <
+            class,
+            class,
+            template<typename, class> class
+        >
+        friend class CloneFactory;
+        /// 1-based index into the factory's cloner table, 0 until cached;
+        /// mutable because caching happens while cloning a const model.
+        mutable unsigned int cloneSlot_;
+    };
+
+/**
  *   \class		CloneFactory
  *   \ingroup	CloneFactoryGroup
  *   \brief		Creates a copy from a polymorphic object.
@@ -1039,16 +2167,57 @@ template <typename AP, typename Id, typename P1 >
     class CloneFactory
         : public FactoryErrorPolicy<TypeInfo, AbstractProduct>
     {
+        /// What the ordered map stores: the cloner plus the flat-table slot
+        /// assigned to the type at Register time.
+        struct ClonerRecord
+        {
+            ClonerRecord() : creator(), slot(0)
+            {}
+            ClonerRecord(ProductCreator c, unsigned int s)
+                : creator(c), slot(s)
+            {}
+            ProductCreator creator;
+            unsigned int slot;
+        };
+
+        /// One flat-table entry; the TypeInfo guards cached slots, so a
+        /// slot cached from another factory or an unregistered type misses.
+        struct SlotEntry
+        {
+            SlotEntry() : type(), creator()
+            {}
+            TypeInfo type;
+            ProductCreator creator;
+        };
+
     public:
         bool Register(const TypeInfo& ti, ProductCreator creator)
         {
-            return associations_.insert(
-                typename IdToProductMap::value_type(ti, creator)).second != 0;
+            // slots are assigned once per Register and never reused, so a
+            // slot cached inside a long-lived object can only go stale,
+            // never silently point at a different type
+            slots_.push_back(SlotEntry());
+            slots_.back().type = ti;
+            slots_.back().creator = creator;
+            const unsigned int slot =
+                static_cast<unsigned int>(slots_.size());
+            if (associations_.insert(typename IdToProductMap::value_type(
+                ti, ClonerRecord(creator, slot))).second != 0)
+                return true;
+            slots_.pop_back();
+            return false;
         }
 
         bool Unregister(const TypeInfo& id)
         {
-            return associations_.erase(id) != 0;
+            typename IdToProductMap::iterator i = associations_.find(id);
+            if (i == associations_.end())
+                return false;
+            // tombstone the flat entry; objects still caching the slot
+            // fail the type check and fall back to the map
+            slots_[i->second.slot - 1] = SlotEntry();
+            associations_.erase(i);
+            return true;
         }
 
         AbstractProduct* CreateObject(const AbstractProduct* model)
@@ -1057,20 +2226,56 @@ template <typename AP, typename Id, typename P1 >
             {
             	return NULL;
             }
+            return CreateFrom(model, Int2Type<SuperSubclass<CloneSlotted,
+                AbstractProduct>::value ? 1 : 0>());
+        }
+
+    private:
 
-            typename IdToProductMap::iterator i = 
+        // AbstractProduct does not derive from CloneSlotted: the
+        // historical ordered lookup
+        AbstractProduct* CreateFrom(const AbstractProduct* model,
+            Int2Type<0>)
+        {
+            typename IdToProductMap::iterator i =
             	associations_.find(typeid(*model));
-            	
+
             if (i != associations_.end())
             {
-                return (i->second)(model);
+                return (i->second.creator)(model);
             }
             return this->OnUnknownType(typeid(*model));
         }
 
-    private:
-        typedef AssocVector<TypeInfo, ProductCreator> IdToProductMap;
+        // fast path: the object carries the slot of its type's cloner
+        AbstractProduct* CreateFrom(const AbstractProduct* model,
+            Int2Type<1>)
+        {
+            const CloneSlotted* const slotted = model;
+            const unsigned int slot = slotted->cloneSlot_;
+            if (0 != slot && slot <= slots_.size())
+            {
+                const SlotEntry& entry = slots_[slot - 1];
+                if (entry.type == TypeInfo(typeid(*model)))
+                    return (entry.creator)(model);
+            }
+
+            // first clone of this object (or a stale slot): ordered
+            // lookup once, then cache the slot inside the object
+            typename IdToProductMap::iterator i =
+            	associations_.find(typeid(*model));
+
+            if (i != associations_.end())
+            {
+                slotted->cloneSlot_ = i->second.slot;
+                return (i->second.creator)(model);
+            }
+            return this->OnUnknownType(typeid(*model));
+        }
+
+        typedef AssocVector<TypeInfo, ClonerRecord> IdToProductMap;
         IdToProductMap associations_;
+        std::vector<SlotEntry> slots_;
     };
         
 } // namespace Loki
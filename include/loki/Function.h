@@ -81,6 +81,25 @@ namespace Loki
         template<class Host, class Func>
         Function(const Host& host, const Func& func) : FBase(host,func) {}
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+        Function(Function&& func)
+        : FBase(std::move(static_cast<FBase&>(func))) {}
+
+        // Declaring the move operations suppresses the implicit copy
+        // assignment the class otherwise relies on, so spell it out.
+        Function& operator=(const Function& func)
+        {
+            FBase::operator=(func);
+            return *this;
+        }
+
+        Function& operator=(Function&& func)
+        {
+            FBase::operator=(std::move(static_cast<FBase&>(func)));
+            return *this;
+        }
+#endif
+
     };
 
 
@@ -111,7 +130,33 @@ namespace Loki
         Function(Func func) : FBase(func) {}        \
                                                     \
         template<class Host, class Func>            \
-        Function(const Host& host, const Func& func): FBase(host,func) {}
+        Function(const Host& host, const Func& func): FBase(host,func) {} \
+                                                    \
+        LOKI_FUNCTION_MOVE_BODY
+
+// Spliced into LOKI_FUNCTION_BODY because #ifdef cannot appear inside a
+// macro definition.  The explicit copy assignment is needed because
+// declaring the move operations suppresses the implicit one.
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+#define LOKI_FUNCTION_MOVE_BODY                                     \
+                                                                    \
+        Function(Function&& func)                                   \
+        : FBase(std::move(static_cast<FBase&>(func))) {}            \
+                                                                    \
+        Function& operator=(const Function& func)                   \
+        {                                                           \
+            FBase::operator=(func);                                 \
+            return *this;                                           \
+        }                                                           \
+                                                                    \
+        Function& operator=(Function&& func)                        \
+        {                                                           \
+            FBase::operator=(std::move(static_cast<FBase&>(func))); \
+            return *this;                                           \
+        }
+#else
+#define LOKI_FUNCTION_MOVE_BODY
+#endif
 
         
 #define LOKI_FUNCTION_R2_CTOR_BODY          \
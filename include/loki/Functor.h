@@ -23,8 +23,27 @@
 #include "EmptyType.h"
 #include "SmallObj.h"
 #include "TypeTraits.h"
+#include "Allocator.h"
 #include <typeinfo>
 #include <memory>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Loki uses rvalue references when the compiler provides them, so moving a
+//  Functor transfers its impl instead of cloning it.  The same macro guards
+//  the move support in SmartPtr.h and StrongPtr.h.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LOKI_HAS_RVALUE_REFERENCES
+    #if ( defined( __cplusplus ) && ( __cplusplus >= 201103L ) ) \
+        || ( defined( _MSC_VER ) && ( _MSC_VER >= 1600 ) )
+        #define LOKI_HAS_RVALUE_REFERENCES 1
+    #endif
+#endif
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+#include <utility>
+#endif
 
 ///  \defgroup FunctorGroup Function objects
 
@@ -36,6 +55,21 @@
 //#define LOKI_FUNCTORS_ARE_COMPARABLE
 #endif
 
+#ifndef LOKI_FUNCTOR_SMALL_BUFFER
+//#define LOKI_FUNCTOR_SMALL_BUFFER
+#endif
+
+/// Room reserved inside each Functor when LOKI_FUNCTOR_SMALL_BUFFER is
+/// defined.  Four words cover a function pointer or a member function
+/// binding; raise it if your function objects are a little bigger.
+#ifndef LOKI_FUNCTOR_SMALL_BUFFER_SIZE
+#define LOKI_FUNCTOR_SMALL_BUFFER_SIZE ( 4 * sizeof(void *) )
+#endif
+
+#ifndef LOKI_FUNCTOR_FAST_DISPATCH
+//#define LOKI_FUNCTOR_FAST_DISPATCH
+#endif
+
 
 /// \namespace Loki
 /// All classes of Loki are in the Loki namespace
@@ -47,6 +81,13 @@ namespace Loki
 
     namespace Private
     {
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+        /// Type-erased signature under which Functor caches an impl's
+        /// dispatch stub.  It is only ever cast back to the exact stub type
+        /// the impl selected, which encodes the functor's real signature.
+        typedef void (*FunctorDispatch)();
+#endif
+
         template <typename R, template <class, class> class ThreadingModel>
         struct FunctorImplBase 
 #ifdef LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT
@@ -85,6 +126,33 @@ namespace Loki
 
             virtual FunctorImplBase* DoClone() const = 0;
 
+            /** Copy-constructs this impl into the given buffer when it
+             fits, returning the copy, or returns 0 to make the caller
+             clone onto the heap instead.  Both the small-buffer Functor
+             storage and BinderFirst's inline target storage rely on this.
+             The default lets custom impls keep working; anything declared
+             with LOKI_DEFINE_CLONE_FUNCTORIMPL overrides it.
+             */
+            virtual FunctorImplBase* DoPlacementClone( void *,
+                std::size_t ) const
+            {
+                return 0;
+            }
+
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            /** Returns a static stub that invokes this impl without going
+             through the virtual operator(), or 0 to make Functor dispatch
+             virtually as always.  The default keeps custom impls working;
+             anything declared with LOKI_DEFINE_DISPATCH_FUNCTORIMPL
+             overrides it.  Functor caches the result whenever its impl
+             changes, so this is only ever called on the cold path.
+             */
+            virtual FunctorDispatch GetDispatch() const
+            {
+                return 0;
+            }
+#endif
+
             template <class U>
             static U* Clone(U* pObj)
             {
@@ -110,7 +178,291 @@ namespace Loki
 ////////////////////////////////////////////////////////////////////////////////
 
 #define LOKI_DEFINE_CLONE_FUNCTORIMPL(Cls) \
-    virtual Cls* DoClone() const { return new Cls(*this); }
+    virtual Cls* DoClone() const { return new Cls(*this); } \
+    virtual Cls* DoPlacementClone(void* buffer, std::size_t avail) const \
+    { return sizeof(Cls) <= avail ? ::new (buffer) Cls(*this) : 0; }
+
+////////////////////////////////////////////////////////////////////////////////
+// macro LOKI_DEFINE_DISPATCH_FUNCTORIMPL
+// Gives a functor implementation a non-virtual dispatch stub: a static
+// function holding the impl's call logic, handed to the owning Functor
+// through GetDispatch and cached there.  Invocation then costs one
+// indirect call through the cached stub instead of a vtable load plus a
+// virtual call.  Only available when LOKI_FUNCTOR_FAST_DISPATCH is
+// defined; otherwise the macro expands to nothing and dispatch stays
+// virtual.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+
+    namespace Private
+    {
+        // Counts the parameters a Functor really takes.  Unused Parm
+        // typedefs are exactly EmptyType; a genuine EmptyType parameter
+        // arrives as TypeTraits' ParameterType (a const reference), so the
+        // two cannot be confused.
+        template < class T > struct FunctorParmUsed
+        {
+            enum { value = 1 };
+        };
+
+        template <> struct FunctorParmUsed< EmptyType >
+        {
+            enum { value = 0 };
+        };
+
+        template < class F > struct FunctorArity
+        {
+            enum { value =
+                  FunctorParmUsed< typename F::Parm1 >::value
+                + FunctorParmUsed< typename F::Parm2 >::value
+                + FunctorParmUsed< typename F::Parm3 >::value
+                + FunctorParmUsed< typename F::Parm4 >::value
+                + FunctorParmUsed< typename F::Parm5 >::value
+                + FunctorParmUsed< typename F::Parm6 >::value
+                + FunctorParmUsed< typename F::Parm7 >::value
+                + FunctorParmUsed< typename F::Parm8 >::value
+                + FunctorParmUsed< typename F::Parm9 >::value
+                + FunctorParmUsed< typename F::Parm10 >::value
+                + FunctorParmUsed< typename F::Parm11 >::value
+                + FunctorParmUsed< typename F::Parm12 >::value
+                + FunctorParmUsed< typename F::Parm13 >::value
+                + FunctorParmUsed< typename F::Parm14 >::value
+                + FunctorParmUsed< typename F::Parm15 >::value };
+        };
+
+        // The exact stub signature for a functor F of the given arity.
+        // Both the impl selecting its Dispatch overload and the Functor
+        // head casting the cached stub back agree on this type, so the
+        // call is always made through the pointer's true type.
+        template < class F, int N > struct FunctorDispatchType;
+
+        template < class F > struct FunctorDispatchType< F, 0 >
+        {
+            typedef typename F::ResultType ( * Type )( void * );
+        };
+        template < class F > struct FunctorDispatchType< F, 1 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1 );
+        };
+        template < class F > struct FunctorDispatchType< F, 2 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2 );
+        };
+        template < class F > struct FunctorDispatchType< F, 3 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3 );
+        };
+        template < class F > struct FunctorDispatchType< F, 4 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4 );
+        };
+        template < class F > struct FunctorDispatchType< F, 5 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5 );
+        };
+        template < class F > struct FunctorDispatchType< F, 6 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6 );
+        };
+        template < class F > struct FunctorDispatchType< F, 7 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7 );
+        };
+        template < class F > struct FunctorDispatchType< F, 8 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8 );
+        };
+        template < class F > struct FunctorDispatchType< F, 9 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9 );
+        };
+        template < class F > struct FunctorDispatchType< F, 10 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10 );
+        };
+        template < class F > struct FunctorDispatchType< F, 11 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10, typename F::Parm11 );
+        };
+        template < class F > struct FunctorDispatchType< F, 12 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10, typename F::Parm11,
+                typename F::Parm12 );
+        };
+        template < class F > struct FunctorDispatchType< F, 13 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10, typename F::Parm11,
+                typename F::Parm12, typename F::Parm13 );
+        };
+        template < class F > struct FunctorDispatchType< F, 14 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10, typename F::Parm11,
+                typename F::Parm12, typename F::Parm13,
+                typename F::Parm14 );
+        };
+        template < class F > struct FunctorDispatchType< F, 15 >
+        {
+            typedef typename F::ResultType ( * Type )( void *,
+                typename F::Parm1, typename F::Parm2, typename F::Parm3,
+                typename F::Parm4, typename F::Parm5, typename F::Parm6,
+                typename F::Parm7, typename F::Parm8, typename F::Parm9,
+                typename F::Parm10, typename F::Parm11,
+                typename F::Parm12, typename F::Parm13,
+                typename F::Parm14, typename F::Parm15 );
+        };
+    }
+
+#define LOKI_DEFINE_DISPATCH_FUNCTORIMPL(Cls, Parent) \
+    static Cls * DispatchSelf(void * p) \
+    { \
+        return static_cast< Cls * >( \
+            static_cast< typename Parent::Impl * >( p ) ); \
+    } \
+    static ResultType Dispatch(void * p) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10, Parm11 p11) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10, p11); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10, Parm11 p11, Parm12 p12) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10, p11, p12); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10, p11, p12, p13); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10, p11, p12, p13, p14); \
+    } \
+    static ResultType Dispatch(void * p, Parm1 p1, Parm2 p2, Parm3 p3, \
+        Parm4 p4, Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, \
+        Parm10 p10, Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, \
+        Parm15 p15) \
+    { \
+        return DispatchSelf(p)->Cls::operator()(p1, p2, p3, p4, p5, p6, \
+            p7, p8, p9, p10, p11, p12, p13, p14, p15); \
+    } \
+    virtual ::Loki::Private::FunctorDispatch GetDispatch() const \
+    { \
+        typedef typename ::Loki::Private::FunctorDispatchType< Parent, \
+            ::Loki::Private::FunctorArity< Parent >::value >::Type \
+            DispatchType; \
+        return reinterpret_cast< ::Loki::Private::FunctorDispatch >( \
+            static_cast< DispatchType >( &Cls::Dispatch ) ); \
+    }
+
+#else
+
+#define LOKI_DEFINE_DISPATCH_FUNCTORIMPL(Cls, Parent)
+
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // class template FunctorImpl
@@ -527,6 +879,13 @@ namespace Loki
 
 #ifndef LOKI_DISABLE_TYPELIST_MACROS
 
+// The typelist specializations derive from their Seq counterparts (same
+// signature, same Parm typedefs) rather than from FunctorImplBase
+// directly.  An impl written against the LOKI_TYPELIST_n spelling is
+// thereby usable wherever the Seq spelling - and thus Function - expects
+// one, so converting between the two Functor forms can adopt the impl
+// instead of wrapping it; see the flattening constructor in Functor.
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template FunctorImpl
 // Specialization for 1 parameter
@@ -534,7 +893,7 @@ namespace Loki
 
     template <typename R, typename P1, template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_1(P1), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -550,7 +909,7 @@ namespace Loki
     template <typename R, typename P1, typename P2, 
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_2(P1, P2), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -567,7 +926,7 @@ namespace Loki
     template <typename R, typename P1, typename P2, typename P3,
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_3(P1, P2, P3), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -585,7 +944,7 @@ namespace Loki
     template <typename R, typename P1, typename P2, typename P3, typename P4,
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_4(P1, P2, P3, P4), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -605,7 +964,7 @@ namespace Loki
         typename P5,
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_5(P1, P2, P3, P4, P5), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -626,7 +985,7 @@ namespace Loki
         typename P5, typename P6,
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_6(P1, P2, P3, P4, P5, P6), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -648,7 +1007,7 @@ namespace Loki
         typename P5, typename P6, typename P7,
         template <class, class> class ThreadingModel>
     class FunctorImpl<R, LOKI_TYPELIST_7(P1, P2, P3, P4, P5, P6, P7), ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -671,9 +1030,8 @@ namespace Loki
     template <typename R, typename P1, typename P2, typename P3, typename P4,
         typename P5, typename P6, typename P7, typename P8,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R, LOKI_TYPELIST_8(P1, P2, P3, P4, P5, P6, P7, P8),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_8(P1, P2, P3, P4, P5, P6, P7, P8), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -697,9 +1055,8 @@ namespace Loki
     template <typename R, typename P1, typename P2, typename P3, typename P4,
         typename P5, typename P6, typename P7, typename P8, typename P9,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R, LOKI_TYPELIST_9(P1, P2, P3, P4, P5, P6, P7, P8, P9),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_9(P1, P2, P3, P4, P5, P6, P7, P8, P9), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -725,9 +1082,8 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R, LOKI_TYPELIST_10(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_10(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -754,10 +1110,8 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10, typename P11,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R,
-            LOKI_TYPELIST_11(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_11(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -785,10 +1139,8 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10, typename P11, typename P12,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R,
-            LOKI_TYPELIST_12(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_12(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -817,10 +1169,8 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10, typename P11, typename P12, typename P13,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R,
-            LOKI_TYPELIST_13(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_13(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -850,11 +1200,9 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10, typename P11, typename P12, typename P13, typename P14,
         template <class, class> class ThreadingModel>
-    class FunctorImpl<R,
-            LOKI_TYPELIST_14(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13,
-                P14),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_14(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13,
+                P14), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13, P14>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -885,11 +1233,9 @@ namespace Loki
         typename P5, typename P6, typename P7, typename P8, typename P9,
         typename P10, typename P11, typename P12, typename P13, typename P14,
         typename P15, template <class, class> class ThreadingModel>
-    class FunctorImpl<R,
-            LOKI_TYPELIST_15(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13,
-                P14, P15),
-            ThreadingModel>
-        : public Private::FunctorImplBase<R, ThreadingModel>
+    class FunctorImpl<R, LOKI_TYPELIST_15(P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13,
+                P14, P15), ThreadingModel>
+        : public FunctorImpl<R, Seq<P1, P2, P3, P4, P5, P6, P7, P8, P9, P10, P11, P12, P13, P14, P15>, ThreadingModel>
     {
     public:
         typedef R ResultType;
@@ -947,6 +1293,7 @@ namespace Loki
         FunctorHandler(const Fun& fun) : f_(fun) {}
         
         LOKI_DEFINE_CLONE_FUNCTORIMPL(FunctorHandler)
+        LOKI_DEFINE_DISPATCH_FUNCTORIMPL(FunctorHandler, ParentFunctor)
 
 
 #ifdef LOKI_FUNCTORS_ARE_COMPARABLE
@@ -1073,6 +1420,7 @@ namespace Loki
         {}
         
         LOKI_DEFINE_CLONE_FUNCTORIMPL(MemFunHandler)
+        LOKI_DEFINE_DISPATCH_FUNCTORIMPL(MemFunHandler, ParentFunctor)
 
 
 #ifdef LOKI_FUNCTORS_ARE_COMPARABLE
@@ -1213,6 +1561,31 @@ namespace Loki
 /// The macro is disabled by default, because it breaks compiling functor 
 /// objects  which have no operator== implemented, keep in mind when you enable
 /// operator==.
+///
+/// \par Macro: LOKI_FUNCTOR_SMALL_BUFFER
+/// Define
+/// \code LOKI_FUNCTOR_SMALL_BUFFER \endcode
+/// to store small impls - a bound function pointer, a member function
+/// binding - inside the Functor object itself instead of on the heap.
+/// Constructing and copying such Functors then allocates nothing, and
+/// invoking one chases no pointer to another cache line, which matters
+/// when callbacks are stored by the million in event tables.  Impls
+/// larger than LOKI_FUNCTOR_SMALL_BUFFER_SIZE still live on the heap, as
+/// do custom impls that do not use LOKI_DEFINE_CLONE_FUNCTORIMPL.  In
+/// this mode assignment offers the basic exception guarantee rather than
+/// the strong one: if cloning the right-hand side throws, the target is
+/// left empty instead of unchanged.
+///
+/// \par Macro: LOKI_FUNCTOR_FAST_DISPATCH
+/// Define
+/// \code LOKI_FUNCTOR_FAST_DISPATCH \endcode
+/// to cache a non-virtual dispatch stub in the Functor itself, queried
+/// from the impl once whenever the impl changes.  Invoking the Functor
+/// then makes a single indirect call through the cached stub with no
+/// vtable dereference, which is what counts when one dispatch sits on
+/// the critical path of millions of events per second.  The Functor
+/// grows by one pointer, and custom impls that do not use
+/// LOKI_DEFINE_DISPATCH_FUNCTORIMPL simply keep dispatching virtually.
 ////////////////////////////////////////////////////////////////////////////////
     template <typename R = void, class TList = NullType,
         template<class, class> class ThreadingModel = LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL>
@@ -1241,24 +1614,205 @@ namespace Loki
 
         // Member functions
 
+#ifdef LOKI_FUNCTOR_SMALL_BUFFER
+
         Functor() : spImpl_(0)
-        {}
-        
+        {
+            UpdateDispatch();
+        }
+
+        Functor(const Functor& rhs) : spImpl_(0)
+        {
+            CopyImpl(rhs);
+            UpdateDispatch();
+        }
+
+        Functor(std::auto_ptr<Impl> spImpl) : spImpl_(spImpl.release())
+        {
+            UpdateDispatch();
+        }
+
+        template <typename Fun>
+        Functor(Fun fun)
+        : spImpl_(0)
+        {
+            typedef FunctorHandler<Functor, Fun> Handler;
+            if (sizeof(Handler) <= sizeof(buffer_))
+                spImpl_ = ::new (static_cast<void*>(buffer_)) Handler(fun);
+            else
+                spImpl_ = new Handler(fun);
+            UpdateDispatch();
+        }
+
+        /// Flattening constructor.  When the source functor's impl class
+        /// derives from this functor's Impl - the LOKI_TYPELIST_n and Seq
+        /// spellings of one signature are related that way - the inner
+        /// impl is cloned and adopted directly instead of being buried
+        /// under another FunctorHandler, which would cost a second impl
+        /// object and a second indirect call on every invocation.
+        /// Functors of unrelated signatures still take the wrapping path.
+        template <typename R2, class TList2>
+        Functor(const Functor<R2, TList2, ThreadingModel>& rhs)
+        : spImpl_(0)
+        {
+            typedef typename
+                Functor<R2, TList2, ThreadingModel>::Impl RhsImpl;
+            AdoptOrWrap(rhs,
+                Int2Type<SuperSubclass<Impl, RhsImpl>::value>());
+            UpdateDispatch();
+        }
+
+        template <class PtrObj, typename MemFn>
+        Functor(const PtrObj& p, MemFn memFn)
+        : spImpl_(0)
+        {
+            typedef MemFunHandler<Functor, PtrObj, MemFn> Handler;
+            if (sizeof(Handler) <= sizeof(buffer_))
+                spImpl_ = ::new (static_cast<void*>(buffer_)) Handler(p, memFn);
+            else
+                spImpl_ = new Handler(p, memFn);
+            UpdateDispatch();
+        }
+
+        ~Functor()
+        {
+            DestroyImpl();
+        }
+
+        typedef Impl * Functor::* unspecified_bool_type;
+
+        operator unspecified_bool_type() const
+        {
+            return spImpl_ ? &Functor::spImpl_ : 0;
+        }
+
+        /// Peek at the polymorphic implementation without transferring
+        /// ownership.  Chain uses this to flatten chained functors into
+        /// one sequence.
+        Impl * GetImpl() const
+        {
+            return spImpl_;
+        }
+
+        Functor& operator=(const Functor& rhs)
+        {
+            if (this != &rhs)
+            {
+                // A buffered impl cannot change owners, so there is no
+                // temporary to swap with; on a throwing clone this is
+                // left empty rather than unchanged.
+                DestroyImpl();
+                spImpl_ = 0;
+                CopyImpl(rhs);
+            }
+            UpdateDispatch();
+            return *this;
+        }
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+        Functor(Functor&& rhs) : spImpl_(0)
+        {
+            MoveImpl(rhs);
+            UpdateDispatch();
+            rhs.UpdateDispatch();
+        }
+
+        Functor& operator=(Functor&& rhs)
+        {
+            if (this != &rhs)
+            {
+                DestroyImpl();
+                spImpl_ = 0;
+                MoveImpl(rhs);
+            }
+            UpdateDispatch();
+            rhs.UpdateDispatch();
+            return *this;
+        }
+#endif
+
+#ifdef LOKI_ENABLE_FUNCTION
+
+        bool empty() const
+        {
+            return spImpl_ == 0;
+        }
+
+        void clear()
+        {
+            DestroyImpl();
+            spImpl_ = 0;
+            UpdateDispatch();
+        }
+#endif
+
+#ifdef LOKI_FUNCTORS_ARE_COMPARABLE
+
+        bool operator==(const Functor& rhs) const
+        {
+            if(spImpl_==0 && rhs.spImpl_==0)
+                return true;
+            if(spImpl_!=0 && rhs.spImpl_!=0)
+                return *spImpl_ == *rhs.spImpl_;
+            else
+                return false;
+        }
+
+        bool operator!=(const Functor& rhs) const
+        {
+            return !(*this==rhs);
+        }
+#endif
+
+#else // LOKI_FUNCTOR_SMALL_BUFFER
+
+        Functor() : spImpl_(0)
+        {
+            UpdateDispatch();
+        }
+
         Functor(const Functor& rhs) : spImpl_(Impl::Clone(rhs.spImpl_.get()))
-        {}
-        
+        {
+            UpdateDispatch();
+        }
+
         Functor(std::auto_ptr<Impl> spImpl) : spImpl_(spImpl)
-        {}
-        
+        {
+            UpdateDispatch();
+        }
+
         template <typename Fun>
         Functor(Fun fun)
         : spImpl_(new FunctorHandler<Functor, Fun>(fun))
-        {}
+        {
+            UpdateDispatch();
+        }
+
+        /// Flattening constructor.  When the source functor's impl class
+        /// derives from this functor's Impl - the LOKI_TYPELIST_n and Seq
+        /// spellings of one signature are related that way - the inner
+        /// impl is cloned and adopted directly instead of being buried
+        /// under another FunctorHandler, which would cost a second heap
+        /// object and a second indirect call on every invocation.
+        /// Functors of unrelated signatures still take the wrapping path.
+        template <typename R2, class TList2>
+        Functor(const Functor<R2, TList2, ThreadingModel>& rhs)
+        : spImpl_(0)
+        {
+            typedef typename
+                Functor<R2, TList2, ThreadingModel>::Impl RhsImpl;
+            AdoptOrWrap(rhs,
+                Int2Type<SuperSubclass<Impl, RhsImpl>::value>());
+            UpdateDispatch();
+        }
 
         template <class PtrObj, typename MemFn>
         Functor(const PtrObj& p, MemFn memFn)
         : spImpl_(new MemFunHandler<Functor, PtrObj, MemFn>(p, memFn))
-        {}
+        {
+            UpdateDispatch();
+        }
 
         typedef Impl * (std::auto_ptr<Impl>::*unspecified_bool_type)() const;
 
@@ -1267,6 +1821,14 @@ namespace Loki
             return spImpl_.get() ? &std::auto_ptr<Impl>::get : 0;
         }
 
+        /// Peek at the polymorphic implementation without transferring
+        /// ownership.  Chain uses this to flatten chained functors into
+        /// one sequence.
+        Impl * GetImpl() const
+        {
+            return spImpl_.get();
+        }
+
         Functor& operator=(const Functor& rhs)
         {
             Functor copy(rhs);
@@ -1274,9 +1836,27 @@ namespace Loki
             Impl* p = spImpl_.release();
             spImpl_.reset(copy.spImpl_.release());
             copy.spImpl_.reset(p);
+            UpdateDispatch();
             return *this;
         }
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+        Functor(Functor&& rhs) : spImpl_(rhs.spImpl_)
+        {
+            UpdateDispatch();
+            rhs.UpdateDispatch();
+        }
+
+        Functor& operator=(Functor&& rhs)
+        {
+            spImpl_.reset(rhs.spImpl_.release());
+            UpdateDispatch();
+            rhs.UpdateDispatch();
+            return *this;
+        }
+#endif
+
 #ifdef LOKI_ENABLE_FUNCTION
 
         bool empty() const
@@ -1287,6 +1867,7 @@ namespace Loki
         void clear()
         {
             spImpl_.reset(0);
+            UpdateDispatch();
         }
 #endif
 
@@ -1308,84 +1889,191 @@ namespace Loki
         }
 #endif
 
+#endif // LOKI_FUNCTOR_SMALL_BUFFER
+
         // operator() implementations for up to 15 arguments
 
         ResultType operator()() const
         {
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget());
+            }
+#endif
+            return (*spImpl_)();
         }
 
         ResultType operator()(Parm1 p1) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1);
+            }
+#endif
+            return (*spImpl_)(p1);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2) const
         {    
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2);
+            }
+#endif
+            return (*spImpl_)(p1, p2);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3) const
         {    
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11) const
         { 
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
-            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11); 
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10,
+                    Parm11);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);
+            }
+#endif
+            return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);
         }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
@@ -1393,6 +2081,16 @@ namespace Loki
             Parm12 p12) const
         {
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10,
+                    Parm11, Parm12);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);
+            }
+#endif
             return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, 
                 p12);
         }
@@ -1402,6 +2100,16 @@ namespace Loki
             Parm12 p12, Parm13 p13) const
         {
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10,
+                    Parm11, Parm12, Parm13);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);
+            }
+#endif
             return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11,
             p12, p13);
         }
@@ -1411,6 +2119,17 @@ namespace Loki
             Parm12 p12, Parm13 p13, Parm14 p14) const
         {
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10,
+                    Parm11, Parm12, Parm13, Parm14);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13,
+                    p14);
+            }
+#endif
             return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, 
                 p12, p13, p14);
         }
@@ -1420,12 +2139,166 @@ namespace Loki
             Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15) const
         {
             LOKI_FUNCTION_THROW_BAD_FUNCTION_CALL
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            if (dispatch_ != 0)
+            {
+                typedef ResultType (*DispatchType)(void*, Parm1, Parm2,
+                    Parm3, Parm4, Parm5, Parm6, Parm7, Parm8, Parm9, Parm10,
+                    Parm11, Parm12, Parm13, Parm14, Parm15);
+                return reinterpret_cast<DispatchType>(dispatch_)(DispatchTarget(),
+                    p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13,
+                    p14, p15);
+            }
+#endif
             return (*spImpl_)(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, 
                 p12, p13, p14, p15);
         }
 
     private:
+
+#ifdef LOKI_FUNCTOR_SMALL_BUFFER
+
+        bool IsBuffered() const
+        {
+            const char * const p = reinterpret_cast<const char*>(spImpl_);
+            return buffer_ <= p && p < buffer_ + sizeof(buffer_);
+        }
+
+        void CopyImpl(const Functor& rhs)
+        {
+            if (rhs.spImpl_ == 0)
+                return;
+            if (rhs.IsBuffered())
+            {
+                spImpl_ = static_cast<Impl*>(rhs.spImpl_->DoPlacementClone(
+                    static_cast<void*>(buffer_), sizeof(buffer_)));
+                if (spImpl_ != 0)
+                    return;
+                // A custom impl without placement support clones onto the
+                // heap instead.
+            }
+            spImpl_ = Impl::Clone(rhs.spImpl_);
+        }
+
+        // Flattening support for the converting constructor: adopt a
+        // clone of a compatible functor's impl, or wrap an incompatible
+        // functor just as the generic constructor would.
+        template <class F2>
+        void AdoptOrWrap(const F2& rhs, Int2Type<1>)
+        {
+            if (rhs.GetImpl() == 0)
+                return;
+            spImpl_ = static_cast<Impl*>(rhs.GetImpl()->DoPlacementClone(
+                static_cast<void*>(buffer_), sizeof(buffer_)));
+            if (spImpl_ == 0)
+                spImpl_ = Impl::Clone(rhs.GetImpl());
+        }
+
+        template <class F2>
+        void AdoptOrWrap(const F2& rhs, Int2Type<0>)
+        {
+            typedef FunctorHandler<Functor, F2> Handler;
+            if (sizeof(Handler) <= sizeof(buffer_))
+                spImpl_ = ::new (static_cast<void*>(buffer_)) Handler(rhs);
+            else
+                spImpl_ = new Handler(rhs);
+        }
+
+        void DestroyImpl()
+        {
+            if (spImpl_ == 0)
+                return;
+            if (IsBuffered())
+                spImpl_->~Impl();
+            else
+                delete spImpl_;
+        }
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+        void MoveImpl(Functor& rhs)
+        {
+            if (rhs.spImpl_ == 0)
+                return;
+            if (rhs.IsBuffered())
+            {
+                // An impl living in rhs's buffer cannot change owners, so
+                // clone it, then empty rhs to keep the moved-from state
+                // uniform.
+                CopyImpl(rhs);
+                rhs.DestroyImpl();
+                rhs.spImpl_ = 0;
+            }
+            else
+            {
+                spImpl_ = rhs.spImpl_;
+                rhs.spImpl_ = 0;
+            }
+        }
+#endif
+
+        void UpdateDispatch()
+        {
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            dispatch_ = (spImpl_ == 0) ? 0 : spImpl_->GetDispatch();
+#endif
+        }
+
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+        void * DispatchTarget() const
+        {
+            return spImpl_;
+        }
+#endif
+
+        union
+        {
+            char buffer_[LOKI_FUNCTOR_SMALL_BUFFER_SIZE];
+            double forAlignment1_;
+            void (*forAlignment2_)();
+        };
+        Impl* spImpl_;
+
+#else
+
+        void UpdateDispatch()
+        {
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+            dispatch_ = (spImpl_.get() == 0) ? 0 : spImpl_->GetDispatch();
+#endif
+        }
+
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+        void * DispatchTarget() const
+        {
+            return spImpl_.get();
+        }
+#endif
+
+        // Flattening support for the converting constructor: adopt a
+        // clone of a compatible functor's impl, or wrap an incompatible
+        // functor just as the generic constructor would.
+        template <class F2>
+        void AdoptOrWrap(const F2& rhs, Int2Type<1>)
+        {
+            if (rhs.GetImpl() != 0)
+                spImpl_.reset(Impl::Clone(rhs.GetImpl()));
+        }
+
+        template <class F2>
+        void AdoptOrWrap(const F2& rhs, Int2Type<0>)
+        {
+            spImpl_.reset(new FunctorHandler<Functor, F2>(rhs));
+        }
+
         std::auto_ptr<Impl> spImpl_;
+
+#endif // LOKI_FUNCTOR_SMALL_BUFFER
+
+#ifdef LOKI_FUNCTOR_FAST_DISPATCH
+        Private::FunctorDispatch dispatch_;
+#endif
+
     };
     
 
@@ -1480,7 +2353,12 @@ namespace Loki
 ///  \class BinderFirst
 ///  
 ///  \ingroup FunctorGroup
-///  Binds the first parameter of a Functor object to a specific value
+///  Binds the first parameter of a Functor object to a specific value.
+///  The bound value and the target are fused into this one impl: the
+///  target's impl is placement-cloned into an inline buffer (with a heap
+///  fallback for oversized targets), so binding costs a single
+///  allocation and invocation calls the target impl directly instead of
+///  hopping through another Functor head.
 ////////////////////////////////////////////////////////////////////////////////
 
     template <class OriginalFunctor>
@@ -1514,13 +2392,43 @@ namespace Loki
         typedef typename OriginalFunctor::Parm15 Parm14;
         typedef EmptyType Parm15;
 
+        typedef typename Private::BinderFirstTraits<OriginalFunctor>
+                ::BoundFunctorType ParentFunctorType;
+
+        typedef typename OriginalFunctor::Impl TargetImpl;
+
     public:
         
         BinderFirst(const OriginalFunctor& fun, BoundType bound)
-        : f_(fun), b_(bound)
-        {}
+        : pTarget_(0), b_(bound)
+        {
+            CopyTarget(fun.GetImpl());
+        }
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+        // The target is cloned rather than stolen: a Functor does not
+        // give up its impl, and the clone usually lands in the inline
+        // buffer anyway.
+        BinderFirst(OriginalFunctor&& fun, BoundType bound)
+        : pTarget_(0), b_(bound)
+        {
+            CopyTarget(fun.GetImpl());
+        }
+#endif
+
+        BinderFirst(const BinderFirst& rhs)
+        : Base(rhs), pTarget_(0), b_(rhs.b_)
+        {
+            CopyTarget(rhs.pTarget_);
+        }
+
+        ~BinderFirst()
+        {
+            DestroyTarget();
+        }
 
         LOKI_DEFINE_CLONE_FUNCTORIMPL(BinderFirst)
+        LOKI_DEFINE_DISPATCH_FUNCTORIMPL(BinderFirst, ParentFunctorType)
 
 #ifdef LOKI_FUNCTORS_ARE_COMPARABLE
         
@@ -1528,77 +2436,116 @@ namespace Loki
         {
             if(typeid(*this) != typeid(rhs))
                 return false; // cannot be equal 
+            const BinderFirst& bf = static_cast<const BinderFirst&>(rhs);
+            if(pTarget_ == 0 || bf.pTarget_ == 0)
+                return pTarget_ == bf.pTarget_ && b_ == bf.b_;
             // if this line gives a compiler error, you are using a function object.
             // you need to implement bool MyFnObj::operator == (const MyFnObj&) const;
-            return    f_ == ((static_cast<const BinderFirst&> (rhs)).f_) &&
-                      b_ == ((static_cast<const BinderFirst&> (rhs)).b_);
+            return    *pTarget_ == *bf.pTarget_ &&
+                      b_ == bf.b_;
         }
 #endif
 
         // operator() implementations for up to 15 arguments
                 
         ResultType operator()()
-        { return f_(b_); }
+        { return (*pTarget_)(b_); }
 
         ResultType operator()(Parm1 p1)
-        { return f_(b_, p1); }
+        { return (*pTarget_)(b_, p1); }
         
         ResultType operator()(Parm1 p1, Parm2 p2)
-        { return f_(b_, p1, p2); }
+        { return (*pTarget_)(b_, p1, p2); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3)
-        { return f_(b_, p1, p2, p3); }
+        { return (*pTarget_)(b_, p1, p2, p3); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
-        { return f_(b_, p1, p2, p3, p4); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
-        { return f_(b_, p1, p2, p3, p4, p5); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6)
-        { return f_(b_, p1, p2, p3, p4, p5, p6); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11,
             Parm12 p12)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11,
             Parm12 p12, Parm13 p13)
-        { return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13); }
+        { return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13); }
         
         ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
             Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10, Parm11 p11,
             Parm12 p12, Parm13 p13, Parm14 p14)
         {
-            return f_(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, 
+            return (*pTarget_)(b_, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, 
                 p14);
         }
         
     private:
-        OriginalFunctor f_;
+
+        // Impls are cloned, never assigned.
+        BinderFirst& operator=(const BinderFirst&);
+
+        bool TargetBuffered() const
+        {
+            const char * const p = reinterpret_cast<const char*>(pTarget_);
+            return buffer_ <= p && p < buffer_ + sizeof(buffer_);
+        }
+
+        void CopyTarget(TargetImpl* src)
+        {
+            if (src == 0)
+                return;
+            pTarget_ = static_cast<TargetImpl*>(src->DoPlacementClone(
+                static_cast<void*>(buffer_), sizeof(buffer_)));
+            if (pTarget_ == 0)
+                pTarget_ = TargetImpl::Clone(src);
+        }
+
+        void DestroyTarget()
+        {
+            if (pTarget_ == 0)
+                return;
+            if (TargetBuffered())
+                pTarget_->~TargetImpl();
+            else
+                delete pTarget_;
+        }
+
+        union
+        {
+            char buffer_[LOKI_FUNCTOR_SMALL_BUFFER_SIZE];
+            double forAlignment1_;
+            void (*forAlignment2_)();
+        };
+        TargetImpl* pTarget_;
         BoundTypeStorage b_;
     };
     
@@ -1620,11 +2567,30 @@ namespace Loki
             new BinderFirst<Fctor>(fun, bound)));
     }
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+    template <typename R, class TList, template <class, class> class ThreadingModel>
+    typename Private::BinderFirstTraits< Functor<R, TList, ThreadingModel> >::BoundFunctorType
+    BindFirst(
+        Functor<R, TList, ThreadingModel>&& fun,
+        typename Functor<R, TList, ThreadingModel>::Parm1 bound)
+    {
+        typedef Functor<R, TList, ThreadingModel> Fctor;
+        typedef typename Private::BinderFirstTraits<Fctor>::BoundFunctorType
+            Outgoing;
+
+        return Outgoing(std::auto_ptr<typename Outgoing::Impl>(
+            new BinderFirst<Fctor>(std::move(fun), bound)));
+    }
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class Chainer
 ///
 ///  \ingroup FunctorGroup
-///   Chains two functor calls one after another
+///   Chains two functor calls one after another.  Chain itself now
+///   builds the flat ChainSequence below; Chainer remains for code that
+///   instantiates it directly.
 ////////////////////////////////////////////////////////////////////////////////
 
     template <typename Fun1, typename Fun2>
@@ -1652,7 +2618,13 @@ namespace Loki
         
         Chainer(const Fun1& fun1, const Fun2& fun2) : f1_(fun1), f2_(fun2) {}
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+        Chainer(Fun1&& fun1, Fun2&& fun2)
+        : f1_(std::move(fun1)), f2_(std::move(fun2)) {}
+#endif
+
         LOKI_DEFINE_CLONE_FUNCTORIMPL(Chainer)
+        LOKI_DEFINE_DISPATCH_FUNCTORIMPL(Chainer, Fun2)
 
 #ifdef LOKI_FUNCTORS_ARE_COMPARABLE
                 
@@ -1767,9 +2739,274 @@ namespace Loki
         Fun2 f2_;
     };
     
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class ChainSequence
+///
+///  \ingroup FunctorGroup
+///   The flat form Chain builds: a contiguous sequence of functors
+///   invoked in order.  Chaining onto an already chained functor appends
+///   to its sequence instead of nesting, so a chain of N callbacks is a
+///   single impl holding N functors side by side and invoking them in a
+///   linear scan, not a tree of N-1 heap nodes walked by pointer
+///   chasing.  The sequence storage comes from the small-object
+///   allocator unless LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT is defined.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <typename Fun>
+    class ChainSequence : public Fun::Impl
+    {
+        typedef Fun Base;
+
+#ifdef LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT
+        typedef std::vector<Fun> Sequence;
+#else
+        typedef std::vector<Fun, LokiAllocator<Fun> > Sequence;
+#endif
+
+    public:
+        typedef typename Base::ResultType ResultType;
+        typedef typename Base::Parm1 Parm1;
+        typedef typename Base::Parm2 Parm2;
+        typedef typename Base::Parm3 Parm3;
+        typedef typename Base::Parm4 Parm4;
+        typedef typename Base::Parm5 Parm5;
+        typedef typename Base::Parm6 Parm6;
+        typedef typename Base::Parm7 Parm7;
+        typedef typename Base::Parm8 Parm8;
+        typedef typename Base::Parm9 Parm9;
+        typedef typename Base::Parm10 Parm10;
+        typedef typename Base::Parm11 Parm11;
+        typedef typename Base::Parm12 Parm12;
+        typedef typename Base::Parm13 Parm13;
+        typedef typename Base::Parm14 Parm14;
+        typedef typename Base::Parm15 Parm15;
+
+        template <class Fun1>
+        ChainSequence(const Fun1& fun1, const Fun& fun2)
+        {
+            Append(fun1);
+            Append(fun2);
+        }
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+        ChainSequence(Fun&& fun1, Fun&& fun2)
+        {
+            Append(std::move(fun1));
+            Append(std::move(fun2));
+        }
+#endif
+
+        LOKI_DEFINE_CLONE_FUNCTORIMPL(ChainSequence)
+        LOKI_DEFINE_DISPATCH_FUNCTORIMPL(ChainSequence, Fun)
+
+#ifdef LOKI_FUNCTORS_ARE_COMPARABLE
+
+        bool operator==(const typename Base::Impl::FunctorImplBaseType& rhs) const
+        {
+            if(typeid(*this) != typeid(rhs))
+                return false; // cannot be equal
+            const ChainSequence& cs = static_cast<const ChainSequence&>(rhs);
+            if(funs_.size() != cs.funs_.size())
+                return false;
+            for (std::size_t i = 0; i != funs_.size(); ++i)
+                if (!(funs_[i] == cs.funs_[i]))
+                    return false;
+            return true;
+        }
+#endif
+
+        // operator() implementations for up to 15 arguments
+
+        ResultType operator()()
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i]();
+            return funs_[last]();
+        }
+        
+        ResultType operator()(Parm1 p1)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1);
+            return funs_[last](p1);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2);
+            return funs_[last](p1, p2);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3);
+            return funs_[last](p1, p2, p3);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4);
+            return funs_[last](p1, p2, p3, p4);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5);
+            return funs_[last](p1, p2, p3, p4, p5);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6);
+            return funs_[last](p1, p2, p3, p4, p5, p6);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+            Parm11 p11)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+            Parm11 p11, Parm12 p12)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11,
+                p12);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+            Parm11 p11, Parm12 p12, Parm13 p13)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12,
+                    p13);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11,
+                p12, p13);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12,
+                    p13, p14);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11,
+                p12, p13, p14);
+        }
+        
+        ResultType operator()(Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4,
+            Parm5 p5, Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
+        {
+            const std::size_t last = funs_.size() - 1;
+            for (std::size_t i = 0; i < last; ++i)
+                funs_[i](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12,
+                    p13, p14, p15);
+            return funs_[last](p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11,
+                p12, p13, p14, p15);
+        }
+
+    private:
+
+        void Append(const Fun& fun)
+        {
+            const ChainSequence* seq =
+                dynamic_cast<const ChainSequence*>(fun.GetImpl());
+            if (seq != 0)
+                funs_.insert(funs_.end(), seq->funs_.begin(),
+                    seq->funs_.end());
+            else
+                funs_.push_back(fun);
+        }
+
+        template <class Fun1>
+        void Append(const Fun1& fun)
+        {
+            funs_.push_back(Fun(fun));
+        }
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+        void Append(Fun&& fun)
+        {
+            if (dynamic_cast<const ChainSequence*>(fun.GetImpl()) != 0)
+                Append(static_cast<const Fun&>(fun)); // flatten by copy
+            else
+                funs_.push_back(std::move(fun));
+        }
+#endif
+
+        Sequence funs_;
+    };
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  Chains two functor calls one after another
 ///  \ingroup FunctorGroup
+///  The result holds a flat ChainSequence: chaining onto an already
+///  chained functor extends its sequence, so repeated Chain calls yield
+///  one sequentially scanned impl rather than a nested tree.
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -1779,9 +3016,23 @@ namespace Loki
         const Fun2& fun2)
     {
         return Fun2(std::auto_ptr<typename Fun2::Impl>(
-            new Chainer<Fun1, Fun2>(fun1, fun2)));
+            new ChainSequence<Fun2>(fun1, fun2)));
     }
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+    template <typename R1, class TL1, template <class, class> class TM1,
+        typename R2, class TL2, template <class, class> class TM2>
+    Functor<R2, TL2, TM2> Chain(
+        Functor<R1, TL1, TM1>&& fun1,
+        Functor<R2, TL2, TM2>&& fun2)
+    {
+        typedef Functor<R2, TL2, TM2> Fun2;
+        return Fun2(std::auto_ptr<typename Fun2::Impl>(
+            new ChainSequence<Fun2>(std::move(fun1), std::move(fun2))));
+    }
+#endif
+
 } // namespace Loki
 
 
@@ -234,6 +234,422 @@ namespace Loki
 //        return FieldHelper<H, i>::Do(obj);
 //    }
         
+////////////////////////////////////////////////////////////////////////////////
+// class template GenTreeHierarchy
+// Generates a balanced binary hierarchy from a typelist and a template
+// Invocation (TList is a typelist, Unit is a template of one arg):
+// GenTreeHierarchy<TList, Unit>
+// Like GenScatterHierarchy the generated class inherits Unit<T> for every T
+// in TList, but the bases form a balanced tree instead of a list, so
+// Field<i>(obj) resolves through log2(n) casts instead of n and deep
+// typelists do not exhaust the compiler's recursion limits.  Every leaf is
+// tagged with its index, so no two bases ever share a type and the empty
+// base optimization is never inhibited: a hierarchy over empty policy
+// classes has size one.  Field<T>(obj) works as for GenScatterHierarchy
+// when T occurs once in TList; with duplicates use Field<i>, which always
+// reaches the i-th unit through its tag.
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        // Tags each unit with its index: bases stay unique types even when
+        // TList repeats a type, which keeps every unit reachable and lets
+        // identical empty units collapse to nothing.
+        template <unsigned int i, class T, template <class> class Unit>
+        struct TreeHierarchyLeaf : public Unit<T>
+        {
+            typedef Unit<T> UnitType;
+        };
+
+        // The subtree covering the index range [offset, offset + length).
+        template <class TList, unsigned int offset, unsigned int length,
+            template <class> class Unit>
+        struct TreeHierarchyNode
+            : public TreeHierarchyNode<TList, offset, length / 2, Unit>
+            , public TreeHierarchyNode<TList, offset + length / 2,
+                  length - length / 2, Unit>
+        {
+            typedef TreeHierarchyNode<TList, offset, length / 2, Unit>
+                LeftBase;
+            typedef TreeHierarchyNode<TList, offset + length / 2,
+                length - length / 2, Unit> RightBase;
+        };
+
+        template <class TList, unsigned int offset,
+            template <class> class Unit>
+        struct TreeHierarchyNode<TList, offset, 1, Unit>
+            : public TreeHierarchyLeaf<offset,
+                  typename TL::TypeAt<TList, offset>::Result, Unit>
+        {
+        };
+
+        // Walks from a node to the leaf holding index i, halving the range
+        // at every step; each Do is one derived-to-base conversion.
+        template <class TList, unsigned int offset, unsigned int length,
+            template <class> class Unit, unsigned int i>
+        struct TreeFieldHelper
+        {
+            enum { leftLength = length / 2 };
+            enum { goLeft = (i < offset + leftLength) };
+            enum { childOffset = goLeft ? offset : offset + leftLength };
+            enum { childLength = goLeft ? leftLength : length - leftLength };
+
+            typedef TreeHierarchyNode<TList, offset, length, Unit> NodeType;
+            typedef TreeFieldHelper<TList, childOffset, childLength, Unit, i>
+                Next;
+            typedef typename Next::ResultType ResultType;
+
+            static ResultType& Do(NodeType& node)
+            {
+                typename Next::NodeType& child = node;
+                return Next::Do(child);
+            }
+            static const ResultType& Do(const NodeType& node)
+            {
+                const typename Next::NodeType& child = node;
+                return Next::Do(child);
+            }
+        };
+
+        template <class TList, unsigned int offset,
+            template <class> class Unit, unsigned int i>
+        struct TreeFieldHelper<TList, offset, 1, Unit, i>
+        {
+            // reached only with i == offset
+            typedef typename TL::TypeAt<TList, offset>::Result ElementType;
+            typedef TreeHierarchyNode<TList, offset, 1, Unit> NodeType;
+            typedef Unit<ElementType> ResultType;
+
+            static ResultType& Do(NodeType& leaf)
+            {
+                return leaf;
+            }
+            static const ResultType& Do(const NodeType& leaf)
+            {
+                return leaf;
+            }
+        };
+    }
+
+    template <class TList, template <class> class Unit>
+    class GenTreeHierarchy
+        : public Private::TreeHierarchyNode<TList, 0,
+              TL::Length<TList>::value, Unit>
+    {
+    public:
+        typedef TList TheList;
+        typedef Private::TreeHierarchyNode<TList, 0,
+            TL::Length<TList>::value, Unit> RootNode;
+        template <typename T> struct Rebind
+        {
+            typedef Unit<T> Result;
+        };
+    };
+
+    template <template <class> class Unit>
+    class GenTreeHierarchy<NullType, Unit>
+    {
+    public:
+        typedef NullType TheList;
+        template <typename T> struct Rebind
+        {
+            typedef Unit<T> Result;
+        };
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// FieldHelper specializations for GenTreeHierarchy
+// Route the generic Field<i>(obj) down the tree.  As with the scattered
+// hierarchy, TupleUnit fields yield the element itself.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class TList, template <class> class Unit, unsigned int i>
+    struct FieldHelper<GenTreeHierarchy<TList, Unit>, i>
+    {
+        typedef typename TL::TypeAt<TList, i>::Result ElementType;
+        typedef Unit<ElementType> UnitType;
+
+        enum
+        {
+            isTuple = Conversion<UnitType, TupleUnit<ElementType> >::sameType
+        };
+
+        typedef typename Select<isTuple, ElementType,
+            UnitType>::Result ResultType;
+
+        typedef Private::TreeFieldHelper<TList, 0,
+            TL::Length<TList>::value, Unit, i> Walker;
+
+        static ResultType& Do(GenTreeHierarchy<TList, Unit>& obj)
+        {
+            UnitType& unit = Walker::Do(obj);
+            return unit;
+        }
+    };
+
+    template <class TList, template <class> class Unit, unsigned int i>
+    struct FieldHelper<const GenTreeHierarchy<TList, Unit>, i>
+    {
+        typedef typename TL::TypeAt<TList, i>::Result ElementType;
+        typedef Unit<ElementType> UnitType;
+
+        enum
+        {
+            isTuple = Conversion<UnitType, TupleUnit<ElementType> >::sameType
+        };
+
+        typedef const typename Select<isTuple, ElementType,
+            UnitType>::Result ResultType;
+
+        typedef Private::TreeFieldHelper<TList, 0,
+            TL::Length<TList>::value, Unit, i> Walker;
+
+        static ResultType& Do(const GenTreeHierarchy<TList, Unit>& obj)
+        {
+            const UnitType& unit = Walker::Do(obj);
+            return unit;
+        }
+    };
+
+    // i == 0 again, to disambiguate against the generic FieldHelper<H, 0>
+    template <class TList, template <class> class Unit>
+    struct FieldHelper<GenTreeHierarchy<TList, Unit>, 0>
+    {
+        typedef typename TList::Head ElementType;
+        typedef Unit<ElementType> UnitType;
+
+        enum
+        {
+            isTuple = Conversion<UnitType, TupleUnit<ElementType> >::sameType
+        };
+
+        typedef typename Select<isTuple, ElementType,
+            UnitType>::Result ResultType;
+
+        typedef Private::TreeFieldHelper<TList, 0,
+            TL::Length<TList>::value, Unit, 0> Walker;
+
+        static ResultType& Do(GenTreeHierarchy<TList, Unit>& obj)
+        {
+            UnitType& unit = Walker::Do(obj);
+            return unit;
+        }
+    };
+
+    template <class TList, template <class> class Unit>
+    struct FieldHelper<const GenTreeHierarchy<TList, Unit>, 0>
+    {
+        typedef typename TList::Head ElementType;
+        typedef Unit<ElementType> UnitType;
+
+        enum
+        {
+            isTuple = Conversion<UnitType, TupleUnit<ElementType> >::sameType
+        };
+
+        typedef const typename Select<isTuple, ElementType,
+            UnitType>::Result ResultType;
+
+        typedef Private::TreeFieldHelper<TList, 0,
+            TL::Length<TList>::value, Unit, 0> Walker;
+
+        static ResultType& Do(const GenTreeHierarchy<TList, Unit>& obj)
+        {
+            const UnitType& unit = Walker::Do(obj);
+            return unit;
+        }
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// class template FlatTuple
+// Tuple variant with flat storage: instead of one base class per field (as
+// GenScatterHierarchy gives Tuple), the fields live in one recursively
+// nested member struct, so every access compiles to a single constant
+// offset from the object's address and the whole tuple occupies one
+// contiguous, naturally aligned block.  Empty class fields are held as
+// bases, so the empty base optimization removes their storage.  Access
+// goes through the same Field<i>(obj) and Field<Type>(obj) interface as
+// Tuple (overloads below), with Field<i> returning the element itself.
+// Unlike Tuple there is no Unit wrapper type to take a reference to;
+// FlatTuple is a plain aggregate of its fields.
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        // Compile-time test for class types (the member-pointer overload
+        // is only viable when T can have members).
+        template <class T>
+        struct FlatTupleIsClass
+        {
+            template <class U> static char Test(void (U::*)(void));
+            template <class U> static int  Test(...);
+            enum { value = sizeof(Test<T>(0)) == sizeof(char) };
+        };
+
+        // Holds one field.  The specialization for (probably) empty
+        // classes stores the field as a base so the empty base
+        // optimization applies; everything else is an ordinary member.
+        template <class T, bool asBase>
+        struct FlatTupleUnit
+        {
+            T value_;
+            T& Get() { return value_; }
+            const T& Get() const { return value_; }
+        };
+
+        template <class T>
+        struct FlatTupleUnit<T, true> : public T
+        {
+            T& Get() { return *this; }
+            const T& Get() const { return *this; }
+        };
+
+        template <class TList> struct FlatTupleStorage;
+
+        template <class Head, class Tail>
+        struct FlatTupleStorage<Typelist<Head, Tail> >
+            : public FlatTupleUnit<Head,
+                  FlatTupleIsClass<Head>::value && sizeof(Head) == 1>
+        {
+            typedef FlatTupleUnit<Head,
+                FlatTupleIsClass<Head>::value && sizeof(Head) == 1> HeadUnit;
+
+            Head& GetHead() { return HeadUnit::Get(); }
+            const Head& GetHead() const { return HeadUnit::Get(); }
+
+            FlatTupleStorage<Tail> tail_;
+        };
+
+        // the last field carries no tail member, so an empty recursion
+        // terminator never pads the layout
+        template <class Head>
+        struct FlatTupleStorage<Typelist<Head, NullType> >
+            : public FlatTupleUnit<Head,
+                  FlatTupleIsClass<Head>::value && sizeof(Head) == 1>
+        {
+            typedef FlatTupleUnit<Head,
+                FlatTupleIsClass<Head>::value && sizeof(Head) == 1> HeadUnit;
+
+            Head& GetHead() { return HeadUnit::Get(); }
+            const Head& GetHead() const { return HeadUnit::Get(); }
+        };
+
+        // Peels tail_ members off until the wanted field is the head; the
+        // recursion is pure compile time, so the load folds to one offset.
+        template <class TList, unsigned int i>
+        struct FlatFieldHelper
+        {
+            typedef typename TL::TypeAt<TList, i>::Result ElementType;
+
+            static ElementType& Do(FlatTupleStorage<TList>& storage)
+            {
+                return FlatFieldHelper<typename TList::Tail, i - 1>
+                    ::Do(storage.tail_);
+            }
+            static const ElementType& Do(const FlatTupleStorage<TList>& storage)
+            {
+                return FlatFieldHelper<typename TList::Tail, i - 1>
+                    ::Do(storage.tail_);
+            }
+        };
+
+        template <class TList>
+        struct FlatFieldHelper<TList, 0>
+        {
+            typedef typename TList::Head ElementType;
+
+            static ElementType& Do(FlatTupleStorage<TList>& storage)
+            {
+                return storage.GetHead();
+            }
+            static const ElementType& Do(const FlatTupleStorage<TList>& storage)
+            {
+                return storage.GetHead();
+            }
+        };
+    }
+
+    template <class TList>
+    struct FlatTuple : public Private::FlatTupleStorage<TList>
+    {
+        typedef TList TupleList;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// FieldHelper specializations for FlatTuple
+// Route the generic Field<i>(obj) through the flat storage instead of the
+// base-class walk; Field<i> on a FlatTuple returns the element itself.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class TList, unsigned int i>
+    struct FieldHelper<FlatTuple<TList>, i>
+    {
+        typedef typename Private::FlatFieldHelper<TList, i>::ElementType
+            ResultType;
+
+        static ResultType& Do(FlatTuple<TList>& obj)
+        {
+            return Private::FlatFieldHelper<TList, i>::Do(obj);
+        }
+    };
+
+    template <class TList, unsigned int i>
+    struct FieldHelper<const FlatTuple<TList>, i>
+    {
+        typedef const typename Private::FlatFieldHelper<TList, i>::ElementType
+            ResultType;
+
+        static ResultType& Do(const FlatTuple<TList>& obj)
+        {
+            return Private::FlatFieldHelper<TList, i>::Do(obj);
+        }
+    };
+
+    // i == 0 again, to disambiguate against the generic FieldHelper<H, 0>
+    template <class TList>
+    struct FieldHelper<FlatTuple<TList>, 0>
+    {
+        typedef typename Private::FlatFieldHelper<TList, 0>::ElementType
+            ResultType;
+
+        static ResultType& Do(FlatTuple<TList>& obj)
+        {
+            return Private::FlatFieldHelper<TList, 0>::Do(obj);
+        }
+    };
+
+    template <class TList>
+    struct FieldHelper<const FlatTuple<TList>, 0>
+    {
+        typedef const typename Private::FlatFieldHelper<TList, 0>::ElementType
+            ResultType;
+
+        static ResultType& Do(const FlatTuple<TList>& obj)
+        {
+            return Private::FlatFieldHelper<TList, 0>::Do(obj);
+        }
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// function template Field (FlatTuple overloads)
+// Field<T>(obj) picks the first field of type T and returns the element
+// itself, like the Unit lookup does for Tuple.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class T, class TList>
+    T& Field(FlatTuple<TList>& obj)
+    {
+        return Private::FlatFieldHelper<TList,
+            TL::IndexOf<TList, T>::value>::Do(obj);
+    }
+
+    template <class T, class TList>
+    const T& Field(const FlatTuple<TList>& obj)
+    {
+        return Private::FlatFieldHelper<TList,
+            TL::IndexOf<TList, T>::value>::Do(obj);
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template GenLinearHierarchy
 // Generates a linear hierarchy starting from a typelist and a template
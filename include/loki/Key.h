@@ -65,6 +65,12 @@ namespace Loki
         typedef typename Factory::Parm13 Parm13;
         typedef typename Factory::Parm14 Parm14;
         typedef typename Factory::Parm15 Parm15;
+
+        void computeHash()
+        {
+            hash = FactoryIdHash<IdentifierType>()(id)
+                ^ (static_cast<std::size_t>(count) * 2654435761u);
+        }
      public:
         // member variables
         int count; // should be const, but constness prevent default copy ctor
@@ -84,15 +90,20 @@ namespace Loki
         Parm13 p13;
         Parm14 p14;
         Parm15 p15;
+        // hash of id and count, computed once at construction so lookups
+        // can decide most comparisons with one integer compare
+        std::size_t hash;
         
         // member functions
         Key() : count(-1)
         {
+            computeHash();
         }
 
         Key(const IdentifierType& id) : count(0)
         {
             this->id = id;
+            computeHash();
         }
         
         Key(const IdentifierType& id,
@@ -100,6 +111,7 @@ namespace Loki
         {
             this->id = id;
             this->p1 = p1;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -108,6 +120,7 @@ namespace Loki
             this->id = id;
             this->p1 = p1;
             this->p2 = p2;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -117,6 +130,7 @@ namespace Loki
             this->p1 = p1;
             this->p2 = p2;
             this->p3 = p3;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -127,6 +141,7 @@ namespace Loki
             this->p2 = p2;
             this->p3 = p3;
             this->p4 = p4;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -138,6 +153,7 @@ namespace Loki
             this->p3 = p3;
             this->p4 = p4;
             this->p5 = p5;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -151,6 +167,7 @@ namespace Loki
             this->p4 = p4;
             this->p5 = p5;
             this->p6 = p6;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -165,6 +182,7 @@ namespace Loki
             this->p5 = p5;
             this->p6 = p6;
             this->p7 = p7;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -180,6 +198,7 @@ namespace Loki
             this->p6 = p6;
             this->p7 = p7;
             this->p8 = p8;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -196,6 +215,7 @@ namespace Loki
             this->p7 = p7;
             this->p8 = p8;
             this->p9 = p9;
+            computeHash();
         }
         
         Key(const IdentifierType& id,
@@ -213,6 +233,7 @@ namespace Loki
             this->p8 = p8;
             this->p9 = p9;
             this->p10 = p10;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -232,6 +253,7 @@ namespace Loki
             this->p9 = p9;
             this->p10 = p10;
             this->p11 = p11;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -252,6 +274,7 @@ namespace Loki
             this->p10 = p10;
             this->p11 = p11;
             this->p12 = p12;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -273,6 +296,7 @@ namespace Loki
             this->p11 = p11;
             this->p12 = p12;
             this->p13 = p13;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -295,6 +319,7 @@ namespace Loki
             this->p12 = p12;
             this->p13 = p13;
             this->p14 = p14;
+            computeHash();
         }
 
         Key(const IdentifierType& id,
@@ -318,6 +343,7 @@ namespace Loki
             this->p13 = p13;
             this->p14 = p14;
             this->p15 = p15;
+            computeHash();
         }
 
         template<class F, typename I>
@@ -328,9 +354,21 @@ namespace Loki
     };
 
         
+    /// Hashed containers reuse the hash the Key precomputed.
+    template<class F, typename I>
+    struct FactoryIdHash< Key<F, I> >
+    {
+        std::size_t operator()(const Key<F, I>& key) const
+        {
+            return key.hash;
+        }
+    };
+
     template<class F, typename I>
      bool operator==(const Key<F, I> &k1, const Key<F, I> &k2)
     {
+        if( k1.hash != k2.hash ) // equal keys always have equal hashes
+            return false;
         if( k1.count != k2.count )
             return false;
         switch(k1.count){
@@ -546,211 +584,527 @@ namespace Loki
     template<class F, typename I>
     bool operator<(const Key<F, I> &k1, const Key<F, I> &k2)
     {
-        if( k1.count < k2.count )
-            return true;
+        // one integer compare decides the common case, the fields only
+        // break hash ties
+        if( k1.hash != k2.hash )
+            return k1.hash < k2.hash;
+        if( k1.count != k2.count )
+            return k1.count < k2.count;
         switch(k1.count){
             case -1:
                 return false;
             case 0:
+                return k1.id < k2.id;
+            case 1:
                 if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
                     return false;
-            case 1:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) )
+                return k1.p1 < k2.p1;
+            case 2:
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
                     return false;
-            case 2:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) )
+                if( k1.p1 < k2.p1 )
                     return true;
-                else
+                if( k2.p1 < k1.p1 )
                     return false;
+                return k1.p2 < k2.p2;
             case 3:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
                     return false;
+                return k1.p3 < k2.p3;
             case 4:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
                     return false;
+                return k1.p4 < k2.p4;
             case 5:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
                     return false;
+                return k1.p5 < k2.p5;
             case 6:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
                     return false;
+                return k1.p6 < k2.p6;
             case 7:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
                     return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                return k1.p7 < k2.p7;
             case 8:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
                     return false;
+                return k1.p8 < k2.p8;
             case 9:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
                     return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                return k1.p9 < k2.p9;
             case 10:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
                     return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                return k1.p10 < k2.p10;
             case 11:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) || 
-                    (k1.p11 < k2.p11) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
                     return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                if( k1.p10 < k2.p10 )
+                    return true;
+                if( k2.p10 < k1.p10 )
+                    return false;
+                return k1.p11 < k2.p11;
             case 12:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) || 
-                    (k1.p11 < k2.p11) || 
-                    (k1.p12 < k2.p12) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
                     return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                if( k1.p10 < k2.p10 )
+                    return true;
+                if( k2.p10 < k1.p10 )
+                    return false;
+                if( k1.p11 < k2.p11 )
+                    return true;
+                if( k2.p11 < k1.p11 )
+                    return false;
+                return k1.p12 < k2.p12;
             case 13:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) || 
-                    (k1.p11 < k2.p11) || 
-                    (k1.p12 < k2.p12) || 
-                    (k1.p13 < k2.p13) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                if( k1.p10 < k2.p10 )
+                    return true;
+                if( k2.p10 < k1.p10 )
+                    return false;
+                if( k1.p11 < k2.p11 )
+                    return true;
+                if( k2.p11 < k1.p11 )
+                    return false;
+                if( k1.p12 < k2.p12 )
+                    return true;
+                if( k2.p12 < k1.p12 )
                     return false;
+                return k1.p13 < k2.p13;
             case 14:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) || 
-                    (k1.p11 < k2.p11) || 
-                    (k1.p12 < k2.p12) || 
-                    (k1.p13 < k2.p13) || 
-                    (k1.p14 < k2.p14) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                if( k1.p10 < k2.p10 )
+                    return true;
+                if( k2.p10 < k1.p10 )
+                    return false;
+                if( k1.p11 < k2.p11 )
+                    return true;
+                if( k2.p11 < k1.p11 )
+                    return false;
+                if( k1.p12 < k2.p12 )
+                    return true;
+                if( k2.p12 < k1.p12 )
                     return false;
+                if( k1.p13 < k2.p13 )
+                    return true;
+                if( k2.p13 < k1.p13 )
+                    return false;
+                return k1.p14 < k2.p14;
             case 15:
-                if( (k1.id < k2.id) || 
-                    (k1.p1 < k2.p1) || 
-                    (k1.p2 < k2.p2) || 
-                    (k1.p3 < k2.p3) || 
-                    (k1.p4 < k2.p4) || 
-                    (k1.p5 < k2.p5) || 
-                    (k1.p6 < k2.p6) || 
-                    (k1.p7 < k2.p7) || 
-                    (k1.p8 < k2.p8) || 
-                    (k1.p9 < k2.p9) || 
-                    (k1.p10 < k2.p10) || 
-                    (k1.p11 < k2.p11) || 
-                    (k1.p12 < k2.p12) || 
-                    (k1.p13 < k2.p13) || 
-                    (k1.p14 < k2.p14) || 
-                    (k1.p15 < k2.p15) )
+                if( k1.id < k2.id )
                     return true;
-                else
+                if( k2.id < k1.id )
+                    return false;
+                if( k1.p1 < k2.p1 )
+                    return true;
+                if( k2.p1 < k1.p1 )
+                    return false;
+                if( k1.p2 < k2.p2 )
+                    return true;
+                if( k2.p2 < k1.p2 )
+                    return false;
+                if( k1.p3 < k2.p3 )
+                    return true;
+                if( k2.p3 < k1.p3 )
+                    return false;
+                if( k1.p4 < k2.p4 )
+                    return true;
+                if( k2.p4 < k1.p4 )
+                    return false;
+                if( k1.p5 < k2.p5 )
+                    return true;
+                if( k2.p5 < k1.p5 )
+                    return false;
+                if( k1.p6 < k2.p6 )
+                    return true;
+                if( k2.p6 < k1.p6 )
+                    return false;
+                if( k1.p7 < k2.p7 )
+                    return true;
+                if( k2.p7 < k1.p7 )
+                    return false;
+                if( k1.p8 < k2.p8 )
+                    return true;
+                if( k2.p8 < k1.p8 )
+                    return false;
+                if( k1.p9 < k2.p9 )
+                    return true;
+                if( k2.p9 < k1.p9 )
+                    return false;
+                if( k1.p10 < k2.p10 )
+                    return true;
+                if( k2.p10 < k1.p10 )
+                    return false;
+                if( k1.p11 < k2.p11 )
+                    return true;
+                if( k2.p11 < k1.p11 )
+                    return false;
+                if( k1.p12 < k2.p12 )
+                    return true;
+                if( k2.p12 < k1.p12 )
+                    return false;
+                if( k1.p13 < k2.p13 )
+                    return true;
+                if( k2.p13 < k1.p13 )
+                    return false;
+                if( k1.p14 < k2.p14 )
+                    return true;
+                if( k2.p14 < k1.p14 )
                     return false;
+                return k1.p15 < k2.p15;
             default:
                 return false;
         }
@@ -561,19 +561,26 @@ private:
 // ----------------------------------------------------------------------------
 
 /** @class SleepLevelMutex
- Implements a sleeping loop to wait for the mutex to unlock.
+ Implements a wait-and-notify scheme to wait for the mutex to unlock.
 
  @par Purpose
- Since this class puts the thread to sleep for short intervals, you can use this 
+ Since this class puts the thread to sleep while it waits, you can use this
  class for most of your mutexes. Especially for locking any high level resources
  where any one operation on the resouce consumes many CPU cycles.  The purpose of
  this mutex is to reduce the number of CPU cycles spent in idle loops.  All
  SleepLevelMutex's should have higher levels than all your SpinLevelMutex's.
 
+ @par Waiting
+ A waiter parks on a condition variable (POSIX) or an auto-reset event
+ (Windows), and Unlock notifies it, so the handoff happens as soon as the
+ holder releases rather than when a sleep interval expires.  The sleep time
+ merely bounds each wait as a safety net; with the notification in place a
+ waiter almost never runs into it.
+
  @par Dependence on SpinLevelMutex
  This utilizes SpinLevelMutex so it does not have to re-implement the DoTryLock
  and DoUnlock functions the same way.  All it really needs is a DoLock function
- and the amount of time it should sleep if an attempt to lock a function fails.
+ that waits for the notification, and an Unlock that sends it.
  */
 class SleepLevelMutex : public SpinLevelMutex
 {
@@ -603,11 +610,15 @@ public:
     inline void SetWakable( bool wakable ) volatile { m_wakable = wakable; }
 #endif
 
-    /** Attempts to lock a mutex, and if it fails, then sleeps for a while
-     before attempting again.
+    /** Attempts to lock a mutex, and if it fails, waits until the holder
+     signals its release - or until the sleep time passes - before
+     attempting again.
      */
     virtual MutexErrors::Type Lock( void ) volatile;
 
+    /// Unlocks the mutex and wakes one waiting thread, if any.
+    virtual MutexErrors::Type Unlock( void ) volatile;
+
 private:
 
     /// Default constructor is not implemented.
@@ -621,18 +632,444 @@ private:
     #if ( _MSC_VER >= 1300 )
         /// True if operating system may wake thread to respond to events.
         bool m_wakable;
+        /// Auto-reset event Unlock signals to wake one waiting thread.
+        HANDLE m_event;
+        /// Number of threads waiting on the event.
+        volatile LONG m_waiters;
     #else
         #error "Only Visual Studio versions 7.0 and after supported."
     #endif
+#else
+    /// Protects m_waiters and pairs with the condition variable.
+    pthread_mutex_t m_waitMutex;
+    /// Condition variable Unlock signals to wake one waiting thread.
+    pthread_cond_t m_waitCondition;
+    /// Number of threads waiting on the condition variable.
+    unsigned int m_waiters;
 #endif
 
-    /// How many milli-seconds to sleep before trying to lock mutex again.
+    /// Upper bound, in milli-seconds, on each wait for the unlock signal.
     unsigned int m_sleepTime;
 
 }; // end class SleepLevelMutex
 
 // ----------------------------------------------------------------------------
 
+/** @class HybridLevelMutex
+ Combines a bounded spin phase with the parking scheme of SleepLevelMutex so a
+ single mutex class can serve every level of a hierarchy whose hold times range
+ from nanoseconds to milliseconds.  Lock first retries in a spin loop whose
+ delay grows along a doubling backoff curve - optionally executing the
+ processor's pause hint between attempts - and only parks on the condition
+ variable or event once the spin budget is spent.
+
+ @par Per-Level Configuration
+ Each aspect of the wait - how many attempts to spin, how long the backoff
+ delay starts, where the doubling stops, and whether to use the pause hint -
+ comes from a WaitPolicy.  Call SetLevelWaitPolicy during program startup to
+ store a policy for a level, and every hybrid mutex constructed at that level
+ afterwards adopts it; briefly held low-level mutexes can thus spin longer
+ before parking while high-level mutexes park almost at once.  A policy passed
+ directly to the constructor - or installed later through SetWaitPolicy -
+ overrides the per-level default for that one mutex.
+ */
+class HybridLevelMutex : public SleepLevelMutex
+{
+public:
+
+    /** @struct WaitPolicy
+     Describes how a hybrid mutex waits before it parks.  A zero spin count
+     parks immediately like SleepLevelMutex; a zero backoff base with a zero
+     cap spins on nothing but lock attempts like a classic spin-loop.
+     */
+    struct WaitPolicy
+    {
+        /// Failed lock attempts made while spinning before Lock parks.
+        unsigned int spinCount;
+        /// Delay iterations executed after the first failed attempt.
+        unsigned int backoffBase;
+        /// Ceiling the doubling backoff delay never exceeds.
+        unsigned int backoffCap;
+        /// True to execute the processor's pause hint in the delay loop.
+        bool usePause;
+
+        /// Constructs defaults suited to briefly held mutexes.
+        WaitPolicy( void );
+
+        WaitPolicy( unsigned int spins, unsigned int base, unsigned int cap,
+            bool pause );
+    };
+
+    /** Constructs a hybrid mutex using the wait policy stored for its level,
+     or the default policy if none was stored.
+     @param level Level of this mutex.
+     */
+    explicit HybridLevelMutex( unsigned int level );
+
+    /// Constructs a hybrid mutex with an explicit wait policy.
+    HybridLevelMutex( unsigned int level, const WaitPolicy & policy );
+
+    /// Destructs the mutex.
+    virtual ~HybridLevelMutex( void );
+
+    /** Attempts to lock the mutex in a spin loop with a doubling backoff
+     delay, and parks as SleepLevelMutex does once the spin budget is spent.
+     */
+    virtual MutexErrors::Type Lock( void ) volatile;
+
+    inline WaitPolicy GetWaitPolicy( void ) const volatile
+    {
+        return WaitPolicy( m_spinCount, m_backoffBase, m_backoffCap,
+            m_usePause );
+    }
+
+    /// Changes how this one mutex waits.  Callable while others hold the lock.
+    void SetWaitPolicy( const WaitPolicy & policy ) volatile;
+
+    /** Stores the wait policy every hybrid mutex of the given level adopts at
+     construction.  Call this while setting up the mutex hierarchy - before
+     constructing mutexes of that level - since the policy table itself is not
+     guarded against concurrent modification.  Mutexes constructed earlier are
+     not revisited.
+     */
+    static void SetLevelWaitPolicy( unsigned int level,
+        const WaitPolicy & policy );
+
+    /// Returns the stored policy for a level, or the defaults if none stored.
+    static WaitPolicy GetLevelWaitPolicy( unsigned int level );
+
+private:
+
+    /// Default constructor is not implemented.
+    HybridLevelMutex( void );
+    /// Copy constructor is not implemented.
+    HybridLevelMutex( const HybridLevelMutex & );
+    /// Copy-assignment operator is not implemented.
+    HybridLevelMutex & operator = ( const HybridLevelMutex & );
+
+    /// Failed lock attempts made while spinning before Lock parks.
+    unsigned int m_spinCount;
+    /// Delay iterations executed after the first failed attempt.
+    unsigned int m_backoffBase;
+    /// Ceiling the doubling backoff delay never exceeds.
+    unsigned int m_backoffCap;
+    /// True to execute the processor's pause hint in the delay loop.
+    bool m_usePause;
+
+}; // end class HybridLevelMutex
+
+// ----------------------------------------------------------------------------
+
+/** @class ReadWriteLevelMutex
+ Wraps a reader/writer lock so a levelized mutex can be held shared by many
+ reader threads at once while writers remain exclusive.  Lock, TryLock, and
+ Unlock take the exclusive (writer) path and satisfy the same MutexPolicy
+ requirements as SpinLevelMutex; LockShared, TryLockShared, and UnlockShared
+ add the shared (reader) path used by LevelMutex::LockShared.
+
+ @par Implementation
+ Uses pthread_rwlock_t on POSIX and slim reader/writer locks on Windows 7 or
+ later.  On older Windows targets it degrades to a CRITICAL_SECTION, where
+ readers serialize but all calls keep their meaning.
+ */
+class ReadWriteLevelMutex
+{
+public:
+
+    /// Constructs a reader/writer levelized mutex.
+    explicit ReadWriteLevelMutex( unsigned int level );
+
+    /// Destructs the mutex.
+    virtual ~ReadWriteLevelMutex( void );
+
+    virtual MutexErrors::Type Lock( void ) volatile;
+
+    virtual MutexErrors::Type TryLock( void ) volatile;
+
+    virtual MutexErrors::Type Unlock( void ) volatile;
+
+    virtual MutexErrors::Type LockShared( void ) volatile;
+
+    virtual MutexErrors::Type TryLockShared( void ) volatile;
+
+    virtual MutexErrors::Type UnlockShared( void ) volatile;
+
+    inline unsigned int GetLevel( void ) const volatile { return m_level; }
+
+private:
+
+    /// Copy constructor is not implemented.
+    ReadWriteLevelMutex( const ReadWriteLevelMutex & );
+    /// Copy-assignment operator is not implemented.
+    ReadWriteLevelMutex & operator = ( const ReadWriteLevelMutex & );
+
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        /// The actual reader/writer lock.
+        SRWLOCK m_mutex;
+    #else
+        /// Exclusive fallback for targets without slim reader/writer locks.
+        CRITICAL_SECTION m_mutex;
+    #endif
+#elif ( __GNUC__ )
+    /// The actual reader/writer lock.
+    pthread_rwlock_t m_mutex;
+#else
+    #error "Check if any mutex libraries are compatible with your compiler."
+#endif
+
+    /// Keep a copy of the mutex level around for error reporting.
+    const unsigned int m_level;
+
+}; // end class ReadWriteLevelMutex
+
+// ----------------------------------------------------------------------------
+
+/** @class SharedLevelTracker
+ Per-thread bookkeeping for shared (reader) locks on levelized mutexes.  The
+ linked list inside LevelMutexInfo can only express exclusive ownership - a
+ mutex holds one back-pointer, so it can sit in one thread's chain - while a
+ shared lock is held by many threads at once.  Each thread therefore records
+ the mutexes it holds shared in a small thread-local stack of its own.
+ GetCurrentThreadsLevel consults this tracker along with the exclusive chain,
+ so the level-ordering deadlock checks treat shared and exclusive locks
+ uniformly: a thread's current level is that of its most recent acquisition
+ of either kind.
+
+ The PreShareCheck and PreUnshareCheck functions follow the same contract as
+ LevelMutexInfo's pre-checks: Success means the call is complete (a re-entrant
+ acquire or nested release was counted), NoProblem means the caller should
+ operate on the actual lock and then record it, and anything else is an error.
+ */
+class SharedLevelTracker
+{
+public:
+
+    /// Deepest nesting of shared locks any one thread may hold.
+    static const unsigned int MaxSharedLocks = 64;
+
+    /// Returns level of the calling thread's most recent shared lock, or
+    /// LevelMutexInfo::UnlockedLevel if the thread holds none.
+    static unsigned int GetLevel( void );
+
+    /// Returns true if the calling thread holds this mutex shared.
+    static bool IsSharedByCurrentThread( const volatile LevelMutexInfo * mutex );
+
+    /** Checks whether the calling thread may acquire this mutex shared.
+     Re-acquiring the thread's most recent shared lock just increments a
+     count and returns Success.
+     @return Success if complete, NoProblem if the caller should lock the
+      actual mutex and then call PostShare, else an error condition.
+     */
+    static MutexErrors::Type PreShareCheck( const volatile LevelMutexInfo * mutex );
+
+    /// Records a successful shared acquisition.  Call only after
+    /// PreShareCheck returned NoProblem and the actual lock succeeded.
+    static void PostShare( const volatile LevelMutexInfo * mutex );
+
+    /** Checks whether the calling thread may release this shared lock.
+     Shared locks must be released in reverse acquisition order, and not
+     before any more recent exclusive lock.
+     @return Success if complete, NoProblem if the caller should unlock the
+      actual mutex and then call PostUnshare, else an error condition.
+     */
+    static MutexErrors::Type PreUnshareCheck( const volatile LevelMutexInfo * mutex );
+
+    /// Records a shared release.  Call only after PreUnshareCheck returned
+    /// NoProblem and the actual unlock succeeded.
+    static void PostUnshare( void );
+
+private:
+
+    /// This class has only static members, so nobody constructs it.
+    SharedLevelTracker( void );
+
+}; // end class SharedLevelTracker
+
+// ----------------------------------------------------------------------------
+
+/** @class MutexStats
+ Per-instance contention statistics for levelized mutexes.  This is not a
+ mutex itself - StatsLevelMutex mixes it into any mutex policy.  Every live
+ instance sits in a global registry, so monitoring code can walk all the
+ instrumented mutexes at runtime (in the spirit of LevelMutexInfo's
+ IsValidList checker) and pinpoint which one is contended.
+
+ @par Accuracy
+ All counters are updated by the thread that holds the associated mutex, so
+ they are exact.  WalkAll reads them without locking each mutex, so a
+ visitor may see a value that is mid-update; for monitoring purposes that
+ imprecision is harmless.
+ */
+class MutexStats
+{
+public:
+
+#if defined( _MSC_VER )
+    typedef unsigned __int64 MicroSeconds;
+#else
+    typedef unsigned long long MicroSeconds;
+#endif
+
+    /** Type of callback function for WalkAll.  Return true to keep walking,
+     or false to stop.
+     @param stats Statistics of one instrumented mutex.
+     @param data Whatever pointer was passed into WalkAll.
+     */
+    typedef bool ( * StatsVisitor )( const volatile MutexStats & stats, void * data );
+
+    /** Calls visitor once for each live instrumented mutex.  This holds the
+     registry lock while walking, so a visitor must not construct or destroy
+     any instrumented mutex, and should return quickly.
+     @return Number of mutexes visited.
+     */
+    static unsigned int WalkAll( StatsVisitor visitor, void * data );
+
+    /// Returns the level of the mutex these statistics belong to.
+    inline unsigned int GetLevel( void ) const volatile { return m_level; }
+
+    /// Returns how many times the mutex was acquired.
+    inline unsigned int GetAcquireCount( void ) const volatile { return m_acquireCount; }
+
+    /// Returns how many acquisitions had to wait for another thread.
+    inline unsigned int GetContendedCount( void ) const volatile { return m_contendedCount; }
+
+    /// Returns total micro-seconds threads spent waiting to acquire.
+    inline MicroSeconds GetTotalWaitTime( void ) const volatile { return m_totalWaitTime; }
+
+    /// Returns total micro-seconds the mutex was held.
+    inline MicroSeconds GetTotalHoldTime( void ) const volatile { return m_totalHoldTime; }
+
+    /// Returns the longest single hold in micro-seconds.
+    inline MicroSeconds GetMaxHoldTime( void ) const volatile { return m_maxHoldTime; }
+
+    /// Returns the current time in micro-seconds of wall-clock time.
+    static MicroSeconds Now( void );
+
+protected:
+
+    /// Constructs the statistics and adds them to the global registry.
+    explicit MutexStats( unsigned int level );
+
+    /// Removes the statistics from the global registry.
+    ~MutexStats( void );
+
+    /// Records one acquisition and how long the acquiring thread waited.
+    void RecordAcquire( MicroSeconds waited, bool contended ) volatile;
+
+    /// Records the release of the mutex and accumulates the hold time.
+    void RecordRelease( void ) volatile;
+
+private:
+
+    /// Copy constructor is not implemented.
+    MutexStats( const MutexStats & );
+    /// Copy-assignment operator is not implemented.
+    MutexStats & operator = ( const MutexStats & );
+
+    /// Head of the global registry of live instrumented mutexes.
+    static MutexStats * s_head;
+
+    /// Level of the associated mutex.
+    const unsigned int m_level;
+    /// How many times the mutex was acquired.
+    unsigned int m_acquireCount;
+    /// How many acquisitions found the mutex held by another thread.
+    unsigned int m_contendedCount;
+    /// Total micro-seconds spent waiting to acquire.
+    MicroSeconds m_totalWaitTime;
+    /// Total micro-seconds the mutex was held.
+    MicroSeconds m_totalHoldTime;
+    /// Longest single hold in micro-seconds.
+    MicroSeconds m_maxHoldTime;
+    /// Moment the current hold began.
+    MicroSeconds m_lockedAt;
+    /// Next statistics object in the registry.
+    MutexStats * m_next;
+    /// Previous statistics object in the registry.
+    MutexStats * m_prev;
+
+}; // end class MutexStats
+
+// ----------------------------------------------------------------------------
+
+/** @class StatsLevelMutex
+ Decorator that instruments any levelized mutex policy with contention
+ statistics.  It forwards Lock, TryLock, and Unlock to the wrapped policy
+ and records acquisition count, contended-acquire count, wait time, and
+ hold times in its MutexStats base, which also registers the instance for
+ MutexStats::WalkAll.  Use it as the MutexPolicy of LevelMutex when you
+ need to find out which mutex a degraded service is queueing on:
+     typedef ::Loki::LevelMutex< ::Loki::StatsLevelMutex<
+         ::Loki::SpinLevelMutex >, 100 > MyMutexType;
+ The statistics of a locked LevelMutex are reachable through
+ GetMutexPolicy().
+
+ Hold times are recorded just before the wrapped policy unlocks, while the
+ calling thread still owns the mutex, so the counters never race.
+ */
+template < class LevelMutexPolicy >
+class StatsLevelMutex : public LevelMutexPolicy, public MutexStats
+{
+public:
+
+    /// Constructs an instrumented mutex of the given level.
+    explicit StatsLevelMutex( unsigned int level ) :
+        LevelMutexPolicy( level ),
+        MutexStats( level )
+    {
+    }
+
+    /// Destructs the mutex, removing its statistics from the registry.
+    virtual ~StatsLevelMutex( void )
+    {
+    }
+
+    virtual MutexErrors::Type Lock( void ) volatile
+    {
+        // Try first so an uncontended acquire is not counted as a wait.
+        MutexErrors::Type result = LevelMutexPolicy::TryLock();
+        if ( MutexErrors::Success == result )
+        {
+            RecordAcquire( 0, false );
+            return result;
+        }
+        if ( MutexErrors::TryFailed != result )
+            return result;
+        const MicroSeconds start = Now();
+        result = LevelMutexPolicy::Lock();
+        if ( MutexErrors::Success == result )
+            RecordAcquire( Now() - start, true );
+        return result;
+    }
+
+    virtual MutexErrors::Type TryLock( void ) volatile
+    {
+        const MutexErrors::Type result = LevelMutexPolicy::TryLock();
+        if ( MutexErrors::Success == result )
+            RecordAcquire( 0, false );
+        return result;
+    }
+
+    virtual MutexErrors::Type Unlock( void ) volatile
+    {
+        RecordRelease();
+        return LevelMutexPolicy::Unlock();
+    }
+
+private:
+
+    /// Default constructor is not implemented.
+    StatsLevelMutex( void );
+    /// Copy constructor is not implemented.
+    StatsLevelMutex( const StatsLevelMutex & );
+    /// Copy-assignment operator is not implemented.
+    StatsLevelMutex & operator = ( const StatsLevelMutex & );
+
+}; // end class StatsLevelMutex
+
+// ----------------------------------------------------------------------------
+
 /** @class LevelMutex
  Levelized mutex class prevents deadlocks by requiring programs to lock mutexes in
  the same order, and unlock them in reverse order.  This is accomplished by forcing
@@ -886,6 +1323,88 @@ public:
         return result;
     }
 
+    /** Locks the mutex for shared, read-only access.  Any number of threads
+     may hold the same mutex shared at once, so readers no longer queue
+     behind one another, while Lock remains exclusive and waits for all
+     shared holders to release.  The level rules are the same as for Lock:
+     this mutex's level must be below the calling thread's current level,
+     whether that level came from an exclusive or a shared lock.  A thread
+     may re-acquire its most recent shared lock.  Upgrading a shared lock to
+     exclusive (or downgrading) is not supported - the level checks reject
+     both.  Shared locks must be released with UnlockShared in reverse
+     acquisition order.  This function requires a MutexPolicy that provides
+     LockShared, such as ReadWriteLevelMutex; with an exclusive-only policy
+     this function simply must not be called, and no code gets made for it
+     unless it is called.
+     @return An error condition if any occurred, else Success.
+     */
+    MutexErrors::Type LockShared( void ) volatile
+    {
+        assert( IsValid() );
+        LOKI_MUTEX_DEBUG_CODE( Checker checker( this ); (void)checker; )
+
+        MutexErrors::Type result = SharedLevelTracker::PreShareCheck( this );
+        if ( MutexErrors::Success == result )
+            return MutexErrors::Success;
+        else if ( MutexErrors::NoProblem != result )
+            return EP::CheckError( result, GetLevel() );
+
+        result = m_mutex.LockShared();
+        if ( MutexErrors::Success != result )
+            return EP::CheckError( result, GetLevel() );
+        SharedLevelTracker::PostShare( this );
+
+        return MutexErrors::Success;
+    }
+
+    /** Tries to lock the mutex for shared access, and returns TryFailed
+     rather than waiting if a writer holds the mutex.  Otherwise behaves
+     like LockShared.
+     @return An error condition if any occurred, else Success.
+     */
+    MutexErrors::Type TryLockShared( void ) volatile
+    {
+        assert( IsValid() );
+        LOKI_MUTEX_DEBUG_CODE( Checker checker( this ); (void)checker; )
+
+        MutexErrors::Type result = SharedLevelTracker::PreShareCheck( this );
+        if ( MutexErrors::Success == result )
+            return MutexErrors::Success;
+        else if ( MutexErrors::NoProblem != result )
+            return EP::CheckError( result, GetLevel() );
+
+        result = m_mutex.TryLockShared();
+        if ( MutexErrors::TryFailed == result )
+            return result;
+        if ( MutexErrors::Success != result )
+            return EP::CheckError( result, GetLevel() );
+        SharedLevelTracker::PostShare( this );
+
+        return MutexErrors::Success;
+    }
+
+    /** Releases a shared lock acquired by LockShared or TryLockShared.
+     @return An error condition if any occurred, else Success.
+     */
+    MutexErrors::Type UnlockShared( void ) volatile
+    {
+        assert( IsValid() );
+        LOKI_MUTEX_DEBUG_CODE( Checker checker( this ); (void)checker; )
+
+        MutexErrors::Type result = SharedLevelTracker::PreUnshareCheck( this );
+        if ( MutexErrors::Success == result )
+            return MutexErrors::Success;
+        else if ( MutexErrors::NoProblem != result )
+            return EP::CheckError( result, GetLevel() );
+
+        result = m_mutex.UnlockShared();
+        if ( MutexErrors::Success != result )
+            return EP::CheckError( result, GetLevel() );
+        SharedLevelTracker::PostUnshare();
+
+        return MutexErrors::Success;
+    }
+
 private:
 
     /// Copy constructor is not implemented since mutexes don't get copied.
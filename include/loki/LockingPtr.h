@@ -22,6 +22,9 @@
 // $Id: LockingPtr.h 840 2008-03-19 19:44:38Z rich_sposato $
 
 
+#include <cassert>
+#include <utility>
+
 #include <loki/ConstPolicy.h>
 #include <loki/Threads.h>
 
@@ -104,6 +107,181 @@ namespace Loki
 
     }; // end class LockingPtr
 
+
+    /** @class ReadLockingPtr
+     Locks a volatile object for shared (read-only) access and casts away
+     volatility.  With a reader-capable LockingPolicy - RWMutex, or the
+     mutex of an ObjectLevelReadWriteLockable host - any number of
+     ReadLockingPtr holders run concurrently, where LockingPtr would
+     serialize them; with a plain Mutex the shared lock degrades to the
+     exclusive one and behavior matches LockingPtr.  Access through this
+     pointer is const, since other readers may hold the lock too.
+     The LockingPolicy must provide ReadLock and ReadUnlock methods.
+     */
+    template < typename SharedObject, typename LockingPolicy = LOKI_DEFAULT_MUTEX,
+               template<class> class ConstPolicy = LOKI_DEFAULT_CONSTNESS >
+    class ReadLockingPtr
+    {
+    public:
+
+        typedef typename ConstPolicy<SharedObject>::Type ConstOrNotType;
+
+        /** Constructor takes the shared lock of the mutex associated with
+         an object.
+         @param object Reference to object.
+         @param mutex Mutex used to control thread access to object.
+         */
+        ReadLockingPtr( volatile ConstOrNotType & object, LockingPolicy & mutex )
+           : pObject_( const_cast< const SharedObject * >( &object ) ),
+            pMutex_( &mutex )
+        {
+            mutex.ReadLock();
+        }
+
+        typedef typename std::pair<volatile ConstOrNotType *, LockingPolicy *> Pair;
+
+        /** Constructor takes the shared lock of the mutex associated with
+         an object.
+         @param lockpair a std::pair of pointers to the object and the mutex
+         */
+        ReadLockingPtr( Pair lockpair )
+           : pObject_( const_cast< const SharedObject * >( lockpair.first ) ),
+            pMutex_( lockpair.second )
+        {
+            lockpair.second->ReadLock();
+        }
+
+        /// Destructor releases the shared lock.
+        ~ReadLockingPtr()
+        {
+            pMutex_->ReadUnlock();
+        }
+
+        /// Star-operator dereferences pointer.
+        const SharedObject & operator * ()
+        {
+            return *pObject_;
+        }
+
+        /// Point-operator returns pointer to object.
+        const SharedObject * operator -> ()
+        {
+            return pObject_;
+        }
+
+    private:
+
+        /// Default constructor is not implemented.
+        ReadLockingPtr();
+
+        /// Copy-constructor is not implemented.
+        ReadLockingPtr( const ReadLockingPtr & );
+
+        /// Copy-assignment-operator is not implemented.
+        ReadLockingPtr & operator = ( const ReadLockingPtr & );
+
+        /// Pointer to the shared object.
+        const SharedObject * pObject_;
+
+        /// Pointer to the mutex.
+        LockingPolicy * pMutex_;
+
+    }; // end class ReadLockingPtr
+
+
+    /** @class TryLockingPtr
+     Like LockingPtr, but fails fast instead of blocking: the constructor
+     probes the mutex once, and Acquired reports whether the lock was
+     taken.  A latency-critical path can thereby skip a contended object
+     rather than wait behind its current owner.  Dereferencing is only
+     legal after Acquired returned true; the destructor unlocks only when
+     the lock was actually taken, so an unacquired TryLockingPtr is
+     harmless to destroy.  The LockingPolicy must provide TryLock and
+     Unlock methods.
+     */
+    template < typename SharedObject, typename LockingPolicy = LOKI_DEFAULT_MUTEX,
+               template<class> class ConstPolicy = LOKI_DEFAULT_CONSTNESS >
+    class TryLockingPtr
+    {
+    public:
+
+        typedef typename ConstPolicy<SharedObject>::Type ConstOrNotType;
+
+        /** Constructor probes the mutex associated with an object without
+         blocking; check Acquired before dereferencing.
+         @param object Reference to object.
+         @param mutex Mutex used to control thread access to object.
+         */
+        TryLockingPtr( volatile ConstOrNotType & object, LockingPolicy & mutex )
+           : pObject_( 0 ),
+            pMutex_( &mutex )
+        {
+            if ( mutex.TryLock() )
+                pObject_ = const_cast< SharedObject * >( &object );
+        }
+
+        typedef typename std::pair<volatile ConstOrNotType *, LockingPolicy *> Pair;
+
+        /** Constructor probes the mutex associated with an object without
+         blocking; check Acquired before dereferencing.
+         @param lockpair a std::pair of pointers to the object and the mutex
+         */
+        TryLockingPtr( Pair lockpair )
+           : pObject_( 0 ),
+            pMutex_( lockpair.second )
+        {
+            if ( lockpair.second->TryLock() )
+                pObject_ = const_cast< SharedObject * >( lockpair.first );
+        }
+
+        /// Destructor unlocks the mutex if the constructor acquired it.
+        ~TryLockingPtr()
+        {
+            if ( 0 != pObject_ )
+                pMutex_->Unlock();
+        }
+
+        /// Returns true when the constructor acquired the lock.
+        bool Acquired() const
+        {
+            return 0 != pObject_;
+        }
+
+        /// Star-operator dereferences pointer.  Only call after Acquired
+        /// returned true.
+        ConstOrNotType & operator * ()
+        {
+            assert( 0 != pObject_ );
+            return *pObject_;
+        }
+
+        /// Point-operator returns pointer to object.  Only call after
+        /// Acquired returned true.
+        ConstOrNotType * operator -> ()
+        {
+            assert( 0 != pObject_ );
+            return pObject_;
+        }
+
+    private:
+
+        /// Default constructor is not implemented.
+        TryLockingPtr();
+
+        /// Copy-constructor is not implemented.
+        TryLockingPtr( const TryLockingPtr & );
+
+        /// Copy-assignment-operator is not implemented.
+        TryLockingPtr & operator = ( const TryLockingPtr & );
+
+        /// Pointer to the shared object; zero when the lock was not taken.
+        ConstOrNotType * pObject_;
+
+        /// Pointer to the mutex.
+        LockingPolicy * pMutex_;
+
+    }; // end class TryLockingPtr
+
 } // namespace Loki
 
 #endif // end file guardian
@@ -55,6 +55,35 @@ namespace Loki
                 return exec.Fire(rhs, lhs);
             }
         };
+
+////////////////////////////////////////////////////////////////////////////////
+// class template SwappedDispatch (helper)
+// Calls a dispatch callback with its two arguments exchanged, which is
+// only expressible when both base types are the same - the case where
+// symmetric dispatch makes sense.  The primary template keeps dispatchers
+// with distinct base types compiling and throws if ever reached, which
+// can only happen through a misuse of AddSymmetric on such a dispatcher.
+////////////////////////////////////////////////////////////////////////////////
+
+        template <typename ResultType, class CallbackType,
+            class BaseLhs, class BaseRhs>
+        struct SwappedDispatch
+        {
+            static ResultType Go(CallbackType&, BaseLhs&, BaseRhs&)
+            {
+                throw std::runtime_error(
+                    "Symmetric dispatch requires BaseLhs == BaseRhs");
+            }
+        };
+
+        template <typename ResultType, class CallbackType, class Base>
+        struct SwappedDispatch<ResultType, CallbackType, Base, Base>
+        {
+            static ResultType Go(CallbackType& fun, Base& lhs, Base& rhs)
+            {
+                return fun(rhs, lhs);
+            }
+        };
     }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -118,10 +147,123 @@ namespace Loki
         { return DispatchLhs(lhs, rhs, exec, TypesLhs()); }
     };
     
+////////////////////////////////////////////////////////////////////////////////
+// class template MatrixDispatcher
+// Implements a constant-time static double dispatcher based on two typelists
+// Where StaticDispatcher walks a chain of dynamic_casts whose cost grows
+// with the typelist, MatrixDispatcher indexes a flat two-dimensional table
+// of trampoline functions with a dense class id, so dispatch is two virtual
+// calls, two bounds checks and one indexed call regardless of hierarchy
+// size.  The price is a hook: every class in TypesLhs/TypesRhs must
+// override
+//     virtual unsigned int GetImplId() const;
+// on its base to return the class's zero-based position in the typelist,
+// e.g.  return TL::IndexOf<Types, MyClass>::value;
+// The trampolines downcast with static_cast, so the classes must derive
+// from their base non-virtually.  An id outside the table (a class missing
+// from the typelist) is routed to Executor::OnError, like a failed cast in
+// StaticDispatcher.  The table is filled on the first call; the fill is
+// idempotent, so concurrent first calls are harmless.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class Executor,
+        class BaseLhs, 
+        class TypesLhs,
+        bool symmetric = true,
+        class BaseRhs = BaseLhs,
+        class TypesRhs = TypesLhs,
+        typename ResultType = void
+    >
+    class MatrixDispatcher
+    {
+        typedef ResultType (*Trampoline)(BaseLhs&, BaseRhs&, Executor&);
+
+        enum
+        {
+            lhsCount = TL::Length<TypesLhs>::value,
+            rhsCount = TL::Length<TypesRhs>::value
+        };
+
+        template <class SomeLhs, class SomeRhs>
+        static ResultType Trampo(BaseLhs& lhs, BaseRhs& rhs, Executor& exec)
+        {
+            SomeLhs& l = static_cast<SomeLhs&>(lhs);
+            SomeRhs& r = static_cast<SomeRhs&>(rhs);
+
+            Int2Type<(symmetric &&
+                      int(TL::IndexOf<TypesRhs, SomeRhs>::value) <
+                      int(TL::IndexOf<TypesLhs, SomeLhs>::value))> i2t;
+
+            typedef Private::InvocationTraits<
+                    SomeLhs, SomeRhs, Executor, ResultType> CallTraits;
+
+            return CallTraits::DoDispatch(l, r, exec, i2t);
+        }
+
+        struct Matrix
+        {
+            Trampoline entries[lhsCount][rhsCount];
+
+            Matrix()
+            {
+                FillLhs(TypesLhs());
+            }
+
+            void FillLhs(NullType)
+            {}
+
+            template <class Head, class Tail>
+            void FillLhs(Typelist<Head, Tail>)
+            {
+                FillRhs<Head>(TypesRhs());
+                FillLhs(Tail());
+            }
+
+            template <class SomeLhs>
+            void FillRhs(NullType)
+            {}
+
+            template <class SomeLhs, class Head, class Tail>
+            void FillRhs(Typelist<Head, Tail>)
+            {
+                entries[TL::IndexOf<TypesLhs, SomeLhs>::value]
+                       [TL::IndexOf<TypesRhs, Head>::value] =
+                    &MatrixDispatcher::template Trampo<SomeLhs, Head>;
+                FillRhs<SomeLhs>(Tail());
+            }
+        };
+
+        static const Matrix& GetMatrix()
+        {
+            static const Matrix matrix;
+            return matrix;
+        }
+
+    public:
+        static ResultType Go(BaseLhs& lhs, BaseRhs& rhs,
+            Executor exec)
+        {
+            const unsigned int l = lhs.GetImplId();
+            const unsigned int r = rhs.GetImplId();
+            if (l >= unsigned(lhsCount) || r >= unsigned(rhsCount))
+                return exec.OnError(lhs, rhs);
+            return GetMatrix().entries[l][r](lhs, rhs, exec);
+        }
+    };
+    
 ////////////////////////////////////////////////////////////////////////////////
 // class template BasicDispatcher
 // Implements a logarithmic double dispatcher for functors (or functions)
-// Doesn't offer automated casts or symmetry
+// Doesn't offer automated casts; symmetry is available via AddSymmetric,
+// which keeps one canonical entry per unordered type pair
+// Go() keeps a one-entry cache of the last dispatched type pair and a flat
+// direct-mapped index hashed over the type_info addresses, so repeated
+// dispatch on the same concrete types is a pointer compare and a direct
+// call instead of an ordered search through callbackMap_.  Both caches are
+// rebuilt from callbackMap_ as needed and cleared by Add and Remove, and
+// like the rest of the dispatcher they are not safe for concurrent use.
 ////////////////////////////////////////////////////////////////////////////////
 
     template
@@ -134,14 +276,73 @@ namespace Loki
     class BasicDispatcher
     {
         typedef std::pair<TypeInfo,TypeInfo> KeyType;
-        typedef CallbackType MappedType;
+
+        // One registered handler.  An exact entry fires only on its ordered
+        // key.  A symmetric entry is stored once, under the canonical
+        // (sorted) ordering of its two types, and fires for both argument
+        // orders; lhsFirst records whether the callback's arguments were
+        // registered in canonical order, so Go knows when to swap them back.
+        struct Handler
+        {
+            CallbackType fun;
+            bool symmetric;
+            bool lhsFirst;
+        };
+        typedef Handler MappedType;
         typedef AssocVector<KeyType, MappedType> MapType;
+
+        // One resolved dispatch: the type_info addresses seen at the call
+        // and the handler they resolved to, with the swap already decided.
+        // Address equality is a cache
+        // hit; an address mismatch just falls through to callbackMap_,
+        // which compares by name, so shared-library aliasing of type_info
+        // objects costs speed but never correctness.
+        struct CacheEntry
+        {
+            const std::type_info* lhs;
+            const std::type_info* rhs;
+            CallbackType fun;
+            bool swap;
+        };
+        typedef std::vector<CacheEntry> CacheType;
+
         MapType callbackMap_;
+        CacheType cache_;
+        CacheEntry last_;
         
         void DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun);
+        void DoAddSymmetric(TypeInfo lhs, TypeInfo rhs, CallbackType fun);
         bool DoRemove(TypeInfo lhs, TypeInfo rhs);
-        
+        void ClearCache();
+
+        ResultType Dispatch(CacheEntry& entry, BaseLhs& lhs, BaseRhs& rhs)
+        {
+            if (entry.swap)
+                return Private::SwappedDispatch<ResultType, CallbackType,
+                    BaseLhs, BaseRhs>::Go(entry.fun, lhs, rhs);
+            return (entry.fun)(lhs, rhs);
+        }
+        ResultType GoSlow(BaseLhs& lhs, BaseRhs& rhs,
+            const std::type_info* lhsType, const std::type_info* rhsType);
+
+        static std::size_t HashTypes(const std::type_info* lhs,
+            const std::type_info* rhs)
+        {
+            // the low bits of type_info addresses are alignment padding,
+            // so shift them out before mixing the two pointers
+            const std::size_t l = reinterpret_cast<std::size_t>(lhs) >> 4;
+            const std::size_t r = reinterpret_cast<std::size_t>(rhs) >> 4;
+            return l ^ (r * 2654435761UL);
+        }
+
     public:
+        BasicDispatcher() : callbackMap_(), cache_()
+        {
+            last_.lhs = 0;
+            last_.rhs = 0;
+            last_.swap = false;
+        }
+
         template <class SomeLhs, class SomeRhs>
         void Add(CallbackType fun)
         {
@@ -153,7 +354,31 @@ namespace Loki
         {
             return DoRemove(typeid(SomeLhs), typeid(SomeRhs));
         }
-        
+
+        // Registers fun once for the unordered pair {SomeLhs, SomeRhs}.
+        // Where symmetric handlers are otherwise Added under both ordered
+        // keys, this stores one entry under the canonical ordering of the
+        // two types - half the table - and Go calls fun with the arguments
+        // swapped back when they arrive in the other order.  fun takes its
+        // arguments in the registration order <SomeLhs, SomeRhs>.  Only
+        // meaningful on dispatchers where BaseLhs and BaseRhs are the same
+        // type.
+        template <class SomeLhs, class SomeRhs>
+        void AddSymmetric(CallbackType fun)
+        {
+            DoAddSymmetric(typeid(SomeLhs), typeid(SomeRhs), fun);
+        }
+
+        // Removes a handler registered with AddSymmetric; the type pair
+        // may be named in either order.
+        template <class SomeLhs, class SomeRhs>
+        bool RemoveSymmetric()
+        {
+            const TypeInfo lhs(typeid(SomeLhs));
+            const TypeInfo rhs(typeid(SomeRhs));
+            return rhs < lhs ? DoRemove(rhs, lhs) : DoRemove(lhs, rhs);
+        }
+
         ResultType Go(BaseLhs& lhs, BaseRhs& rhs);
     };
 
@@ -163,7 +388,27 @@ namespace Loki
     void BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
          ::DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun)
     {
-        callbackMap_[KeyType(lhs, rhs)] = fun;
+        Handler handler;
+        handler.fun = fun;
+        handler.symmetric = false;
+        handler.lhsFirst = true;
+        callbackMap_[KeyType(lhs, rhs)] = handler;
+        ClearCache();
+    }
+
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    void BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+         ::DoAddSymmetric(TypeInfo lhs, TypeInfo rhs, CallbackType fun)
+    {
+        const bool canonical = !(rhs < lhs);
+        Handler handler;
+        handler.fun = fun;
+        handler.symmetric = true;
+        handler.lhsFirst = canonical;
+        callbackMap_[canonical ? KeyType(lhs, rhs) : KeyType(rhs, lhs)] =
+            handler;
+        ClearCache();
     }
         
     template <class BaseLhs, class BaseRhs, 
@@ -171,21 +416,231 @@ namespace Loki
     bool BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
          ::DoRemove(TypeInfo lhs, TypeInfo rhs)
     {
+        ClearCache();
         return callbackMap_.erase(KeyType(lhs, rhs)) == 1;
     }
 
     template <class BaseLhs, class BaseRhs, 
         typename ResultType, typename CallbackType>
-    ResultType BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+    void BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+         ::ClearCache()
+    {
+        last_.lhs = 0;
+        last_.rhs = 0;
+        last_.swap = false;
+        cache_.clear();
+    }
+
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    inline ResultType BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
                ::Go(BaseLhs& lhs, BaseRhs& rhs)
     {
-        typename MapType::key_type k(typeid(lhs),typeid(rhs));
+        const std::type_info* const lhsType = &typeid(lhs);
+        const std::type_info* const rhsType = &typeid(rhs);
+        // fast path: same type pair as the previous dispatch
+        if (last_.lhs == lhsType && last_.rhs == rhsType)
+            return Dispatch(last_, lhs, rhs);
+        return GoSlow(lhs, rhs, lhsType, rhsType);
+    }
+
+    // Non-inline to keep the fast path in Go small...
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    ResultType BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+               ::GoSlow(BaseLhs& lhs, BaseRhs& rhs,
+                   const std::type_info* lhsType, const std::type_info* rhsType)
+    {
+        if (!cache_.empty())
+        {
+            CacheEntry& slot =
+                cache_[HashTypes(lhsType, rhsType) & (cache_.size() - 1)];
+            if (slot.lhs == lhsType && slot.rhs == rhsType)
+            {
+                last_ = slot;
+                return Dispatch(slot, lhs, rhs);
+            }
+        }
+
+        typename MapType::key_type k(*lhsType, *rhsType);
         typename MapType::iterator i = callbackMap_.find(k);
+        bool swap = false;
+        if (i != callbackMap_.end())
+        {
+            // a symmetric entry found by exact key is stored in canonical
+            // order; swap if the callback was registered the other way
+            swap = i->second.symmetric && !i->second.lhsFirst;
+        }
+        else if (k.second < k.first)
+        {
+            // the runtime pair is reversed relative to canonical order, so
+            // a symmetric entry for it would be filed under the sorted key
+            typename MapType::iterator ci =
+                callbackMap_.find(KeyType(k.second, k.first));
+            if (ci != callbackMap_.end() && ci->second.symmetric)
+            {
+                i = ci;
+                swap = i->second.lhsFirst;
+            }
+        }
         if (i == callbackMap_.end())
         {
                 throw std::runtime_error("Function not found");
         }
-        return (i->second)(lhs, rhs);
+
+        if (cache_.empty())
+        {
+            // direct-mapped table, power-of-two size, roomy enough that
+            // distinct registered pairs rarely fight over a slot
+            std::size_t size = 16;
+            while (size < 2 * callbackMap_.size())
+                size *= 2;
+            cache_.resize(size);
+        }
+        CacheEntry& slot =
+            cache_[HashTypes(lhsType, rhsType) & (cache_.size() - 1)];
+        slot.lhs = lhsType;
+        slot.rhs = rhsType;
+        slot.fun = i->second.fun;
+        slot.swap = swap;
+        last_ = slot;
+
+        return Dispatch(slot, lhs, rhs);
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+// class template FlatDispatcher
+// Alternative dispatcher backend for FnDispatcher and FunctorDispatcher,
+// tuned for write-once, read-millions tables.  Add appends to a plain
+// vector in constant amortized time; the first Go after a change sorts the
+// vector once ("freezes" it), and every lookup afterwards is a binary
+// search over one contiguous array of key/callback pairs - no per-entry
+// nodes, no rebalancing, and registration of n handlers costs one sort
+// instead of n ordered inserts.  Adding or removing after the freeze just
+// triggers another sort on the next Go.  Same interface and miss behavior
+// as BasicDispatcher (which remains the default backend and additionally
+// caches recently dispatched pairs); like it, not safe for concurrent use.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class BaseLhs,
+        class BaseRhs = BaseLhs,
+        typename ResultType = void,
+        typename CallbackType = ResultType (*)(BaseLhs&, BaseRhs&)
+    >
+    class FlatDispatcher
+    {
+        typedef std::pair<TypeInfo,TypeInfo> KeyType;
+        typedef CallbackType MappedType;
+
+        struct Entry
+        {
+            KeyType key;
+            MappedType fun;
+        };
+        typedef std::vector<Entry> TableType;
+
+        struct EntryLess
+        {
+            bool operator()(const Entry& lhs, const Entry& rhs) const
+            { return lhs.key < rhs.key; }
+            bool operator()(const Entry& lhs, const KeyType& rhs) const
+            { return lhs.key < rhs; }
+        };
+
+        TableType table_;
+        bool frozen_;
+
+        void Freeze();
+        void DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun);
+        bool DoRemove(TypeInfo lhs, TypeInfo rhs);
+
+    public:
+        FlatDispatcher() : table_(), frozen_(true)
+        {}
+
+        template <class SomeLhs, class SomeRhs>
+        void Add(CallbackType fun)
+        {
+            DoAdd(typeid(SomeLhs), typeid(SomeRhs), fun);
+        }
+
+        template <class SomeLhs, class SomeRhs>
+        bool Remove()
+        {
+            return DoRemove(typeid(SomeLhs), typeid(SomeRhs));
+        }
+
+        ResultType Go(BaseLhs& lhs, BaseRhs& rhs);
+    };
+
+    // Non-inline to reduce compile time overhead...
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    void FlatDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+         ::Freeze()
+    {
+        // stable sort, then keep the last entry of every run of equal
+        // keys, so of several Adds for one pair the latest wins - the
+        // same overwrite semantics a map assignment gives
+        std::stable_sort(table_.begin(), table_.end(), EntryLess());
+        typename TableType::size_type out = 0;
+        for (typename TableType::size_type i = 0; i < table_.size(); ++i)
+        {
+            if (i + 1 < table_.size() && table_[i].key == table_[i + 1].key)
+                continue;
+            if (out != i)
+                table_[out] = table_[i];
+            ++out;
+        }
+        table_.resize(out);
+        frozen_ = true;
+    }
+
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    void FlatDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+         ::DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun)
+    {
+        Entry entry;
+        entry.key = KeyType(lhs, rhs);
+        entry.fun = fun;
+        table_.push_back(entry);
+        frozen_ = false;
+    }
+
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    bool FlatDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+         ::DoRemove(TypeInfo lhs, TypeInfo rhs)
+    {
+        if (!frozen_)
+            Freeze();
+        const KeyType k(lhs, rhs);
+        typename TableType::iterator i =
+            std::lower_bound(table_.begin(), table_.end(), k, EntryLess());
+        if (i == table_.end() || !(i->key == k))
+            return false;
+        table_.erase(i);
+        return true;
+    }
+
+    template <class BaseLhs, class BaseRhs, 
+        typename ResultType, typename CallbackType>
+    ResultType FlatDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
+               ::Go(BaseLhs& lhs, BaseRhs& rhs)
+    {
+        if (!frozen_)
+            Freeze();
+        const KeyType k(typeid(lhs), typeid(rhs));
+        typename TableType::iterator i =
+            std::lower_bound(table_.begin(), table_.end(), k, EntryLess());
+        if (i == table_.end() || !(i->key == k))
+        {
+                throw std::runtime_error("Function not found");
+        }
+        return (i->fun)(lhs, rhs);
     }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -279,6 +734,25 @@ namespace Loki
             Add<SomeLhs, SomeRhs>(&Local::Trampoline);
         }
         
+        // Symmetric registration as a single canonical table entry (see
+        // BasicDispatcher::AddSymmetric), instead of the two mirrored
+        // entries the symmetric Add below inserts.  Requires a backend
+        // with AddSymmetric and BaseLhs == BaseRhs.
+        template <class SomeLhs, class SomeRhs,
+            ResultType (*callback)(SomeLhs&, SomeRhs&)>
+        void AddSymmetric()
+        {
+        typedef Private::FnDispatcherHelper<
+                    BaseLhs, BaseRhs, 
+                    SomeLhs, SomeRhs,
+                    ResultType,
+                    CastingPolicy<SomeLhs,BaseLhs>, 
+                    CastingPolicy<SomeRhs,BaseRhs>, 
+                    callback> Local;
+
+            backEnd_.template AddSymmetric<SomeLhs, SomeRhs>(&Local::Trampoline);
+        }
+
         template <class SomeLhs, class SomeRhs,
             ResultType (*callback)(SomeLhs&, SomeRhs&),
             bool symmetric>
@@ -376,6 +850,25 @@ namespace Loki
 
             backEnd_.template Add<SomeLhs, SomeRhs>(FunctorType(Adapter(fun)));
     }
+        // Symmetric registration as a single canonical table entry (see
+        // BasicDispatcher::AddSymmetric), instead of the two mirrored
+        // entries the symmetric Add below inserts.  Requires a backend
+        // with AddSymmetric and BaseLhs == BaseRhs.
+        template <class SomeLhs, class SomeRhs, class Fun>
+        void AddSymmetric(const Fun& fun)
+        {
+            typedef Private::FunctorDispatcherHelper<
+                    BaseLhs, BaseRhs,
+                    SomeLhs, SomeRhs,
+                    ResultType,
+                    CastingPolicy<SomeLhs, BaseLhs>,
+                    CastingPolicy<SomeRhs, BaseRhs>,
+                    Fun, false> Adapter;
+
+            backEnd_.template AddSymmetric<SomeLhs, SomeRhs>(
+                FunctorType(Adapter(fun)));
+        }
+
         template <class SomeLhs, class SomeRhs, bool symmetric, class Fun>
         void Add(const Fun& fun)
         {
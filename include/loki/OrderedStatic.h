@@ -25,8 +25,23 @@
 
 // usage: see test/OrderedStatic
 
+////////////////////////////////////////////////////////////////////////////////
+// LOKI_ORDERED_STATIC_RESERVE
+// Capacity of the statically allocated registration buffer inside
+// OrderedStaticManagerClass.  Registrations run before main while the heap
+// is cold, so as long as a program declares no more ordered statics than
+// this, registering them allocates nothing; beyond it the registry falls
+// back to a heap vector.  Override on the compiler command line to match
+// programs with unusually many ordered statics.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LOKI_ORDERED_STATIC_RESERVE
+#define LOKI_ORDERED_STATIC_RESERVE 256
+#endif
+
 namespace Loki
 {
+    class ThreadPool;
+
     namespace Private
     {
         ////////////////////////////////////////////////////////////////////////////////
@@ -89,6 +104,79 @@ namespace Loki
             
         };
 
+        ////////////////////////////////////////////////////////////////////////////////
+        // template base class for LazyOrderedStatic template,
+        // common for all specializations.
+        // The slot is registered like any other ordered static, but
+        // createObjects() leaves it alone - the object is built on the
+        // first dereference instead, with double-checked locking, so
+        // objects on cold paths never pay their construction cost.
+        ////////////////////////////////////////////////////////////////////////////////
+        template<class T>
+        class LazyOrderedStaticBase : public OrderedStaticCreatorFunc
+        {
+            typedef LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL<T*> CreationGuard;
+
+        public:
+            T& operator*()
+            {
+                return *GetObject();
+            }
+
+            T* operator->()
+            {
+                return GetObject();
+            }
+
+            // called by OrderedStaticManagerClass::createObjects(), 
+            // does nothing for a lazy static - creation waits for
+            // the first dereference
+            void createObject()
+            {
+            }
+
+        protected:
+
+            LazyOrderedStaticBase(unsigned int longevity) : val_(0), longevity_(longevity)
+            {
+            }
+
+            virtual ~LazyOrderedStaticBase()
+            {
+            }
+
+            // creates the object, implemented by the specializations
+            virtual T* MakeObject() = 0;
+
+        private:
+            LazyOrderedStaticBase();
+            LazyOrderedStaticBase(const LazyOrderedStaticBase&);
+            LazyOrderedStaticBase& operator=(const LazyOrderedStaticBase&);
+
+            T* GetObject()
+            {
+                // load-acquire pairs with the store-release below, so once
+                // the object exists no dereference ever takes the lock
+                T* object = CreationGuard::AtomicLoadPtrAcquire(val_);
+                if(!object)
+                {
+                    typename CreationGuard::Lock guard;
+                    (void)guard;
+                    object = val_;
+                    if(!object)
+                    {
+                        object = MakeObject();
+                        CreationGuard::AtomicAssignPtrRelease(val_,object);
+                        Loki::SetLongevity(object,longevity_);
+                    }
+                }
+                return object;
+            }
+
+            typename CreationGuard::VolatileType val_;
+            unsigned int longevity_;
+        };
+
         ////////////////////////////////////////////////////////////////////////////////
         // OrderedStaticManagerClass implements details 
         // OrderedStaticManager is then defined as a Singleton
@@ -102,21 +190,50 @@ namespace Loki
             typedef void (OrderedStaticCreatorFunc::*Creator)();
 
             void createObjects();
+
+            ////////////////////////////////////////////////////////////////////////////////
+            // Creates the registered objects with statics at the same
+            // longevity level running concurrently on the given pool, while
+            // levels still run strictly in longevity order - each level
+            // finishes before the next begins.  Useful when creators do
+            // slow I/O, so startup shrinks to the critical path per level.
+            // Creators run in parallel must not throw (the pool swallows
+            // exceptions) and must not register further ordered statics,
+            // and the program must be built with a Loki threading model.
+            ////////////////////////////////////////////////////////////////////////////////
+            void createObjects(ThreadPool& pool);
+
             void registerObject(unsigned int longevity,OrderedStaticCreatorFunc*,Creator);
 
         private:
             OrderedStaticManagerClass(const OrderedStaticManagerClass&);
             OrderedStaticManagerClass& operator=(const OrderedStaticManagerClass&);
             
+            // kept a POD so the preallocated_ array below is
+            // zero-initialized in static storage before any translation
+            // unit starts registering ordered statics
             struct Data
             {
-                Data(unsigned int,OrderedStaticCreatorFunc*, Creator);
                 unsigned int longevity;
                 OrderedStaticCreatorFunc* object;
                 Creator creator;
             };
 
-            std::vector<Data> staticObjects_;
+            // answers createObjects' loops from whichever storage is live
+            const Data* GetObjects() const
+            {
+                return overflow_.empty() ? preallocated_ : &overflow_[0];
+            }
+
+            // fixed buffer in static storage serving the first
+            // LOKI_ORDERED_STATIC_RESERVE registrations without touching
+            // the heap
+            static Data preallocated_[LOKI_ORDERED_STATIC_RESERVE];
+            // number of registered objects, in whichever storage is live
+            unsigned int count_;
+            // heap fallback once the buffer is full; the buffer's contents
+            // move here so iteration stays one contiguous array
+            std::vector<Data> overflow_;
             unsigned int max_longevity_;
             unsigned int min_longevity_;
         };
@@ -218,6 +335,99 @@ namespace Loki
         Func para_;
     };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // template LazyOrderedStatic template: 
+    // L        : longevity
+    // T        : object type
+    // TList    : creator parameters
+    //
+    // Same registration and destruction ordering as OrderedStatic, but the
+    // object is created on the first dereference instead of inside
+    // OrderedStaticManager::createObjects().  Creation is thread safe: of
+    // several threads dereferencing first, exactly one creates the object.
+    // An object which is never dereferenced is never created, so cold
+    // objects cost neither startup time nor memory.  The first dereference
+    // must happen before the program enters its exit sequence, otherwise
+    // the destruction ordering by longevity is no longer guaranteed.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<unsigned int L, class T, class TList = Loki::NullType>
+    class LazyOrderedStatic;
+
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // LazyOrderedStatic specializations
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<unsigned int L, class T>
+    class LazyOrderedStatic<L, T, Loki::NullType> : public Private::LazyOrderedStaticBase<T>
+    {
+    public:    
+        LazyOrderedStatic() : Private::LazyOrderedStaticBase<T>(L)
+        {
+            OrderedStaticManager::Instance().registerObject
+                                (L,this,&Private::OrderedStaticCreatorFunc::createObject);
+        }
+
+    private:
+        LazyOrderedStatic(const LazyOrderedStatic&);
+        LazyOrderedStatic& operator=(const LazyOrderedStatic&);
+
+        T* MakeObject()
+        {
+            return new T;
+        }
+    };
+
+    template<unsigned int L, class T, typename P1>
+    class LazyOrderedStatic<L, T, Loki::Seq<P1> > : public Private::LazyOrderedStaticBase<T>
+    {
+    public:
+        LazyOrderedStatic(P1 p) : Private::LazyOrderedStaticBase<T>(L), para_(p)
+        {
+            OrderedStaticManager::Instance().registerObject
+                                (L,this,&Private::OrderedStaticCreatorFunc::createObject);
+        }
+
+    private:
+        LazyOrderedStatic();
+        LazyOrderedStatic(const LazyOrderedStatic&);
+        LazyOrderedStatic& operator=(const LazyOrderedStatic&);
+
+        T* MakeObject()
+        {
+            return new T(para_);
+        }
+
+        P1 para_;
+    };
+
+    template<unsigned int L, class T, typename P1>
+    class LazyOrderedStatic<L, T,  P1(*)() > : public Private::LazyOrderedStaticBase<T>
+    {
+    public:
+
+        typedef P1(*Func)();
+
+        LazyOrderedStatic(Func p) : Private::LazyOrderedStaticBase<T>(L), para_(p)
+        {
+            OrderedStaticManager::Instance().registerObject
+                                (L,this,&Private::OrderedStaticCreatorFunc::createObject);
+        }
+
+    private:
+        LazyOrderedStatic();
+        LazyOrderedStatic(const LazyOrderedStatic&);
+        LazyOrderedStatic& operator=(const LazyOrderedStatic&);
+
+        T* MakeObject()
+        {
+            return new T(para_());
+        }
+
+        Func para_;
+    };
+
 }// namespace Loki
 
 
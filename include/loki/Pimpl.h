@@ -17,6 +17,10 @@
 
 ///  \defgroup PimplGroup Pimpl 
 
+#include <new>
+
+#include "SmallObj.h"
+
 #ifndef LOKI_INHERITED_PIMPL_NAME
 #define LOKI_INHERITED_PIMPL_NAME d
 #endif
@@ -28,6 +32,88 @@
 namespace Loki
 {
 
+    //////////////////////////////////////////
+    ///  \class CreateImplUsingNew
+    ///
+    ///  \ingroup PimplGroup
+    ///   Default creator policy of Pimpl:
+    ///   the implementation comes from the
+    ///   global heap, one object at a time.
+    ///
+    ///   A creator policy needs only the two
+    ///   static functions below, so a pool or
+    ///   an arena plugs in by providing its
+    ///   own policy - Destroy must undo what
+    ///   Create did.  Use CreatorPropPtr as
+    ///   the pointer then, it destroys
+    ///   through the same policy.
+    //////////////////////////////////////////
+
+    template<class T>
+    struct CreateImplUsingNew
+    {
+        static T* Create()
+        {
+            return new T;
+        }
+        static void Destroy(T* p)
+        {
+            delete p;
+        }
+    };
+
+    //////////////////////////////////////////
+    ///  \class CreateImplUsingSmallObj
+    ///
+    ///  \ingroup PimplGroup
+    ///   Creator policy drawing the
+    ///   implementation from Loki's
+    ///   small-object allocator, so waves of
+    ///   pimpl'd objects recycle pooled
+    ///   blocks instead of hammering malloc.
+    //////////////////////////////////////////
+
+    template<class T>
+    struct CreateImplUsingSmallObj
+    {
+        typedef AllocatorSingleton<> Allocator;
+
+        static T* Create()
+        {
+            void* buffer;
+            {
+                Allocator::MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                buffer = Allocator::AllocateSized< sizeof(T) >( true );
+            }
+            try
+            {
+                return new (buffer) T;
+            }
+            catch(...)
+            {
+                Free(buffer);
+                throw;
+            }
+        }
+
+        static void Destroy(T* p)
+        {
+            if(p == 0)
+                return;
+            p->~T();
+            Free(p);
+        }
+
+    private:
+        static void Free(void* buffer)
+        {
+            Allocator::MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+            Allocator::DeallocateSized< sizeof(T) >( buffer );
+        }
+    };
+
     //////////////////////////////////////////
     ///  \class ConstPropPtr
     ///
@@ -54,6 +140,35 @@ namespace Loki
     };
 
 
+    //////////////////////////////////////////
+    ///  \class CreatorPropPtr
+    ///
+    ///  \ingroup PimplGroup
+    ///   Const propagating smart pointer
+    ///   which destroys through a creator
+    ///   policy instead of calling delete.
+    ///   Pair it with the same policy given
+    ///   to Pimpl as creator.
+    //////////////////////////////////////////
+
+    template<class T, class Creator>
+    struct CreatorPropPtr
+    {
+        explicit CreatorPropPtr(T* p) : ptr_(p) {}
+        ~CreatorPropPtr() { Creator::Destroy(ptr_); ptr_ = 0; }
+        T* operator->()    { return  ptr_; }
+        T& operator*()    { return *ptr_; }
+        const T* operator->() const    { return  ptr_; }
+        const T& operator*()  const    { return *ptr_; }
+
+    private:
+        CreatorPropPtr();
+        CreatorPropPtr(const CreatorPropPtr&);
+        CreatorPropPtr& operator=(const CreatorPropPtr&);
+        T* ptr_;
+    };
+
+
     ////////////////////////////////////////////////////////////////////////////////
     ///  \class Pimpl
     ///
@@ -63,6 +178,13 @@ namespace Loki
     ///  automatically creates and deletes the implementation object and adds
     ///  const propagation to the smart pointer.
     ///  
+    ///  The creator policy controls where the implementation object comes
+    ///  from; the default allocates with new, CreateImplUsingSmallObj pools
+    ///  it.  The pointer policy must destroy the object the same way the
+    ///  creator made it - with a creator other than the default, use
+    ///  CreatorPropPtr with the same policy, or a smart pointer with a
+    ///  matching deleter.
+    ///
     ///  \par Usage
     ///  see test/Pimpl
     ////////////////////////////////////////////////////////////////////////////////
@@ -70,7 +192,8 @@ namespace Loki
     template
     <    
         class T, 
-        typename Pointer = ConstPropPtr<T>
+        typename Pointer = ConstPropPtr<T>,
+        class Creator = CreateImplUsingNew<T>
     >
     class Pimpl 
     {
@@ -78,7 +201,7 @@ namespace Loki
 
         typedef T Impl;
 
-        Pimpl() : ptr_(new T)
+        Pimpl() : ptr_(Creator::Create())
         {}
 
         ~Pimpl()
@@ -133,10 +256,105 @@ namespace Loki
     };
 
 
-    template<class T, typename Pointer = ConstPropPtr<T> >
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class FastPimpl
+    ///
+    ///  \ingroup PimplGroup
+    ///
+    ///  Pimpl variant without the heap allocation and the pointer chase:
+    ///  the implementation object is constructed with placement new inside
+    ///  an aligned buffer that lives in the hosting object itself, so the
+    ///  impl is on the same cache line(s) as its owner and creating the
+    ///  owner costs no allocation.  The compile firewall survives because
+    ///  the host's header only mentions sizeof(T) inside the constructor
+    ///  and destructor, which belong in the implementation file - exactly
+    ///  as with Pimpl, they must not be auto-generated or inlined.
+    ///
+    ///  The price is a size budget kept by hand: Size must be at least
+    ///  sizeof(T), which both the constructor and the destructor check at
+    ///  compile time, so a grown implementation breaks the build instead
+    ///  of the heap.  The buffer is aligned like the Alignment parameter
+    ///  (default double, sufficient for impls of scalars and pointers on
+    ///  the supported platforms); pass a more demanding type if the
+    ///  implementation needs it.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class T,
+        unsigned int Size,
+        typename Alignment = double
+    >
+    class FastPimpl
+    {
+    public:
+
+        typedef T Impl;
+
+        FastPimpl()
+        {
+            // Don't compile if the buffer is smaller than the
+            // implementation; adjust the Size argument when this breaks
+            typedef char T_must_fit_in_the_buffer[sizeof(T) <= Size ? 1 : -1 ];
+            new (AsT()) T;
+        }
+
+        ~FastPimpl()
+        {
+            // Don't compile with incomplete type, and re-check the budget
+            // in case only the destructor gets instantiated
+            typedef char T_must_fit_in_the_buffer[sizeof(T) <= Size ? 1 : -1 ];
+            AsT()->~T();
+        }
+
+
+        T* operator->()
+        {
+            return AsT();
+        }
+
+        T& operator*()
+        {
+            return *AsT();
+        }
+
+        const T* operator->() const
+        {
+            return AsT();
+        }
+
+        const T& operator*() const
+        {
+            return *AsT();
+        }
+
+
+    private:
+        FastPimpl(const FastPimpl&);
+        FastPimpl& operator=(const FastPimpl&);
+
+        T* AsT()
+        {
+            return reinterpret_cast<T*>(data_.buffer_);
+        }
+
+        const T* AsT() const
+        {
+            return reinterpret_cast<const T*>(data_.buffer_);
+        }
+
+        union Data
+        {
+            Alignment forAlignment;
+            char buffer_[Size];
+        } data_;
+    };
+
+
+    template<class T, typename Pointer = ConstPropPtr<T>, class Creator = CreateImplUsingNew<T> >
     struct PimplOwner 
     {    
-        Pimpl<T,Pointer> LOKI_INHERITED_PIMPL_NAME;
+        Pimpl<T,Pointer,Creator> LOKI_INHERITED_PIMPL_NAME;
     };
 
 
@@ -174,6 +392,31 @@ namespace Loki
     };
 
 
+    //////////////////////////////////////////
+    /// \class  PooledPimplOf
+    ///
+    /// \ingroup PimplGroup
+    /// Like PimplOf, but the implementation
+    /// lives in the small-object allocator.
+    /// Pass another creator policy to draw
+    /// it from a caller-supplied arena.
+    //////////////////////////////////////////
+
+    template<class T, template<class> class Creator = CreateImplUsingSmallObj>
+    struct PooledPimplOf
+    {
+        typedef T Impl;
+        typedef Creator<ImplOf<T> > ImplCreator;
+        typedef CreatorPropPtr<ImplOf<T>, ImplCreator> Ptr;
+
+        // declare pimpl
+        typedef Pimpl<ImplOf<T>, Ptr, ImplCreator> Type;
+
+        // inherit pimpl
+        typedef PimplOwner<ImplOf<T>, Ptr, ImplCreator> Owner;
+    };
+
+
     template<class T, class UsedPimpl = typename PimplOf<T>::Type >
     struct RimplOf
     {
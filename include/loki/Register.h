@@ -17,6 +17,7 @@
 
 #include "TypeManip.h"
 #include "HierarchyGenerators.h"
+#include "Threads.h"
 
 ///  \defgroup RegisterGroup Register 
 
@@ -66,6 +67,70 @@ namespace Loki
         {
             UnRegisterOnDelete<T> unregisterObj;
         };
+
+        ////////////////////////////////////////////////////////////////////////////////
+        ///  \struct RegistrationThunk
+        ///
+        ///  One recorded, not yet executed registration.  The nodes live
+        ///  inside the DeferRegisterOnCreate objects, so recording one costs
+        ///  two pointer stores and no allocation during static initialization.
+        ////////////////////////////////////////////////////////////////////////////////
+        struct RegistrationThunk
+        {
+            bool (*execute)();
+            RegistrationThunk* next;
+        };
+
+        ///  Head of the list of recorded registrations, in reverse order of
+        ///  their static initialization.
+        inline RegistrationThunk*& PendingRegistrations()
+        {
+            static RegistrationThunk* head = 0;
+            return head;
+        }
+
+        template<class T>
+        struct DeferRegisterOnCreate
+        {
+            DeferRegisterOnCreate()
+            {
+                thunk_.execute = &RegisterFunction<T>;
+                thunk_.next = PendingRegistrations();
+                PendingRegistrations() = &thunk_;
+            }
+            RegistrationThunk thunk_;
+        };
+
+        template<class T>
+        struct DeferRegisterOnCreateElement
+        {
+            DeferRegisterOnCreate<T> registerObj;
+        };
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \ingroup RegisterGroup
+    ///  Runs every registration a DeferredRegisterOnCreateSet recorded and
+    ///  empties the list.  Call it from the factory accessor: after the first
+    ///  call it is one pointer load, so calling it on every access is the
+    ///  cheap way to get lazy registration.  Thunks run in reverse order of
+    ///  their static initialization, which a set of distinct factory keys
+    ///  does not notice.
+    ////////////////////////////////////////////////////////////////////////////////
+    inline void ExecutePendingRegistrations()
+    {
+        if( 0 == Private::PendingRegistrations() )
+            return;
+        static Mutex mutex;
+        mutex.Lock();
+        Private::RegistrationThunk*& head = Private::PendingRegistrations();
+        while( 0 != head )
+        {
+            Private::RegistrationThunk* thunk = head;
+            head = thunk->next;
+            thunk->execute();
+        }
+        mutex.Unlock();
     }
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -97,6 +162,25 @@ namespace Loki
         : GenScatterHierarchy<ElementList, Private::UnRegisterOnDeleteElement>
     {};
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class DeferredRegisterOnCreateSet
+    ///
+    ///  \ingroup RegisterGroup
+    ///  Like RegisterOnCreateSet, but static initialization only records a
+    ///  thunk per class instead of running its RegisterFunction; the recorded
+    ///  registrations run on the first call of ExecutePendingRegistrations.
+    ///  With thousands of generated classes this moves the whole registration
+    ///  cost from before main() to the first factory access - or off the
+    ///  startup path entirely in processes which never touch the factory.
+    ///
+    ///  \par Usage
+    ///  see test/Register
+    ////////////////////////////////////////////////////////////////////////////////
+    template<typename ElementList>
+    struct DeferredRegisterOnCreateSet 
+        : GenScatterHierarchy<ElementList, Private::DeferRegisterOnCreateElement>
+    {};
+
 
     ////////////////////////////////////////////////////////////////////////////////
     ///  \def  LOKI_CHECK_CLASS_IN_LIST( CLASS , LIST )
@@ -73,19 +73,19 @@ namespace Loki
         /// type of the Functor to set
         typedef Functor< void , Seq< void* > > FunctorType;
 
-        FunctionStorage() : pointee_(Default()), functor_()
+        FunctionStorage() : pointee_(Default()), functor_(), cacheHandle_(0)
         {}
 
         // The storage policy doesn't initialize the stored pointer 
         //     which will be initialized by the OwnershipPolicy's Clone fn
-        FunctionStorage(const FunctionStorage& rsh) : pointee_(0), functor_(rsh.functor_)
+        FunctionStorage(const FunctionStorage& rsh) : pointee_(0), functor_(rsh.functor_), cacheHandle_(rsh.cacheHandle_)
         {}
 
         template <class U>
-        FunctionStorage(const FunctionStorage<U>& rsh) : pointee_(0), functor_(rsh.functor_)
+        FunctionStorage(const FunctionStorage<U>& rsh) : pointee_(0), functor_(rsh.functor_), cacheHandle_(rsh.cacheHandle_)
         {}
         
-        FunctionStorage(const StoredType& p) : pointee_(p), functor_() {}
+        FunctionStorage(const StoredType& p) : pointee_(p), functor_(), cacheHandle_(0) {}
         
         PointerType operator->() const { return pointee_; }
         
@@ -95,6 +95,7 @@ namespace Loki
         { 
         	std::swap(pointee_, rhs.pointee_);
         	std::swap(functor_, rhs.functor_);
+        	std::swap(cacheHandle_, rhs.cacheHandle_);
         }
         
         /// Sets the callback function to call. You have to specify it or
@@ -103,6 +104,19 @@ namespace Loki
         {
         	functor_ = functor;
         }
+
+        /// Opaque release handle the cache storage handed out when the
+        /// object was fetched; carried in every copy, so the callback can
+        /// route the release straight to the owning record with no lookup.
+        void SetCacheHandle(void* handle)
+        {
+        	cacheHandle_ = handle;
+        }
+
+        void* GetCacheHandle() const
+        {
+        	return cacheHandle_;
+        }
     
         // Accessors
         template <class F>
@@ -130,6 +144,7 @@ namespace Loki
         // Data
         StoredType pointee_;
         FunctorType functor_;
+        void* cacheHandle_;
     };
 
     template <class T>
@@ -184,7 +199,19 @@ namespace Loki
            {
                 return GetImpl(pProduct);
            }
-           
+
+           // The handle rides inside the FunctionStorage policy, so the
+           // release triggered by the last SmartPtr still carries it.
+           void attachHandle(ProductReturn &sp, void* handle)
+           {
+                sp.SetCacheHandle(handle);
+           }
+
+           void* takeHandle(ProductReturn &sp)
+           {
+                return sp.GetCacheHandle();
+           }
+
            const char* name(){return "smart pointer";}
 
      private:
@@ -1,8 +1,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 // The Loki Library
 // Copyright (c) 2009 by Fedor Pikus & Rich Sposato
-// The copyright on this file is protected under the terms of the MIT license.
-//
+// The copyright on this file is protected under the terms of the MIT license.
+//
 // Permission to use, copy, modify, distribute and sell this software for any
 //     purpose is hereby granted without fee, provided that the above copyright
 //     notice appear in all copies and that both that copyright notice and this
@@ -11,22 +11,22 @@
 // The author makes no claims about the suitability of this software for any
 //     purpose. It is provided "as is" without express or implied warranty.
 ////////////////////////////////////////////////////////////////////////////////
-
-// $Id$
-
-
-#ifndef LOKI_INCLUDED_SAFE_BIT_FIELDS_H
-#define LOKI_INCLUDED_SAFE_BIT_FIELDS_H
-
-#include <cstdlib>
-#include <assert.h>
+
+// $Id$
+
+
+#ifndef LOKI_INCLUDED_SAFE_BIT_FIELDS_H
+#define LOKI_INCLUDED_SAFE_BIT_FIELDS_H
+
+#include <cstdlib>
+#include <assert.h>
 #include <loki/static_check.h>
-
-
-namespace Loki
-{
-
-/*
+
+
+namespace Loki
+{
+
+/*
  ==========================================================================================================================================
    SafeBitField                    - type-safe class for bit fields.
    SafeBitConst                    - type-safe class for bit constants.
@@ -95,25 +95,25 @@ namespace Loki
    ==========================================================================================================================================
 */
 
-/// @par Non-Templated Initialization.
-/// Not all compilers support template member functions where the template
-/// arguments are not deduced but explicitly specified.  For these broken
-/// compilers, a non-template make_bit_const() function is provided instead of
-/// the template one. The only downside is that instead of compile-time checking
-/// of the index argument, it does runtime checking.
+/// @par Non-Templated Initialization.
+/// Not all compilers support template member functions where the template
+/// arguments are not deduced but explicitly specified.  For these broken
+/// compilers, a non-template make_bit_const() function is provided instead of
+/// the template one. The only downside is that instead of compile-time checking
+/// of the index argument, it does runtime checking.
 #if defined(__SUNPRO_CC) || ( defined(__GNUC__) && (__GNUC__ < 3) )
     #define LOKI_BIT_FIELD_NONTEMPLATE_INIT
 #endif
 
-/// @par Forbidding Conversions.
-/// This incomplete type prevents compilers from instantiating templates for
-/// type conversions which should not happen. This incomplete type must be a
-/// template: if the type is incomplete at the point of template definition,
-/// the  template is illegal (although the standard allows compilers to accept
-/// or reject such code, §14.6/, so some compilers will not issue diagnostics
-/// unless template is instantiated). The standard-compliant way is to defer
-/// binding to the point of instantiation by making the incomplete type itself
-/// a template.
+/// @par Forbidding Conversions.
+/// This incomplete type prevents compilers from instantiating templates for
+/// type conversions which should not happen. This incomplete type must be a
+/// template: if the type is incomplete at the point of template definition,
+/// the  template is illegal (although the standard allows compilers to accept
+/// or reject such code, §14.6/, so some compilers will not issue diagnostics
+/// unless template is instantiated). The standard-compliant way is to defer
+/// binding to the point of instantiation by making the incomplete type itself
+/// a template.
 template < typename > struct Forbidden_conversion;  // This struct must not be defined!
 
 /// Forward declaration of the field type.
@@ -122,6 +122,13 @@ template <
     typename word_t = unsigned long
 > class SafeBitField;
 
+/// Forward declaration of the compile-time constant type.
+template <
+    unsigned int unique_index,
+    typename word_t,
+    word_t mask_bits
+> class StaticBitConst;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class SafeBitConst Bit constants.
 ///  This class defines a bit-field constant - a collection of unchanging bits
@@ -154,6 +161,9 @@ public:
     typedef SafeBitField< unique_index, word_t > field_t;
     /// Typedef is not allowed in friendship declaration.
     friend class SafeBitField< unique_index, word_t >;
+    /// Compile-time constants of any mask may convert themselves into
+    /// run-time constants, which needs the private constructor.
+    template < unsigned int i, typename w, w m > friend class StaticBitConst;
 
     // Static factory constructor, creates a bit constant with one bit set. The position of the bit is given by the template parameter,
     // bit 1 is the junior bit, i.e. make_bit_const<1>() returns 1. Bit index 0 is a special case and returns 0.
@@ -167,22 +177,22 @@ public:
     {
         LOKI_STATIC_CHECK( i <= ( 8 * sizeof(word_t) ), Index_is_beyond_size_of_data );
         LOKI_STATIC_CHECK( sizeof(SafeBitConst) == sizeof(word_t), Object_size_does_not_match_data_size );
-        // Why check for ( i > 0 ) again inside the shift if the shift
-        // can never be evaluated for i == 0? Some compilers see shift by ( i - 1 )
-        // and complain that for i == 0 the number is invalid, without
-        // checking that shift needs evaluating.
-        return SafeBitConst( ( i > 0 ) ? ( word_t(1) << ( ( i > 0 ) ? ( i - 1 ) : 0 ) ) : 0 );
+        // Why check for ( i > 0 ) again inside the shift if the shift
+        // can never be evaluated for i == 0? Some compilers see shift by ( i - 1 )
+        // and complain that for i == 0 the number is invalid, without
+        // checking that shift needs evaluating.
+        return SafeBitConst( ( i > 0 ) ? ( word_t(1) << ( ( i > 0 ) ? ( i - 1 ) : 0 ) ) : 0 );
     }
 #else
     static SafeBitConst make_bit_const( unsigned int i )
     {
         LOKI_STATIC_CHECK( sizeof(SafeBitConst) == sizeof(word_t), Object_size_does_not_match_data_size );
-        assert( i <= ( 8 * sizeof(word_t) ) ); // Index is beyond size of data.
-        // Why check for ( i > 0 ) again inside the shift if the shift
-        // can never be evaluated for i == 0? Some compilers see shift by ( i - 1 )
-        // and complain that for i == 0 the number is invalid, without
-        // checking that shift needs evaluating.
-        return SafeBitConst( ( i > 0 ) ? ( word_t(1) << ( ( i > 0 ) ? ( i - 1 ) : 0 ) ) : 0 );
+        assert( i <= ( 8 * sizeof(word_t) ) ); // Index is beyond size of data.
+        // Why check for ( i > 0 ) again inside the shift if the shift
+        // can never be evaluated for i == 0? Some compilers see shift by ( i - 1 )
+        // and complain that for i == 0 the number is invalid, without
+        // checking that shift needs evaluating.
+        return SafeBitConst( ( i > 0 ) ? ( word_t(1) << ( ( i > 0 ) ? ( i - 1 ) : 0 ) ) : 0 );
     }
 #endif
 
@@ -192,79 +202,79 @@ public:
     /// Copy constructor.
     SafeBitConst( const SafeBitConst& rhs ) : word( rhs.word ) {}
 
-    /// Comparison operators which take a constant bit value.
-    bool operator == ( const SafeBitConst & rhs ) const { return word == rhs.word; }
-    bool operator != ( const SafeBitConst & rhs ) const { return word != rhs.word; }
-    bool operator <  ( const SafeBitConst & rhs ) const { return word <  rhs.word; }
-    bool operator >  ( const SafeBitConst & rhs ) const { return word >  rhs.word; }
-    bool operator <= ( const SafeBitConst & rhs ) const { return word <= rhs.word; }
-    bool operator >= ( const SafeBitConst & rhs ) const { return word >= rhs.word; }
-
-    /// Comparision operators for mutable bit fields.
-    bool operator == ( const field_t & rhs ) const { return word == rhs.word; }
-    bool operator != ( const field_t & rhs ) const { return word != rhs.word; }
-    bool operator <  ( const field_t & rhs ) const { return word <  rhs.word; }
-    bool operator >  ( const field_t & rhs ) const { return word >  rhs.word; }
-    bool operator <= ( const field_t & rhs ) const { return word <= rhs.word; }
-    bool operator >= ( const field_t & rhs ) const { return word >= rhs.word; }
-
-    /// Bitwise operations.  Operation-assignment operators are not needed,
-    /// since bit constants cannot be changed after they are initialized.
-    const SafeBitConst operator | ( const SafeBitConst & rhs ) const { return SafeBitConst( word | rhs.word ); }
-    const SafeBitConst operator & ( const SafeBitConst & rhs ) const { return SafeBitConst( word & rhs.word ); }
-    const SafeBitConst operator ^ ( const SafeBitConst & rhs ) const { return SafeBitConst( word ^ rhs.word ); }
-    const SafeBitConst operator ~ ( void ) const { return SafeBitConst( ~word ); }
-
-    /// These bitwise operators return a bit-field instead of a bit-const.
-    field_t operator | ( const field_t & rhs ) const { return field_t( word | rhs.word ); }
-    field_t operator & ( const field_t & rhs ) const { return field_t( word & rhs.word ); }
-    field_t operator ^ ( const field_t & rhs ) const { return field_t( word ^ rhs.word ); }
-
-    /// The shift operators move bits inside the bit field.  These are useful in
-    /// loops which act over bit fields and increment them.
-    const SafeBitConst operator << ( unsigned int s ) const { return SafeBitConst( word << s ); }
-    const SafeBitConst operator >> ( unsigned int s ) const { return SafeBitConst( word >> s ); }
+    /// Comparison operators which take a constant bit value.
+    bool operator == ( const SafeBitConst & rhs ) const { return word == rhs.word; }
+    bool operator != ( const SafeBitConst & rhs ) const { return word != rhs.word; }
+    bool operator <  ( const SafeBitConst & rhs ) const { return word <  rhs.word; }
+    bool operator >  ( const SafeBitConst & rhs ) const { return word >  rhs.word; }
+    bool operator <= ( const SafeBitConst & rhs ) const { return word <= rhs.word; }
+    bool operator >= ( const SafeBitConst & rhs ) const { return word >= rhs.word; }
+
+    /// Comparision operators for mutable bit fields.
+    bool operator == ( const field_t & rhs ) const { return word == rhs.word; }
+    bool operator != ( const field_t & rhs ) const { return word != rhs.word; }
+    bool operator <  ( const field_t & rhs ) const { return word <  rhs.word; }
+    bool operator >  ( const field_t & rhs ) const { return word >  rhs.word; }
+    bool operator <= ( const field_t & rhs ) const { return word <= rhs.word; }
+    bool operator >= ( const field_t & rhs ) const { return word >= rhs.word; }
+
+    /// Bitwise operations.  Operation-assignment operators are not needed,
+    /// since bit constants cannot be changed after they are initialized.
+    const SafeBitConst operator | ( const SafeBitConst & rhs ) const { return SafeBitConst( word | rhs.word ); }
+    const SafeBitConst operator & ( const SafeBitConst & rhs ) const { return SafeBitConst( word & rhs.word ); }
+    const SafeBitConst operator ^ ( const SafeBitConst & rhs ) const { return SafeBitConst( word ^ rhs.word ); }
+    const SafeBitConst operator ~ ( void ) const { return SafeBitConst( ~word ); }
+
+    /// These bitwise operators return a bit-field instead of a bit-const.
+    field_t operator | ( const field_t & rhs ) const { return field_t( word | rhs.word ); }
+    field_t operator & ( const field_t & rhs ) const { return field_t( word & rhs.word ); }
+    field_t operator ^ ( const field_t & rhs ) const { return field_t( word ^ rhs.word ); }
+
+    /// The shift operators move bits inside the bit field.  These are useful in
+    /// loops which act over bit fields and increment them.
+    const SafeBitConst operator << ( unsigned int s ) const { return SafeBitConst( word << s ); }
+    const SafeBitConst operator >> ( unsigned int s ) const { return SafeBitConst( word >> s ); }
 
     /// Word size is also the maximum number of different bit fields for a given word type.
     static size_t size() { return ( 8 * sizeof( word_t ) ); }
 
 private:
-
-    /// Copy-assignment operator is not implemented since it does not make sense
-    /// for a constant object.
-    SafeBitConst operator = ( const SafeBitConst & rhs );
-
-    // Private constructor from an integer type.
-    explicit SafeBitConst( word_t init ) : word( init ) {}
-
-    /// This data stores a single bit value.  It is declared const to enforce
-    // constness for all functions of this class.
-    const word_t word;
-
-    // Here comes the interesting stuff: all the operators designed to
-    // trap unintended conversions and make them not compile.
-    // Operators below handle code like this:
-    //    SafeBitField<1> label1;
-    //    SafeBitField<2> label2;
-    //    if ( label1 & label2 ) { ... }
-
-    // These operators are private, and will not instantiate in any
-    // event because of the incomplete Forbidden_conversion struct.
-    template < typename T > SafeBitConst operator|( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitConst operator&( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitConst operator^( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitConst operator|=( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitConst operator&=( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitConst operator^=( T ) const { Forbidden_conversion< T > wrong; return *this; }
-
-    // And the same thing for comparisons: private and unusable.
-    //    if ( label1 == label2 ) { ... }
-    template < typename T > bool operator==( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator!=( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator<( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator>( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator<=( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator>=( const T ) const { Forbidden_conversion< T > wrong; return true; }
+
+    /// Copy-assignment operator is not implemented since it does not make sense
+    /// for a constant object.
+    SafeBitConst operator = ( const SafeBitConst & rhs );
+
+    // Private constructor from an integer type.
+    explicit SafeBitConst( word_t init ) : word( init ) {}
+
+    /// This data stores a single bit value.  It is declared const to enforce
+    // constness for all functions of this class.
+    const word_t word;
+
+    // Here comes the interesting stuff: all the operators designed to
+    // trap unintended conversions and make them not compile.
+    // Operators below handle code like this:
+    //    SafeBitField<1> label1;
+    //    SafeBitField<2> label2;
+    //    if ( label1 & label2 ) { ... }
+
+    // These operators are private, and will not instantiate in any
+    // event because of the incomplete Forbidden_conversion struct.
+    template < typename T > SafeBitConst operator|( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitConst operator&( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitConst operator^( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitConst operator|=( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitConst operator&=( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitConst operator^=( T ) const { Forbidden_conversion< T > wrong; return *this; }
+
+    // And the same thing for comparisons: private and unusable.
+    //    if ( label1 == label2 ) { ... }
+    template < typename T > bool operator==( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator!=( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator<( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator>( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator<=( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator>=( const T ) const { Forbidden_conversion< T > wrong; return true; }
 };
 
 
@@ -300,6 +310,12 @@ public:
     typedef SafeBitConst< unique_index, word_t > const_t;
     /// Typedef is not allowed in friendship declaration.
     friend class SafeBitConst<unique_index, word_t>;
+    /// Compile-time constants of any mask share friendship so their
+    /// tests read the packed word directly.
+    template < unsigned int i, typename w, w m > friend class StaticBitConst;
+    /// The unique index is exposed so the LOKI_STATIC_BIT_CONST macro can
+    /// name the matching compile-time constant type.
+    enum { field_index = unique_index };
 
     /// Default constructor allows client code to construct bit fields on the stack.
     SafeBitField() : word( 0 ) {}
@@ -312,39 +328,39 @@ public:
     SafeBitField( const const_t & rhs ) : word( rhs.word ) {}
     SafeBitField & operator = ( const const_t & rhs ) { word = rhs.word; return *this; }
 
-    /// These comparison operators act on bit-fields of the same type.
-    bool operator == ( const SafeBitField & rhs ) const { return word == rhs.word; }
-    bool operator != ( const SafeBitField & rhs ) const { return word != rhs.word; }
-    bool operator <  ( const SafeBitField & rhs ) const { return word <  rhs.word; }
-    bool operator >  ( const SafeBitField & rhs ) const { return word >  rhs.word; }
-    bool operator <= ( const SafeBitField & rhs ) const { return word <= rhs.word; }
-    bool operator >= ( const SafeBitField & rhs ) const { return word >= rhs.word; }
-
-    /// These comparison operators act on bit-constants of a similar type.
-    bool operator == ( const const_t & rhs ) const { return word == rhs.word; }
-    bool operator != ( const const_t & rhs ) const { return word != rhs.word; }
-    bool operator <  ( const const_t & rhs ) const { return word <  rhs.word; }
-    bool operator >  ( const const_t & rhs ) const { return word >  rhs.word; }
-    bool operator <= ( const const_t & rhs ) const { return word <= rhs.word; }
-    bool operator >= ( const const_t & rhs ) const { return word >= rhs.word; }
-
-    /// Bitwise operations that use bit-fields.
-    SafeBitField operator |  ( const SafeBitField & rhs ) const { return SafeBitField( word | rhs.word ); }
-    SafeBitField operator &  ( const SafeBitField & rhs ) const { return SafeBitField( word & rhs.word ); }
-    SafeBitField operator ^  ( const SafeBitField & rhs ) const { return SafeBitField( word ^ rhs.word ); }
-    SafeBitField operator ~  ( void ) const { return SafeBitField( ~word ); }
-    SafeBitField operator |= ( const SafeBitField & rhs ) { word |= rhs.word; return SafeBitField( *this ); }
-    SafeBitField operator &= ( const SafeBitField & rhs ) { word &= rhs.word; return SafeBitField( *this ); }
-    SafeBitField operator ^= ( const SafeBitField & rhs ) { word ^= rhs.word; return SafeBitField( *this ); }
-
-    /// Bitwise operators that use bit-constants.
-    SafeBitField operator |  ( const_t rhs ) const { return SafeBitField( word | rhs.word ); }
-    SafeBitField operator &  ( const_t rhs ) const { return SafeBitField( word & rhs.word ); }
-    SafeBitField operator ^  ( const_t rhs ) const { return SafeBitField( word ^ rhs.word ); }
-    SafeBitField operator |= ( const_t rhs ) { word |= rhs.word; return SafeBitField( *this ); }
-    SafeBitField operator &= ( const_t rhs ) { word &= rhs.word; return SafeBitField( *this ); }
-    SafeBitField operator ^= ( const_t rhs ) { word ^= rhs.word; return SafeBitField( *this ); }
-
+    /// These comparison operators act on bit-fields of the same type.
+    bool operator == ( const SafeBitField & rhs ) const { return word == rhs.word; }
+    bool operator != ( const SafeBitField & rhs ) const { return word != rhs.word; }
+    bool operator <  ( const SafeBitField & rhs ) const { return word <  rhs.word; }
+    bool operator >  ( const SafeBitField & rhs ) const { return word >  rhs.word; }
+    bool operator <= ( const SafeBitField & rhs ) const { return word <= rhs.word; }
+    bool operator >= ( const SafeBitField & rhs ) const { return word >= rhs.word; }
+
+    /// These comparison operators act on bit-constants of a similar type.
+    bool operator == ( const const_t & rhs ) const { return word == rhs.word; }
+    bool operator != ( const const_t & rhs ) const { return word != rhs.word; }
+    bool operator <  ( const const_t & rhs ) const { return word <  rhs.word; }
+    bool operator >  ( const const_t & rhs ) const { return word >  rhs.word; }
+    bool operator <= ( const const_t & rhs ) const { return word <= rhs.word; }
+    bool operator >= ( const const_t & rhs ) const { return word >= rhs.word; }
+
+    /// Bitwise operations that use bit-fields.
+    SafeBitField operator |  ( const SafeBitField & rhs ) const { return SafeBitField( word | rhs.word ); }
+    SafeBitField operator &  ( const SafeBitField & rhs ) const { return SafeBitField( word & rhs.word ); }
+    SafeBitField operator ^  ( const SafeBitField & rhs ) const { return SafeBitField( word ^ rhs.word ); }
+    SafeBitField operator ~  ( void ) const { return SafeBitField( ~word ); }
+    SafeBitField operator |= ( const SafeBitField & rhs ) { word |= rhs.word; return SafeBitField( *this ); }
+    SafeBitField operator &= ( const SafeBitField & rhs ) { word &= rhs.word; return SafeBitField( *this ); }
+    SafeBitField operator ^= ( const SafeBitField & rhs ) { word ^= rhs.word; return SafeBitField( *this ); }
+
+    /// Bitwise operators that use bit-constants.
+    SafeBitField operator |  ( const_t rhs ) const { return SafeBitField( word | rhs.word ); }
+    SafeBitField operator &  ( const_t rhs ) const { return SafeBitField( word & rhs.word ); }
+    SafeBitField operator ^  ( const_t rhs ) const { return SafeBitField( word ^ rhs.word ); }
+    SafeBitField operator |= ( const_t rhs ) { word |= rhs.word; return SafeBitField( *this ); }
+    SafeBitField operator &= ( const_t rhs ) { word &= rhs.word; return SafeBitField( *this ); }
+    SafeBitField operator ^= ( const_t rhs ) { word ^= rhs.word; return SafeBitField( *this ); }
+
     // Conversion to bool.
     // This is a major source of headaches, but it's required to support code like this:
     //    const static SafeBitConst<1> Label_value = SafeBitConst<1>::make_bit_const<1>();
@@ -363,17 +379,17 @@ public:
     //
     operator const bool() const { return ( 0 != word ); }
 
-    // Shift operators shift bits inside the bit field. Does not make
-    // sense, most of the time, except perhaps to loop over labels and
-    // increment them.
-    SafeBitField operator <<  ( unsigned int s ) { return SafeBitField( word << s ); }
-    SafeBitField operator >>  ( unsigned int s ) { return SafeBitField( word >> s ); }
-    SafeBitField operator <<= ( unsigned int s ) { word <<= s; return *this; }
-    SafeBitField operator >>= ( unsigned int s ) { word >>= s; return *this; }
-
-    // Word size is also the maximum number of different bit fields for
-    // a given word type.
-    static size_t size( void ) { return ( 8 * sizeof( word_t ) ); }
+    // Shift operators shift bits inside the bit field. Does not make
+    // sense, most of the time, except perhaps to loop over labels and
+    // increment them.
+    SafeBitField operator <<  ( unsigned int s ) { return SafeBitField( word << s ); }
+    SafeBitField operator >>  ( unsigned int s ) { return SafeBitField( word >> s ); }
+    SafeBitField operator <<= ( unsigned int s ) { word <<= s; return *this; }
+    SafeBitField operator >>= ( unsigned int s ) { word >>= s; return *this; }
+
+    // Word size is also the maximum number of different bit fields for
+    // a given word type.
+    static size_t size( void ) { return ( 8 * sizeof( word_t ) ); }
 
 private:
 
@@ -381,86 +397,189 @@ private:
     /// explicit declaration, it's better than nothing but does not solve all
     /// problems with undesired conversions because SafeBitField coverts to bool.
     explicit SafeBitField( word_t init ) : word( init ) {}
-
-    /// This stores the bits.
-    word_t word;
-
-    // Here comes the interesting stuff: all the operators designed to
-    // trap unintended conversions and make them not compile.
-    // Operators below handle code like this:
-    //    SafeBitField<1> label1;
-    //    SafeBitField<2> label2;
-    //    if ( label1 & label2 ) { ... }
-
-    // These operators are private, and will not instantiate in any
-    // event because of the incomplete Forbidden_conversion struct.
-    template < typename T > SafeBitField operator |  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitField operator &  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitField operator ^  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitField operator |= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitField operator &= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-    template < typename T > SafeBitField operator ^= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
-
-    // And the same thing for comparisons:
-    //    if ( label1 == label2 ) { ... }
-    template < typename T > bool operator == ( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator != ( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator <  ( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator >  ( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator <= ( const T ) const { Forbidden_conversion< T > wrong; return true; }
-    template < typename T > bool operator >= ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+
+    /// This stores the bits.
+    word_t word;
+
+    // Here comes the interesting stuff: all the operators designed to
+    // trap unintended conversions and make them not compile.
+    // Operators below handle code like this:
+    //    SafeBitField<1> label1;
+    //    SafeBitField<2> label2;
+    //    if ( label1 & label2 ) { ... }
+
+    // These operators are private, and will not instantiate in any
+    // event because of the incomplete Forbidden_conversion struct.
+    template < typename T > SafeBitField operator |  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitField operator &  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitField operator ^  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitField operator |= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitField operator &= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > SafeBitField operator ^= ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+
+    // And the same thing for comparisons:
+    //    if ( label1 == label2 ) { ... }
+    template < typename T > bool operator == ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator != ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator <  ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator >  ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator <= ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator >= ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class StaticBitConst Compile-time bit constants.
+///  A bit constant whose mask is a non-type template parameter instead of a
+///  run-time word, for code where flag tests sit on the fast path.  A
+///  SafeBitConst is a value the optimizer must track through memory, so a
+///  test of several flags may emit an or per flag; a StaticBitConst carries
+///  its mask in its type, combinations merge masks at compile time, and a
+///  test of any number of flags compiles to a single masked compare against
+///  an immediate.
+///
+/// \par Safety
+///  - The unique_index matches the SafeBitField and SafeBitConst of the same
+///    field type, so constants of different field types still cannot be
+///    mixed - combinations and tests only compile within one index.
+///  - The object carries no data; all instances of one specialization are
+///    interchangeable labels.
+///
+/// \par Usage
+///  Declared with the LOKI_STATIC_BIT_CONST macro, which makes both a type
+///  label_t and a constant object label, the tests read naturally:
+///
+///      LOKI_BIT_FIELD( unsigned long ) field_t;
+///      LOKI_STATIC_BIT_CONST( field_t, Flag_Syn, 1 );
+///      LOKI_STATIC_BIT_CONST( field_t, Flag_Ack, 2 );
+///      ...
+///      if ( ( Flag_Syn | Flag_Ack ).AreAllIn( header ) ) { ... }
+////////////////////////////////////////////////////////////////////////////////
+
+template
+<
+    unsigned int unique_index,
+    typename word_t,
+    word_t mask_bits
+>
+class StaticBitConst
+{
+public:
+
+    /// Type of the bit field is available if needed.
+    typedef word_t bit_word_t;
+    /// Corresponding field type.
+    typedef SafeBitField< unique_index, word_t > field_t;
+    /// Corresponding run-time constant type.
+    typedef SafeBitConst< unique_index, word_t > const_t;
+
+    /// The mask itself, a compile-time constant.
+    static const word_t bits = mask_bits;
+
+    StaticBitConst() {}
+
+    /// Combinations merge masks in the type, so an expression like
+    /// ( Flag_A | Flag_B ) is itself a compile-time constant.
+    template < word_t rhs_bits >
+    StaticBitConst< unique_index, word_t, mask_bits | rhs_bits >
+        operator | ( const StaticBitConst< unique_index, word_t, rhs_bits > & ) const
+    { return StaticBitConst< unique_index, word_t, mask_bits | rhs_bits >(); }
+
+    template < word_t rhs_bits >
+    StaticBitConst< unique_index, word_t, mask_bits & rhs_bits >
+        operator & ( const StaticBitConst< unique_index, word_t, rhs_bits > & ) const
+    { return StaticBitConst< unique_index, word_t, mask_bits & rhs_bits >(); }
+
+    template < word_t rhs_bits >
+    StaticBitConst< unique_index, word_t, mask_bits ^ rhs_bits >
+        operator ^ ( const StaticBitConst< unique_index, word_t, rhs_bits > & ) const
+    { return StaticBitConst< unique_index, word_t, mask_bits ^ rhs_bits >(); }
+
+    StaticBitConst< unique_index, word_t, word_t( ~mask_bits ) >
+        operator ~ ( void ) const
+    { return StaticBitConst< unique_index, word_t, word_t( ~mask_bits ) >(); }
+
+    /// Tests against a run-time field, each one masked compare with an
+    /// immediate no matter how many flags the mask combines.
+    bool AreAllIn( const field_t & rhs ) const { return ( rhs.word & bits ) == bits; }
+    bool IsAnyIn( const field_t & rhs ) const { return ( rhs.word & bits ) != 0; }
+
+    /// Sets or clears every bit of this constant in a field in one
+    /// instruction.
+    void SetIn( field_t & rhs ) const { rhs.word |= bits; }
+    void ClearIn( field_t & rhs ) const { rhs.word &= word_t( ~bits ); }
+
+    /// Converts to the run-time constant type, for passing to code written
+    /// against SafeBitConst.
+    const_t ToConst( void ) const { return const_t( bits ); }
+
+    /// Word size is also the maximum number of different bit fields for a
+    /// given word type.
+    static size_t size( void ) { return ( 8 * sizeof( word_t ) ); }
+
+private:
+
+    // The usual conversion traps: combining or comparing with anything but
+    // a constant of the same field type will not instantiate.
+    template < typename T > StaticBitConst operator |  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > StaticBitConst operator &  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > StaticBitConst operator ^  ( T ) const { Forbidden_conversion< T > wrong; return *this; }
+    template < typename T > bool operator == ( const T ) const { Forbidden_conversion< T > wrong; return true; }
+    template < typename T > bool operator != ( const T ) const { Forbidden_conversion< T > wrong; return true; }
 };
 
-// The above template member operators catch errors when the first
-// argument to a binary operator is a label, but they don't work when
-// the first argument is an integer and the second one is a label: the
-// label converts to bool and the operator is performed on two integers.
-// These operators catch errors like this:
-//    SafeBitField<1> label1;
-//    SafeBitField<2> label2;
-//    if ( !label1 & label2 ) { ... }
-// where the first label is converted to bool (these errors cannot be
-// caught by member operators of SafeBitField class because the first
-// argument is not SafeBitField but bool.
-//
-// If used, these operators will not instantiate because of the
-// incomplete Forbidden_conversion struct.
-
-template < unsigned int unique_index, typename word_t >
-inline SafeBitField< unique_index, word_t > operator & ( bool, SafeBitField< unique_index, word_t > rhs )
-{
-    Forbidden_conversion<word_t> wrong;
-    return rhs;
-}
-
-template < unsigned int unique_index, typename word_t >
-inline SafeBitField< unique_index, word_t > operator | ( bool, SafeBitField< unique_index, word_t > rhs )
-{
-    Forbidden_conversion< word_t > wrong;
-    return rhs;
-}
-
-template < unsigned int unique_index, typename word_t >
-inline SafeBitField< unique_index, word_t > operator ^ ( bool, SafeBitField< unique_index, word_t > rhs )
-{
-    Forbidden_conversion< word_t > wrong;
-    return rhs;
-}
-
-template < unsigned int unique_index, typename word_t >
-inline SafeBitField< unique_index, word_t > operator == ( bool, SafeBitField< unique_index, word_t > rhs )
-{
-    Forbidden_conversion< word_t > wrong;
-    return rhs;
-}
-
-template < unsigned int unique_index, typename word_t >
-inline SafeBitField< unique_index, word_t > operator != ( bool, SafeBitField< unique_index, word_t > rhs )
-{
-    Forbidden_conversion< word_t > wrong;
-    return rhs;
-}
-
+template < unsigned int unique_index, typename word_t, word_t mask_bits >
+const word_t StaticBitConst< unique_index, word_t, mask_bits >::bits;
+
+// The above template member operators catch errors when the first
+// argument to a binary operator is a label, but they don't work when
+// the first argument is an integer and the second one is a label: the
+// label converts to bool and the operator is performed on two integers.
+// These operators catch errors like this:
+//    SafeBitField<1> label1;
+//    SafeBitField<2> label2;
+//    if ( !label1 & label2 ) { ... }
+// where the first label is converted to bool (these errors cannot be
+// caught by member operators of SafeBitField class because the first
+// argument is not SafeBitField but bool.
+//
+// If used, these operators will not instantiate because of the
+// incomplete Forbidden_conversion struct.
+
+template < unsigned int unique_index, typename word_t >
+inline SafeBitField< unique_index, word_t > operator & ( bool, SafeBitField< unique_index, word_t > rhs )
+{
+    Forbidden_conversion<word_t> wrong;
+    return rhs;
+}
+
+template < unsigned int unique_index, typename word_t >
+inline SafeBitField< unique_index, word_t > operator | ( bool, SafeBitField< unique_index, word_t > rhs )
+{
+    Forbidden_conversion< word_t > wrong;
+    return rhs;
+}
+
+template < unsigned int unique_index, typename word_t >
+inline SafeBitField< unique_index, word_t > operator ^ ( bool, SafeBitField< unique_index, word_t > rhs )
+{
+    Forbidden_conversion< word_t > wrong;
+    return rhs;
+}
+
+template < unsigned int unique_index, typename word_t >
+inline SafeBitField< unique_index, word_t > operator == ( bool, SafeBitField< unique_index, word_t > rhs )
+{
+    Forbidden_conversion< word_t > wrong;
+    return rhs;
+}
+
+template < unsigned int unique_index, typename word_t >
+inline SafeBitField< unique_index, word_t > operator != ( bool, SafeBitField< unique_index, word_t > rhs )
+{
+    Forbidden_conversion< word_t > wrong;
+    return rhs;
+}
+
 // Finally, few macros. All macros are conditionally defined to use the SafeBitField classes if LOKI_SAFE_BIT_FIELD is defined. Otherwise,
 // the macros fall back on the use of typedefs and integer constants. This provides no addititonal safety but allows the code to support the
 // mixture of compilers which are broken to different degrees.
@@ -509,6 +628,26 @@ inline SafeBitField< unique_index, word_t > operator != ( bool, SafeBitField< un
     #define LOKI_BIT_FIELD_COUNT( field_t ) ( 8 * sizeof(field_t) )
 #endif // LOKI_SAFE_BIT_FIELD
 
+// The fifth macro helps to declare compile-time bit constants:
+// LOKI_STATIC_BIT_CONST( field_t, Label_1, 1 );
+// creates a type Label_1_t and an object Label_1 of that type representing the
+// field with the 1st (junior) bit set, where the mask is a template argument
+// and therefore an immediate in the generated code.  Without
+// LOKI_SAFE_BIT_FIELD this falls back to a plain integer constant, like
+// LOKI_BIT_CONST, and the member tests of StaticBitConst are unavailable.
+#ifdef LOKI_SAFE_BIT_FIELD
+    #define LOKI_STATIC_BIT_CONST( field_t, label, bit_index ) \
+        typedef ::Loki::StaticBitConst< field_t::field_index, field_t::bit_word_t, \
+            ( ( bit_index ) > 0 ) ? \
+                ( field_t::bit_word_t(1) << ( ( ( bit_index ) > 0 ) ? ( ( bit_index ) - 1 ) : 0 ) ) : 0 > \
+            label##_t; \
+        static const label##_t label
+#else
+    #define LOKI_STATIC_BIT_CONST( field_t, label, bit_index ) \
+        typedef field_t label##_t; \
+        static const field_t label = make_bit_const( bit_index )
+#endif // LOKI_SAFE_BIT_FIELD
+
 } // namespace Loki
 
 #endif // LOKI_INCLUDED_SAFE_BIT_FIELDS_H
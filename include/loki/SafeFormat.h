@@ -1,6 +1,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Copyright (c) 2005 by Andrei Alexandrescu
-// Copyright (c) 2006 Peter K�mmel
+// Copyright (c) 2006 Peter K�mmel
 // Permission to use, copy, modify, distribute, and sell this software for any
 //     purpose is hereby granted without fee, provided that the above copyright
 //     notice appear in all copies and that both that copyright notice and this
@@ -23,16 +23,21 @@
 
 #include <cstdio>
 #include <climits>
+#include <cfloat>
 #include <string>
 #include <cstring>
 #include <stdexcept>
 #include <utility>
 #include <cassert>
-#include <locale>
+#include <algorithm>
 #include <iostream>
 
 #include <loki/LokiExport.h>
 
+// Declared here so PrintfState can take flex_string arguments by length
+// without dragging in the flex_string headers.
+template <typename E, class T, class A, class Storage> class flex_string;
+
 
 // long is 32 bit on 64-bit Windows!
 // intptr_t used to get 64 bit on Win64
@@ -68,6 +73,88 @@ namespace Loki
     LOKI_EXPORT
     void write(std::string& s, const char* from, const char* to);
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // BufferedSink
+    // A device that batches formatted output in a caller-supplied buffer
+    // and flushes it to a raw file descriptor with a single write() per
+    // batch, instead of going through stdio's locked, character-oriented
+    // path. Meant for hot logging: format many lines, pay one syscall.
+    // The destructor flushes whatever is pending.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class LOKI_EXPORT BufferedSink {
+    public:
+        BufferedSink(int fd, char* buffer, std::size_t capacity)
+        : fd_(fd)
+        , buffer_(buffer)
+        , capacity_(capacity)
+        , used_(0)
+        , good_(true) {
+            assert(buffer != 0 && capacity != 0);
+        }
+
+        ~BufferedSink() {
+            Flush();
+        }
+
+        void Append(const char* from, const char* to) {
+            const std::size_t n = to - from;
+            if (n > capacity_ - used_) {
+                Flush();
+                if (n >= capacity_) {
+                    // larger than the whole buffer: one direct write
+                    WriteFd(from, n);
+                    return;
+                }
+            }
+            memcpy(buffer_ + used_, from, n);
+            used_ += n;
+        }
+
+        // Pushes the buffered bytes to the descriptor - one write() per
+        // call, barring short writes. Returns false once any write has
+        // failed; output after a failure is discarded.
+        bool Flush();
+
+        bool Good() const {
+            return good_;
+        }
+
+    private:
+        BufferedSink(const BufferedSink&);
+        BufferedSink& operator=(const BufferedSink&);
+
+        void WriteFd(const char* b, std::size_t n);
+
+        int fd_;
+        char* buffer_;
+        std::size_t capacity_;
+        std::size_t used_;
+        bool good_;
+    };
+
+    // Write to a buffered file descriptor sink
+    LOKI_EXPORT
+    void write(BufferedSink& sink, const char* from, const char* to);
+
+    // Renders the shortest decimal digit string guaranteed to parse
+    // back to exactly value (Grisu2; see SafeFormat.cpp). value must be
+    // finite and positive; digits needs room for 18 characters and
+    // receives no sign, dot, or terminator. Returns the digit count and
+    // sets decimalExponent so that value = digits * 10^decimalExponent.
+    LOKI_EXPORT
+    int RenderDoubleShortest(double value, char* digits, int& decimalExponent);
+
+    // Discards the output; device for the size-estimation pass (see
+    // CountPrintf below)
+    struct CountingDevice { };
+
+    inline void write(CountingDevice&, const char* from, const char* to) {
+        assert(from <= to);
+        (void)from;
+        (void)to;
+    }
+
     // Write to a fixed-size buffer
     template <class Char>
     void write(std::pair<Char*, std::size_t>& s, const Char* from, const Char* to) {
@@ -80,6 +167,38 @@ namespace Loki
         s.second -= to - from;
     }
 
+    // Flag bits of a printf directive, as decoded from the [-+ #0] flag
+    // characters and the 'h' length modifier. PrintfState tracks them in
+    // this form; the compile-time front end (SafeFormatStatic.h) takes
+    // them as template arguments.
+    enum {
+        fmtLeftJustify = 1,
+        fmtShowSignAlways = 2,
+        fmtBlank = 4,
+        fmtAlternateForm = 8,
+        fmtFillZeros = 16,
+        fmtForceShort = 32
+    };
+
+    // Defined in SafeFormatStatic.h
+    template <class Device, class Char, class TList> struct StaticPrintfState;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // StringSpan
+    // Pointer+length view of characters for %s arguments. The formatter
+    // prints exactly len characters starting at p - embedded zeros
+    // included - without ever calling strlen, so callers which already
+    // know the length (parsers, protocol buffers, substrings of larger
+    // blocks) keep it.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template <class Char>
+    struct StringSpan {
+        StringSpan(const Char* p_, std::size_t len_) : p(p_), len(len_) {}
+        const Char* p;
+        std::size_t len;
+    };
+
     ////////////////////////////////////////////////////////////////////////////////
     // PrintfState class template
     // Holds the formatting state, and implements operator() to format stuff
@@ -94,7 +213,8 @@ namespace Loki
                 , width_(0)
                 , prec_(0)
                 , flags_(0)
-                , result_(0) {
+                , result_(0)
+                , shortestFloats_(false) {
             Advance();
         }
         
@@ -166,6 +286,10 @@ namespace Loki
         
         PrintfState& operator()(double n) {
             if (result_ == -1) return *this; // don't even bother
+            if (shortestFloats_) {
+                FormatShortestFloat(n);
+                return *this;
+            }
             PrintUsing_snprintf(n,"eEfgG");
             return *this;
         }
@@ -191,47 +315,48 @@ namespace Loki
             return StoreCountHelper(pi);
         }
         
+        // Length-aware string arguments: the characters move to the
+        // device in one bulk Write (memcpy for the buffered devices)
+        // instead of through strlen and the character-counting path,
+        // and embedded zeros print rather than truncate.
         PrintfState& operator()(const std::string& stdstr) {
-            return operator()(stdstr.c_str());
+            return PrintStringSpan(stdstr.data(), stdstr.size());
+        }
+
+        template <class T, class A, class S>
+        PrintfState& operator()(const ::flex_string<Char, T, A, S>& str) {
+            return PrintStringSpan(str.data(), str.size());
+        }
+
+        PrintfState& operator()(const StringSpan<Char>& span) {
+            return PrintStringSpan(span.p, span.len);
         }
 
         PrintfState& operator()(const char *const s) {
             if (result_ == -1) return *this;
-            ReadLeaders();
-            const char fmt = *format_;
-            if (fmt == 'p') {
-                FormatWithCurrentFlags(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(s));
-                return *this;
-            }
-            if (fmt != 's') {
-                result_ = -1;
-                return *this;
-            }
-			const size_t len = std::min(std::strlen(s), prec_);
-            if (width_ > len) {
-                if (LeftJustify()) {
-                    Write(s, s + len);
-                    Fill(' ', width_ - len);
-                } else {
-                    Fill(' ', width_ - len);
-                    Write(s, s + len);
-                }
-            } else {
-                Write(s, s + len);
-            }
-            Next();
-            return *this;
+            return PrintStringSpan(s, std::strlen(s));
         }
         
         PrintfState& operator()(const void *const p) {
             return (*this)(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(p));
         }
         
+        // Routes subsequent %e/%E/%f/%g/%G directives (doubles only;
+        // long double stays on the snprintf path) through the shortest
+        // round-trip kernel instead of snprintf. The directive's
+        // precision is ignored: the output is the shortest string that
+        // reads back as the identical double, which is what telemetry
+        // and serialization paths want, and ~10x cheaper than snprintf.
+        PrintfState& ShortestFloats() {
+            shortestFloats_ = true;
+            return *this;
+        }
+
         // read the result
         operator int() const {
             return static_cast<int>(result_);
         }
-        
+
     private:
         PrintfState& operator=(const PrintfState&);
         template <typename T>
@@ -253,6 +378,34 @@ namespace Loki
             return *this;
         }
 
+        PrintfState& PrintStringSpan(const Char *const s, const size_t srcLen) {
+            if (result_ == -1) return *this;
+            ReadLeaders();
+            const char fmt = *format_;
+            if (fmt == 'p') {
+                FormatWithCurrentFlags(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(s));
+                return *this;
+            }
+            if (fmt != 's') {
+                result_ = -1;
+                return *this;
+            }
+            const size_t len = std::min(srcLen, prec_);
+            if (width_ > len) {
+                if (LeftJustify()) {
+                    Write(s, s + len);
+                    Fill(' ', width_ - len);
+                } else {
+                    Fill(' ', width_ - len);
+                    Write(s, s + len);
+                }
+            } else {
+                Write(s, s + len);
+            }
+            Next();
+            return *this;
+        }
+
         void FormatWithCurrentFlags(const LOKI_SAFEFORMAT_UNSIGNED_LONG i) {
             // look at the format character
             Char formatChar = *format_;
@@ -386,25 +539,205 @@ namespace Loki
             Advance(); // output stuff to the next format directive
         }
 
+        // The ShortestFloats() path: Grisu2 digits placed according to
+        // the conversion character, then padded like any directive
+        void FormatShortestFloat(double n) {
+            ReadLeaders();
+            const Char conv = *format_;
+            if (!strchr("eEfgG", conv)) {
+                result_ = -1;
+                return;
+            }
+            const bool upper = conv == 'E' || conv == 'G';
+            // sign + 17 digits + dot + "e+308" + slack; fixed notation
+            // can stretch to ~345 characters near the range ends
+            // zero-initialized: gcc otherwise flags the partially
+            // written buffer when its tail is passed to Write
+            char text[384] = { 0 };
+            char* p = text;
+            if (n != n) {
+                *p++ = upper ? 'N' : 'n';
+                *p++ = upper ? 'A' : 'a';
+                *p++ = upper ? 'N' : 'n';
+                ResetFillZeros(); // printf does not zero-pad nan/inf
+                EmitPadded(text, p);
+                return;
+            }
+            if (n < 0) {
+                *p++ = '-';
+                n = -n;
+            } else if (ShowSignAlways()) {
+                *p++ = '+';
+            } else if (Blank()) {
+                *p++ = ' ';
+            }
+            if (n > DBL_MAX) {
+                *p++ = upper ? 'I' : 'i';
+                *p++ = upper ? 'N' : 'n';
+                *p++ = upper ? 'F' : 'f';
+                ResetFillZeros();
+                EmitPadded(text, p);
+                return;
+            }
+            if (n == 0.0) {
+                *p++ = '0';
+                if (conv == 'e' || conv == 'E') {
+                    memcpy(p, upper ? "E+00" : "e+00", 4);
+                    p += 4;
+                }
+                EmitPadded(text, p);
+                return;
+            }
+            char digits[18];
+            int K;
+            const int len = RenderDoubleShortest(n, digits, K);
+            const int dot = len + K; // digits before the decimal point
+            // %g picks its own notation; stay fixed over the range
+            // where fixed is no longer than exponential
+            const bool fixed = conv == 'f' ||
+                ((conv == 'g' || conv == 'G') && dot > -5 && dot <= 21);
+            if (fixed) {
+                if (dot <= 0) {
+                    *p++ = '0';
+                    *p++ = '.';
+                    for (int i = dot; i < 0; ++i) *p++ = '0';
+                    memcpy(p, digits, len);
+                    p += len;
+                } else if (dot >= len) {
+                    memcpy(p, digits, len);
+                    p += len;
+                    for (int i = len; i < dot; ++i) *p++ = '0';
+                } else {
+                    memcpy(p, digits, dot);
+                    p += dot;
+                    *p++ = '.';
+                    memcpy(p, digits + dot, len - dot);
+                    p += len - dot;
+                }
+            } else {
+                *p++ = digits[0];
+                if (len > 1) {
+                    *p++ = '.';
+                    memcpy(p, digits + 1, len - 1);
+                    p += len - 1;
+                }
+                *p++ = upper ? 'E' : 'e';
+                int e10 = dot - 1;
+                if (e10 < 0) {
+                    *p++ = '-';
+                    e10 = -e10;
+                } else {
+                    *p++ = '+';
+                }
+                if (e10 >= 100) {
+                    *p++ = static_cast<char>('0' + e10 / 100);
+                    e10 %= 100;
+                }
+                *p++ = static_cast<char>('0' + e10 / 10);
+                *p++ = static_cast<char>('0' + e10 % 10);
+            }
+            EmitPadded(text, p);
+        }
+
+        void EmitPadded(const char* b, const char* e) {
+            const size_t len = e - b;
+            if (width_ > len) {
+                const size_t pad = width_ - len;
+                if (LeftJustify()) {
+                    Write(b, e);
+                    Fill(' ', pad);
+                } else if (FillZeros()) {
+                    if (*b == '-' || *b == '+' || *b == ' ') {
+                        Write(b, b + 1);
+                        ++b;
+                    }
+                    Fill('0', pad);
+                    Write(b, e);
+                } else {
+                    Fill(' ', pad);
+                    Write(b, e);
+                }
+            } else {
+                Write(b, e);
+            }
+            Next();
+        }
+
         void Fill(const Char c, size_t n) {
-            for (; n > 0; --n) {
-                Write(&c, &c + 1);
+            if (n == 0) return;
+            // write in blocks, not a device call per character
+            Char block[64];
+            const size_t blockSize = sizeof(block) / sizeof(Char);
+            std::fill(block, block + (n < blockSize ? n : blockSize), c);
+            while (n > 0) {
+                const size_t chunk = n < blockSize ? n : blockSize;
+                Write(block, block + chunk);
+                n -= chunk;
             }
         }
-       
-        Char* RenderWithoutSign(LOKI_SAFEFORMAT_UNSIGNED_LONG n, char* bufLast, 
+
+        // "00".."99" as one flat array; two digits per division
+        static const char* DigitPairs() {
+            static const char pairs[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+            return pairs;
+        }
+
+        Char* RenderWithoutSign(LOKI_SAFEFORMAT_UNSIGNED_LONG n, char* bufLast,
                 unsigned int base, bool uppercase) {
-            const Char hex1st = uppercase ? 'A' : 'a';
-            for (;;) {
-                const LOKI_SAFEFORMAT_UNSIGNED_LONG next = n / base;
-                Char c = static_cast<Char>(n - next * base);
-                c = static_cast<Char>(c + (c <= 9 ? '0' : static_cast<Char>(hex1st - 10)));
-                *bufLast = c;
-                n = next;
-                if (n == 0) break;
-                --bufLast;
+            switch (base) {
+            case 10: {
+                // the table halves the divisions and replaces the
+                // per-digit arithmetic
+                const char* const pairs = DigitPairs();
+                while (n >= 100) {
+                    const LOKI_SAFEFORMAT_UNSIGNED_LONG next = n / 100;
+                    const unsigned int r =
+                        static_cast<unsigned int>(n - next * 100) * 2;
+                    *bufLast = static_cast<Char>(pairs[r + 1]);
+                    *--bufLast = static_cast<Char>(pairs[r]);
+                    --bufLast;
+                    n = next;
+                }
+                if (n >= 10) {
+                    const unsigned int r = static_cast<unsigned int>(n) * 2;
+                    *bufLast = static_cast<Char>(pairs[r + 1]);
+                    *--bufLast = static_cast<Char>(pairs[r]);
+                } else {
+                    *bufLast = static_cast<Char>('0' + n);
+                }
+                return bufLast;
+            }
+            case 16: {
+                const char* const digits = uppercase
+                    ? "0123456789ABCDEF"
+                    : "0123456789abcdef";
+                for (;;) {
+                    *bufLast = static_cast<Char>(digits[n & 15]);
+                    n >>= 4;
+                    if (n == 0) break;
+                    --bufLast;
+                }
+                return bufLast;
+            }
+            default: // octal
+                for (;;) {
+                    *bufLast = static_cast<Char>('0' + (n & 7));
+                    n >>= 3;
+                    if (n == 0) break;
+                    --bufLast;
+                }
+                return bufLast;
             }
-            return bufLast;
         }
 
         char* RenderWithoutSign(LOKI_SAFEFORMAT_SIGNED_LONG n, char* bufLast, unsigned int base, 
@@ -463,15 +796,20 @@ namespace Loki
             }
         }
         
+        // Directives are plain ASCII; querying std::locale for every
+        // character was the hottest part of parsing a directive
+        static bool IsDigit(const Char c) {
+            return c >= Char('0') && c <= Char('9');
+        }
+
         void ParseDecimalSizeT(size_t& dest) {
-            if (!std::isdigit(*format_, std::locale())) return;
+            if (!IsDigit(*format_)) return;
             size_t r = 0;
             do {
-                // TODO: inefficient - rewrite
                 r *= 10;
-                r += *format_ - '0';
+                r += static_cast<size_t>(*format_ - '0');
                 ++format_;
-            } while (std::isdigit(*format_, std::locale()));
+            } while (IsDigit(*format_));
             dest = r;
         }
         
@@ -500,13 +838,17 @@ namespace Loki
             ReadModifiers();
         }
         
-        enum { 
-            leftJustify = 1,
-            showSignAlways = 2,
-            blank = 4,
-            alternateForm = 8,
-            fillZeros = 16,
-            forceShort = 32
+        // The compile-time front end seeds width_/prec_/flags_/format_
+        // directly instead of scanning a format string
+        template <class D, class C, class TL> friend struct StaticPrintfState;
+
+        enum {
+            leftJustify = fmtLeftJustify,
+            showSignAlways = fmtShowSignAlways,
+            blank = fmtBlank,
+            alternateForm = fmtAlternateForm,
+            fillZeros = fmtFillZeros,
+            forceShort = fmtForceShort
         };
         
         bool LeftJustify() const { return (flags_ & leftJustify) != 0; }
@@ -540,6 +882,7 @@ namespace Loki
         size_t prec_;
         unsigned int flags_;
         LOKI_SAFEFORMAT_SIGNED_LONG result_;
+        bool shortestFloats_;
     };
 
     LOKI_EXPORT
@@ -560,12 +903,39 @@ namespace Loki
     LOKI_EXPORT
     PrintfState<std::ostream&, char> FPrintf(std::ostream& f, const std::string& format);
 
+    LOKI_EXPORT
+    PrintfState<BufferedSink&, char> FPrintf(BufferedSink& sink, const char* format);
+
+    LOKI_EXPORT
+    PrintfState<BufferedSink&, char> FPrintf(BufferedSink& sink, const std::string& format);
+
     LOKI_EXPORT
     PrintfState<std::string&, char> SPrintf(std::string& s, const char* format);
 
     LOKI_EXPORT
     PrintfState<std::string&, char> SPrintf(std::string& s, const std::string& format);
 
+    // Formats into a caller-provided span with no allocation; read the
+    // length off the state through operator int(). The output is not
+    // zero-terminated. Overflowing the span throws std::overflow_error;
+    // size the span with CountPrintf when the length is not known.
+    LOKI_EXPORT
+    PrintfState<std::pair<char*, std::size_t>, char>
+    SPrintf(char* buffer, std::size_t size, const char* format);
+
+    LOKI_EXPORT
+    PrintfState<std::pair<char*, std::size_t>, char>
+    SPrintf(char* buffer, std::size_t size, const std::string& format);
+
+    // The size-estimation pass: formats into a counting device that
+    // stores nothing, so operator int() yields the exact length the
+    // same directives and arguments will produce
+    LOKI_EXPORT
+    PrintfState<CountingDevice, char> CountPrintf(const char* format);
+
+    LOKI_EXPORT
+    PrintfState<CountingDevice, char> CountPrintf(const std::string& format);
+
     template <class T, class Char>
     PrintfState<T&, Char> XPrintf(T& device, const Char* format) {
         return PrintfState<T&, Char>(device, format);
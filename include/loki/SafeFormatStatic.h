@@ -0,0 +1,309 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2005 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute, and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the suitability of this software
+//     for any purpose. It is provided "as is" without express or implied
+//     warranty.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LOKI_SAFEFORMATSTATIC_INC_
+#define LOKI_SAFEFORMATSTATIC_INC_
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Compile-time front end for SafePrintf. The regular Printf/SPrintf scan
+// their format string on every call; when the format is a literal (as in
+// logging code) that scan decodes the same flags, width, and precision
+// over and over. Here the directive sequence is spelled once as a
+// typelist and the decoding happens during compilation:
+//
+//     typedef Loki::FormatDirective<'d', 0, 6> CountDirective;
+//     typedef Loki::FormatDirective<'x', Loki::fmtAlternateForm> MaskDirective;
+//     typedef LOKI_TYPELIST_2(CountDirective, MaskDirective) LogFormat;
+//     Loki::StaticSPrintf<LogFormat>(s)("count=")(n)(" mask=")(m);
+//
+// (the typedefs keep the directives' commas out of the typelist macro)
+//
+// Literal text between directives is passed as plain strings and written
+// verbatim, without any scanning - there is no format string left to
+// scan. Each value argument consumes the next directive in the typelist;
+// a surplus argument does not compile. When the pending directive is
+// 's' a string argument is taken as its value; literal text that must
+// precede a string value goes through Verbatim(). The '*' dynamic
+// width/precision specifier has no equivalent here: widths are template
+// arguments.
+//
+// Integer, character, and string directives bypass the scanner entirely
+// and drive PrintfState's formatting engine with the precomputed state.
+// Floating-point directives still go through the snprintf fallback, which
+// needs the directive in textual form; that text is rebuilt from the
+// template arguments, a negligible cost next to snprintf itself.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SafeFormat.h"
+#include "Typelist.h"
+#include "TypeManip.h"
+
+namespace Loki
+{
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // FormatDirective
+    // One printf directive with its decoding done by the compiler:
+    // conversion character, flag bits (the fmt* enumerators in
+    // SafeFormat.h), field width, and precision. A negative precision
+    // means "none", as in printf.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        char conversionChar,
+        unsigned int formatFlags = 0,
+        int formatWidth = 0,
+        int formatPrecision = -1
+    >
+    struct FormatDirective
+    {
+        enum
+        {
+            conversion = conversionChar,
+            flags = formatFlags,
+            width = formatWidth,
+            precision = formatPrecision
+        };
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // StaticPrintfState class template
+    // Formatting state whose directive sequence lives in its type. Each
+    // value argument peels the head directive off the typelist, so the
+    // returned state advances through the sequence at compile time.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template <class Device, class Char, class TList>
+    struct StaticPrintfState
+    {
+        typedef typename TList::Head Head;
+        typedef typename TList::Tail Tail;
+        typedef StaticPrintfState<Device, Char, Tail> ConsumedState;
+        // A string argument is a directive when the head conversion is
+        // 's', and a verbatim literal segment otherwise
+        typedef typename Select
+        <
+            Head::conversion == 's',
+            ConsumedState,
+            StaticPrintfState
+        >::Result StringState;
+
+        explicit StaticPrintfState(const PrintfState<Device, Char>& core)
+        : core_(core)
+        {}
+
+        template <class T>
+        ConsumedState operator()(const T& value)
+        {
+            SeedAndFormat(value);
+            return ConsumedState(core_);
+        }
+
+        StringState operator()(const Char* s)
+        {
+            if (Head::conversion == 's')
+            {
+                SeedAndFormat(s);
+            }
+            else
+            {
+                core_.Write(s, s + std::char_traits<Char>::length(s));
+            }
+            return StringState(core_);
+        }
+
+        StringState operator()(const std::string& s)
+        {
+            return (*this)(s.c_str());
+        }
+
+        // Writes s verbatim even when the pending directive is 's' -
+        // for literal text that immediately precedes a string value
+        StaticPrintfState& Verbatim(const Char* s)
+        {
+            core_.Write(s, s + std::char_traits<Char>::length(s));
+            return *this;
+        }
+
+        // read the result
+        operator int() const
+        {
+            return static_cast<int>(core_);
+        }
+
+        PrintfState<Device, Char> core_;
+
+    private:
+        StaticPrintfState& operator=(const StaticPrintfState&);
+
+        template <class T>
+        void SeedAndFormat(const T& value)
+        {
+            const char conv = char(Head::conversion);
+            core_.width_ = int(Head::width) > 0
+                ? size_t(int(Head::width))
+                : size_t(0);
+            core_.prec_ = int(Head::precision) >= 0
+                ? size_t(int(Head::precision))
+                : size_t(-1);
+            core_.flags_ = unsigned(Head::flags);
+            if (conv == 'e' || conv == 'E' || conv == 'f' ||
+                conv == 'g' || conv == 'G' || conv == 'p')
+            {
+                // PrintUsing_snprintf wants the directive as text; build
+                // it from the template arguments
+                Char buf[32];
+                Char* p = buf;
+                *p++ = Char('%');
+                if (Head::flags & fmtLeftJustify)    *p++ = Char('-');
+                if (Head::flags & fmtShowSignAlways) *p++ = Char('+');
+                if (Head::flags & fmtBlank)          *p++ = Char(' ');
+                if (Head::flags & fmtAlternateForm)  *p++ = Char('#');
+                if (Head::flags & fmtFillZeros)      *p++ = Char('0');
+                if (int(Head::width) > 0)
+                {
+                    p = RenderSize(p, unsigned(int(Head::width)));
+                }
+                if (int(Head::precision) >= 0)
+                {
+                    *p++ = Char('.');
+                    p = RenderSize(p, unsigned(int(Head::precision)));
+                }
+                *p++ = Char(conv);
+                *p = 0;
+                core_.format_ = buf + 1; // one past the '%'
+                core_(value);
+            }
+            else
+            {
+                // the engine needs only the conversion character, with a
+                // '%' before it for the snprintf fallback's benefit
+                static const Char fmt[3] = { Char('%'), Char(conv), 0 };
+                core_.format_ = fmt + 1;
+                core_(value);
+            }
+            // don't leave format_ pointing into a dead stack frame
+            static const Char empty = 0;
+            core_.format_ = &empty;
+        }
+
+        static Char* RenderSize(Char* p, unsigned int n)
+        {
+            Char tmp[12];
+            unsigned int i = 0;
+            do
+            {
+                tmp[i++] = Char('0' + n % 10);
+                n /= 10;
+            }
+            while (n != 0);
+            while (i != 0) *p++ = tmp[--i];
+            return p;
+        }
+    };
+
+    // All directives consumed: only literal segments may follow
+    template <class Device, class Char>
+    struct StaticPrintfState<Device, Char, NullType>
+    {
+        explicit StaticPrintfState(const PrintfState<Device, Char>& core)
+        : core_(core)
+        {}
+
+        StaticPrintfState& operator()(const Char* s)
+        {
+            core_.Write(s, s + std::char_traits<Char>::length(s));
+            return *this;
+        }
+
+        StaticPrintfState& operator()(const std::string& s)
+        {
+            return (*this)(s.c_str());
+        }
+
+        // Same as operator(); kept so chained calls need not care
+        // whether directives remain
+        StaticPrintfState& Verbatim(const Char* s)
+        {
+            return (*this)(s);
+        }
+
+        // read the result
+        operator int() const
+        {
+            return static_cast<int>(core_);
+        }
+
+        PrintfState<Device, Char> core_;
+
+    private:
+        StaticPrintfState& operator=(const StaticPrintfState&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // The front ends, mirroring Printf/FPrintf/SPrintf/XPrintf/BufPrintf.
+    // The directive typelist is the explicit template argument:
+    //     StaticPrintf<MyFormat>()(x)(y);
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template <class TList>
+    StaticPrintfState<std::FILE*, char, TList> StaticPrintf()
+    {
+        return StaticPrintfState<std::FILE*, char, TList>(
+            PrintfState<std::FILE*, char>(stdout, ""));
+    }
+
+    template <class TList>
+    StaticPrintfState<std::FILE*, char, TList> StaticFPrintf(std::FILE* f)
+    {
+        return StaticPrintfState<std::FILE*, char, TList>(
+            PrintfState<std::FILE*, char>(f, ""));
+    }
+
+    template <class TList>
+    StaticPrintfState<std::ostream&, char, TList> StaticFPrintf(std::ostream& f)
+    {
+        return StaticPrintfState<std::ostream&, char, TList>(
+            PrintfState<std::ostream&, char>(f, ""));
+    }
+
+    template <class TList>
+    StaticPrintfState<std::string&, char, TList> StaticSPrintf(std::string& s)
+    {
+        return StaticPrintfState<std::string&, char, TList>(
+            PrintfState<std::string&, char>(s, ""));
+    }
+
+    template <class TList, class T, class Char>
+    StaticPrintfState<T&, Char, TList> StaticXPrintf(T& device)
+    {
+        static const Char empty = 0;
+        return StaticPrintfState<T&, Char, TList>(
+            PrintfState<T&, Char>(device, &empty));
+    }
+
+    template <class TList, class Char, std::size_t N>
+    StaticPrintfState<std::pair<Char*, std::size_t>, Char, TList>
+    StaticBufPrintf(Char (&buf)[N])
+    {
+        static const Char empty = 0;
+        const std::pair<Char*, std::size_t> temp(buf, N);
+        return StaticPrintfState<std::pair<Char*, std::size_t>, Char, TList>(
+            PrintfState<std::pair<Char*, std::size_t>, Char>(temp, &empty));
+    }
+
+}// namespace Loki
+
+
+#endif // end file guardian
@@ -653,6 +653,79 @@ namespace Loki
           ::MakeObjGuard( *obj, memFun, p1, p2, p3 );
     }
 
+    ////////////////////////////////////////////////////////////////
+    ///
+    /// \class FastScopeGuard
+    /// \ingroup ExceptionGroup
+    ///
+    /// Lightweight alternative to ScopeGuard for hot paths.  The callable is
+    /// stored inline by value and invoked straight from the destructor, with
+    /// no try/catch around the call and no common base class, so when the
+    /// callable is visible to the compiler the whole guard inlines and a
+    /// dismissed guard optimizes away to nothing.  The price of the speed:
+    ///
+    /// - The cleanup callable must not throw.  A FastScopeGuard swallows
+    ///   nothing, and its destructor has a throw() specification.
+    /// - A FastScopeGuard cannot be bound to the ScopeGuard typedef.
+    ///   Declare it as a named local of its exact type,
+    ///   \code
+    ///   Loki::FastScopeGuard< void(*)() > guard( &Cleanup );
+    ///   \endcode
+    ///   or bind the result of MakeFastGuard to a const reference of the
+    ///   exact guard type.
+    ///
+    /// Use it where a profile shows the classic ScopeGuard; everywhere else
+    /// the classic one's exception swallowing is worth its cost.
+    ///
+    ////////////////////////////////////////////////////////////////
+
+    template <typename F>
+    class FastScopeGuard
+    {
+    public:
+        explicit FastScopeGuard(F fun) : fun_(fun), dismissed_(false)
+        {}
+
+        /// Copy-constructor takes over responsibility from other guard.
+        FastScopeGuard(const FastScopeGuard& other)
+            : fun_(other.fun_), dismissed_(other.dismissed_)
+        {
+            other.Dismiss();
+        }
+
+        ~FastScopeGuard() throw()
+        {
+            if (!dismissed_)
+                fun_();
+        }
+
+        void Dismiss() const throw()
+        {
+            dismissed_ = true;
+        }
+
+    private:
+        /// Copy-assignment operator is not implemented and private.
+        FastScopeGuard& operator =(const FastScopeGuard&);
+
+        F fun_;
+        mutable bool dismissed_;
+    };
+
+    ////////////////////////////////////////////////////////////////
+    ///
+    /// Creates a FastScopeGuard from any callable taking no parameters.
+    /// The result must be stored in (or bound to a const reference of) its
+    /// exact type - it cannot ride on the ScopeGuard typedef.
+    ///
+    ////////////////////////////////////////////////////////////////
+
+    template <typename F>
+    inline FastScopeGuard<F> MakeFastGuard(F fun)
+    {
+        return FastScopeGuard<F>(fun);
+    }
+
 } // namespace Loki
 
 #define LOKI_CONCATENATE_DIRECT(s1, s2)  s1##s2
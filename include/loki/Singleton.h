@@ -68,10 +68,39 @@ namespace Loki
 #define LOKI_ENABLE_NEW_SETLONGLIVITY_HELPER_DATA_IMPL        
 #ifdef LOKI_ENABLE_NEW_SETLONGLIVITY_HELPER_DATA_IMPL
 
+        ////////////////////////////////////////////////////////////////////////////////
+        // struct TrackerEntry
+        // One registered longevity object.  The longevity is copied out of the
+        // tracker so heap reordering compares plain integers instead of
+        // chasing tracker pointers.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        struct TrackerEntry
+        {
+            unsigned int longevity;
+            // Registration order, to break longevity ties: among objects of
+            // equal longevity the one registered last is destroyed first,
+            // as with the previous sorted-insert implementation.
+            unsigned int seq;
+            LifetimeTracker* tracker;
+
+            // Heap ordering: a < b when a is destroyed after b, so the top
+            // of the max-heap is always the next object to destroy.
+            bool operator<(const TrackerEntry& rhs) const
+            {
+                if (longevity != rhs.longevity)
+                    return longevity > rhs.longevity;
+                return seq < rhs.seq;
+            }
+        };
+
         // Helper data
-        // std::list because of the inserts
-        typedef std::list<LifetimeTracker*> TrackerArray;
+        // a binary heap: registration is O(log n) instead of the O(n)
+        // sorted insert, which matters with tens of thousands of
+        // registered longevity objects
+        typedef std::vector<TrackerEntry> TrackerArray;
         extern LOKI_EXPORT TrackerArray* pTrackerArray;
+        extern LOKI_EXPORT unsigned int trackerSeq;
 #else
         // Helper data
         typedef LifetimeTracker** TrackerArray;
@@ -91,6 +120,13 @@ namespace Loki
             {}
             
             virtual ~LifetimeTracker() = 0;
+
+            // Trackers come from a pool of fixed-size slots carved out of
+            // chunks, so registering a longevity object does not cost a
+            // heap allocation per entry.  Oversized trackers (an unusually
+            // large destroyer functor) fall back to the global operator new.
+            static void* operator new(std::size_t size);
+            static void operator delete(void* p, std::size_t size);
             
             static bool Compare(const LifetimeTracker* lhs,
                 const LifetimeTracker* rhs)
@@ -158,15 +194,16 @@ namespace Loki
         std::auto_ptr<LifetimeTracker> 
             p( new ConcreteLifetimeTracker<T, Destroyer>(pDynObject, longevity, d) );
 
-        // Find correct position
-        TrackerArray::iterator pos = std::upper_bound(
-            pTrackerArray->begin(), 
-            pTrackerArray->end(), 
-            p.get(), 
-            LifetimeTracker::Compare);
-        
-        // Insert the pointer to the ConcreteLifetimeTracker object into the queue
-        pTrackerArray->insert(pos, p.get());
+        TrackerEntry entry;
+        entry.longevity = longevity;
+        entry.seq = trackerSeq;
+        entry.tracker = p.get();
+
+        // Sift the entry into the heap; push_heap only swaps PODs, so
+        // once push_back has succeeded nothing below can throw
+        pTrackerArray->push_back(entry);
+        std::push_heap(pTrackerArray->begin(), pTrackerArray->end());
+        ++trackerSeq;
         
         // nothing has thrown: don't delete the ConcreteLifetimeTracker object
         p.release();
@@ -364,7 +401,11 @@ namespace Loki
     ///  \ingroup LifetimeGroup
     ///  Implementation of the LifetimePolicy used by SingletonHolder
     ///  Schedules an object's destruction as per C++ rules, and it allows object 
-    ///  recreation by not throwing an exception from OnDeadReference
+    ///  recreation by not throwing an exception from OnDeadReference.
+    ///  The once-flag keeping atexit from being registered twice is only
+    ///  touched here, under the holder's creation guard; the alive fast path
+    ///  of SingletonHolder never examines it, so tolerating shutdown ordering
+    ///  costs nothing while the singleton lives.
     ////////////////////////////////////////////////////////////////////////////////
     template <class T>
     class PhoenixSingleton
@@ -387,12 +428,12 @@ namespace Loki
         
     private:
 #ifndef ATEXIT_FIXED
-        static bool destroyedOnce_;
+        static volatile bool destroyedOnce_;
 #endif
     };
     
 #ifndef ATEXIT_FIXED
-    template <class T> bool PhoenixSingleton<T>::destroyedOnce_ = false;
+    template <class T> volatile bool PhoenixSingleton<T>::destroyedOnce_ = false;
 #endif
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -731,7 +772,12 @@ namespace Loki
 
         ///  Returns a reference to singleton object
         static T& Instance();
-        
+
+        ///  Returns a reference to the singleton object without offering to
+        ///  create it.  Only for callers who can guarantee Instance() has
+        ///  already run and the singleton has not yet been destroyed.
+        static T& InstanceFast();
+
     private:
         // Helpers
         static void MakeInstance();
@@ -743,7 +789,7 @@ namespace Loki
         // Data
         typedef typename ThreadingModel<T*,MutexPolicy>::VolatileType PtrInstanceType;
         static PtrInstanceType pInstance_;
-        static bool destroyed_;
+        static volatile bool destroyed_;
     };
     
     ////////////////////////////////////////////////////////////////////////////////
@@ -769,7 +815,7 @@ namespace Loki
         template <class, class> class M,
         class X
     >
-    bool SingletonHolder<T, C, L, M, X>::destroyed_ = false;
+    volatile bool SingletonHolder<T, C, L, M, X>::destroyed_ = false;
 
     ////////////////////////////////////////////////////////////////////////////////
     // SingletonHolder::Instance
@@ -786,11 +832,42 @@ namespace Loki
     inline T& SingletonHolder<T, CreationPolicy, 
         LifetimePolicy, ThreadingModel, MutexPolicy>::Instance()
     {
-        if (!pInstance_)
+        // Double-checked fast path: a load-acquire of the instance
+        // pointer synchronizes with the store-release in MakeInstance,
+        // so once the singleton exists no call ever takes the guard.
+        T* instance = ThreadingModel<T*,MutexPolicy>::
+            AtomicLoadPtrAcquire(pInstance_);
+        if (!instance)
         {
             MakeInstance();
+            instance = pInstance_;
         }
-        return *pInstance_;
+        return *instance;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // SingletonHolder::InstanceFast
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class T,
+        template <class> class CreationPolicy,
+        template <class> class LifetimePolicy,
+        template <class, class> class ThreadingModel,
+        class MutexPolicy
+    >
+    inline T& SingletonHolder<T, CreationPolicy, 
+        LifetimePolicy, ThreadingModel, MutexPolicy>::InstanceFast()
+    {
+        // No creation branch and no dead-reference handling: the caller
+        // promises the singleton already exists.  The load-acquire still
+        // pairs with the store-release in MakeInstance in case the caller's
+        // guarantee rests on another thread having made the instance.
+        T* instance = ThreadingModel<T*,MutexPolicy>::
+            AtomicLoadPtrAcquire(pInstance_);
+        assert(instance);
+        return *instance;
     }
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -815,11 +892,20 @@ namespace Loki
         {
             if (destroyed_)
             {
-                destroyed_ = false;
+                // Resurrection runs once per death, under the guard.  The
+                // policy is consulted before the dead-flag is lowered, so a
+                // policy that vetoes rebirth by throwing leaves the dead
+                // state intact and every later call keeps refusing.
                 LifetimePolicy<T>::OnDeadReference();
+                destroyed_ = false;
             }
-            pInstance_ = CreationPolicy<T>::Create();
-            LifetimePolicy<T>::ScheduleDestruction(pInstance_, 
+            // Publish with a store-release only after the object is fully
+            // constructed, so a thread whose load-acquire in Instance sees
+            // the pointer also sees the object behind it.
+            T* instance = CreationPolicy<T>::Create();
+            ThreadingModel<T*,MutexPolicy>::
+                AtomicAssignPtrRelease(pInstance_, instance);
+            LifetimePolicy<T>::ScheduleDestruction(instance, 
                 &DestroySingleton);
         }
     }
@@ -837,11 +923,76 @@ namespace Loki
     {
         assert(!destroyed_);
         CreationPolicy<T>::Destroy(pInstance_);
-        pInstance_ = 0;
+        // Raise the dead-flag before the pointer is cleared with a
+        // store-release: a thread whose load-acquire in Instance sees the
+        // null pointer then also sees the dead state, and resurrects
+        // through OnDeadReference instead of plainly re-creating.
         destroyed_ = true;
+        M<T*,X>::AtomicAssignPtrRelease(
+            pInstance_, static_cast<T*>(0));
     }
 
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class  SingletonRef
+    ///
+    ///  \ingroup SingletonGroup
+    ///
+    ///  Caches the address of a singleton after the first access, so later
+    ///  accesses through the same SingletonRef cost one plain pointer load -
+    ///  no atomic operation, no creation branch, no destroyed-state checks.
+    ///  Intended for hot loops which hit a singleton (an allocator, a
+    ///  registry) on every iteration: declare one SingletonRef per
+    ///  translation unit, or as a local hoisted out of the loop.
+    ///
+    ///  \par Usage
+    ///  \code
+    ///  typedef Loki::SingletonHolder<Registry> RegistryHolder;
+    ///  static Loki::SingletonRef<RegistryHolder> registry;
+    ///  void Process(Item& item) { registry->Add(item); }
+    ///  \endcode
+    ///
+    ///  The cached pointer is never invalidated, so a SingletonRef must not
+    ///  outlive the singleton - do not use one from destructors which run
+    ///  during program exit unless the singleton's lifetime policy keeps it
+    ///  alive that long.  Each thread caching through the same static
+    ///  SingletonRef may race to fill the cache; every writer stores the
+    ///  same value, and the first access goes through Instance(), which is
+    ///  safe to race on, so the worst case is caching the pointer twice.
+    ///
+    ///  \param SH The SingletonHolder instantiation to cache.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<class SH>
+    class SingletonRef
+    {
+    public:
+
+        ///  Type of the singleton object
+        typedef typename SH::ObjectType ObjectType;
+
+        SingletonRef() : pCached_(0)
+        {}
+
+        ///  Returns a reference to the singleton object, creating it through
+        ///  SH::Instance on the first access.
+        ObjectType& Get()
+        {
+            if (!pCached_)
+                pCached_ = &SH::Instance();
+            return *pCached_;
+        }
+
+        ObjectType& operator*() { return Get(); }
+
+        ObjectType* operator->() { return &Get(); }
+
+    private:
+
+        ///  Address of the singleton, once any access has looked it up.
+        ObjectType* pCached_;
+    };
+
     ////////////////////////////////////////////////////////////////////////////////
     ///  \class  Singleton
     ///
@@ -23,11 +23,30 @@
 #include "Singleton.h"
 #include <cstddef>
 #include <new> // needed for std::nothrow_t parameter.
+#include <vector> // needed for SmallObjRegion's chunk list.
 
 #ifndef LOKI_DEFAULT_CHUNK_SIZE
 #define LOKI_DEFAULT_CHUNK_SIZE 4096
 #endif
 
+#ifdef LOKI_SMALL_OBJECT_ALLOC_PROFILER
+    // Samples each thread's profiler ring can hold; must be a power of two.
+    #ifndef LOKI_SMALL_OBJECT_PROFILE_RING_SIZE
+    #define LOKI_SMALL_OBJECT_PROFILE_RING_SIZE 1024
+    #endif
+    // Return address of the current function, and the thread-local keyword,
+    // for allocation-site attribution.
+    #if defined( _MSC_VER )
+        #include <intrin.h>
+        #pragma intrinsic( _ReturnAddress )
+        #define LOKI_SMALLOBJ_RETURN_ADDRESS() _ReturnAddress()
+        #define LOKI_SMALLOBJ_PROFILER_TLS __declspec( thread )
+    #else
+        #define LOKI_SMALLOBJ_RETURN_ADDRESS() __builtin_return_address( 0 )
+        #define LOKI_SMALLOBJ_PROFILER_TLS __thread
+    #endif
+#endif
+
 #ifndef LOKI_MAX_SMALL_OBJECT_SIZE
 #define LOKI_MAX_SMALL_OBJECT_SIZE 256
 #endif
@@ -40,6 +59,54 @@
 #define LOKI_DEFAULT_SMALLOBJ_LIFETIME ::Loki::LongevityLifetime::DieAsSmallObjectParent
 #endif
 
+// Define LOKI_SMALL_OBJECT_THREAD_CACHE to place a thread-local magazine of
+// blocks in front of each size-class.  The hot path of the new and delete
+// operators then pops or pushes blocks without acquiring the allocator's
+// mutex, which is only taken when a magazine must be refilled from - or
+// flushed back to - the shared FixedAllocator.  Tune the magazine capacity
+// with LOKI_SMALL_OBJECT_MAGAZINE_SIZE.  Requires compiler support for
+// thread-local storage (__thread or __declspec(thread)).
+
+// Define LOKI_SMALL_OBJECT_ATOMIC_FREELIST to give each FixedAllocator an
+// atomic compare-and-swap based list of pending deallocations.  The delete
+// operator then pushes blocks onto that list without acquiring the
+// allocator's mutex, and the locked allocation path drains the list back
+// into the Chunks.  Concurrent deallocations of the same size-class scale
+// across cores instead of serializing on the mutex.  Blocks smaller than a
+// pointer can not carry a link and silently use the locked path.  Requires
+// compiler support for atomic pointer operations (GCC __sync builtins or
+// the MSVC Interlocked family).
+
+// Define LOKI_SMALL_OBJECT_USE_MMAP to back Chunks with large mmap'd
+// regions instead of individual malloc calls.  Chunks are sliced out of
+// region-sized mappings - LOKI_SMALL_OBJECT_REGION_SIZE bytes each - which
+// keeps the allocator's pages contiguous, out of the general heap, and
+// releasable back to the OS a whole region at a time.  Additionally define
+// LOKI_SMALL_OBJECT_USE_HUGE_PAGES to request MAP_HUGETLB mappings (with a
+// transparent fallback to normal pages), which cuts TLB misses on
+// allocation-heavy loops.  POSIX only.
+
+// Define LOKI_SMALL_OBJECT_NUMA_AWARE to give every NUMA node its own
+// allocator instance.  The new operators of Small-Objects then bind each
+// allocation to the calling thread's node, and the delete operators route
+// each block back to the node which allocated it, so block reuse - and the
+// cache lines the bookkeeping touches - stays node-local instead of
+// bouncing between sockets.  The per-node instances are registered with the
+// same LongevityLifetime machinery as the ordinary singleton, so they die
+// at the same late point of the exit sequence.  The map holds up to
+// LOKI_SMALL_OBJECT_NUMA_MAX_NODES nodes (default 8); higher node numbers
+// wrap around, which merely shares an instance and is still correct.
+// Frees always take the allocator's lock so ownership can be checked -
+// hence the magazine and pending-list fast paths of the delete operators
+// are disabled in this mode, though the allocation-side magazine still
+// works.  Linux only, since node discovery uses the getcpu system call.
+
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+    #ifndef LOKI_SMALL_OBJECT_NUMA_MAX_NODES
+        #define LOKI_SMALL_OBJECT_NUMA_MAX_NODES 8
+    #endif
+#endif
+
 #if defined(LOKI_SMALL_OBJECT_USE_NEW_ARRAY) && defined(_MSC_VER)
 #pragma message("Don't define LOKI_SMALL_OBJECT_USE_NEW_ARRAY when using a Microsoft compiler to prevent memory leaks.")
 #pragma message("now calling '#undef LOKI_SMALL_OBJECT_USE_NEW_ARRAY'")
@@ -77,6 +144,52 @@ namespace Loki
 
     class FixedAllocator;
 
+    /** @struct AllocatorStats
+        @ingroup SmallObjectGroupInternal
+     Snapshot of the counters one FixedAllocator maintains about its
+     size-class.  The counters are plain increments done on paths which
+     already hold the allocator's lock, so keeping them costs almost nothing
+     and they are always compiled in.  Blocks parked in thread-local
+     magazines (see LOKI_SMALL_OBJECT_THREAD_CACHE) count as live since the
+     shared pool has handed them out.
+     */
+    struct AllocatorStats
+    {
+        std::size_t blockSize;       ///< Byte size of blocks in this size-class.
+        std::size_t allocCount;      ///< Total # of blocks ever handed out.
+        std::size_t deallocCount;    ///< Total # of blocks ever returned.
+        std::size_t liveBlocks;      ///< # of blocks currently held by callers.
+        std::size_t chunkCount;      ///< # of Chunks currently allocated.
+        std::size_t blocksPerChunk;  ///< Capacity of each Chunk in blocks.
+        std::size_t highWaterBlocks; ///< Most blocks ever simultaneously live.
+    };
+
+    /** Callback invoked whenever a FixedAllocator acquires or releases a
+     Chunk, so heap growth can be watched in production.  Called with the
+     allocator's lock held, so the callback must not reenter the allocator
+     nor block.
+     @param blockSize Byte size of the size-class acquiring or releasing.
+     @param chunkBytes Total # of bytes in the Chunk.
+     @param acquired True when a Chunk was just acquired, false when released.
+     */
+    typedef void ( * ChunkEventCallback )( std::size_t blockSize,
+        std::size_t chunkBytes, bool acquired );
+
+    /** Callback by which a client relocates one live block during
+     compaction.  The allocator has already copied the block's bytes from
+     oldPlace to newPlace; the callback must repoint every reference the
+     program holds to oldPlace - or return false to refuse, which makes the
+     allocator discard newPlace, keep the block where it was, and stop
+     compacting the current Chunk.  Called with the allocator's lock held,
+     so it must not reenter the allocator.
+     @param oldPlace Address the block is moving away from.
+     @param newPlace Address the block now lives at if true is returned.
+     @param blockSize # of bytes in the block's size-class.
+     @return True if references were repointed and the move may commit.
+     */
+    typedef bool ( * BlockRelocator )( void * oldPlace, void * newPlace,
+        std::size_t blockSize );
+
     /** @class SmallObjAllocator
         @ingroup SmallObjectGroupInternal
      Manages pool of fixed-size allocators.
@@ -134,12 +247,49 @@ namespace Loki
          */
         void * Allocate( std::size_t size, bool doThrow );
 
+        /** Allocates a block from the size-class at index, which the caller
+         already computed - typically at compile time through
+         AllocatorSingleton::AllocateSized - so the offset division and the
+         oversize checks of Allocate vanish from the hot path.  index must
+         be less than GetFixedAllocatorCount().  Exception-safety matches
+         Allocate; Allocate itself delegates here after mapping its size.
+         */
+        void * AllocateAtIndex( std::size_t index, bool doThrow );
+
+        /** Deallocates a block belonging to the size-class at index.  The
+         counterpart of AllocateAtIndex; Deallocate delegates here after
+         mapping its size.  This never throws.
+         */
+        void DeallocateAtIndex( void * p, std::size_t index );
+
+        /** Allocates a block of memory of requested size whose address is a
+         multiple of the requested alignment, so hot objects can get whole
+         cache lines to themselves without every small object paying for one.
+         Alignments up to the allocator's own boundary (GetAlignment) cost
+         nothing extra and go through the normal pool.  Larger alignments -
+         which must be powers of two - are served by dedicated
+         FixedAllocator's created on first use for that alignment, whose
+         Chunks are themselves aligned, so only the types which ask for
+         alignment pay the padding.  Exception-safety matches Allocate.
+         @param size # of bytes needed for allocation.
+         @param alignment Required address alignment in bytes, a power of two.
+         @param doThrow True to throw on failure, false to return NULL.
+         */
+        void * Allocate( std::size_t size, std::size_t alignment,
+            bool doThrow );
+
         /** Deallocates a block of memory at a given place and of a specific
         size.  Complexity is almost always constant-time, and is O(C) only if
         it has to search for which Chunk deallocates.  This never throws.
          */
         void Deallocate( void * p, std::size_t size );
 
+        /** Deallocates a block which was allocated through the alignment-
+         aware Allocate overload.  The same size and alignment must be passed
+         so the block is routed back to its dedicated pool.  Never throws.
+         */
+        void Deallocate( void * p, std::size_t size, std::size_t alignment );
+
         /** Deallocates a block of memory at a given place but of unknown size
         size.  Complexity is O(F + C) where F is the count of FixedAllocator's
         in the pool, and C is the number of Chunks in all FixedAllocator's.  This
@@ -149,6 +299,130 @@ namespace Loki
          */
         void Deallocate( void * p );
 
+        /** Returns true if a block at this address and of this size belongs
+         to one of this allocator's Chunks.  Complexity is O(C) over the
+         Chunks of one size-class.  Never throws.  Used to route blocks home
+         when several allocator instances coexist, as in NUMA-aware mode.
+         */
+        bool Owns( void * p, std::size_t size ) const;
+
+        /** Deallocates a block of unknown size if - and only if - it belongs
+         to one of this allocator's Chunks.  Unlike the one-argument
+         Deallocate, an unrecognized block is left alone rather than handed
+         to the default deallocator, so a caller can probe several allocator
+         instances in turn.  Never throws.
+         @return True if this allocator owned and released the block.
+         */
+        bool TryDeallocate( void * p );
+
+        /** Releases every Chunk of every size-class wholesale - no
+         per-block accounting - and ignores all deallocations from then
+         on, so outstanding blocks may simply be abandoned.  Complexity is
+         O(F + C) where F is the count of FixedAllocator's and C the
+         number of Chunks, independent of how many blocks are live.  Only
+         call at a quiescent point when no block of this allocator will be
+         dereferenced again; a stray late deallocation is ignored rather
+         than corrupting the pool.  Allocation still works afterwards and
+         starts fresh Chunks, but such blocks leak, so treat the allocator
+         as finished.  Never throws.
+         */
+        void ShutdownFast( void );
+
+        /** Allocates count blocks of the requested size in one call so that
+         batch-oriented clients pay the size-class lookup, the Chunk search,
+         and - when called under a ThreadingModel lock - the lock acquisition
+         only once per batch instead of once per block.  Blocks are carved out
+         of as few Chunks as possible.  Exception safety matches Allocate:
+         with doThrow true this throws std::bad_alloc if it can not supply the
+         whole batch - after returning any partially allocated blocks - and
+         with doThrow false it never throws and returns a partial count.
+         @param size # of bytes needed for each block.
+         @param count # of blocks requested.
+         @param out Caller-supplied array with room for count pointers.
+         @param doThrow True to throw on failure, false to return short count.
+         @return # of blocks actually allocated - always count if doThrow.
+         */
+        std::size_t AllocateBatch( std::size_t size, std::size_t count,
+            void ** out, bool doThrow );
+
+        /** Deallocates count blocks which were all allocated with the same
+         size, paying the size-class lookup once per batch.  The blocks need
+         not come from one AllocateBatch call - any group of same-sized blocks
+         from this allocator may be released together.  This never throws.
+         @param blocks Array of count block addresses; NULL entries are ignored.
+         @param count # of entries in blocks.
+         @param size # of bytes with which each block was allocated.
+         */
+        void DeallocateBatch( void ** blocks, std::size_t count,
+            std::size_t size );
+
+        /** Tunes one size-class to its measured workload instead of the
+         global page size every class inherits from the constructor.  The
+         chunk size sets how many blocks each Chunk of the class carries
+         (capped at 255, the most a Chunk can index); a hot class gets big
+         chunks to cut chunk churn, a rare class gets small ones so it stops
+         wasting pages.  reserveChunks Chunks are created immediately, so a
+         class known to be hot skips its warm-up churn; a nonzero maxChunks
+         caps how many Chunks the class may ever own, after which its
+         allocations fail like any exhaustion (NULL or std::bad_alloc).
+
+         This must be called before the first allocation of that size-class
+         - reshaping live Chunks would orphan their blocks - and returns
+         false if the class is already in use, so a late call is detected
+         rather than ignored.  On AllocatorSingleton, call it under the
+         ThreadingModel's lock during program setup, like any allocator
+         function.  A configured reserve deliberately keeps several empty
+         Chunks alive; the DO_EXTRA_LOKI_TESTS audits assume at most one
+         empty Chunk and do not model reserves.
+
+         @param objectSize Size in bytes whose class is configured; must not
+          exceed GetMaxObjectSize().
+         @param chunkSize # of bytes in each Chunk of this class.
+         @param reserveChunks # of Chunks to create now.
+         @param maxChunks Most Chunks the class may own, or 0 for no cap.
+         @return True if the class was configured and reserved.
+         */
+        bool ConfigureSizeClass( std::size_t objectSize, std::size_t chunkSize,
+            std::size_t reserveChunks, std::size_t maxChunks );
+
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+        /** Attempts to pop a block from the calling thread's magazine for the
+         size-class of the request.  This only touches thread-local storage, so
+         it requires no lock, and is therefore safe to call before acquiring
+         the allocator's mutex.  The magazine is refilled as a side-effect of
+         the next locked call to Allocate, so a NULL return here merely means
+         the caller must take the slow, locked path.  This never throws.
+         @return Pointer to cached block, or NULL if the magazine is empty or
+          the request can not be served from a magazine.
+         */
+        void * ThreadCacheAllocate( std::size_t size );
+
+        /** Attempts to push a block onto the calling thread's magazine for
+         the size-class of the block.  This only touches thread-local storage,
+         so it requires no lock.  If the magazine is full, this returns false
+         and the caller must take the locked path through Deallocate, which
+         flushes part of the magazine back to the shared FixedAllocator under
+         that single lock acquisition.  This never throws.
+         @return True if block was cached, false if caller must call Deallocate.
+         */
+        bool ThreadCacheDeallocate( void * p, std::size_t size );
+#endif
+
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+        /** Attempts to push a block onto the atomic pending-free list of the
+         FixedAllocator for its size-class.  This uses a compare-and-swap loop
+         instead of the allocator's mutex, so concurrent calls from different
+         threads do not serialize.  The block is threaded back into a Chunk by
+         the next locked call to Allocate or Deallocate for that size-class.
+         This never throws.
+         @return True if the block was queued, false if the caller must take
+          the locked path through Deallocate - either because the size-class
+          is too small to hold a link pointer, or the size is not served by
+          any FixedAllocator.
+         */
+        bool DeferDeallocate( void * p, std::size_t size );
+#endif
+
         /// Returns max # of bytes which this can allocate.
         inline std::size_t GetMaxObjectSize() const
         { return maxSmallObjectSize_; }
@@ -165,6 +439,23 @@ namespace Loki
          */
         bool TrimExcessMemory( void );
 
+        /** Incrementally compacts the pool by migrating live blocks out of
+         sparsely used Chunks into the free space of fuller ones, so that
+         TrimExcessMemory and the normal empty-Chunk machinery can then
+         release whole Chunks which a handful of stragglers used to pin in
+         memory.  Only blocks whose owners opted in through the relocator
+         callback move; each move copies the block's bytes and asks the
+         relocator to repoint references.  Work is bounded by maxMoves so
+         callers can drive compaction in small time-budgeted steps from a
+         maintenance loop.  Like Allocate, this must be called under the
+         allocator's ThreadingModel lock in threaded programs.
+         @param relocator Client callback which repoints references.
+         @param maxMoves Most blocks to migrate in this step.
+         @return # of blocks actually migrated - zero when the pool is as
+          compact as the relocator allows.
+         */
+        std::size_t Compact( BlockRelocator relocator, std::size_t maxMoves );
+
         /** Returns true if anything in implementation is corrupt.  Complexity
          is O(F + C + B) where F is the count of FixedAllocator's in the pool,
          C is the number of Chunks in all FixedAllocator's, and B is the number
@@ -175,6 +466,27 @@ namespace Loki
          */
         bool IsCorrupt( void ) const;
 
+        /// Returns # of FixedAllocator's in the pool - one per size-class.
+        std::size_t GetFixedAllocatorCount( void ) const;
+
+        /** Copies the counters of one size-class into stats.  The counters
+         are updated under the allocator's lock, so a caller wanting a
+         consistent snapshot across concurrent use should hold that lock too;
+         a merely informational reading needs no lock.  This never throws.
+         @param index Size-class index, from 0 to GetFixedAllocatorCount()-1.
+         @param stats Receives the snapshot.
+         @return False if index is out of range.
+         */
+        bool GetStats( std::size_t index, AllocatorStats & stats ) const;
+
+        /** Installs a callback invoked on every Chunk acquisition and
+         release, for all size-classes of this allocator.  Pass NULL to
+         remove the hook.  The callback runs with the allocator's lock held.
+         Chunks released wholesale by the allocator's destructor do not fire
+         the callback.
+         */
+        void SetChunkEventCallback( ChunkEventCallback callback );
+
     private:
         /// Default-constructor is not implemented.
         SmallObjAllocator( void );
@@ -186,11 +498,23 @@ namespace Loki
         /// Pointer to array of fixed-size allocators.
         Loki::FixedAllocator * pool_;
 
+        /// Lazily created pools for alignments above objectAlignSize_, one
+        /// set of FixedAllocator's per distinct alignment.  Hidden behind a
+        /// pointer so the implementation stays in the source file.
+        struct AlignedPools * alignedPools_;
+
+        /// Page size given at construction - kept so aligned pools created
+        /// later use the same Chunk size as the normal pool.
+        const std::size_t pageSize_;
+
         /// Largest object size supported by allocators.
         const std::size_t maxSmallObjectSize_;
 
         /// Size of alignment boundaries.
         const std::size_t objectAlignSize_;
+
+        /// True after ShutdownFast; deallocations are ignored from then on.
+        bool shutdown_;
     };
 
 
@@ -210,6 +534,14 @@ namespace Loki
      SmallValueObject inheritance hierarchies are the new and delete
      operators.
     */
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+    /** @ingroup SmallObjectGroupInternal
+     Returns the NUMA node the calling thread currently runs on, or zero
+     when the platform offers no way to tell.  Implemented in SmallObj.cpp.
+     */
+    unsigned int GetCurrentNumaNode( void );
+#endif
+
     template
     <
         template <class, class> class ThreadingModel = LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL,
@@ -240,6 +572,158 @@ namespace Loki
             return MyAllocatorSingleton::Instance();
         }
 
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+
+        /** Returns the allocator instance bound to the calling thread's
+         NUMA node, creating it on first use.  Creation is not internally
+         synchronized - like SmallObjAllocator's own functions, this must be
+         called under the ThreadingModel's lock in threaded programs, which
+         the new and delete operators of Small-Objects already do.
+         */
+        static AllocatorSingleton & NodeInstance( void );
+
+        /// Returns the calling thread's node instance without creating it,
+        /// or NULL if no allocation happened on this node yet.  Safe to
+        /// call without the lock, which the lock-free fast paths need.
+        inline static AllocatorSingleton * NodePeek( void )
+        {
+            return nodes_[ GetCurrentNumaNode()
+                % LOKI_SMALL_OBJECT_NUMA_MAX_NODES ];
+        }
+
+        /** Routes a block back to whichever node's allocator owns it.  The
+         calling thread's own node is checked first since frees are usually
+         node-local.  Must be called under the ThreadingModel's lock.
+         */
+        static void NodeDeallocate( void * p, std::size_t size );
+
+        /// Routes a block of unknown size back to its owning node.
+        static void NodeDeallocate( void * p );
+
+#endif // LOKI_SMALL_OBJECT_NUMA_AWARE
+
+        /** Allocates a block for an object whose size is known at compile
+         time - as sizeof(T) is at every operator new call site.  The
+         mapping from size to size-class, which Allocate performs with an
+         addition and a division on every call, is evaluated by the
+         compiler here, so execution starts directly at the right
+         FixedAllocator.  Sizes above maxSmallObjectSize compile straight
+         into the ordinary fallback path.  Like Allocate, this must be
+         called under the ThreadingModel's lock in threaded programs.
+         */
+        template < std::size_t numBytes >
+        inline static void * AllocateSized( bool doThrow )
+        {
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            MyAllocator & allocator = NodeInstance();
+#else
+            MyAllocator & allocator = Instance();
+#endif
+            if ( numBytes > maxSmallObjectSize )
+                return allocator.Allocate( numBytes, doThrow );
+            return allocator.AllocateAtIndex(
+                ( ( 0 == numBytes ? 1 : numBytes ) + objectAlignSize - 1 )
+                    / objectAlignSize - 1, doThrow );
+        }
+
+        /** Deallocates a block whose size is known at compile time.  The
+         counterpart of AllocateSized, with the same compile-time size-class
+         mapping.  Must be called under the ThreadingModel's lock.
+         */
+        template < std::size_t numBytes >
+        inline static void DeallocateSized( void * p )
+        {
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            // Blocks may belong to another node, so route them home; the
+            // compile-time mapping still spares the local ownership probe
+            // its division.
+            NodeDeallocate( p, numBytes );
+#else
+            if ( numBytes > maxSmallObjectSize )
+            {
+                Instance().Deallocate( p, numBytes );
+                return;
+            }
+            Instance().DeallocateAtIndex( p,
+                ( ( 0 == numBytes ? 1 : numBytes ) + objectAlignSize - 1 )
+                    / objectAlignSize - 1 );
+#endif
+        }
+
+        /** @class Arena
+         A caller-held handle to the allocator a thread should use.  Every
+         operator new of a Small-Object re-resolves Instance() - and the
+         current NUMA node in NUMA-aware builds - on each call.  A tight
+         loop constructing many objects can instead obtain an Arena once
+         per work item with GetArena and allocate through it, hoisting
+         that resolution out of the loop; the batch functions then pay
+         the remaining per-call costs once per batch too.
+
+         The handle is a plain value: cheap to copy and pass by value,
+         holding no ownership.  It obeys the same rules as calling the
+         allocator directly - use it under the ThreadingModel's lock in
+         threaded programs - and it should not outlive its work item: in
+         NUMA-aware builds the node binding is fixed when the handle is
+         obtained, so a handle carried across threads or blocking points
+         would keep allocating from the old node.
+        */
+        class Arena
+        {
+        public:
+
+            inline void * Allocate( std::size_t numBytes, bool doThrow )
+            {
+                return allocator_->Allocate( numBytes, doThrow );
+            }
+
+            inline void Deallocate( void * p, std::size_t numBytes )
+            {
+                allocator_->Deallocate( p, numBytes );
+            }
+
+            /// AllocateBatch of the held allocator; with an Arena the
+            /// singleton resolution is paid zero times per block.
+            inline std::size_t AllocateBatch( std::size_t size,
+                std::size_t count, void ** out, bool doThrow )
+            {
+                return allocator_->AllocateBatch( size, count, out, doThrow );
+            }
+
+            inline void DeallocateBatch( void ** blocks, std::size_t count,
+                std::size_t size )
+            {
+                allocator_->DeallocateBatch( blocks, count, size );
+            }
+
+            /// The held allocator, for the less common entry points.
+            inline MyAllocator & GetAllocator( void )
+            {
+                return *allocator_;
+            }
+
+        private:
+            friend class AllocatorSingleton;
+            inline explicit Arena( MyAllocator & allocator ) :
+                allocator_( &allocator )
+            {}
+            MyAllocator * allocator_;
+        };
+
+        /** Returns a handle to the allocator the calling thread should
+         use now: the node instance in NUMA-aware builds, the singleton
+         otherwise.  Obtain it once per work item.  Like the new and
+         delete operators' own resolution, this must be called under the
+         ThreadingModel's lock in threaded programs.
+         */
+        inline static Arena GetArena( void )
+        {
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            return Arena( NodeInstance() );
+#else
+            return Arena( Instance() );
+#endif
+        }
+
         /// The default constructor is not meant to be called directly.
         inline AllocatorSingleton() :
             SmallObjAllocator( chunkSize, maxSmallObjectSize, objectAlignSize )
@@ -258,6 +742,34 @@ namespace Loki
          */
         static void ClearExtraMemory( void );
 
+        /** Fast teardown for controlled restarts: releases every Chunk of
+         the singleton allocator wholesale and disables its deallocation
+         bookkeeping, bypassing the per-object destructor churn an
+         ordinary exit pays while the longevity tracker unwinds.  Call at
+         a quiescent point when no small object of this allocator will be
+         allocated or dereferenced again.  Objects still alive simply keep
+         their destructors unrun - which is the point for trivially
+         destructible classes; classes whose destructors matter must be
+         destroyed before calling this.  A stray late delete still runs
+         the object's destructor but its memory release is ignored, so it
+         does not corrupt the pool.  The singleton object itself stays
+         registered with its LifetimePolicy and dies as usual at exit; by
+         then it owns no Chunks, so that destruction is trivial.
+         */
+        static void ShutdownFast( void )
+        {
+            typename MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            for ( std::size_t ii = 0; ii < LOKI_SMALL_OBJECT_NUMA_MAX_NODES; ++ii )
+            {
+                if ( 0 != nodes_[ ii ] )
+                    nodes_[ ii ]->SmallObjAllocator::ShutdownFast();
+            }
+#endif
+            Instance().SmallObjAllocator::ShutdownFast();
+        }
+
         /** Returns true if anything in implementation is corrupt.  Complexity
          is O(F + C + B) where F is the count of FixedAllocator's in the pool,
          C is the number of Chunks in all FixedAllocator's, and B is the number
@@ -273,8 +785,117 @@ namespace Loki
         AllocatorSingleton( const AllocatorSingleton & );
         /// Copy-assignment operator is not implemented.
         AllocatorSingleton & operator = ( const AllocatorSingleton & );
+
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+        /// Map from NUMA node number to that node's allocator instance.
+        static MyAllocator * nodes_[ LOKI_SMALL_OBJECT_NUMA_MAX_NODES ];
+#endif
     };
 
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+
+    template
+    <
+        template <class, class> class T,
+        std::size_t C,
+        std::size_t M,
+        std::size_t O,
+        template <class> class L,
+        class X
+    >
+    typename AllocatorSingleton< T, C, M, O, L, X >::MyAllocator *
+    AllocatorSingleton< T, C, M, O, L, X >::nodes_[
+        LOKI_SMALL_OBJECT_NUMA_MAX_NODES ] = { 0 };
+
+    template
+    <
+        template <class, class> class T,
+        std::size_t C,
+        std::size_t M,
+        std::size_t O,
+        template <class> class L,
+        class X
+    >
+    AllocatorSingleton< T, C, M, O, L, X > &
+    AllocatorSingleton< T, C, M, O, L, X >::NodeInstance( void )
+    {
+        const unsigned int node =
+            GetCurrentNumaNode() % LOKI_SMALL_OBJECT_NUMA_MAX_NODES;
+        MyAllocator * instance = nodes_[ node ];
+        if ( NULL == instance )
+        {
+            instance = new MyAllocator;
+            // Registering with SetLongevity destroys each node's allocator
+            // at the same late point of the exit sequence as the singleton
+            // itself, so objects with shorter lifetimes can still be freed.
+            Loki::SetLongevity( instance, GetLongevity( instance ) );
+            nodes_[ node ] = instance;
+        }
+        return *instance;
+    }
+
+    template
+    <
+        template <class, class> class T,
+        std::size_t C,
+        std::size_t M,
+        std::size_t O,
+        template <class> class L,
+        class X
+    >
+    void AllocatorSingleton< T, C, M, O, L, X >::NodeDeallocate( void * p,
+        std::size_t size )
+    {
+        if ( NULL == p ) return;
+        MyAllocator & local = NodeInstance();
+        // Oversize blocks came from the default allocator and belong to no
+        // node; frees of node-local blocks - the common case - stop here too.
+        if ( ( size > local.GetMaxObjectSize() ) || local.Owns( p, size ) )
+        {
+            local.Deallocate( p, size );
+            return;
+        }
+        for ( unsigned int ii = 0; ii < LOKI_SMALL_OBJECT_NUMA_MAX_NODES; ++ii )
+        {
+            MyAllocator * other = nodes_[ ii ];
+            if ( ( NULL != other ) && ( other != &local )
+                && other->Owns( p, size ) )
+            {
+                other->Deallocate( p, size );
+                return;
+            }
+        }
+        // No node owns the block, so it came from the plain singleton -
+        // code sharing the process may still use Instance() directly -
+        // whose Deallocate also covers the default-allocator case.
+        Instance().Deallocate( p, size );
+    }
+
+    template
+    <
+        template <class, class> class T,
+        std::size_t C,
+        std::size_t M,
+        std::size_t O,
+        template <class> class L,
+        class X
+    >
+    void AllocatorSingleton< T, C, M, O, L, X >::NodeDeallocate( void * p )
+    {
+        if ( NULL == p ) return;
+        for ( unsigned int ii = 0; ii < LOKI_SMALL_OBJECT_NUMA_MAX_NODES; ++ii )
+        {
+            MyAllocator * other = nodes_[ ii ];
+            if ( ( NULL != other ) && other->TryDeallocate( p ) )
+                return;
+        }
+        // Not node-local: the plain singleton probes its own Chunks and
+        // falls back to the default deallocator.
+        Instance().Deallocate( p );
+    }
+
+#endif // LOKI_SMALL_OBJECT_NUMA_AWARE
+
     template
     <
         template <class, class> class T,
@@ -336,6 +957,247 @@ namespace Loki
     }
 
 
+#ifdef LOKI_SMALL_OBJECT_ALLOC_PROFILER
+
+    /** @class SmallObjProfiler
+        @ingroup SmallObjectGroup
+     Opt-in allocation-site profiler for the Small-Object new operators,
+     compiled in by defining LOKI_SMALL_OBJECT_ALLOC_PROFILER.  One in every
+     SetSamplingRate(N) allocations records a (return address, size) sample
+     into the calling thread's lock-free ring buffer, so attribution runs in
+     production at the cost of one thread-local decrement per allocation
+     plus the occasional ring push.  Samples name the call site of the new
+     operator - the caller of new when the operator is inlined there - and
+     can be fed to addr2line or the platform's symbolizer.
+
+     Rings hold LOKI_SMALL_OBJECT_PROFILE_RING_SIZE samples each.  When the
+     drainer does not keep up, new samples are dropped and counted rather
+     than stalling the allocating thread.  Drain walks every thread's ring
+     and must be called by one thread at a time - typically a dedicated
+     profiler thread.  A thread's ring is created on its first sample and
+     lives until the process exits.
+     */
+    class LOKI_EXPORT SmallObjProfiler
+    {
+    public:
+
+        /// One recorded allocation.
+        struct Sample
+        {
+            void * site;        ///< Return address of the new call.
+            std::size_t size;   ///< Requested size in bytes.
+        };
+
+        /** Sets the sampling rate: one in every rate allocations gets
+         sampled; zero turns sampling off, which is the default.  Running
+         threads notice a change within a bounded number of allocations.
+         */
+        static void SetSamplingRate( unsigned long rate );
+
+        /// Returns the current sampling rate, zero when off.
+        static unsigned long GetSamplingRate( void );
+
+        /** Copies and removes up to max samples from the rings of all
+         threads.  Call from one drainer thread at a time.
+         @return # of samples written to out.
+         */
+        static std::size_t Drain( Sample * out, std::size_t max );
+
+        /// Returns # of samples dropped into full rings so far.
+        static unsigned long GetDroppedCount( void );
+
+        /// Called by the Small-Object new operators; not for clients.
+        inline static void Count( void * site, std::size_t size )
+        {
+            if ( 0 == --countdown_ )
+                Record( site, size );
+        }
+
+    private:
+
+        /// Records one sample and rearms the countdown.
+        static void Record( void * site, std::size_t size );
+
+        /// Allocations left on this thread until the next sample.  Starts
+        /// at one so each thread's first allocation consults the rate.
+        static LOKI_SMALLOBJ_PROFILER_TLS unsigned long countdown_;
+    };
+
+#endif // LOKI_SMALL_OBJECT_ALLOC_PROFILER
+
+#ifdef LOKI_SMALL_OBJECT_ALLOC_TRACE
+
+    /** @class SmallObjTracer
+        @ingroup SmallObjectGroup
+     Opt-in allocation trace for SmallObjAllocator, compiled in by defining
+     LOKI_SMALL_OBJECT_ALLOC_TRACE.  While a trace runs, every pool
+     allocation and deallocation appends one fixed-size binary record -
+     operation, size-class byte size, slot id, small thread id - to an
+     in-memory buffer which is written to the trace file whenever it fills,
+     so the steady-state overhead is one buffered copy per operation.  The
+     slot id is the block's address at record time; replay treats it as an
+     opaque key for pairing each free with its allocation.  Requests larger
+     than the small-object threshold go to the default allocator and are
+     not recorded.
+
+     The file starts with an 8-byte header - 'LKSO', format version, record
+     size, sizeof(size_t) - and is written in the host's native widths and
+     byte order, so traces replay on the platform that recorded them.  The
+     replay driver lives in test/SmallObj/SmallObjReplay.cpp.
+     */
+    class LOKI_EXPORT SmallObjTracer
+    {
+    public:
+
+        /// One operation in the binary stream.
+        struct Record
+        {
+            std::size_t slot;       ///< Block address when recorded; opaque id on replay.
+            unsigned int size;      ///< Size-class size in bytes.
+            unsigned char op;       ///< One of the Operation values.
+            unsigned char thread;   ///< Small sequential id of the calling thread.
+            unsigned char reserved[ 2 ]; ///< Keeps the record at a fixed width.
+        };
+
+        /// Values for Record::op.
+        enum Operation
+        {
+            OpAllocate = 0,
+            OpDeallocate = 1
+        };
+
+        /** Starts recording into the named file.  No-op returning false if a
+         trace is already running or the file cannot be made.
+         @param path File the binary stream is written to.
+         @param bufferRecords Records buffered between writes.
+         */
+        static bool Start( const char * path, std::size_t bufferRecords = 4096 );
+
+        /// Flushes and closes the running trace.  Safe to call when idle.
+        static void Stop( void );
+
+        /// Returns true while a trace is recording.
+        static bool IsTracing( void );
+
+        /// Returns # of records lost to file-write failures so far.
+        static unsigned long GetDroppedCount( void );
+
+        /// Called by SmallObjAllocator; not for clients.
+        static void Trace( unsigned char op, void * slot, std::size_t size );
+    };
+
+#endif // LOKI_SMALL_OBJECT_ALLOC_TRACE
+
+#ifdef LOKI_SMALL_OBJECT_ALLOC_PROFILER
+    #define LOKI_SMALLOBJ_PROFILE_ALLOC( size ) \
+        ::Loki::SmallObjProfiler::Count( LOKI_SMALLOBJ_RETURN_ADDRESS(), size )
+#else
+    #define LOKI_SMALLOBJ_PROFILE_ALLOC( size )
+#endif
+
+    /** @class SmallObjRegion
+        @ingroup SmallObjectGroup
+     Scoped arena region with free-all-at-once semantics.  Construct one on
+     the stack at a controlled point - top of a request loop, start of a
+     phase - and it becomes the calling thread's open region until it goes
+     out of scope.  While a region is open, classes derived from
+     SmallRegionObject satisfy their allocations bump-pointer style from
+     chunks the region owns, so each allocation is a pointer increment and
+     deleting an object releases no memory; the region's destructor returns
+     every chunk in one pass, O(chunks) regardless of how many objects they
+     held.  Regions nest: an inner region shadows the outer one and
+     restores it on exit, so a sub-phase can run its own region.  While no
+     region is open, SmallRegionObject falls back to the pooled
+     SmallObjAllocator path, so the class is always safe to use.
+
+     The arena contract applies: an object allocated while a region is
+     open borrows that region's memory, and must be destroyed - or simply
+     abandoned, if its destructor is trivial - before the region closes.
+     Deleting such an object runs its destructor but returns no memory;
+     deleting it after its region closed hands a dangling block to the
+     pool, with the usual undefined results.
+
+     The active region is tracked per thread where thread-local storage is
+     available, so regions on different threads do not interleave; the
+     region object itself is not locked and must only be used by the
+     thread that opened it.
+     */
+    class LOKI_EXPORT SmallObjRegion
+    {
+    public:
+        /** Opens a region and installs it as the calling thread's active
+         region.
+         @param pageSize Byte size of the chunks the region carves
+          allocations from; requests larger than this get a chunk of their
+          own.  Defaults to the small-object allocator's page size.
+         */
+        explicit SmallObjRegion( std::size_t pageSize = LOKI_DEFAULT_CHUNK_SIZE );
+
+        /// Releases every chunk in one pass and restores the previously
+        /// active region.
+        ~SmallObjRegion();
+
+        /// Returns the calling thread's active region, or NULL if none.
+        static SmallObjRegion * ThisThread();
+
+        /** Returns the innermost active region owning the block, or NULL.
+         Walks the calling thread's nest of regions, so a block allocated
+         in an outer region is found while an inner one is open.
+         */
+        static SmallObjRegion * FindOwner( const void * p );
+
+        /** Allocates a block bump-pointer style from the current chunk,
+         starting a fresh chunk when the current one cannot hold the
+         request.  Complexity is constant apart from chunk starts.
+         @param size # of bytes to allocate.
+         @param alignment Alignment of the returned block; 0 for none.
+         @param doThrow True to throw bad_alloc when out of memory, false
+          to return NULL.
+         */
+        void * Allocate( std::size_t size, std::size_t alignment,
+            bool doThrow );
+
+        /// Returns true if the block lies within one of this region's
+        /// chunks.  Linear over the chunks.
+        bool Owns( const void * p ) const;
+
+        /// Returns # of chunks the region currently holds.
+        std::size_t GetChunkCount( void ) const
+        { return chunks_.size(); }
+
+    private:
+        /// Copy-constructor is not implemented.
+        SmallObjRegion( const SmallObjRegion & );
+        /// Copy-assignment operator is not implemented.
+        SmallObjRegion & operator = ( const SmallObjRegion & );
+
+        /// One chunk of region-owned memory.
+        struct Page
+        {
+            char * mem;
+            std::size_t size;
+        };
+
+        /// Starts a fresh chunk of at least bytes bytes.  Returns false
+        /// instead of throwing when doThrow is false.
+        bool AddPage( std::size_t bytes, bool doThrow );
+
+        /// Every chunk the region owns, released wholesale at close.
+        ::std::vector< Page > chunks_;
+
+        /// Next free byte of the current chunk.
+        char * cursor_;
+
+        /// One past the last byte of the current chunk.
+        char * end_;
+
+        /// Byte size of a standard chunk.
+        const std::size_t pageSize_;
+
+        /// Region this one shadowed, restored by the destructor.
+        SmallObjRegion * const previous_;
+    };
+
     /** @class SmallObjectBase
         @ingroup SmallObjectGroup
      Base class for small object allocation classes.
@@ -462,17 +1324,48 @@ namespace Loki
         static void * operator new ( std::size_t size ) throw ( std::bad_alloc )
 #endif
         {
+            LOKI_SMALLOBJ_PROFILE_ALLOC( size );
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            // NodePeek never creates, so this stays safe without the lock.
+            ObjAllocatorSingleton * cached = ObjAllocatorSingleton::NodePeek();
+            void * place = ( NULL == cached ) ? NULL :
+                cached->ThreadCacheAllocate( size );
+#else
+            void * place = MyAllocatorSingleton::Instance().ThreadCacheAllocate( size );
+#endif
+            if ( NULL != place ) return place;
+#endif
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            return ObjAllocatorSingleton::NodeInstance().Allocate( size, true );
+#else
             return MyAllocatorSingleton::Instance().Allocate( size, true );
+#endif
         }
 
         /// Non-throwing single-object new returns NULL if allocation fails.
         static void * operator new ( std::size_t size, const std::nothrow_t & ) throw ()
         {
+            LOKI_SMALLOBJ_PROFILE_ALLOC( size );
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            ObjAllocatorSingleton * cached = ObjAllocatorSingleton::NodePeek();
+            void * place = ( NULL == cached ) ? NULL :
+                cached->ThreadCacheAllocate( size );
+#else
+            void * place = MyAllocatorSingleton::Instance().ThreadCacheAllocate( size );
+#endif
+            if ( NULL != place ) return place;
+#endif
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            return ObjAllocatorSingleton::NodeInstance().Allocate( size, false );
+#else
             return MyAllocatorSingleton::Instance().Allocate( size, false );
+#endif
         }
 
         /// Placement single-object new merely calls global placement new.
@@ -484,9 +1377,24 @@ namespace Loki
         /// Single-object delete.
         static void operator delete ( void * p, std::size_t size ) throw ()
         {
+            // In NUMA-aware mode the lock-free fast paths are skipped since
+            // routing a block home requires an ownership check, which is
+            // only safe under the lock.
+#if defined(LOKI_SMALL_OBJECT_THREAD_CACHE) && !defined(LOKI_SMALL_OBJECT_NUMA_AWARE)
+            if ( MyAllocatorSingleton::Instance().ThreadCacheDeallocate( p, size ) )
+                return;
+#endif
+#if defined(LOKI_SMALL_OBJECT_ATOMIC_FREELIST) && !defined(LOKI_SMALL_OBJECT_NUMA_AWARE)
+            if ( MyAllocatorSingleton::Instance().DeferDeallocate( p, size ) )
+                return;
+#endif
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            ObjAllocatorSingleton::NodeDeallocate( p, size );
+#else
             MyAllocatorSingleton::Instance().Deallocate( p, size );
+#endif
         }
 
         /** Non-throwing single-object delete is only called when nothrow
@@ -496,7 +1404,11 @@ namespace Loki
         {
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            ObjAllocatorSingleton::NodeDeallocate( p );
+#else
             MyAllocatorSingleton::Instance().Deallocate( p );
+#endif
         }
 
         /// Placement single-object delete merely calls global placement delete.
@@ -516,18 +1428,28 @@ namespace Loki
             throw ( std::bad_alloc )
 #endif
         {
+            LOKI_SMALLOBJ_PROFILE_ALLOC( size );
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            return ObjAllocatorSingleton::NodeInstance().Allocate( size, true );
+#else
             return MyAllocatorSingleton::Instance().Allocate( size, true );
+#endif
         }
 
         /// Non-throwing array-object new returns NULL if allocation fails.
         static void * operator new [] ( std::size_t size,
             const std::nothrow_t & ) throw ()
         {
+            LOKI_SMALLOBJ_PROFILE_ALLOC( size );
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            return ObjAllocatorSingleton::NodeInstance().Allocate( size, false );
+#else
             return MyAllocatorSingleton::Instance().Allocate( size, false );
+#endif
         }
 
         /// Placement array-object new merely calls global placement new.
@@ -541,7 +1463,11 @@ namespace Loki
         {
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            ObjAllocatorSingleton::NodeDeallocate( p, size );
+#else
             MyAllocatorSingleton::Instance().Deallocate( p, size );
+#endif
         }
 
         /** Non-throwing array-object delete is only called when nothrow
@@ -552,7 +1478,11 @@ namespace Loki
         {
             typename MyThreadingModel::Lock lock;
             (void)lock; // get rid of warning
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+            ObjAllocatorSingleton::NodeDeallocate( p );
+#else
             MyAllocatorSingleton::Instance().Deallocate( p );
+#endif
         }
 
         /// Placement array-object delete merely calls global placement delete.
@@ -638,6 +1568,104 @@ namespace Loki
         inline ~SmallValueObject() {}
     }; // end class SmallValueObject
 
+
+    /** @class SmallRegionObject
+        @ingroup SmallObjectGroup
+     SmallRegionObject Base class for polymorphic small objects whose
+     allocations prefer the calling thread's open SmallObjRegion.  While a
+     region is open, operator new bump-allocates from it and operator
+     delete runs the destructor without releasing memory - the region
+     returns its chunks wholesale when it closes.  While no region is
+     open, both operators behave exactly as SmallObject's, so the class
+     costs nothing outside regions.  Deleting a region-allocated object
+     while its region is still open is recognized by walking the thread's
+     region nest; deleting one after its region closed is undefined, per
+     the arena contract described at SmallObjRegion.  Destructor is
+     virtual and public, copy operations are not implemented, and the
+     class has no data members, like SmallObject.
+     */
+    template
+    <
+        template <class, class> class ThreadingModel = LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL,
+        std::size_t chunkSize = LOKI_DEFAULT_CHUNK_SIZE,
+        std::size_t maxSmallObjectSize = LOKI_MAX_SMALL_OBJECT_SIZE,
+        std::size_t objectAlignSize = LOKI_DEFAULT_OBJECT_ALIGNMENT,
+        template <class> class LifetimePolicy = LOKI_DEFAULT_SMALLOBJ_LIFETIME,
+        class MutexPolicy = LOKI_DEFAULT_MUTEX
+    >
+    class SmallRegionObject : public SmallObjectBase< ThreadingModel, chunkSize,
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy >
+    {
+        typedef SmallObjectBase< ThreadingModel, chunkSize,
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy >
+            BaseType;
+
+    public:
+
+        /// Throwing single-object new prefers the open region.
+#ifdef _MSC_VER
+        /// @note MSVC complains about non-empty exception specification lists.
+        static void * operator new ( std::size_t size )
+#else
+        static void * operator new ( std::size_t size ) throw ( std::bad_alloc )
+#endif
+        {
+            SmallObjRegion * region = SmallObjRegion::ThisThread();
+            if ( NULL != region )
+                return region->Allocate( size, objectAlignSize, true );
+            return BaseType::operator new( size );
+        }
+
+        /// Non-throwing single-object new prefers the open region.
+        static void * operator new ( std::size_t size, const std::nothrow_t & nt ) throw ()
+        {
+            SmallObjRegion * region = SmallObjRegion::ThisThread();
+            if ( NULL != region )
+                return region->Allocate( size, objectAlignSize, false );
+            return BaseType::operator new( size, nt );
+        }
+
+        /// Placement single-object new merely calls global placement new.
+        inline static void * operator new ( std::size_t size, void * place )
+        {
+            return ::operator new( size, place );
+        }
+
+        /// Single-object delete is a no-op for blocks an open region owns.
+        static void operator delete ( void * p, std::size_t size ) throw ()
+        {
+            if ( NULL != SmallObjRegion::FindOwner( p ) )
+                return;
+            BaseType::operator delete( p, size );
+        }
+
+        /** Non-throwing single-object delete is only called when nothrow
+         new operator is used, and the constructor throws an exception.
+         */
+        static void operator delete ( void * p, const std::nothrow_t & nt ) throw()
+        {
+            if ( NULL != SmallObjRegion::FindOwner( p ) )
+                return;
+            BaseType::operator delete( p, nt );
+        }
+
+        /// Placement single-object delete merely calls global placement delete.
+        inline static void operator delete ( void * p, void * place )
+        {
+            ::operator delete ( p, place );
+        }
+
+        virtual ~SmallRegionObject() {}
+    protected:
+        inline SmallRegionObject( void ) {}
+
+    private:
+        /// Copy-constructor is not implemented.
+        SmallRegionObject( const SmallRegionObject & );
+        /// Copy-assignment operator is not implemented.
+        SmallRegionObject & operator = ( const SmallRegionObject & );
+    }; // end class SmallRegionObject
+
 } // namespace Loki
 
 #endif // end file guardian
@@ -37,6 +37,7 @@
 #include "ConstPolicy.h"
 
 #include <functional>
+#include <vector>
 #include <stdexcept>
 #include <cassert>
 #include <string>
@@ -54,10 +55,102 @@
 #define LOKI_ENABLE_FRIEND_TEMPLATE_TEMPLATE_PARAMETER_WORKAROUND
 #endif
 
+// The RefCountedAtomic ownership policy needs native atomic increments and
+// decrements - the GCC __sync builtins or the MSVC Interlocked family.
+// Without them the policy is simply not declared, and RefCountedMTAdj
+// remains the portable multithreaded choice.
+#if defined( _MSC_VER ) \
+    || ( defined( __GNUC__ ) \
+        && ( ( __GNUC__ > 4 ) \
+            || ( ( __GNUC__ == 4 ) && ( __GNUC_MINOR__ >= 1 ) ) ) )
+    #define LOKI_SMARTPTR_ATOMIC_REFCOUNT
+#endif
+#if defined( LOKI_SMARTPTR_ATOMIC_REFCOUNT ) && defined( _MSC_VER )
+    #include <intrin.h>
+#endif
+
+// When the compiler provides rvalue references, SmartPtr and StrongPtr gain
+// move constructors and move assignment so ownership transfers are a swap
+// instead of a Clone-plus-Release.  Functor.h uses the same macro.
+#ifndef LOKI_HAS_RVALUE_REFERENCES
+    #if ( defined( __cplusplus ) && ( __cplusplus >= 201103L ) ) \
+        || ( defined( _MSC_VER ) && ( _MSC_VER >= 1600 ) )
+        #define LOKI_HAS_RVALUE_REFERENCES 1
+    #endif
+#endif
+
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+#include <utility>
+#endif
+
 
 namespace Loki
 {
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class ReclamationQueue
+///
+///  \ingroup  SmartPointerGroup
+///  Per-thread queue of deferred destructions, used by DeferredSPStorage.
+///  Dropping the last SmartPtr to a large object graph normally runs the
+///  whole destructor cascade inline, stalling whatever the thread was
+///  doing; with deferred storage the pointee is pushed here instead and
+///  destroyed when the thread decides to pay for it.
+///
+///  A queue is a plain scoped object: construct one on the stack at a
+///  controlled point (top of a request loop, body of a reclaimer thread)
+///  and it becomes the calling thread's active queue until it goes out of
+///  scope, draining itself in its destructor.  Call Drain() earlier to
+///  empty it at chosen moments.  Queues nest; an inner queue shadows the
+///  outer one and restores it on exit.  While no queue is active,
+///  DeferredSPStorage destroys inline, so the policy is always safe to
+///  use.  Destructions may themselves defer further destructions - the
+///  drain loop keeps going until the queue is empty.
+////////////////////////////////////////////////////////////////////////////////
+
+    class LOKI_EXPORT ReclamationQueue
+    {
+    public:
+        /// Function which destroys a deferred pointee.
+        typedef void (*Destroyer)( void * p );
+
+        /// Installs this queue as the calling thread's active queue.
+        ReclamationQueue();
+
+        /// Drains the queue, then restores the previously active queue.
+        ~ReclamationQueue();
+
+        /// Returns the calling thread's active queue, or NULL if none.
+        static ReclamationQueue * ThisThread();
+
+        /// Queues one pointee for deferred destruction.
+        void Defer( void * p, Destroyer destroyer );
+
+        /// Destroys everything queued so far, including destructions
+        /// deferred while draining.  @return Number of pointees destroyed.
+        std::size_t Drain();
+
+        /// Returns the number of pointees waiting to be destroyed.
+        std::size_t GetCount() const
+        { return items_.size(); }
+
+    private:
+        ReclamationQueue( const ReclamationQueue & );
+        ReclamationQueue & operator = ( const ReclamationQueue & );
+
+        struct Item
+        {
+            void * p;
+            Destroyer destroyer;
+        };
+
+        ::std::vector< Item > items_;
+
+        /// Queue this one shadowed, restored by the destructor.
+        ReclamationQueue * const previous_;
+    };
+
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class HeapStorage
 ///
@@ -222,6 +315,98 @@ namespace Loki
     { return sp.pointee_; }
 
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class DeferredSPStorage
+///
+///  \ingroup  SmartPointerStorageGroup
+///  Implementation of the StoragePolicy used by SmartPtr.  Same as
+///  DefaultSPStorage, except that destruction goes through the calling
+///  thread's active ReclamationQueue when there is one, so releasing the
+///  last pointer costs a queue push instead of the destructor cascade.
+///  Without an active queue it deletes inline like DefaultSPStorage.
+////////////////////////////////////////////////////////////////////////////////
+
+
+    template <class T>
+    class DeferredSPStorage
+    {
+    public:
+        typedef T* StoredType;    // the type of the pointee_ object
+        typedef T* InitPointerType; /// type used to declare OwnershipPolicy type.
+        typedef T* PointerType;   // type returned by operator->
+        typedef T& ReferenceType; // type returned by operator*
+
+        DeferredSPStorage() : pointee_(Default())
+        {}
+
+        // The storage policy doesn't initialize the stored pointer
+        //     which will be initialized by the OwnershipPolicy's Clone fn
+        DeferredSPStorage(const DeferredSPStorage&) : pointee_(0)
+        {}
+
+        template <class U>
+        DeferredSPStorage(const DeferredSPStorage<U>&) : pointee_(0)
+        {}
+
+        DeferredSPStorage(const StoredType& p) : pointee_(p) {}
+
+        PointerType operator->() const { return pointee_; }
+
+        ReferenceType operator*() const { return *pointee_; }
+
+        void Swap(DeferredSPStorage& rhs)
+        { std::swap(pointee_, rhs.pointee_); }
+
+        // Accessors
+        template <class F>
+        friend typename DeferredSPStorage<F>::PointerType GetImpl(const DeferredSPStorage<F>& sp);
+
+        template <class F>
+        friend const typename DeferredSPStorage<F>::StoredType& GetImplRef(const DeferredSPStorage<F>& sp);
+
+        template <class F>
+        friend typename DeferredSPStorage<F>::StoredType& GetImplRef(DeferredSPStorage<F>& sp);
+
+    protected:
+        // Defers the destruction of the data stored when a queue is
+        // active; the queue destroys it through DeleteErased later,
+        // possibly on another thread.
+        void Destroy()
+        {
+            if ( 0 == pointee_ )
+                return;
+            ReclamationQueue * queue = ReclamationQueue::ThisThread();
+            if ( 0 != queue )
+                queue->Defer( pointee_, &DeleteErased );
+            else
+                delete pointee_;
+        }
+
+        // Default value to initialize the pointer
+        static StoredType Default()
+        { return 0; }
+
+    private:
+        static void DeleteErased( void * p )
+        { delete static_cast< T * >( p ); }
+
+        // Data
+        StoredType pointee_;
+    };
+
+    template <class T>
+    inline typename DeferredSPStorage<T>::PointerType GetImpl(const DeferredSPStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline const typename DeferredSPStorage<T>::StoredType& GetImplRef(const DeferredSPStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline typename DeferredSPStorage<T>::StoredType& GetImplRef(DeferredSPStorage<T>& sp)
+    { return sp.pointee_; }
+
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class LockedStorage
 ///
@@ -424,6 +609,274 @@ namespace Loki
     { return sp.pointee_; }
 
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class SizedArrayStorage
+///
+///  \ingroup  SmartPointerStorageGroup
+///  Implementation of the StoragePolicy used by SmartPtr.  Like ArrayStorage,
+///  but the element count lives in a small header in front of the array, in
+///  the same allocation, so a shared array needs one block instead of a
+///  pointer-plus-size pair kept somewhere else.  The policy exposes the
+///  count and a [Begin(), End()) view through the SmartPtr, which makes
+///  bounds-checked access and whole-array bulk operations possible without
+///  carrying the size separately.
+///
+///  Arrays for this policy must be made by Allocate, never by new[]:
+///
+///  \code
+///  SmartPtr<int, RefCounted, DisallowConversion, AssertCheck,
+///           SizedArrayStorage> a( SizedArrayStorage<int>::Allocate( 100 ) );
+///  \endcode
+///
+///  The header is aligned like a double; element types with stricter
+///  alignment requirements are not supported.
+////////////////////////////////////////////////////////////////////////////////
+
+
+    template <class T>
+    class SizedArrayStorage
+    {
+    public:
+        typedef T* StoredType;    // the type of the pointee_ object
+        typedef T* InitPointerType; /// type used to declare OwnershipPolicy type.
+        typedef T* PointerType;   // type returned by operator->
+        typedef T& ReferenceType; // type returned by operator*
+
+        SizedArrayStorage() : pointee_(Default())
+        {}
+
+        // The storage policy doesn't initialize the stored pointer
+        //     which will be initialized by the OwnershipPolicy's Clone fn
+        SizedArrayStorage(const SizedArrayStorage&) : pointee_(0)
+        {}
+
+        template <class U>
+        SizedArrayStorage(const SizedArrayStorage<U>&) : pointee_(0)
+        {}
+
+        SizedArrayStorage(const StoredType& p) : pointee_(p) {}
+
+        PointerType operator->() const { return pointee_; }
+
+        ReferenceType operator*() const { return *pointee_; }
+
+        void Swap(SizedArrayStorage& rhs)
+        { std::swap(pointee_, rhs.pointee_); }
+
+        /// Returns the number of elements in the array.
+        std::size_t GetCount() const
+        { return ( 0 == pointee_ ) ? 0 : Count( pointee_ ); }
+
+        /// Returns the first element of the array view.
+        PointerType Begin() const
+        { return pointee_; }
+
+        /// Returns one past the last element of the array view.
+        PointerType End() const
+        { return ( 0 == pointee_ ) ? 0 : pointee_ + Count( pointee_ ); }
+
+        /// Bounds-asserted element access.
+        ReferenceType At( std::size_t index ) const
+        {
+            assert( index < GetCount() );
+            return pointee_[ index ];
+        }
+
+        /// Returns the element count stored in front of an array which
+        /// was made by Allocate.
+        inline static std::size_t Count( const T * p )
+        {
+            return ( reinterpret_cast< const Header * >( p ) - 1 )->count_;
+        }
+
+        /** Makes an array of count default-constructed elements with the
+         count stored in front of it, all in one allocation.  Pass the
+         result to the SmartPtr constructor.  Elements constructed so far
+         are destroyed if a constructor throws.
+         */
+        static T * Allocate( std::size_t count )
+        {
+            void * block = ::operator new(
+                sizeof(Header) + count * sizeof(T) );
+            Header * header = static_cast< Header * >( block );
+            header->count_ = count;
+            T * array = reinterpret_cast< T * >( header + 1 );
+            std::size_t made = 0;
+            try
+            {
+                for ( ; made < count; ++made )
+                    new ( array + made ) T;
+            }
+            catch ( ... )
+            {
+                while ( made != 0 )
+                    array[ --made ].~T();
+                ::operator delete( block );
+                throw;
+            }
+            return array;
+        }
+
+        /// Destroys the elements and frees an array made by Allocate.
+        static void Deallocate( T * p )
+        {
+            if ( 0 == p )
+                return;
+            Header * header = reinterpret_cast< Header * >( p ) - 1;
+            for ( std::size_t i = header->count_; i != 0; --i )
+                p[ i - 1 ].~T();
+            ::operator delete( header );
+        }
+
+        // Accessors
+        template <class F>
+        friend typename SizedArrayStorage<F>::PointerType GetImpl(const SizedArrayStorage<F>& sp);
+
+        template <class F>
+        friend const typename SizedArrayStorage<F>::StoredType& GetImplRef(const SizedArrayStorage<F>& sp);
+
+        template <class F>
+        friend typename SizedArrayStorage<F>::StoredType& GetImplRef(SizedArrayStorage<F>& sp);
+
+    protected:
+        // Destroys the data stored
+        // (Destruction might be taken over by the OwnershipPolicy)
+        void Destroy()
+        { Deallocate( pointee_ ); }
+
+        // Default value to initialize the pointer
+        static StoredType Default()
+        { return 0; }
+
+    private:
+        union Header
+        {
+            std::size_t count_;
+            double forAlignment_;  // keeps the first element aligned
+        };
+
+        // Data
+        StoredType pointee_;
+    };
+
+    template <class T>
+    inline typename SizedArrayStorage<T>::PointerType GetImpl(const SizedArrayStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline const typename SizedArrayStorage<T>::StoredType& GetImplRef(const SizedArrayStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline typename SizedArrayStorage<T>::StoredType& GetImplRef(SizedArrayStorage<T>& sp)
+    { return sp.pointee_; }
+
+
+////////////////////////////////////////////////////////////////////////////////
+///  \union CombinedRefCount
+///
+///  \ingroup SmartPointerStorageGroup
+///  Header which CreateCombined places immediately in front of the pointee
+///  inside a single SmallObject block.  The extra members do not store
+///  anything - they only pad the count to the strictest common alignment,
+///  so the object behind the header is as aligned as the count itself.
+////////////////////////////////////////////////////////////////////////////////
+
+    union CombinedRefCount
+    {
+        uintptr_t count_;
+        double forAlignment1_;
+        void * forAlignment2_;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class CombinedStorage
+///
+///  \ingroup  SmartPointerStorageGroup
+///  Implementation of the StoragePolicy used by SmartPtr for objects made
+///  by CreateCombined, whose reference count and pointee share one
+///  SmallObject block.  Destroy calls T's destructor explicitly and then
+///  returns the whole block - header and object - to the allocator.  Only
+///  pointers obtained from CreateCombined may be stored here.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class T>
+    class CombinedStorage
+    {
+    public:
+        typedef T* StoredType;      /// the type of the pointee_ object
+        typedef T* InitPointerType; /// type used to declare OwnershipPolicy type.
+        typedef T* PointerType;     /// type returned by operator->
+        typedef T& ReferenceType;   /// type returned by operator*
+
+        CombinedStorage() : pointee_(Default())
+        {}
+
+        // The storage policy doesn't initialize the stored pointer
+        //     which will be initialized by the OwnershipPolicy's Clone fn
+        CombinedStorage(const CombinedStorage&) : pointee_(0)
+        {}
+
+        template <class U>
+        CombinedStorage(const CombinedStorage<U>&) : pointee_(0)
+        {}
+
+        CombinedStorage(const StoredType& p) : pointee_(p) {}
+
+        PointerType operator->() const { return pointee_; }
+
+        ReferenceType operator*() const { return *pointee_; }
+
+        void Swap(CombinedStorage& rhs)
+        { std::swap(pointee_, rhs.pointee_); }
+
+        // Accessors
+        template <class F>
+        friend typename CombinedStorage<F>::PointerType GetImpl(const CombinedStorage<F>& sp);
+
+        template <class F>
+        friend const typename CombinedStorage<F>::StoredType& GetImplRef(const CombinedStorage<F>& sp);
+
+        template <class F>
+        friend typename CombinedStorage<F>::StoredType& GetImplRef(CombinedStorage<F>& sp);
+
+    protected:
+        // Destroys the data stored
+        // (Destruction might be taken over by the OwnershipPolicy)
+        void Destroy()
+        {
+            if ( 0 != pointee_ )
+            {
+                pointee_->~T();
+                SmallObject<>::operator delete(
+                    reinterpret_cast< char * >( pointee_ )
+                        - sizeof(CombinedRefCount),
+                    sizeof(CombinedRefCount) + sizeof(T) );
+            }
+        }
+
+        // Default value to initialize the pointer
+        static StoredType Default()
+        { return 0; }
+
+    private:
+        // Data
+        StoredType pointee_;
+    };
+
+    template <class T>
+    inline typename CombinedStorage<T>::PointerType GetImpl(const CombinedStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline const typename CombinedStorage<T>::StoredType& GetImplRef(const CombinedStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline typename CombinedStorage<T>::StoredType& GetImplRef(CombinedStorage<T>& sp)
+    { return sp.pointee_; }
+
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class RefCounted
 ///
@@ -481,6 +934,64 @@ namespace Loki
         uintptr_t* pCount_;
     };
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class CombinedRefCounted
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr for objects made
+///  by CreateCombined.  The reference count lives in the CombinedRefCount
+///  header directly in front of the pointee, so this policy carries no data
+///  of its own, creating an object costs one allocation instead of the two
+///  RefCounted pays, and Clone touches the cache line the object itself
+///  just warmed.  Counting is plain like RefCounted's, for single-threaded
+///  use.  Only pointers obtained from CreateCombined have the header, so
+///  only such pointers may be handed to a SmartPtr using this policy.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class P>
+    class CombinedRefCounted
+    {
+    public:
+        CombinedRefCounted()
+        {}
+
+        CombinedRefCounted(const CombinedRefCounted&)
+        {}
+
+        template <typename P1>
+        CombinedRefCounted(const CombinedRefCounted<P1>&)
+        {}
+
+        static P Clone(const P& val)
+        {
+            if ( 0 != val )
+                ++GetCounter( val )->count_;
+            return val;
+        }
+
+        static bool Release(const P& val)
+        {
+            if ( 0 == val )
+                return false;
+            // The block - count and all - is freed by CombinedStorage.
+            return 0 == --GetCounter( val )->count_;
+        }
+
+        static void Swap(CombinedRefCounted&)
+        {}
+
+        enum { destructiveCopy = false };
+
+    private:
+        /// Returns the header CreateCombined placed in front of the pointee.
+        static CombinedRefCount * GetCounter(const P& val)
+        {
+            return reinterpret_cast< CombinedRefCount * >(
+                reinterpret_cast< char * >( val )
+                    - sizeof(CombinedRefCount) );
+        }
+    };
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \struct RefCountedMT
 ///
@@ -519,7 +1030,8 @@ namespace Loki
                         sizeof(*pCount_)));
                 assert(pCount_);
                 //*pCount_ = 1;
-                ThreadingModel<RefCountedMT, MX>::AtomicAssign(*pCount_, 1);
+                // nobody can see the fresh count yet, so no ordering needed
+                ThreadingModel<RefCountedMT, MX>::AtomicAssignRelaxed(*pCount_, 1);
             }
 
             RefCountedMT(const RefCountedMT& rhs)
@@ -534,15 +1046,17 @@ namespace Loki
 
             P Clone(const P& val)
             {
-                ThreadingModel<RefCountedMT, MX>::AtomicIncrement(*pCount_);
+                // the copied-from pointer keeps the count above zero, so
+                // the uptick needs no ordering
+                ThreadingModel<RefCountedMT, MX>::AtomicIncrementRelaxed(*pCount_);
                 return val;
             }
 
             bool Release(const P&)
             {
-                bool isZero = false;
-                ThreadingModel< RefCountedMT, MX >::AtomicDecrement( *pCount_, 0, isZero );
-                if ( isZero )
+                // acquire-release: the final releaser must see every write
+                // the other owners made before dropping their references
+                if ( 0 == ThreadingModel< RefCountedMT, MX >::AtomicDecrementAcqRel( *pCount_ ) )
                 {
                     SmallObject<LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL>::operator delete(
                         const_cast<CountType *>(pCount_),
@@ -563,6 +1077,101 @@ namespace Loki
         };
     };
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class RefCountedAtomic
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr
+///  Provides external reference counting for multithreaded programs using
+///  the processor's native atomic increment and decrement, so copying or
+///  destroying a SmartPtr costs one atomic operation instead of the mutex
+///  round trip RefCountedMTAdj pays on platforms whose ThreadingModel
+///  implements AtomicIncrement with a lock.  The increment in Clone needs
+///  no ordering guarantee - the copied-from pointer already keeps the count
+///  above zero - while the decrement in Release carries the usual
+///  acquire/release semantics of the builtins so the pointee's writes are
+///  visible to whichever thread performs the final release.  Only declared
+///  when the compiler offers atomic builtins; see
+///  LOKI_SMARTPTR_ATOMIC_REFCOUNT above.
+///
+///  \par Warning
+///  The race condition described for RefCountedMTAdj - copying the last
+///  pointer in one thread while another destroys it - applies here too,
+///  and likewise can only be fixed at a higher design level.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+    template <class P>
+    class RefCountedAtomic
+    {
+#if defined( _MSC_VER )
+        typedef long CountType;
+#else
+        typedef int CountType;
+#endif
+        typedef volatile CountType * CountPtrType;
+
+    public:
+        RefCountedAtomic()
+            : pCount_( static_cast< CountPtrType >(
+                SmallObject<>::operator new( sizeof(CountType) ) ) )
+        {
+            assert( pCount_ != 0 );
+            // The counter is not shared with any other thread until this
+            // constructor returns, so a plain store suffices.
+            *pCount_ = 1;
+        }
+
+        RefCountedAtomic( const RefCountedAtomic& rhs )
+            : pCount_( rhs.pCount_ )
+        {}
+
+        // MWCW lacks template friends, hence the following kludge
+        template <typename P1>
+        RefCountedAtomic( const RefCountedAtomic<P1>& rhs )
+            : pCount_( reinterpret_cast< const RefCountedAtomic& >( rhs ).pCount_ )
+        {}
+
+        P Clone( const P& val )
+        {
+#if defined( _MSC_VER )
+            ::_InterlockedIncrement( pCount_ );
+#else
+            __sync_add_and_fetch( pCount_, 1 );
+#endif
+            return val;
+        }
+
+        bool Release( const P& )
+        {
+#if defined( _MSC_VER )
+            if ( 0 == ::_InterlockedDecrement( pCount_ ) )
+#else
+            if ( 0 == __sync_sub_and_fetch( pCount_, 1 ) )
+#endif
+            {
+                SmallObject<>::operator delete(
+                    const_cast< CountType * >( pCount_ ),
+                    sizeof(CountType) );
+                pCount_ = NULL;
+                return true;
+            }
+            return false;
+        }
+
+        void Swap( RefCountedAtomic& rhs )
+        { std::swap( pCount_, rhs.pCount_ ); }
+
+        enum { destructiveCopy = false };
+
+    private:
+        // Data
+        CountPtrType pCount_;
+    };
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class COMRefCounted
 ///
@@ -602,6 +1211,163 @@ namespace Loki
         {}
     };
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class IntrusiveRefCount
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Mixin base embedding the reference count in the pointee itself, for use
+///  with the IntrusiveRefCounted ownership policy.  Derive from it and the
+///  count lives on the object's own cache line: creating the object costs
+///  no second allocation, and Clone touches memory the object itself just
+///  warmed, unlike RefCounted whose external counter both costs an
+///  allocation and drags a second line through the cache on every copy.
+///  Counting is plain, for single-threaded use; IntrusiveRefCountAtomic
+///  below is the multithreaded flavour.
+///
+///  The count starts at one: the creator's reference is assumed by the
+///  first SmartPtr the raw pointer is handed to.  Constructing two
+///  independent SmartPtrs from the same raw pointer double-destroys, as
+///  with every counted policy.  Copying or assigning a pointee leaves the
+///  counts alone - a fresh copy starts with its creator's single
+///  reference, whatever the original's count was.
+////////////////////////////////////////////////////////////////////////////////
+
+    class IntrusiveRefCount
+    {
+    public:
+        void AddRef() const
+        { ++count_; }
+
+        /// Drops one reference; returns true when the last is gone and
+        /// the caller must destroy the object.
+        bool ReleaseRef() const
+        { return 0 == --count_; }
+
+    protected:
+        IntrusiveRefCount() : count_(1)
+        {}
+
+        IntrusiveRefCount(const IntrusiveRefCount&) : count_(1)
+        {}
+
+        IntrusiveRefCount& operator=(const IntrusiveRefCount&)
+        { return *this; }
+
+        ~IntrusiveRefCount()
+        {}
+
+    private:
+        // Data
+        mutable uintptr_t count_;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class IntrusiveRefCountAtomic
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Multithreaded flavour of IntrusiveRefCount: same embedded count and
+///  the same AddRef/ReleaseRef hooks, maintained with the processor's
+///  native atomic increment and decrement.  As in RefCountedAtomic, the
+///  increment needs no ordering guarantee - the copied-from pointer keeps
+///  the count above zero - while the decrement carries the usual
+///  acquire/release semantics of the builtins so the pointee's writes are
+///  visible to whichever thread performs the final release.  Only declared
+///  when the compiler offers atomic builtins; see
+///  LOKI_SMARTPTR_ATOMIC_REFCOUNT above.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+    class IntrusiveRefCountAtomic
+    {
+#if defined( _MSC_VER )
+        typedef long CountType;
+#else
+        typedef int CountType;
+#endif
+
+    public:
+        void AddRef() const
+        {
+#if defined( _MSC_VER )
+            ::_InterlockedIncrement( &count_ );
+#else
+            __sync_add_and_fetch( &count_, 1 );
+#endif
+        }
+
+        /// Drops one reference; returns true when the last is gone and
+        /// the caller must destroy the object.
+        bool ReleaseRef() const
+        {
+#if defined( _MSC_VER )
+            return 0 == ::_InterlockedDecrement( &count_ );
+#else
+            return 0 == __sync_sub_and_fetch( &count_, 1 );
+#endif
+        }
+
+    protected:
+        IntrusiveRefCountAtomic() : count_(1)
+        {}
+
+        IntrusiveRefCountAtomic(const IntrusiveRefCountAtomic&) : count_(1)
+        {}
+
+        IntrusiveRefCountAtomic& operator=(const IntrusiveRefCountAtomic&)
+        { return *this; }
+
+        ~IntrusiveRefCountAtomic()
+        {}
+
+    private:
+        // Data
+        mutable volatile CountType count_;
+    };
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class IntrusiveRefCounted
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr
+///  Reference counting through AddRef/ReleaseRef hooks embedded in the
+///  pointee - derive it from IntrusiveRefCount or IntrusiveRefCountAtomic
+///  above, or supply the two hooks directly.  The policy itself carries no
+///  data.  Unlike COMRefCounted the pointee does not destroy itself:
+///  ReleaseRef only reports that the last reference is gone and the
+///  SmartPtr's StoragePolicy performs the destruction, so intrusively
+///  counted objects work with any storage, arena-backed ones included.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class P>
+    class IntrusiveRefCounted
+    {
+    public:
+        IntrusiveRefCounted()
+        {}
+
+        template <class U>
+        IntrusiveRefCounted(const IntrusiveRefCounted<U>&)
+        {}
+
+        static P Clone(const P& val)
+        {
+            if(val!=0)
+                val->AddRef();
+            return val;
+        }
+
+        static bool Release(const P& val)
+        { return val!=0 && val->ReleaseRef(); }
+
+        enum { destructiveCopy = false };
+
+        static void Swap(IntrusiveRefCounted&)
+        {}
+    };
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \struct DeepCopy
 ///
@@ -668,6 +1434,58 @@ namespace Loki
             mutable const RefLinkedBase* prev_;
             mutable const RefLinkedBase* next_;
         };
+
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+        ////////////////////////////////////////////////////////////////////////
+        // Base class of the RefLinkedAtomic ownership policy.  Same doubly
+        // linked ring as RefLinkedBase, plus a one-word spin lock per node
+        // built on the atomic-exchange builtin.  Every operation locks only
+        // the nodes whose links it rewrites - two for joining a ring, three
+        // for leaving one - and takes them by locking its own node first and
+        // try-locking the neighbors, retrying on failure, so threads never
+        // block while holding more than their own lock and cannot deadlock
+        // around the ring.  Holding a node's lock pins its neighbors: they
+        // can neither relink nor be destroyed, because doing so needs that
+        // same lock.  Critical sections are a handful of pointer writes.
+        ////////////////////////////////////////////////////////////////////////
+        class LOKI_EXPORT RefLinkedAtomicBase
+        {
+        public:
+            RefLinkedAtomicBase()
+            {
+                prev_ = next_ = this;
+                lock_ = 0;
+            }
+
+            RefLinkedAtomicBase(const RefLinkedAtomicBase& rhs);
+
+            bool Release();
+
+            void Swap(RefLinkedAtomicBase& rhs);
+
+            bool Merge( RefLinkedAtomicBase & rhs );
+
+            enum { destructiveCopy = false };
+
+        private:
+            void LockNode() const;
+            bool TryLockNode() const;
+            void UnlockNode() const;
+
+            /// Splices this node into the ring right after the anchor.
+            void InsertSelfAfter( const RefLinkedAtomicBase & anchor );
+
+            /// Splices this node out of its ring, leaving it self-linked.
+            /// @return True if the node was alone in its ring.
+            bool UnlinkSelf();
+
+            mutable const RefLinkedAtomicBase* prev_;
+            mutable const RefLinkedAtomicBase* next_;
+            mutable volatile long lock_;
+        };
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
     }
 
     template <class P>
@@ -695,6 +1513,58 @@ namespace Loki
         }
     };
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class RefLinkedAtomic
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr
+///  Reference linking for multithreaded programs.  Keeps RefLinked's
+///  zero-allocation ownership - the owners form a doubly linked ring through
+///  the pointers themselves, no shared counter is ever allocated - but the
+///  ring surgery is synchronized with a one-word spin lock in every node.
+///  Copying locks the copied-from node and its successor; releasing locks
+///  the leaving node and its two neighbors; owners elsewhere in the ring
+///  are never touched, so unrelated copies and releases of the same object
+///  proceed in parallel.  Costs one word per SmartPtr more than RefLinked.
+///  Only declared when the compiler offers atomic builtins; see
+///  LOKI_SMARTPTR_ATOMIC_REFCOUNT above.
+///
+///  \par Warning
+///  The race condition described for RefCountedMTAdj - copying the last
+///  pointer in one thread while another destroys it - applies here too.
+///  Merge inspects whole rings and so cannot be protected by per-node
+///  locks; call it only while no other thread mutates either ring.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+    template <class P>
+    class RefLinkedAtomic : public Private::RefLinkedAtomicBase
+    {
+    public:
+        RefLinkedAtomic()
+        {}
+
+        template <class P1>
+        RefLinkedAtomic(const RefLinkedAtomic<P1>& rhs)
+        : Private::RefLinkedAtomicBase(rhs)
+        {}
+
+        static P Clone(const P& val)
+        { return val; }
+
+        bool Release(const P&)
+        { return Private::RefLinkedAtomicBase::Release(); }
+
+        template < class P1 >
+        bool Merge( RefLinkedAtomic< P1 > & rhs )
+        {
+            return Private::RefLinkedAtomicBase::Merge( rhs );
+        }
+    };
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class DestructiveCopy
 ///
@@ -1207,6 +2077,28 @@ namespace Loki
         : SP(rhs), OP(rhs), KP(rhs), CP(rhs)
         {}
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+        /// Move constructor starts out default-constructed, then swaps with
+        /// rhs, which is left holding the default value - no Clone, and for
+        /// reference-counted policies no count is touched.
+        SmartPtr( SmartPtr && rhs )
+        {
+            KP::OnDefault(GetImpl(*this));
+            Swap( rhs );
+        }
+
+        SmartPtr & operator=( SmartPtr && rhs )
+        {
+            if ( this != &rhs )
+            {
+                SmartPtr temp( std::move( rhs ) );
+                temp.Swap( *this );
+            }
+            return *this;
+        }
+#endif
+
         operator RefToValue<SmartPtr>()
         { return RefToValue<SmartPtr>(*this); }
 
@@ -1510,6 +2402,145 @@ namespace Loki
 
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+///  \struct CombinedSmartPtr
+///
+///  \ingroup SmartPointerGroup
+///  Names the SmartPtr instantiation whose reference count and pointee
+///  share one allocation: instead of writing out the CombinedRefCounted
+///  and CombinedStorage policies, write CombinedSmartPtr<T>::Type.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class T>
+    struct CombinedSmartPtr
+    {
+        typedef SmartPtr
+        <
+            T,
+            CombinedRefCounted,
+            DisallowConversion,
+            AssertCheck,
+            CombinedStorage
+        >
+        Type;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+///  Creates a T and its reference count inside one SmallObject block - the
+///  make_shared of this library - and returns a SmartPtr owning it.  Every
+///  SmartPtr built the usual way costs two allocations, one for T and one
+///  for the count; this halves the allocator traffic and keeps the count
+///  on the same cache line as the object, so copying the pointer touches
+///  memory the object's own use has already made hot.  The overloads
+///  forward up to four constructor arguments.  If T's constructor throws,
+///  the block is released and the exception propagates.
+///  \ingroup SmartPointerGroup
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        /// Allocates the combined block and readies its header.  Shared by
+        /// the CreateCombined overloads.
+        inline void * CreateCombinedBlock( std::size_t objectSize )
+        {
+            void * block = SmallObject<>::operator new(
+                sizeof(CombinedRefCount) + objectSize );
+            static_cast< CombinedRefCount * >( block )->count_ = 1;
+            return static_cast< CombinedRefCount * >( block ) + 1;
+        }
+
+        /// Releases a combined block when T's constructor throws.
+        inline void DiscardCombinedBlock( void * place, std::size_t objectSize )
+        {
+            SmallObject<>::operator delete(
+                static_cast< CombinedRefCount * >( place ) - 1,
+                sizeof(CombinedRefCount) + objectSize );
+        }
+    }
+
+    template <class T>
+    typename CombinedSmartPtr< T >::Type CreateCombined( void )
+    {
+        void * place = Private::CreateCombinedBlock( sizeof(T) );
+        try
+        {
+            return typename CombinedSmartPtr< T >::Type(
+                ::new ( place ) T );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCombinedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template <class T, class A1>
+    typename CombinedSmartPtr< T >::Type CreateCombined( const A1 & a1 )
+    {
+        void * place = Private::CreateCombinedBlock( sizeof(T) );
+        try
+        {
+            return typename CombinedSmartPtr< T >::Type(
+                ::new ( place ) T( a1 ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCombinedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template <class T, class A1, class A2>
+    typename CombinedSmartPtr< T >::Type CreateCombined( const A1 & a1,
+        const A2 & a2 )
+    {
+        void * place = Private::CreateCombinedBlock( sizeof(T) );
+        try
+        {
+            return typename CombinedSmartPtr< T >::Type(
+                ::new ( place ) T( a1, a2 ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCombinedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template <class T, class A1, class A2, class A3>
+    typename CombinedSmartPtr< T >::Type CreateCombined( const A1 & a1,
+        const A2 & a2, const A3 & a3 )
+    {
+        void * place = Private::CreateCombinedBlock( sizeof(T) );
+        try
+        {
+            return typename CombinedSmartPtr< T >::Type(
+                ::new ( place ) T( a1, a2, a3 ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCombinedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template <class T, class A1, class A2, class A3, class A4>
+    typename CombinedSmartPtr< T >::Type CreateCombined( const A1 & a1,
+        const A2 & a2, const A3 & a3, const A4 & a4 )
+    {
+        void * place = Private::CreateCombinedBlock( sizeof(T) );
+        try
+        {
+            return typename CombinedSmartPtr< T >::Type(
+                ::new ( place ) T( a1, a2, a3, a4 ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCombinedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 // free comparison operators for class template SmartPtr
 ////////////////////////////////////////////////////////////////////////////////
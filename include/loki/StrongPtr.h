@@ -22,6 +22,10 @@
     #include <loki/Threads.h>
 #endif
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -233,6 +237,40 @@ public:
     inline void Swap( DeleteArray & ) {}
 };
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class DeleteSizedArray
+///
+///  \ingroup  StrongPointerDeleteGroup
+///  Implementation of the DeletePolicy used by StrongPtr.  This deletes an
+///   array of shared objects which was made by SizedArrayStorage::Allocate.
+///   The element count lives in front of the array in the same allocation,
+///   so unlike DeleteArray no size has to be carried separately, and it can
+///   be read back through SizedArrayStorage::Count for bulk operations.
+////////////////////////////////////////////////////////////////////////////////
+
+template < class P >
+class DeleteSizedArray
+{
+public:
+    inline static void Delete( const P * p )
+    {
+        /** @note If you see an error message about a negative subscript, that
+         means your are attempting to use Loki to delete an incomplete type.
+         Please don't use this policy with incomplete types; you may want to
+         use DeleteNothing instead.
+         */
+        typedef char Type_Must_Be_Defined[ sizeof(P) ? 1 : -1 ];
+        SizedArrayStorage< P >::Deallocate( const_cast< P * >( p ) );
+    }
+
+    inline static P * Default( void )
+    {
+        return 0;
+    }
+
+    inline void Swap( DeleteSizedArray & ) {}
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class CantResetWithStrong
 ///
@@ -537,6 +575,169 @@ private:
 
 #endif // if object-level-locking or class-level-locking
 
+////////////////////////////////////////////////////////////////////////////////
+///  \class AtomicTwoRefCountInfo
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   Implementation detail for lock-free counting of strong and weak
+///   pointers.  Both counts live packed inside one 64-bit word - the
+///   strong count in the low half, the weak count in the high half - and
+///   every change is a single atomic add, so copying or releasing a
+///   StrongPtr costs one atomic instruction instead of the mutex round
+///   trip made by LockableTwoRefCountInfo, whose embedded mutex also makes
+///   each count block several times larger.  It provides the same
+///   guarantees as LockableTwoRefCountInfo: individual count updates never
+///   race, while destroying the very last strong and the very last weak
+///   copointer simultaneously from two threads remains the caller's
+///   problem, just as it is for the lockable form.  The info also records
+///   the byte size of the block it lives in, because CreateCoAllocated
+///   places the pointee in the same allocation as the counts.  Not
+///   intended to be used directly.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined( LOKI_SMARTPTR_ATOMIC_REFCOUNT )
+
+class LOKI_EXPORT AtomicTwoRefCountInfo
+{
+public:
+
+#if defined( _MSC_VER )
+    typedef unsigned __int64 CountsWord;
+#else
+    typedef unsigned long long CountsWord;
+#endif
+
+    inline explicit AtomicTwoRefCountInfo( bool strong )
+        : m_pointer( 0 )
+        , m_counts( strong ? StrongOne() : WeakOne() )
+        , m_blockSize( sizeof(AtomicTwoRefCountInfo) )
+    {
+    }
+
+    inline AtomicTwoRefCountInfo( void * p, bool strong )
+        : m_pointer( p )
+        , m_counts( strong ? StrongOne() : WeakOne() )
+        , m_blockSize( sizeof(AtomicTwoRefCountInfo) )
+    {
+    }
+
+    inline ~AtomicTwoRefCountInfo( void )
+    {
+    }
+
+    inline bool HasStrongPointer( void ) const
+    {
+        return 0 != ( m_counts & StrongMask() );
+    }
+
+    inline bool HasWeakPointer( void ) const
+    {
+        return 0 != ( m_counts >> 32 );
+    }
+
+    inline void IncStrongCount( void )
+    {
+        AtomicAdd( StrongOne() );
+    }
+
+    inline void IncWeakCount( void )
+    {
+        AtomicAdd( WeakOne() );
+    }
+
+    /// Returns true when the last strong reference just went away.
+    inline bool DecStrongCount( void )
+    {
+        return 0 == ( AtomicAdd( 0 - StrongOne() ) & StrongMask() );
+    }
+
+    /// Returns true when the last weak reference just went away.
+    inline bool DecWeakCount( void )
+    {
+        return 0 == ( AtomicAdd( 0 - WeakOne() ) >> 32 );
+    }
+
+    inline void ZapPointer( void )
+    {
+        m_pointer = 0;
+    }
+
+    void SetPointer( void * p )
+    {
+        m_pointer = p;
+    }
+
+    inline void * GetPointer( void ) const
+    {
+        return m_pointer;
+    }
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return const_cast< void * & >( m_pointer );
+    }
+
+    /// Tells the info how many bytes its own allocation spans; only
+    /// CreateCoAllocated passes anything other than the default.
+    inline void SetBlockSize( std::size_t bytes )
+    {
+        m_blockSize = bytes;
+    }
+
+    inline std::size_t GetBlockSize( void ) const
+    {
+        return m_blockSize;
+    }
+
+private:
+    /// Copy-constructor not implemented.
+    AtomicTwoRefCountInfo( const AtomicTwoRefCountInfo & );
+    /// Copy-assignment operator not implemented.
+    AtomicTwoRefCountInfo & operator = ( const AtomicTwoRefCountInfo & );
+
+    inline static CountsWord StrongOne( void )
+    {
+        return 1;
+    }
+
+    inline static CountsWord WeakOne( void )
+    {
+        return static_cast< CountsWord >( 1 ) << 32;
+    }
+
+    inline static CountsWord StrongMask( void )
+    {
+        return 0xFFFFFFFFul;
+    }
+
+    /// Adds delta to the packed word atomically; pass the two's complement
+    /// to subtract from either half.  Returns the new value.
+    inline CountsWord AtomicAdd( CountsWord delta )
+    {
+#if defined( _MSC_VER )
+        for ( ;; )
+        {
+            const CountsWord old = m_counts;
+            const CountsWord with = old + delta;
+            if ( static_cast< __int64 >( old )
+                == ::_InterlockedCompareExchange64(
+                    reinterpret_cast< volatile __int64 * >( &m_counts ),
+                    static_cast< __int64 >( with ),
+                    static_cast< __int64 >( old ) ) )
+                return with;
+        }
+#else
+        return __sync_add_and_fetch( &m_counts, delta );
+#endif
+    }
+
+    void * m_pointer;
+    volatile CountsWord m_counts;
+    std::size_t m_blockSize;
+};
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
 } // end namespace Private
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -599,6 +800,20 @@ protected:
         return m_counts->GetPointer();
     }
 
+    /// Record type shared by all copointers; used by ReleaseRange.
+    typedef Loki::Private::TwoRefCountInfo CountRecord;
+
+    /// Makes a record already holding count claims of the given strength,
+    /// for ReleaseRange to hand the emptied pointers.
+    static CountRecord * CreateSpareRecord( bool strong, unsigned int count );
+
+    /// Repoints this policy at another record.  Only for ReleaseRange,
+    /// after this policy's claim on its old record was released.
+    void Adopt( CountRecord * counts )
+    {
+        m_counts = counts;
+    }
+
 private:
     TwoRefCounts( void );
     TwoRefCounts & operator = ( const TwoRefCounts & );
@@ -765,65 +980,462 @@ private:
 #endif // if object-level-locking or class-level-locking
 
 ////////////////////////////////////////////////////////////////////////////////
-///  \class TwoRefLinks
+///  \class AtomicTwoRefCounts
 ///
 ///  \ingroup  StrongPointerOwnershipGroup
-///   This implementation of StrongPtr's OwnershipPolicy uses a doubly-linked
-///   cycle of copointers to a shared object. Some functions are trivial enough
-///   to be inline, while others are implemented in elsewhere.  It is not thread
-///   safe, and is intended for single-threaded environments.
+///   This implementation of StrongPtr's OwnershipPolicy does exactly what
+///   LockableTwoRefCounts does, but with a pointer to a shared instance of
+///   AtomicTwoRefCountInfo, so each copy, release and expiry check is one
+///   atomic instruction on the packed count word rather than a mutex
+///   acquisition.  Use it wherever LockableTwoRefCounts fits but the
+///   pointers are copied often enough for the mutex to show up in
+///   profiles.
+///
+///  \note This class is not designed for use with a single-threaded model.
+///   Tests using a single-threaded model will not run properly, but tests in a
+///   multi-threaded model with either class-level-locking or object-level-locking
+///   do run properly.
 ////////////////////////////////////////////////////////////////////////////////
 
-class LOKI_EXPORT TwoRefLinks
+#if defined( LOKI_SMARTPTR_ATOMIC_REFCOUNT ) \
+    && ( defined( LOKI_OBJECT_LEVEL_THREADING ) \
+        || defined( LOKI_CLASS_LEVEL_THREADING ) )
+
+class LOKI_EXPORT AtomicTwoRefCounts
 {
+    typedef SmallValueObject< ::Loki::ClassLevelLockable > ThreadSafePointerAllocator;
+
 protected:
 
-    inline explicit TwoRefLinks( bool strong )
-        : m_pointer( 0 )
-        , m_strong( strong )
+    explicit AtomicTwoRefCounts( bool strong )
+        : m_counts( NULL )
     {
-        m_prev = m_next = this;
+        void * temp = ThreadSafePointerAllocator::operator new(
+            sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( temp != 0 );
+#endif
+        m_counts = new ( temp ) Loki::Private::AtomicTwoRefCountInfo( strong );
     }
 
-    TwoRefLinks( const void * p, bool strong );
+    AtomicTwoRefCounts( const void * p, bool strong )
+        : m_counts( NULL )
+    {
+        void * temp = ThreadSafePointerAllocator::operator new(
+            sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( temp != 0 );
+#endif
+        void * p2 = const_cast< void * >( p );
+        m_counts = new ( temp )
+            Loki::Private::AtomicTwoRefCountInfo( p2, strong );
+    }
 
-    TwoRefLinks( const TwoRefLinks & rhs, bool strong );
+    AtomicTwoRefCounts( const AtomicTwoRefCounts & rhs, bool strong ) :
+        m_counts( rhs.m_counts )
+    {
+        Increment( strong );
+    }
 
-    bool Release( bool strong );
+    /** The destructor does not need to do anything since the call to
+     ZapPointer inside StrongPtr::~StrongPtr will do the cleanup which
+     this dtor would have done.
+     */
+    inline ~AtomicTwoRefCounts( void ) {}
 
-    void Swap( TwoRefLinks & rhs );
+    inline bool Release( bool strong )
+    {
+        return Decrement( strong );
+    }
 
-    bool Merge( TwoRefLinks & rhs );
+    void Increment( bool strong )
+    {
+        if ( strong )
+        {
+            m_counts->IncStrongCount();
+        }
+        else
+        {
+            m_counts->IncWeakCount();
+        }
+    }
 
-    bool HasStrongPointer( void ) const;
+    bool Decrement( bool strong )
+    {
+        bool noStrongPointers = false;
+        if ( strong )
+        {
+            noStrongPointers = m_counts->DecStrongCount();
+        }
+        else
+        {
+            m_counts->DecWeakCount();
+            noStrongPointers = !m_counts->HasStrongPointer();
+        }
+        return noStrongPointers;
+    }
 
-    inline void ZapPointer( void )
+    bool HasStrongPointer( void ) const
     {
-        ZapAllNodes();
+        return m_counts->HasStrongPointer();
     }
 
-    void SetPointer( void * p );
+    void Swap( AtomicTwoRefCounts & rhs )
+    {
+        std::swap( m_counts, rhs.m_counts );
+    }
+
+    void SetPointer( void * p )
+    {
+        m_counts->SetPointer( p );
+    }
+
+    void ZapPointer( void )
+    {
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( !m_counts->HasStrongPointer() );
+#endif
+        if ( m_counts->HasWeakPointer() )
+        {
+            m_counts->ZapPointer();
+        }
+        else
+        {
+            ThreadSafePointerAllocator::operator delete ( m_counts,
+                sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+            m_counts = NULL;
+        }
+    }
 
     inline void * GetPointer( void ) const
     {
-        return m_pointer;
+        return m_counts->GetPointer();
     }
 
     inline void * & GetPointerRef( void ) const
     {
-        return const_cast< void * & >( m_pointer );
+        return m_counts->GetPointerRef();
     }
 
-private:
-    static unsigned int CountPrevCycle( const TwoRefLinks * pThis );
-    static unsigned int CountNextCycle( const TwoRefLinks * pThis );
+    /// Record type shared by all copointers; used by ReleaseRange.
+    typedef Loki::Private::AtomicTwoRefCountInfo CountRecord;
 
-    /// Not implemented.
-    TwoRefLinks( void );
-    /// Not implemented.
-    TwoRefLinks & operator = ( const TwoRefLinks & );
+    /// Makes a record already holding count claims of the given strength,
+    /// for ReleaseRange to hand the emptied pointers.
+    static CountRecord * CreateSpareRecord( bool strong, unsigned int count )
+    {
+        void * temp = ThreadSafePointerAllocator::operator new(
+            sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( temp != 0 );
+#endif
+        CountRecord * info =
+            new ( temp ) Loki::Private::AtomicTwoRefCountInfo( strong );
+        for ( unsigned int i = 1; i < count; ++i )
+        {
+            if ( strong )
+            {
+                info->IncStrongCount();
+            }
+            else
+            {
+                info->IncWeakCount();
+            }
+        }
+        return info;
+    }
 
-    bool HasPrevNode( const TwoRefLinks * p ) const;
+    /// Repoints this policy at another record.  Only for ReleaseRange,
+    /// after this policy's claim on its old record was released.
+    void Adopt( CountRecord * counts )
+    {
+        m_counts = counts;
+    }
+
+private:
+    AtomicTwoRefCounts( void );
+    AtomicTwoRefCounts & operator = ( const AtomicTwoRefCounts & );
+
+    /// Pointer to all shared data.
+    Loki::Private::AtomicTwoRefCountInfo * m_counts;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class CoAllocatedTwoRefCounts
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   OwnershipPolicy for pointees made by CreateCoAllocated, whose
+///   AtomicTwoRefCountInfo lives in the same allocation as the object
+///   itself - immediately in front of it - so a strong/weak pair costs one
+///   block instead of two and the counts share a cache line with the
+///   object.  Constructing this policy from a non-null raw pointer adopts
+///   the counts in front of that pointer, so only pass in pointers that
+///   came from CreateCoAllocated.  The object holds a claim on the weak
+///   half of its own counts, dropped by DeleteCoAllocated after the
+///   destructor runs; whoever drops the weak half to zero - that claim or
+///   the last weak pointer - releases the whole block.  Use through
+///   CoAllocatedStrongPtr rather than by naming the policies directly.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT CoAllocatedTwoRefCounts
+{
+    typedef SmallValueObject< ::Loki::ClassLevelLockable > ThreadSafePointerAllocator;
+
+protected:
+
+    explicit CoAllocatedTwoRefCounts( bool strong )
+        : m_counts( NULL )
+    {
+        void * temp = ThreadSafePointerAllocator::operator new(
+            sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( temp != 0 );
+#endif
+        m_counts = new ( temp ) Loki::Private::AtomicTwoRefCountInfo( strong );
+    }
+
+    /** Adopts the count block CreateCoAllocated placed in front of *p and
+     adds this pointer to it.  A NULL p gets a standalone count block so
+     default-constructed and reset pointers still behave.
+     */
+    CoAllocatedTwoRefCounts( const void * p, bool strong )
+        : m_counts( NULL )
+    {
+        if ( NULL == p )
+        {
+            void * temp = ThreadSafePointerAllocator::operator new(
+                sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+            assert( temp != 0 );
+#endif
+            m_counts = new ( temp )
+                Loki::Private::AtomicTwoRefCountInfo( strong );
+        }
+        else
+        {
+            m_counts = reinterpret_cast< Loki::Private::AtomicTwoRefCountInfo * >(
+                reinterpret_cast< char * >( const_cast< void * >( p ) )
+                - sizeof(Loki::Private::AtomicTwoRefCountInfo) );
+            Increment( strong );
+        }
+    }
+
+    CoAllocatedTwoRefCounts( const CoAllocatedTwoRefCounts & rhs, bool strong ) :
+        m_counts( rhs.m_counts )
+    {
+        Increment( strong );
+    }
+
+    /** The destructor does not need to do anything since the call to
+     ZapPointer inside StrongPtr::~StrongPtr will do the cleanup which
+     this dtor would have done.
+     */
+    inline ~CoAllocatedTwoRefCounts( void ) {}
+
+    inline bool Release( bool strong )
+    {
+        return Decrement( strong );
+    }
+
+    void Increment( bool strong )
+    {
+        if ( strong )
+        {
+            m_counts->IncStrongCount();
+        }
+        else
+        {
+            m_counts->IncWeakCount();
+        }
+    }
+
+    bool Decrement( bool strong )
+    {
+        bool noStrongPointers = false;
+        if ( strong )
+        {
+            noStrongPointers = m_counts->DecStrongCount();
+        }
+        else
+        {
+            m_counts->DecWeakCount();
+            noStrongPointers = !m_counts->HasStrongPointer();
+        }
+        return noStrongPointers;
+    }
+
+    bool HasStrongPointer( void ) const
+    {
+        return m_counts->HasStrongPointer();
+    }
+
+    void Swap( CoAllocatedTwoRefCounts & rhs )
+    {
+        std::swap( m_counts, rhs.m_counts );
+    }
+
+    void SetPointer( void * p )
+    {
+        m_counts->SetPointer( p );
+    }
+
+    /** For a co-allocated pointee the weak half still carries the object's
+     own claim at this point, so this only ever zaps; the claim is dropped
+     and the block is released inside DeleteCoAllocated, after the pointee
+     is destroyed.  Standalone count blocks - from NULL construction - are
+     released here just as AtomicTwoRefCounts does.
+     */
+    void ZapPointer( void )
+    {
+#ifdef DO_EXTRA_LOKI_TESTS
+        assert( !m_counts->HasStrongPointer() );
+#endif
+        if ( m_counts->HasWeakPointer() )
+        {
+            m_counts->ZapPointer();
+        }
+        else
+        {
+            ThreadSafePointerAllocator::operator delete ( m_counts,
+                m_counts->GetBlockSize() );
+            m_counts = NULL;
+        }
+    }
+
+    inline void * GetPointer( void ) const
+    {
+        return m_counts->GetPointer();
+    }
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return m_counts->GetPointerRef();
+    }
+
+private:
+    CoAllocatedTwoRefCounts( void );
+    CoAllocatedTwoRefCounts & operator = ( const CoAllocatedTwoRefCounts & );
+
+    /// Pointer to all shared data.
+    Loki::Private::AtomicTwoRefCountInfo * m_counts;
+};
+
+#endif // atomic builtins and a threading model
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class DeleteCoAllocated
+///
+///  \ingroup  StrongPointerDeleteGroup
+///  Implementation of the DeletePolicy used by StrongPtr for objects made
+///   by CreateCoAllocated, which share one allocation with their reference
+///   counts.  This runs the destructor explicitly, then drops the weak
+///   claim the object holds on its count block; the block - counts and
+///   object together - is released when that claim was the last one.  Only
+///   use this policy together with the CoAllocatedTwoRefCounts ownership
+///   policy, or through CoAllocatedStrongPtr.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined( LOKI_SMARTPTR_ATOMIC_REFCOUNT ) \
+    && ( defined( LOKI_OBJECT_LEVEL_THREADING ) \
+        || defined( LOKI_CLASS_LEVEL_THREADING ) )
+
+template < class P >
+class DeleteCoAllocated
+{
+public:
+    static void Delete( const P * p )
+    {
+        if ( 0 == p )
+        {
+            return;
+        }
+        p->~P();
+        Private::AtomicTwoRefCountInfo * info =
+            reinterpret_cast< Private::AtomicTwoRefCountInfo * >(
+                reinterpret_cast< char * >( const_cast< P * >( p ) )
+                - sizeof(Private::AtomicTwoRefCountInfo) );
+        const std::size_t blockSize = info->GetBlockSize();
+        // Drop the claim the object holds on its own count block.  Weak
+        // pointers may still be watching the counts, so the block only
+        // goes away here when none remain.
+        if ( info->DecWeakCount() )
+        {
+            SmallValueObject< ::Loki::ClassLevelLockable >::operator delete(
+                info, blockSize );
+        }
+    }
+
+    /// Provides default value to initialize the pointer
+    inline static P * Default( void )
+    {
+        return 0;
+    }
+
+    inline void Swap( DeleteCoAllocated & ) {}
+};
+
+#endif // atomic builtins and a threading model
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class TwoRefLinks
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   This implementation of StrongPtr's OwnershipPolicy uses a doubly-linked
+///   cycle of copointers to a shared object. Some functions are trivial enough
+///   to be inline, while others are implemented in elsewhere.  It is not thread
+///   safe, and is intended for single-threaded environments.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT TwoRefLinks
+{
+protected:
+
+    inline explicit TwoRefLinks( bool strong )
+        : m_pointer( 0 )
+        , m_strong( strong )
+    {
+        m_prev = m_next = this;
+    }
+
+    TwoRefLinks( const void * p, bool strong );
+
+    TwoRefLinks( const TwoRefLinks & rhs, bool strong );
+
+    bool Release( bool strong );
+
+    void Swap( TwoRefLinks & rhs );
+
+    bool Merge( TwoRefLinks & rhs );
+
+    bool HasStrongPointer( void ) const;
+
+    inline void ZapPointer( void )
+    {
+        ZapAllNodes();
+    }
+
+    void SetPointer( void * p );
+
+    inline void * GetPointer( void ) const
+    {
+        return m_pointer;
+    }
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return const_cast< void * & >( m_pointer );
+    }
+
+private:
+    static unsigned int CountPrevCycle( const TwoRefLinks * pThis );
+    static unsigned int CountNextCycle( const TwoRefLinks * pThis );
+
+    /// Not implemented.
+    TwoRefLinks( void );
+    /// Not implemented.
+    TwoRefLinks & operator = ( const TwoRefLinks & );
+
+    bool HasPrevNode( const TwoRefLinks * p ) const;
     bool HasNextNode( const TwoRefLinks * p ) const;
     bool AllNodesHaveSamePointer( void ) const;
     void ZapAllNodes( void );
@@ -959,6 +1571,28 @@ public:
         return RefToValue< StrongPtr >( *this );
     }
 
+#ifdef LOKI_HAS_RVALUE_REFERENCES
+
+    /// Move constructor starts out default-constructed and swaps with rhs,
+    /// so the shared reference counts are never touched; rhs is left as an
+    /// empty pointer.
+    StrongPtr( StrongPtr && rhs ) : OP( Strong )
+    {
+        KP::OnDefault( GetPointer() );
+        Swap( rhs );
+    }
+
+    StrongPtr & operator = ( StrongPtr && rhs )
+    {
+        if ( this != &rhs )
+        {
+            StrongPtr temp( std::move( rhs ) );
+            temp.Swap( *this );
+        }
+        return *this;
+    }
+#endif
+
     StrongPtr & operator = ( const StrongPtr & rhs )
     {
         if ( GetPointer() != rhs.GetPointer() )
@@ -1063,6 +1697,61 @@ public:
         return true;
     }
 
+    /** Releases every claim in the contiguous range [ first, last ) in
+     bulk, with the same effect as destroying each pointer, but ordered by
+     pointee address: the count updates run in one sorted pass and the
+     last-owner deletions follow in a second sorted sweep, so tearing down
+     millions of pointers walks memory forward instead of hopping wherever
+     the range happens to point.  Each pointer is left holding a claim on
+     one shared empty record, so the destructors that eventually run on
+     them are trivial and touch only that record.  Requires an
+     OwnershipPolicy providing CountRecord, CreateSpareRecord and Adopt -
+     TwoRefCounts and AtomicTwoRefCounts do.
+     */
+    friend void ReleaseRange( StrongPtr * first, StrongPtr * last )
+    {
+        if ( first == last )
+        {
+            return;
+        }
+        typedef std::pair< void *, StrongPtr * > Entry;
+        std::vector< Entry > order;
+        order.reserve( last - first );
+        for ( StrongPtr * sp = first; sp != last; ++sp )
+        {
+            order.push_back( Entry( sp->OP::GetPointer(), sp ) );
+        }
+        std::sort( order.begin(), order.end() );
+
+        // One spare record carries a claim for every emptied pointer, so
+        // their destructors stay legitimate without a fresh record apiece.
+        typename StrongPtr::OP::CountRecord * spare =
+            StrongPtr::OP::CreateSpareRecord( Strong,
+                static_cast< unsigned int >( last - first ) );
+
+        std::vector< Entry > victims;
+        for ( typename std::vector< Entry >::iterator it = order.begin();
+            it != order.end(); ++it )
+        {
+            StrongPtr & sp = *( it->second );
+            if ( sp.OP::Release( Strong ) )
+            {
+                T * p = sp.GetPointer();
+                sp.OP::ZapPointer();
+                if ( p != 0 )
+                {
+                    victims.push_back( Entry( p, &sp ) );
+                }
+            }
+            sp.OP::Adopt( spare );
+        }
+        for ( typename std::vector< Entry >::iterator it = victims.begin();
+            it != victims.end(); ++it )
+        {
+            it->second->DP::Delete( static_cast< T * >( it->first ) );
+        }
+    }
+
 #else
 
     template
@@ -1094,6 +1783,20 @@ public:
     friend bool ResetAll( StrongPtr< T1, S1, OP1, CP1, KP1, RP1, DP1, CNP1 > & sp,
         typename StrongPtr< T1, S1, OP1, CP1, KP1, RP1, DP1, CNP1 >::StoredType p );
 
+    template
+    <
+        typename T1,
+        bool S1,
+        class OP1,
+        class CP1,
+        template < class > class KP1,
+        template < class > class RP1,
+        template < class > class DP1,
+        template < class > class CNP1
+    >
+    friend void ReleaseRange( StrongPtr< T1, S1, OP1, CP1, KP1, RP1, DP1, CNP1 > * first,
+        StrongPtr< T1, S1, OP1, CP1, KP1, RP1, DP1, CNP1 > * last );
+
 #endif
 
 
@@ -1413,9 +2116,465 @@ bool ResetAll( StrongPtr< T, S, OP, CP, KP, RP, DP, CNP > & sp,
   sp.OP::SetPointer( p );
   return true;
 }
+
+template
+<
+    typename U,
+    typename T,
+    bool S,
+    class OP,
+    class CP,
+    template < class > class KP,
+    template < class > class RP,
+    template < class > class DP,
+    template < class > class CNP
+>
+void ReleaseRange( StrongPtr< T, S, OP, CP, KP, RP, DP, CNP > * first,
+                   StrongPtr< T, S, OP, CP, KP, RP, DP, CNP > * last )
+{
+    typedef StrongPtr< T, S, OP, CP, KP, RP, DP, CNP > Ptr;
+    if ( first == last )
+    {
+        return;
+    }
+    typedef std::pair< void *, Ptr * > Entry;
+    std::vector< Entry > order;
+    order.reserve( last - first );
+    for ( Ptr * sp = first; sp != last; ++sp )
+    {
+        order.push_back( Entry( sp->OP::GetPointer(), sp ) );
+    }
+    std::sort( order.begin(), order.end() );
+
+    typename OP::CountRecord * spare = OP::CreateSpareRecord( S,
+        static_cast< unsigned int >( last - first ) );
+
+    std::vector< Entry > victims;
+    for ( typename std::vector< Entry >::iterator it = order.begin();
+        it != order.end(); ++it )
+    {
+        Ptr & sp = *( it->second );
+        if ( sp.OP::Release( S ) )
+        {
+            T * p = sp.GetPointer();
+            sp.OP::ZapPointer();
+            if ( p != 0 )
+            {
+                victims.push_back( Entry( p, &sp ) );
+            }
+        }
+        sp.OP::Adopt( spare );
+    }
+    for ( typename std::vector< Entry >::iterator it = victims.begin();
+        it != victims.end(); ++it )
+    {
+        it->second->DP<T>::Delete( static_cast< T * >( it->first ) );
+    }
+}
 #endif
 
 
+////////////////////////////////////////////////////////////////////////////////
+///  \struct CoAllocatedStrongPtr
+///
+///  \ingroup SmartPointerGroup
+///  Names the StrongPtr instantiation whose counts and pointee share one
+///  allocation: instead of writing out the CoAllocatedTwoRefCounts and
+///  DeleteCoAllocated policies, write CoAllocatedStrongPtr<T>::Type, or
+///  CoAllocatedStrongPtr<T, false>::Type for the matching weak pointer.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined( LOKI_SMARTPTR_ATOMIC_REFCOUNT ) \
+    && ( defined( LOKI_OBJECT_LEVEL_THREADING ) \
+        || defined( LOKI_CLASS_LEVEL_THREADING ) )
+
+    template < class T, bool Strong = true >
+    struct CoAllocatedStrongPtr
+    {
+        typedef StrongPtr
+        <
+            T,
+            Strong,
+            CoAllocatedTwoRefCounts,
+            DisallowConversion,
+            AssertCheck,
+            CantResetWithStrong,
+            DeleteCoAllocated
+        >
+        Type;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+///  Creates a T and its strong/weak counts inside one allocation - the
+///  make_shared of StrongPtr - and returns a CoAllocatedStrongPtr owning
+///  it.  Every StrongPtr built the usual way costs two allocations, one
+///  for T and one for the count block; this halves the allocator traffic
+///  and keeps the atomic count word on the same cache line as the object.
+///  The overloads forward up to four constructor arguments.  If T's
+///  constructor throws, the block is released and the exception
+///  propagates.
+///  \ingroup SmartPointerGroup
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        /// Allocates the co-allocated block.  Shared by the
+        /// CreateCoAllocated overloads; returns where T goes.
+        inline void * CreateCoAllocatedBlock( std::size_t objectSize )
+        {
+            void * block =
+                SmallValueObject< ::Loki::ClassLevelLockable >::operator new(
+                    sizeof(AtomicTwoRefCountInfo) + objectSize );
+            return static_cast< AtomicTwoRefCountInfo * >( block ) + 1;
+        }
+
+        /// Releases a co-allocated block when T's constructor throws.
+        inline void DiscardCoAllocatedBlock( void * place,
+            std::size_t objectSize )
+        {
+            SmallValueObject< ::Loki::ClassLevelLockable >::operator delete(
+                static_cast< AtomicTwoRefCountInfo * >( place ) - 1,
+                sizeof(AtomicTwoRefCountInfo) + objectSize );
+        }
+
+        /// Readies the counts in front of a just constructed pointee.  The
+        /// weak half starts at one - the claim the object itself holds
+        /// until DeleteCoAllocated drops it.
+        inline void * ReadyCoAllocatedCounts( void * object,
+            std::size_t objectSize )
+        {
+            AtomicTwoRefCountInfo * info =
+                static_cast< AtomicTwoRefCountInfo * >( object ) - 1;
+            new ( info ) AtomicTwoRefCountInfo( object, false );
+            info->SetBlockSize( sizeof(AtomicTwoRefCountInfo) + objectSize );
+            return object;
+        }
+    }
+
+    template < class T >
+    typename CoAllocatedStrongPtr< T >::Type CreateCoAllocated( void )
+    {
+        void * place = Private::CreateCoAllocatedBlock( sizeof(T) );
+        try
+        {
+            return typename CoAllocatedStrongPtr< T >::Type( static_cast< T * >(
+                Private::ReadyCoAllocatedCounts( ::new ( place ) T,
+                    sizeof(T) ) ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCoAllocatedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template < class T, class A1 >
+    typename CoAllocatedStrongPtr< T >::Type CreateCoAllocated( const A1 & a1 )
+    {
+        void * place = Private::CreateCoAllocatedBlock( sizeof(T) );
+        try
+        {
+            return typename CoAllocatedStrongPtr< T >::Type( static_cast< T * >(
+                Private::ReadyCoAllocatedCounts( ::new ( place ) T( a1 ),
+                    sizeof(T) ) ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCoAllocatedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template < class T, class A1, class A2 >
+    typename CoAllocatedStrongPtr< T >::Type CreateCoAllocated( const A1 & a1,
+        const A2 & a2 )
+    {
+        void * place = Private::CreateCoAllocatedBlock( sizeof(T) );
+        try
+        {
+            return typename CoAllocatedStrongPtr< T >::Type( static_cast< T * >(
+                Private::ReadyCoAllocatedCounts( ::new ( place ) T( a1, a2 ),
+                    sizeof(T) ) ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCoAllocatedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template < class T, class A1, class A2, class A3 >
+    typename CoAllocatedStrongPtr< T >::Type CreateCoAllocated( const A1 & a1,
+        const A2 & a2, const A3 & a3 )
+    {
+        void * place = Private::CreateCoAllocatedBlock( sizeof(T) );
+        try
+        {
+            return typename CoAllocatedStrongPtr< T >::Type( static_cast< T * >(
+                Private::ReadyCoAllocatedCounts( ::new ( place ) T( a1, a2, a3 ),
+                    sizeof(T) ) ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCoAllocatedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+    template < class T, class A1, class A2, class A3, class A4 >
+    typename CoAllocatedStrongPtr< T >::Type CreateCoAllocated( const A1 & a1,
+        const A2 & a2, const A3 & a3, const A4 & a4 )
+    {
+        void * place = Private::CreateCoAllocatedBlock( sizeof(T) );
+        try
+        {
+            return typename CoAllocatedStrongPtr< T >::Type( static_cast< T * >(
+                Private::ReadyCoAllocatedCounts(
+                    ::new ( place ) T( a1, a2, a3, a4 ), sizeof(T) ) ) );
+        }
+        catch ( ... )
+        {
+            Private::DiscardCoAllocatedBlock( place, sizeof(T) );
+            throw;
+        }
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class AtomicStrongPtr
+///
+///  \ingroup SmartPointerGroup
+///  One shared, mutable pointer slot many threads may Load and Store
+///  concurrently without a lock - the equivalent of atomic_load and
+///  atomic_store for shared_ptr.  Use it for read-mostly data published
+///  once and copied per request, such as configuration snapshots, where
+///  funnelling every reader through one mutex serializes them.
+///
+///  The slot packs a transient reader count into the upper bits of the
+///  pointer word and uses split reference counting: Load reserves a
+///  reference with one fetch-and-add on the slot, pays it into the
+///  pointee's own strong count, and returns the reserved word.  A
+///  concurrent Store pays any outstanding reservations forward before it
+///  releases the old pointee, so readers never touch a count block that
+///  could disappear under them, and readers of an unchanging slot never
+///  wait on each other or on writers.
+///
+///  The slot holds pointers made by CreateCoAllocated - the counts must
+///  sit in front of the pointee - and requires a 64-bit platform with
+///  spare upper pointer bits.  Up to 65535 Loads may overlap on one slot.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN64 ) || defined( __x86_64__ ) || defined( __aarch64__ ) \
+    || defined( __powerpc64__ )
+
+    template < class T >
+    class AtomicStrongPtr
+    {
+    public:
+
+        typedef typename CoAllocatedStrongPtr< T >::Type PointerType;
+
+        inline AtomicStrongPtr( void )
+            : m_slot( 0 )
+        {
+        }
+
+        /// Starts out owning whatever the pointer owns, shared with it.
+        explicit AtomicStrongPtr( const PointerType & sp )
+            : m_slot( 0 )
+        {
+            Store( sp );
+        }
+
+        /** Releases whatever the slot still holds.  This deliberately does
+         not go through Store: default-constructing a PointerType allocates
+         a standalone count block, which must not happen during static
+         destruction when the slot is a global.
+         */
+        inline ~AtomicStrongPtr( void )
+        {
+            Replace( NULL );
+        }
+
+        /** Returns a StrongPtr sharing ownership of whatever the slot held
+         at some instant during the call.  Safe against concurrent Loads
+         and Stores; costs one atomic add on the slot plus one on the
+         pointee's counts.
+         */
+        PointerType Load( void )
+        {
+            const SlotWord reserved = Reserve();
+            void * p = PointerOf( reserved );
+            if ( NULL == p )
+            {
+                Unreserve( p );
+                return PointerType();
+            }
+            // The reservation keeps the count block alive while this copy
+            // pays its own way in.
+            PointerType result( static_cast< T * >( p ) );
+            if ( !Unreserve( p ) )
+            {
+                // A Store already paid for the reservation, so the copy
+                // above counted the reference twice.  The result itself
+                // keeps the strong count above zero, so no release logic
+                // is needed here.
+                CountsOf( p )->DecStrongCount();
+            }
+            return result;
+        }
+
+        /** Publishes the pointer's pointee, releasing whatever the slot
+         held before.  Safe against concurrent Loads and Stores.
+         */
+        void Store( const PointerType & sp )
+        {
+            T * newPtr = NULL;
+            if ( sp )
+            {
+                newPtr = const_cast< PointerType & >( sp ).operator ->();
+                // The slot holds a strong reference of its own.
+                CountsOf( newPtr )->IncStrongCount();
+            }
+            Replace( newPtr );
+        }
+
+    private:
+        /// Not implemented - the slot itself is not copyable.
+        AtomicStrongPtr( const AtomicStrongPtr & );
+        /// Not implemented.
+        AtomicStrongPtr & operator = ( const AtomicStrongPtr & );
+
+        /** Swaps newPtr - whose slot reference the caller already counted -
+         into the slot and releases the previous occupant.
+         */
+        void Replace( T * newPtr )
+        {
+            const SlotWord old = Exchange(
+                reinterpret_cast< SlotWord >( newPtr ) );
+            void * oldPtr = PointerOf( old );
+            if ( NULL == oldPtr )
+            {
+                return;
+            }
+            ::Loki::Private::AtomicTwoRefCountInfo * counts =
+                CountsOf( oldPtr );
+            // Pay forward every reservation still in flight; each matching
+            // Load will see the slot changed and skip its own payment.
+            for ( SlotWord r = old >> ReservedShift(); 0 != r; --r )
+            {
+                counts->IncStrongCount();
+            }
+            // Release the slot's own reference the same way the
+            // CoAllocatedTwoRefCounts policy would.
+            if ( counts->DecStrongCount() )
+            {
+                T * p = static_cast< T * >( counts->GetPointer() );
+                counts->ZapPointer();
+                if ( NULL != p )
+                {
+                    DeleteCoAllocated< T >::Delete( p );
+                }
+            }
+        }
+
+#if defined( _MSC_VER )
+        typedef unsigned __int64 SlotWord;
+#else
+        typedef unsigned long long SlotWord;
+#endif
+
+        inline static unsigned int ReservedShift( void )
+        {
+            return 48;
+        }
+
+        inline static SlotWord ReservedOne( void )
+        {
+            return static_cast< SlotWord >( 1 ) << ReservedShift();
+        }
+
+        inline static void * PointerOf( SlotWord word )
+        {
+            return reinterpret_cast< void * >(
+                word & ( ReservedOne() - 1 ) );
+        }
+
+        inline static ::Loki::Private::AtomicTwoRefCountInfo * CountsOf(
+            void * p )
+        {
+            return reinterpret_cast< ::Loki::Private::AtomicTwoRefCountInfo * >(
+                reinterpret_cast< char * >( p )
+                - sizeof(::Loki::Private::AtomicTwoRefCountInfo) );
+        }
+
+        /// Bumps the reservation count and returns the word as it was.
+        inline SlotWord Reserve( void )
+        {
+#if defined( _MSC_VER )
+            return static_cast< SlotWord >( ::_InterlockedExchangeAdd64(
+                reinterpret_cast< volatile __int64 * >( &m_slot ),
+                static_cast< __int64 >( ReservedOne() ) ) );
+#else
+            return __sync_fetch_and_add( &m_slot, ReservedOne() );
+#endif
+        }
+
+        /** Takes back one reservation, as long as the slot still holds p
+         and has any reservations left to take.  Returns false when a
+         Store intervened - the reservations it saw were paid forward, and
+         because they are interchangeable, it does not matter whether the
+         one paid for was nominally ours.  For a null p there is nothing
+         owed either way, so the return value is moot.
+         */
+        bool Unreserve( void * p )
+        {
+            for ( ;; )
+            {
+                const SlotWord seen = m_slot;
+                if ( ( PointerOf( seen ) != p )
+                    || ( 0 == ( seen >> ReservedShift() ) ) )
+                {
+                    return false;
+                }
+                if ( CompareAndSwap( seen, seen - ReservedOne() ) )
+                {
+                    return true;
+                }
+            }
+        }
+
+        inline bool CompareAndSwap( SlotWord expected, SlotWord with )
+        {
+#if defined( _MSC_VER )
+            return static_cast< __int64 >( expected )
+                == ::_InterlockedCompareExchange64(
+                    reinterpret_cast< volatile __int64 * >( &m_slot ),
+                    static_cast< __int64 >( with ),
+                    static_cast< __int64 >( expected ) );
+#else
+            return __sync_bool_compare_and_swap( &m_slot, expected, with );
+#endif
+        }
+
+        SlotWord Exchange( SlotWord with )
+        {
+            for ( ;; )
+            {
+                const SlotWord seen = m_slot;
+                if ( CompareAndSwap( seen, with ) )
+                {
+                    return seen;
+                }
+            }
+        }
+
+        volatile SlotWord m_slot;
+    };
+
+#endif // 64-bit platform
+
+#endif // atomic builtins and a threading model
+
 // free comparison operators for class template StrongPtr
 
 ///  operator== for lhs = StrongPtr, rhs = raw pointer
@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// ThreadPool facility for the Loki Library
+// Copyright (c) 2008 Richard Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+/// @file ThreadPool.h Defines ThreadPool, a fixed pool of worker threads
+///  which executes tasks expressed as Loki::Functor< void >.
+
+#ifndef LOKI_THREAD_POOL_H_INCLUDED
+#define LOKI_THREAD_POOL_H_INCLUDED
+
+
+// ----------------------------------------------------------------------------
+
+#include <loki/Functor.h>
+
+#include <deque>
+#include <vector>
+
+#if defined( _MSC_VER )
+    #include <Windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+
+namespace Loki
+{
+
+// ----------------------------------------------------------------------------
+
+/** @class ThreadPool
+ A fixed pool of worker threads which executes tasks expressed as
+ Loki::Functor< void >.  The threads are created once, so running a task
+ costs a queue operation instead of a thread creation, and the pool keeps
+ every core busy as long as tasks remain.  The pool is a plain class rather
+ than a singleton - make one per subsystem, or wrap one in SingletonHolder
+ if a program wants a single process-wide pool.
+
+ @par Work Stealing
+ Each worker owns a deque of tasks.  A worker takes tasks from the back of
+ its own deque, so a task spawned by another task tends to run on the same
+ thread while its data is still warm in that core's cache.  When a worker's
+ own deque drains, it steals from the front of another worker's deque - the
+ oldest task, whose data the victim is least likely to touch soon.  Tasks
+ added from threads outside the pool are dealt to the workers round-robin.
+ Because idle workers steal, an uneven task mix still spreads across the
+ pool without any central queue to fight over.
+
+ @par Tasks
+ A task is any Loki::Functor< void > - a function, a member function bound
+ with BindFirst, or a functor object.  Tasks must not throw exceptions; a
+ task which does gets its exception swallowed so one bad task cannot kill a
+ worker thread.  A task may call AddTask to spawn further tasks, and may
+ call nothing else on the pool.  Calling WaitForIdle or the destructor from
+ inside a task deadlocks, just as joining a thread from itself would.
+
+ @par Exception safety
+ The constructor throws ::std::runtime_error if the platform cannot supply
+ the threads or synchronization primitives.  AddTask provides the strong
+ exception guarantee - if copying the task into a queue throws, the pool is
+ unchanged.
+
+ @par Build requirements
+ Functors allocate their implementations through the SmallObject allocator,
+ and pool threads copy and destroy tasks concurrently, so Loki must be
+ compiled with a threading model - define LOKI_CLASS_LEVEL_THREADING or
+ LOKI_OBJECT_LEVEL_THREADING for the whole project, as with any
+ multithreaded use of Loki.
+ */
+class ThreadPool
+{
+public:
+
+    /// Type of task the pool executes.
+    typedef ::Loki::Functor< void > Task;
+
+    /** Creates the worker threads.  The workers start idle and cost nothing
+     but their stacks until tasks arrive.
+     @param threadCount How many workers to make.  Zero means one per
+      processor, which suits compute-bound tasks; tasks which block should
+      get a larger count.
+     */
+    explicit ThreadPool( unsigned int threadCount = 0 );
+
+    /** Waits for all queued tasks to finish, then stops and joins every
+     worker thread.  Do not call from inside a task.
+     */
+    ~ThreadPool( void );
+
+    /** Adds a task for the pool to execute.  Called from inside a task,
+     this places the new task on the calling worker's own deque so related
+     tasks stay cache-warm; called from any other thread, it deals tasks to
+     the workers round-robin.  May be called by several threads at once.
+     @param task Functor to execute.  The pool keeps its own copy.  Empty
+      functors are quietly ignored.
+     */
+    void AddTask( const Task & task );
+
+    /** Waits until every queued task has finished executing.  The pool
+     remains usable afterwards - this is a barrier, not a shutdown.  Do not
+     call from inside a task.
+     */
+    void WaitForIdle( void );
+
+    /// Returns the number of worker threads in the pool.
+    inline unsigned int GetThreadCount( void ) const
+    {
+        return static_cast< unsigned int >( m_workers.size() );
+    }
+
+    /** Returns the number of processors on this machine, which is the
+     worker count a default-constructed pool gets.  Never returns zero.
+     */
+    static unsigned int GetProcessorCount( void );
+
+private:
+
+    /** @class Worker
+     One worker thread and the deque of tasks it owns.  Only the owning
+     thread touches the back of the deque; thieves take from the front.
+     The deque mutex is held just long enough to move one task, so workers
+     rarely collide on it.
+     */
+    class Worker
+    {
+    public:
+
+        Worker( ThreadPool * owner, unsigned int index );
+
+        ~Worker( void );
+
+        /// Starts the underlying thread.  Separate from the constructor so
+        /// the thread never sees a partly built pool.
+        void Start( void );
+
+        /// Signals the thread to exit once no tasks remain, then joins it.
+        void Stop( void );
+
+        /// Places a task on this worker's deque.  @param atBack True when
+        /// the owning thread adds its own spawned task, false for tasks
+        /// dealt from outside so they queue behind the worker's own work.
+        void Push( const Task & task, bool atBack );
+
+        /// Takes a task from the back of this worker's own deque.
+        /// @return True if a task was taken.
+        bool PopBack( Task & task );
+
+        /// Steals the oldest task from the front of this worker's deque.
+        /// @return True if a task was stolen.
+        bool Steal( Task & task );
+
+    private:
+
+        /// Default constructor is not implemented.
+        Worker( void );
+        /// Copy constructor is not implemented.
+        Worker( const Worker & );
+        /// Copy-assignment operator is not implemented.
+        Worker & operator = ( const Worker & );
+
+#if defined( _MSC_VER )
+        static unsigned int __stdcall TopFunction( void * p );
+#else
+        static void * TopFunction( void * p );
+#endif
+
+        /// Runs tasks until the pool stops: own deque first, then steal,
+        /// then sleep until more work arrives.
+        void Run( void );
+
+        /// Pool this worker belongs to.
+        ThreadPool * const m_owner;
+
+        /// Index of this worker within the pool, where stealing starts.
+        const unsigned int m_index;
+
+        /// Tasks owned by this worker.
+        ::std::deque< Task > m_tasks;
+
+#if defined( _MSC_VER )
+        /// Guards m_tasks.
+        CRITICAL_SECTION m_tasksMutex;
+        /// The underlying thread.
+        HANDLE m_thread;
+#else
+        /// Guards m_tasks.
+        pthread_mutex_t m_tasksMutex;
+        /// The underlying thread.
+        pthread_t m_thread;
+#endif
+
+        /// True while the underlying thread runs, so Stop only joins
+        /// threads Start actually made.
+        bool m_started;
+
+    }; // end class Worker
+
+    friend class Worker;
+
+    /// Copy-constructor is not implemented.
+    ThreadPool( const ThreadPool & );
+
+    /// Copy-assignment operator is not implemented.
+    ThreadPool & operator = ( const ThreadPool & );
+
+    /** Takes a task for the calling worker: its own deque first, then a
+     steal sweep over the other workers starting after the caller.
+     @return True if a task was found.
+     */
+    bool FindTask( unsigned int index, Task & task );
+
+    /// Called by a worker after finishing a task; wakes WaitForIdle when
+    /// the last task completes.
+    void TaskDone( void );
+
+    typedef ::std::vector< Worker * > Workers;
+    typedef Workers::iterator WorkersIter;
+
+    /// The worker threads.
+    Workers m_workers;
+
+    /// Next worker to receive a task dealt from outside the pool.
+    unsigned int m_nextWorker;
+
+    /// Number of tasks queued or executing.  Guarded by m_mutex.
+    unsigned int m_pendingCount;
+
+    /// Number of tasks sitting in worker deques.  Guarded by m_mutex, and
+    /// lets idle workers sleep instead of rescanning empty deques.
+    unsigned int m_queuedCount;
+
+    /// True once the destructor tells the workers to exit.
+    volatile bool m_stop;
+
+#if defined( _MSC_VER )
+    /// Guards the counters above.
+    CRITICAL_SECTION m_mutex;
+    /// Auto-reset event signalled when a task arrives or the pool stops.
+    HANDLE m_wakeEvent;
+    /// Manual-reset event signalled while no tasks are pending.
+    HANDLE m_idleEvent;
+#else
+    /// Guards the counters above.
+    pthread_mutex_t m_mutex;
+    /// Signalled when a task arrives or the pool stops.
+    pthread_cond_t m_wakeCondition;
+    /// Signalled when the last pending task finishes.
+    pthread_cond_t m_idleCondition;
+#endif
+
+}; // end class ThreadPool
+
+// ----------------------------------------------------------------------------
+
+} // end namespace Loki
+
+#endif  // end file guard
@@ -24,6 +24,8 @@
 ///  - SingleThreaded
 ///  - ObjectLevelLockable
 ///  - ClassLevelLockable
+///  - ObjectLevelReadWriteLockable
+///  - ClassLevelReadWriteLockable
 ///
 ///  All classes in Loki have configurable threading model.
 ///
@@ -81,16 +83,90 @@
 #define LOKI_DEFAULT_MUTEX ::Loki::Mutex
 #endif
 
+///  Number of mutexes StripedLevelLockable spreads its hosts over.
+///  Must be a power of two.
+#ifndef LOKI_STRIPED_LOCK_COUNT
+#define LOKI_STRIPED_LOCK_COUNT 256
+#endif
+
+#ifndef LOKI_DEFAULT_RWMUTEX
+#define LOKI_DEFAULT_RWMUTEX ::Loki::RWMutex
+#endif
+
+///  Number of cache-line-padded slots DistributedCounter spreads its
+///  increments over.  Must be a power of two.  More slots cost memory
+///  (one cache line each) but keep more concurrent threads off each
+///  other's lines.
+#ifndef LOKI_DISTRIBUTED_COUNTER_SLOTS
+#define LOKI_DISTRIBUTED_COUNTER_SLOTS 16
+#endif
+
+/** Thread local storage keyword.  Kept in sync with LevelMutex.h, which
+ defines the same guarded macro for compilers that spell it differently.
+ */
+#ifndef LOKI_THREAD_LOCAL
+    #if defined( _MSC_VER )
+        #if ( _MSC_VER >= 1300 )
+            #define LOKI_THREAD_LOCAL __declspec( thread )
+        #else
+            #error "Only Visual Studio versions 7.0 and after supported."
+        #endif
+
+    #elif ( __GNUC__ )
+        #define LOKI_THREAD_LOCAL __thread
+
+    #else
+        #warning "Check if your compiler provides thread local storage."
+        #define LOKI_THREAD_LOCAL thread_local
+    #endif
+#endif
+
 #ifdef LOKI_WINDOWS_H
 
 #define LOKI_THREADS_MUTEX(x)           CRITICAL_SECTION (x);
 #define LOKI_THREADS_MUTEX_INIT(x)      ::InitializeCriticalSection (x)
 #define LOKI_THREADS_MUTEX_DELETE(x)    ::DeleteCriticalSection (x)
 #define LOKI_THREADS_MUTEX_LOCK(x)      ::EnterCriticalSection (x)
+#define LOKI_THREADS_MUTEX_TRYLOCK(x)   ::TryEnterCriticalSection (x)
 #define LOKI_THREADS_MUTEX_UNLOCK(x)    ::LeaveCriticalSection (x)
 #define LOKI_THREADS_LONG               LONG
 #define LOKI_THREADS_MUTEX_CTOR(x)
 
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0600)
+// slim reader/writer locks (Vista and later)
+#define LOKI_THREADS_RWMUTEX(x)              SRWLOCK (x);
+#define LOKI_THREADS_RWMUTEX_INIT(x)         ::InitializeSRWLock (x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)
+#define LOKI_THREADS_RWMUTEX_READ_LOCK(x)    ::AcquireSRWLockShared (x)
+#define LOKI_THREADS_RWMUTEX_READ_UNLOCK(x)  ::ReleaseSRWLockShared (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_LOCK(x)   ::AcquireSRWLockExclusive (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_UNLOCK(x) ::ReleaseSRWLockExclusive (x)
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0601)
+#define LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(x)  (0 != ::TryAcquireSRWLockShared (x))
+#define LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(x) (0 != ::TryAcquireSRWLockExclusive (x))
+#else
+// no try-acquire for SRW locks before Windows 7; report contention,
+// which is safe - a try-lock may spuriously fail, never spuriously succeed
+#define LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(x)  0
+#define LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(x) 0
+#endif
+#else
+// no native reader/writer lock before Vista; readers serialize
+#define LOKI_THREADS_RWMUTEX(x)              CRITICAL_SECTION (x);
+#define LOKI_THREADS_RWMUTEX_INIT(x)         ::InitializeCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)       ::DeleteCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_READ_LOCK(x)    ::EnterCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_READ_UNLOCK(x)  ::LeaveCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_LOCK(x)   ::EnterCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_UNLOCK(x) ::LeaveCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(x)  ::TryEnterCriticalSection (x)
+#define LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(x) ::TryEnterCriticalSection (x)
+#endif
+
+// The memory-order-named variants at the end mirror those of the
+// builtin backend in the pthread section; the Interlocked family is
+// always a full barrier, so here they differ from the plain versions
+// only in bypassing the mutex.
 #define LOKI_THREADS_ATOMIC_FUNCTIONS                                   \
         static IntType AtomicMultiply(volatile IntType& lval, const IntType val) \
         {                                                               \
@@ -182,6 +258,71 @@
             matches = ( lval == compare );                              \
             ::LeaveCriticalSection( &atomic_mutex_ );                    \
             return lval;                                                \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrementRelaxed(volatile IntType& lval)   \
+        { return InterlockedIncrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicDecrementAcqRel(volatile IntType& lval)    \
+        { return InterlockedDecrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static void AtomicAssignRelease(volatile IntType& lval, const IntType val) \
+        { InterlockedExchange(&const_cast<IntType&>(lval), val); }      \
+                                                                        \
+        static IntType AtomicLoadAcquire(volatile const IntType& lval)  \
+        { return InterlockedExchangeAdd(&const_cast<IntType&>(lval), 0); } \
+                                                                        \
+        static IntType AtomicIncrementAcquire(volatile IntType& lval)   \
+        { return InterlockedIncrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicIncrementRelease(volatile IntType& lval)   \
+        { return InterlockedIncrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicIncrementAcqRel(volatile IntType& lval)    \
+        { return InterlockedIncrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicDecrementRelaxed(volatile IntType& lval)   \
+        { return InterlockedDecrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicDecrementAcquire(volatile IntType& lval)   \
+        { return InterlockedDecrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static IntType AtomicDecrementRelease(volatile IntType& lval)   \
+        { return InterlockedDecrement(&const_cast<IntType&>(lval)); }   \
+                                                                        \
+        static void AtomicAssignRelaxed(volatile IntType& lval, const IntType val) \
+        { lval = val; }                                                 \
+                                                                        \
+        static IntType AtomicLoadRelaxed(volatile const IntType& lval)  \
+        { return lval; }                                                \
+                                                                        \
+        static bool AtomicCompareAndSwap(volatile IntType& lval, const IntType compare, const IntType val) \
+        {                                                               \
+            return compare == InterlockedCompareExchange(               \
+                &const_cast<IntType&>(lval), val, compare );            \
+        }
+
+// Pointer-sized load-acquire and store-release, used for publication
+// patterns such as the double-checked fast path in SingletonHolder.
+// The Interlocked pointer functions are full barriers, which subsumes
+// the acquire and release orderings the names promise.
+#define LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS                           \
+        template < class Ptr >                                          \
+        static Ptr AtomicLoadPtrAcquire(Ptr volatile & pval)            \
+        {                                                               \
+            return reinterpret_cast< Ptr >(                             \
+                InterlockedCompareExchangePointer(                      \
+                    reinterpret_cast< PVOID volatile * >(               \
+                        const_cast< Ptr * >( &pval ) ), 0, 0 ) );       \
+        }                                                               \
+                                                                        \
+        template < class Ptr >                                          \
+        static void AtomicAssignPtrRelease(Ptr volatile & pval, Ptr val) \
+        {                                                               \
+            InterlockedExchangePointer(                                 \
+                reinterpret_cast< PVOID volatile * >(                   \
+                    const_cast< Ptr * >( &pval ) ),                     \
+                reinterpret_cast< PVOID >( val ) );                     \
         }
 
 #elif defined(LOKI_PTHREAD_H)
@@ -202,14 +343,315 @@
 
 #define LOKI_THREADS_MUTEX_DELETE(x)    ::pthread_mutex_destroy (x)
 #define LOKI_THREADS_MUTEX_LOCK(x)      ::pthread_mutex_lock (x)
+#define LOKI_THREADS_MUTEX_TRYLOCK(x)   (::pthread_mutex_trylock (x) == 0)
 #define LOKI_THREADS_MUTEX_UNLOCK(x)    ::pthread_mutex_unlock (x)
 #define LOKI_THREADS_LONG               long
 
+#define LOKI_THREADS_RWMUTEX(x)              pthread_rwlock_t (x);
+#define LOKI_THREADS_RWMUTEX_INIT(x)         ::pthread_rwlock_init (x, 0)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)       ::pthread_rwlock_destroy (x)
+#define LOKI_THREADS_RWMUTEX_READ_LOCK(x)    ::pthread_rwlock_rdlock (x)
+#define LOKI_THREADS_RWMUTEX_READ_UNLOCK(x)  ::pthread_rwlock_unlock (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_LOCK(x)   ::pthread_rwlock_wrlock (x)
+#define LOKI_THREADS_RWMUTEX_WRITE_UNLOCK(x) ::pthread_rwlock_unlock (x)
+#define LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(x)  (::pthread_rwlock_tryrdlock (x) == 0)
+#define LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(x) (::pthread_rwlock_trywrlock (x) == 0)
+
 #define LOKI_THREADS_ATOMIC(x)                                           \
                 pthread_mutex_lock(&atomic_mutex_);                      \
                 x;                                                       \
                 pthread_mutex_unlock(&atomic_mutex_)
 
+// Native atomic operations where the compiler provides them.  The
+// __atomic builtins (gcc 4.7 and later, clang) carry explicit memory
+// orders; the older __sync builtins (gcc 4.1 and later) are full
+// barriers throughout.  With neither available - or with
+// LOKI_THREADS_FORCE_MUTEX_ATOMICS defined - the atomics fall back to
+// the historic pthread_mutex_t emulation, and AtomicIncrement on a
+// refcount costs a mutex round trip instead of one instruction.
+//
+// Every backend offers the same names.  The plain functions are
+// sequentially consistent, as the mutex emulation effectively was.
+// The order-suffixed variants - Relaxed, Acquire, Release and AcqRel
+// on increment and decrement, Relaxed and Release on assign, Relaxed
+// and Acquire on load - relax the order where the backend can exploit
+// it: a statistics counter or refcount uptick needs no ordering at
+// all, the final decrement before destruction needs acquire-release,
+// and flag handshakes need only the acquire/release pair.  A backend
+// without a weaker primitive (the __sync builtins, the Interlocked
+// API, the mutex emulation) falls back to its full-barrier form, so
+// the names state intent and cost at most what the plain call costs.
+// Multiply and divide have no native equivalent and are implemented
+// as compare-and-swap loops.
+#if !defined(LOKI_THREADS_FORCE_MUTEX_ATOMICS) && defined(__ATOMIC_SEQ_CST)
+    #define LOKI_THREADS_GCC_ATOMIC_BUILTINS
+#elif !defined(LOKI_THREADS_FORCE_MUTEX_ATOMICS) && defined(__GNUC__) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+    #define LOKI_THREADS_GCC_SYNC_BUILTINS
+#else
+    #define LOKI_THREADS_MUTEX_ATOMICS
+#endif
+
+#if defined(LOKI_THREADS_GCC_ATOMIC_BUILTINS)
+
+#define LOKI_THREADS_ATOMIC_FUNCTIONS                                   \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            IntType expected = __atomic_load_n(&lval, __ATOMIC_RELAXED); \
+            while (!__atomic_compare_exchange_n(&lval, &expected,       \
+                IntType(expected * val), false,                         \
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))                    \
+            {}                                                          \
+            return IntType(expected * val);                             \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            IntType expected = __atomic_load_n(&lval, __ATOMIC_RELAXED); \
+            while (!__atomic_compare_exchange_n(&lval, &expected,       \
+                IntType(expected / val), false,                         \
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))                    \
+            {}                                                          \
+            return IntType(expected / val);                             \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval)          \
+        { return __atomic_add_fetch(&lval, 1, __ATOMIC_SEQ_CST); }      \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval)          \
+        { return __atomic_sub_fetch(&lval, 1, __ATOMIC_SEQ_CST); }      \
+                                                                        \
+        static void AtomicAssign(volatile IntType& lval, const IntType val) \
+        { __atomic_store_n(&lval, val, __ATOMIC_SEQ_CST); }             \
+                                                                        \
+        static void AtomicAssign(IntType& lval, volatile const IntType& val) \
+        { lval = __atomic_load_n(&val, __ATOMIC_SEQ_CST); }             \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = __atomic_add_fetch(&lval, 1, __ATOMIC_SEQ_CST); \
+            matches = ( compare == result );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = __atomic_sub_fetch(&lval, 1, __ATOMIC_SEQ_CST); \
+            matches = ( compare == result );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicMultiply(lval, val);           \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicDivide(lval, val);             \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrementRelaxed(volatile IntType& lval)   \
+        { return __atomic_add_fetch(&lval, 1, __ATOMIC_RELAXED); }      \
+                                                                        \
+        static IntType AtomicDecrementAcqRel(volatile IntType& lval)    \
+        { return __atomic_sub_fetch(&lval, 1, __ATOMIC_ACQ_REL); }      \
+                                                                        \
+        static void AtomicAssignRelease(volatile IntType& lval, const IntType val) \
+        { __atomic_store_n(&lval, val, __ATOMIC_RELEASE); }             \
+                                                                        \
+        static IntType AtomicLoadAcquire(volatile const IntType& lval)  \
+        { return __atomic_load_n(&lval, __ATOMIC_ACQUIRE); }            \
+                                                                        \
+        static IntType AtomicIncrementAcquire(volatile IntType& lval)   \
+        { return __atomic_add_fetch(&lval, 1, __ATOMIC_ACQUIRE); }      \
+                                                                        \
+        static IntType AtomicIncrementRelease(volatile IntType& lval)   \
+        { return __atomic_add_fetch(&lval, 1, __ATOMIC_RELEASE); }      \
+                                                                        \
+        static IntType AtomicIncrementAcqRel(volatile IntType& lval)    \
+        { return __atomic_add_fetch(&lval, 1, __ATOMIC_ACQ_REL); }      \
+                                                                        \
+        static IntType AtomicDecrementRelaxed(volatile IntType& lval)   \
+        { return __atomic_sub_fetch(&lval, 1, __ATOMIC_RELAXED); }      \
+                                                                        \
+        static IntType AtomicDecrementAcquire(volatile IntType& lval)   \
+        { return __atomic_sub_fetch(&lval, 1, __ATOMIC_ACQUIRE); }      \
+                                                                        \
+        static IntType AtomicDecrementRelease(volatile IntType& lval)   \
+        { return __atomic_sub_fetch(&lval, 1, __ATOMIC_RELEASE); }      \
+                                                                        \
+        static void AtomicAssignRelaxed(volatile IntType& lval, const IntType val) \
+        { __atomic_store_n(&lval, val, __ATOMIC_RELAXED); }             \
+                                                                        \
+        static IntType AtomicLoadRelaxed(volatile const IntType& lval)  \
+        { return __atomic_load_n(&lval, __ATOMIC_RELAXED); }            \
+                                                                        \
+        static bool AtomicCompareAndSwap(volatile IntType& lval, const IntType compare, const IntType val) \
+        {                                                               \
+            IntType expected = compare;                                 \
+            return __atomic_compare_exchange_n(&lval, &expected, val,   \
+                false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);             \
+        }
+
+// Pointer-sized load-acquire and store-release, used for publication
+// patterns such as the double-checked fast path in SingletonHolder.
+#define LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS                           \
+        template < class Ptr >                                          \
+        static Ptr AtomicLoadPtrAcquire(Ptr volatile & pval)            \
+        { return __atomic_load_n(&pval, __ATOMIC_ACQUIRE); }            \
+                                                                        \
+        template < class Ptr >                                          \
+        static void AtomicAssignPtrRelease(Ptr volatile & pval, Ptr val) \
+        { __atomic_store_n(&pval, val, __ATOMIC_RELEASE); }
+
+#elif defined(LOKI_THREADS_GCC_SYNC_BUILTINS)
+
+#define LOKI_THREADS_ATOMIC_FUNCTIONS                                   \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            IntType expected = lval;                                    \
+            for (;;)                                                    \
+            {                                                           \
+                const IntType desired = IntType(expected * val);        \
+                const IntType seen =                                    \
+                    __sync_val_compare_and_swap(&lval, expected, desired); \
+                if (seen == expected)                                   \
+                    return desired;                                     \
+                expected = seen;                                        \
+            }                                                           \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            IntType expected = lval;                                    \
+            for (;;)                                                    \
+            {                                                           \
+                const IntType desired = IntType(expected / val);        \
+                const IntType seen =                                    \
+                    __sync_val_compare_and_swap(&lval, expected, desired); \
+                if (seen == expected)                                   \
+                    return desired;                                     \
+                expected = seen;                                        \
+            }                                                           \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval)          \
+        { return __sync_add_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval)          \
+        { return __sync_sub_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static void AtomicAssign(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            __sync_synchronize();                                       \
+            __sync_lock_test_and_set(&lval, val);                       \
+        }                                                               \
+                                                                        \
+        static void AtomicAssign(IntType& lval, volatile const IntType& val) \
+        {                                                               \
+            lval = val;                                                 \
+            __sync_synchronize();                                       \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = __sync_add_and_fetch(&lval, 1);      \
+            matches = ( compare == result );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = __sync_sub_and_fetch(&lval, 1);      \
+            matches = ( compare == result );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicMultiply(lval, val);           \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicDivide(lval, val);             \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrementRelaxed(volatile IntType& lval)   \
+        { return __sync_add_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicDecrementAcqRel(volatile IntType& lval)    \
+        { return __sync_sub_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static void AtomicAssignRelease(volatile IntType& lval, const IntType val) \
+        { AtomicAssign(lval, val); }                                    \
+                                                                        \
+        static IntType AtomicLoadAcquire(volatile const IntType& lval)  \
+        {                                                               \
+            const IntType result = lval;                                \
+            __sync_synchronize();                                       \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrementAcquire(volatile IntType& lval)   \
+        { return __sync_add_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicIncrementRelease(volatile IntType& lval)   \
+        { return __sync_add_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicIncrementAcqRel(volatile IntType& lval)    \
+        { return __sync_add_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicDecrementRelaxed(volatile IntType& lval)   \
+        { return __sync_sub_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicDecrementAcquire(volatile IntType& lval)   \
+        { return __sync_sub_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static IntType AtomicDecrementRelease(volatile IntType& lval)   \
+        { return __sync_sub_and_fetch(&lval, 1); }                      \
+                                                                        \
+        static void AtomicAssignRelaxed(volatile IntType& lval, const IntType val) \
+        { __sync_lock_test_and_set(&lval, val); }                       \
+                                                                        \
+        static IntType AtomicLoadRelaxed(volatile const IntType& lval)  \
+        { return lval; }                                                \
+                                                                        \
+        static bool AtomicCompareAndSwap(volatile IntType& lval, const IntType compare, const IntType val) \
+        { return compare == __sync_val_compare_and_swap(&lval, compare, val); }
+
+// Pointer-sized load-acquire and store-release, used for publication
+// patterns such as the double-checked fast path in SingletonHolder.
+// A full barrier after the load (or before the store) of an aligned
+// pointer gives the named ordering on every target the __sync builtins
+// support.
+#define LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS                           \
+        template < class Ptr >                                          \
+        static Ptr AtomicLoadPtrAcquire(Ptr volatile & pval)            \
+        {                                                               \
+            const Ptr result = pval;                                    \
+            __sync_synchronize();                                       \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        template < class Ptr >                                          \
+        static void AtomicAssignPtrRelease(Ptr volatile & pval, Ptr val) \
+        {                                                               \
+            __sync_synchronize();                                       \
+            pval = val;                                                 \
+        }
+
+#else
+
 #define LOKI_THREADS_ATOMIC_FUNCTIONS                                \
     private:                                                         \
         static pthread_mutex_t atomic_mutex_;                        \
@@ -251,7 +693,6 @@
             ::pthread_mutex_lock( &atomic_mutex_ );                      \
             lval = val;                                                  \
             ::pthread_mutex_unlock( &atomic_mutex_ );                    \
-            return lval;                                                 \
         }                                                                \
                                                                          \
         static void AtomicAssign(IntType& lval, volatile const IntType& val) \
@@ -259,7 +700,6 @@
             ::pthread_mutex_lock( &atomic_mutex_ );                      \
             lval = val;                                                  \
             ::pthread_mutex_unlock( &atomic_mutex_ );                    \
-            return lval;                                                 \
         }                                                                \
                                                                          \
         static IntType AtomicIncrement(volatile IntType& lval, const IntType compare, bool & matches ) \
@@ -295,17 +735,101 @@
             matches = ( lval == compare );                              \
             ::pthread_mutex_unlock( &atomic_mutex_ );                   \
             return lval;                                                \
+        }                                                                \
+                                                                        \
+        static IntType AtomicIncrementRelaxed(volatile IntType& lval)   \
+        { return AtomicIncrement(lval); }                               \
+                                                                        \
+        static IntType AtomicDecrementAcqRel(volatile IntType& lval)    \
+        { return AtomicDecrement(lval); }                               \
+                                                                        \
+        static void AtomicAssignRelease(volatile IntType& lval, const IntType val) \
+        { AtomicAssign(lval, val); }                                    \
+                                                                        \
+        static IntType AtomicLoadAcquire(volatile const IntType& lval)  \
+        {                                                               \
+            ::pthread_mutex_lock( &atomic_mutex_ );                     \
+            const IntType result = lval;                                \
+            ::pthread_mutex_unlock( &atomic_mutex_ );                   \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrementAcquire(volatile IntType& lval)   \
+        { return AtomicIncrement(lval); }                               \
+                                                                        \
+        static IntType AtomicIncrementRelease(volatile IntType& lval)   \
+        { return AtomicIncrement(lval); }                               \
+                                                                        \
+        static IntType AtomicIncrementAcqRel(volatile IntType& lval)    \
+        { return AtomicIncrement(lval); }                               \
+                                                                        \
+        static IntType AtomicDecrementRelaxed(volatile IntType& lval)   \
+        { return AtomicDecrement(lval); }                               \
+                                                                        \
+        static IntType AtomicDecrementAcquire(volatile IntType& lval)   \
+        { return AtomicDecrement(lval); }                               \
+                                                                        \
+        static IntType AtomicDecrementRelease(volatile IntType& lval)   \
+        { return AtomicDecrement(lval); }                               \
+                                                                        \
+        static void AtomicAssignRelaxed(volatile IntType& lval, const IntType val) \
+        { AtomicAssign(lval, val); }                                    \
+                                                                        \
+        static IntType AtomicLoadRelaxed(volatile const IntType& lval)  \
+        { return AtomicLoadAcquire(lval); }                             \
+                                                                        \
+        static bool AtomicCompareAndSwap(volatile IntType& lval, const IntType compare, const IntType val) \
+        {                                                                \
+            ::pthread_mutex_lock( &atomic_mutex_ );                      \
+            const bool matches = ( lval == compare );                    \
+            if( matches )                                                \
+                lval = val;                                              \
+            ::pthread_mutex_unlock( &atomic_mutex_ );                    \
+            return matches;                                              \
+        }
+
+// Pointer-sized load-acquire and store-release, used for publication
+// patterns such as the double-checked fast path in SingletonHolder.
+// The mutex acquire and release provide the orderings the names promise.
+#define LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS                           \
+        template < class Ptr >                                          \
+        static Ptr AtomicLoadPtrAcquire(Ptr volatile & pval)            \
+        {                                                               \
+            ::pthread_mutex_lock( &atomic_mutex_ );                     \
+            const Ptr result = pval;                                    \
+            ::pthread_mutex_unlock( &atomic_mutex_ );                   \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        template < class Ptr >                                          \
+        static void AtomicAssignPtrRelease(Ptr volatile & pval, Ptr val) \
+        {                                                               \
+            ::pthread_mutex_lock( &atomic_mutex_ );                     \
+            pval = val;                                                 \
+            ::pthread_mutex_unlock( &atomic_mutex_ );                   \
         }
 
+#endif
+
 #else // single threaded
 
 #define LOKI_THREADS_MUTEX(x)
 #define LOKI_THREADS_MUTEX_INIT(x)
 #define LOKI_THREADS_MUTEX_DELETE(x)
 #define LOKI_THREADS_MUTEX_LOCK(x)
+#define LOKI_THREADS_MUTEX_TRYLOCK(x)   1
 #define LOKI_THREADS_MUTEX_UNLOCK(x)
 #define LOKI_THREADS_LONG
 #define LOKI_THREADS_MUTEX_CTOR(x)
+#define LOKI_THREADS_RWMUTEX(x)
+#define LOKI_THREADS_RWMUTEX_INIT(x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)
+#define LOKI_THREADS_RWMUTEX_READ_LOCK(x)
+#define LOKI_THREADS_RWMUTEX_READ_UNLOCK(x)
+#define LOKI_THREADS_RWMUTEX_WRITE_LOCK(x)
+#define LOKI_THREADS_RWMUTEX_WRITE_UNLOCK(x)
+#define LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(x)  1
+#define LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(x) 1
 
 #endif
 
@@ -340,6 +864,38 @@ namespace Loki
         {
             LOKI_THREADS_MUTEX_UNLOCK(&mtx_);
         }
+        /// Returns true when the lock was taken without blocking.
+        bool TryLock()
+        {
+            return 0 != LOKI_THREADS_MUTEX_TRYLOCK(&mtx_);
+        }
+        /// The shared interface of RWMutex, mapped onto the exclusive
+        /// lock: a Mutex can serve as the policy of the read/write
+        /// locking models, merely without reader concurrency.
+        void ReadLock()
+        {
+            Lock();
+        }
+        void ReadUnlock()
+        {
+            Unlock();
+        }
+        void WriteLock()
+        {
+            Lock();
+        }
+        void WriteUnlock()
+        {
+            Unlock();
+        }
+        bool TryReadLock()
+        {
+            return TryLock();
+        }
+        bool TryWriteLock()
+        {
+            return TryLock();
+        }
     private:
         /// Copy-constructor not implemented.
         Mutex(const Mutex &);
@@ -349,31 +905,191 @@ namespace Loki
     };
 
 
-     ////////////////////////////////////////////////////////////////////////////////
-    ///  \class SingleThreaded
-    ///
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class RWMutex
+    //
     ///  \ingroup ThreadingGroup
-    ///  Implementation of the ThreadingModel policy used by various classes
-    ///  Implements a single-threaded model; no synchronization
+    ///  A simple and portable reader/writer mutex.  The default policy class
+    ///  for the read/write locking models.  Lock/Unlock take the exclusive
+    ///  path, so a RWMutex can also stand in wherever a Mutex is expected.
     ////////////////////////////////////////////////////////////////////////////////
-    template <class Host, class MutexPolicy = LOKI_DEFAULT_MUTEX>
-    class SingleThreaded
+
+    class RWMutex
     {
     public:
-        /// \struct Lock
-        /// Dummy Lock class
-        struct Lock
+        RWMutex()
         {
-            Lock() {}
-            explicit Lock(const SingleThreaded&) {}
-            explicit Lock(const SingleThreaded*) {}
-        };
+            LOKI_THREADS_RWMUTEX_INIT(&mtx_);
+        }
+        ~RWMutex()
+        {
+            LOKI_THREADS_RWMUTEX_DELETE(&mtx_);
+        }
+        void ReadLock()
+        {
+            LOKI_THREADS_RWMUTEX_READ_LOCK(&mtx_);
+        }
+        void ReadUnlock()
+        {
+            LOKI_THREADS_RWMUTEX_READ_UNLOCK(&mtx_);
+        }
+        void WriteLock()
+        {
+            LOKI_THREADS_RWMUTEX_WRITE_LOCK(&mtx_);
+        }
+        void WriteUnlock()
+        {
+            LOKI_THREADS_RWMUTEX_WRITE_UNLOCK(&mtx_);
+        }
+        /// Returns true when the shared lock was taken without blocking.
+        bool TryReadLock()
+        {
+            return 0 != LOKI_THREADS_RWMUTEX_TRY_READ_LOCK(&mtx_);
+        }
+        /// Returns true when the exclusive lock was taken without blocking.
+        bool TryWriteLock()
+        {
+            return 0 != LOKI_THREADS_RWMUTEX_TRY_WRITE_LOCK(&mtx_);
+        }
+        void Lock()
+        {
+            WriteLock();
+        }
+        void Unlock()
+        {
+            WriteUnlock();
+        }
+        bool TryLock()
+        {
+            return TryWriteLock();
+        }
+    private:
+        /// Copy-constructor not implemented.
+        RWMutex(const RWMutex &);
+        /// Copy-assignement operator not implemented.
+        RWMutex & operator = (const RWMutex &);
+        LOKI_THREADS_RWMUTEX(mtx_)
+    };
 
-        typedef Host VolatileType;
 
-        typedef int IntType;
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class AdaptiveMutex
+    //
+    ///  \ingroup ThreadingGroup
+    ///  A mutex that spins before it sleeps.  For the sub-microsecond
+    ///  critical sections of SmallObjAllocator or Functor cloning, parking
+    ///  the thread in the kernel costs far more than the work the lock
+    ///  protects; this policy first polls the lock a bounded number of
+    ///  times with exponentially growing pauses, and only then falls back
+    ///  to the blocking platform lock.  Under no contention it is a single
+    ///  try-lock.  Select it per class through the MutexPolicy parameter,
+    ///  or globally by defining LOKI_DEFAULT_MUTEX to
+    ///  ::Loki::AdaptiveMutex before including any Loki header.
+    ////////////////////////////////////////////////////////////////////////////////
 
-        static IntType AtomicAdd(volatile IntType& lval, const IntType val)
+    class AdaptiveMutex
+    {
+    public:
+        AdaptiveMutex() LOKI_THREADS_MUTEX_CTOR(mtx_)
+        {
+            LOKI_THREADS_MUTEX_INIT(&mtx_);
+        }
+        ~AdaptiveMutex()
+        {
+            LOKI_THREADS_MUTEX_DELETE(&mtx_);
+        }
+        void Lock()
+        {
+            unsigned int delay = 1;
+            for (unsigned int spin = 0; spin < maxSpins; ++spin)
+            {
+                if (LOKI_THREADS_MUTEX_TRYLOCK(&mtx_))
+                    return;
+                for (volatile unsigned int pause = 0; pause < delay; ++pause)
+                {}
+                if (delay < maxDelay)
+                    delay *= 2;
+            }
+            LOKI_THREADS_MUTEX_LOCK(&mtx_);
+        }
+        void Unlock()
+        {
+            LOKI_THREADS_MUTEX_UNLOCK(&mtx_);
+        }
+        /// A single probe - no spinning; a caller asking not to block
+        /// would not want the backoff loop either.
+        bool TryLock()
+        {
+            return 0 != LOKI_THREADS_MUTEX_TRYLOCK(&mtx_);
+        }
+        /// The shared interface of RWMutex, mapped onto the exclusive
+        /// lock, so AdaptiveMutex too can serve the read/write models.
+        void ReadLock()
+        {
+            Lock();
+        }
+        void ReadUnlock()
+        {
+            Unlock();
+        }
+        void WriteLock()
+        {
+            Lock();
+        }
+        void WriteUnlock()
+        {
+            Unlock();
+        }
+        bool TryReadLock()
+        {
+            return TryLock();
+        }
+        bool TryWriteLock()
+        {
+            return TryLock();
+        }
+    private:
+        enum
+        {
+            /// Poll attempts before parking; past this point the owner is
+            /// evidently not on a short critical section
+            maxSpins = 16,
+            /// Cap on the backoff pause so the last polls stay responsive
+            maxDelay = 1024
+        };
+        /// Copy-constructor not implemented.
+        AdaptiveMutex(const AdaptiveMutex &);
+        /// Copy-assignement operator not implemented.
+        AdaptiveMutex & operator = (const AdaptiveMutex &);
+        LOKI_THREADS_MUTEX(mtx_)
+    };
+
+
+     ////////////////////////////////////////////////////////////////////////////////
+    ///  \class SingleThreaded
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  Implementation of the ThreadingModel policy used by various classes
+    ///  Implements a single-threaded model; no synchronization
+    ////////////////////////////////////////////////////////////////////////////////
+    template <class Host, class MutexPolicy = LOKI_DEFAULT_MUTEX>
+    class SingleThreaded
+    {
+    public:
+        /// \struct Lock
+        /// Dummy Lock class
+        struct Lock
+        {
+            Lock() {}
+            explicit Lock(const SingleThreaded&) {}
+            explicit Lock(const SingleThreaded*) {}
+        };
+
+        typedef Host VolatileType;
+
+        typedef int IntType;
+
+        static IntType AtomicAdd(volatile IntType& lval, const IntType val)
         { return lval += val; }
 
         static IntType AtomicSubtract(volatile IntType& lval, const IntType val)
@@ -439,6 +1155,58 @@ namespace Loki
             return lval;
         }
 
+        static IntType AtomicIncrementRelaxed(volatile IntType& lval)
+        { return ++lval; }
+
+        static IntType AtomicDecrementAcqRel(volatile IntType& lval)
+        { return --lval; }
+
+        static void AtomicAssignRelease(volatile IntType& lval, const IntType val)
+        { lval = val; }
+
+        static IntType AtomicLoadAcquire(volatile const IntType& lval)
+        { return lval; }
+
+        static IntType AtomicIncrementAcquire(volatile IntType& lval)
+        { return ++lval; }
+
+        static IntType AtomicIncrementRelease(volatile IntType& lval)
+        { return ++lval; }
+
+        static IntType AtomicIncrementAcqRel(volatile IntType& lval)
+        { return ++lval; }
+
+        static IntType AtomicDecrementRelaxed(volatile IntType& lval)
+        { return --lval; }
+
+        static IntType AtomicDecrementAcquire(volatile IntType& lval)
+        { return --lval; }
+
+        static IntType AtomicDecrementRelease(volatile IntType& lval)
+        { return --lval; }
+
+        static void AtomicAssignRelaxed(volatile IntType& lval, const IntType val)
+        { lval = val; }
+
+        static IntType AtomicLoadRelaxed(volatile const IntType& lval)
+        { return lval; }
+
+        static bool AtomicCompareAndSwap(volatile IntType& lval, const IntType compare, const IntType val)
+        {
+            if ( lval != compare )
+                return false;
+            lval = val;
+            return true;
+        }
+
+        template < class Ptr >
+        static Ptr AtomicLoadPtrAcquire(Ptr volatile & pval)
+        { return pval; }
+
+        template < class Ptr >
+        static void AtomicAssignPtrRelease(Ptr volatile & pval, Ptr val)
+        { pval = val; }
+
     };
 
 
@@ -504,13 +1272,107 @@ namespace Loki
 
         LOKI_THREADS_ATOMIC_FUNCTIONS
 
+        LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS
+
     };
 
-#ifdef LOKI_PTHREAD_H
+#if defined(LOKI_PTHREAD_H) && defined(LOKI_THREADS_MUTEX_ATOMICS)
     template <class Host, class MutexPolicy>
     pthread_mutex_t ObjectLevelLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class StripedLevelLockable
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  Implementation of the ThreadingModel policy used by various classes.
+    ///  Locks on object level like ObjectLevelLockable, but instead of
+    ///  embedding a mutex in every object it maps the object's address onto
+    ///  a fixed pool of LOKI_STRIPED_LOCK_COUNT mutexes shared by all hosts
+    ///  of the class.  An object therefore costs no lock memory at all,
+    ///  which matters when millions of small objects each need a lock that
+    ///  is idle nearly all the time.  The price is rare false contention:
+    ///  two objects whose addresses land on the same stripe serialize
+    ///  against each other.  For the same reason, holding locks on two
+    ///  objects at once can self-deadlock when both map onto one stripe and
+    ///  the mutex is not recursive - code that nests object locks should
+    ///  keep using ObjectLevelLockable.
+    ////////////////////////////////////////////////////////////////////////////////
+    template < class Host, class MutexPolicy = LOKI_DEFAULT_MUTEX >
+    class StripedLevelLockable
+    {
+        static MutexPolicy stripes_[ LOKI_STRIPED_LOCK_COUNT ];
+
+        static MutexPolicy& StripeFor(const void* host)
+        {
+            unsigned long bits = static_cast<unsigned long>(
+                reinterpret_cast<LOKI_THREADS_LONG>(host) );
+            // the low bits carry only alignment, so shift them out and
+            // fold higher bits down to spread neighbouring pages too
+            bits = ( bits >> 4 ) ^ ( bits >> 16 );
+            return stripes_[ bits & ( LOKI_STRIPED_LOCK_COUNT - 1 ) ];
+        }
+
+    public:
+        StripedLevelLockable() {}
+
+        StripedLevelLockable(const StripedLevelLockable&) {}
+
+        ~StripedLevelLockable() {}
+
+        class Lock;
+        friend class Lock;
+
+        ///  \struct Lock
+        ///  Lock class to lock on object level through the object's stripe
+        class Lock
+        {
+        public:
+
+            /// Lock object
+            explicit Lock(const StripedLevelLockable& host) : mtx_(StripeFor(&host))
+            {
+                mtx_.Lock();
+            }
+
+            /// Lock object
+            explicit Lock(const StripedLevelLockable* host) : mtx_(StripeFor(host))
+            {
+                mtx_.Lock();
+            }
+
+            /// Unlock object
+            ~Lock()
+            {
+                mtx_.Unlock();
+            }
+
+        private:
+            /// private by design of the object level threading
+            Lock();
+            Lock(const Lock&);
+            Lock& operator=(const Lock&);
+            MutexPolicy& mtx_;
+        };
+
+        typedef volatile Host VolatileType;
+
+        typedef LOKI_THREADS_LONG IntType;
+
+        LOKI_THREADS_ATOMIC_FUNCTIONS
+
+        LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS
+
+    };
+
+    template < class Host, class MutexPolicy >
+    MutexPolicy StripedLevelLockable< Host, MutexPolicy >::stripes_[ LOKI_STRIPED_LOCK_COUNT ];
+
+#if defined(LOKI_PTHREAD_H) && defined(LOKI_THREADS_MUTEX_ATOMICS)
+    template <class Host, class MutexPolicy>
+    pthread_mutex_t StripedLevelLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
     ////////////////////////////////////////////////////////////////////////////////
     ///  \class ClassLevelLockable
     ///
@@ -589,9 +1451,11 @@ namespace Loki
 
         LOKI_THREADS_ATOMIC_FUNCTIONS
 
+        LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS
+
     };
 
-#ifdef LOKI_PTHREAD_H
+#if defined(LOKI_PTHREAD_H) && defined(LOKI_THREADS_MUTEX_ATOMICS)
     template <class Host, class MutexPolicy>
     pthread_mutex_t ClassLevelLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 #endif
@@ -600,8 +1464,368 @@ namespace Loki
     typename ClassLevelLockable< Host, MutexPolicy >::Initializer
     ClassLevelLockable< Host, MutexPolicy >::initializer_;
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class ObjectLevelReadWriteLockable
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  Implementation of the ThreadingModel policy used by various classes
+    ///  Implements object-level locking with shared and exclusive guards:
+    ///  any number of ReadLock holders proceed together, a Lock (or its
+    ///  WriteLock alias) holder excludes everyone.  Lock is exclusive, so
+    ///  the model is a drop-in replacement for ObjectLevelLockable;
+    ///  read-mostly code takes ReadLock instead and stops serializing its
+    ///  readers.
+    ////////////////////////////////////////////////////////////////////////////////
+    template < class Host, class MutexPolicy = LOKI_DEFAULT_RWMUTEX >
+    class ObjectLevelReadWriteLockable
+    {
+        mutable MutexPolicy mtx_;
+
+    public:
+        ObjectLevelReadWriteLockable() : mtx_() {}
+
+        ObjectLevelReadWriteLockable(const ObjectLevelReadWriteLockable&) : mtx_() {}
+
+        ~ObjectLevelReadWriteLockable() {}
+
+        class Lock;
+        friend class Lock;
+        class ReadLock;
+        friend class ReadLock;
+
+        ///  \struct Lock
+        ///  Lock class to lock on object level, excluding readers and writers
+        class Lock
+        {
+        public:
+
+            /// Lock object exclusively
+            explicit Lock(const ObjectLevelReadWriteLockable& host) : host_(host)
+            {
+                host_.mtx_.WriteLock();
+            }
+
+            /// Lock object exclusively
+            explicit Lock(const ObjectLevelReadWriteLockable* host) : host_(*host)
+            {
+                host_.mtx_.WriteLock();
+            }
+
+            /// Unlock object
+            ~Lock()
+            {
+                host_.mtx_.WriteUnlock();
+            }
+
+        private:
+            /// private by design of the object level threading
+            Lock();
+            Lock(const Lock&);
+            Lock& operator=(const Lock&);
+            const ObjectLevelReadWriteLockable& host_;
+        };
+
+        ///  \struct ReadLock
+        ///  Lock class to share the object with other readers
+        class ReadLock
+        {
+        public:
+
+            /// Lock object for reading
+            explicit ReadLock(const ObjectLevelReadWriteLockable& host) : host_(host)
+            {
+                host_.mtx_.ReadLock();
+            }
+
+            /// Lock object for reading
+            explicit ReadLock(const ObjectLevelReadWriteLockable* host) : host_(*host)
+            {
+                host_.mtx_.ReadLock();
+            }
+
+            /// Unlock object
+            ~ReadLock()
+            {
+                host_.mtx_.ReadUnlock();
+            }
+
+        private:
+            /// private by design of the object level threading
+            ReadLock();
+            ReadLock(const ReadLock&);
+            ReadLock& operator=(const ReadLock&);
+            const ObjectLevelReadWriteLockable& host_;
+        };
+
+        /// The exclusive guard under its explicit name
+        typedef Lock WriteLock;
+
+        typedef volatile Host VolatileType;
+
+        typedef LOKI_THREADS_LONG IntType;
+
+        LOKI_THREADS_ATOMIC_FUNCTIONS
+
+        LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS
+
+    };
+
+#if defined(LOKI_PTHREAD_H) && defined(LOKI_THREADS_MUTEX_ATOMICS)
+    template <class Host, class MutexPolicy>
+    pthread_mutex_t ObjectLevelReadWriteLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class ClassLevelReadWriteLockable
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  Implementation of the ThreadingModel policy used by various classes
+    ///  Implements class-level locking with shared and exclusive guards.
+    ///  Lock is exclusive, making the model a drop-in replacement for
+    ///  ClassLevelLockable; read-mostly code - registry singletons, factory
+    ///  lookups - takes ReadLock and lets its readers run concurrently.
+    ////////////////////////////////////////////////////////////////////////////////
+    template <class Host, class MutexPolicy = LOKI_DEFAULT_RWMUTEX >
+    class ClassLevelReadWriteLockable
+    {
+        struct Initializer
+        {
+            bool init_;
+            MutexPolicy mtx_;
+
+            Initializer() : init_(false), mtx_()
+            {
+                init_ = true;
+            }
+
+            ~Initializer()
+            {
+                assert(init_);
+            }
+        };
+
+        static Initializer initializer_;
+
+    public:
+
+        class Lock;
+        friend class Lock;
+        class ReadLock;
+        friend class ReadLock;
+
+        ///  \struct Lock
+        ///  Lock class to lock on class level, excluding readers and writers
+        class Lock
+        {
+        public:
+
+            /// Lock class exclusively
+            Lock()
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.WriteLock();
+            }
+
+            /// Lock class exclusively
+            explicit Lock(const ClassLevelReadWriteLockable&)
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.WriteLock();
+            }
+
+            /// Lock class exclusively
+            explicit Lock(const ClassLevelReadWriteLockable*)
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.WriteLock();
+            }
+
+            /// Unlock class
+            ~Lock()
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.WriteUnlock();
+            }
+
+        private:
+            Lock(const Lock&);
+            Lock& operator=(const Lock&);
+        };
+
+        ///  \struct ReadLock
+        ///  Lock class to share the class with other readers
+        class ReadLock
+        {
+        public:
+
+            /// Lock class for reading
+            ReadLock()
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.ReadLock();
+            }
+
+            /// Lock class for reading
+            explicit ReadLock(const ClassLevelReadWriteLockable&)
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.ReadLock();
+            }
+
+            /// Lock class for reading
+            explicit ReadLock(const ClassLevelReadWriteLockable*)
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.ReadLock();
+            }
+
+            /// Unlock class
+            ~ReadLock()
+            {
+                assert(initializer_.init_);
+                initializer_.mtx_.ReadUnlock();
+            }
+
+        private:
+            ReadLock(const ReadLock&);
+            ReadLock& operator=(const ReadLock&);
+        };
+
+        /// The exclusive guard under its explicit name
+        typedef Lock WriteLock;
+
+        typedef volatile Host VolatileType;
+
+        typedef LOKI_THREADS_LONG IntType;
+
+        LOKI_THREADS_ATOMIC_FUNCTIONS
+
+        LOKI_THREADS_ATOMIC_POINTER_FUNCTIONS
+
+    };
+
+#if defined(LOKI_PTHREAD_H) && defined(LOKI_THREADS_MUTEX_ATOMICS)
+    template <class Host, class MutexPolicy>
+    pthread_mutex_t ClassLevelReadWriteLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+    template < class Host, class MutexPolicy >
+    typename ClassLevelReadWriteLockable< Host, MutexPolicy >::Initializer
+    ClassLevelReadWriteLockable< Host, MutexPolicy >::initializer_;
+
 #endif // #if defined(LOKI_WINDOWS_H) || defined(LOKI_PTHREAD_H)
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class DistributedCounter
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  A shared event counter cheap enough to bump on nanosecond-scale hot
+    ///  paths.  A single shared counter makes every incrementing thread write
+    ///  the same cache line, so the line ping-pongs between cores and the
+    ///  "free" statistic dominates the operation it measures.  This class
+    ///  spreads the count over LOKI_DISTRIBUTED_COUNTER_SLOTS slots, each
+    ///  padded to a cache line of its own; a thread is assigned a slot the
+    ///  first time it increments any DistributedCounter and keeps it for
+    ///  life, so as long as threads do not outnumber slots no two threads
+    ///  share a line.  Increments are relaxed atomic operations - one
+    ///  uninstrumented add on the thread's own line, and no count is ever
+    ///  lost even when threads do share a slot.
+    ///
+    ///  Read() sums the slots without stopping writers, so it returns a
+    ///  value that was exact at some instant during the call - the right
+    ///  semantics for statistics, not for synchronization.  Decrement is
+    ///  provided for gauge-style counts (objects outstanding); slots can
+    ///  go individually negative as long as the sum stays meaningful.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class DistributedCounter
+    {
+        typedef LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL< DistributedCounter > Atomics;
+
+    public:
+
+        typedef Atomics::IntType CountType;
+
+        DistributedCounter()
+        {
+            for ( unsigned int i = 0; i < LOKI_DISTRIBUTED_COUNTER_SLOTS; ++i )
+                slots_[ i ].count = 0;
+        }
+
+        ///  Adds one to this thread's slot.  Relaxed: orders nothing.
+        void Increment()
+        {
+            Atomics::AtomicIncrementRelaxed( ThisThreadsSlot().count );
+        }
+
+        ///  Subtracts one from this thread's slot.  The thread releasing a
+        ///  resource may decrement a different slot than the thread which
+        ///  acquired it incremented; the sum still balances.
+        void Decrement()
+        {
+            Atomics::AtomicDecrementRelaxed( ThisThreadsSlot().count );
+        }
+
+        ///  Sums the slots.  Exact at some instant during the call while
+        ///  writers keep running; use only for reporting, never to decide
+        ///  whether a resource is free.
+        CountType Read() const
+        {
+            CountType total = 0;
+            for ( unsigned int i = 0; i < LOKI_DISTRIBUTED_COUNTER_SLOTS; ++i )
+                total += Atomics::AtomicLoadRelaxed( slots_[ i ].count );
+            return total;
+        }
+
+        ///  Zeroes every slot.  Increments running concurrently with the
+        ///  reset may land on either side of it; reset only quiescent
+        ///  counters if that matters.
+        void Reset()
+        {
+            for ( unsigned int i = 0; i < LOKI_DISTRIBUTED_COUNTER_SLOTS; ++i )
+                Atomics::AtomicAssignRelaxed( slots_[ i ].count, 0 );
+        }
+
+    private:
+
+        ///  Copy constructor is not implemented.
+        DistributedCounter( const DistributedCounter & );
+        ///  Copy-assignment operator is not implemented.
+        DistributedCounter & operator = ( const DistributedCounter & );
+
+        ///  One counter slot, alone on its cache line so threads on
+        ///  different slots never invalidate each other.
+        struct Slot
+        {
+            volatile CountType count;
+            char padding[ 64 - sizeof( CountType ) ];
+        };
+
+        ///  Index of the calling thread's slot, assigned round-robin on the
+        ///  thread's first use of any DistributedCounter.  One index serves
+        ///  every counter, so a thread stays on its own line in all of them.
+        static unsigned int ThisThreadsIndex( void )
+        {
+            static LOKI_THREAD_LOCAL unsigned int index = 0;
+            if ( 0 == index )
+            {
+                static volatile CountType nextThread = 0;
+                const CountType thread = Atomics::AtomicIncrement( nextThread );
+                index = 1 + static_cast< unsigned int >( thread )
+                    % LOKI_DISTRIBUTED_COUNTER_SLOTS;
+            }
+            return index - 1;
+        }
+
+        Slot & ThisThreadsSlot( void )
+        {
+            return slots_[ ThisThreadsIndex() ];
+        }
+
+        Slot slots_[ LOKI_DISTRIBUTED_COUNTER_SLOTS ];
+
+    };
+
 } // namespace Loki
 
 
@@ -31,6 +31,38 @@
 #pragma warning( disable : 4180 ) //qualifier applied to function type has no meaning; ignored
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// Compiler-intrinsic backend
+//
+// The function-pointer and member-function-pointer helpers below otherwise
+// need a partial specialization per arity and cv-qualification - some 160
+// class templates parsed in every translation unit including this header,
+// plus one scan per TypeTraits instantiation.  Compilers which answer these
+// queries directly are asked instead.  Each intrinsic is tested for
+// individually, so partial support degrades helper by helper to the portable
+// specialization scan; the integral/float classification keeps the typelist
+// implementation everywhere, because Loki deliberately sorts bool, char and
+// wchar_t apart from the signed/unsigned lists while the corresponding
+// intrinsics follow the platform's signedness.  Define
+// LOKI_TYPETRAITS_NO_INTRINSICS to force the portable implementation
+// throughout.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LOKI_TYPETRAITS_NO_INTRINSICS
+    #if defined(__has_builtin)
+        #if __has_builtin(__is_function)
+            #define LOKI_TYPETRAITS_IS_FUNCTION(T) __is_function(T)
+        #endif
+        #if __has_builtin(__is_member_function_pointer)
+            #define LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER(T) \
+                __is_member_function_pointer(T)
+        #endif
+    #elif defined(_MSC_VER) && (_MSC_VER >= 1500)
+        #define LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER(T) \
+            __is_member_function_pointer(T)
+    #endif
+#endif
+
 namespace Loki
 {
 ////////////////////////////////////////////////////////////////////////////////
@@ -152,6 +184,18 @@ namespace Loki
             typedef NullType Result;
         };
     
+#ifdef LOKI_TYPETRAITS_IS_FUNCTION
+
+        template <typename T>
+        struct IsFunctionPointerRaw
+        {enum{result = 0};};
+
+        template <typename T>
+        struct IsFunctionPointerRaw<T*>
+        {enum{result = LOKI_TYPETRAITS_IS_FUNCTION(T)};};
+
+#else // LOKI_TYPETRAITS_IS_FUNCTION
+
         template <typename T>
         struct IsFunctionPointerRaw
         {enum{result = 0};};
@@ -527,8 +571,17 @@ namespace Loki
             P16, P17, P18, P19, P20,
             ...)> 
         {enum {result = 1};};
+
+#endif // LOKI_TYPETRAITS_IS_FUNCTION
         
-        
+#ifdef LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER
+
+        template <typename T>
+        struct IsMemberFunctionPointerRaw
+        {enum{result = LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER(T)};};
+
+#else // LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER
+
         template <typename T>
         struct IsMemberFunctionPointerRaw
         {enum{result = 0};};
@@ -2026,6 +2079,8 @@ namespace Loki
             P16, P17, P18, P19, P20,
             ...) const volatile> 
         {enum {result = 1};};
+
+#endif // LOKI_TYPETRAITS_IS_MEMBER_FUNCTION_POINTER
                
       }// namespace Private
         
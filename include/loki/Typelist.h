@@ -87,6 +87,114 @@ namespace Loki
             typedef NullType Result;
         };
 
+////////////////////////////////////////////////////////////////////////////////
+// class template Private::SameType
+// Local type-equality test used by the unrolled algorithms below;
+// TypeTraits.h offers the same thing but includes this header
+////////////////////////////////////////////////////////////////////////////////
+
+        namespace Private
+        {
+            template <class T, class U>
+            struct SameType
+            {
+                enum { value = false };
+            };
+
+            template <class T>
+            struct SameType<T, T>
+            {
+                enum { value = true };
+            };
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+// class template Drop
+// Skips the first 'index' types of a typelist
+// Invocation (TList is a typelist and index is a compile-time integral
+//     constant):
+// Drop<TList, index>::Result
+// returns the typelist starting at position 'index' in TList (the whole
+//     list for 0, NullType for index == length)
+// Dropping past the end of the list is a compile-time error
+// The recursion halves the index, so the instantiation depth is
+// logarithmic in 'index' - this is the workhorse that keeps TypeAt and
+// friends inside the compiler's template depth limit on huge typelists
+////////////////////////////////////////////////////////////////////////////////
+
+        template <class TList, unsigned int index> struct Drop;
+
+        template <class TList> struct Drop<TList, 0>
+        {
+            typedef TList Result;
+        };
+
+        // resolves the ambiguity between <TList, 0> and <Typelist, index>
+        template <class Head, class Tail>
+        struct Drop<Typelist<Head, Tail>, 0>
+        {
+            typedef Typelist<Head, Tail> Result;
+        };
+
+        template <class Head, class Tail>
+        struct Drop<Typelist<Head, Tail>, 1>
+        {
+            typedef Tail Result;
+        };
+
+        template <class Head, class Tail, unsigned int i>
+        struct Drop<Typelist<Head, Tail>, i>
+        {
+            typedef typename Drop<
+                typename Drop<Typelist<Head, Tail>, i / 2>::Result,
+                i - i / 2>::Result Result;
+        };
+
+////////////////////////////////////////////////////////////////////////////////
+// class template DropNonStrict
+// Like Drop, but dropping past the end of the list yields NullType
+// instead of a compile-time error
+////////////////////////////////////////////////////////////////////////////////
+
+        template <class TList, unsigned int index> struct DropNonStrict;
+
+        template <class TList> struct DropNonStrict<TList, 0>
+        {
+            typedef TList Result;
+        };
+
+        template <unsigned int i>
+        struct DropNonStrict<NullType, i>
+        {
+            typedef NullType Result;
+        };
+
+        template <>
+        struct DropNonStrict<NullType, 0>
+        {
+            typedef NullType Result;
+        };
+
+        template <class Head, class Tail>
+        struct DropNonStrict<Typelist<Head, Tail>, 0>
+        {
+            typedef Typelist<Head, Tail> Result;
+        };
+
+        template <class Head, class Tail>
+        struct DropNonStrict<Typelist<Head, Tail>, 1>
+        {
+            typedef Tail Result;
+        };
+
+        template <class Head, class Tail, unsigned int i>
+        struct DropNonStrict<Typelist<Head, Tail>, i>
+        {
+            typedef typename DropNonStrict<
+                typename DropNonStrict<Typelist<Head, Tail>, i / 2>::Result,
+                i - i / 2>::Result Result;
+        };
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template Length
 // Computes the length of a typelist
@@ -108,6 +216,17 @@ namespace Loki
             enum { value = 1 + Length<U>::value };
         };
 
+        // eight types per recursion level, so a 400-type list stays far
+        // below the compiler's instantiation depth limit
+        template <class T1, class T2, class T3, class T4,
+                  class T5, class T6, class T7, class T8, class Rest>
+        struct Length< Typelist<T1, Typelist<T2, Typelist<T3, Typelist<T4,
+            Typelist<T5, Typelist<T6, Typelist<T7, Typelist<T8,
+            Rest> > > > > > > > >
+        {
+            enum { value = 8 + Length<Rest>::value };
+        };
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template TypeAt
 // Finds the type at a given index in a typelist
@@ -129,7 +248,8 @@ namespace Loki
         template <class Head, class Tail, unsigned int i>
         struct TypeAt<Typelist<Head, Tail>, i>
         {
-            typedef typename TypeAt<Tail, i - 1>::Result Result;
+            typedef typename
+                Drop<Typelist<Head, Tail>, i>::Result::Head Result;
         };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -160,8 +280,24 @@ namespace Loki
         template <class Head, class Tail, unsigned int i, typename DefaultType>
         struct TypeAtNonStrict<Typelist<Head, Tail>, i, DefaultType>
         {
-            typedef typename 
-                TypeAtNonStrict<Tail, i - 1, DefaultType>::Result Result;
+        private:
+            template <class TList, class D> struct HeadOrDefault
+            {
+                typedef D Result;
+            };
+
+            template <class H, class T, class D>
+            struct HeadOrDefault<Typelist<H, T>, D>
+            {
+                typedef H Result;
+            };
+
+            typedef typename
+                DropNonStrict<Typelist<Head, Tail>, i>::Result Suffix;
+
+        public:
+            typedef typename
+                HeadOrDefault<Suffix, DefaultType>::Result Result;
         };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,19 +316,38 @@ namespace Loki
             enum { value = -1 };
         };
         
-        template <class T, class Tail>
-        struct IndexOf<Typelist<T, Tail>, T>
-        {
-            enum { value = 0 };
-        };
-        
         template <class Head, class Tail, class T>
         struct IndexOf<Typelist<Head, Tail>, T>
         {
         private:
             enum { temp = IndexOf<Tail, T>::value };
         public:
-            enum { value = (temp == -1 ? -1 : 1 + temp) };
+            enum { value = Private::SameType<Head, T>::value ? 0 :
+                       (temp == -1 ? -1 : 1 + temp) };
+        };
+
+        // eight types per recursion level; the head comparisons moved
+        // into the value computation so this stays unambiguous with the
+        // one-type specialization above
+        template <class T1, class T2, class T3, class T4,
+                  class T5, class T6, class T7, class T8, class Rest,
+                  class T>
+        struct IndexOf<Typelist<T1, Typelist<T2, Typelist<T3, Typelist<T4,
+            Typelist<T5, Typelist<T6, Typelist<T7, Typelist<T8,
+            Rest> > > > > > > >, T>
+        {
+        private:
+            enum { temp = IndexOf<Rest, T>::value };
+        public:
+            enum { value = Private::SameType<T1, T>::value ? 0 :
+                           Private::SameType<T2, T>::value ? 1 :
+                           Private::SameType<T3, T>::value ? 2 :
+                           Private::SameType<T4, T>::value ? 3 :
+                           Private::SameType<T5, T>::value ? 4 :
+                           Private::SameType<T6, T>::value ? 5 :
+                           Private::SameType<T7, T>::value ? 6 :
+                           Private::SameType<T8, T>::value ? 7 :
+                       (temp == -1 ? -1 : 8 + temp) };
         };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -228,6 +383,20 @@ namespace Loki
                     typename Append<Tail, T>::Result>
                 Result;
         };
+
+        // eight types per recursion level, like Length and IndexOf
+        template <class T1, class T2, class T3, class T4,
+                  class T5, class T6, class T7, class T8, class Rest,
+                  class T>
+        struct Append<Typelist<T1, Typelist<T2, Typelist<T3, Typelist<T4,
+            Typelist<T5, Typelist<T6, Typelist<T7, Typelist<T8,
+            Rest> > > > > > > >, T>
+        {
+            typedef Typelist<T1, Typelist<T2, Typelist<T3, Typelist<T4,
+                Typelist<T5, Typelist<T6, Typelist<T7, Typelist<T8,
+                typename Append<Rest, T>::Result> > > > > > > >
+                Result;
+        };
         
 ////////////////////////////////////////////////////////////////////////////////
 // class template Erase
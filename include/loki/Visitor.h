@@ -23,8 +23,28 @@
 #include "Typelist.h"
 #include "HierarchyGenerators.h"
 
+#include <cstddef>
+#include <typeinfo>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 namespace Loki
 {
+    namespace Private
+    {
+        // Orders VisitGrouped's tagged elements by type tag alone, so
+        // elements of one type keep their original relative order.
+        struct TypeTagLess
+        {
+            template <class Pair>
+            bool operator()(const Pair& lhs, const Pair& rhs) const
+            {
+                return lhs.first < rhs.first;
+            }
+        };
+    }
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \class BaseVisitor
@@ -39,6 +59,79 @@ namespace Loki
         virtual ~BaseVisitor() {}
     };
     
+////////////////////////////////////////////////////////////////////////////////
+// class template Private::VisitorCastCache
+// Memoizes dynamic_cast<VisitorType*> per dynamic visitor type for the
+// cached Accept variant below.  The result of the cross-cast is a fixed
+// offset from the most-derived object for every visitor of one dynamic
+// type, so the cache keys a small direct-mapped table on the type_info
+// address and replays the offset on a hit; the most-derived address
+// itself comes from dynamic_cast<void*>, which compilers resolve with a
+// single vtable read instead of a hierarchy walk.  A different type_info
+// object for the same type (shared-library aliasing) or a slot collision
+// just repeats the full dynamic_cast - never a wrong result.
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        template <class VisitorType>
+        class VisitorCastCache
+        {
+            struct Slot
+            {
+                const std::type_info* type;
+                std::ptrdiff_t offset;
+                bool failed;
+            };
+
+            enum { tableSize = 16 }; // power of two, visitor types are few
+
+            Slot slots_[tableSize];
+
+            static std::size_t Hash(const std::type_info* type)
+            {
+                // low bits of the address are alignment padding
+                return (reinterpret_cast<std::size_t>(type) >> 4)
+                     & (tableSize - 1);
+            }
+
+        public:
+            VisitorCastCache()
+            {
+                for (unsigned int i = 0; i < tableSize; ++i)
+                {
+                    slots_[i].type = 0;
+                    slots_[i].offset = 0;
+                    slots_[i].failed = false;
+                }
+            }
+
+            VisitorType* Get(BaseVisitor& guest)
+            {
+                const std::type_info* const type = &typeid(guest);
+                Slot& slot = slots_[Hash(type)];
+                if (slot.type == type)
+                {
+                    if (slot.failed)
+                        return 0;
+                    return reinterpret_cast<VisitorType*>(
+                        static_cast<char*>(dynamic_cast<void*>(&guest))
+                        + slot.offset);
+                }
+                VisitorType* const p = dynamic_cast<VisitorType*>(&guest);
+                slot.offset = 0;
+                slot.failed = (0 == p);
+                if (p)
+                {
+                    slot.offset = reinterpret_cast<char*>(p)
+                        - static_cast<char*>(dynamic_cast<void*>(&guest));
+                }
+                slot.type = type;
+                return p;
+            }
+        };
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class Visitor
 ///
@@ -268,6 +361,19 @@ struct DefaultCatchAll
             }
             return CatchAll<R, T>::OnUnknownVisitor(visited, guest);
         }
+
+        template <class T>
+        static ReturnType AcceptCachedImpl(T& visited, BaseVisitor& guest)
+        {
+            // Apply the Acyclic Visitor, memoizing the cross-cast per
+            // dynamic visitor type
+            static Private::VisitorCastCache<Visitor<T,R> > cache;
+            if (Visitor<T,R>* p = cache.Get(guest))
+            {
+                return p->Visit(visited);
+            }
+            return CatchAll<R, T>::OnUnknownVisitor(visited, guest);
+        }
     };
 
     template<typename R,template <typename, class> class CatchAll>
@@ -289,6 +395,19 @@ struct DefaultCatchAll
             }
             return CatchAll<R, T>::OnUnknownVisitor(const_cast<T&>(visited), guest);
         }
+
+        template <class T>
+        static ReturnType AcceptCachedImpl(const T& visited, BaseVisitor& guest)
+        {
+            // Apply the Acyclic Visitor, memoizing the cross-cast per
+            // dynamic visitor type
+            static Private::VisitorCastCache<Visitor<T,R,true> > cache;
+            if (Visitor<T,R,true>* p = cache.Get(guest))
+            {
+                return p->Visit(visited);
+            }
+            return CatchAll<R, T>::OnUnknownVisitor(const_cast<T&>(visited), guest);
+        }
     };
 
 
@@ -314,6 +433,79 @@ struct DefaultCatchAll
     virtual ReturnType Accept(::Loki::BaseVisitor& guest) const \
     { return AcceptImpl(*this, guest); }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \def LOKI_DEFINE_CACHED_VISITABLE()
+/// \ingroup VisitorGroup
+/// Like LOKI_DEFINE_VISITABLE, but Accept memoizes the visitor cross-cast
+/// per dynamic visitor type, so visiting many elements with few visitor
+/// types costs a table probe instead of a dynamic_cast per element.
+/// The cache is written without locking: use LOKI_DEFINE_VISITABLE instead
+/// where concurrent threads Accept into the same visited class.
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOKI_DEFINE_CACHED_VISITABLE() \
+    virtual ReturnType Accept(::Loki::BaseVisitor& guest) \
+    { return AcceptCachedImpl(*this, guest); }
+
+////////////////////////////////////////////////////////////////////////////////
+/// \def LOKI_DEFINE_CONST_CACHED_VISITABLE()
+/// \ingroup VisitorGroup
+/// Const-visit counterpart of LOKI_DEFINE_CACHED_VISITABLE; same caching,
+/// same caveat about concurrent visits.
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOKI_DEFINE_CONST_CACHED_VISITABLE() \
+    virtual ReturnType Accept(::Loki::BaseVisitor& guest) const \
+    { return AcceptCachedImpl(*this, guest); }
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn VisitGrouped
+/// \ingroup VisitorGroup
+/// Accepts the visitor over a range of visitable pointers in
+/// type-grouped order instead of container order.  A heterogeneous
+/// container visited element by element alternates between unrelated
+/// Accept and Visit targets, so the branch predictor relearns the
+/// dispatch on nearly every element.  This helper first tags each
+/// element with its concrete type_info, sorts the tags so elements of
+/// one dynamic type become one contiguous run, and then Accepts each
+/// run in a tight loop: every virtual call in a run lands on the same
+/// target, and with LOKI_DEFINE_CACHED_VISITABLE the visitor cross-cast
+/// resolves once per run and hits its cache for the rest.
+///
+/// The iterators must dereference to non-null pointers (smart or raw)
+/// to visitables; within one type the elements keep their original
+/// relative order, and return values of Accept are discarded.  The
+/// grouping buffer is scratch space of one pointer pair per element,
+/// so for scenes visited repeatedly it is cheaper to keep the
+/// container itself sorted by type and skip the helper.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class InputIterator>
+    void VisitGrouped(InputIterator first, InputIterator last,
+        BaseVisitor& guest)
+    {
+        typedef typename std::iterator_traits<InputIterator>::value_type
+            PointerType;
+        typedef std::pair<const std::type_info*, PointerType> TaggedElement;
+
+        std::vector<TaggedElement> grouped;
+        grouped.reserve(static_cast<std::size_t>(
+            std::distance(first, last)));
+        for (; first != last; ++first)
+            grouped.push_back(TaggedElement(&typeid(**first), *first));
+
+        // ordered by type_info address - any consistent order groups;
+        // comparing only the tag keeps the sort stable within one type
+        std::stable_sort(grouped.begin(), grouped.end(),
+            Private::TypeTagLess());
+
+        for (typename std::vector<TaggedElement>::iterator i =
+                grouped.begin(); i != grouped.end(); ++i)
+        {
+            (*i->second).Accept(guest);
+        }
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class CyclicVisitor
 ///
@@ -347,6 +539,97 @@ struct DefaultCatchAll
     virtual SomeVisitor::ReturnType Accept(SomeVisitor& guest) \
     { return guest.GenericVisit(*this); }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \class IndexedCyclicVisitor
+///
+/// \ingroup VisitorGroup
+/// Variant of CyclicVisitor that dispatches through a flat table of
+/// trampoline functions indexed by a dense class id, instead of the
+/// Accept/Visit pair of virtual calls.  The visited base class must expose
+/// the same hook MatrixDispatcher uses,
+/// \code
+///     virtual unsigned int GetImplId() const;
+/// \endcode
+/// overridden in every class of TList to return that class's zero-based
+/// typelist position (TL::IndexOf<TList, MyClass>::value).  A concrete
+/// visitor derives with CRTP,
+/// \code
+/// class Renderer : public IndexedCyclicVisitor<void, Shapes, Shape, Renderer>
+/// {
+/// public:
+///     void Visit(Rect&);
+///     void Visit(Ellipse&);
+/// };
+/// \endcode
+/// and its plain, non-virtual Visit overloads are called directly from the
+/// trampolines, so the compiler can inline small visit bodies.  Iteration
+/// then calls visitor.Dispatch(element) - one virtual GetImplId call, one
+/// indexed call, no Accept needed.  Trampolines downcast with static_cast,
+/// so the classes must derive from Base non-virtually.  An id outside the
+/// table routes to OnUnknown, which returns ReturnType() unless the
+/// concrete visitor shadows it.  The table is built per concrete visitor
+/// on first use; the fill is idempotent, so racing first calls are
+/// harmless.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <typename R, class TList, class Base, class ConcreteVisitor>
+    class IndexedCyclicVisitor
+    {
+        typedef R (*Trampoline)(ConcreteVisitor&, Base&);
+
+        enum { typeCount = TL::Length<TList>::value };
+
+        template <class Visited>
+        static R Trampo(ConcreteVisitor& visitor, Base& host)
+        {
+            return visitor.Visit(static_cast<Visited&>(host));
+        }
+
+        struct Table
+        {
+            Trampoline entries[typeCount];
+
+            Table()
+            {
+                Fill(TList());
+            }
+
+            void Fill(NullType)
+            {}
+
+            template <class Head, class Tail>
+            void Fill(Typelist<Head, Tail>)
+            {
+                entries[TL::IndexOf<TList, Head>::value] =
+                    &IndexedCyclicVisitor::template Trampo<Head>;
+                Fill(Tail());
+            }
+        };
+
+        static const Table& GetTable()
+        {
+            static const Table table;
+            return table;
+        }
+
+    public:
+        typedef R ReturnType;
+
+        ReturnType Dispatch(Base& host)
+        {
+            const unsigned int id = host.GetImplId();
+            ConcreteVisitor& self = static_cast<ConcreteVisitor&>(*this);
+            if (id >= unsigned(typeCount))
+                return self.OnUnknown(host);
+            return GetTable().entries[id](self, host);
+        }
+
+        ReturnType OnUnknown(Base&)
+        {
+            return ReturnType();
+        }
+    };
+
 } // namespace Loki
 
 
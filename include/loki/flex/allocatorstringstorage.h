@@ -68,13 +68,23 @@ class StoragePolicy
 #include "flex_string_details.h"
 #include "simplestringstorage.h"
 
+// Primary declared in flex_string_shell.h; specialized below.
+template <class Storage> struct StorageHasReserveExact;
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template AllocatorStringStorage
 // Allocates with your allocator
 // Takes advantage of the Empty Base Optimization if available
+// GrowthPercent controls how append grows a full buffer: 0 (the default)
+//     reserves exactly what is needed, the historical behavior; a value
+//     above 100 grows to at least capacity() * GrowthPercent / 100, so
+//     e.g. 150 trades at most a third of slack for amortized appends.
+//     ReserveExact sizes the buffer to exactly the requested capacity
+//     (never below size()), shrinking included, for strings that are
+//     done growing.
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename E, class A = std::allocator<E> >
+template <typename E, class A = std::allocator<E>, unsigned int GrowthPercent = 0>
 class AllocatorStringStorage : public A
 {
     typedef typename A::size_type size_type;
@@ -118,6 +128,17 @@ class AllocatorStringStorage : public A
             pData_->pEndOfMem_ = pData_->buffer_ + cap;
         }
     }
+
+    // What append asks for when the buffer is full: at least the need,
+    // amplified by GrowthPercent when one is configured.  The division
+    // comes first so huge capacities cannot overflow the product.
+    size_type GrownCapacity(size_type needed) const
+    {
+        if (GrowthPercent <= 100) return needed;
+        const size_type grown = capacity()
+            + capacity() / 100 * (GrowthPercent - 100);
+        return grown > needed ? grown : needed;
+    }
     
 public:
     typedef E value_type;
@@ -234,6 +255,22 @@ public:
         swap(newStr);
     }
 
+    // Sizes the buffer to exactly res_arg characters (never below the
+    // current size), shrinking included.
+    void ReserveExact(size_type res_arg)
+    {
+        if (res_arg < size()) res_arg = size();
+        if (res_arg == capacity()) return;
+
+        A& myAlloc = *this;
+        AllocatorStringStorage newStr(myAlloc);
+        newStr.Init(size(), res_arg);
+
+        flex_string_details::pod_copy(begin(), end(), newStr.begin());
+
+        swap(newStr);
+    }
+
     template <class ForwardIterator>
     void append(ForwardIterator b, ForwardIterator e)
     {
@@ -246,7 +283,7 @@ public:
             static std::less_equal<const E*> le;
             (void) le;
             assert(!(le(begin(), &*b) && le(&*b, end())));
-            reserve(neededCapacity);
+            reserve(GrownCapacity(neededCapacity));
         }
         std::copy(b, e, end());
         pData_->pEnd_ += sz;
@@ -275,4 +312,10 @@ public:
     { return *this; }
 };
 
+template <typename E, class A, unsigned int GrowthPercent>
+struct StorageHasReserveExact<AllocatorStringStorage<E, A, GrowthPercent> >
+{
+    enum { result = true };
+};
+
 #endif // ALLOCATOR_STRING_STORAGE_INC_
@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Copyright (c) 2001 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPACT_STRING_OPT_INC_
+#define COMPACT_STRING_OPT_INC_
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template CompactStringOpt
+// A tighter small string optimization than SmallStringOpt, built over any
+//     other storage.
+// The spare capacity lives in the very last byte of the object, so a full
+//     small string's terminator doubles as the "spare == 0" mark and no
+//     padding byte is lost: with the default threshold the whole object is
+//     24 bytes holding up to 23 chars inline, 32 bytes holding 31.
+// The small/large discrimination is a single byte compare against 0xFF --
+//     a value spare capacity can never take -- instead of SmallStringOpt's
+//     value_type magic, so size() and data() compile down to one load, one
+//     compare and a conditional move.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include "flex_string_details.h"
+
+template <class Storage, unsigned int threshold,
+    typename Align = typename Storage::value_type*>
+class CompactStringOpt
+{
+public:
+    typedef typename Storage::value_type value_type;
+    typedef value_type* iterator;
+    typedef const value_type* const_iterator;
+    typedef typename Storage::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+    typedef typename Storage::reference reference;
+
+private:
+    enum { alignBytes = sizeof(Align) };
+
+    // enough room for the threshold, for an embedded Storage plus the
+    // flag byte, and for the alignment type...
+    enum { temp1 = threshold * sizeof(value_type) + 1 > sizeof(Storage) + 1
+        ? threshold * sizeof(value_type) + 1
+        : sizeof(Storage) + 1 };
+    enum { temp2 = int(temp1) > int(alignBytes) ? int(temp1) : int(alignBytes) };
+
+    // ...rounded up so no padding is wasted
+    enum { bufBytes =
+        (temp2 + alignBytes - 1) / alignBytes * alignBytes };
+    enum { bufChars = bufBytes / sizeof(value_type) };
+
+public:
+    // the spare count must stay clear of the 0xFF large marker
+    enum { maxSmallString = bufChars - 1 < 126 ? bufChars - 1 : 126 };
+
+private:
+    enum { large = 0xFF };
+
+    union
+    {
+        mutable value_type buf_[bufChars];
+        Align align_;
+    };
+
+    // The last byte of the object: spare small capacity (0 when full, so
+    // a full string's terminator writes exactly it), or 0xFF when the
+    // contents live in the embedded Storage.
+    unsigned char& Flag() const
+    { return reinterpret_cast<unsigned char*>(buf_)[bufBytes - 1]; }
+
+    void MarkSmall(size_type len)
+    {
+        assert(len <= maxSmallString);
+        Flag() = static_cast<unsigned char>(maxSmallString - len);
+    }
+
+    bool Small() const
+    { return Flag() != large; }
+
+    Storage& GetStorage()
+    {
+        assert(!Small());
+        Storage* p = reinterpret_cast<Storage*>(&buf_[0]);
+        return *p;
+    }
+
+    const Storage& GetStorage() const
+    {
+        assert(!Small());
+        const Storage* p = reinterpret_cast<const Storage*>(&buf_[0]);
+        return *p;
+    }
+
+public:
+    CompactStringOpt(const CompactStringOpt& s)
+    {
+        if (s.Small())
+        {
+            // the flag byte travels with the buffer
+            flex_string_details::pod_copy(s.buf_, s.buf_ + bufChars, buf_);
+        }
+        else
+        {
+            new(buf_) Storage(s.GetStorage());
+            Flag() = large;
+        }
+    }
+
+    CompactStringOpt(const allocator_type&)
+    {
+        MarkSmall(0);
+    }
+
+    CompactStringOpt(const value_type* s, size_type len,
+        const allocator_type& a)
+    {
+        if (len <= maxSmallString)
+        {
+            flex_string_details::pod_copy(s, s + len, buf_);
+            MarkSmall(len);
+        }
+        else
+        {
+            new(buf_) Storage(s, len, a);
+            Flag() = large;
+        }
+    }
+
+    CompactStringOpt(size_type len, value_type c, const allocator_type& a)
+    {
+        if (len <= maxSmallString)
+        {
+            flex_string_details::pod_fill(buf_, buf_ + len, c);
+            MarkSmall(len);
+        }
+        else
+        {
+            new(buf_) Storage(len, c, a);
+            Flag() = large;
+        }
+    }
+
+    CompactStringOpt& operator=(const CompactStringOpt& rhs)
+    {
+        if (&rhs != this)
+        {
+            CompactStringOpt copy(rhs);
+            copy.swap(*this);
+        }
+        return *this;
+    }
+
+    ~CompactStringOpt()
+    {
+        if (!Small()) GetStorage().~Storage();
+    }
+
+    iterator begin()
+    {
+        if (Small()) return buf_;
+        return &*GetStorage().begin();
+    }
+
+    const_iterator begin() const
+    {
+        if (Small()) return buf_;
+        return &*GetStorage().begin();
+    }
+
+    iterator end()
+    { return begin() + size(); }
+
+    const_iterator end() const
+    { return begin() + size(); }
+
+    size_type size() const
+    {
+        const unsigned char spare = Flag();
+        return spare != large
+            ? size_type(maxSmallString) - spare
+            : GetStorage().size();
+    }
+
+    size_type max_size() const
+    { return get_allocator().max_size(); }
+
+    size_type capacity() const
+    { return Small() ? size_type(maxSmallString) : GetStorage().capacity(); }
+
+    void reserve(size_type res_arg)
+    {
+        if (Small())
+        {
+            if (res_arg <= maxSmallString) return;
+            CompactStringOpt temp(*this);
+            this->~CompactStringOpt();
+            new(buf_) Storage(temp.data(), temp.size(),
+                temp.get_allocator());
+            Flag() = large;
+            GetStorage().reserve(res_arg);
+        }
+        else
+        {
+            GetStorage().reserve(res_arg);
+        }
+        assert(capacity() >= res_arg);
+    }
+
+    template <class FwdIterator>
+    void append(FwdIterator b, FwdIterator e)
+    {
+        if (!Small())
+        {
+            GetStorage().append(b, e);
+        }
+        else
+        {
+            const size_type
+                oldSize = size(),
+                sz = std::distance(b, e),
+                neededCapacity = oldSize + sz;
+
+            if (maxSmallString < neededCapacity)
+            {
+                // need to change storage strategy
+                allocator_type alloc;
+                Storage temp(alloc);
+                temp.reserve(neededCapacity);
+                temp.append(buf_, buf_ + oldSize);
+                temp.append(b, e);
+                new(buf_) Storage(temp.get_allocator());
+                Flag() = large;
+                GetStorage().swap(temp);
+            }
+            else
+            {
+                std::copy(b, e, buf_ + oldSize);
+                MarkSmall(neededCapacity);
+            }
+        }
+    }
+
+    void resize(size_type n, value_type c)
+    {
+        if (Small())
+        {
+            if (n > maxSmallString)
+            {
+                // Small string resized to big string
+                CompactStringOpt temp(*this); // can't throw
+                Storage newString(temp.data(), temp.size(),
+                    temp.get_allocator());
+                newString.resize(n, c);
+                // We make the reasonable assumption that an empty Storage
+                //     constructor won't throw
+                this->~CompactStringOpt();
+                new(&buf_[0]) Storage(temp.get_allocator());
+                Flag() = large;
+                GetStorage().swap(newString);
+            }
+            else
+            {
+                // Small string resized to small string
+                const size_type oldSize = size();
+                if (n > oldSize)
+                    flex_string_details::pod_fill(
+                        buf_ + oldSize, buf_ + n, c);
+                MarkSmall(n);
+            }
+        }
+        else
+        {
+            // Stay with the embedded Storage even when n would fit
+            // inline: flex_string's insert and replace flows hold
+            // pointers into the buffer across resize, so releasing it
+            // here would leave them dangling -- and would also shrink
+            // capacity behind the caller's back.
+            GetStorage().resize(n, c);
+        }
+    }
+
+    void swap(CompactStringOpt& rhs)
+    {
+        if (Small())
+        {
+            if (rhs.Small())
+            {
+                // Small swapped with small; the flag bytes travel along
+                std::swap_ranges(buf_, buf_ + bufChars, rhs.buf_);
+            }
+            else
+            {
+                // Small swapped with big
+                // Make a copy of myself - can't throw
+                CompactStringOpt temp(*this);
+                // Nuke myself
+                this->~CompactStringOpt();
+                // Make an empty storage for myself (likely won't throw)
+                new(buf_) Storage(0, value_type(), rhs.get_allocator());
+                Flag() = large;
+                // Recurse to this same function
+                swap(rhs);
+                // Nuke rhs
+                rhs.~CompactStringOpt();
+                // Build the new small string into rhs
+                new(&rhs) CompactStringOpt(temp);
+            }
+        }
+        else
+        {
+            if (rhs.Small())
+            {
+                // Big swapped with small
+                // Already implemented, recurse with reversed args
+                rhs.swap(*this);
+            }
+            else
+            {
+                // Big swapped with big
+                GetStorage().swap(rhs.GetStorage());
+            }
+        }
+    }
+
+    const value_type* c_str() const
+    {
+        if (!Small()) return GetStorage().c_str();
+        // when full, the terminator lands on the flag byte, which is then
+        // legitimately zero (no spare capacity)
+        buf_[size()] = value_type();
+        return buf_;
+    }
+
+    const value_type* data() const
+    { return Flag() != large ? buf_ : GetStorage().data(); }
+
+    allocator_type get_allocator() const
+    { return allocator_type(); }
+};
+
+
+#endif // COMPACT_STRING_OPT_INC_
@@ -277,4 +277,233 @@ public:
 };
 
 
+#if defined(FLEX_STRING_HAS_ATOMIC_COW)
+
+////////////////////////////////////////////////////////////////////////////////
+// class template AtomicCowStringOpt
+// Copy on Write over any storage, with an atomic sharing count, so
+//     distinct string handles over the same buffer may live in different
+//     threads: handing a string across threads is a refcount bump, not a
+//     copy. The usual container contract still applies -- concurrent
+//     access to the SAME handle, one of them mutating, is a race.
+// The count sits in the first character of the buffer exactly like
+//     CowStringOpt's; only the operations on it differ. Copying CASes
+//     the count up so saturation at the type's maximum safely degrades
+//     to a deep copy; unsharing deep-copies first and then drops the old
+//     count with a release, destroying the old buffer when it turns out
+//     this handle was the last owner.
+// Only available where the compiler provides the atomic builtins (see
+//     flex_string_details.h).
+////////////////////////////////////////////////////////////////////////////////
+
+template <class Storage, typename Align = typename Storage::value_type*>
+class AtomicCowStringOpt
+{
+    typedef typename Storage::value_type E;
+    typedef typename flex_string_details::get_unsigned<E>::result RefCountType;
+
+public:
+    typedef E value_type;
+    typedef typename Storage::iterator iterator;
+    typedef typename Storage::const_iterator const_iterator;
+    typedef typename Storage::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+    typedef typename Storage::reference reference;
+
+private:
+    union
+    {
+        mutable char buf_[sizeof(Storage)];
+        Align align_;
+    };
+
+    Storage& Data() const
+    { return *reinterpret_cast<Storage*>(buf_); }
+
+    volatile RefCountType& Refs() const
+    {
+        Storage& d = Data();
+        assert(d.size() > 0);
+        return reinterpret_cast<volatile RefCountType&>(*d.begin());
+    }
+
+    RefCountType GetRefs() const
+    { return flex_string_details::atomic_load(Refs()); }
+
+    void MakeUnique() const
+    {
+        assert(GetRefs() >= 1);
+        if (GetRefs() == 1) return;
+
+        union
+        {
+            char buf_[sizeof(Storage)];
+            Align align_;
+        } temp;
+
+        // deep-copy the payload only (not the count character, which
+        // other owners are updating atomically); the payload itself is
+        // immutable while shared, so reading it here is safe
+        const Storage& old = Data();
+        Storage* fresh = new(temp.buf_) Storage(old.get_allocator());
+        fresh->reserve(old.size());
+        fresh->resize(1, 1);
+        fresh->append(old.data() + 1, old.data() + old.size());
+        if (flex_string_details::atomic_decrement(Refs()) == 0)
+        {
+            // every other owner left while we copied
+            Data().~Storage();
+        }
+        new(buf_) Storage(*fresh, flex_string_details::Shallow());
+        *Data().begin() = 1;
+    }
+
+public:
+    AtomicCowStringOpt(const AtomicCowStringOpt& s)
+    {
+        for (;;)
+        {
+            const RefCountType refs = s.GetRefs();
+            if (refs == std::numeric_limits<RefCountType>::max())
+            {
+                // saturated: must make a brand new copy (payload only,
+                // the count character is owned by the atomics)
+                const Storage& old = s.Data();
+                new(buf_) Storage(old.get_allocator());
+                Data().reserve(old.size());
+                Data().resize(1, 1);
+                Data().append(old.data() + 1, old.data() + old.size());
+                break;
+            }
+            if (flex_string_details::atomic_compare_swap(
+                s.Refs(), refs, RefCountType(refs + 1)))
+            {
+                new(buf_) Storage(s.Data(), flex_string_details::Shallow());
+                break;
+            }
+        }
+        assert(Data().size() > 0);
+    }
+
+    AtomicCowStringOpt(const allocator_type& a)
+    {
+        new(buf_) Storage(1, 1, a);
+    }
+
+    AtomicCowStringOpt(const E* s, size_type len, const allocator_type& a)
+    {
+        new(buf_) Storage(a);
+        Data().reserve(len + 1);
+        Data().resize(1, 1);
+        Data().append(s, s + len);
+    }
+
+    AtomicCowStringOpt(size_type len, E c, const allocator_type& a)
+    {
+        new(buf_) Storage(len + 1, c, a);
+        *Data().begin() = 1;
+    }
+
+    AtomicCowStringOpt& operator=(const AtomicCowStringOpt& rhs)
+    {
+        AtomicCowStringOpt(rhs).swap(*this);
+        return *this;
+    }
+
+    ~AtomicCowStringOpt()
+    {
+        assert(Data().size() > 0);
+        if (flex_string_details::atomic_decrement(Refs()) == 0)
+            Data().~Storage();
+    }
+
+    iterator begin()
+    {
+        assert(Data().size() > 0);
+        MakeUnique();
+        return Data().begin() + 1;
+    }
+
+    const_iterator begin() const
+    {
+        assert(Data().size() > 0);
+        return Data().begin() + 1;
+    }
+
+    iterator end()
+    {
+        MakeUnique();
+        return Data().end();
+    }
+
+    const_iterator end() const
+    {
+        return Data().end();
+    }
+
+    size_type size() const
+    {
+        assert(Data().size() > 0);
+        return Data().size() - 1;
+    }
+
+    size_type max_size() const
+    {
+        assert(Data().max_size() > 0);
+        return Data().max_size() - 1;
+    }
+
+    size_type capacity() const
+    {
+        assert(Data().capacity() > 0);
+        return Data().capacity() - 1;
+    }
+
+    void resize(size_type n, E c)
+    {
+        assert(Data().size() > 0);
+        MakeUnique();
+        Data().resize(n + 1, c);
+    }
+
+    template <class FwdIterator>
+    void append(FwdIterator b, FwdIterator e)
+    {
+        MakeUnique();
+        Data().append(b, e);
+    }
+
+    void reserve(size_type res_arg)
+    {
+        if (capacity() > res_arg) return;
+        MakeUnique();
+        Data().reserve(res_arg + 1);
+    }
+
+    void swap(AtomicCowStringOpt& rhs)
+    {
+        Data().swap(rhs.Data());
+    }
+
+    const E* c_str() const
+    {
+        assert(Data().size() > 0);
+        return Data().c_str() + 1;
+    }
+
+    const E* data() const
+    {
+        assert(Data().size() > 0);
+        return Data().data() + 1;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return Data().get_allocator();
+    }
+};
+
+#endif // FLEX_STRING_HAS_ATOMIC_COW
+
+
 #endif // COW_STRING_OPT_INC_
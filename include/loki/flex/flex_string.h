@@ -24,7 +24,10 @@
 #include "allocatorstringstorage.h"
 #include "vectorstringstorage.h"
 #include "smallstringopt.h"
+#include "compactstringopt.h"
+#include "segmentedstringopt.h"
 #include "cowstringopt.h"
+#include "hashedstringopt.h"
 //#include "utf16encoding.h"
 
 #endif // FLEX_STRING_INC_
@@ -16,7 +16,16 @@
 // $Id: flex_string_details.h 754 2006-10-17 19:59:11Z syntheticpp $
 
 
+#include <cstring>
+#include <cwchar>
 #include <memory>
+#include <string>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) \
+    || defined(_M_X64)
+    #define FLEX_STRING_SSE2 1
+    #include <emmintrin.h>
+#endif
 
 namespace flex_string_details
 {
@@ -97,6 +106,226 @@ namespace flex_string_details
     };
 
     enum Shallow {};
+
+    // Atomic counter primitives for AtomicCowStringOpt. The __sync
+    // builtins are full barriers, which covers the acquire half needed
+    // when a decrement drops the count to zero and the release half
+    // needed when publishing an unshared copy.
+#if defined(__GNUC__)
+    #define FLEX_STRING_HAS_ATOMIC_COW 1
+
+    template <class T>
+    inline T atomic_decrement(volatile T& counter)
+    { return __sync_sub_and_fetch(&counter, T(1)); }
+
+    template <class T>
+    inline bool atomic_compare_swap(volatile T& counter, T expected, T fresh)
+    { return __sync_bool_compare_and_swap(&counter, expected, fresh); }
+
+    template <class T>
+    inline T atomic_load(const volatile T& counter)
+    { return __sync_fetch_and_add(const_cast<volatile T*>(&counter), T(0)); }
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// class template StringScan
+// Scan kernels behind flex_string's find and find_first_of. The primary
+//     template walks characters through the Traits, exactly as the shell
+//     used to; the specializations below hand the char and wchar_t cases
+//     with standard traits to memchr/memcmp/wmemchr/wmemcmp -- which the
+//     C library already dispatches to the widest vector unit the CPU has
+//     -- plus an SSE2 substring kernel that anchors on the first and last
+//     needle characters, so long scans run at memory bandwidth.
+// All methods return a pointer into the haystack, or 0 when not found.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <typename E, class Traits>
+    struct StringScan
+    {
+        static const E* FindSub(const E* hay, size_t haySize,
+            const E* needle, size_t n)
+        {
+            if (n > haySize) return 0;
+            const size_t last = haySize - n;
+            for (size_t i = 0; i <= last; ++i)
+            {
+                if (Traits::compare(hay + i, needle, n) == 0)
+                    return hay + i;
+            }
+            return 0;
+        }
+
+        static const E* FindFirstOf(const E* hay, size_t haySize,
+            const E* set, size_t n)
+        {
+            for (size_t i = 0; i != haySize; ++i)
+            {
+                if (Traits::find(set, n, hay[i]) != 0)
+                    return hay + i;
+            }
+            return 0;
+        }
+    };
+
+    template <>
+    struct StringScan<char, std::char_traits<char> >
+    {
+        static const char* FindSub(const char* hay, size_t haySize,
+            const char* needle, size_t n)
+        {
+            if (n > haySize) return 0;
+            if (n == 0) return hay;
+            if (n == 1)
+                return static_cast<const char*>(
+                    memchr(hay, *needle, haySize));
+            size_t i = 0;
+#if defined(FLEX_STRING_SSE2)
+            // compare 16 candidate positions at a time against the first
+            // and last needle characters; only positions where both hit
+            // pay for the full memcmp
+            const __m128i first = _mm_set1_epi8(needle[0]);
+            const __m128i last = _mm_set1_epi8(needle[n - 1]);
+            for (; i + n + 15 <= haySize; i += 16)
+            {
+                const __m128i blockFirst = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(hay + i));
+                const __m128i blockLast = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(hay + i + n - 1));
+                unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(blockFirst, first),
+                    _mm_cmpeq_epi8(blockLast, last)));
+                while (mask != 0)
+                {
+                    const unsigned bit = mask & (0U - mask);
+                    size_t off = 0;
+                    for (unsigned b = bit; b > 1; b >>= 1) ++off;
+                    if (memcmp(hay + i + off + 1, needle + 1, n - 2) == 0)
+                        return hay + i + off;
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            // memchr-anchored tail (and whole scan without SSE2)
+            const char* p = hay + i;
+            const char* const stop = hay + haySize - n + 1;
+            while (p < stop)
+            {
+                p = static_cast<const char*>(memchr(p, *needle, stop - p));
+                if (p == 0) return 0;
+                if (memcmp(p + 1, needle + 1, n - 1) == 0) return p;
+                ++p;
+            }
+            return 0;
+        }
+
+        static const char* FindFirstOf(const char* hay, size_t haySize,
+            const char* set, size_t n)
+        {
+            if (n == 1)
+                return static_cast<const char*>(
+                    memchr(hay, *set, haySize));
+            // one table build, then one load per haystack character
+            // instead of an O(n) set scan each
+            unsigned char inSet[256];
+            memset(inSet, 0, sizeof(inSet));
+            for (size_t j = 0; j != n; ++j)
+                inSet[static_cast<unsigned char>(set[j])] = 1;
+            for (size_t i = 0; i != haySize; ++i)
+            {
+                if (inSet[static_cast<unsigned char>(hay[i])])
+                    return hay + i;
+            }
+            return 0;
+        }
+    };
+
+    template <>
+    struct StringScan<wchar_t, std::char_traits<wchar_t> >
+    {
+        static const wchar_t* FindSub(const wchar_t* hay, size_t haySize,
+            const wchar_t* needle, size_t n)
+        {
+            if (n > haySize) return 0;
+            if (n == 0) return hay;
+            const wchar_t* p = hay;
+            const wchar_t* const stop = hay + haySize - n + 1;
+            while (p < stop)
+            {
+                p = wmemchr(p, *needle, stop - p);
+                if (p == 0) return 0;
+                if (wmemcmp(p + 1, needle + 1, n - 1) == 0) return p;
+                ++p;
+            }
+            return 0;
+        }
+
+        static const wchar_t* FindFirstOf(const wchar_t* hay,
+            size_t haySize, const wchar_t* set, size_t n)
+        {
+            if (n == 1) return wmemchr(hay, *set, haySize);
+            for (size_t i = 0; i != haySize; ++i)
+            {
+                if (wmemchr(set, hay[i], n) != 0)
+                    return hay + i;
+            }
+            return 0;
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////
+    // String hashing
+    // HashBytes is FNV-1a over the characters' object representation;
+    // StringHashSelector routes flex_string::hash either there or to a
+    // storage's own cached hash (see StorageHasCachedHash in the shell).
+    ////////////////////////////////////////////////////////////////////////
+
+    template <class E>
+    inline std::size_t HashBytes(const E* s, std::size_t len)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+        const std::size_t n = len * sizeof(E);
+        std::size_t h = static_cast<std::size_t>(2166136261UL);
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            h ^= static_cast<std::size_t>(p[i]);
+            h *= static_cast<std::size_t>(16777619UL);
+        }
+        return h;
+    }
+
+    template <bool storageCachesHash> struct StringHashSelector
+    {
+        template <class Storage, class E>
+        static std::size_t Do(const Storage&, const E* data, std::size_t len)
+        { return HashBytes(data, len); }
+    };
+
+    template <> struct StringHashSelector<true>
+    {
+        template <class Storage, class E>
+        static std::size_t Do(const Storage& s, const E*, std::size_t)
+        { return s.hash(); }
+    };
+
+    ////////////////////////////////////////////////////////////////////////
+    // StringShrinkSelector routes flex_string::shrink_to_fit either to a
+    // storage's in-place ReserveExact (see StorageHasReserveExact in the
+    // shell) or to a rebuild through an exactly sized temporary.
+    ////////////////////////////////////////////////////////////////////////
+
+    template <bool storageReservesExactly> struct StringShrinkSelector
+    {
+        template <class Storage, class String>
+        static void Do(Storage&, String& s)
+        { String(s.data(), s.size()).swap(s); }
+    };
+
+    template <> struct StringShrinkSelector<true>
+    {
+        template <class Storage, class String>
+        static void Do(Storage& storage, String&)
+        { storage.ReserveExact(storage.size()); }
+    };
 }
 
 #endif // FLEX_STRING_DETAILS_INC_
@@ -30,8 +30,13 @@
 #include "flex_string_details.h"
 #include <string>
 
-// Forward declaration for default storage policy
-template <typename E, class A> class AllocatorStringStorage;
+// Forward declaration for default storage policy (defaults, including the
+// growth percentage, live with the definition in allocatorstringstorage.h)
+template <typename E, class A, unsigned int GrowthPercent>
+class AllocatorStringStorage;
+
+// Forward declaration; defined after flex_string below
+template <typename E, class T, class A, class Storage> class flex_string_slice;
 
 
 template <class T> class mallocator
@@ -140,16 +145,61 @@ typename Allocator::pointer Reallocate(
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+// class template StorageAppendPreservesBuffer
+// Tells flex_string::append whether a storage's append can move or
+//     invalidate the characters already stored. For ordinary contiguous
+//     storages it cannot be ruled out, so append guards against the source
+//     aliasing the string itself by reserving first; storages that append
+//     out of place (e.g. SegmentedStringOpt) specialize this to skip the
+//     guard -- and with it a forced materialization per append.
+////////////////////////////////////////////////////////////////////////////////
+
+template <class Storage>
+struct StorageAppendPreservesBuffer
+{
+    enum { result = false };
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template StorageHasCachedHash
+// Tells flex_string::hash whether a storage keeps a cached hash of its
+//     characters (HashedStringOpt specializes this). Without a cache the
+//     hash is recomputed from the data on every call.
+////////////////////////////////////////////////////////////////////////////////
+
+template <class Storage>
+struct StorageHasCachedHash
+{
+    enum { result = false };
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template StorageHasReserveExact
+// Tells flex_string::shrink_to_fit whether a storage can size its buffer
+//     to an exact capacity in place (ReserveExact). Without it the string
+//     is rebuilt through a temporary, which costs one extra copy.
+////////////////////////////////////////////////////////////////////////////////
+
+template <class Storage>
+struct StorageHasReserveExact
+{
+    enum { result = false };
+};
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template flex_string
-// a std::basic_string compatible implementation 
-// Uses a Storage policy 
+// a std::basic_string compatible implementation
+// Uses a Storage policy
 ////////////////////////////////////////////////////////////////////////////////
 
 template <typename E,
     class T = std::char_traits<E>,
     class A = std::allocator<E>,
-    class Storage = AllocatorStringStorage<E, A> >
+    class Storage = AllocatorStringStorage<E, A, 0> >
 class flex_string : private Storage
 {
 
@@ -388,7 +438,8 @@ public:
         Invariant checker(*this); 
         (void) checker; 
         static std::less_equal<const value_type*> le;
-        if (le(&*begin(), s) && le(s, &*end())) // aliasing
+        if (!StorageAppendPreservesBuffer<Storage>::result &&
+            le(&*begin(), s) && le(s, &*end())) // aliasing
         {
             const size_type offset = s - &*begin();
             Storage::reserve(size() + n);
@@ -892,14 +943,11 @@ public:
     {
         if (n + pos > size())
             return npos;
-        for (; pos + n <= size(); ++pos)
-        {
-            if (traits_type::compare(data() + pos, s, n) == 0)
-            {
-                return pos;
-            }
-        }
-        return npos;
+        const value_type* const b = data();
+        const value_type* const r = flex_string_details::
+            StringScan<value_type, traits_type>::FindSub(
+                b + pos, size() - pos, s, n);
+        return r != 0 ? static_cast<size_type>(r - b) : npos;
     }
     
     size_type find (const value_type* s, size_type pos = 0) const
@@ -943,16 +991,11 @@ public:
         size_type pos, size_type n) const
     {
         if (pos > length() || n == 0) return npos;
-        const_iterator i(begin() + pos),
-            finish(end());
-        for (; i != finish; ++i)
-        {
-            if (traits_type::find(s, n, *i) != 0)
-            {
-                return i - begin();
-            }
-        }
-        return npos;
+        const value_type* const b = data();
+        const value_type* const r = flex_string_details::
+            StringScan<value_type, traits_type>::FindFirstOf(
+                b + pos, length() - pos, s, n);
+        return r != 0 ? static_cast<size_type>(r - b) : npos;
     }
         
     size_type find_first_of(const value_type* s, size_type pos = 0) const
@@ -1057,6 +1100,33 @@ public:
         return flex_string(data() + pos, Min(n, size() - pos));
     }
 
+    // Like substr, but copies no characters; see flex_string_slice below.
+    // Defined out of line, after flex_string_slice.
+    flex_string_slice<E, T, A, Storage>
+        slice(size_type pos = 0, size_type n = npos) const;
+
+    // A hash of the character data (extension, for keying hash maps).
+    // Storages declaring StorageHasCachedHash answer from their cache;
+    // for the rest every call hashes the whole string.
+    std::size_t hash() const
+    {
+        return flex_string_details::StringHashSelector<
+            StorageHasCachedHash<Storage>::result != 0>::Do(
+                static_cast<const Storage&>(*this), data(), size());
+    }
+
+    // Trims capacity to size (extension). Storages declaring
+    // StorageHasReserveExact resize their buffer in place; the rest are
+    // rebuilt through a temporary, leaving whatever capacity an exact
+    // construction gives.  Either way a bulk-loaded string ends up with
+    // zero slack.
+    void shrink_to_fit()
+    {
+        flex_string_details::StringShrinkSelector<
+            StorageHasReserveExact<Storage>::result != 0>::Do(
+                static_cast<Storage&>(*this), *this);
+    }
+
     int compare(const flex_string& str) const
     { 
         // FIX due to Goncalo N M de Carvalho July 18, 2005
@@ -1106,6 +1176,169 @@ public:
     }
 };
 
+
+////////////////////////////////////////////////////////////////////////////////
+// class template flex_string_slice
+// A read-only view of a character range inside a flex_string, produced by
+//     flex_string::slice.  The view copies no characters: it holds a handle
+//     to the source string plus an offset and a length.  With a
+//     reference-counted storage (CowStringOpt, AtomicCowStringOpt) the
+//     handle is a refcount increment on the shared buffer, so taking a
+//     slice allocates nothing and the slice stays valid even after the
+//     source string is modified (the writer unshares, the slice keeps the
+//     old buffer) or destroyed.  With non-shared storages the handle is an
+//     ordinary string copy, and substr is the cheaper choice.
+// A slice is not null-terminated and therefore has no c_str; use str() to
+//     materialize a flex_string when one is needed.
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename E, class T, class A, class Storage>
+class flex_string_slice
+{
+public:
+    typedef flex_string<E, T, A, Storage> string_type;
+    typedef T traits_type;
+    typedef E value_type;
+    typedef typename string_type::size_type size_type;
+    typedef const value_type* const_iterator;
+    typedef const value_type& const_reference;
+
+    flex_string_slice()
+    : anchor_(), pos_(0), len_(0)
+    {}
+
+    flex_string_slice(const string_type& str,
+        size_type pos = 0, size_type n = string_type::npos)
+    : anchor_(str), pos_(pos), len_(0)
+    {
+        if (pos > anchor_.size())
+            throw std::out_of_range("flex_string_slice");
+        const size_type avail = anchor_.size() - pos;
+        len_ = n < avail ? n : avail;
+    }
+
+    const value_type* data() const
+    { return anchor_.data() + pos_; }
+
+    size_type size() const
+    { return len_; }
+
+    size_type length() const
+    { return len_; }
+
+    bool empty() const
+    { return len_ == 0; }
+
+    const_iterator begin() const
+    { return data(); }
+
+    const_iterator end() const
+    { return data() + len_; }
+
+    const_reference operator[](size_type pos) const
+    { return *(data() + pos); }
+
+    const_reference at(size_type n) const
+    {
+        if (n >= len_)
+            throw std::out_of_range("flex_string_slice");
+        return *(data() + n);
+    }
+
+    // A slice of a slice shares the same anchor; still no copying.
+    flex_string_slice slice(size_type pos = 0,
+        size_type n = string_type::npos) const
+    {
+        if (pos > len_)
+            throw std::out_of_range("flex_string_slice");
+        const size_type avail = len_ - pos;
+        return flex_string_slice(anchor_, pos_ + pos,
+            n < avail ? n : avail);
+    }
+
+    // Materializes the viewed characters as an ordinary string.
+    string_type str() const
+    { return string_type(data(), len_); }
+
+    int compare(const flex_string_slice& rhs) const
+    {
+        const size_type n1(len_), n2(rhs.len_);
+        const int r = traits_type::compare(data(), rhs.data(),
+            n1 < n2 ? n1 : n2);
+        return r != 0 ? r : n1 > n2 ? 1 : n1 < n2 ? -1 : 0;
+    }
+
+private:
+    string_type anchor_;
+    size_type pos_;
+    size_type len_;
+};
+
+template <typename E, class T, class A, class S>
+flex_string_slice<E, T, A, S>
+flex_string<E, T, A, S>::slice(size_type pos, size_type n) const
+{
+    return flex_string_slice<E, T, A, S>(*this, pos, n);
+}
+
+template <typename E, class T, class A, class S>
+bool operator==(const flex_string_slice<E, T, A, S>& lhs,
+    const flex_string_slice<E, T, A, S>& rhs)
+{
+    return lhs.size() == rhs.size() &&
+        T::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+template <typename E, class T, class A, class S>
+bool operator==(const flex_string_slice<E, T, A, S>& lhs,
+    const flex_string<E, T, A, S>& rhs)
+{
+    return lhs.size() == rhs.size() &&
+        T::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+template <typename E, class T, class A, class S>
+bool operator==(const flex_string<E, T, A, S>& lhs,
+    const flex_string_slice<E, T, A, S>& rhs)
+{ return rhs == lhs; }
+
+template <typename E, class T, class A, class S>
+bool operator==(const flex_string_slice<E, T, A, S>& lhs,
+    const typename flex_string<E, T, A, S>::value_type* rhs)
+{
+    const typename flex_string<E, T, A, S>::size_type n = T::length(rhs);
+    return lhs.size() == n && T::compare(lhs.data(), rhs, n) == 0;
+}
+
+template <typename E, class T, class A, class S>
+bool operator==(const typename flex_string<E, T, A, S>::value_type* lhs,
+    const flex_string_slice<E, T, A, S>& rhs)
+{ return rhs == lhs; }
+
+template <typename E, class T, class A, class S>
+bool operator!=(const flex_string_slice<E, T, A, S>& lhs,
+    const flex_string_slice<E, T, A, S>& rhs)
+{ return !(lhs == rhs); }
+
+template <typename E, class T, class A, class S>
+bool operator!=(const flex_string_slice<E, T, A, S>& lhs,
+    const flex_string<E, T, A, S>& rhs)
+{ return !(lhs == rhs); }
+
+template <typename E, class T, class A, class S>
+bool operator!=(const flex_string<E, T, A, S>& lhs,
+    const flex_string_slice<E, T, A, S>& rhs)
+{ return !(rhs == lhs); }
+
+template <typename E, class T, class A, class S>
+std::basic_ostream<typename flex_string<E, T, A, S>::value_type,
+    typename flex_string<E, T, A, S>::traits_type>&
+operator<<(
+    std::basic_ostream<typename flex_string<E, T, A, S>::value_type,
+        typename flex_string<E, T, A, S>::traits_type>& os,
+    const flex_string_slice<E, T, A, S>& str)
+{ return os.write(str.data(), str.size()); }
+
 // non-member functions
 template <typename E, class T, class A, class S>
 flex_string<E, T, A, S> operator+(const flex_string<E, T, A, S>& lhs, 
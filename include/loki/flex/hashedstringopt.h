@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Copyright (c) 2001 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HASHED_STRING_OPT_INC_
+#define HASHED_STRING_OPT_INC_
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template HashedStringOpt
+// Caches the string's hash over any storage
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <algorithm>
+#include "flex_string_details.h"
+
+// Primary declared in flex_string_shell.h; specialized below.
+template <class Storage> struct StorageHasCachedHash;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template HashedStringOpt
+// Keeps a lazily computed hash of the characters next to any storage, for
+//     strings used as hash map keys.  The hash is computed on the first
+//     call to hash() and answered from the cache afterwards, so repeated
+//     lookups of the same key hash it once instead of once per probe.
+//     Every operation that can mutate the characters - handing out a
+//     mutable iterator, resize, append - drops the cache; copying and
+//     assignment carry it along, since they carry the characters too.
+// flex_string::hash routes here through StorageHasCachedHash (specialized
+//     below), and the operator== overloads at the bottom compare cached
+//     hashes before touching the characters, so unequal keys of equal
+//     length part ways after one integer comparison.
+////////////////////////////////////////////////////////////////////////////////
+
+template <class Storage>
+class HashedStringOpt : private Storage
+{
+    typedef typename Storage::value_type E;
+
+public:
+    typedef E value_type;
+    typedef typename Storage::iterator iterator;
+    typedef typename Storage::const_iterator const_iterator;
+    typedef typename Storage::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+    typedef typename Storage::reference reference;
+
+private:
+    mutable std::size_t hash_;
+    mutable bool hashValid_;
+
+    void Invalidate()
+    { hashValid_ = false; }
+
+public:
+    HashedStringOpt(const HashedStringOpt& s)
+    : Storage(s), hash_(s.hash_), hashValid_(s.hashValid_)
+    {}
+
+    HashedStringOpt(const allocator_type& a)
+    : Storage(a), hash_(0), hashValid_(false)
+    {}
+
+    HashedStringOpt(const E* s, size_type len, const allocator_type& a)
+    : Storage(s, len, a), hash_(0), hashValid_(false)
+    {}
+
+    HashedStringOpt(size_type len, E c, const allocator_type& a)
+    : Storage(len, c, a), hash_(0), hashValid_(false)
+    {}
+
+    HashedStringOpt& operator=(const HashedStringOpt& rhs)
+    {
+        HashedStringOpt(rhs).swap(*this);
+        return *this;
+    }
+
+    // mutable access may be used to write; the cache cannot survive it
+    iterator begin()
+    {
+        Invalidate();
+        return Storage::begin();
+    }
+
+    const_iterator begin() const
+    { return Storage::begin(); }
+
+    iterator end()
+    {
+        Invalidate();
+        return Storage::end();
+    }
+
+    const_iterator end() const
+    { return Storage::end(); }
+
+    size_type size() const
+    { return Storage::size(); }
+
+    size_type max_size() const
+    { return Storage::max_size(); }
+
+    size_type capacity() const
+    { return Storage::capacity(); }
+
+    void resize(size_type n, E c)
+    {
+        Invalidate();
+        Storage::resize(n, c);
+    }
+
+    template <class FwdIterator>
+    void append(FwdIterator b, FwdIterator e)
+    {
+        Invalidate();
+        Storage::append(b, e);
+    }
+
+    // reserve moves the characters but does not change them
+    void reserve(size_type res_arg)
+    { Storage::reserve(res_arg); }
+
+    void swap(HashedStringOpt& rhs)
+    {
+        Storage::swap(rhs);
+        std::swap(hash_, rhs.hash_);
+        std::swap(hashValid_, rhs.hashValid_);
+    }
+
+    const E* c_str() const
+    { return Storage::c_str(); }
+
+    const E* data() const
+    { return Storage::data(); }
+
+    allocator_type get_allocator() const
+    { return Storage::get_allocator(); }
+
+    // The cached hash, computed on first demand.
+    std::size_t hash() const
+    {
+        if (!hashValid_)
+        {
+            hash_ = flex_string_details::HashBytes(data(), size());
+            hashValid_ = true;
+        }
+        return hash_;
+    }
+};
+
+template <class Storage>
+struct StorageHasCachedHash<HashedStringOpt<Storage> >
+{
+    enum { result = true };
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// operator== / operator!= fast path
+// More specialized than the generic flex_string comparisons, so overload
+// resolution prefers them for hashed-storage strings: unequal hashes
+// settle the comparison without reading a single character.  Equal hashes
+// still fall through to the character comparison, since hashes collide.
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename E, class T, class A, class Storage> class flex_string;
+
+template <typename E, class T, class A, class S>
+bool operator==(const flex_string<E, T, A, HashedStringOpt<S> >& lhs,
+    const flex_string<E, T, A, HashedStringOpt<S> >& rhs)
+{
+    return lhs.hash() == rhs.hash() &&
+        lhs.size() == rhs.size() &&
+        T::compare(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+template <typename E, class T, class A, class S>
+bool operator!=(const flex_string<E, T, A, HashedStringOpt<S> >& lhs,
+    const flex_string<E, T, A, HashedStringOpt<S> >& rhs)
+{ return !(lhs == rhs); }
+
+
+////////////////////////////////////////////////////////////////////////////////
+// struct template FlexStringHasher
+// Drop-in hash functor for hash maps keyed on any flex_string; with a
+// HashedStringOpt storage the call is answered from the cache.
+////////////////////////////////////////////////////////////////////////////////
+
+template <class StringType>
+struct FlexStringHasher
+{
+    std::size_t operator()(const StringType& s) const
+    { return s.hash(); }
+};
+
+#endif // HASHED_STRING_OPT_INC_
@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Copyright (c) 2001 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SEGMENTED_STRING_OPT_INC_
+#define SEGMENTED_STRING_OPT_INC_
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class template SegmentedStringOpt
+// A rope-flavored storage built over any other storage, for strings that
+//     are assembled by appending.
+// Appended characters go into fixed-size segments, so growing never
+//     reallocates-and-copies what is already there: append is O(1)
+//     amortized no matter how large the string gets. Any operation that
+//     needs the characters contiguous -- begin, data, c_str, and friends
+//     -- first collapses the segments into the underlying Storage with a
+//     single reserve and one pass over the segments; materialize() does
+//     the same on demand, so a build-then-read workload pays for exactly
+//     one large allocation, at the end.
+// Reads and appends interleave correctly but each switch from appending
+//     to reading materializes, so this storage earns its keep only when
+//     appends come in long runs. Pointers and iterators are invalidated
+//     exactly when any storage's would be: by growth past the reserved
+//     capacity, never by a collapse within it.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "flex_string_details.h"
+
+template <class Storage, unsigned int segmentChars = 4096>
+class SegmentedStringOpt
+{
+public:
+    typedef typename Storage::value_type value_type;
+    typedef value_type* iterator;
+    typedef const value_type* const_iterator;
+    typedef typename Storage::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+    typedef typename Storage::reference reference;
+
+private:
+    // the materialized prefix, and the appended-but-not-yet-collapsed
+    // tail chopped into segments of segmentChars characters each;
+    // mutable because handing out a contiguous view of a const string
+    // still has to collapse the segments
+    mutable Storage base_;
+    mutable std::vector<value_type*> segs_;
+    mutable size_type pending_;
+
+    void AddSegment()
+    {
+        allocator_type a(get_allocator());
+        segs_.push_back(a.allocate(segmentChars));
+    }
+
+    void FreeSegments() const
+    {
+        allocator_type a(get_allocator());
+        for (size_type i = 0; i != segs_.size(); ++i)
+            a.deallocate(segs_[i], segmentChars);
+        segs_.clear();
+    }
+
+public:
+    SegmentedStringOpt(const SegmentedStringOpt& s)
+        : base_(s.get_allocator()), pending_(0)
+    {
+        s.materialize();
+        Storage temp(s.base_);
+        base_.swap(temp);
+    }
+
+    SegmentedStringOpt(const allocator_type& a)
+        : base_(a), pending_(0)
+    {}
+
+    SegmentedStringOpt(const value_type* s, size_type len,
+        const allocator_type& a)
+        : base_(s, len, a), pending_(0)
+    {}
+
+    SegmentedStringOpt(size_type len, value_type c,
+        const allocator_type& a)
+        : base_(len, c, a), pending_(0)
+    {}
+
+    SegmentedStringOpt& operator=(const SegmentedStringOpt& rhs)
+    {
+        if (&rhs != this)
+        {
+            SegmentedStringOpt copy(rhs);
+            copy.swap(*this);
+        }
+        return *this;
+    }
+
+    ~SegmentedStringOpt()
+    {
+        FreeSegments();
+    }
+
+    // Collapse the segments into the underlying Storage: one reserve for
+    // the final size, one pass over the segments, and the string is
+    // contiguous. Call it after an append-heavy build phase; every
+    // contiguous-access member below calls it implicitly.
+    void materialize() const
+    {
+        if (segs_.empty()) return;
+        // a one-shot materialization after a long build allocates the
+        // exact final size and moves nothing twice; when base_ already
+        // has room (reserve() went through us) the collapse is in place
+        // and invalidates nothing; when reads interleave with appends
+        // the doubling keeps repeated collapses amortized O(1)
+        const size_type needed = base_.size() + pending_;
+        if (needed > base_.capacity())
+        {
+            const size_type doubled = 2 * base_.capacity();
+            base_.reserve(needed > doubled ? needed : doubled);
+        }
+        size_type left = pending_;
+        for (size_type i = 0; left != 0; ++i)
+        {
+            const size_type chunk =
+                left < segmentChars ? left : size_type(segmentChars);
+            base_.append(segs_[i], segs_[i] + chunk);
+            left -= chunk;
+        }
+        FreeSegments();
+        pending_ = 0;
+    }
+
+    iterator begin()
+    {
+        materialize();
+        return &*base_.begin();
+    }
+
+    const_iterator begin() const
+    {
+        materialize();
+        return &*base_.begin();
+    }
+
+    iterator end()
+    { return begin() + size(); }
+
+    const_iterator end() const
+    { return begin() + size(); }
+
+    size_type size() const
+    { return base_.size() + pending_; }
+
+    size_type max_size() const
+    { return base_.max_size(); }
+
+    // Only slack that materialize() can use without moving the buffer
+    // counts as capacity: flex_string captures pointers across begin()
+    // and data() after ensuring capacity, so those calls must collapse
+    // in place whenever capacity() promised room.
+    size_type capacity() const
+    {
+        const size_type sz = base_.size() + pending_;
+        return base_.capacity() > sz ? base_.capacity() : sz;
+    }
+
+    void reserve(size_type res_arg)
+    {
+        materialize();
+        base_.reserve(res_arg);
+        assert(capacity() >= res_arg);
+    }
+
+    template <class FwdIterator>
+    void append(FwdIterator b, FwdIterator e)
+    {
+        size_type n = std::distance(b, e);
+        while (n != 0)
+        {
+            if (pending_ / segmentChars == segs_.size()) AddSegment();
+            const size_type used = pending_ % segmentChars;
+            const size_type room = segmentChars - used;
+            const size_type chunk = n < room ? n : room;
+            value_type* d = segs_[pending_ / segmentChars] + used;
+            for (size_type k = 0; k != chunk; ++k, ++b) d[k] = *b;
+            pending_ += chunk;
+            n -= chunk;
+        }
+    }
+
+    void resize(size_type n, value_type c)
+    {
+        const size_type oldSize = size();
+        if (n > oldSize)
+        {
+            // grow by filling segments, same as append
+            size_type left = n - oldSize;
+            while (left != 0)
+            {
+                if (pending_ / segmentChars == segs_.size()) AddSegment();
+                const size_type used = pending_ % segmentChars;
+                const size_type room = segmentChars - used;
+                const size_type chunk =
+                    left < room ? left : room;
+                value_type* d = segs_[pending_ / segmentChars] + used;
+                flex_string_details::pod_fill(d, d + chunk, c);
+                pending_ += chunk;
+                left -= chunk;
+            }
+        }
+        else if (n >= base_.size())
+        {
+            // shrinking within the pending tail is just bookkeeping
+            pending_ = n - base_.size();
+        }
+        else
+        {
+            // keep the segments: freeing them would shrink capacity()
+            // behind the client's back, and appends reuse them anyway
+            pending_ = 0;
+            base_.resize(n, c);
+        }
+    }
+
+    void swap(SegmentedStringOpt& rhs)
+    {
+        base_.swap(rhs.base_);
+        segs_.swap(rhs.segs_);
+        std::swap(pending_, rhs.pending_);
+    }
+
+    const value_type* c_str() const
+    {
+        materialize();
+        return base_.c_str();
+    }
+
+    const value_type* data() const
+    {
+        materialize();
+        return base_.data();
+    }
+
+    allocator_type get_allocator() const
+    { return base_.get_allocator(); }
+};
+
+// Appends go into fresh segments and never move the characters already
+// stored (all pointers the string hands out point into the materialized
+// base), so flex_string::append can skip its aliasing guard -- which
+// would otherwise force a materialization per append.
+template <class Storage, unsigned int segmentChars>
+struct StorageAppendPreservesBuffer<SegmentedStringOpt<Storage, segmentChars> >
+{
+    enum { result = true };
+};
+
+
+#endif // SEGMENTED_STRING_OPT_INC_
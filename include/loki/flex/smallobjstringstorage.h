@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Copyright (c) 2001 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMALLOBJ_STRING_STORAGE_INC_
+#define SMALLOBJ_STRING_STORAGE_INC_
+
+// $Id$
+
+// Requires project to be compiled with loki/src/SmallObj.cpp and loki/src/Singleton.cpp
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Storage bindings that keep short-lived flex_strings away from the
+//     global heap.
+// SmallObjStringStorage draws every buffer from Loki's Small-Object
+//     Allocator through LokiAllocator, so strings below the small-object
+//     threshold cost a free-list pop instead of a malloc.
+// StringArena / ArenaAllocator / ArenaStringStorage go one step further
+//     for batch work such as parsing: buffers are bumped off large chunks
+//     and individual deallocation is a no-op; one Reset() after the batch
+//     reclaims every string at once. All strings built from an arena must
+//     be destroyed -- which is free -- or abandoned before Reset() is
+//     called or the arena is destroyed.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <loki/Allocator.h>
+#include "allocatorstringstorage.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// class template SmallObjStringStorage
+// AllocatorStringStorage bound to Loki's Small-Object Allocator. Use as
+//     flex_string<char, std::char_traits<char>, Loki::LokiAllocator<char>,
+//         SmallObjStringStorage<char> >
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename E>
+class SmallObjStringStorage
+    : public AllocatorStringStorage<E, Loki::LokiAllocator<E> >
+{
+    typedef AllocatorStringStorage<E, Loki::LokiAllocator<E> > Base;
+
+public:
+    typedef typename Base::value_type value_type;
+    typedef typename Base::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+
+    SmallObjStringStorage(const SmallObjStringStorage& s) : Base(s)
+    {}
+
+    SmallObjStringStorage(const allocator_type& a) : Base(a)
+    {}
+
+    SmallObjStringStorage(const value_type* s, size_type len,
+        const allocator_type& a) : Base(s, len, a)
+    {}
+
+    SmallObjStringStorage(size_type len, value_type c,
+        const allocator_type& a) : Base(len, c, a)
+    {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class StringArena
+// A chunked bump allocator. Allocate() carves aligned blocks off the
+//     current chunk and starts a new one when it runs out; oversized
+//     requests get a chunk of their own. Nothing is returned piecemeal:
+//     Reset() rewinds to the newest chunk and frees the rest, ready for
+//     the next batch.
+////////////////////////////////////////////////////////////////////////////////
+
+class StringArena
+{
+    union MaxAlign
+    {
+        double d_;
+        void* p_;
+        long l_;
+    };
+    enum { alignment = sizeof(MaxAlign) };
+
+    struct Chunk
+    {
+        Chunk* next_;
+        std::size_t bytes_; // payload bytes, excluding this header
+        char* Payload()
+        { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    Chunk* chunks_;
+    char* cursor_;
+    char* limit_;
+    std::size_t chunkBytes_;
+
+    void Grow(std::size_t bytes)
+    {
+        const std::size_t payload =
+            bytes > chunkBytes_ ? bytes : chunkBytes_;
+        Chunk* c = static_cast<Chunk*>(
+            ::operator new(sizeof(Chunk) + payload));
+        c->next_ = chunks_;
+        c->bytes_ = payload;
+        chunks_ = c;
+        cursor_ = c->Payload();
+        limit_ = cursor_ + payload;
+    }
+
+    StringArena(const StringArena&);
+    StringArena& operator=(const StringArena&);
+
+public:
+    explicit StringArena(std::size_t chunkBytes = 4096)
+        : chunks_(0), cursor_(0), limit_(0), chunkBytes_(chunkBytes)
+    {}
+
+    ~StringArena()
+    {
+        while (chunks_ != 0)
+        {
+            Chunk* c = chunks_;
+            chunks_ = c->next_;
+            ::operator delete(c);
+        }
+    }
+
+    void* Allocate(std::size_t bytes)
+    {
+        bytes = (bytes + (alignment - 1)) & ~std::size_t(alignment - 1);
+        if (bytes > std::size_t(limit_ - cursor_)) Grow(bytes);
+        char* p = cursor_;
+        cursor_ += bytes;
+        return p;
+    }
+
+    // Reclaim everything allocated so far. The newest chunk -- sized for
+    // the largest demand the last batch made -- is kept and rewound, so
+    // steady-state batches allocate no chunks at all.
+    void Reset()
+    {
+        if (chunks_ == 0) return;
+        Chunk* c = chunks_->next_;
+        chunks_->next_ = 0;
+        while (c != 0)
+        {
+            Chunk* next = c->next_;
+            ::operator delete(c);
+            c = next;
+        }
+        cursor_ = chunks_->Payload();
+        limit_ = cursor_ + chunks_->bytes_;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class template ArenaAllocator
+// STL-style allocator face of StringArena. deallocate() is a no-op; the
+//     memory comes back with the arena's Reset(). The default-constructed
+//     allocator has no arena and must not allocate.
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename Type>
+class ArenaAllocator
+{
+public:
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Type* pointer;
+    typedef const Type* const_pointer;
+    typedef Type& reference;
+    typedef const Type& const_reference;
+    typedef Type value_type;
+
+    ArenaAllocator() throw() : arena_(0)
+    {}
+
+    explicit ArenaAllocator(StringArena& arena) throw() : arena_(&arena)
+    {}
+
+    template <typename Type1>
+    ArenaAllocator(const ArenaAllocator<Type1>& rhs) throw()
+        : arena_(rhs.GetArena())
+    {}
+
+    template <typename Type1>
+    struct rebind
+    {
+        typedef ArenaAllocator<Type1> other;
+    };
+
+    pointer address(reference elem) const
+    { return &elem; }
+
+    const_pointer address(const_reference elem) const
+    { return &elem; }
+
+    pointer allocate(size_type count, const void* = 0)
+    {
+        assert(arena_ != 0);
+        return static_cast<pointer>(
+            arena_->Allocate(count * sizeof(Type)));
+    }
+
+    void deallocate(pointer, size_type)
+    {} // reclaimed wholesale by StringArena::Reset
+
+    size_type max_size() const throw()
+    { return size_type(-1) / sizeof(Type); }
+
+    void construct(pointer p, const Type& value)
+    { ::new(p) Type(value); }
+
+    void destroy(pointer p)
+    {
+        (void)p;
+        p->~Type();
+    }
+
+    StringArena* GetArena() const
+    { return arena_; }
+
+private:
+    StringArena* arena_;
+};
+
+template <typename Type>
+inline bool operator==(const ArenaAllocator<Type>& lhs,
+    const ArenaAllocator<Type>& rhs)
+{
+    return lhs.GetArena() == rhs.GetArena();
+}
+
+template <typename Type>
+inline bool operator!=(const ArenaAllocator<Type>& lhs,
+    const ArenaAllocator<Type>& rhs)
+{
+    return lhs.GetArena() != rhs.GetArena();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class template ArenaStringStorage
+// AllocatorStringStorage bound to a StringArena. Construct the strings
+//     with an ArenaAllocator naming the arena:
+//     flex_string<char, std::char_traits<char>, ArenaAllocator<char>,
+//         ArenaStringStorage<char> > s(ArenaAllocator<char>(arena));
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename E>
+class ArenaStringStorage
+    : public AllocatorStringStorage<E, ArenaAllocator<E> >
+{
+    typedef AllocatorStringStorage<E, ArenaAllocator<E> > Base;
+
+public:
+    typedef typename Base::value_type value_type;
+    typedef typename Base::allocator_type allocator_type;
+    typedef typename allocator_type::size_type size_type;
+
+    ArenaStringStorage(const ArenaStringStorage& s) : Base(s)
+    {}
+
+    ArenaStringStorage(const allocator_type& a) : Base(a)
+    {}
+
+    ArenaStringStorage(const value_type* s, size_type len,
+        const allocator_type& a) : Base(s, len, a)
+    {}
+
+    ArenaStringStorage(size_type len, value_type c,
+        const allocator_type& a) : Base(len, c, a)
+    {}
+};
+
+
+#endif // SMALLOBJ_STRING_STORAGE_INC_
@@ -346,29 +346,12 @@ public:
         }
         else
         {
-            if (n > maxSmallString)
-            {
-                // Big string resized to big string
-                GetStorage().resize(n, c);
-            }
-            else
-            {
-                // Big string resized to small string
-                // 11-17=2001: bug fix in the assertion below
-                assert(capacity() > n);
-                // The following two commented-out lines were fixed by
-                // Jean-Francois Bastien, 07/26/2007
-                //SmallStringOpt newObj(data(), n, get_allocator());
-                // newObj.swap(*this);
-                if (n <= size()) {
-                  SmallStringOpt newObj(data(), n, get_allocator());
-                  newObj.swap(*this);
-                } else {
-                  SmallStringOpt newObj(data(), size(), get_allocator());
-                  newObj.resize(n, c); // invoke this function recursively
-                  newObj.swap(*this);
-                }
-            }
+            // Stay big even when n would fit inline: flex_string's
+            // insert and replace flows hold pointers into the buffer
+            // across resize, so switching back to the small buffer here
+            // would free the storage they still point into -- and would
+            // also shrink capacity behind the caller's back.
+            GetStorage().resize(n, c);
         }
     }
 
@@ -69,17 +69,38 @@ class StoragePolicy
 #include <limits>
 #include <stdexcept>
 
+// Primary declared in flex_string_shell.h; specialized below.
+template <class Storage> struct StorageHasReserveExact;
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template VectorStringStorage
 // Uses std::vector
 // Takes advantage of the Empty Base Optimization if available
+// GrowthPercent controls how append grows a full buffer: 0 (the default)
+//     reserves exactly what is needed, the historical behavior; a value
+//     above 100 reserves at least capacity() * GrowthPercent / 100 first,
+//     so the vector never falls back on its own (typically doubling)
+//     growth policy.  ReserveExact rebuilds the vector with exactly the
+//     requested capacity (never below size()), shrinking included, which
+//     std::vector cannot otherwise do before C++11.
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename E, class A = std::allocator<E> >
+template <typename E, class A = std::allocator<E>, unsigned int GrowthPercent = 0>
 class VectorStringStorage : protected std::vector<E, A>
 {
     typedef std::vector<E, A> base;
 
+    // What append asks for when the buffer is full: at least the need,
+    // amplified by GrowthPercent when one is configured.  The division
+    // comes first so huge capacities cannot overflow the product.
+    typename A::size_type GrownCapacity(typename A::size_type needed) const
+    {
+        if (GrowthPercent <= 100) return needed;
+        const typename A::size_type grown = base::capacity()
+            + base::capacity() / 100 * (GrowthPercent - 100);
+        return grown > needed ? grown : needed;
+    }
+
 public: // protected:
     typedef E value_type;
     typedef typename base::iterator iterator;
@@ -151,7 +172,8 @@ public: // protected:
             sz = std::distance(b, e);
         assert(sz >= 0);
         if (sz == 0) return;
-        base::reserve(base::size() + sz);
+        if (base::capacity() < base::size() + sz)
+            base::reserve(GrownCapacity(base::size() + sz));
         const value_type & v = *b;
         struct OnBlockExit
         {
@@ -176,6 +198,20 @@ public: // protected:
         base::back() = E();
     }
 
+    // Rebuilds the vector with exactly res_arg characters of capacity
+    // (never below the current size), shrinking included.
+    void ReserveExact(size_type res_arg)
+    {
+        if (res_arg < size()) res_arg = size();
+        if (res_arg + 1 == base::capacity()) return;
+
+        base& v = *this;
+        base tmp(get_allocator());
+        tmp.reserve(res_arg + 1);
+        tmp.insert(tmp.end(), v.begin(), v.end());
+        v.swap(tmp);
+    }
+
     void swap(VectorStringStorage& rhs)
     { base::swap(rhs); }
     
@@ -189,5 +225,11 @@ public: // protected:
     { return base::get_allocator(); }
 };
 
+template <typename E, class A, unsigned int GrowthPercent>
+struct StorageHasReserveExact<VectorStringStorage<E, A, GrowthPercent> >
+{
+    enum { result = true };
+};
+
 
 #endif // VECTOR_STRING_STORAGE_INC_
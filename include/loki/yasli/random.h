@@ -5,30 +5,56 @@
 
 
 #include <ctime>
+#include <cstddef>
 
-class Random 
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) \
+    || defined(_M_X64)
+    #define YASLI_RANDOM_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+class Random
 {
     unsigned int seed_;
+    // Four independent multiply-with-carry streams backing nextBatch.
+    // Each lane uses its own multiplier from the list in nextShort, so
+    // the streams never coincide; stepped side by side they hide the
+    // serial dependency that limits the scalar path to one multiply
+    // per result.
+    unsigned int lane_[4];
+    // Leftovers of the last generated group of four, so the batch stream
+    // reads the same no matter how calls slice it.
+    unsigned int pending_[4];
+    int pendingCount_;
 public:
     Random(unsigned int seed = 0)
-        : seed_(seed ? seed : static_cast<unsigned int>(std::time(0)))
+        : seed_(seed ? seed : static_cast<unsigned int>(std::time(0))),
+        pendingCount_(0)
     {
+        // Decorrelate the batch lanes from seed_ and from one another.
+        // A lane seed of zero would pin that stream at zero forever.
+        unsigned int scramble = seed_;
+        for (int i = 0; i != 4; ++i)
+        {
+            scramble = scramble * 2654435761u + 0x9e3779b9u;
+            lane_[i] = scramble ? scramble : 0x9e3779b9u;
+        }
     }
     unsigned short nextShort()
     {
         /* Use any number from this list for "a"
-            18000 18030 18273 18513 18879 19074 19098 19164 19215 19584       
-            19599 19950 20088 20508 20544 20664 20814 20970 21153 21243       
-            21423 21723 21954 22125 22188 22293 22860 22938 22965 22974       
-            23109 23124 23163 23208 23508 23520 23553 23658 23865 24114       
-            24219 24660 24699 24864 24948 25023 25308 25443 26004 26088       
-            26154 26550 26679 26838 27183 27258 27753 27795 27810 27834       
-            27960 28320 28380 28689 28710 28794 28854 28959 28980 29013       
+            18000 18030 18273 18513 18879 19074 19098 19164 19215 19584
+            19599 19950 20088 20508 20544 20664 20814 20970 21153 21243
+            21423 21723 21954 22125 22188 22293 22860 22938 22965 22974
+            23109 23124 23163 23208 23508 23520 23553 23658 23865 24114
+            24219 24660 24699 24864 24948 25023 25308 25443 26004 26088
+            26154 26550 26679 26838 27183 27258 27753 27795 27810 27834
+            27960 28320 28380 28689 28710 28794 28854 28959 28980 29013
             29379 29889 30135 30345 30459 30714 30903 30963 31059 31083
         */
         static const unsigned int a = 18000;
-        return static_cast<unsigned short>(seed_ = 
-            a * (seed_ & 65535) + 
+        return static_cast<unsigned short>(seed_ =
+            a * (seed_ & 65535) +
                 (seed_ >> 16));
     }
 
@@ -43,13 +69,112 @@ public:
         ++high;
         const unsigned int bucket_size = ULONG_MAX / high;
         unsigned int a;
-        do 
+        do
         {
             a = nextUint() / bucket_size;
         }
         while (a >= high);
         return a;
     }
+
+    // Fills out[0..n) with full-width randoms built like nextUint - two
+    // generator steps per value, high half first - but drawn from the
+    // four interleaved lane streams instead of the scalar sequence, so
+    // consecutive values carry no data dependency.  With SSE2 all four
+    // lanes step in one vector operation; the multiplier fits 16 bits
+    // and the step result fits 31, so a 16x16 multiply pair covers the
+    // whole step without SSE4 lane multiplies.  The stream does not
+    // depend on how calls slice it: leftovers of the last group of four
+    // are carried over and served first by the next call.
+    void nextBatch(unsigned int* out, std::size_t n)
+    {
+        while (0 != pendingCount_ && 0 != n)
+        {
+            *out++ = pending_[4 - pendingCount_--];
+            --n;
+        }
+#if YASLI_RANDOM_SSE2
+        if (n >= 4)
+        {
+            const __m128i mult =
+                _mm_set_epi32(18513, 18273, 18030, 18000);
+            const __m128i low16 = _mm_set1_epi32(0xffff);
+            __m128i s = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(lane_));
+            do
+            {
+                const __m128i s1 = step4(s, mult, low16);
+                const __m128i s2 = step4(s1, mult, low16);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                    _mm_or_si128(
+                        _mm_slli_epi32(_mm_and_si128(s1, low16), 16),
+                        _mm_and_si128(s2, low16)));
+                s = s2;
+                out += 4;
+                n -= 4;
+            }
+            while (n >= 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_), s);
+        }
+#else
+        while (n >= 4)
+        {
+            nextGroup(out);
+            out += 4;
+            n -= 4;
+        }
+#endif
+        if (0 != n)
+        {
+            nextGroup(pending_);
+            for (std::size_t i = 0; i != n; ++i)
+                out[i] = pending_[i];
+            pendingCount_ = static_cast<int>(4 - n);
+        }
+    }
+
+private:
+    // One group of four: every lane steps twice and yields one value,
+    // exactly one iteration of the bulk loop.
+    void nextGroup(unsigned int* out)
+    {
+#if YASLI_RANDOM_SSE2
+        const __m128i mult = _mm_set_epi32(18513, 18273, 18030, 18000);
+        const __m128i low16 = _mm_set1_epi32(0xffff);
+        const __m128i s1 = step4(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(lane_)), mult, low16);
+        const __m128i s2 = step4(s1, mult, low16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+            _mm_or_si128(
+                _mm_slli_epi32(_mm_and_si128(s1, low16), 16),
+                _mm_and_si128(s2, low16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_), s2);
+#else
+        static const unsigned int a[4] = { 18000, 18030, 18273, 18513 };
+        for (int i = 0; i != 4; ++i)
+        {
+            unsigned int s = a[i] * (lane_[i] & 65535) + (lane_[i] >> 16);
+            const unsigned int hi = s & 65535;
+            s = a[i] * (s & 65535) + (s >> 16);
+            lane_[i] = s;
+            out[i] = hi << 16 | (s & 65535);
+        }
+#endif
+    }
+
+#if YASLI_RANDOM_SSE2
+    // One generator step of all four lanes: the 31-bit product is built
+    // from the 16-bit halves of a 16x16 multiply, then the carry (the
+    // old high half) is added back.
+    static __m128i step4(__m128i s, __m128i mult, __m128i low16)
+    {
+        const __m128i x = _mm_and_si128(s, low16);
+        const __m128i prod = _mm_or_si128(
+            _mm_mullo_epi16(x, mult),
+            _mm_slli_epi32(_mm_mulhi_epu16(x, mult), 16));
+        return _mm_add_epi32(prod, _mm_srli_epi32(s, 16));
+    }
+#endif
 };
 
 #endif // RANDOM_H_
@@ -4,11 +4,19 @@
 // $Id: yasli_memory.h 754 2006-10-17 19:59:11Z syntheticpp $
 
 
+#include "platform.h"
 #include "yasli_traits.h"
-#include "yasli_protocols.h"//!
 #include <cassert>
 #include <cstddef>
-#include <misc/mojo.h>//NOT A SAFE WAY TO INCLUDE IT
+#include <iterator>
+
+// Define YASLI_NEW_IS_MALLOC to 1 when the global operator new is known
+// to be a thin wrapper around malloc, so that buffers obtained from
+// yasli::allocator may legally be grown through realloc. platform.h
+// records this for the runtimes it knows as YASLI_REALLOC_AFTER_NEW.
+#ifndef YASLI_NEW_IS_MALLOC
+#define YASLI_NEW_IS_MALLOC YASLI_REALLOC_AFTER_NEW
+#endif
 
 namespace yasli {
           
@@ -147,6 +155,71 @@ namespace yasli_nstd
         }
     };
     
+    // An allocator that can adopt one externally provided buffer --
+    // typically a region mmap'd from a snapshot file -- as if it had
+    // allocated it. deallocate recognizes the adopted region and leaves
+    // it alone (the mapping belongs to the caller), so a yasli::vector
+    // holding such a buffer grows by the ordinary allocate-move path
+    // and simply walks away from the mapping: copy-on-grow. The caller
+    // must keep the mapping alive for as long as any allocator copy
+    // still carries the marker, typically the life of the process.
+    // Growth goes through operator new like yasli::allocator, but the
+    // adopted buffer is not realloc-able, so this is a separate type
+    // and the generic (allocate-move-deallocate) traits apply to it.
+    template <class T> class adopting_allocator 
+    {
+    public:
+        typedef size_t       size_type;
+        typedef ptrdiff_t    difference_type;
+        typedef T*           pointer;
+        typedef const T*     const_pointer;
+        typedef T&           reference;
+        typedef const T&     const_reference;
+        typedef T            value_type;
+        
+        template <class U> struct rebind { typedef adopting_allocator<U> other; };
+        adopting_allocator() throw() : adopted_(0) {}
+        adopting_allocator(const adopting_allocator& rhs) throw()
+            : adopted_(rhs.adopted_) {}
+        template <class U> adopting_allocator(const adopting_allocator<U>&) throw()
+            : adopted_(0) {}
+        ~adopting_allocator() throw() {}
+        pointer address(reference x) const { return &x; }
+        const_pointer address(const_reference x) { return &x; }
+        pointer allocate(size_type n, yasli::allocator<void>::const_pointer = 0)
+        {
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+        void deallocate(pointer p, size_type) 
+        {
+            if (p == adopted_)
+            {
+                // not ours to free -- the vector has moved on
+                adopted_ = 0;
+                return;
+            }
+            ::operator delete(p);
+        }
+        size_type max_size() const throw() 
+        {
+            return size_type(-1);
+        }
+        void construct(pointer p, const T& val) 
+        {
+            new((void *) p) T(val);
+        }
+        void destroy(pointer p) 
+        {
+            ((T*) p)->~T();
+        }
+        // marks p as the adopted region; at most one per instance
+        void adopt(pointer p) { adopted_ = p; }
+        bool is_adopted(const_pointer p) const
+        { return p != 0 && p == adopted_; }
+    private:
+        pointer adopted_;
+    };
+    
     //--------------destroy--------
     
     namespace _impl
@@ -200,14 +273,19 @@ namespace yasli_nstd
     }
     
     //---------------
+}
 
+// yasli_protocols.h needs destroy_range above and supplies the
+// move_traits the allocator traits below dispatch on; the forward
+// declaration covers the case where that header included this one
+namespace yasli_protocols
+{
+    template <class T> struct move_traits;
+}
+#include "yasli_protocols.h"
 
-    template <class It1, class It2>
-    It2 uninitialized_move(It1 b, It1 e, It2 d)
-    {
-        return mojo::uninitialized_move(b, e, d);
-    }
-    
+namespace yasli_nstd
+{
     template <class A>
     struct generic_allocator_traits
     {
@@ -257,25 +335,28 @@ namespace yasli_nstd
         : public generic_allocator_traits< yasli::allocator<T> > 
     {
 #if YASLI_NEW_IS_MALLOC != 0
-        
+        // operator new is malloc here, so buffers from this allocator
+        // can go straight through mallocator's realloc-aware machinery
         static bool reallocate_inplace(
-                        A& a,
-                        typename A::pointer b,
-                        typename A::size_type newSize) 
+                        yasli::allocator<T>&,
+                        typename yasli::allocator<T>::pointer b,
+                        typename yasli::allocator<T>::size_type newSize)
         {
-            allocator_traits< yasli_nstd::mallocator<T> >
-                              ::reallocate_inplace(a, b, newSize);
+            yasli_nstd::mallocator<T> m;
+            return allocator_traits< yasli_nstd::mallocator<T> >
+                              ::reallocate_inplace(m, b, newSize);
         }
-               
-        static typename yasli::allocator<T>::pointer 
+
+        static typename yasli::allocator<T>::pointer
         reallocate(
-            yasli::allocator<T>& a, 
-            typename yasli::allocator<T>::pointer b, 
-            typename yasli::allocator<T>::pointer e, 
-            typename yasli::allocator<T>::size_type newSize) 
-        {    
-            allocator_traits< yasli_nstd::mallocator<T> >
-                              ::reallocate(a, b, e, newSize);      
+            yasli::allocator<T>&,
+            typename yasli::allocator<T>::pointer b,
+            typename yasli::allocator<T>::pointer e,
+            typename yasli::allocator<T>::size_type newSize)
+        {
+            yasli_nstd::mallocator<T> m;
+            return allocator_traits< yasli_nstd::mallocator<T> >
+                              ::reallocate(m, b, e, newSize);
         }
 #endif//yasli_new_is_malloc
     };
@@ -286,30 +367,70 @@ namespace yasli_nstd
     {
 #if YASLI_HAS_EXPAND && YASLI_HAS_EFFICIENT_MSIZE
         static bool reallocate_inplace(
-                        yasli_nstd::mallocator<T>& a,
+                        yasli_nstd::mallocator<T>&,
                         typename yasli_nstd::mallocator<T>::pointer b,
-                        typename yasli_nstd::mallocator<T>::size_type newSize) 
+                        typename yasli_nstd::mallocator<T>::size_type newSize)
         {
-            if (b == 0) return malloc(newSize);
-            if (newSize == 0) {free(b); return false;}
-            return b == yasli_platform::expand(b, newSize) 
-                   && yasli_platform::msize(b) >= newSize;
-        } 
+            if (b == 0 || newSize == 0) return false;
+            return b == yasli_platform::expand(b, newSize * sizeof(T))
+                   && yasli_platform::msize(b) >= newSize * sizeof(T);
+        }
 #endif
-        static typename yasli_nstd::mallocator<T>::pointer 
+    private:
+        struct realloc_mover
+        {
+            // realloc extends the block in place when it can and
+            // otherwise moves the raw bits -- for a relocatable type
+            // that is destructive_move minus the extra copy
+            static typename yasli_nstd::mallocator<T>::pointer
+            execute(
+                yasli_nstd::mallocator<T>&,
+                typename yasli_nstd::mallocator<T>::pointer b,
+                typename yasli_nstd::mallocator<T>::pointer,
+                typename yasli_nstd::mallocator<T>::size_type newSize)
+            {
+                return static_cast<T*>(realloc(b, newSize * sizeof(T)));
+            }
+        };
+
+        struct safe_mover
+        {
+            static typename yasli_nstd::mallocator<T>::pointer
+            execute(
+                yasli_nstd::mallocator<T>& a,
+                typename yasli_nstd::mallocator<T>::pointer b,
+                typename yasli_nstd::mallocator<T>::pointer e,
+                typename yasli_nstd::mallocator<T>::size_type newSize)
+            {
+                // expanding in place is correct for any type -- no
+                // object moves at all -- but never shrink this way, or
+                // the tail elements would miss their destructors
+                const typename yasli_nstd::mallocator<T>::size_type
+                    oldSize = e - b;
+                if (newSize >= oldSize
+                    && allocator_traits::reallocate_inplace(a, b, newSize))
+                {
+                    return b;
+                }
+                return generic_allocator_traits<
+                    yasli_nstd::mallocator<T> >::
+                        reallocate(a, b, e, newSize);
+            }
+        };
+
+    public:
+        static typename yasli_nstd::mallocator<T>::pointer
         reallocate(
             yasli_nstd::mallocator<T>& a,
             typename yasli_nstd::mallocator<T>::pointer b,
             typename yasli_nstd::mallocator<T>::pointer e,
             typename yasli_nstd::mallocator<T>::size_type newSize)
         {
-            if (yasli_nstd::is_memmoveable<T>::value)
-            {
-                return static_cast<T*>(realloc(b, newSize));
-            }
-            if(reallocate_inplace(a, b, newSize)) return b;           
-            return generic_allocator_traits< yasli_nstd::mallocator<T> >::
-                          reallocate(a, b, e, newSize);            
+            return yasli_nstd::type_selector<
+                yasli_protocols::move_traits<T>::relocatable != 0,
+                realloc_mover,
+                safe_mover
+                >::result::execute(a, b, e, newSize);
         }
     };
 }
@@ -341,9 +462,10 @@ namespace yasli
                          for (; begin != end; ++begin) (&*begin)->~T();
                      }
                  } guard = { result, &result };
-                 for (; first != last; ++first, ++result) 
+                 for (; first != last; ++first, ++result)
                      new(&*result) typename std::iterator_traits<FwdItr>::value_type(*first);
                  // commit
+                 guard.current = 0;
                  return result;
              }
           };                    
@@ -353,7 +475,7 @@ namespace yasli
           {
              static T* execute(const T* first, const T* last, T* result)
              {
-                 yasli_nstd::is_memcopyable<T>::value;
+                 assert(yasli_nstd::is_memcopyable<T>::value);
                  const size_t s = last - first;
                  memmove(result, first, s * sizeof(T));
                  return result + s;                 
@@ -367,14 +489,12 @@ namespace yasli
     template <class InputItr, class FwdItr>
     FwdItr uninitialized_copy(InputItr first, InputItr last, FwdItr result)
     {
-           std::cout<<"neither\n";
         return _impl::uninitialized_safe_copier<InputItr, FwdItr>::execute(first, last, result);
     }
     
     template <class T>
     T* uninitialized_copy(const T* first, const T* last, T* result)
     {
-       std::cout<<"const\n";
        return yasli_nstd::type_selector<yasli_nstd::is_memcopyable<T>::value != 0,
                                          _impl::uninitialized_memcopier<T>,
                                          _impl::uninitialized_safe_copier<const T*, T*>
@@ -384,7 +504,6 @@ namespace yasli
     template <class T>
     T* uninitialized_copy(T* first, T* last, T* result)
     {
-       std::cout<<"non-const\n";
        return uninitialized_copy(static_cast<const T*>(first), 
                                  static_cast<const T*>(last), result);
     }  
@@ -0,0 +1,313 @@
+#ifndef YASLI_PARALLEL_H_
+#define YASLI_PARALLEL_H_
+
+// $Id$
+
+
+// Parallel bulk operations over contiguous ranges, meant for the
+// multi-gigabyte yasli::vector buffers where a single core cannot
+// saturate the memory channels. Only types the traits classify as
+// memcopyable are split across threads; class types fall back to the
+// serial algorithms, as does everything on platforms without pthreads
+// or when the range is too small to amortize the thread handshake.
+//
+// The ranges are raw pointers so the algorithms compose with
+// yasli::vector via &*v.begin() as well as with plain arrays. The
+// destination of parallel_uninitialized_copy may be raw memory; the
+// functor given to parallel_transform is copied into each worker and
+// must be safe to run concurrently.
+
+#include "yasli_traits.h"
+#include "yasli_memory.h"
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#ifndef YASLI_HAS_PARALLEL
+#if defined(__GNUC__) && !defined(YASLI_NO_PARALLEL)
+#define YASLI_HAS_PARALLEL 1
+#else
+#define YASLI_HAS_PARALLEL 0
+#endif
+#endif
+
+#if YASLI_HAS_PARALLEL
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace yasli_nstd
+{
+    namespace _impl
+    {
+        enum { max_parallel_threads = 8 };
+
+        // Below this many bytes the fork/join handshake costs more
+        // than the second core buys
+        enum { parallel_min_bytes = 2 * 1024 * 1024 };
+
+        struct parallel_task
+        {
+            void (*run_)(parallel_task*);
+        };
+
+#if YASLI_HAS_PARALLEL
+        inline void* parallel_thread_main(void* p)
+        {
+            parallel_task* t = static_cast<parallel_task*>(p);
+            t->run_(t);
+            return 0;
+        }
+#endif
+
+        inline unsigned int parallel_threads_for(std::size_t bytes)
+        {
+#if YASLI_HAS_PARALLEL
+            if (bytes < std::size_t(parallel_min_bytes)) return 1;
+            const long n = sysconf(_SC_NPROCESSORS_ONLN);
+            if (n < 2) return 1;
+            return n < long(max_parallel_threads)
+                ? static_cast<unsigned int>(n)
+                : static_cast<unsigned int>(max_parallel_threads);
+#else
+            (void)bytes;
+            return 1;
+#endif
+        }
+
+        // Runs count tasks, the last one on the calling thread. A task
+        // whose thread cannot be spawned just runs here too -- the
+        // algorithms stay correct, only less parallel.
+        inline void run_parallel(parallel_task** tasks, unsigned int count)
+        {
+#if YASLI_HAS_PARALLEL
+            pthread_t ids[max_parallel_threads];
+            bool spawned[max_parallel_threads];
+            unsigned int i;
+            for (i = 0; i + 1 < count; ++i)
+            {
+                spawned[i] = pthread_create(&ids[i], 0,
+                    parallel_thread_main, tasks[i]) == 0;
+                if (!spawned[i]) tasks[i]->run_(tasks[i]);
+            }
+            tasks[count - 1]->run_(tasks[count - 1]);
+            for (i = 0; i + 1 < count; ++i)
+            {
+                if (spawned[i]) pthread_join(ids[i], 0);
+            }
+#else
+            for (unsigned int i = 0; i < count; ++i)
+                tasks[i]->run_(tasks[i]);
+#endif
+        }
+
+        //---------------fill---------------
+
+        template <class T>
+        struct fill_task : public parallel_task
+        {
+            T* b_;
+            T* e_;
+            const T* value_;
+
+            static void run(parallel_task* p)
+            {
+                fill_task* t = static_cast<fill_task*>(p);
+                std::fill(t->b_, t->e_, *t->value_);
+            }
+        };
+
+        template <class T>
+        struct parallel_filler
+        {
+            static void execute(T* dest, std::size_t n, const T& value)
+            {
+                const unsigned int k =
+                    parallel_threads_for(n * sizeof(T));
+                if (k < 2)
+                {
+                    std::fill(dest, dest + n, value);
+                    return;
+                }
+                fill_task<T> tasks[max_parallel_threads];
+                parallel_task* run[max_parallel_threads];
+                const std::size_t chunk = n / k;
+                for (unsigned int i = 0; i < k; ++i)
+                {
+                    tasks[i].run_ = &fill_task<T>::run;
+                    tasks[i].b_ = dest + i * chunk;
+                    tasks[i].e_ = i + 1 < k
+                        ? tasks[i].b_ + chunk
+                        : dest + n;
+                    tasks[i].value_ = &value;
+                    run[i] = &tasks[i];
+                }
+                run_parallel(run, k);
+            }
+        };
+
+        template <class T>
+        struct serial_filler
+        {
+            static void execute(T* dest, std::size_t n, const T& value)
+            {
+                std::fill(dest, dest + n, value);
+            }
+        };
+
+        //---------------uninitialized copy---------------
+
+        template <class T>
+        struct copy_task : public parallel_task
+        {
+            const T* b_;
+            const T* e_;
+            T* dest_;
+
+            static void run(parallel_task* p)
+            {
+                copy_task* t = static_cast<copy_task*>(p);
+                memcpy(t->dest_, t->b_, (t->e_ - t->b_) * sizeof(T));
+            }
+        };
+
+        template <class T>
+        struct parallel_copier
+        {
+            static T* execute(const T* first, const T* last, T* dest)
+            {
+                const std::size_t n = last - first;
+                const unsigned int k =
+                    parallel_threads_for(n * sizeof(T));
+                if (k < 2)
+                {
+                    return yasli::uninitialized_copy(first, last, dest);
+                }
+                copy_task<T> tasks[max_parallel_threads];
+                parallel_task* run[max_parallel_threads];
+                const std::size_t chunk = n / k;
+                for (unsigned int i = 0; i < k; ++i)
+                {
+                    tasks[i].run_ = &copy_task<T>::run;
+                    tasks[i].b_ = first + i * chunk;
+                    tasks[i].e_ = i + 1 < k
+                        ? tasks[i].b_ + chunk
+                        : last;
+                    tasks[i].dest_ = dest + i * chunk;
+                    run[i] = &tasks[i];
+                }
+                run_parallel(run, k);
+                return dest + n;
+            }
+        };
+
+        template <class T>
+        struct serial_copier
+        {
+            static T* execute(const T* first, const T* last, T* dest)
+            {
+                return yasli::uninitialized_copy(first, last, dest);
+            }
+        };
+
+        //---------------transform---------------
+
+        template <class T, class U, class Op>
+        struct transform_task : public parallel_task
+        {
+            const T* b_;
+            const T* e_;
+            U* dest_;
+            Op op_; // per-worker copy
+
+            transform_task(const Op& op) : op_(op) {}
+
+            static void run(parallel_task* p)
+            {
+                transform_task* t = static_cast<transform_task*>(p);
+                std::transform(t->b_, t->e_, t->dest_, t->op_);
+            }
+        };
+
+        template <class T, class U, class Op>
+        struct parallel_transformer
+        {
+            static U* execute(const T* first, const T* last, U* dest,
+                const Op& op)
+            {
+                const std::size_t n = last - first;
+                const unsigned int k =
+                    parallel_threads_for(n * sizeof(U));
+                if (k < 2)
+                {
+                    return std::transform(first, last, dest, op);
+                }
+                typedef transform_task<T, U, Op> task_t;
+                task_t tasks[max_parallel_threads] =
+                {
+                    task_t(op), task_t(op), task_t(op), task_t(op),
+                    task_t(op), task_t(op), task_t(op), task_t(op)
+                };
+                parallel_task* run[max_parallel_threads];
+                const std::size_t chunk = n / k;
+                for (unsigned int i = 0; i < k; ++i)
+                {
+                    tasks[i].run_ = &task_t::run;
+                    tasks[i].b_ = first + i * chunk;
+                    tasks[i].e_ = i + 1 < k
+                        ? tasks[i].b_ + chunk
+                        : last;
+                    tasks[i].dest_ = dest + i * chunk;
+                    run[i] = &tasks[i];
+                }
+                run_parallel(run, k);
+                return dest + n;
+            }
+        };
+
+        template <class T, class U, class Op>
+        struct serial_transformer
+        {
+            static U* execute(const T* first, const T* last, U* dest,
+                const Op& op)
+            {
+                return std::transform(first, last, dest, op);
+            }
+        };
+    } // _impl
+} // yasli_nstd
+
+namespace yasli
+{
+    template <class T>
+    void parallel_fill_n(T* dest, std::size_t n, const T& value)
+    {
+        yasli_nstd::type_selector<
+            yasli_nstd::is_memcopyable<T>::value != 0,
+            yasli_nstd::_impl::parallel_filler<T>,
+            yasli_nstd::_impl::serial_filler<T>
+            >::result::execute(dest, n, value);
+    }
+
+    template <class T>
+    T* parallel_uninitialized_copy(const T* first, const T* last, T* dest)
+    {
+        return yasli_nstd::type_selector<
+            yasli_nstd::is_memcopyable<T>::value != 0,
+            yasli_nstd::_impl::parallel_copier<T>,
+            yasli_nstd::_impl::serial_copier<T>
+            >::result::execute(first, last, dest);
+    }
+
+    template <class T, class U, class Op>
+    U* parallel_transform(const T* first, const T* last, U* dest, Op op)
+    {
+        return yasli_nstd::type_selector<
+            yasli_nstd::is_memcopyable<U>::value != 0,
+            yasli_nstd::_impl::parallel_transformer<T, U, Op>,
+            yasli_nstd::_impl::serial_transformer<T, U, Op>
+            >::result::execute(first, last, dest, op);
+    }
+} // yasli
+
+#endif // YASLI_PARALLEL_H_
@@ -6,6 +6,7 @@
 
 #include <complex>
 #include <functional>
+#include <memory>
 #include "yasli_memory.h"
 #include <memory.h>
 
@@ -16,6 +17,10 @@ namespace yasli_protocols
     template <class T>
     struct safe_move_traits
     {
+        // Objects must be moved one at a time through their copy
+        // constructor; their bits may not be blindly relocated
+        enum { relocatable = 0 };
+
         static T* destructive_move(
             T* begin, 
             T* end, 
@@ -67,6 +72,11 @@ namespace yasli_protocols
     template <class T>
     struct memmove_traits
     {
+        // Objects are just bits: the allocator machinery may relocate
+        // them wholesale (e.g. through realloc) without running any
+        // constructor or destructor
+        enum { relocatable = 1 };
+
         static T* destructive_move(
             T* begin, 
             T* end, 
@@ -10,21 +10,55 @@
 #include "yasli_traits.h"
 #include "yasli_protocols.h"
 #include <iterator>
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include "../TypeManip.h"
 
-namespace yasli 
+namespace yasli
 {
-    template <class T, class Allocator = allocator<T> >
+    template <class T, class Allocator = allocator<T>,
+        unsigned int inlineCapacity = 0>
     class vector;
 }
 
 namespace yasli {
-     
-   template <class T, class Allocator>
-   class vector 
+
+   // Inline element storage for vector: the primary template holds room
+   // for n elements inside the object itself, the n == 0 specialization
+   // is an empty base so the plain vector keeps its three-pointer layout
+   template <class T, unsigned int n>
+   struct vector_inline_store
+   {
+       enum { inline_capacity = n };
+       T* inline_begin()
+       { return reinterpret_cast<T*>(buf_.room_); }
+       bool is_inline(const T* p) const
+       { return p == reinterpret_cast<const T*>(buf_.room_); }
+   private:
+       union
+       {
+           char room_[n * sizeof(T)];
+           double forAlignment_;
+           void* forAlignment2_;
+           long forAlignment3_;
+       } buf_;
+   };
+
+   template <class T>
+   struct vector_inline_store<T, 0>
+   {
+       enum { inline_capacity = 0 };
+       T* inline_begin() { return 0; }
+       bool is_inline(const T*) const { return false; }
+   };
+
+   template <class T, class Allocator, unsigned int inlineCapacity>
+   class vector
+       : private vector_inline_store<T, inlineCapacity>
    {
+       typedef vector_inline_store<T, inlineCapacity> inline_store;
+
        struct ebo : public Allocator
        {
            T *beg_;
@@ -35,7 +69,7 @@ namespace yasli {
        T *eos_; 
    public:
        // types:
-       typedef          vector<T, Allocator>             this_type;//not standard
+       typedef          vector<T, Allocator, inlineCapacity> this_type;//not standard
        typedef typename Allocator::reference             reference;
        typedef typename Allocator::const_reference       const_reference;
        typedef typename Allocator::pointer               iterator;       // See 23.1
@@ -49,9 +83,16 @@ namespace yasli {
        typedef std::reverse_iterator<iterator>           reverse_iterator;
        typedef std::reverse_iterator<const_iterator>     const_reverse_iterator;
    private:
-       void init_empty() 
+       void init_empty()
        {
-            
+           if (inline_store::inline_capacity != 0)
+           {
+               ebo_.beg_ = this->inline_begin();
+               end_ = ebo_.beg_;
+               eos_ = ebo_.beg_ + inline_store::inline_capacity;
+               assert(empty());
+               return;
+           }
    #if YASLI_UNDEFINED_POINTERS_COPYABLE == 1
            end_ = ebo_.beg_;
            eos_ = ebo_.beg_;
@@ -66,6 +107,14 @@ namespace yasli {
        
        void init_move(vector& temp)
        {
+           if (inline_store::inline_capacity != 0)
+           {
+               // temp's buffer may live inside temp; swap knows how to
+               // move it between objects
+               init_empty();
+               swap(temp);
+               return;
+           }
            ebo_ = temp.ebo_;
            end_ = temp.end_;
            eos_ = temp.eos_;
@@ -75,7 +124,7 @@ namespace yasli {
        void init_fill(size_type n, const T& value, const Allocator& a)
        {
            // Will avoid catch (...)
-           vector<T, Allocator> temp(a);
+           vector temp(a);
            temp.insert(temp.end(), n, value);
            init_move(temp);
            assert(size() == n);
@@ -125,21 +174,22 @@ namespace yasli {
        }
        
    public:
-       vector(const vector<T,Allocator>& x)
+       vector(const vector& x)
        {
            vector temp(x.begin(), x.end(), x.ebo_);
            init_move(temp);
        }
-   
+
        ~vector()
        {
            yasli_nstd::destroy(ebo_, ebo_.beg_, size());
            const size_type c = capacity();
-           if (c != 0) ebo_.deallocate(ebo_.beg_, c);
+           if (c != 0 && !this->is_inline(ebo_.beg_))
+               ebo_.deallocate(ebo_.beg_, c);
        }
-   
+
        // Note pass by value
-       vector<T,Allocator>& operator=(vector<T,Allocator> temp)
+       vector& operator=(vector temp)
        {
            temp.swap(*this);
            return *this;
@@ -197,12 +247,12 @@ namespace yasli {
            {
                const size_t delta = newSize - size();
                RanIt i = last - delta;
-               copy(first, i, ebo_.beg_);
+               std::copy(first, i, ebo_.beg_);
                insert(end(), i, last);
            }
            else
            {
-               copy(first, last, ebo_.beg_);
+               std::copy(first, last, ebo_.beg_);
                resize(newSize);
            }
            assert(size() == newSize);
@@ -214,7 +264,7 @@ namespace yasli {
            if (n <= s)
            {
                T* const newEnd = ebo_.beg_ + n;
-               fill(ebo_.beg_, newEnd, u);
+               std::fill(ebo_.beg_, newEnd, u);
                yasli_nstd::destroy(ebo_, newEnd, s - n);
                end_ = newEnd;
            }
@@ -222,7 +272,7 @@ namespace yasli {
            {
                reserve(n);
                T* const newEnd = ebo_.beg_ + n;
-               fill(ebo_.beg_, end_, u);
+               std::fill(ebo_.beg_, end_, u);
                uninitialized_fill(end_, newEnd, u);
                end_ = newEnd;
            }
@@ -264,6 +314,29 @@ namespace yasli {
            }
            assert(size() == sz);
        }
+       // Grows without writing the new elements when the traits say T
+       // is memcopyable, so staging buffers the caller immediately
+       // overwrites pay for one pass over memory instead of two; the
+       // new elements hold indeterminate values until assigned. Class
+       // types get a plain value-initializing resize.
+       void resize_uninitialized_nstd(size_type sz)
+       {
+           const size_type oldSz = size();
+           if (oldSz >= sz)
+           {
+               erase(ebo_.beg_ + sz, end_);
+           }
+           else if (yasli_nstd::is_memcopyable<T>::value)
+           {
+               reserve(sz);
+               end_ = ebo_.beg_ + sz;
+           }
+           else
+           {
+               resize(sz);
+           }
+           assert(size() == sz);
+       }
    private:
        template<class is>
        void resize_impl(size_type sz, T c)
@@ -288,6 +361,15 @@ namespace yasli {
            {
                ebo_.beg_ = ebo_.allocate(n);
            }
+           else if (this->is_inline(ebo_.beg_))
+           {
+               // the inline buffer is not the allocator's to reallocate
+               // or free -- allocate and move out of it
+               T* const p = ebo_.allocate(n);
+               yasli_protocols::move_traits<T>::destructive_move(
+                   ebo_.beg_, end_, p);
+               ebo_.beg_ = p;
+           }
            else
            {
                ebo_.beg_ = yasli_nstd::allocator_traits<Allocator>::reallocate(
@@ -301,6 +383,7 @@ namespace yasli {
        bool reserve_inplace_nstd(size_type n)
        {
            if (capacity() >= n) return true;
+           if (this->is_inline(ebo_.beg_)) return false;
            if (!yasli_nstd::allocator_traits<Allocator>::reallocate_inplace(
                ebo_, ebo_.beg_, n)) 
            {
@@ -309,6 +392,33 @@ namespace yasli {
            eos_ = ebo_.beg_ + n;
            return true;
        }
+       // Adopts an externally provided buffer -- typically an mmap'd
+       // snapshot file -- as the vector's storage, so loading becomes a
+       // map plus page-fault-on-demand instead of a bulk read into
+       // fresh memory. Requires an allocator that understands adoption
+       // (yasli_nstd::adopting_allocator) and a memcopyable T; growth
+       // beyond cap copies the elements out through the normal
+       // reallocation path and leaves the mapping to the caller, who
+       // keeps it alive until owns_buffer_nstd() reports true again.
+       // The first size elements of buf are taken to be live.
+       void adopt_buffer_nstd(T* buf, size_type sz, size_type cap)
+       {
+           assert(yasli_nstd::is_memcopyable<T>::value);
+           assert(buf != 0);
+           assert(sz <= cap);
+           yasli_nstd::destroy(ebo_, ebo_.beg_, size());
+           const size_type c = capacity();
+           if (c != 0 && !this->is_inline(ebo_.beg_))
+               ebo_.deallocate(ebo_.beg_, c);
+           ebo_.adopt(buf);
+           ebo_.beg_ = buf;
+           end_ = buf + sz;
+           eos_ = buf + cap;
+       }
+       bool owns_buffer_nstd() const
+       {
+           return !ebo_.is_adopted(ebo_.beg_);
+       }
        // element access:
        reference operator[](size_type n)
        {
@@ -401,10 +511,11 @@ namespace yasli {
        // 23.2.4.3 modifiers:
        iterator insert(iterator position, const T& x)
        {
-           // @@@ be smarter about this reservation 
-           reserve(size() + 1);
+           // take the offset before growing -- reserve invalidates
+           // position -- and grow geometrically, not by one
            const size_type pos = position - begin();
-           insert(position, (size_type)1, x);
+           if (size() == capacity()) prepare_growth(1);
+           insert(ebo_.beg_ + pos, (size_type)1, x);
            return ebo_.beg_ + pos;
        }
        void insert(iterator position, size_type n, const T& x)
@@ -468,7 +579,9 @@ namespace yasli {
                    FwdIterator i2 = i1;
                    std::advance(i2, &*position + count - end_);//why not i2 = first; advance(i2,count);
                    T* const oldEnd = end_;
-                   end_ = copy(i1, i2, end_);
+                   // the memory past end_ is raw -- construct, don't
+                   // assign
+                   end_ = yasli::uninitialized_copy(i1, i2, end_);
                    assert(end_ == &*position + count);
                    // Step 2: move existing data to the end
                    mt::nondestructive_move(
@@ -477,7 +590,7 @@ namespace yasli {
                        end_);
                    end_ = oldEnd + count;
                    // Step 3: copy in the remaining data
-                   copy(first, i1, position);
+                   std::copy(first, i1, position);
                }
                else // simpler case
                {
@@ -490,12 +603,12 @@ namespace yasli {
                        position,
                        end_ - count,
                        position + count);
-                   copy(first, last, position);
+                   std::copy(first, last, position);
                }
            }
            else
            {
-               vector<T, Allocator> temp(ebo_);
+               vector temp(ebo_);
                temp.reserve(size() + count);
                // The calls below won't cause infinite recursion
                //   because they will fall on the other branch
@@ -524,12 +637,57 @@ namespace yasli {
            end_ -= destroyed;
            return first;
        }
-       void swap(vector<T,Allocator>& rhs)//COULD DO THIS WITH LESS TEMPORARIES
+       void swap(vector& rhs)//COULD DO THIS WITH LESS TEMPORARIES
        {
            std::swap(static_cast<Allocator&>(ebo_), static_cast<Allocator&>(rhs.ebo_));
-           std::swap(ebo_.beg_, rhs.ebo_.beg_);
-           std::swap(end_, rhs.end_);
-           std::swap(eos_, rhs.eos_);
+           const bool thisInline = this->is_inline(ebo_.beg_);
+           const bool rhsInline = rhs.is_inline(rhs.ebo_.beg_);
+           if (!thisInline && !rhsInline)
+           {
+               std::swap(ebo_.beg_, rhs.ebo_.beg_);
+               std::swap(end_, rhs.end_);
+               std::swap(eos_, rhs.eos_);
+               return;
+           }
+           // A buffer living inside either object cannot change owners,
+           // so its elements move into the peer's inline room instead
+           // (both objects have one of the same capacity)
+           typedef yasli_protocols::move_traits<T> mt;
+           if (thisInline && rhsInline)
+           {
+               inline_store tmp;
+               const size_type ls = size(), rs = rhs.size();
+               mt::destructive_move(ebo_.beg_, end_, tmp.inline_begin());
+               mt::destructive_move(rhs.ebo_.beg_, rhs.end_,
+                   this->inline_begin());
+               mt::destructive_move(tmp.inline_begin(),
+                   tmp.inline_begin() + ls, rhs.inline_begin());
+               end_ = ebo_.beg_ + rs;
+               rhs.end_ = rhs.ebo_.beg_ + ls;
+               return;
+           }
+           if (thisInline)
+           {
+               const size_type ls = size();
+               mt::destructive_move(ebo_.beg_, end_, rhs.inline_begin());
+               ebo_.beg_ = rhs.ebo_.beg_;
+               end_ = rhs.end_;
+               eos_ = rhs.eos_;
+               rhs.ebo_.beg_ = rhs.inline_begin();
+               rhs.end_ = rhs.ebo_.beg_ + ls;
+               rhs.eos_ = rhs.ebo_.beg_ + inline_store::inline_capacity;
+               return;
+           }
+           // rhs is the inline one
+           const size_type rs = rhs.size();
+           mt::destructive_move(rhs.ebo_.beg_, rhs.end_,
+               this->inline_begin());
+           rhs.ebo_.beg_ = ebo_.beg_;
+           rhs.end_ = end_;
+           rhs.eos_ = eos_;
+           ebo_.beg_ = this->inline_begin();
+           end_ = ebo_.beg_ + rs;
+           eos_ = ebo_.beg_ + inline_store::inline_capacity;
        }
        void clear()
        {
@@ -541,27 +699,27 @@ namespace yasli {
    
    
    
-   template <class T, class Allocator>
-   bool operator==(const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
-   template <class T, class Allocator>
-   bool operator< (const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
-   template <class T, class Allocator>
-   bool operator!=(const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
-   template <class T, class Allocator>
-   bool operator> (const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
-   template <class T, class Allocator>
-   bool operator>=(const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
-   template <class T, class Allocator>
-   bool operator<=(const vector<T,Allocator>& x,
-                   const vector<T,Allocator>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator==(const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator< (const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator!=(const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator> (const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator>=(const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
+   template <class T, class Allocator, unsigned int n>
+   bool operator<=(const vector<T,Allocator,n>& x,
+                   const vector<T,Allocator,n>& y);
    // specialized algorithms:
-   template <class T, class Allocator>
-   void swap(vector<T,Allocator>& x, vector<T,Allocator>& y);
+   template <class T, class Allocator, unsigned int n>
+   void swap(vector<T,Allocator,n>& x, vector<T,Allocator,n>& y);
    
 }//yasli
 
@@ -569,15 +727,19 @@ namespace yasli {
 
 namespace yasli_protocols
 {         
-    template <class T, class A>
-    struct move_traits< yasli::vector<T, A> >:public 
+    // A plain vector is three pointers into the heap and can be
+    // relocated bitwise; one with inline storage points into itself
+    // and must take the safe path
+    template <class T, class A, unsigned int n>
+    struct move_traits< yasli::vector<T, A, n> >:public 
     yasli_nstd::type_selector<
-                    sizeof(yasli::vector<T, A>) != (3 * sizeof(T*)),
-                    memmove_traits< std::complex<T> >,
-                    safe_move_traits< std::complex<T> >
+                    n == 0 &&
+                    sizeof(yasli::vector<T, A, n>) == (3 * sizeof(T*)),
+                    memmove_traits< yasli::vector<T, A, n> >,
+                    safe_move_traits< yasli::vector<T, A, n> >
              >::result 
     {
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -26,6 +26,11 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <map>
+
+#if !defined( _MSC_VER )
+    #include <sys/time.h> // declares gettimeofday
+#endif
 
 
 using namespace ::std;
@@ -39,11 +44,72 @@ LOKI_THREAD_LOCAL volatile ::Loki::LevelMutexInfo * ::Loki::LevelMutexInfo::s_cu
 
 unsigned int ::Loki::MutexSleepWaits::sleepTime = 1;
 
+::Loki::MutexStats * ::Loki::MutexStats::s_head = nullptr;
+
 
 /// Anonymous namespace hides some functions which are implementation details.
 namespace
 {
 
+// ----------------------------------------------------------------------------
+
+/** @class StatsRegistryLock
+ Wraps the platform mutex guarding the registry of MutexStats objects.
+ Accessed through GetStatsRegistryLock so a global instrumented mutex
+ constructed before main still finds an initialized lock.
+ */
+class StatsRegistryLock
+{
+public:
+    StatsRegistryLock( void )
+    {
+#if defined( _MSC_VER )
+        ::InitializeCriticalSection( &m_lock );
+#else
+        ::pthread_mutex_init( &m_lock, 0 );
+#endif
+    }
+    ~StatsRegistryLock( void )
+    {
+#if defined( _MSC_VER )
+        ::DeleteCriticalSection( &m_lock );
+#else
+        ::pthread_mutex_destroy( &m_lock );
+#endif
+    }
+    void Lock( void )
+    {
+#if defined( _MSC_VER )
+        ::EnterCriticalSection( &m_lock );
+#else
+        ::pthread_mutex_lock( &m_lock );
+#endif
+    }
+    void Unlock( void )
+    {
+#if defined( _MSC_VER )
+        ::LeaveCriticalSection( &m_lock );
+#else
+        ::pthread_mutex_unlock( &m_lock );
+#endif
+    }
+private:
+    StatsRegistryLock( const StatsRegistryLock & );
+    StatsRegistryLock & operator = ( const StatsRegistryLock & );
+#if defined( _MSC_VER )
+    CRITICAL_SECTION m_lock;
+#else
+    pthread_mutex_t m_lock;
+#endif
+};
+
+StatsRegistryLock & GetStatsRegistryLock( void )
+{
+    static StatsRegistryLock lock;
+    return lock;
+}
+
+
 // ----------------------------------------------------------------------------
 
 /** Determines if the mutex at specific iterator location is unique within the
@@ -119,6 +185,64 @@ unsigned int GetLevel( const ::Loki::LevelMutexInfo::MutexContainer & mutexes )
 
 // ----------------------------------------------------------------------------
 
+/** @struct SharedLockRecord
+ One shared (reader) lock held by the calling thread.  The thread-local
+ array of these forms the stack maintained by SharedLevelTracker.  A plain
+ array is used instead of a linked list through the mutexes themselves since
+ many threads hold the same mutex shared at once, so the mutex can not store
+ a per-owner back-pointer the way LevelMutexInfo does for exclusive locks.
+ */
+struct SharedLockRecord
+{
+    /// Mutex held shared by the calling thread.
+    const volatile ::Loki::LevelMutexInfo * m_mutex;
+    /// Level of that mutex, kept here so level checks need not touch it.
+    unsigned int m_level;
+    /// Number of times the thread re-acquired this shared lock.
+    unsigned int m_count;
+};
+
+/// Stack of shared locks held by the calling thread - most recent on top.
+LOKI_THREAD_LOCAL SharedLockRecord s_sharedLocks[ ::Loki::SharedLevelTracker::MaxSharedLocks ];
+
+/// Number of elements of s_sharedLocks in use by the calling thread.
+LOKI_THREAD_LOCAL unsigned int s_sharedLockCount = 0;
+
+// ----------------------------------------------------------------------------
+
+typedef ::std::map< unsigned int, ::Loki::HybridLevelMutex::WaitPolicy >
+    LevelWaitPolicyMap;
+
+/** Provides the table of per-level wait policies consulted by constructors of
+ HybridLevelMutex.  A function-local static so a global hybrid mutex
+ constructed during static initialization still finds an initialized table.
+ */
+LevelWaitPolicyMap & GetLevelWaitPolicies( void )
+{
+    static LevelWaitPolicyMap policies;
+    return policies;
+}
+
+// ----------------------------------------------------------------------------
+
+/** Executes the processor's pause hint, which tells the core a spin-wait is
+ in progress so it releases pipeline resources to the other hyperthread and
+ leaves the wait loop faster when the awaited store arrives.  A quiet no-op
+ on processors without such a hint.
+ */
+inline void SpinPauseHint( void )
+{
+#if defined( _MSC_VER )
+    ::YieldProcessor();
+#elif defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+    __asm__ __volatile__ ( "pause" );
+#elif defined( __GNUC__ ) && ( defined( __arm__ ) || defined( __aarch64__ ) )
+    __asm__ __volatile__ ( "yield" );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
 } // end anonymous namespace
 
 namespace Loki
@@ -129,7 +253,12 @@ namespace Loki
 unsigned int GetCurrentThreadsLevel( void )
 {
     const volatile LevelMutexInfo * mutex = LevelMutexInfo::GetCurrentMutex();
-    return ( nullptr == mutex ) ? LevelMutexInfo::UnlockedLevel : mutex->GetLevel();
+    const unsigned int exclusiveLevel =
+        ( nullptr == mutex ) ? LevelMutexInfo::UnlockedLevel : mutex->GetLevel();
+    const unsigned int sharedLevel = SharedLevelTracker::GetLevel();
+    // Both lock kinds count towards the thread's current level, so the
+    // level-ordering checks can't be sidestepped by mixing them.
+    return ( sharedLevel < exclusiveLevel ) ? sharedLevel : exclusiveLevel;
 }
 
 // ----------------------------------------------------------------------------
@@ -774,7 +903,12 @@ void MutexSleepWaits::Wait( void )
 #if defined( _MSC_VER )
     ::SleepEx( sleepTime, true );
 #else
-    ::sleep( sleepTime );
+    // sleepTime is in milli-seconds; ::sleep rounds everything up to whole
+    // seconds, which is far longer than any reasonable re-check interval.
+    timespec moment;
+    moment.tv_sec = sleepTime / 1000;
+    moment.tv_nsec = ( sleepTime % 1000 ) * 1000000;
+    ::nanosleep( &moment, 0 );
 #endif
 }
 
@@ -905,9 +1039,16 @@ MutexErrors::Type SpinLevelMutex::Unlock( void ) volatile
 
 SleepLevelMutex::SleepLevelMutex( unsigned int level ) :
     SpinLevelMutex( level ),
-    m_sleepTime( 1 ),
-    m_wakable( true )
+    m_wakable( true ),
+    m_event( 0 ),
+    m_waiters( 0 ),
+    m_sleepTime( 1 )
 {
+    // Auto-reset event: each SetEvent releases exactly one waiter.
+    m_event = ::CreateEvent( 0, FALSE, FALSE, 0 );
+    if ( 0 == m_event )
+        throw MutexException( "unable to create event for mutex!",
+            level, MutexErrors::NotInitialized );
 }
 
 // ----------------------------------------------------------------------------
@@ -916,10 +1057,24 @@ SleepLevelMutex::SleepLevelMutex( unsigned int level ) :
 
 SleepLevelMutex::SleepLevelMutex( unsigned int level, unsigned int sleepTime ) :
     SpinLevelMutex( level ),
-    m_sleepTime( sleepTime / 1000 )
+    m_waitMutex(),
+    m_waitCondition(),
+    m_waiters( 0 ),
+    m_sleepTime( sleepTime )
 {
     if ( 0 == m_sleepTime )
-        m_sleepTime = 1; // Can't have a resolution less than 1 second.
+        m_sleepTime = 1; // Can't wait for less than 1 milli-second.
+    int result = ::pthread_mutex_init( &m_waitMutex, 0 );
+    if ( 0 != result )
+        throw MutexException( "pthread wait mutex not initialized properly!",
+            level, MutexErrors::NotInitialized );
+    result = ::pthread_cond_init( &m_waitCondition, 0 );
+    if ( 0 != result )
+    {
+        ::pthread_mutex_destroy( &m_waitMutex );
+        throw MutexException( "pthread condition not initialized properly!",
+            level, MutexErrors::NotInitialized );
+    }
 }
 
 #endif
@@ -928,29 +1083,658 @@ SleepLevelMutex::SleepLevelMutex( unsigned int level, unsigned int sleepTime ) :
 
 SleepLevelMutex::~SleepLevelMutex( void )
 {
+#if defined( _MSC_VER )
+    ::CloseHandle( m_event );
+#else
+    ::pthread_cond_destroy( &m_waitCondition );
+    ::pthread_mutex_destroy( &m_waitMutex );
+#endif
 }
 
 // ----------------------------------------------------------------------------
 
 MutexErrors::Type SleepLevelMutex::Lock( void ) volatile
 {
-    bool locked = false;
-    while ( !locked )
+    if ( MutexErrors::Success == TryLock() )
+        return MutexErrors::Success;
+    // Have to cast away volatile since the wait primitives do not use the
+    // volatile qualifier.
+    SleepLevelMutex * pThis = const_cast< SleepLevelMutex * >( this );
+#if defined( _MSC_VER )
+    for ( ;; )
     {
-        locked = ( MutexErrors::Success == TryLock() );
-        if ( locked )
+        ::InterlockedIncrement( &pThis->m_waiters );
+        if ( MutexErrors::Success == TryLock() )
+        {
+            ::InterlockedDecrement( &pThis->m_waiters );
             break;
+        }
+        // The timeout only bounds the window in which an unlock could slip
+        // between the failed TryLock and this wait; the usual exit is the
+        // event Unlock signals.
+        ::WaitForSingleObjectEx( pThis->m_event, pThis->m_sleepTime,
+            pThis->m_wakable );
+        ::InterlockedDecrement( &pThis->m_waiters );
+    }
+#else
+    ::pthread_mutex_lock( &pThis->m_waitMutex );
+    ++( pThis->m_waiters );
+    while ( MutexErrors::Success != TryLock() )
+    {
+        /* No unlock can get lost: Unlock acquires m_waitMutex before it
+         reads the waiter count, so it cannot signal between the failed
+         TryLock above and the wait below.  The timeout is plain caution.
+         */
+        timespec until;
+#if defined( CLOCK_REALTIME )
+        ::clock_gettime( CLOCK_REALTIME, &until );
+#else
+        until.tv_sec = ::time( 0 );
+        until.tv_nsec = 0;
+#endif
+        until.tv_sec += pThis->m_sleepTime / 1000;
+        until.tv_nsec += ( pThis->m_sleepTime % 1000 ) * 1000000;
+        if ( 1000000000 <= until.tv_nsec )
+        {
+            until.tv_nsec -= 1000000000;
+            ++until.tv_sec;
+        }
+        ::pthread_cond_timedwait( &pThis->m_waitCondition,
+            &pThis->m_waitMutex, &until );
+    }
+    --( pThis->m_waiters );
+    ::pthread_mutex_unlock( &pThis->m_waitMutex );
+#endif
+    return MutexErrors::Success;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type SleepLevelMutex::Unlock( void ) volatile
+{
+    const MutexErrors::Type result = SpinLevelMutex::Unlock();
+    // Have to cast away volatile since the wait primitives do not use the
+    // volatile qualifier.
+    SleepLevelMutex * pThis = const_cast< SleepLevelMutex * >( this );
 #if defined( _MSC_VER )
-        ::SleepEx( m_sleepTime, m_wakable );
+    if ( 0 != pThis->m_waiters )
+        ::SetEvent( pThis->m_event );
 #else
-        ::sleep( m_sleepTime );
+    ::pthread_mutex_lock( &pThis->m_waitMutex );
+    const bool anyWaiters = ( 0 != pThis->m_waiters );
+    ::pthread_mutex_unlock( &pThis->m_waitMutex );
+    if ( anyWaiters )
+        ::pthread_cond_signal( &pThis->m_waitCondition );
 #endif
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::WaitPolicy::WaitPolicy( void ) :
+    spinCount( 64 ),
+    backoffBase( 1 ),
+    backoffCap( 64 ),
+    usePause( true )
+{
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::WaitPolicy::WaitPolicy( unsigned int spins,
+    unsigned int base, unsigned int cap, bool pause ) :
+    spinCount( spins ),
+    backoffBase( base ),
+    backoffCap( cap ),
+    usePause( pause )
+{
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::HybridLevelMutex( unsigned int level ) :
+#if defined( _MSC_VER )
+    SleepLevelMutex( level ),
+#else
+    SleepLevelMutex( level, 1 ),
+#endif
+    m_spinCount( 0 ),
+    m_backoffBase( 0 ),
+    m_backoffCap( 0 ),
+    m_usePause( false )
+{
+    SetWaitPolicy( GetLevelWaitPolicy( level ) );
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::HybridLevelMutex( unsigned int level,
+    const WaitPolicy & policy ) :
+#if defined( _MSC_VER )
+    SleepLevelMutex( level ),
+#else
+    SleepLevelMutex( level, 1 ),
+#endif
+    m_spinCount( 0 ),
+    m_backoffBase( 0 ),
+    m_backoffCap( 0 ),
+    m_usePause( false )
+{
+    SetWaitPolicy( policy );
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::~HybridLevelMutex( void )
+{
+}
+
+// ----------------------------------------------------------------------------
+
+void HybridLevelMutex::SetWaitPolicy( const WaitPolicy & policy ) volatile
+{
+    m_spinCount = policy.spinCount;
+    m_backoffBase = policy.backoffBase;
+    // A cap below the base would make the very first delay overshoot it, so
+    // raise the cap to the base rather than guess which one was meant.
+    m_backoffCap = ( policy.backoffCap < policy.backoffBase ) ?
+        policy.backoffBase : policy.backoffCap;
+    m_usePause = policy.usePause;
+}
+
+// ----------------------------------------------------------------------------
+
+void HybridLevelMutex::SetLevelWaitPolicy( unsigned int level,
+    const WaitPolicy & policy )
+{
+    GetLevelWaitPolicies()[ level ] = policy;
+}
+
+// ----------------------------------------------------------------------------
+
+HybridLevelMutex::WaitPolicy HybridLevelMutex::GetLevelWaitPolicy(
+    unsigned int level )
+{
+    const LevelWaitPolicyMap & policies = GetLevelWaitPolicies();
+    const LevelWaitPolicyMap::const_iterator it = policies.find( level );
+    return ( policies.end() == it ) ? WaitPolicy() : it->second;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type HybridLevelMutex::Lock( void ) volatile
+{
+    if ( MutexErrors::Success == TryLock() )
+        return MutexErrors::Success;
+    // Read the policy once so a concurrent SetWaitPolicy cannot change the
+    // shape of the wait mid-loop.
+    const HybridLevelMutex * pThis =
+        const_cast< const HybridLevelMutex * >( this );
+    const unsigned int spinCount = pThis->m_spinCount;
+    const unsigned int backoffCap = pThis->m_backoffCap;
+    const bool usePause = pThis->m_usePause;
+    unsigned int backoff = pThis->m_backoffBase;
+    for ( unsigned int attempt = 0; attempt < spinCount; ++attempt )
+    {
+        // The volatile counter keeps the delay loop from being optimized
+        // away when the pause hint is unavailable or switched off.
+        for ( volatile unsigned int delay = 0; delay < backoff; ++delay )
+        {
+            if ( usePause )
+                SpinPauseHint();
+        }
+        if ( MutexErrors::Success == TryLock() )
+            return MutexErrors::Success;
+        /* Double the delay so colliding threads spread their retries apart
+         instead of hammering the lock line in step, but never past the cap
+         that bounds the latency of any one spin round.
+         */
+        if ( backoff < backoffCap )
+        {
+            backoff = ( 0 == backoff ) ? 1 : backoff * 2;
+            if ( backoffCap < backoff )
+                backoff = backoffCap;
+        }
     }
+    // The spin budget is spent, so the holder is probably keeping the mutex
+    // longer than spinning is worth; park until it signals the release.
+    return SleepLevelMutex::Lock();
+}
+
+// ----------------------------------------------------------------------------
+
+ReadWriteLevelMutex::ReadWriteLevelMutex( unsigned int level ) :
+    m_mutex(),
+    m_level( level )
+{
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        ::InitializeSRWLock( &m_mutex );
+    #else
+        ::InitializeCriticalSection( &m_mutex );
+    #endif
+#else
+    const int result = ::pthread_rwlock_init( &m_mutex, 0 );
+    switch ( result )
+    {
+        case 0:
+            return;
+        case EBUSY:
+            throw MutexException( "pthread rwlock already initialized!",
+                level, MutexErrors::AlreadyInitialized );
+        default:
+        case EINVAL:
+            throw MutexException( "pthread rwlock has an invalid attribute!",
+                level, MutexErrors::InvalidAttribute );
+        case EFAULT:
+            throw MutexException( "pthread rwlock has an invalid address!",
+                level, MutexErrors::InvalidAddress );
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ReadWriteLevelMutex::~ReadWriteLevelMutex( void )
+{
+    try
+    {
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        // Slim reader/writer locks need no cleanup.
+    #else
+        ::DeleteCriticalSection( &m_mutex );
+    #endif
+#else
+        ::pthread_rwlock_destroy( &m_mutex );
+#endif
+    }
+    catch ( ... )
+    {
+        // Not much we can do after catching an exception inside a destructor!
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::Lock( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        ::AcquireSRWLockExclusive( &pThis->m_mutex );
+    #else
+        ::EnterCriticalSection( &pThis->m_mutex );
+    #endif
+#else
+    const int result = ::pthread_rwlock_wrlock( &pThis->m_mutex );
+    switch ( result )
+    {
+        case 0:
+            break;
+        default:
+        case EINVAL:
+            throw MutexException( "pthread rwlock not initialized properly!",
+                GetLevel(), MutexErrors::NotInitialized );
+        case EDEADLK:
+            throw MutexException( "locking this pthread rwlock may cause a deadlock!",
+                GetLevel(), MutexErrors::MayDeadlock );
+    }
+#endif
+    return MutexErrors::Success;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::TryLock( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        const bool locked = ( 0 != ::TryAcquireSRWLockExclusive( &pThis->m_mutex ) );
+    #else
+        const bool locked = ( 0 != ::TryEnterCriticalSection( &pThis->m_mutex ) );
+    #endif
+    return ( locked ) ? MutexErrors::Success : MutexErrors::TryFailed;
+#else
+    const int result = ::pthread_rwlock_trywrlock( &pThis->m_mutex );
+    switch ( result )
+    {
+        case 0:
+            return MutexErrors::Success;
+        default:
+        case EBUSY:
+            break;
+        case EINVAL:
+            throw MutexException( "pthread rwlock not initialized properly!",
+                GetLevel(), MutexErrors::NotInitialized );
+    }
+    return MutexErrors::TryFailed;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::Unlock( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        ::ReleaseSRWLockExclusive( &pThis->m_mutex );
+    #else
+        ::LeaveCriticalSection( &pThis->m_mutex );
+    #endif
+#else
+    const int result = ::pthread_rwlock_unlock( &pThis->m_mutex );
+    if ( EPERM == result )
+        throw MutexException( "current thread did not lock this pthread rwlock!",
+            GetLevel(), MutexErrors::NotLockedByThread );
+#endif
+    return MutexErrors::Success;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::LockShared( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        ::AcquireSRWLockShared( &pThis->m_mutex );
+    #else
+        ::EnterCriticalSection( &pThis->m_mutex );
+    #endif
+#else
+    const int result = ::pthread_rwlock_rdlock( &pThis->m_mutex );
+    switch ( result )
+    {
+        case 0:
+            break;
+        default:
+        case EINVAL:
+            throw MutexException( "pthread rwlock not initialized properly!",
+                GetLevel(), MutexErrors::NotInitialized );
+        case EAGAIN:
+            throw MutexException( "pthread rwlock reached its share limit!",
+                GetLevel(), MutexErrors::TooMuchRecursion );
+        case EDEADLK:
+            throw MutexException( "locking this pthread rwlock may cause a deadlock!",
+                GetLevel(), MutexErrors::MayDeadlock );
+    }
+#endif
+    return MutexErrors::Success;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::TryLockShared( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        const bool locked = ( 0 != ::TryAcquireSRWLockShared( &pThis->m_mutex ) );
+    #else
+        const bool locked = ( 0 != ::TryEnterCriticalSection( &pThis->m_mutex ) );
+    #endif
+    return ( locked ) ? MutexErrors::Success : MutexErrors::TryFailed;
+#else
+    const int result = ::pthread_rwlock_tryrdlock( &pThis->m_mutex );
+    switch ( result )
+    {
+        case 0:
+            return MutexErrors::Success;
+        default:
+        case EBUSY:
+            break;
+        case EINVAL:
+            throw MutexException( "pthread rwlock not initialized properly!",
+                GetLevel(), MutexErrors::NotInitialized );
+        case EAGAIN:
+            throw MutexException( "pthread rwlock reached its share limit!",
+                GetLevel(), MutexErrors::TooMuchRecursion );
+    }
+    return MutexErrors::TryFailed;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ReadWriteLevelMutex::UnlockShared( void ) volatile
+{
+    // Have to cast away volatile since the platform lock functions do not
+    // use volatile qualifier.
+    ReadWriteLevelMutex * pThis = const_cast< ReadWriteLevelMutex * >( this );
+#if defined( _MSC_VER )
+    #if defined( _WIN32_WINNT ) && ( _WIN32_WINNT >= 0x0601 )
+        ::ReleaseSRWLockShared( &pThis->m_mutex );
+    #else
+        ::LeaveCriticalSection( &pThis->m_mutex );
+    #endif
+#else
+    const int result = ::pthread_rwlock_unlock( &pThis->m_mutex );
+    if ( EPERM == result )
+        throw MutexException( "current thread did not lock this pthread rwlock!",
+            GetLevel(), MutexErrors::NotLockedByThread );
+#endif
     return MutexErrors::Success;
 }
 
 // ----------------------------------------------------------------------------
 
+unsigned int SharedLevelTracker::GetLevel( void )
+{
+    if ( 0 == s_sharedLockCount )
+        return LevelMutexInfo::UnlockedLevel;
+    return s_sharedLocks[ s_sharedLockCount - 1 ].m_level;
+}
+
+// ----------------------------------------------------------------------------
+
+bool SharedLevelTracker::IsSharedByCurrentThread( const volatile LevelMutexInfo * mutex )
+{
+    for ( unsigned int ii = 0; ii < s_sharedLockCount; ++ii )
+    {
+        if ( s_sharedLocks[ ii ].m_mutex == mutex )
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type SharedLevelTracker::PreShareCheck( const volatile LevelMutexInfo * mutex )
+{
+    assert( nullptr != mutex );
+
+    const unsigned int level = mutex->GetLevel();
+    const unsigned int currentLevel = GetCurrentThreadsLevel();
+    if ( currentLevel == level )
+    {
+        // A thread may re-acquire its most recent shared lock, but may not
+        // acquire another mutex at the same level, and may not downgrade an
+        // exclusive lock to a shared one.
+        if ( ( 0 != s_sharedLockCount )
+          && ( s_sharedLocks[ s_sharedLockCount - 1 ].m_mutex == mutex )
+          && ( GetLevel() == currentLevel ) )
+        {
+            s_sharedLocks[ s_sharedLockCount - 1 ].m_count++;
+            return MutexErrors::Success;
+        }
+        return MutexErrors::LevelTooHigh;
+    }
+    if ( currentLevel < level )
+        return MutexErrors::LevelTooHigh;
+    if ( MaxSharedLocks == s_sharedLockCount )
+        return MutexErrors::TooMuchRecursion;
+
+    return MutexErrors::NoProblem;
+}
+
+// ----------------------------------------------------------------------------
+
+void SharedLevelTracker::PostShare( const volatile LevelMutexInfo * mutex )
+{
+    assert( nullptr != mutex );
+    assert( s_sharedLockCount < MaxSharedLocks );
+
+    SharedLockRecord & record = s_sharedLocks[ s_sharedLockCount ];
+    record.m_mutex = mutex;
+    record.m_level = mutex->GetLevel();
+    record.m_count = 1;
+    ++s_sharedLockCount;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type SharedLevelTracker::PreUnshareCheck( const volatile LevelMutexInfo * mutex )
+{
+    assert( nullptr != mutex );
+
+    if ( ( 0 == s_sharedLockCount )
+      || ( s_sharedLocks[ s_sharedLockCount - 1 ].m_mutex != mutex ) )
+    {
+        return ( IsSharedByCurrentThread( mutex ) ) ?
+            MutexErrors::LevelTooHigh : MutexErrors::NotLockedByThread;
+    }
+    // An exclusive lock acquired after this shared lock must be released
+    // first, just as the exclusive chain requires release in reverse order.
+    if ( GetCurrentThreadsLevel() < GetLevel() )
+        return MutexErrors::LevelTooHigh;
+    if ( 1 < s_sharedLocks[ s_sharedLockCount - 1 ].m_count )
+    {
+        s_sharedLocks[ s_sharedLockCount - 1 ].m_count--;
+        return MutexErrors::Success;
+    }
+
+    return MutexErrors::NoProblem;
+}
+
+// ----------------------------------------------------------------------------
+
+void SharedLevelTracker::PostUnshare( void )
+{
+    assert( 0 != s_sharedLockCount );
+    assert( 1 == s_sharedLocks[ s_sharedLockCount - 1 ].m_count );
+
+    --s_sharedLockCount;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexStats::MutexStats( unsigned int level ) :
+    m_level( level ),
+    m_acquireCount( 0 ),
+    m_contendedCount( 0 ),
+    m_totalWaitTime( 0 ),
+    m_totalHoldTime( 0 ),
+    m_maxHoldTime( 0 ),
+    m_lockedAt( 0 ),
+    m_next( nullptr ),
+    m_prev( nullptr )
+{
+    StatsRegistryLock & registryLock = GetStatsRegistryLock();
+    registryLock.Lock();
+    m_next = s_head;
+    if ( nullptr != s_head )
+        s_head->m_prev = this;
+    s_head = this;
+    registryLock.Unlock();
+}
+
+// ----------------------------------------------------------------------------
+
+MutexStats::~MutexStats( void )
+{
+    StatsRegistryLock & registryLock = GetStatsRegistryLock();
+    registryLock.Lock();
+    if ( nullptr != m_prev )
+        m_prev->m_next = m_next;
+    else
+        s_head = m_next;
+    if ( nullptr != m_next )
+        m_next->m_prev = m_prev;
+    registryLock.Unlock();
+}
+
+// ----------------------------------------------------------------------------
+
+unsigned int MutexStats::WalkAll( StatsVisitor visitor, void * data )
+{
+    assert( nullptr != visitor );
+    unsigned int visited = 0;
+    StatsRegistryLock & registryLock = GetStatsRegistryLock();
+    registryLock.Lock();
+    for ( const MutexStats * stats = s_head; nullptr != stats;
+        stats = stats->m_next )
+    {
+        ++visited;
+        if ( !visitor( *stats, data ) )
+            break;
+    }
+    registryLock.Unlock();
+    return visited;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexStats::MicroSeconds MutexStats::Now( void )
+{
+#if defined( _MSC_VER )
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceCounter( &counter );
+    ::QueryPerformanceFrequency( &frequency );
+    return static_cast< MicroSeconds >(
+        counter.QuadPart * 1000000 / frequency.QuadPart );
+#else
+    timeval moment;
+    ::gettimeofday( &moment, 0 );
+    return static_cast< MicroSeconds >( moment.tv_sec ) * 1000000
+        + static_cast< MicroSeconds >( moment.tv_usec );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void MutexStats::RecordAcquire( MicroSeconds waited, bool contended ) volatile
+{
+    // The calling thread holds the associated mutex, which makes it safe to
+    // cast away volatile and update the counters without further locking.
+    MutexStats * pThis = const_cast< MutexStats * >( this );
+    ++pThis->m_acquireCount;
+    if ( contended )
+    {
+        ++pThis->m_contendedCount;
+        pThis->m_totalWaitTime += waited;
+    }
+    pThis->m_lockedAt = Now();
+}
+
+// ----------------------------------------------------------------------------
+
+void MutexStats::RecordRelease( void ) volatile
+{
+    // Called just before the mutex unlocks, so the calling thread still owns
+    // it and the counters need no further locking.
+    MutexStats * pThis = const_cast< MutexStats * >( this );
+    const MicroSeconds held = Now() - pThis->m_lockedAt;
+    pThis->m_totalHoldTime += held;
+    if ( pThis->m_maxHoldTime < held )
+        pThis->m_maxHoldTime = held;
+}
+
+// ----------------------------------------------------------------------------
+
 MutexException::MutexException( const char * message,
     unsigned int level, MutexErrors::Type reason ) :
     m_message( message ),
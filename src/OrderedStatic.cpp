@@ -14,6 +14,7 @@
 
 
 #include <loki/OrderedStatic.h>
+#include <loki/ThreadPool.h>
 #include <limits>
 
 #ifdef min 
@@ -39,7 +40,8 @@ namespace Loki
     
 
         OrderedStaticManagerClass::OrderedStaticManagerClass() :
-                    staticObjects_(),
+                    count_(0),
+                    overflow_(),
                     max_longevity_(std::numeric_limits<unsigned int>::min()),
                     min_longevity_(std::numeric_limits<unsigned int>::max())
         {
@@ -51,29 +53,86 @@ namespace Loki
 
         void OrderedStaticManagerClass::createObjects()
         {
+            const Data* objects = GetObjects();
             for(unsigned int longevity=max_longevity_; longevity>=min_longevity_; longevity--)
             {
-                for(unsigned int i=0; i<staticObjects_.size(); i++)
+                for(unsigned int i=0; i<count_; i++)
                 {
-                    Data cur = staticObjects_.at(i);
+                    Data cur = objects[i];
                     if(cur.longevity==longevity)
                         ( (*cur.object).*cur.creator )();
                 }
             }
         }
 
+        ////////////////////////////////////////////////////////////////////////////////
+        // Helper binding one registered static's creator call, so it can be
+        // handed to a ThreadPool as a Functor<void>.
+        ////////////////////////////////////////////////////////////////////////////////
+        namespace
+        {
+            struct CreateOne
+            {
+                OrderedStaticCreatorFunc* object;
+                OrderedStaticManagerClass::Creator creator;
+                void operator()()
+                {
+                    ( (*object).*creator )();
+                }
+            };
+        }
+
+        void OrderedStaticManagerClass::createObjects(ThreadPool& pool)
+        {
+            const Data* objects = GetObjects();
+            for(unsigned int longevity=max_longevity_; longevity>=min_longevity_; longevity--)
+            {
+                for(unsigned int i=0; i<count_; i++)
+                {
+                    Data cur = objects[i];
+                    if(cur.longevity==longevity)
+                    {
+                        CreateOne create;
+                        create.object = cur.object;
+                        create.creator = cur.creator;
+                        pool.AddTask(ThreadPool::Task(create));
+                    }
+                }
+                // a level must be complete before the next one starts
+                pool.WaitForIdle();
+            }
+        }
+
         void OrderedStaticManagerClass::registerObject(unsigned int l, OrderedStaticCreatorFunc* o,Creator f)
         {
-            staticObjects_.push_back(Data(l,o,f));
+            Data data;
+            data.longevity = l;
+            data.object = o;
+            data.creator = f;
+
+            if(count_<LOKI_ORDERED_STATIC_RESERVE && overflow_.empty())
+            {
+                preallocated_[count_] = data;
+            }
+            else
+            {
+                if(overflow_.empty())
+                {
+                    // buffer full - move everything to the heap in one
+                    // growth step and keep the registry contiguous
+                    overflow_.reserve(2*LOKI_ORDERED_STATIC_RESERVE);
+                    overflow_.assign(preallocated_, preallocated_+count_);
+                }
+                overflow_.push_back(data);
+            }
+            ++count_;
 
             if(l>max_longevity_) max_longevity_=l;
             if(l<min_longevity_) min_longevity_=l;
         }
 
-        OrderedStaticManagerClass::Data::Data(unsigned int l, OrderedStaticCreatorFunc* o, Creator f)
-            : longevity(l), object(o), creator(f)
-        {
-        }
+        OrderedStaticManagerClass::Data
+            OrderedStaticManagerClass::preallocated_[LOKI_ORDERED_STATIC_RESERVE];
 
     }//namespace Private
 
@@ -1,6 +1,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Copyright (c) 2005 by Andrei Alexandrescu
-// Copyright (c) 2006 Peter K�mmel
+// Copyright (c) 2006 Peter K�mmel
 // Permission to use, copy, modify, distribute, and sell this software for any
 //     purpose is hereby granted without fee, provided that the above copyright
 //     notice appear in all copies and that both that copyright notice and this
@@ -15,6 +15,14 @@
 
 #include <loki/SafeFormat.h>
 
+#include <cerrno>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 
 namespace Loki
 {
@@ -41,6 +49,329 @@ namespace Loki
         f.write(from, std::streamsize(to - from));
     }
 
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Shortest round-trip rendering of doubles (the Grisu2 algorithm;
+    // Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+    // with Integers", PLDI 2010). Integer-only: no division by powers of
+    // ten, no arbitrary precision. The digit strings it produces are
+    // guaranteed to parse back to the identical double; in rare cases
+    // they carry one digit more than the true shortest form.
+    ////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+#if defined(_MSC_VER)
+    typedef unsigned __int64 SfU64;
+#define LOKI_SF_U64(x) x##ui64
+#else
+    typedef unsigned long long SfU64;
+#define LOKI_SF_U64(x) x##ULL
+#endif
+
+    struct DiyFp
+    {
+        SfU64 f;
+        int e;
+    };
+
+    const int kDiySignificandSize = 64;
+    const int kDpSignificandSize = 52;
+    const int kDpExponentBias = 0x3FF + kDpSignificandSize;
+    const int kDpMinExponent = -kDpExponentBias;
+    const SfU64 kDpExponentMask = LOKI_SF_U64(0x7FF0000000000000);
+    const SfU64 kDpSignificandMask = LOKI_SF_U64(0x000FFFFFFFFFFFFF);
+    const SfU64 kDpHiddenBit = LOKI_SF_U64(0x0010000000000000);
+
+    DiyFp DiyFpFromDouble(double d)
+    {
+        SfU64 u;
+        memcpy(&u, &d, sizeof u);
+        const SfU64 biasedE = (u & kDpExponentMask) >> kDpSignificandSize;
+        const SfU64 significand = u & kDpSignificandMask;
+        DiyFp r;
+        if (biasedE != 0)
+        {
+            r.f = significand + kDpHiddenBit;
+            r.e = static_cast<int>(biasedE) - kDpExponentBias;
+        }
+        else
+        {
+            r.f = significand;
+            r.e = kDpMinExponent + 1;
+        }
+        return r;
+    }
+
+    DiyFp DiyFpMinus(DiyFp a, DiyFp b)
+    {
+        assert(a.e == b.e && a.f >= b.f);
+        DiyFp r;
+        r.f = a.f - b.f;
+        r.e = a.e;
+        return r;
+    }
+
+    // the upper 64 bits of the 128-bit product, rounded
+    DiyFp DiyFpMultiply(DiyFp a, DiyFp b)
+    {
+        const SfU64 M32 = LOKI_SF_U64(0xFFFFFFFF);
+        const SfU64 aL = a.f & M32, aH = a.f >> 32;
+        const SfU64 bL = b.f & M32, bH = b.f >> 32;
+        const SfU64 m1 = aL * bH, m2 = aH * bL;
+        SfU64 tmp = ((aL * bL) >> 32) + (m1 & M32) + (m2 & M32);
+        tmp += SfU64(1) << 31; // round up the dropped half
+        DiyFp r;
+        r.f = aH * bH + (m1 >> 32) + (m2 >> 32) + (tmp >> 32);
+        r.e = a.e + b.e + 64;
+        return r;
+    }
+
+    DiyFp DiyFpNormalize(DiyFp a)
+    {
+        while ((a.f & (SfU64(1) << (kDiySignificandSize - 1))) == 0)
+        {
+            a.f <<= 1;
+            --a.e;
+        }
+        return a;
+    }
+
+    DiyFp NormalizeBoundary(DiyFp a)
+    {
+        while ((a.f & (kDpHiddenBit << 1)) == 0)
+        {
+            a.f <<= 1;
+            --a.e;
+        }
+        a.f <<= kDiySignificandSize - kDpSignificandSize - 2;
+        a.e -= kDiySignificandSize - kDpSignificandSize - 2;
+        return a;
+    }
+
+    void NormalizedBoundaries(double d, DiyFp* minus, DiyFp* plus)
+    {
+        const DiyFp v = DiyFpFromDouble(d);
+        DiyFp pl, mi;
+        pl.f = (v.f << 1) + 1;
+        pl.e = v.e - 1;
+        pl = NormalizeBoundary(pl);
+        if (v.f == kDpHiddenBit)
+        {
+            // the boundary below a power of two is closer
+            mi.f = (v.f << 2) - 1;
+            mi.e = v.e - 2;
+        }
+        else
+        {
+            mi.f = (v.f << 1) - 1;
+            mi.e = v.e - 1;
+        }
+        mi.f <<= mi.e - pl.e;
+        mi.e = pl.e;
+        *plus = pl;
+        *minus = mi;
+    }
+
+    // 64-bit significands of 10^-348, 10^-340, ..., 10^340, correctly
+    // rounded, with their binary exponents. Generated with exact
+    // integer arithmetic.
+    const SfU64 kCachedPowersF[] = {
+        LOKI_SF_U64(0xfa8fd5a0081c0288), LOKI_SF_U64(0xbaaee17fa23ebf76), LOKI_SF_U64(0x8b16fb203055ac76),
+        LOKI_SF_U64(0xcf42894a5dce35ea), LOKI_SF_U64(0x9a6bb0aa55653b2d), LOKI_SF_U64(0xe61acf033d1a45df),
+        LOKI_SF_U64(0xab70fe17c79ac6ca), LOKI_SF_U64(0xff77b1fcbebcdc4f), LOKI_SF_U64(0xbe5691ef416bd60c),
+        LOKI_SF_U64(0x8dd01fad907ffc3c), LOKI_SF_U64(0xd3515c2831559a83), LOKI_SF_U64(0x9d71ac8fada6c9b5),
+        LOKI_SF_U64(0xea9c227723ee8bcb), LOKI_SF_U64(0xaecc49914078536d), LOKI_SF_U64(0x823c12795db6ce57),
+        LOKI_SF_U64(0xc21094364dfb5637), LOKI_SF_U64(0x9096ea6f3848984f), LOKI_SF_U64(0xd77485cb25823ac7),
+        LOKI_SF_U64(0xa086cfcd97bf97f4), LOKI_SF_U64(0xef340a98172aace5), LOKI_SF_U64(0xb23867fb2a35b28e),
+        LOKI_SF_U64(0x84c8d4dfd2c63f3b), LOKI_SF_U64(0xc5dd44271ad3cdba), LOKI_SF_U64(0x936b9fcebb25c996),
+        LOKI_SF_U64(0xdbac6c247d62a584), LOKI_SF_U64(0xa3ab66580d5fdaf6), LOKI_SF_U64(0xf3e2f893dec3f126),
+        LOKI_SF_U64(0xb5b5ada8aaff80b8), LOKI_SF_U64(0x87625f056c7c4a8b), LOKI_SF_U64(0xc9bcff6034c13053),
+        LOKI_SF_U64(0x964e858c91ba2655), LOKI_SF_U64(0xdff9772470297ebd), LOKI_SF_U64(0xa6dfbd9fb8e5b88f),
+        LOKI_SF_U64(0xf8a95fcf88747d94), LOKI_SF_U64(0xb94470938fa89bcf), LOKI_SF_U64(0x8a08f0f8bf0f156b),
+        LOKI_SF_U64(0xcdb02555653131b6), LOKI_SF_U64(0x993fe2c6d07b7fac), LOKI_SF_U64(0xe45c10c42a2b3b06),
+        LOKI_SF_U64(0xaa242499697392d3), LOKI_SF_U64(0xfd87b5f28300ca0e), LOKI_SF_U64(0xbce5086492111aeb),
+        LOKI_SF_U64(0x8cbccc096f5088cc), LOKI_SF_U64(0xd1b71758e219652c), LOKI_SF_U64(0x9c40000000000000),
+        LOKI_SF_U64(0xe8d4a51000000000), LOKI_SF_U64(0xad78ebc5ac620000), LOKI_SF_U64(0x813f3978f8940984),
+        LOKI_SF_U64(0xc097ce7bc90715b3), LOKI_SF_U64(0x8f7e32ce7bea5c70), LOKI_SF_U64(0xd5d238a4abe98068),
+        LOKI_SF_U64(0x9f4f2726179a2245), LOKI_SF_U64(0xed63a231d4c4fb27), LOKI_SF_U64(0xb0de65388cc8ada8),
+        LOKI_SF_U64(0x83c7088e1aab65db), LOKI_SF_U64(0xc45d1df942711d9a), LOKI_SF_U64(0x924d692ca61be758),
+        LOKI_SF_U64(0xda01ee641a708dea), LOKI_SF_U64(0xa26da3999aef774a), LOKI_SF_U64(0xf209787bb47d6b85),
+        LOKI_SF_U64(0xb454e4a179dd1877), LOKI_SF_U64(0x865b86925b9bc5c2), LOKI_SF_U64(0xc83553c5c8965d3d),
+        LOKI_SF_U64(0x952ab45cfa97a0b3), LOKI_SF_U64(0xde469fbd99a05fe3), LOKI_SF_U64(0xa59bc234db398c25),
+        LOKI_SF_U64(0xf6c69a72a3989f5c), LOKI_SF_U64(0xb7dcbf5354e9bece), LOKI_SF_U64(0x88fcf317f22241e2),
+        LOKI_SF_U64(0xcc20ce9bd35c78a5), LOKI_SF_U64(0x98165af37b2153df), LOKI_SF_U64(0xe2a0b5dc971f303a),
+        LOKI_SF_U64(0xa8d9d1535ce3b396), LOKI_SF_U64(0xfb9b7cd9a4a7443c), LOKI_SF_U64(0xbb764c4ca7a44410),
+        LOKI_SF_U64(0x8bab8eefb6409c1a), LOKI_SF_U64(0xd01fef10a657842c), LOKI_SF_U64(0x9b10a4e5e9913129),
+        LOKI_SF_U64(0xe7109bfba19c0c9d), LOKI_SF_U64(0xac2820d9623bf429), LOKI_SF_U64(0x80444b5e7aa7cf85),
+        LOKI_SF_U64(0xbf21e44003acdd2d), LOKI_SF_U64(0x8e679c2f5e44ff8f), LOKI_SF_U64(0xd433179d9c8cb841),
+        LOKI_SF_U64(0x9e19db92b4e31ba9), LOKI_SF_U64(0xeb96bf6ebadf77d9), LOKI_SF_U64(0xaf87023b9bf0ee6b),
+    };
+
+    const short kCachedPowersE[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034,
+        -1007, -980, -954, -927, -901, -874, -847, -821,
+        -794, -768, -741, -715, -688, -661, -635, -608,
+        -582, -555, -529, -502, -475, -449, -422, -396,
+        -369, -343, -316, -289, -263, -236, -210, -183,
+        -157, -130, -103, -77, -50, -24, 3, 30,
+        56, 83, 109, 136, 162, 189, 216, 242,
+        269, 295, 322, 348, 375, 402, 428, 455,
+        481, 508, 534, 561, 588, 614, 641, 667,
+        694, 720, 747, 774, 800, 827, 853, 880,
+        907, 933, 960, 986, 1013, 1039, 1066,
+    };
+
+    // smallest cached power >= 10^k with the product exponent landing
+    // in [-63, -32]
+    DiyFp GetCachedPower(int e, int* K)
+    {
+        const double dk = (-61 - e) * 0.30102999566398114 + 347;
+        int k = static_cast<int>(dk);
+        if (dk - k > 0.0) ++k;
+        const unsigned index = static_cast<unsigned>((k >> 3) + 1);
+        *K = -(-348 + static_cast<int>(index << 3));
+        assert(index < sizeof(kCachedPowersF) / sizeof(kCachedPowersF[0]));
+        DiyFp r;
+        r.f = kCachedPowersF[index];
+        r.e = kCachedPowersE[index];
+        return r;
+    }
+
+    const unsigned kPow10_32[] = {
+        1, 10, 100, 1000, 10000, 100000,
+        1000000, 10000000, 100000000, 1000000000
+    };
+
+    int CountDecimalDigit32(unsigned n)
+    {
+        int i = 1;
+        while (i < 10 && n >= kPow10_32[i]) ++i;
+        return i;
+    }
+
+    // nudges the last digit towards w (the exact value) while staying
+    // inside the rounding interval
+    void GrisuRound(char* buffer, int len, SfU64 delta, SfU64 rest,
+        SfU64 tenKappa, SfU64 wpW)
+    {
+        while (rest < wpW && delta - rest >= tenKappa &&
+               (rest + tenKappa < wpW ||
+                wpW - rest > rest + tenKappa - wpW))
+        {
+            --buffer[len - 1];
+            rest += tenKappa;
+        }
+    }
+
+    void DigitGen(DiyFp W, DiyFp Mp, SfU64 delta, char* buffer,
+        int* len, int* K)
+    {
+        DiyFp one;
+        one.f = SfU64(1) << -Mp.e;
+        one.e = Mp.e;
+        const DiyFp wpW = DiyFpMinus(Mp, W);
+        unsigned p1 = static_cast<unsigned>(Mp.f >> -one.e);
+        SfU64 p2 = Mp.f & (one.f - 1);
+        int kappa = CountDecimalDigit32(p1);
+        *len = 0;
+        while (kappa > 0)
+        {
+            const unsigned d = p1 / kPow10_32[kappa - 1];
+            p1 %= kPow10_32[kappa - 1];
+            if (d != 0 || *len != 0)
+            {
+                buffer[(*len)++] = static_cast<char>('0' + d);
+            }
+            --kappa;
+            const SfU64 tmp = (SfU64(p1) << -one.e) + p2;
+            if (tmp <= delta)
+            {
+                *K += kappa;
+                GrisuRound(buffer, *len, delta, tmp,
+                    SfU64(kPow10_32[kappa]) << -one.e, wpW.f);
+                return;
+            }
+        }
+        for (;;)
+        {
+            p2 *= 10;
+            delta *= 10;
+            const char d = static_cast<char>(p2 >> -one.e);
+            if (d != 0 || *len != 0)
+            {
+                buffer[(*len)++] = static_cast<char>('0' + d);
+            }
+            p2 &= one.f - 1;
+            --kappa;
+            if (p2 < delta)
+            {
+                *K += kappa;
+                // beyond the table the scaled boundary would overflow
+                // 64 bits anyway; 0 just skips the nudge
+                GrisuRound(buffer, *len, delta, p2, one.f,
+                    -kappa < 10 ? wpW.f * kPow10_32[-kappa] : 0);
+                return;
+            }
+        }
+    }
+
+} // anonymous namespace
+
+    int RenderDoubleShortest(double value, char* digits, int& decimalExponent)
+    {
+        assert(value > 0.0);
+        const DiyFp v = DiyFpNormalize(DiyFpFromDouble(value));
+        DiyFp wM, wP;
+        NormalizedBoundaries(value, &wM, &wP);
+        int K;
+        const DiyFp cMk = GetCachedPower(wP.e, &K);
+        const DiyFp W = DiyFpMultiply(v, cMk);
+        DiyFp Wp = DiyFpMultiply(wP, cMk);
+        DiyFp Wm = DiyFpMultiply(wM, cMk);
+        // shrink the interval by one ulp on each side so any digit
+        // string inside it is safe to emit
+        ++Wm.f;
+        --Wp.f;
+        int length = 0;
+        DigitGen(W, Wp, Wp.f - Wm.f, digits, &length, &K);
+        decimalExponent = K;
+        return length;
+    }
+
+    // Write to a buffered file descriptor sink
+
+    void write(BufferedSink& sink, const char* from, const char* to) {
+        assert(from <= to);
+        sink.Append(from, to);
+    }
+
+    void BufferedSink::WriteFd(const char* b, std::size_t n) {
+        while (n > 0 && good_) {
+#if defined(_WIN32) || defined(_WIN64)
+            const int written = ::_write(fd_, b, static_cast<unsigned int>(n));
+#else
+            const ssize_t written = ::write(fd_, b, n);
+#endif
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                good_ = false;
+                return;
+            }
+            b += written;
+            n -= static_cast<std::size_t>(written);
+        }
+    }
+
+    bool BufferedSink::Flush() {
+        if (used_ != 0) {
+            WriteFd(buffer_, used_);
+            used_ = 0;
+        }
+        return good_;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     // PrintfState class template
     // Holds the formatting state, and implements operator() to format stuff
@@ -72,6 +403,14 @@ namespace Loki
         return PrintfState<std::ostream&, char>(f, format.c_str());
     }
 
+    PrintfState<BufferedSink&, char> FPrintf(BufferedSink& sink, const char* format) {
+        return PrintfState<BufferedSink&, char>(sink, format);
+    }
+
+    PrintfState<BufferedSink&, char> FPrintf(BufferedSink& sink, const std::string& format) {
+        return PrintfState<BufferedSink&, char>(sink, format.c_str());
+    }
+
     PrintfState<std::string&, char> SPrintf(std::string& s, const char* format) {
         return PrintfState<std::string&, char>(s, format);
     }
@@ -80,6 +419,25 @@ namespace Loki
         return PrintfState<std::string&, char>(s, format.c_str());
     }
 
+    PrintfState<std::pair<char*, std::size_t>, char>
+    SPrintf(char* buffer, std::size_t size, const char* format) {
+        const std::pair<char*, std::size_t> span(buffer, size);
+        return PrintfState<std::pair<char*, std::size_t>, char>(span, format);
+    }
+
+    PrintfState<std::pair<char*, std::size_t>, char>
+    SPrintf(char* buffer, std::size_t size, const std::string& format) {
+        return SPrintf(buffer, size, format.c_str());
+    }
+
+    PrintfState<CountingDevice, char> CountPrintf(const char* format) {
+        return PrintfState<CountingDevice, char>(CountingDevice(), format);
+    }
+
+    PrintfState<CountingDevice, char> CountPrintf(const std::string& format) {
+        return PrintfState<CountingDevice, char>(CountingDevice(), format.c_str());
+    }
+
 
 } // end namespace Loki
 
@@ -21,6 +21,7 @@
 
 #ifdef LOKI_ENABLE_NEW_SETLONGLIVITY_HELPER_DATA_IMPL
 Loki::Private::TrackerArray* Loki::Private::pTrackerArray = 0;
+unsigned int Loki::Private::trackerSeq = 0;
 #else
 Loki::Private::TrackerArray Loki::Private::pTrackerArray = 0;
 unsigned int Loki::Private::elements = 0;
@@ -33,24 +34,103 @@ unsigned int Loki::Private::elements = 0;
 
 #ifdef LOKI_ENABLE_NEW_SETLONGLIVITY_HELPER_DATA_IMPL
 
+////////////////////////////////////////////////////////////////////////////////
+// Pool for LifetimeTracker objects
+// Slots are carved out of chunks, so a longevity registration costs no heap
+// allocation of its own; one chunk serves trackersPerChunk registrations.
+// Freed slots go on a free list for reuse by phoenix singletons which
+// re-register during program exit.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    union TrackerSlot
+    {
+        TrackerSlot* pNext;
+        double forAlignment;
+        char storage[ 6 * sizeof(void*) ];
+    };
+
+    const unsigned int trackersPerChunk = 256;
+
+    struct TrackerChunk
+    {
+        TrackerChunk* pNext;
+        TrackerSlot slots[ trackersPerChunk ];
+    };
+
+    TrackerChunk* pChunkList = 0;
+    TrackerSlot* pFreeList = 0;
+    unsigned int slotsUsed = trackersPerChunk;
+
+    void ReleaseTrackerPool()
+    {
+        while (pChunkList != 0)
+        {
+            TrackerChunk* pChunk = pChunkList;
+            pChunkList = pChunkList->pNext;
+            ::operator delete(pChunk);
+        }
+        pFreeList = 0;
+        slotsUsed = trackersPerChunk;
+    }
+}
+
+void* Loki::Private::LifetimeTracker::operator new(std::size_t size)
+{
+    if (size > sizeof(TrackerSlot().storage))
+        return ::operator new(size);
+    if (pFreeList != 0)
+    {
+        TrackerSlot* pSlot = pFreeList;
+        pFreeList = pFreeList->pNext;
+        return pSlot->storage;
+    }
+    if (slotsUsed == trackersPerChunk)
+    {
+        TrackerChunk* pChunk = static_cast<TrackerChunk*>(
+            ::operator new(sizeof(TrackerChunk)));
+        pChunk->pNext = pChunkList;
+        pChunkList = pChunk;
+        slotsUsed = 0;
+    }
+    return pChunkList->slots[slotsUsed++].storage;
+}
+
+void Loki::Private::LifetimeTracker::operator delete(void* p, std::size_t size)
+{
+    if (p == 0)
+        return;
+    if (size > sizeof(TrackerSlot().storage))
+    {
+        ::operator delete(p);
+        return;
+    }
+    TrackerSlot* pSlot = reinterpret_cast<TrackerSlot*>(p);
+    pSlot->pNext = pFreeList;
+    pFreeList = pSlot;
+}
+
 void LOKI_C_CALLING_CONVENTION_QUALIFIER Loki::Private::AtExitFn()
 {
     assert(pTrackerArray!=0 && !pTrackerArray->empty());
     
-    // Pick the element at the top of the stack
-    LifetimeTracker* pTop = pTrackerArray->back();
+    // Move the top of the heap - the next object to destroy - to the back
+    std::pop_heap(pTrackerArray->begin(), pTrackerArray->end());
+    LifetimeTracker* pTop = pTrackerArray->back().tracker;
     
-    // Remove that object off the stack _before_ deleting pTop
+    // Remove that object off the heap _before_ deleting pTop
     pTrackerArray->pop_back();
     
     // Destroy the element
     delete pTop;
     
-    // Destroy stack when it's empty _after_ deleting pTop
+    // Destroy heap and pool when empty _after_ deleting pTop
     if(pTrackerArray->empty())
     {
         delete pTrackerArray;
         pTrackerArray = 0;
+        ReleaseTrackerPool();
     }
 }
 
@@ -19,9 +19,14 @@
 #include <loki/SmallObj.h>
 
 #include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
 #include <climits>
 #include <vector>
 #include <bitset>
+#include <utility>
+#include <algorithm>
 
 //#define DO_EXTRA_LOKI_TESTS
 //#define USE_NEW_TO_ALLOCATE
@@ -31,9 +36,125 @@
     #include <iostream>
 #endif
 
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+    #if defined( _MSC_VER )
+        #define LOKI_THREAD_LOCAL __declspec( thread )
+    #elif defined( __GNUC__ )
+        #define LOKI_THREAD_LOCAL __thread
+    #else
+        #error "LOKI_SMALL_OBJECT_THREAD_CACHE requires compiler support for thread-local storage."
+    #endif
+    #ifndef LOKI_SMALL_OBJECT_MAGAZINE_SIZE
+        #define LOKI_SMALL_OBJECT_MAGAZINE_SIZE 64
+    #endif
+    // Upper bound on the # of size-classes served by thread magazines.  A
+    // SmallObjAllocator with more FixedAllocator's than this just sends the
+    // extra size-classes through the locked path.
+    #define LOKI_SMALL_OBJECT_MAGAZINE_CLASSES \
+        ( LOKI_MAX_SMALL_OBJECT_SIZE / LOKI_DEFAULT_OBJECT_ALIGNMENT )
+#endif
+
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+    #if !defined( __linux__ )
+        #error "LOKI_SMALL_OBJECT_NUMA_AWARE requires Linux for the getcpu system call."
+    #endif
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+
+#ifdef LOKI_SMALL_OBJECT_USE_MMAP
+    #if defined( _WIN32 )
+        #error "LOKI_SMALL_OBJECT_USE_MMAP requires a POSIX platform."
+    #endif
+    #include <sys/mman.h>
+    #include <pthread.h>
+    #ifndef LOKI_SMALL_OBJECT_REGION_SIZE
+        #ifdef LOKI_SMALL_OBJECT_USE_HUGE_PAGES
+            // One huge page on most Linux configurations.
+            #define LOKI_SMALL_OBJECT_REGION_SIZE ( 2 * 1024 * 1024 )
+        #else
+            #define LOKI_SMALL_OBJECT_REGION_SIZE ( 1024 * 1024 )
+        #endif
+    #endif
+#endif
+
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+    #if defined( _MSC_VER )
+        #include <intrin.h>
+    #elif !defined( __GNUC__ )
+        #error "LOKI_SMALL_OBJECT_ATOMIC_FREELIST requires compiler support for atomic pointer operations."
+    #endif
+#endif
+
 namespace Loki
 {
 
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
+    /// Atomically swaps in newValue at place if place still holds comparand.
+    /// Returns true if the swap happened.  Implies a full memory barrier.
+    inline bool AtomicCompareAndSwapPointer( void * volatile * place,
+        void * comparand, void * newValue )
+    {
+    #if defined( __GNUC__ )
+        return __sync_bool_compare_and_swap( place, comparand, newValue );
+    #else
+        return ( comparand == _InterlockedCompareExchangePointer(
+            place, newValue, comparand ) );
+    #endif
+    }
+
+    /// Atomically stores newValue at place and returns the previous contents.
+    inline void * AtomicExchangePointer( void * volatile * place,
+        void * newValue )
+    {
+    #if defined( __GNUC__ )
+        void * old = __sync_lock_test_and_set( place, newValue );
+        __sync_synchronize();
+        return old;
+    #else
+        return _InterlockedExchangePointer( place, newValue );
+    #endif
+    }
+
+#endif // LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+
+    /** @struct Magazine
+        @ingroup SmallObjectGroupInternal
+     A per-thread cache of blocks for one size-class.  A Magazine holds blocks
+     popped off a FixedAllocator so that a thread can allocate and deallocate
+     without acquiring the allocator's mutex.  Only half of a Magazine is
+     filled or flushed at a time so that a thread alternating between one
+     allocation and one deallocation at the capacity boundary does not acquire
+     the mutex on every call.  All Magazine data is thread-local, so none of
+     its operations require locks.  Blocks still sitting in a Magazine when a
+     thread exits are not returned to the FixedAllocator until the allocator
+     itself is destroyed - which releases all Chunks wholesale anyway.
+
+     Each Magazine remembers which SmallObjAllocator owns its blocks.  If a
+     thread uses two different allocator singletons, only the first one it
+     touches gets cached service for a given size-class; the other one simply
+     falls back to the locked path.  This keeps blocks from different pools
+     from getting mixed into one free list.
+     */
+    struct Magazine
+    {
+        /// Allocator which owns the cached blocks, or NULL if magazine unused.
+        const SmallObjAllocator * owner_;
+        /// Count of cached blocks.
+        std::size_t count_;
+        /// Cached blocks, valid in range [0, count_).
+        void * blocks_[ LOKI_SMALL_OBJECT_MAGAZINE_SIZE ];
+    };
+
+    /// One magazine per size-class for each thread.  Thread-local storage of
+    /// POD types is zero-initialized, which is a valid empty magazine.
+    static LOKI_THREAD_LOCAL Magazine magazines_[ LOKI_SMALL_OBJECT_MAGAZINE_CLASSES ];
+
+#endif // LOKI_SMALL_OBJECT_THREAD_CACHE
+
     /** @struct Chunk
         @ingroup SmallObjectGroupInternal
      Contains info about each allocated Chunk - which is a collection of
@@ -75,9 +196,12 @@ namespace Loki
         /** Initializes a just-constructed Chunk.
          @param blockSize Number of bytes per block.
          @param blocks Number of blocks per Chunk.
+         @param alignment Required address alignment of the Chunk's data in
+          bytes - a power of two - or zero for no particular alignment.
          @return True for success, false for failure.
          */
-        bool Init( std::size_t blockSize, unsigned char blocks );
+        bool Init( std::size_t blockSize, unsigned char blocks,
+            std::size_t alignment );
 
         /** Allocate a block within the Chunk.  Complexity is always O(1), and
          this will never throw.  Does not actually "allocate" by calling
@@ -104,8 +228,11 @@ namespace Loki
          */
         void Reset( std::size_t blockSize, unsigned char blocks );
 
-        /// Releases the allocated block of memory.
-        void Release();
+        /** Releases the allocated block of memory.  The caller passes the
+         total # of bytes and the alignment the Chunk was initialized with
+         since the page source may need those to recycle the Chunk's pages.
+         */
+        void Release( std::size_t chunkLength, std::size_t alignment );
 
         /** Determines if the Chunk has been corrupted.
          @param numBlocks Total # of blocks in the Chunk.
@@ -184,19 +311,37 @@ namespace Loki
          */
         bool MakeNewChunk( void );
 
-        /** Finds the Chunk which owns the block at address p.  It starts at
-         deallocChunk_ and searches in both forwards and backwards directions
-         from there until it finds the Chunk which owns p.  This algorithm
-         should find the Chunk quickly if it is deallocChunk_ or is close to it
-         in the Chunks container.  This goes both forwards and backwards since
-         that works well for both same-order and opposite-order deallocations.
-         (Same-order = objects are deallocated in the same order in which they
-         were allocated.  Opposite order = objects are deallocated in a last to
-         first order.  Complexity is O(C) where C is count of all Chunks.  This
-         never throws.
+        /** Finds the Chunk which owns the block at address p by binary search
+         through the sorted-address index.  Callers should check deallocChunk_
+         first since repeated frees into the same Chunk then cost nothing.
+         Complexity is O(log C) where C is count of all Chunks.  This never
+         throws.
          @return Pointer to Chunk that owns p, or NULL if no owner found.
          */
-        Chunk * VicinityFind( void * p ) const;
+        Chunk * FindChunkByAddress( void * p ) const;
+
+        /** Discards and rebuilds the entire sorted-address index from the
+         Chunks container.  Called whenever the container reallocates, since
+         that moves every Chunk and invalidates all index entries.  Complexity
+         is O(C log C).
+         */
+        void RebuildChunkIndex( void );
+
+        /// Adds a just-created Chunk to the sorted-address index.
+        void InsertChunkIndex( Chunk * chunk );
+
+        /// Removes the entry for the data block at pData before it is released.
+        void RemoveChunkIndex( const unsigned char * pData );
+
+        /** Repoints the index entry for the data block now held by chunk.
+         Called after two Chunks swap contents, once for each Chunk.
+         */
+        void UpdateChunkIndex( Chunk * chunk );
+
+        /// Orders index entries by the address of the Chunk's data block.
+        static bool ChunkIndexLess( const std::pair< unsigned char *, Chunk * > & lhs,
+            const std::pair< unsigned char *, Chunk * > & rhs )
+        { return lhs.first < rhs.first; }
 
         /// Not implemented.
         FixedAllocator(const FixedAllocator&);
@@ -210,6 +355,12 @@ namespace Loki
         /// Iterator through const container of Chunks.
         typedef Chunks::const_iterator ChunkCIter;
 
+        /// One entry of the sorted-address index: data block address of a
+        /// Chunk paired with the Chunk which currently holds that block.
+        typedef std::pair< unsigned char *, Chunk * > ChunkIndexEntry;
+        /// Type of container used for the sorted-address index of Chunks.
+        typedef std::vector< ChunkIndexEntry > ChunkIndex;
+
         /// Fewest # of objects managed by a Chunk.
         static unsigned char MinObjectsPerChunk_;
 
@@ -218,11 +369,19 @@ namespace Loki
 
         /// Number of bytes in a single block within a Chunk.
         std::size_t blockSize_;
+        /// Address alignment of each Chunk's data in bytes, or zero when no
+        /// particular alignment was requested.
+        std::size_t alignment_;
         /// Number of blocks managed by each Chunk.
         unsigned char numBlocks_;
+        /// Most Chunks this may ever own, or zero for no cap.
+        std::size_t maxChunks_;
 
         /// Container of Chunks.
         Chunks chunks_;
+        /// Index of Chunks sorted by data block address, so deallocations
+        /// resolve the owning Chunk by binary search instead of linear scan.
+        ChunkIndex chunkIndex_;
         /// Pointer to Chunk used for last or next allocation.
         Chunk * allocChunk_;
         /// Pointer to Chunk used for last or next deallocation.
@@ -230,15 +389,54 @@ namespace Loki
         /// Pointer to the only empty Chunk if there is one, else NULL.
         Chunk * emptyChunk_;
 
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+        /// Head of atomic singly-linked list of blocks waiting to be
+        /// threaded back into Chunks.  Each pending block stores the pointer
+        /// to the next pending block in its first bytes.
+        void * volatile pendingFrees_;
+#endif
+
+        /// Total # of blocks ever handed out by this FixedAllocator.
+        std::size_t allocCount_;
+        /// Total # of blocks ever returned to this FixedAllocator.
+        std::size_t deallocCount_;
+        /// Most blocks ever simultaneously live.
+        std::size_t highWater_;
+        /// Optional hook fired on every Chunk acquisition and release.
+        ChunkEventCallback chunkCallback_;
+
+        /// Counts one block handed out and pushes the high-water mark.
+        inline void CountAllocation( void )
+        {
+            ++allocCount_;
+            const std::size_t live = allocCount_ - deallocCount_;
+            if ( live > highWater_ )
+                highWater_ = live;
+        }
+
     public:
         /// Create a FixedAllocator which manages blocks of 'blockSize' size.
         FixedAllocator();
 
+        /** Reshapes this FixedAllocator before its first use: recomputes the
+         blocks-per-Chunk from chunkSize, creates reserveChunks Chunks up
+         front, and caps the Chunk count at maxChunks (0 means no cap).
+         @return False if any Chunk exists already, if chunkSize is smaller
+          than the block size, or if the reserve exceeds the cap.
+         */
+        bool Configure( std::size_t chunkSize, std::size_t reserveChunks,
+            std::size_t maxChunks );
+
         /// Destroy the FixedAllocator and release all its Chunks.
         ~FixedAllocator();
 
-        /// Initializes a FixedAllocator by calculating # of blocks per Chunk.
-        void Initialize( std::size_t blockSize, std::size_t pageSize );
+        /** Initializes a FixedAllocator by calculating # of blocks per
+         Chunk.  A nonzero alignment - a power of two - makes every Chunk's
+         data block start on that alignment, so all blocks handed out are
+         themselves aligned since the block size is a multiple of it.
+         */
+        void Initialize( std::size_t blockSize, std::size_t pageSize,
+            std::size_t alignment = 0 );
 
         /** Returns pointer to allocated memory block of fixed size - or NULL
          if it failed to allocate.
@@ -252,6 +450,22 @@ namespace Loki
          */
         bool Deallocate( void * p, Chunk * hint );
 
+        /** Allocates up to count blocks, carving consecutive runs out of the
+         current allocation Chunk so the Chunk search happens once per Chunk
+         instead of once per block.  Complexity is O(N) in the count of blocks
+         plus O(C) for at most one search through the Chunks.  Never throws.
+         @return # of blocks actually allocated - less than count only if the
+          underlying memory allocator is exhausted.
+         */
+        std::size_t AllocateBatch( void ** out, std::size_t count );
+
+        /** Deallocates count blocks.  Each deallocation updates the hint used
+         by VicinityFind, so releasing blocks which live near each other - the
+         common case for batches - costs almost no searching.  Never throws.
+         @return True if all non-NULL blocks were owned by this FixedAllocator.
+         */
+        bool DeallocateBatch( void * const * blocks, std::size_t count );
+
         /// Returns block size with which the FixedAllocator was initialized.
         inline std::size_t BlockSize() const { return blockSize_; }
 
@@ -268,11 +482,38 @@ namespace Loki
          */
         bool TrimChunkList( void );
 
+        /** Releases every Chunk wholesale without touching per-block
+         bookkeeping - the teardown the destructor performs, made callable
+         earlier.  Afterwards the FixedAllocator is in its
+         freshly-initialized empty state, so later allocations simply start
+         new Chunks.  Blocks still live inside the released Chunks dangle;
+         only call this when no block of this size-class will be touched
+         again.  Complexity is O(C).  Never throws.
+         */
+        void ReleaseAllChunks( void );
+
         /** Returns count of empty Chunks held by this allocator.  Complexity
          is O(C) where C is the total number of Chunks - empty or used.
          */
         std::size_t CountEmptyChunks( void ) const;
 
+        /// Copies this size-class's counters into stats.  Never throws.
+        void GetStats( AllocatorStats & stats ) const;
+
+        /** Picks the partially-used Chunk with the fewest live blocks and
+         migrates those blocks - bytes copied, references repointed through
+         the relocator - into the free space of the fullest other Chunks.
+         Once the victim Chunk empties, the usual empty-Chunk machinery
+         releases it.  Stops after maxMoves migrations or as soon as the
+         relocator refuses a move.  Returns # of blocks migrated.
+         */
+        std::size_t CompactStep( BlockRelocator relocator,
+            std::size_t maxMoves );
+
+        /// Installs or removes (NULL) the Chunk acquisition/release hook.
+        inline void SetChunkEventCallback( ChunkEventCallback callback )
+        { chunkCallback_ = callback; }
+
         /** Determines if FixedAllocator is corrupt.  Checks data members to
          see if any have erroneous values, or violate class invariants.  It
          also checks if any Chunk is corrupt.  Complexity is O(C) where C is
@@ -282,8 +523,8 @@ namespace Loki
         bool IsCorrupt( void ) const;
 
         /** Returns true if the block at address p is within a Chunk owned by
-         this FixedAllocator.  Complexity is O(C) where C is the total number
-         of Chunks - empty or used.
+         this FixedAllocator.  Complexity is O(log C) where C is the total
+         number of Chunks - empty or used.
          */
         const Chunk * HasBlock( void * p ) const;
         inline Chunk * HasBlock( void * p )
@@ -292,14 +533,230 @@ namespace Loki
                 const_cast< const FixedAllocator * >( this )->HasBlock( p ) );
         }
 
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+        /** Pushes the block at address p onto the atomic pending-free list
+         using a compare-and-swap loop, without requiring any lock.  The push
+         never suffers from the ABA problem since nothing pops individual
+         nodes - the list is only ever emptied wholesale by DrainPendingFrees.
+         @return False if the block size can not hold a link pointer, in which
+          case the caller must deallocate through the locked path.
+         */
+        bool PushPendingFree( void * p );
+
+        /** Claims the entire pending-free list with one atomic exchange and
+         threads each claimed block back into its owning Chunk.  Must be
+         called with the allocator's external mutex held so that the Chunk
+         bookkeeping is not raced.  This never throws.
+         */
+        void DrainPendingFrees( void );
+#endif
+
     };
 
     unsigned char FixedAllocator::MinObjectsPerChunk_ = 8;
     unsigned char FixedAllocator::MaxObjectsPerChunk_ = UCHAR_MAX;
 
+/// Returns memory whose address is a multiple of alignment.  Used for the
+/// data blocks of Chunks belonging to alignment-aware pools.  Never throws.
+static void * AllocateAlignedPages( std::size_t bytes, std::size_t alignment )
+{
+#if defined( _MSC_VER )
+    return ::_aligned_malloc( bytes, alignment );
+#else
+    void * place = NULL;
+    if ( 0 != ::posix_memalign( &place, alignment, bytes ) )
+        return NULL;
+    return place;
+#endif
+}
+
+/// Releases memory obtained from AllocateAlignedPages.
+static void FreeAlignedPages( void * p )
+{
+#if defined( _MSC_VER )
+    ::_aligned_free( p );
+#else
+    ::std::free( p );
+#endif
+}
+
+#ifdef LOKI_SMALL_OBJECT_USE_MMAP
+
+/** @par Region page source
+ When LOKI_SMALL_OBJECT_USE_MMAP is defined, Chunks do not call malloc but
+ carve their data blocks out of large anonymous mappings.  Each PageRegion
+ is one mmap'd area; Chunk-sized slices are bump-allocated from its tail,
+ and released slices are kept on the region's own free list for reuse by
+ later Chunks of the same size.  When every slice of a region has been
+ released, the whole region is returned to the OS with one munmap call.
+ The page source is shared by all FixedAllocators - and possibly several
+ SmallObjAllocator singletons with different mutexes - so it has its own
+ small mutex.  That mutex is only touched when Chunks are created or
+ destroyed, never on the per-block hot path.
+ */
+
+    /// One slice previously handed to a Chunk and since released.
+    struct FreeSlice
+    {
+        std::size_t bytes_;
+        void * place_;
+    };
+
+    /// One mmap'd area from which Chunk data blocks are sliced.
+    struct PageRegion
+    {
+        unsigned char * base_;   ///< Start of the mapping.
+        std::size_t mapBytes_;   ///< Total size of the mapping.
+        std::size_t used_;       ///< Bump offset for never-used space.
+        std::size_t live_;       ///< Count of slices currently owned by Chunks.
+        std::vector< FreeSlice > freeSlices_; ///< Released, reusable slices.
+    };
+
+    static std::vector< PageRegion > regions_;
+    static ::pthread_mutex_t regionMutex_ = PTHREAD_MUTEX_INITIALIZER;
+
+    /// Rounds slice sizes so every Chunk's data stays 16-byte aligned.
+    inline std::size_t RoundSliceSize( std::size_t bytes )
+    {
+        return ( bytes + 15 ) & ~static_cast< std::size_t >( 15 );
+    }
+
+    /// Maps a new anonymous region, preferring huge pages when asked for.
+    static unsigned char * MapRegion( std::size_t bytes )
+    {
+        void * base = MAP_FAILED;
+#if defined( LOKI_SMALL_OBJECT_USE_HUGE_PAGES ) && defined( MAP_HUGETLB )
+        base = ::mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+#endif
+        if ( MAP_FAILED == base )
+            // Either huge pages were not requested, not configured on this
+            // host, or the pool is exhausted - fall back to normal pages.
+            base = ::mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( MAP_FAILED == base )
+            return NULL;
+        return static_cast< unsigned char * >( base );
+    }
+
+    /// Acquires a Chunk-sized slice from the regions whose address is a
+    /// multiple of alignment.  Returns NULL if the OS refuses to supply
+    /// more pages.  Never throws.
+    static void * AcquirePages( std::size_t bytes, std::size_t alignment )
+    {
+        bytes = RoundSliceSize( bytes );
+        if ( alignment < 16 ) alignment = 16;
+        void * place = NULL;
+        ::pthread_mutex_lock( &regionMutex_ );
+        try
+        {
+            for ( std::size_t ii = 0; ii < regions_.size(); ++ii )
+            {
+                PageRegion & region = regions_[ ii ];
+                for ( std::size_t ss = 0; ss < region.freeSlices_.size(); ++ss )
+                {
+                    if ( ( region.freeSlices_[ ss ].bytes_ == bytes )
+                        && ( 0 == ( reinterpret_cast< std::size_t >(
+                            region.freeSlices_[ ss ].place_ ) % alignment ) ) )
+                    {
+                        place = region.freeSlices_[ ss ].place_;
+                        region.freeSlices_[ ss ] = region.freeSlices_.back();
+                        region.freeSlices_.pop_back();
+                        ++region.live_;
+                        break;
+                    }
+                }
+                if ( NULL != place )
+                    break;
+                // Round the bump offset up so the slice lands on the
+                // requested alignment; regions themselves are page-aligned.
+                const std::size_t alignedUsed =
+                    ( region.used_ + alignment - 1 ) & ~( alignment - 1 );
+                if ( ( alignedUsed <= region.mapBytes_ )
+                    && ( region.mapBytes_ - alignedUsed >= bytes ) )
+                {
+                    place = region.base_ + alignedUsed;
+                    region.used_ = alignedUsed + bytes;
+                    ++region.live_;
+                    break;
+                }
+            }
+            if ( NULL == place )
+            {
+                // No region can serve the request, so map a new one.  Chunks
+                // bigger than a whole region get a dedicated mapping.
+                std::size_t mapBytes = LOKI_SMALL_OBJECT_REGION_SIZE;
+                if ( bytes > mapBytes ) mapBytes = bytes;
+                unsigned char * base = MapRegion( mapBytes );
+                if ( NULL != base )
+                {
+                    PageRegion region;
+                    region.base_ = base;
+                    region.mapBytes_ = mapBytes;
+                    region.used_ = bytes;
+                    region.live_ = 1;
+                    regions_.push_back( region );
+                    place = base;
+                }
+            }
+        }
+        catch ( ... )
+        {
+            place = NULL;
+        }
+        ::pthread_mutex_unlock( &regionMutex_ );
+        return place;
+    }
+
+    /// Returns a slice to its region.  Once the last live slice of a region
+    /// comes back, the whole region is unmapped in one call.  Never throws.
+    static void ReleasePages( void * p, std::size_t bytes )
+    {
+        bytes = RoundSliceSize( bytes );
+        unsigned char * pc = static_cast< unsigned char * >( p );
+        ::pthread_mutex_lock( &regionMutex_ );
+        for ( std::size_t ii = 0; ii < regions_.size(); ++ii )
+        {
+            PageRegion & region = regions_[ ii ];
+            if ( ( region.base_ <= pc ) && ( pc < region.base_ + region.mapBytes_ ) )
+            {
+                assert( 0 < region.live_ );
+                --region.live_;
+                if ( 0 == region.live_ )
+                {
+                    // All slices are back, so the free list records die with
+                    // the region and the pages go back to the OS wholesale.
+                    ::munmap( region.base_, region.mapBytes_ );
+                    regions_[ ii ] = regions_.back();
+                    regions_.pop_back();
+                }
+                else
+                {
+                    try
+                    {
+                        FreeSlice slice;
+                        slice.bytes_ = bytes;
+                        slice.place_ = p;
+                        region.freeSlices_.push_back( slice );
+                    }
+                    catch ( ... )
+                    {
+                        // Could not record the slice, so its space is simply
+                        // unavailable until the region empties out.
+                    }
+                }
+                break;
+            }
+        }
+        ::pthread_mutex_unlock( &regionMutex_ );
+    }
+
+#endif // LOKI_SMALL_OBJECT_USE_MMAP
+
 // Chunk::Init ----------------------------------------------------------------
 
-bool Chunk::Init( std::size_t blockSize, unsigned char blocks )
+bool Chunk::Init( std::size_t blockSize, unsigned char blocks,
+    std::size_t alignment )
 {
     assert(blockSize > 0);
     assert(blocks > 0);
@@ -307,14 +764,33 @@ bool Chunk::Init( std::size_t blockSize, unsigned char blocks )
     const std::size_t allocSize = blockSize * blocks;
     assert( allocSize / blockSize == blocks);
 
-#ifdef USE_NEW_TO_ALLOCATE
+#if defined(LOKI_SMALL_OBJECT_USE_MMAP)
+    // The region page source indicates failure with a NULL pointer, just
+    // like malloc does.
+    pData_ = static_cast< unsigned char * >(
+        AcquirePages( allocSize, alignment ) );
+    if ( NULL == pData_ ) return false;
+#elif defined(USE_NEW_TO_ALLOCATE)
     // If this new operator fails, it will throw, and the exception will get
-    // caught one layer up.
-    pData_ = static_cast< unsigned char * >( ::operator new ( allocSize ) );
+    // caught one layer up.  Alignment-aware pools bypass it since the global
+    // new operator makes no alignment promises.
+    if ( 0 != alignment )
+    {
+        pData_ = static_cast< unsigned char * >(
+            AllocateAlignedPages( allocSize, alignment ) );
+        if ( NULL == pData_ ) return false;
+    }
+    else
+        pData_ = static_cast< unsigned char * >( ::operator new ( allocSize ) );
 #else
     // malloc can't throw, so its only way to indicate an error is to return
-    // a NULL pointer, so we have to check for that.
-    pData_ = static_cast< unsigned char * >( ::std::malloc( allocSize ) );
+    // a NULL pointer, so we have to check for that.  malloc only guarantees
+    // fundamental alignment, so alignment-aware pools take the aligned path.
+    if ( 0 != alignment )
+        pData_ = static_cast< unsigned char * >(
+            AllocateAlignedPages( allocSize, alignment ) );
+    else
+        pData_ = static_cast< unsigned char * >( ::std::malloc( allocSize ) );
     if ( NULL == pData_ ) return false;
 #endif
 
@@ -343,13 +819,23 @@ void Chunk::Reset(std::size_t blockSize, unsigned char blocks)
 
 // Chunk::Release -------------------------------------------------------------
 
-void Chunk::Release()
+void Chunk::Release( std::size_t chunkLength, std::size_t alignment )
 {
     assert( NULL != pData_ );
-#ifdef USE_NEW_TO_ALLOCATE
-    ::operator delete ( pData_ );
+    (void) chunkLength;
+    (void) alignment;
+#if defined(LOKI_SMALL_OBJECT_USE_MMAP)
+    ReleasePages( pData_, chunkLength );
+#elif defined(USE_NEW_TO_ALLOCATE)
+    if ( 0 != alignment )
+        FreeAlignedPages( pData_ );
+    else
+        ::operator delete ( pData_ );
 #else
-    ::std::free( static_cast< void * >( pData_ ) );
+    if ( 0 != alignment )
+        FreeAlignedPages( pData_ );
+    else
+        ::std::free( static_cast< void * >( pData_ ) );
 #endif
 }
 
@@ -545,14 +1031,72 @@ bool Chunk::IsBlockAvailable( void * p, unsigned char numBlocks,
 
 FixedAllocator::FixedAllocator()
     : blockSize_( 0 )
+    , alignment_( 0 )
     , numBlocks_( 0 )
+    , maxChunks_( 0 )
     , chunks_( 0 )
     , allocChunk_( NULL )
     , deallocChunk_( NULL )
     , emptyChunk_( NULL )
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+    , pendingFrees_( NULL )
+#endif
+    , allocCount_( 0 )
+    , deallocCount_( 0 )
+    , highWater_( 0 )
+    , chunkCallback_( NULL )
+{
+}
+
+// FixedAllocator::GetStats ---------------------------------------------------
+
+void FixedAllocator::GetStats( AllocatorStats & stats ) const
+{
+    stats.blockSize = blockSize_;
+    stats.allocCount = allocCount_;
+    stats.deallocCount = deallocCount_;
+    stats.liveBlocks = allocCount_ - deallocCount_;
+    stats.chunkCount = chunks_.size();
+    stats.blocksPerChunk = numBlocks_;
+    stats.highWaterBlocks = highWater_;
+}
+
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
+// FixedAllocator::PushPendingFree --------------------------------------------
+
+bool FixedAllocator::PushPendingFree( void * p )
+{
+    if ( blockSize_ < sizeof(void *) )
+        return false;
+    for (;;)
+    {
+        void * head = pendingFrees_;
+        *static_cast< void ** >( p ) = head;
+        if ( AtomicCompareAndSwapPointer( &pendingFrees_, head, p ) )
+            return true;
+    }
+}
+
+// FixedAllocator::DrainPendingFrees ------------------------------------------
+
+void FixedAllocator::DrainPendingFrees( void )
 {
+    if ( NULL == pendingFrees_ )
+        return;
+    void * head = AtomicExchangePointer( &pendingFrees_, NULL );
+    while ( NULL != head )
+    {
+        void * next = *static_cast< void ** >( head );
+        const bool found = Deallocate( head, NULL );
+        (void) found;
+        assert( found );
+        head = next;
+    }
 }
 
+#endif // LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
 // FixedAllocator::~FixedAllocator --------------------------------------------
 
 FixedAllocator::~FixedAllocator()
@@ -562,16 +1106,44 @@ FixedAllocator::~FixedAllocator()
     assert( chunks_.empty() && "Memory leak detected!" );
 #endif
     for ( ChunkIter i( chunks_.begin() ); i != chunks_.end(); ++i )
-       i->Release();
+       i->Release( numBlocks_ * blockSize_, alignment_ );
+}
+
+// FixedAllocator::ReleaseAllChunks -------------------------------------------
+
+void FixedAllocator::ReleaseAllChunks( void )
+{
+    // Like the wholesale release in the destructor, this does not fire
+    // chunkCallback_ - the blocks are not coming back.
+    for ( ChunkIter i( chunks_.begin() ); i != chunks_.end(); ++i )
+        i->Release( numBlocks_ * blockSize_, alignment_ );
+    chunks_.clear();
+    chunkIndex_.clear();
+    allocChunk_ = NULL;
+    deallocChunk_ = NULL;
+    emptyChunk_ = NULL;
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+    pendingFrees_ = NULL;
+#endif
+    // Everything still outstanding counts as returned, so the live-block
+    // arithmetic of GetStats stays consistent.
+    deallocCount_ = allocCount_;
 }
 
 // FixedAllocator::Initialize -------------------------------------------------
 
-void FixedAllocator::Initialize( std::size_t blockSize, std::size_t pageSize )
+void FixedAllocator::Initialize( std::size_t blockSize, std::size_t pageSize,
+    std::size_t alignment )
 {
     assert( blockSize > 0 );
     assert( pageSize >= blockSize );
+    // A nonzero alignment must be a power of two which divides the block
+    // size, or blocks after the first would drift off the alignment.
+    assert( ( 0 == alignment )
+        || ( ( 0 == ( alignment & ( alignment - 1 ) ) )
+            && ( 0 == ( blockSize % alignment ) ) ) );
     blockSize_ = blockSize;
+    alignment_ = alignment;
 
     std::size_t numBlocks = pageSize / blockSize;
     if ( numBlocks > MaxObjectsPerChunk_ ) numBlocks = MaxObjectsPerChunk_;
@@ -581,6 +1153,29 @@ void FixedAllocator::Initialize( std::size_t blockSize, std::size_t pageSize )
     assert(numBlocks_ == numBlocks);
 }
 
+// FixedAllocator::Configure --------------------------------------------------
+
+bool FixedAllocator::Configure( std::size_t chunkSize, std::size_t reserveChunks,
+    std::size_t maxChunks )
+{
+    // Only meaningful before the first use - reshaping live Chunks would
+    // orphan the blocks they already handed out.
+    if ( !chunks_.empty() )
+        return false;
+    if ( chunkSize < blockSize_ )
+        return false;
+    if ( ( 0 != maxChunks ) && ( reserveChunks > maxChunks ) )
+        return false;
+    Initialize( blockSize_, chunkSize, alignment_ );
+    maxChunks_ = maxChunks;
+    for ( std::size_t i = 0; i < reserveChunks; ++i )
+    {
+        if ( !MakeNewChunk() )
+            return false;
+    }
+    return true;
+}
+
 // FixedAllocator::CountEmptyChunks -------------------------------------------
 
 std::size_t FixedAllocator::CountEmptyChunks( void ) const
@@ -611,6 +1206,13 @@ bool FixedAllocator::IsCorrupt( void ) const
     ChunkCIter last( chunks_.end() );
     const size_t emptyChunkCount = CountEmptyChunks();
 
+    if ( chunkIndex_.size() != chunks_.size() )
+    {
+        // Every Chunk must have exactly one entry in the sorted index.
+        assert( false );
+        return true;
+    }
+
     if ( isEmpty )
     {
         if ( start != last )
@@ -721,14 +1323,7 @@ bool FixedAllocator::IsCorrupt( void ) const
 
 const Chunk * FixedAllocator::HasBlock( void * p ) const
 {
-    const std::size_t chunkLength = numBlocks_ * blockSize_;
-    for ( ChunkCIter it( chunks_.begin() ); it != chunks_.end(); ++it )
-    {
-        const Chunk & chunk = *it;
-        if ( chunk.HasBlock( p, chunkLength ) )
-            return &chunk;
-    }
-    return NULL;
+    return FindChunkByAddress( p );
 }
 
 // FixedAllocator::TrimEmptyChunk ---------------------------------------------
@@ -746,10 +1341,23 @@ bool FixedAllocator::TrimEmptyChunk( void )
 
     Chunk * lastChunk = &chunks_.back();
     if ( lastChunk != emptyChunk_ )
+    {
         std::swap( *emptyChunk_, *lastChunk );
+        UpdateChunkIndex( emptyChunk_ );
+        // The Chunk contents which the cached pointers referred to now live
+        // in the emptyChunk_ slot, so follow them there before the last
+        // slot goes away.
+        if ( deallocChunk_ == lastChunk )
+            deallocChunk_ = emptyChunk_;
+        if ( allocChunk_ == lastChunk )
+            allocChunk_ = emptyChunk_;
+    }
     assert( lastChunk->HasAvailable( numBlocks_ ) );
-    lastChunk->Release();
+    RemoveChunkIndex( lastChunk->pData_ );
+    lastChunk->Release( numBlocks_ * blockSize_, alignment_ );
     chunks_.pop_back();
+    if ( NULL != chunkCallback_ )
+        chunkCallback_( blockSize_, blockSize_ * numBlocks_, false );
 
     if ( chunks_.empty() )
     {
@@ -788,8 +1396,26 @@ bool FixedAllocator::TrimChunkList( void )
 
     if ( chunks_.size() == chunks_.capacity() )
         return false;
+    // Remember the cached pointers as offsets since the swap trick below
+    // moves every Chunk and would leave them dangling.
+    const std::ptrdiff_t allocOffset = ( NULL == allocChunk_ ) ?
+        -1 : allocChunk_ - &chunks_.front();
+    const std::ptrdiff_t deallocOffset = ( NULL == deallocChunk_ ) ?
+        -1 : deallocChunk_ - &chunks_.front();
+    const std::ptrdiff_t emptyOffset = ( NULL == emptyChunk_ ) ?
+        -1 : emptyChunk_ - &chunks_.front();
     // Use the "make-a-temp-and-swap" trick to remove excess capacity.
     Chunks( chunks_ ).swap( chunks_ );
+    if ( !chunks_.empty() )
+    {
+        allocChunk_ = ( allocOffset < 0 ) ? NULL : &chunks_.front() + allocOffset;
+        deallocChunk_ = ( deallocOffset < 0 ) ? NULL : &chunks_.front() + deallocOffset;
+        emptyChunk_ = ( emptyOffset < 0 ) ? NULL : &chunks_.front() + emptyOffset;
+    }
+    // The swap moved every Chunk, so repoint all index entries and drop the
+    // index's own excess capacity while at it.
+    RebuildChunkIndex();
+    ChunkIndex( chunkIndex_ ).swap( chunkIndex_ );
 
     return true;
 }
@@ -798,7 +1424,11 @@ bool FixedAllocator::TrimChunkList( void )
 
 bool FixedAllocator::MakeNewChunk( void )
 {
+    if ( ( 0 != maxChunks_ ) && ( chunks_.size() >= maxChunks_ ) )
+        // The size-class is capped; fail like any exhaustion.
+        return false;
     bool allocated = false;
+    bool reserved = false;
     try
     {
         std::size_t size = chunks_.size();
@@ -809,20 +1439,33 @@ bool FixedAllocator::MakeNewChunk( void )
         {
             if ( 0 == size ) size = 4;
             chunks_.reserve( size * 2 );
+            reserved = true;
         }
         Chunk newChunk;
-        allocated = newChunk.Init( blockSize_, numBlocks_ );
+        allocated = newChunk.Init( blockSize_, numBlocks_, alignment_ );
         if ( allocated )
+        {
             chunks_.push_back( newChunk );
+            if ( reserved )
+                // The reserve moved every Chunk, so all index entries must
+                // be repointed.  The rebuild covers the new Chunk as well.
+                RebuildChunkIndex();
+            else
+                InsertChunkIndex( &chunks_.back() );
+        }
     }
     catch ( ... )
     {
         allocated = false;
+        if ( reserved )
+            RebuildChunkIndex();
     }
     if ( !allocated ) return false;
 
     allocChunk_ = &chunks_.back();
     deallocChunk_ = &chunks_.front();
+    if ( NULL != chunkCallback_ )
+        chunkCallback_( blockSize_, blockSize_ * numBlocks_, true );
     return true;
 }
 
@@ -868,6 +1511,7 @@ void * FixedAllocator::Allocate( void )
     assert( allocChunk_ != NULL );
     assert( !allocChunk_->IsFilled() );
     void * place = allocChunk_->Allocate( blockSize_ );
+    CountAllocation();
 
     // prove either emptyChunk_ points nowhere, or points to a truly empty Chunk.
     assert( ( NULL == emptyChunk_ ) || ( emptyChunk_->HasAvailable( numBlocks_ ) ) );
@@ -883,6 +1527,157 @@ void * FixedAllocator::Allocate( void )
     return place;
 }
 
+// FixedAllocator::CompactStep ------------------------------------------------
+
+std::size_t FixedAllocator::CompactStep( BlockRelocator relocator,
+    std::size_t maxMoves )
+{
+    assert( NULL != relocator );
+    if ( ( 0 == maxMoves ) || ( chunks_.size() < 2 ) )
+        return 0;
+
+    // Pick the partially-used Chunk with the fewest live blocks as the
+    // migration victim, and total up the free space everywhere else so we
+    // know its blocks can actually be absorbed.
+    Chunk * victim = NULL;
+    std::size_t victimLive = 0;
+    std::size_t totalAvailable = 0;
+    for ( ChunkIter it( chunks_.begin() ); it != chunks_.end(); ++it )
+    {
+        const std::size_t live = numBlocks_ - it->blocksAvailable_;
+        if ( 0 == live )
+            // Migrating blocks into an empty Chunk would merely shuttle the
+            // sparseness around, so empty Chunks are neither victims nor
+            // targets and their space does not count as absorption room.
+            continue;
+        totalAvailable += it->blocksAvailable_;
+        if ( numBlocks_ == live )
+            continue;
+        if ( ( NULL == victim ) || ( live < victimLive ) )
+        {
+            victim = &*it;
+            victimLive = live;
+        }
+    }
+    if ( NULL == victim )
+        return 0;
+    if ( totalAvailable - victim->blocksAvailable_ < victimLive )
+        // The other Chunks can not absorb the victim's blocks, so moving
+        // any of them would churn memory without ever emptying the victim.
+        return 0;
+
+    /* Walk the victim's free list to mark its available blocks, then collect
+     the complementary set - the live blocks which must migrate.  The
+     addresses are collected up front because deallocations below may swap
+     Chunk contents around and eventually release the victim itself, which
+     would invalidate the victim pointer mid-loop.
+     */
+    std::bitset< UCHAR_MAX > available;
+    unsigned char idx = victim->firstAvailableBlock_;
+    for ( unsigned char cc = 0; cc < victim->blocksAvailable_; ++cc )
+    {
+        available.set( idx, true );
+        if ( cc + 1 < victim->blocksAvailable_ )
+            idx = *( victim->pData_ + idx * blockSize_ );
+    }
+    const unsigned char * victimData = victim->pData_;
+    std::vector< void * > liveBlocks;
+    liveBlocks.reserve( victimLive );
+    for ( unsigned char bb = 0; bb < numBlocks_; ++bb )
+    {
+        if ( !available.test( bb ) )
+            liveBlocks.push_back( victim->pData_ + bb * blockSize_ );
+    }
+
+    std::size_t moves = 0;
+    for ( std::size_t ii = 0; ( ii < liveBlocks.size() ) && ( moves < maxMoves ); ++ii )
+    {
+        // Re-find the fullest non-victim Chunk with room on every pass since
+        // each deallocation below may swap or release Chunks.
+        Chunk * target = NULL;
+        for ( ChunkIter it( chunks_.begin() ); it != chunks_.end(); ++it )
+        {
+            if ( it->IsFilled() || it->HasAvailable( numBlocks_ )
+                || ( it->pData_ == victimData ) )
+                continue;
+            if ( ( NULL == target )
+                || ( it->blocksAvailable_ < target->blocksAvailable_ ) )
+                target = &*it;
+        }
+        if ( NULL == target )
+            break;
+        if ( target == emptyChunk_ )
+            emptyChunk_ = NULL;
+        void * newPlace = target->Allocate( blockSize_ );
+        assert( NULL != newPlace );
+        CountAllocation();
+        ::std::memcpy( newPlace, liveBlocks[ ii ], blockSize_ );
+        if ( !relocator( liveBlocks[ ii ], newPlace, blockSize_ ) )
+        {
+            // The client could not repoint its references, so discard the
+            // copy, keep the block where it is, and give up on this Chunk.
+            const bool found = Deallocate( newPlace, NULL );
+            (void) found;
+            assert( found );
+            break;
+        }
+        const bool found = Deallocate( liveBlocks[ ii ], NULL );
+        (void) found;
+        assert( found );
+        ++moves;
+    }
+    return moves;
+}
+
+// FixedAllocator::AllocateBatch ----------------------------------------------
+
+std::size_t FixedAllocator::AllocateBatch( void ** out, std::size_t count )
+{
+    assert( NULL != out );
+    std::size_t made = 0;
+    while ( made < count )
+    {
+        if ( ( NULL == allocChunk_ ) || allocChunk_->IsFilled() )
+        {
+            // Let the single-block path find or make a Chunk with room.
+            void * place = Allocate();
+            if ( NULL == place )
+                break;
+            out[ made++ ] = place;
+            continue;
+        }
+        if ( allocChunk_ == emptyChunk_ )
+            // The Chunk is about to lose a block, so it is no longer empty.
+            emptyChunk_ = NULL;
+        // Carve blocks out of the current Chunk until it fills up or the
+        // batch is complete.
+        while ( ( made < count ) && !allocChunk_->IsFilled() )
+        {
+            out[ made++ ] = allocChunk_->Allocate( blockSize_ );
+            CountAllocation();
+        }
+    }
+    return made;
+}
+
+// FixedAllocator::DeallocateBatch --------------------------------------------
+
+bool FixedAllocator::DeallocateBatch( void * const * blocks, std::size_t count )
+{
+    assert( NULL != blocks );
+    bool foundAll = true;
+    for ( std::size_t ii = 0; ii < count; ++ii )
+    {
+        if ( NULL == blocks[ ii ] )
+            continue;
+        // Each call moves deallocChunk_ to the owning Chunk, so blocks which
+        // neighbor the previous one are found without searching.
+        if ( !Deallocate( blocks[ ii ], NULL ) )
+            foundAll = false;
+    }
+    return foundAll;
+}
+
 // FixedAllocator::Deallocate -------------------------------------------------
 
 bool FixedAllocator::Deallocate( void * p, Chunk * hint )
@@ -894,7 +1689,17 @@ bool FixedAllocator::Deallocate( void * p, Chunk * hint )
     assert( &chunks_.back() >= allocChunk_ );
     assert( CountEmptyChunks() < 2 );
 
-    Chunk * foundChunk = ( NULL == hint ) ? VicinityFind( p ) : hint;
+    Chunk * foundChunk = hint;
+    if ( NULL == foundChunk )
+    {
+        // Repeated frees into the cached Chunk cost no searching at all,
+        // while anything else is resolved by the sorted-address index.
+        const std::size_t chunkLength = numBlocks_ * blockSize_;
+        if ( deallocChunk_->HasBlock( p, chunkLength ) )
+            foundChunk = deallocChunk_;
+        else
+            foundChunk = FindChunkByAddress( p );
+    }
     if ( NULL == foundChunk )
         return false;
 
@@ -918,57 +1723,84 @@ bool FixedAllocator::Deallocate( void * p, Chunk * hint )
     return true;
 }
 
-// FixedAllocator::VicinityFind -----------------------------------------------
+// FixedAllocator::FindChunkByAddress -----------------------------------------
 
-Chunk * FixedAllocator::VicinityFind( void * p ) const
+Chunk * FixedAllocator::FindChunkByAddress( void * p ) const
 {
-    if ( chunks_.empty() ) return NULL;
-    assert(deallocChunk_);
-
+    if ( chunkIndex_.empty() ) return NULL;
+    assert( chunkIndex_.size() == chunks_.size() );
+
+    unsigned char * pc = static_cast< unsigned char * >( p );
+    // Find the last index entry whose data block starts at or below p.
+    std::size_t lo = 0;
+    std::size_t hi = chunkIndex_.size();
+    while ( lo < hi )
+    {
+        const std::size_t mid = lo + ( hi - lo ) / 2;
+        if ( chunkIndex_[ mid ].first <= pc )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if ( 0 == lo )
+        return NULL;
+    Chunk * chunk = chunkIndex_[ lo - 1 ].second;
+    assert( chunk->pData_ == chunkIndex_[ lo - 1 ].first );
     const std::size_t chunkLength = numBlocks_ * blockSize_;
-    Chunk * lo = deallocChunk_;
-    Chunk * hi = deallocChunk_ + 1;
-    const Chunk * loBound = &chunks_.front();
-    const Chunk * hiBound = &chunks_.back() + 1;
+    return chunk->HasBlock( p, chunkLength ) ? chunk : NULL;
+}
 
-    // Special case: deallocChunk_ is the last in the array
-    if (hi == hiBound) hi = NULL;
+// FixedAllocator::RebuildChunkIndex ------------------------------------------
 
-    for (;;)
-    {
-        if (lo)
-        {
-            if ( lo->HasBlock( p, chunkLength ) ) return lo;
-            if ( lo == loBound )
-            {
-                lo = NULL;
-                if ( NULL == hi ) break;
-            }
-            else --lo;
-        }
+void FixedAllocator::RebuildChunkIndex( void )
+{
+    chunkIndex_.clear();
+    chunkIndex_.reserve( chunks_.capacity() );
+    for ( ChunkIter it( chunks_.begin() ); it != chunks_.end(); ++it )
+        chunkIndex_.push_back( ChunkIndexEntry( it->pData_, &*it ) );
+    std::sort( chunkIndex_.begin(), chunkIndex_.end(), ChunkIndexLess );
+}
 
-        if (hi)
-        {
-            if ( hi->HasBlock( p, chunkLength ) ) return hi;
-            if ( ++hi == hiBound )
-            {
-                hi = NULL;
-                if ( NULL == lo ) break;
-            }
-        }
-    }
+// FixedAllocator::InsertChunkIndex -------------------------------------------
 
-    return NULL;
+void FixedAllocator::InsertChunkIndex( Chunk * chunk )
+{
+    const ChunkIndexEntry entry( chunk->pData_, chunk );
+    chunkIndex_.insert( std::lower_bound( chunkIndex_.begin(),
+        chunkIndex_.end(), entry, ChunkIndexLess ), entry );
 }
 
-// FixedAllocator::DoDeallocate -----------------------------------------------
+// FixedAllocator::RemoveChunkIndex -------------------------------------------
 
-void FixedAllocator::DoDeallocate(void* p)
+void FixedAllocator::RemoveChunkIndex( const unsigned char * pData )
 {
-    // Show that deallocChunk_ really owns the block at address p.
-    assert( deallocChunk_->HasBlock( p, numBlocks_ * blockSize_ ) );
-    // Either of the next two assertions may fail if somebody tries to
-    // delete the same block twice.
+    const ChunkIndexEntry entry( const_cast< unsigned char * >( pData ),
+        NULL );
+    const ChunkIndex::iterator it( std::lower_bound( chunkIndex_.begin(),
+        chunkIndex_.end(), entry, ChunkIndexLess ) );
+    assert( ( it != chunkIndex_.end() ) && ( it->first == pData ) );
+    chunkIndex_.erase( it );
+}
+
+// FixedAllocator::UpdateChunkIndex -------------------------------------------
+
+void FixedAllocator::UpdateChunkIndex( Chunk * chunk )
+{
+    const ChunkIndexEntry entry( chunk->pData_, NULL );
+    const ChunkIndex::iterator it( std::lower_bound( chunkIndex_.begin(),
+        chunkIndex_.end(), entry, ChunkIndexLess ) );
+    assert( ( it != chunkIndex_.end() ) && ( it->first == chunk->pData_ ) );
+    it->second = chunk;
+}
+
+// FixedAllocator::DoDeallocate -----------------------------------------------
+
+void FixedAllocator::DoDeallocate(void* p)
+{
+    // Show that deallocChunk_ really owns the block at address p.
+    assert( deallocChunk_->HasBlock( p, numBlocks_ * blockSize_ ) );
+    // Either of the next two assertions may fail if somebody tries to
+    // delete the same block twice.
     assert( emptyChunk_ != deallocChunk_ );
     assert( !deallocChunk_->HasAvailable( numBlocks_ ) );
     // prove either emptyChunk_ points nowhere, or points to a truly empty Chunk.
@@ -976,6 +1808,7 @@ void FixedAllocator::DoDeallocate(void* p)
 
     // call into the chunk, will adjust the inner list but won't release memory
     deallocChunk_->Deallocate(p, blockSize_);
+    ++deallocCount_;
 
     if ( deallocChunk_->HasAvailable( numBlocks_ ) )
     {
@@ -993,10 +1826,16 @@ void FixedAllocator::DoDeallocate(void* p)
             if ( lastChunk == deallocChunk_ )
                 deallocChunk_ = emptyChunk_;
             else if ( lastChunk != emptyChunk_ )
+            {
                 std::swap( *emptyChunk_, *lastChunk );
+                UpdateChunkIndex( emptyChunk_ );
+            }
             assert( lastChunk->HasAvailable( numBlocks_ ) );
-            lastChunk->Release();
+            RemoveChunkIndex( lastChunk->pData_ );
+            lastChunk->Release( numBlocks_ * blockSize_, alignment_ );
             chunks_.pop_back();
+            if ( NULL != chunkCallback_ )
+                chunkCallback_( blockSize_, blockSize_ * numBlocks_, false );
             if ( ( allocChunk_ == lastChunk ) || allocChunk_->IsFilled() ) 
                 allocChunk_ = deallocChunk_;
         }
@@ -1055,13 +1894,415 @@ void DefaultDeallocator( void * p )
 #endif
 }
 
+// AlignedPools ---------------------------------------------------------------
+/** @struct AlignedPools
+ Holds the lazily created FixedAllocator pools for alignments stricter than
+ the allocator's normal boundary.  Each distinct alignment requested gets its
+ own set of FixedAllocator's whose size-classes are multiples of that
+ alignment and whose Chunks place their data on it.  Programs typically ask
+ for only one or two distinct alignments - usually the cache-line size - so
+ the sets are kept in a small vector searched linearly.
+ */
+struct AlignedPools
+{
+    /// One set of size-class pools for a single alignment.
+    struct PoolSet
+    {
+        std::size_t alignment;   ///< Alignment served by this set.
+        std::size_t count;       ///< # of FixedAllocator's in pool.
+        FixedAllocator * pool;   ///< Array of count FixedAllocator's.
+    };
+
+    typedef ::std::vector< PoolSet > PoolSets;
+    PoolSets sets_;
+
+    ~AlignedPools( void )
+    {
+        for ( PoolSets::iterator it( sets_.begin() ); it != sets_.end(); ++it )
+            delete [] it->pool;
+    }
+
+    /** Returns the FixedAllocator serving numBytes at alignment, creating
+     the alignment's pool set on first use.  Returns NULL only if creating
+     the set fails for lack of memory.
+     */
+    FixedAllocator * GetPool( std::size_t numBytes, std::size_t alignment,
+        std::size_t maxObjectSize, std::size_t pageSize )
+    {
+        PoolSet * set = NULL;
+        for ( PoolSets::iterator it( sets_.begin() ); it != sets_.end(); ++it )
+        {
+            if ( it->alignment == alignment )
+            {
+                set = &*it;
+                break;
+            }
+        }
+        if ( NULL == set )
+        {
+            PoolSet newSet;
+            newSet.alignment = alignment;
+            newSet.count = GetOffset( maxObjectSize, alignment );
+            newSet.pool = new ( std::nothrow ) FixedAllocator[ newSet.count ];
+            if ( NULL == newSet.pool )
+                return NULL;
+            for ( std::size_t i = 0; i < newSet.count; ++i )
+            {
+                const std::size_t blockSize = ( i + 1 ) * alignment;
+                newSet.pool[ i ].Initialize( blockSize,
+                    ( pageSize < blockSize ) ? blockSize : pageSize,
+                    alignment );
+            }
+            sets_.push_back( newSet );
+            set = &sets_.back();
+        }
+        const std::size_t index = GetOffset( numBytes, alignment ) - 1;
+        assert( index < set->count );
+        return &set->pool[ index ];
+    }
+};
+
+#ifdef LOKI_SMALL_OBJECT_NUMA_AWARE
+
+// GetCurrentNumaNode ---------------------------------------------------------
+
+unsigned int GetCurrentNumaNode( void )
+{
+    // getcpu is implemented in the vDSO on the kernels this targets, so
+    // calling it per allocation costs a few nanoseconds, not a mode switch.
+    // The node - not the cpu - is what matters, so sched_getcpu is no use.
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if ( 0 != ::syscall( SYS_getcpu, &cpu, &node, NULL ) )
+        return 0;
+    return node;
+}
+
+#endif // LOKI_SMALL_OBJECT_NUMA_AWARE
+
+#ifdef LOKI_SMALL_OBJECT_ALLOC_PROFILER
+
+namespace
+{
+    typedef Loki::SmallObjProfiler::Sample ProfileSample;
+
+    /** Single-producer single-consumer ring of one thread's samples.  The
+     owning thread writes samples and head; the drainer writes only tail.
+     */
+    struct ProfileRing
+    {
+        ProfileSample samples[ LOKI_SMALL_OBJECT_PROFILE_RING_SIZE ];
+        volatile long head;   ///< Written only by the owning thread.
+        volatile long tail;   ///< Written only by the drainer.
+        ProfileRing * next;   ///< Older rings in the registry.
+    };
+
+    /// Head of the list of every ring ever made.  Rings are pushed with
+    /// compare-and-swap and never removed, so walking needs no lock.
+    ProfileRing * volatile ringList = 0;
+
+    /// The calling thread's ring, made on its first sample.
+    LOKI_SMALLOBJ_PROFILER_TLS ProfileRing * myRing = 0;
+
+    /// One in this many allocations gets sampled; zero means off.
+    volatile long samplingRate = 0;
+
+    /// Samples lost to full rings.
+    volatile long droppedCount = 0;
+
+    /// While sampling is off, threads recheck the rate this often.
+    const unsigned long recheckInterval = 8192;
+
+    inline long AtomicRead( volatile long & value )
+    {
+#if defined( _MSC_VER )
+        return ::_InterlockedExchangeAdd( &value, 0 );
+#else
+        return __sync_fetch_and_add( &value, 0 );
+#endif
+    }
+
+    inline void AtomicIncrement( volatile long & value )
+    {
+#if defined( _MSC_VER )
+        ::_InterlockedIncrement( &value );
+#else
+        __sync_fetch_and_add( &value, 1 );
+#endif
+    }
+
+    inline bool CasRingPointer( ProfileRing * volatile * where,
+        ProfileRing * expected, ProfileRing * replacement )
+    {
+#if defined( _MSC_VER )
+        return expected == ::_InterlockedCompareExchangePointer(
+            reinterpret_cast< void * volatile * >( where ),
+            replacement, expected );
+#else
+        return __sync_bool_compare_and_swap( where, expected, replacement );
+#endif
+    }
+}
+
+// SmallObjProfiler -----------------------------------------------------------
+
+LOKI_SMALLOBJ_PROFILER_TLS unsigned long SmallObjProfiler::countdown_ = 1;
+
+void SmallObjProfiler::SetSamplingRate( unsigned long rate )
+{
+    samplingRate = static_cast< long >( rate );
+}
+
+unsigned long SmallObjProfiler::GetSamplingRate( void )
+{
+    return static_cast< unsigned long >( AtomicRead( samplingRate ) );
+}
+
+unsigned long SmallObjProfiler::GetDroppedCount( void )
+{
+    return static_cast< unsigned long >( AtomicRead( droppedCount ) );
+}
+
+void SmallObjProfiler::Record( void * site, std::size_t size )
+{
+    const long rate = AtomicRead( samplingRate );
+    if ( rate <= 0 )
+    {
+        // Sampling is off; come back after a while to see if it turned on.
+        countdown_ = recheckInterval;
+        return;
+    }
+    countdown_ = static_cast< unsigned long >( rate );
+
+    ProfileRing * ring = myRing;
+    if ( 0 == ring )
+    {
+        // This thread's first sample.  The ring comes from the global heap,
+        // not from the Small-Object allocator this profiles.
+        ring = new ProfileRing;
+        ring->head = 0;
+        ring->tail = 0;
+        myRing = ring;
+        for (;;)
+        {
+            ProfileRing * first = ringList;
+            ring->next = first;
+            if ( CasRingPointer( &ringList, first, ring ) )
+                break;
+        }
+    }
+
+    const long head = ring->head;
+    if ( head - ring->tail >= LOKI_SMALL_OBJECT_PROFILE_RING_SIZE )
+    {
+        // Drainer is not keeping up; drop rather than stall the allocation.
+        AtomicIncrement( droppedCount );
+        return;
+    }
+    ProfileSample & sample =
+        ring->samples[ head & ( LOKI_SMALL_OBJECT_PROFILE_RING_SIZE - 1 ) ];
+    sample.site = site;
+    sample.size = size;
+    // The increment is a full barrier, so the sample is written before the
+    // drainer can see the new head.
+    AtomicIncrement( ring->head );
+}
+
+std::size_t SmallObjProfiler::Drain( Sample * out, std::size_t max )
+{
+    std::size_t count = 0;
+    for ( ProfileRing * ring = ringList;
+        ( 0 != ring ) && ( count < max ); ring = ring->next )
+    {
+        while ( count < max )
+        {
+            const long head = AtomicRead( ring->head );
+            const long tail = ring->tail;
+            if ( tail == head )
+                break;
+            out[ count ] =
+                ring->samples[ tail & ( LOKI_SMALL_OBJECT_PROFILE_RING_SIZE - 1 ) ];
+            ++count;
+            // Full barrier: the copy completes before the slot is reusable.
+            AtomicIncrement( ring->tail );
+        }
+    }
+    return count;
+}
+
+#endif // LOKI_SMALL_OBJECT_ALLOC_PROFILER
+
+#ifdef LOKI_SMALL_OBJECT_ALLOC_TRACE
+
+namespace
+{
+    /// Thread-local storage keyword for the trace thread ids.
+#if defined( _MSC_VER )
+    #define LOKI_SMALLOBJ_TRACE_TLS __declspec( thread )
+#elif defined( __GNUC__ )
+    #define LOKI_SMALLOBJ_TRACE_TLS __thread
+#else
+    // Without thread-local support every record carries thread id zero.
+    #define LOKI_SMALLOBJ_TRACE_TLS
+#endif
+
+    /// Guards the trace buffer and file.  A spin lock keeps the fast path
+    /// to two atomic operations; the critical section is one record copy,
+    /// or one buffered write when the buffer is full.
+    volatile long traceLock = 0;
+
+    inline void AcquireTraceLock( void )
+    {
+#if defined( _MSC_VER )
+        while ( 0 != ::_InterlockedExchange( &traceLock, 1 ) ) {}
+#else
+        while ( 0 != __sync_lock_test_and_set( &traceLock, 1 ) ) {}
+#endif
+    }
+
+    inline void ReleaseTraceLock( void )
+    {
+#if defined( _MSC_VER )
+        ::_InterlockedExchange( &traceLock, 0 );
+#else
+        __sync_lock_release( &traceLock );
+#endif
+    }
+
+    ::std::FILE * traceFile = 0;
+    Loki::SmallObjTracer::Record * traceBuffer = 0;
+    ::std::size_t traceCapacity = 0;
+    ::std::size_t traceCount = 0;
+    volatile long traceActive = 0;
+    unsigned long traceDropped = 0;
+    volatile long nextTraceThreadId = 0;
+    LOKI_SMALLOBJ_TRACE_TLS long myTraceThreadId = -1;
+
+    /// Writes the buffered records.  Call with the trace lock held.
+    void FlushTraceBuffer( void )
+    {
+        if ( 0 == traceCount )
+            return;
+        const ::std::size_t written = ::std::fwrite( traceBuffer,
+            sizeof( Loki::SmallObjTracer::Record ), traceCount, traceFile );
+        traceDropped += static_cast< unsigned long >( traceCount - written );
+        traceCount = 0;
+    }
+}
+
+// SmallObjTracer -------------------------------------------------------------
+
+bool SmallObjTracer::Start( const char * path, std::size_t bufferRecords )
+{
+    if ( ( 0 == path ) || ( 0 == bufferRecords ) )
+        return false;
+    AcquireTraceLock();
+    if ( 0 != traceActive )
+    {
+        ReleaseTraceLock();
+        return false;
+    }
+    ::std::FILE * file = ::std::fopen( path, "wb" );
+    if ( 0 == file )
+    {
+        ReleaseTraceLock();
+        return false;
+    }
+    Record * buffer = new ( ::std::nothrow ) Record[ bufferRecords ];
+    if ( 0 == buffer )
+    {
+        ::std::fclose( file );
+        ReleaseTraceLock();
+        return false;
+    }
+    const unsigned char header[ 8 ] =
+    {
+        'L', 'K', 'S', 'O', 1,
+        static_cast< unsigned char >( sizeof( Record ) ),
+        static_cast< unsigned char >( sizeof( std::size_t ) ),
+        0
+    };
+    ::std::fwrite( header, 1, sizeof( header ), file );
+    traceFile = file;
+    traceBuffer = buffer;
+    traceCapacity = bufferRecords;
+    traceCount = 0;
+    traceDropped = 0;
+    traceActive = 1;
+    ReleaseTraceLock();
+    return true;
+}
+
+void SmallObjTracer::Stop( void )
+{
+    AcquireTraceLock();
+    if ( 0 != traceActive )
+    {
+        traceActive = 0;
+        FlushTraceBuffer();
+        ::std::fclose( traceFile );
+        traceFile = 0;
+        delete [] traceBuffer;
+        traceBuffer = 0;
+        traceCapacity = 0;
+    }
+    ReleaseTraceLock();
+}
+
+bool SmallObjTracer::IsTracing( void )
+{
+    return ( 0 != traceActive );
+}
+
+unsigned long SmallObjTracer::GetDroppedCount( void )
+{
+    return traceDropped;
+}
+
+void SmallObjTracer::Trace( unsigned char op, void * slot, std::size_t size )
+{
+    if ( 0 == traceActive )
+        return;
+    if ( 0 > myTraceThreadId )
+    {
+#if defined( _MSC_VER )
+        myTraceThreadId = ::_InterlockedIncrement( &nextTraceThreadId ) - 1;
+#elif defined( __GNUC__ )
+        myTraceThreadId = __sync_fetch_and_add( &nextTraceThreadId, 1 );
+#else
+        myTraceThreadId = 0;
+#endif
+    }
+    AcquireTraceLock();
+    if ( 0 == traceActive )
+    {
+        ReleaseTraceLock();
+        return;
+    }
+    if ( traceCount == traceCapacity )
+        FlushTraceBuffer();
+    Record & record = traceBuffer[ traceCount++ ];
+    record.slot = reinterpret_cast< std::size_t >( slot );
+    record.size = static_cast< unsigned int >( size );
+    record.op = op;
+    record.thread = static_cast< unsigned char >( myTraceThreadId & 0xFF );
+    record.reserved[ 0 ] = 0;
+    record.reserved[ 1 ] = 0;
+    ReleaseTraceLock();
+}
+
+#endif // LOKI_SMALL_OBJECT_ALLOC_TRACE
+
 // SmallObjAllocator::SmallObjAllocator ---------------------------------------
 
 SmallObjAllocator::SmallObjAllocator( std::size_t pageSize,
     std::size_t maxObjectSize, std::size_t objectAlignSize ) :
     pool_( NULL ),
+    alignedPools_( NULL ),
+    pageSize_( pageSize ),
     maxSmallObjectSize_( maxObjectSize ),
-    objectAlignSize_( objectAlignSize )
+    objectAlignSize_( objectAlignSize ),
+    shutdown_( false )
 {
 #ifdef DO_EXTRA_LOKI_TESTS
     std::cout << "SmallObjAllocator " << this << std::endl;
@@ -1080,9 +2321,35 @@ SmallObjAllocator::~SmallObjAllocator( void )
 #ifdef DO_EXTRA_LOKI_TESTS
     std::cout << "~SmallObjAllocator " << this << std::endl;
 #endif
+    delete alignedPools_;
     delete [] pool_;
 }
 
+// SmallObjAllocator::ShutdownFast --------------------------------------------
+
+void SmallObjAllocator::ShutdownFast( void )
+{
+    assert( NULL != pool_ );
+    const std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
+    for ( std::size_t ii = 0; ii < allocCount; ++ii )
+        pool_[ ii ].ReleaseAllChunks();
+    delete alignedPools_;
+    alignedPools_ = NULL;
+    shutdown_ = true;
+}
+
+// SmallObjAllocator::ConfigureSizeClass --------------------------------------
+
+bool SmallObjAllocator::ConfigureSizeClass( std::size_t objectSize,
+    std::size_t chunkSize, std::size_t reserveChunks, std::size_t maxChunks )
+{
+    if ( ( 0 == objectSize ) || ( objectSize > GetMaxObjectSize() ) )
+        return false;
+    assert( NULL != pool_ );
+    const std::size_t index = GetOffset( objectSize, GetAlignment() ) - 1;
+    return pool_[ index ].Configure( chunkSize, reserveChunks, maxChunks );
+}
+
 // SmallObjAllocator::TrimExcessMemory ----------------------------------------
 
 bool SmallObjAllocator::TrimExcessMemory( void )
@@ -1090,6 +2357,13 @@ bool SmallObjAllocator::TrimExcessMemory( void )
     bool found = false;
     const std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
     std::size_t i = 0;
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+    // Return queued deallocations to the Chunks first so that Chunks which
+    // are only nominally in-use can be recognized as empty and trimmed.
+    for ( ; i < allocCount; ++i )
+        pool_[ i ].DrainPendingFrees();
+    i = 0;
+#endif
     for ( ; i < allocCount; ++i )
     {
         if ( pool_[ i ].TrimEmptyChunk() )
@@ -1104,6 +2378,126 @@ bool SmallObjAllocator::TrimExcessMemory( void )
     return found;
 }
 
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+
+// SmallObjAllocator::ThreadCacheAllocate -------------------------------------
+
+void * SmallObjAllocator::ThreadCacheAllocate( std::size_t numBytes )
+{
+    // After ShutdownFast the magazines hold blocks of released Chunks.
+    if ( shutdown_ )
+        return NULL;
+    if ( numBytes > GetMaxObjectSize() )
+        return NULL;
+    if ( 0 == numBytes ) numBytes = 1;
+    const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    if ( index >= LOKI_SMALL_OBJECT_MAGAZINE_CLASSES )
+        return NULL;
+    Magazine & magazine = magazines_[ index ];
+    if ( ( this != magazine.owner_ ) || ( 0 == magazine.count_ ) )
+        return NULL;
+    return magazine.blocks_[ --magazine.count_ ];
+}
+
+// SmallObjAllocator::ThreadCacheDeallocate -----------------------------------
+
+bool SmallObjAllocator::ThreadCacheDeallocate( void * p, std::size_t numBytes )
+{
+    if ( shutdown_ ) return true;
+    if ( NULL == p ) return true;
+    if ( numBytes > GetMaxObjectSize() )
+        return false;
+    if ( 0 == numBytes ) numBytes = 1;
+    const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    if ( index >= LOKI_SMALL_OBJECT_MAGAZINE_CLASSES )
+        return false;
+    Magazine & magazine = magazines_[ index ];
+    // The block at address p came from this allocator, so an empty magazine
+    // may be claimed for this allocator no matter who owned it before.
+    if ( 0 == magazine.count_ )
+        magazine.owner_ = this;
+    else if ( this != magazine.owner_ )
+        return false;
+    if ( LOKI_SMALL_OBJECT_MAGAZINE_SIZE == magazine.count_ )
+        return false;
+    magazine.blocks_[ magazine.count_++ ] = p;
+    return true;
+}
+
+#endif // LOKI_SMALL_OBJECT_THREAD_CACHE
+
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
+// SmallObjAllocator::DeferDeallocate -----------------------------------------
+
+bool SmallObjAllocator::DeferDeallocate( void * p, std::size_t numBytes )
+{
+    if ( shutdown_ ) return true;
+    if ( NULL == p ) return true;
+    if ( numBytes > GetMaxObjectSize() )
+        return false;
+    if ( 0 == numBytes ) numBytes = 1;
+    const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    assert( index < GetOffset( GetMaxObjectSize(), GetAlignment() ) );
+    return pool_[ index ].PushPendingFree( p );
+}
+
+#endif // LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+
+// SmallObjAllocator::Compact -------------------------------------------------
+
+std::size_t SmallObjAllocator::Compact( BlockRelocator relocator,
+    std::size_t maxMoves )
+{
+    assert( NULL != relocator );
+    assert( NULL != pool_ );
+    std::size_t moved = 0;
+    const std::size_t allocCount = GetFixedAllocatorCount();
+    for ( std::size_t ii = 0; ( ii < allocCount ) && ( moved < maxMoves ); ++ii )
+    {
+        // Keep compacting this size-class while it makes progress and the
+        // move budget lasts.
+        for (;;)
+        {
+            const std::size_t step =
+                pool_[ ii ].CompactStep( relocator, maxMoves - moved );
+            moved += step;
+            if ( ( 0 == step ) || ( moved >= maxMoves ) )
+                break;
+        }
+    }
+    return moved;
+}
+
+// SmallObjAllocator::GetFixedAllocatorCount ----------------------------------
+
+std::size_t SmallObjAllocator::GetFixedAllocatorCount( void ) const
+{
+    return GetOffset( GetMaxObjectSize(), GetAlignment() );
+}
+
+// SmallObjAllocator::GetStats ------------------------------------------------
+
+bool SmallObjAllocator::GetStats( std::size_t index,
+    AllocatorStats & stats ) const
+{
+    if ( index >= GetFixedAllocatorCount() )
+        return false;
+    assert( NULL != pool_ );
+    pool_[ index ].GetStats( stats );
+    return true;
+}
+
+// SmallObjAllocator::SetChunkEventCallback -----------------------------------
+
+void SmallObjAllocator::SetChunkEventCallback( ChunkEventCallback callback )
+{
+    assert( NULL != pool_ );
+    const std::size_t allocCount = GetFixedAllocatorCount();
+    for ( std::size_t ii = 0; ii < allocCount; ++ii )
+        pool_[ ii ].SetChunkEventCallback( callback );
+}
+
 // SmallObjAllocator::Allocate ------------------------------------------------
 
 void * SmallObjAllocator::Allocate( std::size_t numBytes, bool doThrow )
@@ -1114,18 +2508,51 @@ void * SmallObjAllocator::Allocate( std::size_t numBytes, bool doThrow )
     assert( NULL != pool_ );
     if ( 0 == numBytes ) numBytes = 1;
     const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    assert( pool_[ index ].BlockSize() >= numBytes );
+    assert( pool_[ index ].BlockSize() < numBytes + GetAlignment() );
+    return AllocateAtIndex( index, doThrow );
+}
+
+// SmallObjAllocator::AllocateAtIndex -----------------------------------------
+
+void * SmallObjAllocator::AllocateAtIndex( std::size_t index, bool doThrow )
+{
+    assert( NULL != pool_ );
     const std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
     (void) allocCount;
     assert( index < allocCount );
 
     FixedAllocator & allocator = pool_[ index ];
-    assert( allocator.BlockSize() >= numBytes );
-    assert( allocator.BlockSize() < numBytes + GetAlignment() );
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+    // The caller already holds the lock, so blocks queued by lock-free
+    // deallocations can be threaded back into the Chunks for reuse now.
+    allocator.DrainPendingFrees();
+#endif
     void * place = allocator.Allocate();
 
     if ( ( NULL == place ) && TrimExcessMemory() )
         place = allocator.Allocate();
 
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+    // The caller already holds the allocator's lock, so refill the calling
+    // thread's magazine now to make its next allocations lock-free.
+    if ( ( NULL != place ) && ( index < LOKI_SMALL_OBJECT_MAGAZINE_CLASSES ) )
+    {
+        Magazine & magazine = magazines_[ index ];
+        if ( 0 == magazine.count_ )
+            magazine.owner_ = this;
+        if ( this == magazine.owner_ )
+        {
+            while ( magazine.count_ < LOKI_SMALL_OBJECT_MAGAZINE_SIZE / 2 )
+            {
+                void * block = allocator.Allocate();
+                if ( NULL == block ) break;
+                magazine.blocks_[ magazine.count_++ ] = block;
+            }
+        }
+    }
+#endif
+
     if ( ( NULL == place ) && doThrow )
     {
 #ifdef _MSC_VER
@@ -1136,6 +2563,11 @@ void * SmallObjAllocator::Allocate( std::size_t numBytes, bool doThrow )
         throw std::bad_alloc();
 #endif
     }
+#ifdef LOKI_SMALL_OBJECT_ALLOC_TRACE
+    if ( NULL != place )
+        SmallObjTracer::Trace( SmallObjTracer::OpAllocate, place,
+            ( index + 1 ) * GetAlignment() );
+#endif
     return place;
 }
 
@@ -1143,6 +2575,7 @@ void * SmallObjAllocator::Allocate( std::size_t numBytes, bool doThrow )
 
 void SmallObjAllocator::Deallocate( void * p, std::size_t numBytes )
 {
+    if ( shutdown_ ) return;
     if ( NULL == p ) return;
     if ( numBytes > GetMaxObjectSize() )
     {
@@ -1152,22 +2585,208 @@ void SmallObjAllocator::Deallocate( void * p, std::size_t numBytes )
     assert( NULL != pool_ );
     if ( 0 == numBytes ) numBytes = 1;
     const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    assert( pool_[ index ].BlockSize() >= numBytes );
+    assert( pool_[ index ].BlockSize() < numBytes + GetAlignment() );
+    DeallocateAtIndex( p, index );
+}
+
+// SmallObjAllocator::DeallocateAtIndex ---------------------------------------
+
+void SmallObjAllocator::DeallocateAtIndex( void * p, std::size_t index )
+{
+    if ( shutdown_ ) return;
+    if ( NULL == p ) return;
+    assert( NULL != pool_ );
+#ifdef LOKI_SMALL_OBJECT_ALLOC_TRACE
+    SmallObjTracer::Trace( SmallObjTracer::OpDeallocate, p,
+        ( index + 1 ) * GetAlignment() );
+#endif
     const std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
     (void) allocCount;
     assert( index < allocCount );
     FixedAllocator & allocator = pool_[ index ];
-    assert( allocator.BlockSize() >= numBytes );
-    assert( allocator.BlockSize() < numBytes + GetAlignment() );
+
+#ifdef LOKI_SMALL_OBJECT_THREAD_CACHE
+    // The caller already holds the allocator's lock.  If the calling thread's
+    // magazine for this size-class is full, flush half of it back to the
+    // FixedAllocator under this one lock acquisition.
+    if ( index < LOKI_SMALL_OBJECT_MAGAZINE_CLASSES )
+    {
+        Magazine & magazine = magazines_[ index ];
+        if ( ( this == magazine.owner_ )
+            && ( LOKI_SMALL_OBJECT_MAGAZINE_SIZE == magazine.count_ ) )
+        {
+            while ( magazine.count_ > LOKI_SMALL_OBJECT_MAGAZINE_SIZE / 2 )
+                allocator.Deallocate( magazine.blocks_[ --magazine.count_ ], NULL );
+        }
+    }
+#endif
+
     const bool found = allocator.Deallocate( p, NULL );
     (void) found;
     assert( found );
 }
 
+// SmallObjAllocator::Allocate ------------------------------------------------
+
+void * SmallObjAllocator::Allocate( std::size_t numBytes,
+    std::size_t alignment, bool doThrow )
+{
+    assert( 0 != alignment );
+    assert( 0 == ( alignment & ( alignment - 1 ) ) );
+    // Modest alignments fall out of the normal pool for free since every
+    // block there sits on an objectAlignSize_ boundary.
+    if ( alignment <= GetAlignment() )
+        return Allocate( numBytes, doThrow );
+    if ( 0 == numBytes ) numBytes = 1;
+
+    if ( numBytes > GetMaxObjectSize() )
+    {
+        void * place = AllocateAlignedPages( numBytes, alignment );
+        if ( ( NULL == place ) && doThrow )
+            throw std::bad_alloc();
+        return place;
+    }
+
+    if ( NULL == alignedPools_ )
+        alignedPools_ = new ( std::nothrow ) AlignedPools;
+    FixedAllocator * allocator = ( NULL == alignedPools_ ) ? NULL :
+        alignedPools_->GetPool( numBytes, alignment, GetMaxObjectSize(),
+            pageSize_ );
+    void * place = NULL;
+    if ( NULL != allocator )
+    {
+        assert( allocator->BlockSize() >= numBytes );
+        place = allocator->Allocate();
+        if ( ( NULL == place ) && TrimExcessMemory() )
+            place = allocator->Allocate();
+    }
+    if ( ( NULL == place ) && doThrow )
+        throw std::bad_alloc();
+    return place;
+}
+
+// SmallObjAllocator::Deallocate ----------------------------------------------
+
+void SmallObjAllocator::Deallocate( void * p, std::size_t numBytes,
+    std::size_t alignment )
+{
+    if ( shutdown_ ) return;
+    if ( NULL == p ) return;
+    assert( 0 != alignment );
+    assert( 0 == ( alignment & ( alignment - 1 ) ) );
+    if ( alignment <= GetAlignment() )
+    {
+        Deallocate( p, numBytes );
+        return;
+    }
+    if ( 0 == numBytes ) numBytes = 1;
+    if ( numBytes > GetMaxObjectSize() )
+    {
+        FreeAlignedPages( p );
+        return;
+    }
+    // A block this size at this alignment can only have come from the
+    // dedicated pool, so the pool set must already exist.
+    assert( NULL != alignedPools_ );
+    FixedAllocator * allocator = alignedPools_->GetPool( numBytes, alignment,
+        GetMaxObjectSize(), pageSize_ );
+    assert( NULL != allocator );
+    const bool found = allocator->Deallocate( p, NULL );
+    (void) found;
+    assert( found );
+}
+
+// SmallObjAllocator::AllocateBatch -------------------------------------------
+
+std::size_t SmallObjAllocator::AllocateBatch( std::size_t numBytes,
+    std::size_t count, void ** out, bool doThrow )
+{
+    assert( NULL != out );
+    std::size_t made = 0;
+    if ( numBytes > GetMaxObjectSize() )
+    {
+        for ( ; made < count; ++made )
+        {
+            void * place = DefaultAllocator( numBytes, false );
+            if ( NULL == place )
+                break;
+            out[ made ] = place;
+        }
+    }
+    else
+    {
+        assert( NULL != pool_ );
+        if ( 0 == numBytes ) numBytes = 1;
+        const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+        assert( index < GetOffset( GetMaxObjectSize(), GetAlignment() ) );
+        FixedAllocator & allocator = pool_[ index ];
+        assert( allocator.BlockSize() >= numBytes );
+        assert( allocator.BlockSize() < numBytes + GetAlignment() );
+#ifdef LOKI_SMALL_OBJECT_ATOMIC_FREELIST
+        allocator.DrainPendingFrees();
+#endif
+        made = allocator.AllocateBatch( out, count );
+        if ( ( made < count ) && TrimExcessMemory() )
+            made += allocator.AllocateBatch( out + made, count - made );
+    }
+
+    if ( ( made < count ) && doThrow )
+    {
+        // Provide the strong guarantee by returning the partial batch
+        // before reporting failure.
+        DeallocateBatch( out, made, numBytes );
+        throw std::bad_alloc();
+    }
+    return made;
+}
+
+// SmallObjAllocator::DeallocateBatch -----------------------------------------
+
+void SmallObjAllocator::DeallocateBatch( void ** blocks, std::size_t count,
+    std::size_t numBytes )
+{
+    if ( shutdown_ ) return;
+    assert( NULL != blocks );
+    if ( numBytes > GetMaxObjectSize() )
+    {
+        for ( std::size_t ii = 0; ii < count; ++ii )
+        {
+            if ( NULL != blocks[ ii ] )
+                DefaultDeallocator( blocks[ ii ] );
+        }
+        return;
+    }
+    assert( NULL != pool_ );
+    if ( 0 == numBytes ) numBytes = 1;
+    const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    assert( index < GetOffset( GetMaxObjectSize(), GetAlignment() ) );
+    FixedAllocator & allocator = pool_[ index ];
+    assert( allocator.BlockSize() >= numBytes );
+    assert( allocator.BlockSize() < numBytes + GetAlignment() );
+    const bool foundAll = allocator.DeallocateBatch( blocks, count );
+    (void) foundAll;
+    assert( foundAll );
+}
+
 // SmallObjAllocator::Deallocate ----------------------------------------------
 
 void SmallObjAllocator::Deallocate( void * p )
 {
+    if ( shutdown_ ) return;
     if ( NULL == p ) return;
+    if ( !TryDeallocate( p ) )
+        DefaultDeallocator( p );
+}
+
+// SmallObjAllocator::TryDeallocate -------------------------------------------
+
+bool SmallObjAllocator::TryDeallocate( void * p )
+{
+    // Post-shutdown everything is already released; claim the block so
+    // the caller does not hand it to the default deallocator.
+    if ( shutdown_ ) return true;
+    if ( NULL == p ) return false;
     assert( NULL != pool_ );
     FixedAllocator * pAllocator = NULL;
     const std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
@@ -1183,15 +2802,26 @@ void SmallObjAllocator::Deallocate( void * p )
         }
     }
     if ( NULL == pAllocator )
-    {
-        DefaultDeallocator( p );
-        return;
-    }
+        return false;
 
     assert( NULL != chunk );
     const bool found = pAllocator->Deallocate( p, chunk );
     (void) found;
     assert( found );
+    return true;
+}
+
+// SmallObjAllocator::Owns ----------------------------------------------------
+
+bool SmallObjAllocator::Owns( void * p, std::size_t numBytes ) const
+{
+    if ( NULL == p ) return false;
+    if ( numBytes > GetMaxObjectSize() ) return false;
+    assert( NULL != pool_ );
+    if ( 0 == numBytes ) numBytes = 1;
+    const std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    assert( index < GetOffset( GetMaxObjectSize(), GetAlignment() ) );
+    return NULL != pool_[ index ].HasBlock( p );
 }
 
 // SmallObjAllocator::IsCorrupt -----------------------------------------------
@@ -1222,5 +2852,133 @@ bool SmallObjAllocator::IsCorrupt( void ) const
     return false;
 }
 
+// SmallObjRegion -------------------------------------------------------------
+
+namespace
+{
+
+    /// The calling thread's innermost open region, or NULL.
+#if defined( _MSC_VER )
+    __declspec( thread ) SmallObjRegion * currentRegion = 0;
+#elif defined( __GNUC__ )
+    __thread SmallObjRegion * currentRegion = 0;
+#else
+    // No thread-local storage available - all threads share one open
+    // region, which is only correct in single-threaded programs.
+    SmallObjRegion * currentRegion = 0;
+#endif
+
+}
+
+// ----------------------------------------------------------------------------
+
+SmallObjRegion::SmallObjRegion( std::size_t pageSize )
+    : chunks_()
+    , cursor_( 0 )
+    , end_( 0 )
+    , pageSize_( 0 != pageSize ? pageSize : LOKI_DEFAULT_CHUNK_SIZE )
+    , previous_( currentRegion )
+{
+    currentRegion = this;
+}
+
+// ----------------------------------------------------------------------------
+
+SmallObjRegion::~SmallObjRegion()
+{
+    assert( currentRegion == this );
+    for ( std::size_t ii = 0; ii < chunks_.size(); ++ii )
+    {
+        ::operator delete( chunks_[ ii ].mem );
+    }
+    currentRegion = previous_;
+}
+
+// ----------------------------------------------------------------------------
+
+SmallObjRegion * SmallObjRegion::ThisThread( void )
+{
+    return currentRegion;
+}
+
+// ----------------------------------------------------------------------------
+
+SmallObjRegion * SmallObjRegion::FindOwner( const void * p )
+{
+    for ( SmallObjRegion * region = currentRegion; 0 != region;
+        region = region->previous_ )
+    {
+        if ( region->Owns( p ) )
+            return region;
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void * SmallObjRegion::Allocate( std::size_t size, std::size_t alignment,
+    bool doThrow )
+{
+    if ( 0 == size )
+        size = 1;
+    std::size_t pad = ( 0 == alignment ) ? 0 :
+        ( alignment - reinterpret_cast< std::size_t >( cursor_ ) % alignment )
+            % alignment;
+    if ( static_cast< std::size_t >( end_ - cursor_ ) < pad + size )
+    {
+        // An oversize request gets a chunk of its own, with headroom for
+        // the worst-case alignment fixup of the fresh cursor.
+        const std::size_t needed = size + alignment;
+        if ( !AddPage( needed > pageSize_ ? needed : pageSize_, doThrow ) )
+            return 0;
+        pad = ( 0 == alignment ) ? 0 :
+            ( alignment - reinterpret_cast< std::size_t >( cursor_ )
+                % alignment ) % alignment;
+    }
+    char * place = cursor_ + pad;
+    cursor_ = place + size;
+    return place;
+}
+
+// ----------------------------------------------------------------------------
+
+bool SmallObjRegion::Owns( const void * p ) const
+{
+    const char * cp = static_cast< const char * >( p );
+    for ( std::size_t ii = 0; ii < chunks_.size(); ++ii )
+    {
+        const Page & page = chunks_[ ii ];
+        if ( page.mem <= cp && cp < page.mem + page.size )
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+bool SmallObjRegion::AddPage( std::size_t bytes, bool doThrow )
+{
+    char * mem = doThrow ?
+        static_cast< char * >( ::operator new( bytes ) ) :
+        static_cast< char * >( ::operator new( bytes, std::nothrow ) );
+    if ( 0 == mem )
+        return false;
+    const Page page = { mem, bytes };
+    try
+    {
+        chunks_.push_back( page );
+    }
+    catch ( ... )
+    {
+        ::operator delete( mem );
+        if ( doThrow )
+            throw;
+        return false;
+    }
+    cursor_ = mem;
+    end_ = mem + bytes;
+    return true;
+}
+
 } // end namespace Loki
 
@@ -32,6 +32,78 @@
 namespace Loki
 {
 
+namespace
+{
+
+    /// The calling thread's active reclamation queue, or NULL.
+#if defined( _MSC_VER )
+    __declspec( thread ) ReclamationQueue * currentQueue = 0;
+#elif defined( __GNUC__ )
+    __thread ReclamationQueue * currentQueue = 0;
+#else
+    // No thread-local storage available - all threads share one active
+    // queue, which is only correct in single-threaded programs.
+    ReclamationQueue * currentQueue = 0;
+#endif
+
+}
+
+// ----------------------------------------------------------------------------
+
+ReclamationQueue::ReclamationQueue()
+    : items_()
+    , previous_( currentQueue )
+{
+    currentQueue = this;
+}
+
+// ----------------------------------------------------------------------------
+
+ReclamationQueue::~ReclamationQueue()
+{
+    Drain();
+    assert( currentQueue == this );
+    currentQueue = previous_;
+}
+
+// ----------------------------------------------------------------------------
+
+ReclamationQueue * ReclamationQueue::ThisThread()
+{
+    return currentQueue;
+}
+
+// ----------------------------------------------------------------------------
+
+void ReclamationQueue::Defer( void * p, Destroyer destroyer )
+{
+    assert( 0 != p );
+    assert( 0 != destroyer );
+    Item item;
+    item.p = p;
+    item.destroyer = destroyer;
+    items_.push_back( item );
+}
+
+// ----------------------------------------------------------------------------
+
+std::size_t ReclamationQueue::Drain()
+{
+    std::size_t count = 0;
+    // Destroying an item may defer further destructions into this same
+    // queue, so keep going until it is truly empty.
+    while ( !items_.empty() )
+    {
+        Item item = items_.back();
+        items_.pop_back();
+        item.destroyer( item.p );
+        ++count;
+    }
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+
 namespace Private
 {
 
@@ -308,6 +380,232 @@ bool RefLinkedBase::Merge( RefLinkedBase & rhs )
 
 // ----------------------------------------------------------------------------
 
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+void RefLinkedAtomicBase::LockNode() const
+{
+    while ( !TryLockNode() )
+    {
+        // Critical sections are a few pointer writes, so just spin.
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+bool RefLinkedAtomicBase::TryLockNode() const
+{
+#if defined( _MSC_VER )
+    return 0 == ::_InterlockedExchange( &lock_, 1 );
+#else
+    return 0 == __sync_lock_test_and_set( &lock_, 1 );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void RefLinkedAtomicBase::UnlockNode() const
+{
+#if defined( _MSC_VER )
+    ::_InterlockedExchange( &lock_, 0 );
+#else
+    __sync_lock_release( &lock_ );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+RefLinkedAtomicBase::RefLinkedAtomicBase(const RefLinkedAtomicBase& rhs)
+{
+    prev_ = next_ = this;
+    lock_ = 0;
+    InsertSelfAfter( rhs );
+}
+
+// ----------------------------------------------------------------------------
+
+void RefLinkedAtomicBase::InsertSelfAfter( const RefLinkedAtomicBase & anchor )
+{
+    // This node is not visible to other threads yet, so only the anchor
+    // and its successor need locking.  The successor cannot relink or die
+    // while the anchor's lock is held - leaving its ring needs that lock.
+    for (;;)
+    {
+        anchor.LockNode();
+        const RefLinkedAtomicBase * n = anchor.next_;
+        if ( n == &anchor )
+        {
+            // Ring of one: only the anchor's own links change.
+            prev_ = &anchor;
+            next_ = &anchor;
+            anchor.prev_ = this;
+            anchor.next_ = this;
+            anchor.UnlockNode();
+            return;
+        }
+        if ( n->TryLockNode() )
+        {
+            prev_ = &anchor;
+            next_ = n;
+            anchor.next_ = this;
+            n->prev_ = this;
+            n->UnlockNode();
+            anchor.UnlockNode();
+            return;
+        }
+        // A neighbor is busy; back off so its operation can finish.
+        anchor.UnlockNode();
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+bool RefLinkedAtomicBase::UnlinkSelf()
+{
+    for (;;)
+    {
+        LockNode();
+        if ( next_ == this )
+        {
+            assert( prev_ == this );
+            UnlockNode();
+            return true;
+        }
+        // Holding our own lock pins both neighbors - relinking or
+        // destroying either one needs this node's lock - so they stay
+        // valid while their locks are tried.
+        const RefLinkedAtomicBase * p = prev_;
+        const RefLinkedAtomicBase * n = next_;
+        if ( p->TryLockNode() )
+        {
+            if ( p == n || n->TryLockNode() )
+            {
+                p->next_ = n;
+                n->prev_ = p;
+                if ( p != n )
+                    n->UnlockNode();
+                p->UnlockNode();
+                prev_ = next_ = this;
+                UnlockNode();
+                return false;
+            }
+            p->UnlockNode();
+        }
+        UnlockNode();
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+bool RefLinkedAtomicBase::Release()
+{
+    // The re-entrancy check must happen under the lock too - a neighbor
+    // leaving the ring writes this node's links while holding its lock.
+    LockNode();
+    if ( NULL == next_ )
+    {
+        assert( NULL == prev_ );
+        UnlockNode();
+        // Return false so it does not try to destroy shared object
+        // more than once.
+        return false;
+    }
+    UnlockNode();
+    if ( UnlinkSelf() )
+    {
+        // Last owner.  No other thread can join the ring any more - doing
+        // so means copying a SmartPtr that is being destroyed, which is
+        // the caller's race, as with the counted policies.
+        prev_ = NULL;
+        next_ = NULL;
+        return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+void RefLinkedAtomicBase::Swap(RefLinkedAtomicBase& rhs)
+{
+    if ( this == &rhs )
+        return;
+    // Both nodes belong to the calling thread, but their ring neighbors
+    // do not, so neither ring may be anchored through a neighbor.  The
+    // dummies are inserted next to the owned nodes and hold each ring in
+    // place while this and rhs float across; every step is one locked
+    // splice, so both rings are consistent at all times.
+    RefLinkedAtomicBase dummy1;
+    RefLinkedAtomicBase dummy2;
+    dummy1.InsertSelfAfter( *this );
+    dummy2.InsertSelfAfter( rhs );
+    UnlinkSelf();
+    rhs.UnlinkSelf();
+    InsertSelfAfter( dummy2 );
+    rhs.InsertSelfAfter( dummy1 );
+    dummy2.UnlinkSelf();
+    dummy1.UnlinkSelf();
+}
+
+// ----------------------------------------------------------------------------
+
+bool RefLinkedAtomicBase::Merge( RefLinkedAtomicBase & rhs )
+{
+    // Whole-ring operation - see the header warning: both rings must be
+    // quiescent, so no locks are taken here.
+    if ( NULL == next_ )
+    {
+        assert( NULL == prev_ );
+        return false;
+    }
+    RefLinkedAtomicBase * prhs = &rhs;
+    if ( prhs == this )
+        return true;
+    if ( NULL == prhs->next_ )
+    {
+        assert( NULL == prhs->prev_ );
+        return true;
+    }
+    // If rhs node is already in this cycle, then no need to merge.
+    for ( const RefLinkedAtomicBase * node = next_; ; node = node->next_ )
+    {
+        if ( node == prhs )
+            return true;
+        if ( node == this )
+            break;
+    }
+
+    if ( prhs == prhs->next_ )
+    {
+        /// rhs is in a cycle with 1 node.
+        assert( prhs->prev_ == prhs );
+        prhs->prev_ = prev_;
+        prhs->next_ = this;
+        prev_->next_ = prhs;
+        prev_ = prhs;
+    }
+    else if ( this == next_ )
+    {
+        /// this is in a cycle with 1 node.
+        assert( prev_ == this );
+        prev_ = prhs->prev_;
+        next_ = prhs;
+        prhs->prev_->next_ = this;
+        prhs->prev_ = this;
+    }
+    else
+    {
+        const RefLinkedAtomicBase * oldNext = next_;
+        oldNext->prev_ = prhs->prev_;
+        prhs->prev_->next_ = oldNext;
+        next_ = prhs;
+        prhs->prev_ = this;
+    }
+    return true;
+}
+
+#endif // LOKI_SMARTPTR_ATOMIC_REFCOUNT
+
+// ----------------------------------------------------------------------------
+
 } // end namespace Private
 
 } // end namespace Loki
@@ -110,6 +110,32 @@ void TwoRefCounts::ZapPointer( void )
     }
 }
 
+// ----------------------------------------------------------------------------
+
+Loki::Private::TwoRefCountInfo * TwoRefCounts::CreateSpareRecord(
+    bool strong, unsigned int count )
+{
+    void * temp = SmallObject<>::operator new(
+        sizeof(Loki::Private::TwoRefCountInfo) );
+#ifdef DO_EXTRA_LOKI_TESTS
+    assert( temp != 0 );
+#endif
+    Loki::Private::TwoRefCountInfo * info =
+        new ( temp ) Loki::Private::TwoRefCountInfo( strong );
+    for ( unsigned int i = 1; i < count; ++i )
+    {
+        if ( strong )
+        {
+            info->IncStrongCount();
+        }
+        else
+        {
+            info->IncWeakCount();
+        }
+    }
+    return info;
+}
+
 
 // ----------------------------------------------------------------------------
 
@@ -0,0 +1,572 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// ThreadPool facility for the Loki Library
+// Copyright (c) 2008 Richard Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+/// @file ThreadPool.cpp Contains functions needed by ThreadPool class.
+
+// ----------------------------------------------------------------------------
+
+#include <loki/ThreadPool.h>
+
+#include <stdexcept>
+
+#include <assert.h>
+
+#if defined( _MSC_VER )
+    #include <process.h>
+#else
+    #include <unistd.h> // declares sysconf
+#endif
+
+
+using namespace ::std;
+
+// define nullptr even though new compilers will have this keyword just so we
+// have a consistent and easy way of identifying which uses of 0 mean null.
+#define nullptr 0
+
+/** @par thread_local Keyword
+ The pool requires compilers to provide thread local storage - meaning each
+ thread gets its own copy of the data.  The next version of C++ will have a
+ new keyword, thread_local for that purpose.  Some existing compilers already
+ provide thread local storage using different syntax, so these lines use
+ thread_local to mimic that syntax.  If your compiler provides thread local
+ storage but using different syntax besides "thread_local", you may want to
+ modify these lines.  If your compiler does not support thread local storage,
+ you can't use ThreadPool.
+ */
+#ifndef LOKI_THREAD_LOCAL
+    #if defined( _MSC_VER )
+        #if ( _MSC_VER >= 1300 )
+            #define LOKI_THREAD_LOCAL __declspec( thread )
+        #else
+            #error "Only Visual Studio versions 7.0 and after supported."
+        #endif
+
+    #elif ( __GNUC__ )
+        #define LOKI_THREAD_LOCAL __thread
+
+    #else
+        #warning "Check if your compiler provides thread local storage."
+        #define LOKI_THREAD_LOCAL thread_local
+    #endif
+#endif
+
+/// Anonymous namespace hides some data which are implementation details.
+namespace
+{
+
+/// Pool whose worker is running on the calling thread, if any.  This is how
+/// AddTask knows a task is spawning another task, and which deque is the
+/// calling worker's own.
+LOKI_THREAD_LOCAL ::Loki::ThreadPool * s_currentPool = nullptr;
+
+/// Index of the calling worker thread within s_currentPool.
+LOKI_THREAD_LOCAL unsigned int s_currentWorkerIndex = 0;
+
+/// How many milliseconds a worker with no tasks sleeps before looking again.
+/// Only the Windows branch polls; pthreads wait on a condition variable.
+static const unsigned int wakeCheckTime = 10;
+
+} // end anonymous namespace
+
+namespace Loki
+{
+
+// ----------------------------------------------------------------------------
+
+unsigned int ThreadPool::GetProcessorCount( void )
+{
+#if defined( _MSC_VER )
+    SYSTEM_INFO info;
+    ::GetSystemInfo( &info );
+    const long count = static_cast< long >( info.dwNumberOfProcessors );
+#else
+    const long count = ::sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+    return ( count < 1 ) ? 1 : static_cast< unsigned int >( count );
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadPool::ThreadPool( unsigned int threadCount ) :
+    m_workers(),
+    m_nextWorker( 0 ),
+    m_pendingCount( 0 ),
+    m_queuedCount( 0 ),
+    m_stop( false )
+{
+    if ( 0 == threadCount )
+        threadCount = GetProcessorCount();
+
+#if defined( _MSC_VER )
+    ::InitializeCriticalSection( &m_mutex );
+    m_wakeEvent = ::CreateEvent( nullptr, FALSE, FALSE, nullptr );
+    m_idleEvent = ::CreateEvent( nullptr, TRUE, TRUE, nullptr );
+    if ( ( nullptr == m_wakeEvent ) || ( nullptr == m_idleEvent ) )
+    {
+        if ( nullptr != m_wakeEvent )
+            ::CloseHandle( m_wakeEvent );
+        if ( nullptr != m_idleEvent )
+            ::CloseHandle( m_idleEvent );
+        ::DeleteCriticalSection( &m_mutex );
+        throw runtime_error( "ThreadPool could not make its events." );
+    }
+#else
+    if ( ( 0 != ::pthread_mutex_init( &m_mutex, 0 ) )
+      || ( 0 != ::pthread_cond_init( &m_wakeCondition, 0 ) )
+      || ( 0 != ::pthread_cond_init( &m_idleCondition, 0 ) ) )
+        throw runtime_error(
+            "ThreadPool could not make its synchronization primitives." );
+#endif
+
+    try
+    {
+        m_workers.reserve( threadCount );
+        for ( unsigned int ii = 0; ii < threadCount; ++ii )
+            m_workers.push_back( new Worker( this, ii ) );
+        // All workers exist before any thread starts, so no thread ever
+        // tries to steal from a partly built pool.
+        for ( unsigned int ii = 0; ii < threadCount; ++ii )
+            m_workers[ ii ]->Start();
+    }
+    catch ( ... )
+    {
+        m_stop = true;
+        for ( WorkersIter it( m_workers.begin() ); it != m_workers.end(); ++it )
+        {
+            ( *it )->Stop();
+            delete *it;
+        }
+#if defined( _MSC_VER )
+        ::CloseHandle( m_wakeEvent );
+        ::CloseHandle( m_idleEvent );
+        ::DeleteCriticalSection( &m_mutex );
+#else
+        ::pthread_cond_destroy( &m_idleCondition );
+        ::pthread_cond_destroy( &m_wakeCondition );
+        ::pthread_mutex_destroy( &m_mutex );
+#endif
+        throw;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadPool::~ThreadPool( void )
+{
+    assert( s_currentPool != this );
+
+    try
+    {
+        WaitForIdle();
+
+#if defined( _MSC_VER )
+        ::EnterCriticalSection( &m_mutex );
+        m_stop = true;
+        ::LeaveCriticalSection( &m_mutex );
+#else
+        ::pthread_mutex_lock( &m_mutex );
+        m_stop = true;
+        ::pthread_cond_broadcast( &m_wakeCondition );
+        ::pthread_mutex_unlock( &m_mutex );
+#endif
+
+        for ( WorkersIter it( m_workers.begin() ); it != m_workers.end(); ++it )
+        {
+            ( *it )->Stop();
+            delete *it;
+        }
+
+#if defined( _MSC_VER )
+        ::CloseHandle( m_wakeEvent );
+        ::CloseHandle( m_idleEvent );
+        ::DeleteCriticalSection( &m_mutex );
+#else
+        ::pthread_cond_destroy( &m_idleCondition );
+        ::pthread_cond_destroy( &m_wakeCondition );
+        ::pthread_mutex_destroy( &m_mutex );
+#endif
+    }
+    catch ( ... )
+    {
+        // Not much we can do after catching an exception inside a destructor!
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::AddTask( const Task & task )
+{
+    if ( !task )
+        return;
+
+    // Count the task before making it visible so a worker which grabs it
+    // immediately can't drive the pending count negative.
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_mutex );
+    if ( 0 == m_pendingCount )
+        ::ResetEvent( m_idleEvent );
+    ++m_pendingCount;
+    ++m_queuedCount;
+    const unsigned int target = m_nextWorker;
+    m_nextWorker = ( m_nextWorker + 1 ) % m_workers.size();
+    ::LeaveCriticalSection( &m_mutex );
+#else
+    ::pthread_mutex_lock( &m_mutex );
+    ++m_pendingCount;
+    ++m_queuedCount;
+    const unsigned int target = m_nextWorker;
+    m_nextWorker = ( m_nextWorker + 1 ) % m_workers.size();
+    ::pthread_mutex_unlock( &m_mutex );
+#endif
+
+    try
+    {
+        if ( s_currentPool == this )
+        {
+            // A task is spawning another task.  Place it at the back of the
+            // calling worker's own deque so it likely runs next on this
+            // thread while its data is still in this core's cache.
+            m_workers[ s_currentWorkerIndex ]->Push( task, true );
+        }
+        else
+        {
+            m_workers[ target ]->Push( task, false );
+        }
+    }
+    catch ( ... )
+    {
+#if defined( _MSC_VER )
+        ::EnterCriticalSection( &m_mutex );
+        --m_queuedCount;
+        --m_pendingCount;
+        if ( 0 == m_pendingCount )
+            ::SetEvent( m_idleEvent );
+        ::LeaveCriticalSection( &m_mutex );
+#else
+        ::pthread_mutex_lock( &m_mutex );
+        --m_queuedCount;
+        --m_pendingCount;
+        ::pthread_mutex_unlock( &m_mutex );
+#endif
+        throw;
+    }
+
+#if defined( _MSC_VER )
+    ::SetEvent( m_wakeEvent );
+#else
+    ::pthread_mutex_lock( &m_mutex );
+    ::pthread_cond_signal( &m_wakeCondition );
+    ::pthread_mutex_unlock( &m_mutex );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::WaitForIdle( void )
+{
+    assert( s_currentPool != this );
+
+#if defined( _MSC_VER )
+    ::WaitForSingleObject( m_idleEvent, INFINITE );
+#else
+    ::pthread_mutex_lock( &m_mutex );
+    while ( 0 != m_pendingCount )
+        ::pthread_cond_wait( &m_idleCondition, &m_mutex );
+    ::pthread_mutex_unlock( &m_mutex );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadPool::FindTask( unsigned int index, Task & task )
+{
+    assert( index < m_workers.size() );
+
+    bool found = m_workers[ index ]->PopBack( task );
+    if ( !found )
+    {
+        // Steal sweep.  Starting just past the caller spreads the thieves
+        // over different victims instead of mobbing worker zero.
+        const unsigned int count = m_workers.size();
+        for ( unsigned int offset = 1; offset < count; ++offset )
+        {
+            if ( m_workers[ ( index + offset ) % count ]->Steal( task ) )
+            {
+                found = true;
+                break;
+            }
+        }
+    }
+    if ( !found )
+        return false;
+
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_mutex );
+    --m_queuedCount;
+    ::LeaveCriticalSection( &m_mutex );
+#else
+    ::pthread_mutex_lock( &m_mutex );
+    --m_queuedCount;
+    ::pthread_mutex_unlock( &m_mutex );
+#endif
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::TaskDone( void )
+{
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_mutex );
+    assert( 0 != m_pendingCount );
+    --m_pendingCount;
+    if ( 0 == m_pendingCount )
+        ::SetEvent( m_idleEvent );
+    ::LeaveCriticalSection( &m_mutex );
+#else
+    ::pthread_mutex_lock( &m_mutex );
+    assert( 0 != m_pendingCount );
+    --m_pendingCount;
+    if ( 0 == m_pendingCount )
+        ::pthread_cond_broadcast( &m_idleCondition );
+    ::pthread_mutex_unlock( &m_mutex );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadPool::Worker::Worker( ThreadPool * owner, unsigned int index ) :
+    m_owner( owner ),
+    m_index( index ),
+    m_tasks(),
+    m_tasksMutex(),
+    m_thread(),
+    m_started( false )
+{
+    assert( nullptr != owner );
+#if defined( _MSC_VER )
+    ::InitializeCriticalSection( &m_tasksMutex );
+#else
+    if ( 0 != ::pthread_mutex_init( &m_tasksMutex, 0 ) )
+        throw runtime_error( "ThreadPool worker could not make its mutex." );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadPool::Worker::~Worker( void )
+{
+    assert( m_tasks.empty() );
+#if defined( _MSC_VER )
+    ::DeleteCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_destroy( &m_tasksMutex );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::Worker::Start( void )
+{
+#if defined( _MSC_VER )
+    m_thread = reinterpret_cast< HANDLE >(
+        ::_beginthreadex( nullptr, 0, TopFunction, this, 0, nullptr ) );
+    if ( nullptr == m_thread )
+        throw runtime_error( "ThreadPool could not make a worker thread." );
+#else
+    if ( 0 != ::pthread_create( &m_thread, nullptr, TopFunction, this ) )
+        throw runtime_error( "ThreadPool could not make a worker thread." );
+#endif
+    m_started = true;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::Worker::Stop( void )
+{
+    if ( !m_started )
+        return;
+#if defined( _MSC_VER )
+    ::WaitForSingleObject( m_thread, INFINITE );
+    ::CloseHandle( m_thread );
+    m_thread = nullptr;
+#else
+    ::pthread_join( m_thread, nullptr );
+#endif
+    m_started = false;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::Worker::Push( const Task & task, bool atBack )
+{
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_tasksMutex );
+    try
+    {
+        if ( atBack )
+            m_tasks.push_back( task );
+        else
+            m_tasks.push_front( task );
+    }
+    catch ( ... )
+    {
+        ::LeaveCriticalSection( &m_tasksMutex );
+        throw;
+    }
+    ::LeaveCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_lock( &m_tasksMutex );
+    try
+    {
+        if ( atBack )
+            m_tasks.push_back( task );
+        else
+            m_tasks.push_front( task );
+    }
+    catch ( ... )
+    {
+        ::pthread_mutex_unlock( &m_tasksMutex );
+        throw;
+    }
+    ::pthread_mutex_unlock( &m_tasksMutex );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadPool::Worker::PopBack( Task & task )
+{
+    bool found = false;
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_lock( &m_tasksMutex );
+#endif
+    if ( !m_tasks.empty() )
+    {
+        task = m_tasks.back();
+        m_tasks.pop_back();
+        found = true;
+    }
+#if defined( _MSC_VER )
+    ::LeaveCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_unlock( &m_tasksMutex );
+#endif
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadPool::Worker::Steal( Task & task )
+{
+    bool found = false;
+#if defined( _MSC_VER )
+    ::EnterCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_lock( &m_tasksMutex );
+#endif
+    if ( !m_tasks.empty() )
+    {
+        task = m_tasks.front();
+        m_tasks.pop_front();
+        found = true;
+    }
+#if defined( _MSC_VER )
+    ::LeaveCriticalSection( &m_tasksMutex );
+#else
+    ::pthread_mutex_unlock( &m_tasksMutex );
+#endif
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined( _MSC_VER )
+    unsigned int __stdcall ThreadPool::Worker::TopFunction( void * p )
+#else
+    void * ThreadPool::Worker::TopFunction( void * p )
+#endif
+{
+    assert( nullptr != p );
+
+    Worker * worker = reinterpret_cast< Worker * >( p );
+    s_currentPool = worker->m_owner;
+    s_currentWorkerIndex = worker->m_index;
+    worker->Run();
+    s_currentPool = nullptr;
+
+#if defined( _MSC_VER )
+    return 0;
+#else
+    return nullptr;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadPool::Worker::Run( void )
+{
+    Task task;
+    for ( ;; )
+    {
+        if ( m_owner->FindTask( m_index, task ) )
+        {
+            try
+            {
+                task();
+            }
+            catch ( ... )
+            {
+                // Swallow the exception so one bad task can't kill a
+                // worker thread.  Tasks are not supposed to throw.
+            }
+            // Drop the pool's copy before reporting done, or a functor
+            // owning resources would outlive its task.
+            task = Task();
+            m_owner->TaskDone();
+            continue;
+        }
+
+        // No tasks anywhere, so sleep until more work arrives.
+#if defined( _MSC_VER )
+        // The auto-reset event latches only one wake-up, so a timed wait
+        // covers any wake-ups lost while several workers go idle at once.
+        ::EnterCriticalSection( &m_owner->m_mutex );
+        const bool done = ( m_owner->m_stop ) && ( 0 == m_owner->m_queuedCount );
+        ::LeaveCriticalSection( &m_owner->m_mutex );
+        if ( done )
+            break;
+        ::WaitForSingleObject( m_owner->m_wakeEvent, wakeCheckTime );
+#else
+        ::pthread_mutex_lock( &m_owner->m_mutex );
+        while ( ( 0 == m_owner->m_queuedCount ) && ( !m_owner->m_stop ) )
+            ::pthread_cond_wait( &m_owner->m_wakeCondition, &m_owner->m_mutex );
+        const bool done = ( m_owner->m_stop ) && ( 0 == m_owner->m_queuedCount );
+        ::pthread_mutex_unlock( &m_owner->m_mutex );
+        if ( done )
+            break;
+#endif
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+} // end namespace Loki
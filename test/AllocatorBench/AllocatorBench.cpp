@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Compares LokiAllocator against std::allocator for the node-based standard
+// containers, so the decision which instantiations should adopt it rests on
+// numbers instead of folklore.  For each payload size the benchmark times
+// filling and clearing a std::list and a std::map, single-threaded and -
+// when built with a Loki threading macro - on several threads at once, and
+// finally prints the per-instantiation usage counters LokiAllocator collects
+// with LOKI_ALLOCATOR_TRACK_USAGE (including the refusals of requests too
+// big for the small-object allocator).
+//
+// ----------------------------------------------------------------------------
+
+#define LOKI_ALLOCATOR_TRACK_USAGE
+
+#include <loki/Allocator.h>
+#include "../benchmark.h"
+
+#include <cstddef>
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+
+#if defined(LOKI_CLASS_LEVEL_THREADING) || defined(LOKI_OBJECT_LEVEL_THREADING)
+    #define ALLOC_BENCH_THREADS
+    #if defined(_WIN32)
+        #include <process.h>
+        #include <windows.h>
+    #else
+        #include <pthread.h>
+    #endif
+#endif
+
+using namespace std;
+
+// how many nodes one timed pass builds and tears down
+static const size_t nodesPerRun = 100000;
+static const unsigned long runs = 5;
+
+// ----------------------------------------------------------------------------
+
+template < unsigned int size >
+struct Payload
+{
+    Payload( void ) { bytes[ 0 ] = 0; }
+    explicit Payload( char c ) { bytes[ 0 ] = c; }
+    char bytes[ size ];
+};
+
+// ----------------------------------------------------------------------------
+
+/// Fills a list with nodes and destroys it; returns median ns per node.
+template < class List >
+double TimeListFill( void )
+{
+    ::std::vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        {
+            List nodes;
+            for ( size_t i = 0; i < nodesPerRun; ++i )
+                nodes.push_back( typename List::value_type() );
+            LokiBench::DoNotOptimize( nodes );
+        }
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / nodesPerRun );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Inserts and erases map nodes; returns median ns per node.
+template < class Map >
+double TimeMapChurn( void )
+{
+    ::std::vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        {
+            Map nodes;
+            for ( size_t i = 0; i < nodesPerRun; ++i )
+                nodes.insert( typename Map::value_type(
+                    static_cast< int >( i ), typename Map::mapped_type() ) );
+            LokiBench::DoNotOptimize( nodes );
+        }
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / nodesPerRun );
+    }
+    return LokiBench::Median( samples );
+}
+
+static void Report( const char * what, double stdNs, double lokiNs )
+{
+    cout << what << "\tstd: " << stdNs << " ns/node\tloki: " << lokiNs
+        << " ns/node\tspeed-up: "
+        << ( lokiNs != 0.0 ? stdNs / lokiNs : 0.0 ) << endl;
+}
+
+template < unsigned int size >
+void CompareSingleThreaded( void )
+{
+    typedef Payload< size > P;
+    cout << "payload " << size << " bytes:" << endl;
+    Report( "  list fill+clear",
+        TimeListFill< list< P > >(),
+        TimeListFill< list< P, Loki::LokiAllocator< P > > >() );
+    Report( "  map  fill+clear",
+        TimeMapChurn< map< int, P > >(),
+        TimeMapChurn< map< int, P, less< int >,
+            Loki::LokiAllocator< pair< const int, P > > > >() );
+}
+
+// ----------------------------------------------------------------------------
+
+#ifdef ALLOC_BENCH_THREADS
+
+namespace MtBench
+{
+    volatile bool startFlag = false;
+
+    inline void WaitForStart( void )
+    {
+        while ( !startFlag ) {}
+    }
+
+    template < class List >
+    struct ListWorker
+    {
+        double seconds;
+
+        static void * Run( void * self )
+        {
+            ListWorker * worker = static_cast< ListWorker * >( self );
+            WaitForStart();
+            LokiBench::Stopwatch watch;
+            watch.Start();
+            {
+                List nodes;
+                for ( size_t i = 0; i < nodesPerRun; ++i )
+                    nodes.push_back( typename List::value_type() );
+                LokiBench::DoNotOptimize( nodes );
+            }
+            watch.Stop();
+            worker->seconds = watch.Nanoseconds() / 1e9;
+            return 0;
+        }
+    };
+
+    class BenchThread
+    {
+    public:
+        void Start( void * ( *callback )( void * ), void * parameter )
+        {
+#if defined(_WIN32)
+            handle_ = ( HANDLE )_beginthreadex( 0, 0,
+                ( unsigned ( __stdcall * )( void * ) )callback, parameter, 0, 0 );
+#else
+            ::pthread_create( &handle_, 0, callback, parameter );
+#endif
+        }
+        void Join( void )
+        {
+#if defined(_WIN32)
+            ::WaitForSingleObject( handle_, INFINITE );
+            ::CloseHandle( handle_ );
+#else
+            ::pthread_join( handle_, 0 );
+#endif
+        }
+    private:
+#if defined(_WIN32)
+        HANDLE handle_;
+#else
+        pthread_t handle_;
+#endif
+    };
+
+    template < class List >
+    double RunThreads( unsigned int threadCount )
+    {
+        ::std::vector< ListWorker< List > > workers( threadCount );
+        ::std::vector< BenchThread > threads( threadCount );
+        startFlag = false;
+        for ( unsigned int t = 0; t < threadCount; ++t )
+            threads[ t ].Start( &ListWorker< List >::Run, &workers[ t ] );
+        startFlag = true;
+        double worst = 0.0;
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            threads[ t ].Join();
+            if ( workers[ t ].seconds > worst )
+                worst = workers[ t ].seconds;
+        }
+        // aggregate throughput: all threads' nodes over the slowest thread
+        return ( threadCount * nodesPerRun ) / worst / 1000.0;
+    }
+
+    template < unsigned int size >
+    void CompareThreaded( void )
+    {
+        typedef Payload< size > P;
+        const unsigned int threadCounts[] = { 1, 2, 4 };
+        cout << "payload " << size << " bytes, list fill+clear:" << endl;
+        for ( unsigned int i = 0;
+            i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i )
+        {
+            const unsigned int threadCount = threadCounts[ i ];
+            const double stdK = RunThreads< list< P > >( threadCount );
+            const double lokiK =
+                RunThreads< list< P, Loki::LokiAllocator< P > > >( threadCount );
+            cout << "  " << threadCount << " thread(s)\tstd: " << stdK
+                << " knodes/s\tloki: " << lokiK << " knodes/s\tspeed-up: "
+                << ( stdK != 0.0 ? lokiK / stdK : 0.0 ) << endl;
+        }
+    }
+}
+
+#endif // ALLOC_BENCH_THREADS
+
+// ----------------------------------------------------------------------------
+
+static void PrintUsage( void )
+{
+    cout << endl << "LokiAllocator instantiations (after rebind):" << endl;
+    for ( const Loki::AllocatorUsage * usage = Loki::AllocatorUsageHead();
+        usage != 0; usage = usage->next )
+    {
+        cout << "  " << usage->elementName << " (" << usage->elementSize
+            << " bytes): " << usage->allocations << " allocations, "
+            << usage->bytes << " bytes, " << usage->refusals
+            << " refusals over the small-object limit" << endl;
+    }
+}
+
+int main( void )
+{
+    cout << "AllocatorBench: " << nodesPerRun << " nodes per run, median of "
+        << runs << " runs" << endl << endl;
+
+    CompareSingleThreaded< 8 >();
+    CompareSingleThreaded< 32 >();
+    CompareSingleThreaded< 128 >();
+    // payload past LOKI_MAX_SMALL_OBJECT_SIZE: every request is refused and
+    // forwarded, so this line shows the cost of adopting it wrongly
+    CompareSingleThreaded< 512 >();
+
+#ifdef ALLOC_BENCH_THREADS
+    cout << endl << "multithreaded:" << endl;
+    MtBench::CompareThreaded< 8 >();
+    MtBench::CompareThreaded< 32 >();
+#endif
+
+    PrintUsage();
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,367 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Settles with numbers when AssocVector beats the node-based maps.  For each
+// key type (int, an 8-byte POD, flex_string) and each size from 16 up to 16M
+// entries, the benchmark times against std::map - and, where the compiler
+// provides one, a hash map - the operations the argument is usually about:
+//   - insert        one element at a time, in random key order;
+//   - build         from an already sorted range, AssocVector's best case;
+//   - find hit      probes for keys that are present, in random order;
+//   - find miss     probes for keys that are absent;
+//   - iterate       one pass accumulating the mapped values;
+//   - erase         removal of every other key.
+// Random single inserts and erases are AssocVector's quadratic worst case, so
+// beyond a threshold size they are skipped and printed as '-'; that cliff is
+// part of the answer, not a measurement artifact.
+//
+// The default sweep stops at 64K entries to keep a casual run short; pass the
+// largest size on the command line (up to 16M) for the full series, e.g.
+//     ./AssocVectorBench 16777216
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/AssocVector.h>
+#include <loki/flex/flex_string.h>
+#include "../benchmark.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#if defined( __GNUC__ )
+    #include <tr1/unordered_map>
+    #define ASSOC_BENCH_HAS_HASH_MAP 1
+#else
+    #define ASSOC_BENCH_HAS_HASH_MAP 0
+#endif
+
+using namespace std;
+
+static const unsigned long runs = 5;
+
+/// Random single insert or erase into an AssocVector moves half the table
+/// per call; above this size one timed pass would take minutes, so the
+/// benchmark reports '-' instead.
+static const size_t singleOpCeiling = 65536;
+
+typedef flex_string< char > BenchString;
+
+// ----------------------------------------------------------------------------
+
+/// The 8-byte POD key: two ints ordered lexicographically.
+struct PodKey
+{
+    int hi;
+    int lo;
+};
+
+inline bool operator<( const PodKey & a, const PodKey & b )
+{
+    return a.hi < b.hi || ( a.hi == b.hi && a.lo < b.lo );
+}
+
+inline bool operator==( const PodKey & a, const PodKey & b )
+{
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Makes the i-th key of each type.  Even seeds make the resident keys,
+/// odd seeds the keys every lookup of the miss column asks for in vain.
+inline void MakeKey( size_t seed, int & key )
+{
+    key = static_cast< int >( seed );
+}
+
+inline void MakeKey( size_t seed, PodKey & key )
+{
+    key.hi = static_cast< int >( seed >> 16 );
+    key.lo = static_cast< int >( seed & 0xFFFF );
+}
+
+inline void MakeKey( size_t seed, BenchString & key )
+{
+    char buffer[ 24 ];
+    ::std::sprintf( buffer, "key_%012lu", static_cast< unsigned long >( seed ) );
+    key = BenchString( buffer );
+}
+
+// ----------------------------------------------------------------------------
+
+#if ASSOC_BENCH_HAS_HASH_MAP
+
+/// One hasher for all three key types, so the hash map columns exist for
+/// each of them.
+struct BenchHasher
+{
+    size_t operator()( int key ) const
+    {
+        return static_cast< size_t >( key ) * 2654435761u;
+    }
+    size_t operator()( const PodKey & key ) const
+    {
+        return ( static_cast< size_t >( key.hi ) * 2654435761u )
+            ^ static_cast< size_t >( key.lo );
+    }
+    size_t operator()( const BenchString & key ) const
+    {
+        // FNV-1a over the characters
+        size_t hash = 2166136261u;
+        for ( size_t i = 0; i < key.size(); ++i )
+        {
+            hash ^= static_cast< unsigned char >( key[ i ] );
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+};
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+/// Median ns per element for inserting the keys one by one in random order.
+template < class Map, class Key >
+double TimeInsert( const vector< Key > & shuffled )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Map table;
+        watch.Start();
+        for ( size_t i = 0; i < shuffled.size(); ++i )
+            table.insert( make_pair( shuffled[ i ], static_cast< unsigned >( i ) ) );
+        watch.Stop();
+        LokiBench::DoNotOptimize( table );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( shuffled.size() ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per element for constructing from an already sorted range.
+template < class Map, class Pair >
+double TimeBuild( const vector< Pair > & sorted )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        Map table( sorted.begin(), sorted.end() );
+        watch.Stop();
+        LokiBench::DoNotOptimize( table );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( sorted.size() ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per probe over the given probe keys; hits and misses are the
+/// same code, only the probe vector differs.
+template < class Map, class Key >
+double TimeFind( const Map & table, const vector< Key > & probes )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        unsigned found = 0;
+        watch.Start();
+        for ( size_t i = 0; i < probes.size(); ++i )
+        {
+            if ( table.find( probes[ i ] ) != table.end() )
+                ++found;
+        }
+        watch.Stop();
+        LokiBench::DoNotOptimize( found );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( probes.size() ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per element for one full pass summing the mapped values.
+template < class Map >
+double TimeIterate( const Map & table )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        unsigned long sum = 0;
+        watch.Start();
+        for ( typename Map::const_iterator it = table.begin();
+              it != table.end(); ++it )
+            sum += it->second;
+        watch.Stop();
+        LokiBench::DoNotOptimize( sum );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( table.size() ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per erase for removing every other key; the removed keys go
+/// back in between timed passes.
+template < class Map, class Key >
+double TimeErase( Map & table, const vector< Key > & victims )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        for ( size_t i = 0; i < victims.size(); ++i )
+            table.erase( victims[ i ] );
+        watch.Stop();
+        for ( size_t i = 0; i < victims.size(); ++i )
+            table.insert( make_pair( victims[ i ], 0u ) );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( victims.size() ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+// ----------------------------------------------------------------------------
+
+static void PrintCell( double ns )
+{
+    ::std::printf( " %9.1f", ns );
+}
+
+static void PrintSkipped( void )
+{
+    ::std::printf( " %9s", "-" );
+}
+
+/// Runs every measurement for one container over one key set and prints
+/// the row.  skipSingleOps suppresses the per-element insert and erase
+/// columns, used for AssocVector beyond its quadratic cliff.
+template < class Map, class Key, class Pair >
+void BenchOneMap( const char * container,
+                  const vector< Key > & shuffled,
+                  const vector< Pair > & sorted,
+                  const vector< Key > & hitProbes,
+                  const vector< Key > & missProbes,
+                  const vector< Key > & victims,
+                  bool skipSingleOps )
+{
+    ::std::printf( "    %-12s", container );
+    if ( skipSingleOps )
+        PrintSkipped();
+    else
+        PrintCell( TimeInsert< Map >( shuffled ) );
+    PrintCell( TimeBuild< Map >( sorted ) );
+
+    Map table( sorted.begin(), sorted.end() );
+    PrintCell( TimeFind( table, hitProbes ) );
+    PrintCell( TimeFind( table, missProbes ) );
+    PrintCell( TimeIterate( table ) );
+    if ( skipSingleOps )
+        PrintSkipped();
+    else
+        PrintCell( TimeErase( table, victims ) );
+    ::std::printf( "\n" );
+}
+
+// ----------------------------------------------------------------------------
+
+/// Prepares the key material for one (key type, size) combination and
+/// benches every container on it.
+template < class Key >
+void BenchKeyType( const char * keyName, size_t count )
+{
+    typedef pair< Key, unsigned > Pair;
+
+    vector< Key > shuffled( count );
+    vector< Key > missProbes( count );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        MakeKey( 2 * i, shuffled[ i ] );
+        MakeKey( 2 * i + 1, missProbes[ i ] );
+    }
+    random_shuffle( shuffled.begin(), shuffled.end() );
+    random_shuffle( missProbes.begin(), missProbes.end() );
+
+    vector< Key > hitProbes( shuffled );
+    random_shuffle( hitProbes.begin(), hitProbes.end() );
+
+    vector< Pair > sorted( count );
+    for ( size_t i = 0; i < count; ++i )
+        sorted[ i ] = make_pair( shuffled[ i ], static_cast< unsigned >( i ) );
+    sort( sorted.begin(), sorted.end() );
+
+    vector< Key > victims;
+    victims.reserve( count / 2 );
+    for ( size_t i = 0; i < count; i += 2 )
+        victims.push_back( shuffled[ i ] );
+
+    ::std::printf( "  %s keys, %lu entries (ns per operation)\n",
+        keyName, static_cast< unsigned long >( count ) );
+    ::std::printf( "    %-12s %9s %9s %9s %9s %9s %9s\n",
+        "container", "insert", "build", "find-hit", "find-miss",
+        "iterate", "erase" );
+
+    const bool skipSingleOps = ( count > singleOpCeiling );
+    BenchOneMap< Loki::AssocVector< Key, unsigned > >( "AssocVector",
+        shuffled, sorted, hitProbes, missProbes, victims, skipSingleOps );
+    BenchOneMap< map< Key, unsigned > >( "std::map",
+        shuffled, sorted, hitProbes, missProbes, victims, false );
+#if ASSOC_BENCH_HAS_HASH_MAP
+    BenchOneMap< tr1::unordered_map< Key, unsigned, BenchHasher > >( "hash map",
+        shuffled, sorted, hitProbes, missProbes, victims, false );
+#endif
+    ::std::printf( "\n" );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, char * argv[] )
+{
+    size_t maxCount = 65536;
+    if ( argc > 1 )
+        maxCount = static_cast< size_t >( ::std::atol( argv[ 1 ] ) );
+    if ( maxCount > ( 1u << 24 ) )
+        maxCount = ( 1u << 24 );
+
+    static const size_t sizes[] =
+        { 16, 256, 4096, 65536, 1048576, 16777216 };
+    const size_t sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+
+    cout << "AssocVector versus the node-based maps" << endl;
+#if !ASSOC_BENCH_HAS_HASH_MAP
+    cout << "(no hash map available with this compiler)" << endl;
+#endif
+    cout << endl;
+
+    for ( size_t s = 0; s < sizeCount; ++s )
+    {
+        if ( sizes[ s ] > maxCount )
+            break;
+        BenchKeyType< int >( "int", sizes[ s ] );
+        BenchKeyType< PodKey >( "8-byte POD", sizes[ s ] );
+        BenchKeyType< BenchString >( "flex_string", sizes[ s ] );
+    }
+    return 0;
+}
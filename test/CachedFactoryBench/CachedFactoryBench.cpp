@@ -0,0 +1,329 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Replays key streams against CachedFactory so the choice of eviction
+// policy rests on numbers instead of guesswork.  Every stream runs once
+// through each policy - EvictLRU, EvictAging, EvictLRUList (the
+// constant-time LRU) and EvictRandom - over a cache limited by
+// AmountLimitedCreation, and the row reports what a tile cache cares
+// about: the hit ratio, the per-fetch latency distribution (p50/p90/p99,
+// in nanoseconds, timed around CreateObject alone), and how many objects
+// were evicted per second of replay.
+//
+// The synthetic streams cover the classic cases:
+//   - zipfian   skewed popularity (s = 0.99), where LRU-like policies
+//               should shine and random eviction pays for its ignorance;
+//   - scan      one sequential sweep over a universe larger than the
+//               cache, where nothing can hit and eviction cost is bare;
+//   - loop      a cycle slightly longer than the cache, the adversarial
+//               case where strict LRU evicts exactly what comes next.
+//
+// A recorded stream replays with
+//     ./CachedFactoryBench trace <file> [capacity]
+// where <file> holds one integer key per line; keys are remapped to a
+// dense range, so any ids do.  Without a trace the synthetic streams run:
+//     ./CachedFactoryBench [fetches] [capacity]
+// (default 100000 fetches through a 512-object cache).
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/CachedFactory.h>
+#include "../benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+/// Counters the product maintains itself, so the benchmark can meter
+/// creations (misses) and destructions (evictions) without paying for
+/// SimpleStatisticPolicy inside the timed loop.
+static unsigned long tilesCreated = 0;
+static unsigned long tilesDestroyed = 0;
+
+/// The cached product: a tile with a construction cost big enough that
+/// caching it is worth discussing, and small enough that a run is short.
+struct Tile
+{
+    Tile()
+    {
+        for ( size_t i = 0; i < sizeof(payload) / sizeof(payload[0]); ++i )
+            payload[ i ] = static_cast< int >( i );
+        ++tilesCreated;
+    }
+    ~Tile()
+    {
+        ++tilesDestroyed;
+    }
+    int payload[ 256 ];
+};
+
+Tile * CreateTile( void )
+{
+    return new Tile;
+}
+
+// ----------------------------------------------------------------------------
+
+/// One cache per eviction policy; everything else stays at the defaults
+/// except AmountLimitedCreation, which turns the creation cap into the
+/// cache capacity and makes misses beyond it trigger an eviction.
+template < template < typename, typename > class EvictionPolicy >
+struct CacheOf
+{
+    typedef Loki::CachedFactory
+        <
+        Tile, int, Loki::NullType,
+        Loki::SimplePointer,
+        Loki::AmountLimitedCreation,
+        EvictionPolicy
+        >
+        Type;
+};
+
+// ----------------------------------------------------------------------------
+
+/// A fixed-seed linear congruential generator, so every policy replays
+/// the very same stream and runs compare across machines.
+static unsigned long rngState = 2463534242UL;
+
+static inline unsigned long NextRandom( void )
+{
+    rngState = rngState * 1664525UL + 1013904223UL;
+    return ( rngState >> 8 ) & 0xFFFFFFUL;
+}
+
+static inline double NextUniform( void )
+{
+    return static_cast< double >( NextRandom() ) / 16777216.0;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Zipfian keys by inversion: the cumulative popularity of the universe
+/// is tabulated once, and each draw binary-searches a uniform variate
+/// into it.  s = 0.99 is the customary skew for cache studies.
+static void MakeZipfianStream( vector< int > & keys, size_t count,
+    int universe )
+{
+    const double skew = 0.99;
+    vector< double > cdf( static_cast< size_t >( universe ) );
+    double sum = 0;
+    for ( int k = 0; k < universe; ++k )
+    {
+        sum += 1.0 / ::std::pow( static_cast< double >( k + 1 ), skew );
+        cdf[ static_cast< size_t >( k ) ] = sum;
+    }
+    keys.resize( count );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const double draw = NextUniform() * sum;
+        keys[ i ] = static_cast< int >(
+            lower_bound( cdf.begin(), cdf.end(), draw ) - cdf.begin() );
+    }
+}
+
+/// Sequential sweeps over a universe four times the cache: every fetch
+/// is a compulsory miss, which lays the eviction cost bare.
+static void MakeScanStream( vector< int > & keys, size_t count,
+    int universe )
+{
+    keys.resize( count );
+    for ( size_t i = 0; i < count; ++i )
+        keys[ i ] = static_cast< int >( i % static_cast< size_t >( universe ) );
+}
+
+/// A cycle one quarter longer than the cache: strict LRU always evicts
+/// the key that is about to be asked for.
+static void MakeLoopStream( vector< int > & keys, size_t count,
+    int universe )
+{
+    MakeScanStream( keys, count, universe );
+}
+
+/// Loads one integer key per line and remaps the ids to 0..universe-1,
+/// so the trace's key values need not be dense or small.
+static bool LoadTraceStream( const char * path, vector< int > & keys,
+    int & universe )
+{
+    ifstream trace( path );
+    if ( !trace )
+        return false;
+    map< long, int > remap;
+    long raw;
+    while ( trace >> raw )
+    {
+        map< long, int >::iterator it = remap.find( raw );
+        if ( it == remap.end() )
+            it = remap.insert(
+                make_pair( raw, static_cast< int >( remap.size() ) ) ).first;
+        keys.push_back( it->second );
+    }
+    universe = static_cast< int >( remap.size() );
+    return !keys.empty();
+}
+
+// ----------------------------------------------------------------------------
+
+struct ReplayResult
+{
+    double hitRatio;        ///< hits / fetches
+    double p50;             ///< median fetch latency, ns
+    double p90;
+    double p99;
+    double evictionsPerSec;
+};
+
+static double Percentile( const vector< double > & sorted, double rank )
+{
+    size_t index = static_cast< size_t >(
+        rank * static_cast< double >( sorted.size() ) );
+    if ( index >= sorted.size() )
+        index = sorted.size() - 1;
+    return sorted[ index ];
+}
+
+/// Replays the stream through one cache.  Only CreateObject is inside
+/// the per-fetch timing; the immediate release puts the object back in
+/// the pool, as a tile cache would between frames.
+template < class Cache >
+ReplayResult Replay( const vector< int > & keys, unsigned capacity,
+    int universe )
+{
+    Cache cache;
+    cache.setMaxCreation( capacity );
+    for ( int id = 0; id < universe; ++id )
+        cache.Register( id, CreateTile );
+
+    const unsigned long createdBefore = tilesCreated;
+    const unsigned long destroyedBefore = tilesDestroyed;
+
+    vector< double > samples;
+    samples.reserve( keys.size() );
+    LokiBench::Stopwatch total;
+    total.Start();
+    for ( size_t i = 0; i < keys.size(); ++i )
+    {
+        const LokiBench::CountType before = LokiBench::NowNanoseconds();
+        Tile * tile = cache.CreateObject( keys[ i ] );
+        samples.push_back( static_cast< double >(
+            LokiBench::NowNanoseconds() - before ) );
+        LokiBench::DoNotOptimize( tile );
+        cache.ReleaseObject( tile );
+    }
+    total.Stop();
+
+    const unsigned long misses = tilesCreated - createdBefore;
+    const unsigned long evictions = tilesDestroyed - destroyedBefore;
+
+    sort( samples.begin(), samples.end() );
+    ReplayResult result;
+    result.hitRatio = 1.0
+        - static_cast< double >( misses ) / static_cast< double >( keys.size() );
+    result.p50 = Percentile( samples, 0.50 );
+    result.p90 = Percentile( samples, 0.90 );
+    result.p99 = Percentile( samples, 0.99 );
+    const double seconds = total.Nanoseconds() / 1e9;
+    result.evictionsPerSec = ( seconds > 0 )
+        ? static_cast< double >( evictions ) / seconds : 0;
+    return result;
+}
+
+static void PrintRow( const char * policy, const ReplayResult & r )
+{
+    ::std::printf( "    %-12s %7.1f %9.1f %9.1f %9.1f %11.0f\n",
+        policy, 100 * r.hitRatio, r.p50, r.p90, r.p99, r.evictionsPerSec );
+}
+
+/// Runs one stream through every policy and prints the table.
+static void BenchStream( const char * streamName, const vector< int > & keys,
+    unsigned capacity, int universe )
+{
+    ::std::printf( "  %s stream: %lu fetches, universe %d, capacity %u\n",
+        streamName, static_cast< unsigned long >( keys.size() ),
+        universe, capacity );
+    ::std::printf( "    %-12s %7s %9s %9s %9s %11s\n",
+        "policy", "hit%", "p50 ns", "p90 ns", "p99 ns", "evict/s" );
+    PrintRow( "LRU",
+        Replay< CacheOf< Loki::EvictLRU >::Type >( keys, capacity, universe ) );
+    PrintRow( "aging",
+        Replay< CacheOf< Loki::EvictAging >::Type >( keys, capacity, universe ) );
+    PrintRow( "LRU list",
+        Replay< CacheOf< Loki::EvictLRUList >::Type >( keys, capacity, universe ) );
+    PrintRow( "random",
+        Replay< CacheOf< Loki::EvictRandom >::Type >( keys, capacity, universe ) );
+    ::std::printf( "\n" );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, char * argv[] )
+{
+    cout << "CachedFactory eviction policies under replayed key streams"
+         << endl << endl;
+
+    if ( argc > 2 && 0 == ::std::strcmp( argv[ 1 ], "trace" ) )
+    {
+        unsigned capacity = 512;
+        if ( argc > 3 )
+            capacity = static_cast< unsigned >( ::std::atol( argv[ 3 ] ) );
+        vector< int > keys;
+        int universe = 0;
+        if ( !LoadTraceStream( argv[ 2 ], keys, universe ) )
+        {
+            cerr << "cannot read any keys from " << argv[ 2 ] << endl;
+            return 1;
+        }
+        BenchStream( argv[ 2 ], keys, capacity, universe );
+        return 0;
+    }
+
+    size_t fetches = 100000;
+    unsigned capacity = 512;
+    if ( argc > 1 )
+        fetches = static_cast< size_t >( ::std::atol( argv[ 1 ] ) );
+    if ( argc > 2 )
+        capacity = static_cast< unsigned >( ::std::atol( argv[ 2 ] ) );
+
+    vector< int > keys;
+
+    MakeZipfianStream( keys, fetches, static_cast< int >( 16 * capacity ) );
+    BenchStream( "zipfian(0.99)", keys, capacity,
+        static_cast< int >( 16 * capacity ) );
+
+    MakeScanStream( keys, fetches, static_cast< int >( 4 * capacity ) );
+    BenchStream( "scan", keys, capacity, static_cast< int >( 4 * capacity ) );
+
+    MakeLoopStream( keys, fetches, static_cast< int >( capacity + capacity / 4 ) );
+    BenchStream( "loop", keys, capacity,
+        static_cast< int >( capacity + capacity / 4 ) );
+
+    return 0;
+}
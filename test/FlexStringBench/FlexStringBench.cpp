@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Copyright (c) 2001 by Andrei Alexandrescu
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+// Benchmarks the flex_string storage policies against std::string on the
+// operations that dominate real string workloads -- construct, copy,
+// append, find and substr -- at three length distributions. Relative
+// times are against std::string for the same operation and length, so a
+// row over 100% is slower than the standard string and a row under 100%
+// is faster. Use it to pick a policy with data instead of guesswork.
+
+#include <loki/flex/flex_string.h>
+#include <loki/flex/smallobjstringstorage.h>
+#include "../SmallObj/timer.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static volatile unsigned long sink = 0;
+
+static const char payload[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+template <class S>
+struct Bench
+{
+    static int construct(int loops, const char* src, unsigned int len)
+    {
+        Timer t;
+        t.start();
+        for (int i = 0; i < loops; ++i)
+        {
+            S s(src, len);
+            sink += s.size();
+        }
+        t.stop();
+        return t.t();
+    }
+
+    static int copy(int loops, const char* src, unsigned int len)
+    {
+        const S proto(src, len);
+        Timer t;
+        t.start();
+        for (int i = 0; i < loops; ++i)
+        {
+            S s(proto);
+            sink += s.size();
+        }
+        t.stop();
+        return t.t();
+    }
+
+    static int append(int loops, unsigned int len)
+    {
+        Timer t;
+        t.start();
+        for (int i = 0; i < loops; ++i)
+        {
+            S s;
+            while (s.size() < len) s.append(payload, 8);
+            sink += s.size();
+        }
+        t.stop();
+        return t.t();
+    }
+
+    static int find(int loops, unsigned int len)
+    {
+        S hay;
+        while (hay.size() < len) hay.append(payload, 61); // no '+' repeats
+        hay.append("needle!!", 8);
+        Timer t;
+        t.start();
+        for (int i = 0; i < loops; ++i)
+        {
+            sink += hay.find("needle!!");
+        }
+        t.stop();
+        return t.t();
+    }
+
+    static int substr(int loops, const char* src, unsigned int len)
+    {
+        const S proto(src, len);
+        Timer t;
+        t.start();
+        for (int i = 0; i < loops; ++i)
+        {
+            S s(proto.substr(len / 4, len / 2));
+            sink += s.size();
+        }
+        t.stop();
+        return t.t();
+    }
+};
+
+
+// ----------------------------------------------------------------------------
+
+// One row per storage policy; std::string goes first and sets the 100%
+// mark for its column.
+
+#define FLEX_BENCH_ROW(S, name)                                             \
+    {                                                                       \
+        Timer t;                                                            \
+        t.t100 = t100_construct;                                            \
+        const int tc = Bench<S >::construct(ctorLoops, payload, len);       \
+        if (t.t100 == 0) { t.t100 = tc; t100_construct = tc; }              \
+        t.print(tc, name "  construct");                                    \
+        t.t100 = t100_copy;                                                 \
+        const int tk = Bench<S >::copy(ctorLoops, payload, len);            \
+        if (t.t100 == 0) { t.t100 = tk; t100_copy = tk; }                   \
+        t.print(tk, name "  copy     ");                                    \
+        t.t100 = t100_append;                                               \
+        const int ta = Bench<S >::append(appendLoops, len);                 \
+        if (t.t100 == 0) { t.t100 = ta; t100_append = ta; }                 \
+        t.print(ta, name "  append   ");                                    \
+        t.t100 = t100_find;                                                 \
+        const int tf = Bench<S >::find(findLoops, len);                     \
+        if (t.t100 == 0) { t.t100 = tf; t100_find = tf; }                   \
+        t.print(tf, name "  find     ");                                    \
+        t.t100 = t100_substr;                                               \
+        const int ts = Bench<S >::substr(ctorLoops, payload, len);          \
+        if (t.t100 == 0) { t.t100 = ts; t100_substr = ts; }                 \
+        t.print(ts, name "  substr   ");                                    \
+        cout << endl;                                                       \
+    }
+
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    SimpleStringStorage<char, allocator<char> > > SimpleStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    AllocatorStringStorage<char, allocator<char> > > AllocStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    VectorStringStorage<char, allocator<char> > > VectorStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    SmallStringOpt<AllocatorStringStorage<char, allocator<char> >, 31> >
+    SmallStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    CompactStringOpt<VectorStringStorage<char, allocator<char> >, 23> >
+    CompactStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    CowStringOpt<AllocatorStringStorage<char, allocator<char> > > > CowStr;
+typedef flex_string<char, char_traits<char>, allocator<char>,
+    SegmentedStringOpt<AllocatorStringStorage<char, allocator<char> >,
+        4096> > SegmentedStr;
+typedef flex_string<char, char_traits<char>, Loki::LokiAllocator<char>,
+    SmallObjStringStorage<char> > SmallObjStr;
+
+static void benchLength(unsigned int len, int ctorLoops, int appendLoops,
+    int findLoops)
+{
+    cout << "string length " << len << ", " << ctorLoops
+        << " construct/copy/substr, " << appendLoops << " append, "
+        << findLoops << " find" << endl << endl;
+
+    double t100_construct = 0, t100_copy = 0, t100_append = 0,
+        t100_find = 0, t100_substr = 0;
+
+    FLEX_BENCH_ROW(string, "std::string      ")
+    FLEX_BENCH_ROW(SimpleStr, "SimpleStorage    ")
+    FLEX_BENCH_ROW(AllocStr, "AllocatorStorage ")
+    FLEX_BENCH_ROW(VectorStr, "VectorStorage    ")
+    FLEX_BENCH_ROW(SmallStr, "SmallStringOpt   ")
+    FLEX_BENCH_ROW(CompactStr, "CompactStringOpt ")
+    FLEX_BENCH_ROW(CowStr, "CowStringOpt     ")
+    FLEX_BENCH_ROW(SegmentedStr, "SegmentedOpt     ")
+    FLEX_BENCH_ROW(SmallObjStr, "SmallObjStorage  ")
+
+    cout << "----------------------------------------------------------"
+        << endl << endl;
+}
+
+int main()
+{
+    cout << endl << "flex_string storage policy benchmark" << endl
+        << endl;
+
+    // short: inline-buffer territory; medium: one heap block; long:
+    // growth and scan costs dominate
+    benchLength(7, 2000000, 200000, 2000000);
+    benchLength(63, 1000000, 100000, 500000);
+    benchLength(2000, 50000, 10000, 50000);
+
+    return 0;
+}
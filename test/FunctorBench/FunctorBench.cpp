@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The authors make no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+// ----------------------------------------------------------------------------
+//
+// Micro-benchmark for the Functor/Function dispatch hot path: creation,
+// copy, invocation, BindFirst and Chain, each measured against a raw
+// function pointer doing the same work.  The raw-pointer loop is the
+// 100% baseline of each section, so a regression in any of the Functor
+// layers shows up directly in the relative-time column.
+//
+// Build with the macros you deploy with, e.g.
+//     make CPPFLAGS="-DLOKI_FUNCTOR_SMALL_BUFFER -DLOKI_FUNCTOR_FAST_DISPATCH"
+// to see what the optional storage and dispatch modes buy.
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/Function.h>
+#include <loki/Functor.h>
+
+#include "../SmallObj/timer.h"
+
+#include <iostream>
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+    const int invokeLoop = 50000000;
+    const int createLoop = 2000000;
+
+    // Keeps results observable so the loops cannot be optimized away.
+    volatile int sink = 0;
+
+    int add( int a, int b )
+    {
+        return a + b;
+    }
+
+    void bump( int & x )
+    {
+        ++x;
+    }
+
+    struct Adder
+    {
+        int operator()( int a, int b ) const
+        {
+            return a + b;
+        }
+    };
+
+    struct Host
+    {
+        int Add( int a, int b ) const
+        {
+            return a + b;
+        }
+    };
+
+    typedef Loki::Functor< int, LOKI_TYPELIST_2( int, int ) > IntFunctor;
+    typedef Loki::Functor< int, LOKI_TYPELIST_1( int ) > BoundFunctor;
+    typedef Loki::Functor< void, LOKI_TYPELIST_1( int & ) > VoidFunctor;
+    typedef Loki::Function< int ( int, int ) > IntFunction;
+}
+
+
+// ----------------------------------------------------------------------------
+
+static void BenchInvocation( void )
+{
+    Timer t;
+    cout << "Invocation (" << invokeLoop << " calls):" << endl;
+
+    int ( * volatile rawPtr )( int, int ) = &add;
+    int acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += rawPtr( i, 3 );
+    t.stop();
+    sink = acc;
+    t.t100 = t.t();
+    t.print( t.t(), "raw function pointer      " );
+
+    IntFunctor functorFree( &add );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += functorFree( i, 3 );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Functor, free function    " );
+
+    IntFunctor functorObj( ( Adder() ) );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += functorObj( i, 3 );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Functor, function object  " );
+
+    Host host;
+    IntFunctor functorMemFn( &host, &Host::Add );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += functorMemFn( i, 3 );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Functor, member function  " );
+
+    IntFunction function( &add );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += function( i, 3 );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Function, free function   " );
+
+    BoundFunctor bound = Loki::BindFirst( functorFree, 10 );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop; ++i )
+        acc += bound( i );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "BindFirst result          " );
+
+    VoidFunctor link( &bump );
+    VoidFunctor chain2 = Loki::Chain( link, link );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop / 2; ++i )
+        chain2( acc );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Chain of 2 (same # calls) " );
+
+    VoidFunctor chain8 = chain2;
+    for ( int n = 2; n < 8; ++n )
+        chain8 = Loki::Chain( chain8, link );
+    acc = 0;
+    t.start();
+    for ( int i = 0; i < invokeLoop / 8; ++i )
+        chain8( acc );
+    t.stop();
+    sink = acc;
+    t.print( t.t(), "Chain of 8 (same # calls) " );
+
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+static void BenchCreation( void )
+{
+    Timer t;
+    cout << "Creation and destruction (" << createLoop << " rounds):" << endl;
+
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        int ( * volatile rawPtr )( int, int ) = &add;
+        sink = sink + ( rawPtr != 0 );
+    }
+    t.stop();
+    t.t100 = t.t();
+    t.print( t.t(), "raw function pointer      " );
+
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        IntFunctor f( &add );
+        sink = sink + ( f ? 1 : 0 );
+    }
+    t.stop();
+    t.print( t.t(), "Functor, free function    " );
+
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        IntFunction f( &add );
+        sink = sink + ( f.empty() ? 0 : 1 );
+    }
+    t.stop();
+    t.print( t.t(), "Function, free function   " );
+
+    IntFunctor functorFree( &add );
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        BoundFunctor b = Loki::BindFirst( functorFree, i );
+        sink = sink + ( b ? 1 : 0 );
+    }
+    t.stop();
+    t.print( t.t(), "BindFirst                 " );
+
+    VoidFunctor link( &bump );
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        VoidFunctor c = Loki::Chain( link, link );
+        sink = sink + ( c ? 1 : 0 );
+    }
+    t.stop();
+    t.print( t.t(), "Chain of 2                " );
+
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+static void BenchCopy( void )
+{
+    Timer t;
+    cout << "Copy (" << createLoop << " rounds):" << endl;
+
+    int ( *rawPtr )( int, int ) = &add;
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        int ( * volatile copy )( int, int ) = rawPtr;
+        sink = sink + ( copy != 0 );
+    }
+    t.stop();
+    t.t100 = t.t();
+    t.print( t.t(), "raw function pointer      " );
+
+    IntFunctor functorFree( &add );
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        IntFunctor copy( functorFree );
+        sink = sink + ( copy ? 1 : 0 );
+    }
+    t.stop();
+    t.print( t.t(), "Functor, free function    " );
+
+    IntFunction function( &add );
+    t.start();
+    for ( int i = 0; i < createLoop; ++i )
+    {
+        IntFunction copy( function );
+        sink = sink + ( copy.empty() ? 0 : 1 );
+    }
+    t.stop();
+    t.print( t.t(), "Function, free function   " );
+
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( void )
+{
+    cout << "FunctorBench: relative time is against the raw-pointer"
+        << " baseline of each section." << endl << endl;
+
+    BenchInvocation();
+    BenchCreation();
+    BenchCopy();
+
+    cout << "sink: " << sink << endl;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Puts numbers on mutex contention.  The multithreaded tests prove the
+// mutexes correct; this target measures what each waiting strategy costs
+// when several threads actually collide.  For every combination of
+// thread count (1, 2, 4) and critical-section length the same workload
+// runs through:
+//   - default     Loki::Mutex, the operating system's mutex and what
+//                 LOKI_DEFAULT_MUTEX resolves to (the Makefile defines
+//                 LOKI_CLASS_LEVEL_THREADING so it really locks);
+//   - spin        SpinLevelMutex, a pure busy-wait;
+//   - sleep       SleepLevelMutex, which parks on a condition variable
+//                 and relies on the unlock notification for the handoff;
+//   - hybrid      HybridLevelMutex, bounded spinning with backoff first,
+//                 parking after.
+// The level-checking bookkeeping of the LevelMutex wrapper is left out
+// on purpose: the raw policy classes are measured so the numbers isolate
+// the waiting strategy itself.
+//
+// Each cell runs for a fixed wall-clock slice (200 ms by default, the
+// first argument overrides in ms) and reports:
+//   - acq/s       total acquisitions per second across all threads;
+//   - fairness    the slowest thread's share of the fastest one's
+//                 acquisitions - 1.00 is perfectly fair, a near-zero
+//                 value means the lock is being monopolized;
+//   - p50/p99 ns  the handoff latency distribution: time from asking
+//                 for the lock to holding it, sampled every 16th
+//                 acquisition.
+// The critical section increments a shared counter holdWork times; each
+// thread then does the same amount of private work outside the lock, so
+// there is a window for the handoff to actually change threads.
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/Threads.h>
+#include <loki/LevelMutex.h>
+#include "../benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <process.h>
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+/// The mutexes under test, behind one uniform face.  The adapters add a
+/// call through an inline function for Loki::Mutex and a virtual call
+/// for the level mutexes - the same price every real client pays.
+
+struct DefaultMutexAdapter
+{
+    Loki::Mutex mutex_;
+    void Lock( void ) { mutex_.Lock(); }
+    void Unlock( void ) { mutex_.Unlock(); }
+};
+
+struct SpinMutexAdapter
+{
+    Loki::SpinLevelMutex mutex_;
+    SpinMutexAdapter( void ) : mutex_( 1 ) {}
+    void Lock( void ) { mutex_.Lock(); }
+    void Unlock( void ) { mutex_.Unlock(); }
+};
+
+struct SleepMutexAdapter
+{
+    Loki::SleepLevelMutex mutex_;
+    // the explicit sleep time picks the ctor POSIX builds provide;
+    // with the unlock notification it is only a safety-net bound
+    SleepMutexAdapter( void ) : mutex_( 1, 1 ) {}
+    void Lock( void ) { mutex_.Lock(); }
+    void Unlock( void ) { mutex_.Unlock(); }
+};
+
+struct HybridMutexAdapter
+{
+    Loki::HybridLevelMutex mutex_;
+    HybridMutexAdapter( void ) : mutex_( 1 ) {}
+    void Lock( void ) { mutex_.Lock(); }
+    void Unlock( void ) { mutex_.Unlock(); }
+};
+
+// ----------------------------------------------------------------------------
+
+volatile bool startFlag = false;
+volatile bool stopFlag = false;
+
+inline void WaitForStart( void )
+{
+    while ( !startFlag ) {}
+}
+
+/// The counter every critical section increments; sharing one line is
+/// the point, since that is what the mutex protects in real code.
+volatile unsigned long sharedCounter = 0;
+
+class BenchThread
+{
+public:
+    void Start( void * ( *callback )( void * ), void * parameter )
+    {
+#if defined(_WIN32)
+        handle_ = ( HANDLE )_beginthreadex( 0, 0,
+            ( unsigned ( __stdcall * )( void * ) )callback, parameter, 0, 0 );
+#else
+        ::pthread_create( &handle_, 0, callback, parameter );
+#endif
+    }
+    void Join( void )
+    {
+#if defined(_WIN32)
+        ::WaitForSingleObject( handle_, INFINITE );
+        ::CloseHandle( handle_ );
+#else
+        ::pthread_join( handle_, 0 );
+#endif
+    }
+private:
+#if defined(_WIN32)
+    HANDLE handle_;
+#else
+    pthread_t handle_;
+#endif
+};
+
+// ----------------------------------------------------------------------------
+
+/// Locks, works, unlocks, works outside, until the clock runs out.
+template < class Mutex >
+struct ContendWorker
+{
+    Mutex * mutex;
+    unsigned int holdWork;
+    unsigned long acquisitions;
+    vector< double > waitSamples;
+
+    static void * Run( void * self )
+    {
+        ContendWorker * worker = static_cast< ContendWorker * >( self );
+        Mutex & mutex = *worker->mutex;
+        const unsigned int holdWork = worker->holdWork;
+        unsigned long count = 0;
+        volatile unsigned long outside = 0;
+        worker->waitSamples.reserve( 1 << 16 );
+        WaitForStart();
+        while ( !stopFlag )
+        {
+            if ( 0 == ( count & 15 ) )
+            {
+                const LokiBench::CountType before = LokiBench::NowNanoseconds();
+                mutex.Lock();
+                if ( worker->waitSamples.size() < ( 1 << 20 ) )
+                    worker->waitSamples.push_back( static_cast< double >(
+                        LokiBench::NowNanoseconds() - before ) );
+            }
+            else
+                mutex.Lock();
+            for ( unsigned int w = 0; w < holdWork; ++w )
+                ++sharedCounter;
+            mutex.Unlock();
+            ++count;
+            // the same amount of private work outside the lock, so the
+            // handoff has a chance to reach another thread
+            for ( unsigned int w = 0; w < holdWork; ++w )
+                ++outside;
+        }
+        worker->acquisitions = count;
+        return 0;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+static double Percentile( const vector< double > & sorted, double rank )
+{
+    size_t index = static_cast< size_t >(
+        rank * static_cast< double >( sorted.size() ) );
+    if ( index >= sorted.size() )
+        index = sorted.size() - 1;
+    return sorted.empty() ? 0.0 : sorted[ index ];
+}
+
+/// Runs one cell: threadCount threads contending on one mutex for
+/// sliceMs of wall clock, and prints the row.
+template < class Mutex >
+void BenchMutex( const char * name, unsigned int threadCount,
+    unsigned int holdWork, unsigned long sliceMs )
+{
+    Mutex mutex;
+    vector< ContendWorker< Mutex > > workers( threadCount );
+    vector< BenchThread > threads( threadCount );
+    startFlag = false;
+    stopFlag = false;
+    for ( unsigned int t = 0; t < threadCount; ++t )
+    {
+        workers[ t ].mutex = &mutex;
+        workers[ t ].holdWork = holdWork;
+        workers[ t ].acquisitions = 0;
+        threads[ t ].Start( &ContendWorker< Mutex >::Run, &workers[ t ] );
+    }
+    LokiBench::Stopwatch slice;
+    slice.Start();
+    startFlag = true;
+    const LokiBench::CountType begin = LokiBench::NowNanoseconds();
+    while ( LokiBench::NowNanoseconds() - begin < sliceMs * 1000000ULL ) {}
+    stopFlag = true;
+    for ( unsigned int t = 0; t < threadCount; ++t )
+        threads[ t ].Join();
+    slice.Stop();
+
+    unsigned long total = 0;
+    unsigned long slowest = workers[ 0 ].acquisitions;
+    unsigned long fastest = workers[ 0 ].acquisitions;
+    vector< double > waits;
+    for ( unsigned int t = 0; t < threadCount; ++t )
+    {
+        const unsigned long count = workers[ t ].acquisitions;
+        total += count;
+        if ( count < slowest ) slowest = count;
+        if ( count > fastest ) fastest = count;
+        waits.insert( waits.end(), workers[ t ].waitSamples.begin(),
+            workers[ t ].waitSamples.end() );
+    }
+    sort( waits.begin(), waits.end() );
+
+    const double seconds = slice.Nanoseconds() / 1e9;
+    const double fairness = ( fastest > 0 )
+        ? static_cast< double >( slowest ) / static_cast< double >( fastest )
+        : 1.0;
+    ::std::printf( "    %-10s %12.0f %9.2f %10.1f %10.1f\n", name,
+        static_cast< double >( total ) / seconds, fairness,
+        Percentile( waits, 0.50 ), Percentile( waits, 0.99 ) );
+}
+
+static void BenchCell( unsigned int threadCount, unsigned int holdWork,
+    unsigned long sliceMs )
+{
+    ::std::printf( "  %u thread%s, %u work units held\n",
+        threadCount, threadCount > 1 ? "s" : "", holdWork );
+    ::std::printf( "    %-10s %12s %9s %10s %10s\n",
+        "mutex", "acq/s", "fairness", "p50 ns", "p99 ns" );
+    BenchMutex< DefaultMutexAdapter >( "default", threadCount, holdWork, sliceMs );
+    BenchMutex< SpinMutexAdapter >( "spin", threadCount, holdWork, sliceMs );
+    BenchMutex< SleepMutexAdapter >( "sleep", threadCount, holdWork, sliceMs );
+    BenchMutex< HybridMutexAdapter >( "hybrid", threadCount, holdWork, sliceMs );
+    ::std::printf( "\n" );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, char * argv[] )
+{
+    unsigned long sliceMs = 200;
+    if ( argc > 1 )
+        sliceMs = static_cast< unsigned long >( ::std::atol( argv[ 1 ] ) );
+    if ( sliceMs < 10 )
+        sliceMs = 10;
+
+    cout << "Mutex contention: acquisition rate, fairness and handoff tails"
+         << endl << endl;
+
+    static const unsigned int threadCounts[] = { 1, 2, 4 };
+    static const unsigned int holdWorks[] = { 0, 100, 1000 };
+
+    for ( size_t h = 0; h < sizeof(holdWorks) / sizeof(holdWorks[0]); ++h )
+        for ( size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t )
+            BenchCell( threadCounts[ t ], holdWorks[ h ], sliceMs );
+
+    LokiBench::DoNotOptimize( sharedCounter );
+    return 0;
+}
@@ -1,7 +1,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 // Unit Test framework
 //
-// Copyright Terje Sletteb� and Pavel Vozenilek 2002.
+// Copyright Terje Sletteb� and Pavel Vozenilek 2002.
 //
 // Permission to use, copy, modify, and distribute this software for any
 // purpose is hereby granted without fee, provided that this copyright and
@@ -16,12 +16,16 @@
 // $Id: UnitTest.h 760 2006-10-17 20:36:13Z syntheticpp $
 
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <functional>
 
+#include "../benchmark.h"
+
 ///////////////////////////////////////////////////////////////////////////////
 // SameType
 ///////////////////////////////////////////////////////////////////////////////
@@ -89,8 +93,36 @@ class Test
 typedef std::vector<Test*> tests_type;
 static tests_type tests;
 
+// What run() records about one test, besides pass/fail
+struct Timing
+{
+  std::string name;
+  double wallNs;
+  double cycles;
+  unsigned long budgetMicroseconds;
+
+  bool overBudget() const
+    {
+    return budgetMicroseconds!=0 && wallNs/1000.0>budgetMicroseconds;
+    }
+};
+
+typedef std::vector<Timing> timings_type;
+
+// Function-local static, so projects using this header need not define
+// another out-of-line static alongside Test::tests
+static timings_type &timings()
+  {
+  static timings_type log;
+  return log;
+  }
+
 public:
-  explicit Test(const std::string &n) : name(n)
+  // A non-zero budget declares how long the test may take; run() flags
+  // (but does not fail) tests exceeding it, making the suite a coarse
+  // performance tripwire
+  explicit Test(const std::string &n,unsigned long budgetMicroseconds =0)
+    : name(n),budget(budgetMicroseconds)
     {
     Test::tests.push_back(this);
     }
@@ -146,7 +178,8 @@ public:
 
 protected:
   const std::string name;
-  
+  const unsigned long budget;
+
 public:
   static int run(const std::string &title)
     {
@@ -157,12 +190,26 @@ public:
     
     tests_type::iterator it;
     tests_type::const_iterator itEnd = Test::tests.end();
+    timings().clear();
+
     for(it=Test::tests.begin(); it!=itEnd; ++it)
       {
       Test* test = *it;
+
+      const LokiBench::CountType ns0=LokiBench::NowNanoseconds();
+      const LokiBench::CountType cycles0=LokiBench::ReadCycles();
       test->execute(testResult);
+      const LokiBench::CountType cycles1=LokiBench::ReadCycles();
+      const LokiBench::CountType ns1=LokiBench::NowNanoseconds();
+
+      Timing timing;
+      timing.name=test->name;
+      timing.wallNs=static_cast<double>(ns1-ns0);
+      timing.cycles=static_cast<double>(cycles1-cycles0);
+      timing.budgetMicroseconds=test->budget;
+      timings().push_back(timing);
       }
-    
+
     std::cout << std::string(76,'-') << '\n';
 
     const int total=testResult.passed+testResult.failed;
@@ -176,9 +223,52 @@ public:
       std::cout << "Not Supported - " << testResult.notSupported << '/' << totalAll << ", "
                 << testResult.notSupported*100/totalAll << "%\n";
 
+    reportTimings();
+
     return testResult.failed;
     }
 
+private:
+  // Flags budget overruns on the console, and - when the environment
+  // variable LOKI_UNITTEST_TIMING names a file - writes every test's
+  // timing as tab-separated lines:
+  //   name <TAB> wall ns <TAB> cycles <TAB> budget us <TAB> OK|OVER
+  // so a build script can diff timings between changes
+  static void reportTimings()
+    {
+    timings_type::const_iterator it;
+    const timings_type::const_iterator itEnd=timings().end();
+
+    int flagged=0;
+
+    for(it=timings().begin(); it!=itEnd; ++it)
+      {
+      if(!it->overBudget())
+        continue;
+
+      if(flagged==0)
+        std::cout << '\n';
+
+      std::cout << "Over budget - " << it->name << " took "
+                << it->wallNs/1000.0 << " us, budget "
+                << it->budgetMicroseconds << " us\n";
+
+      ++flagged;
+      }
+
+    const char *const reportPath=std::getenv("LOKI_UNITTEST_TIMING");
+
+    if(reportPath==0)
+      return;
+
+    std::ofstream report(reportPath);
+
+    for(it=timings().begin(); it!=itEnd; ++it)
+      report << it->name << '\t' << it->wallNs << '\t' << it->cycles << '\t'
+             << it->budgetMicroseconds << '\t'
+             << (it->overBudget() ? "OVER" : "OK") << '\n';
+    }
+
 };
 
 
@@ -23,7 +23,7 @@
 #endif
 
 #include <loki/SmallObj.h>
-#include "timer.h"
+#include "../benchmark.h"
 
 #include <iostream>
 #include <string>
@@ -126,7 +126,7 @@ double t100_delete = 0;
 
 #define LOKI_SMALLOBJ_BENCH(FUNC, CODE_LOOP)                                 \
 template<class T, int TN>                                                    \
-int FUNC(void**, const int N, int loop, Timer& t, const char* s)             \
+double FUNC(void**, const int N, int loop, LokiBench::Timer& t, const char* s) \
 {                                                                            \
     t.start();                                                               \
     /****************************************************************/       \
@@ -152,7 +152,7 @@ int FUNC(void**, const int N, int loop, Timer& t, const char* s)             \
 
 #define LOKI_SMALLOBJ_BENCH_ARRAY(FUNC, CODE_DECL, CODE_NEW, CODE_DELETE)    \
 template<class T, int TN>                                                    \
-int FUNC(void** arrv, const int N, int loop, Timer& t, const char* s)        \
+double FUNC(void** arrv, const int N, int loop, LokiBench::Timer& t, const char* s) \
 {                                                                            \
                                                                              \
     CODE_DECL;                                                               \
@@ -208,13 +208,13 @@ int FUNC(void** arrv, const int N, int loop, Timer& t, const char* s)        \
 // ----------------------------------------------------------------------------
 
 
-LOKI_SMALLOBJ_BENCH(delete_new        ,delete new T;)
-LOKI_SMALLOBJ_BENCH(delete_new_mal    ,std::free(std::malloc(sizeof(T)));)
-LOKI_SMALLOBJ_BENCH(delete_new_all    ,std::allocator<T> st;st.deallocate(st.allocate(1), 1);)
+LOKI_SMALLOBJ_BENCH(delete_new        ,T* p = new T;LokiBench::DoNotOptimize(p);delete p;)
+LOKI_SMALLOBJ_BENCH(delete_new_mal    ,void* p = std::malloc(sizeof(T));LokiBench::DoNotOptimize(p);std::free(p);)
+LOKI_SMALLOBJ_BENCH(delete_new_all    ,std::allocator<T> st;T* p = st.allocate(1);LokiBench::DoNotOptimize(p);st.deallocate(p, 1);)
 
-LOKI_SMALLOBJ_BENCH(delete_new_array    ,delete[] new T[N];)
-LOKI_SMALLOBJ_BENCH(delete_new_array_mal,std::free(std::malloc(sizeof(T[TN])));)
-LOKI_SMALLOBJ_BENCH(delete_new_array_all,std::allocator<T[TN]> st;st.deallocate(st.allocate(1), 1);)
+LOKI_SMALLOBJ_BENCH(delete_new_array    ,T* p = new T[N];LokiBench::DoNotOptimize(p);delete[] p;)
+LOKI_SMALLOBJ_BENCH(delete_new_array_mal,void* p = std::malloc(sizeof(T[TN]));LokiBench::DoNotOptimize(p);std::free(p);)
+LOKI_SMALLOBJ_BENCH(delete_new_array_all,std::allocator<T[TN]> st;T(*p)[TN] = st.allocate(1);LokiBench::DoNotOptimize(p);st.deallocate(p, 1);)
 
 LOKI_SMALLOBJ_BENCH_ARRAY(new_del_on_arr    , , arr[i] = new T; , 
                                                 delete arr[i];)
@@ -300,7 +300,7 @@ void testSize()
     cout << "malloc   = std::malloc/free      \tsizeof(A) = " << sizeof(A) << endl;
     cout << endl << endl;
 
-    Timer t;
+    LokiBench::Timer t;
 
     const int N = 3;    
     int Narr = 1000*1000;
@@ -372,13 +372,451 @@ void DoClassLockTest (void)
 #endif
 
 // ----------------------------------------------------------------------------
+//
+// Multithreaded contention scenarios.
+//
+// The loops above run on one thread, but the allocator's real cost shows up
+// when many threads hit AllocatorSingleton at once.  Three scenarios below
+// measure that directly and report per-thread throughput plus a scalability
+// table against the 1-thread run:
+//  - same-size-class contention: every thread does new/delete in one class,
+//    the worst case for the allocator's lock;
+//  - producer/consumer: objects allocated on one thread are freed on
+//    another, the pattern that defeats purely thread-local caching;
+//  - mixed sizes from a replayable trace: every thread replays the same
+//    operation stream over several size classes with a bounded live set.
+//    The stream comes from a trace file (one size-class index per line,
+//    passed as argv[1]) or, without a file, from a fixed-seed generator -
+//    either way two runs replay identical streams, so results compare
+//    across allocator changes.
+//
+// ----------------------------------------------------------------------------
+
+#if defined(LOKI_CLASS_LEVEL_THREADING)
+
+#if defined(_MSC_VER)
+    #include <process.h>
+#else
+    #include <pthread.h>
+#endif
+
+#include <fstream>
+#include <vector>
+
+namespace MtBench
+{
+
+typedef Base<16, Loki::SmallObject<> > Obj16;
+// Size classes for the mixed trace.
+typedef Base< 8, Loki::SmallObject<> > Obj8;
+typedef Base<24, Loki::SmallObject<> > Obj24;
+typedef Base<64, Loki::SmallObject<> > Obj64;
+
+// ----------------------------------------------------------------------------
+
+/// One worker thread, portable over pthreads and Windows.
+class BenchThread
+{
+public:
+    typedef void (*Callback)(void*);
+
+    BenchThread() : callback_(0), arg_(0) {}
+
+    void Start(Callback callback, void* arg)
+    {
+        callback_ = callback;
+        arg_ = arg;
+#if defined(_MSC_VER)
+        thread_ = reinterpret_cast<HANDLE>(
+            ::_beginthreadex(0, 0, &BenchThread::Top, this, 0, 0));
+#else
+        ::pthread_create(&thread_, 0, &BenchThread::Top, this);
+#endif
+    }
+
+    void Join()
+    {
+#if defined(_MSC_VER)
+        ::WaitForSingleObject(thread_, INFINITE);
+        ::CloseHandle(thread_);
+#else
+        ::pthread_join(thread_, 0);
+#endif
+    }
+
+private:
+#if defined(_MSC_VER)
+    static unsigned int __stdcall Top(void* p)
+    {
+        BenchThread* self = static_cast<BenchThread*>(p);
+        self->callback_(self->arg_);
+        return 0;
+    }
+    HANDLE thread_;
+#else
+    static void* Top(void* p)
+    {
+        BenchThread* self = static_cast<BenchThread*>(p);
+        self->callback_(self->arg_);
+        return 0;
+    }
+    pthread_t thread_;
+#endif
+    Callback callback_;
+    void* arg_;
+};
+
+// ----------------------------------------------------------------------------
+
+/// Start gate: workers spin here so the measured region begins with all
+/// threads running, not with a thread-creation ramp.
+volatile bool startFlag = false;
+
+inline void WaitForStart()
+{
+    while (!startFlag)
+        LokiBench::ClobberMemory();
+}
+
+/// What one worker measured.
+struct WorkerResult
+{
+    double seconds;
+    unsigned long ops;
+};
+
+/// Prints one scalability line and returns aggregate ops/s for the baseline.
+double Report(unsigned int threads, const WorkerResult* results, double baselineOpsPerSec)
+{
+    double aggregate = 0;
+    double slowest = 0;
+    unsigned long ops = 0;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        if (results[i].seconds > 0)
+            aggregate += results[i].ops / results[i].seconds;
+        if (results[i].seconds > slowest)
+            slowest = results[i].seconds;
+        ops += results[i].ops;
+    }
+    const double perThread = aggregate / threads;
+    cout << "  threads: " << threads
+         << "\taggregate: " << static_cast<unsigned long>(aggregate / 1000) << " kops/s"
+         << "\tper-thread: " << static_cast<unsigned long>(perThread / 1000) << " kops/s";
+    if (baselineOpsPerSec > 0)
+        cout << "\tscalability: "
+             << static_cast<unsigned long>(floor(100.0 * aggregate / baselineOpsPerSec + 0.5))
+             << "%";
+    cout << endl;
+    return aggregate;
+}
+
+// ----------------------------------------------------------------------------
+// Scenario 1: same-size-class contention.
+// ----------------------------------------------------------------------------
+
+struct ContendArg
+{
+    unsigned long iterations;
+    WorkerResult* result;
+};
+
+void ContendWorker(void* p)
+{
+    ContendArg* arg = static_cast<ContendArg*>(p);
+    WaitForStart();
+    LokiBench::Stopwatch watch;
+    watch.Start();
+    for (unsigned long i = 0; i < arg->iterations; ++i)
+    {
+        Obj16* object = new Obj16;
+        LokiBench::DoNotOptimize(object);
+        delete object;
+    }
+    watch.Stop();
+    arg->result->seconds = watch.Nanoseconds() / 1e9;
+    arg->result->ops = arg->iterations * 2;
+}
+
+// ----------------------------------------------------------------------------
+// Scenario 2: producer/consumer cross-thread free.
+// ----------------------------------------------------------------------------
+
+/// One single-producer single-consumer ring per pair.  Each side writes only
+/// its own index, so plain volatile indices suffice for a benchmark.
+struct CrossFreeRing
+{
+    enum { Capacity = 1024 };
+    Obj16* slots[Capacity];
+    volatile unsigned long head;
+    volatile unsigned long tail;
+    unsigned long iterations;
+    WorkerResult* producerResult;
+    WorkerResult* consumerResult;
+};
 
-int main()
+void ProducerWorker(void* p)
+{
+    CrossFreeRing* ring = static_cast<CrossFreeRing*>(p);
+    WaitForStart();
+    LokiBench::Stopwatch watch;
+    watch.Start();
+    for (unsigned long i = 0; i < ring->iterations; ++i)
+    {
+        while (ring->head - ring->tail >= CrossFreeRing::Capacity - 1)
+            LokiBench::ClobberMemory();
+        ring->slots[ring->head % CrossFreeRing::Capacity] = new Obj16;
+        LokiBench::ClobberMemory();
+        ring->head = ring->head + 1;
+    }
+    watch.Stop();
+    ring->producerResult->seconds = watch.Nanoseconds() / 1e9;
+    ring->producerResult->ops = ring->iterations;
+}
+
+void ConsumerWorker(void* p)
+{
+    CrossFreeRing* ring = static_cast<CrossFreeRing*>(p);
+    WaitForStart();
+    LokiBench::Stopwatch watch;
+    watch.Start();
+    for (unsigned long i = 0; i < ring->iterations; ++i)
+    {
+        while (ring->tail == ring->head)
+            LokiBench::ClobberMemory();
+        delete ring->slots[ring->tail % CrossFreeRing::Capacity];
+        LokiBench::ClobberMemory();
+        ring->tail = ring->tail + 1;
+    }
+    watch.Stop();
+    ring->consumerResult->seconds = watch.Nanoseconds() / 1e9;
+    ring->consumerResult->ops = ring->iterations;
+}
+
+// ----------------------------------------------------------------------------
+// Scenario 3: mixed size classes replayed from a trace.
+// ----------------------------------------------------------------------------
+
+/// Loads a trace: one size-class index (0..3) per line.  Returns false when
+/// the file cannot be read, in which case a fixed-seed stream is generated
+/// instead - both forms replay identically from run to run.
+bool LoadTrace(const char* path, std::vector<int>& trace)
+{
+    if (0 == path)
+        return false;
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    int sizeClass;
+    while (file >> sizeClass)
+        trace.push_back(sizeClass & 3);
+    return !trace.empty();
+}
+
+void GenerateTrace(std::vector<int>& trace, unsigned long length)
+{
+    // small allocations dominate real traces, so weight them accordingly
+    unsigned long state = 12345;
+    for (unsigned long i = 0; i < length; ++i)
+    {
+        state = state * 1103515245ul + 12345ul;
+        const unsigned long draw = (state >> 16) & 15;
+        trace.push_back(draw < 6 ? 0 : (draw < 11 ? 1 : (draw < 14 ? 2 : 3)));
+    }
+}
+
+struct TraceArg
+{
+    const std::vector<int>* trace;
+    unsigned long repeats;
+    WorkerResult* result;
+};
+
+void* AllocateSizeClass(int sizeClass)
+{
+    switch (sizeClass)
+    {
+        case 0:  return new Obj8;
+        case 1:  return new Obj16;
+        case 2:  return new Obj24;
+        default: return new Obj64;
+    }
+}
+
+void FreeSizeClass(void* p, int sizeClass)
+{
+    switch (sizeClass)
+    {
+        case 0:  delete static_cast<Obj8*>(p);  break;
+        case 1:  delete static_cast<Obj16*>(p); break;
+        case 2:  delete static_cast<Obj24*>(p); break;
+        default: delete static_cast<Obj64*>(p); break;
+    }
+}
+
+void TraceWorker(void* p)
+{
+    TraceArg* arg = static_cast<TraceArg*>(p);
+    const std::vector<int>& trace = *arg->trace;
+    // bounded live set, freed oldest-first so frees hit cold chunks
+    enum { LiveDepth = 64 };
+    void* live[LiveDepth];
+    int liveClass[LiveDepth];
+    unsigned long liveCount = 0;
+    unsigned long oldest = 0;
+    WaitForStart();
+    LokiBench::Stopwatch watch;
+    watch.Start();
+    unsigned long ops = 0;
+    for (unsigned long r = 0; r < arg->repeats; ++r)
+    {
+        for (unsigned long i = 0; i < trace.size(); ++i)
+        {
+            if (liveCount == LiveDepth)
+            {
+                FreeSizeClass(live[oldest % LiveDepth], liveClass[oldest % LiveDepth]);
+                ++oldest;
+                --liveCount;
+                ++ops;
+            }
+            const int sizeClass = trace[i];
+            live[(oldest + liveCount) % LiveDepth] = AllocateSizeClass(sizeClass);
+            liveClass[(oldest + liveCount) % LiveDepth] = sizeClass;
+            ++liveCount;
+            ++ops;
+        }
+    }
+    while (liveCount != 0)
+    {
+        FreeSizeClass(live[oldest % LiveDepth], liveClass[oldest % LiveDepth]);
+        ++oldest;
+        --liveCount;
+        ++ops;
+    }
+    watch.Stop();
+    arg->result->seconds = watch.Nanoseconds() / 1e9;
+    arg->result->ops = ops;
+}
+
+// ----------------------------------------------------------------------------
+
+void DoMultiThreadedTest(const char* tracePath)
+{
+    static const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+    const unsigned int countOfCounts = sizeof(threadCounts) / sizeof(threadCounts[0]);
+    const unsigned long iterations = 200 * 1000;
+
+    cout << endl << "Multithreaded Allocator Benchmark Tests" << endl << endl;
+
+    cout << "same-size-class contention ('new Obj16 / delete' on every thread)" << endl;
+    double baseline = 0;
+    for (unsigned int c = 0; c < countOfCounts; ++c)
+    {
+        const unsigned int threads = threadCounts[c];
+        std::vector<BenchThread> workers(threads);
+        std::vector<WorkerResult> results(threads);
+        std::vector<ContendArg> args(threads);
+        startFlag = false;
+        for (unsigned int i = 0; i < threads; ++i)
+        {
+            args[i].iterations = iterations;
+            args[i].result = &results[i];
+            workers[i].Start(&ContendWorker, &args[i]);
+        }
+        startFlag = true;
+        for (unsigned int i = 0; i < threads; ++i)
+            workers[i].Join();
+        const double aggregate = Report(threads, &results[0], baseline);
+        if (1 == threads)
+            baseline = aggregate;
+    }
+    cout << endl;
+
+    cout << "producer/consumer cross-thread free (pairs; producer news, consumer deletes)" << endl;
+    baseline = 0;
+    for (unsigned int c = 0; c < countOfCounts - 1; ++c)
+    {
+        const unsigned int pairs = threadCounts[c];
+        std::vector<BenchThread> workers(pairs * 2);
+        std::vector<WorkerResult> results(pairs * 2);
+        std::vector<CrossFreeRing*> rings(pairs);
+        startFlag = false;
+        for (unsigned int i = 0; i < pairs; ++i)
+        {
+            rings[i] = new CrossFreeRing;
+            rings[i]->head = 0;
+            rings[i]->tail = 0;
+            rings[i]->iterations = iterations;
+            rings[i]->producerResult = &results[2 * i];
+            rings[i]->consumerResult = &results[2 * i + 1];
+            workers[2 * i].Start(&ProducerWorker, rings[i]);
+            workers[2 * i + 1].Start(&ConsumerWorker, rings[i]);
+        }
+        startFlag = true;
+        for (unsigned int i = 0; i < pairs * 2; ++i)
+            workers[i].Join();
+        for (unsigned int i = 0; i < pairs; ++i)
+            delete rings[i];
+        const double aggregate = Report(pairs * 2, &results[0], baseline);
+        if (1 == pairs)
+            baseline = aggregate;
+    }
+    cout << endl;
+
+    std::vector<int> trace;
+    if (LoadTrace(tracePath, trace))
+        cout << "mixed size classes, trace replayed from '" << tracePath << "' ("
+             << trace.size() << " ops)" << endl;
+    else
+    {
+        GenerateTrace(trace, 10 * 1000);
+        cout << "mixed size classes, built-in fixed-seed trace ("
+             << trace.size() << " ops; pass a trace file as argv[1] to replay your own)"
+             << endl;
+    }
+    baseline = 0;
+    for (unsigned int c = 0; c < countOfCounts; ++c)
+    {
+        const unsigned int threads = threadCounts[c];
+        std::vector<BenchThread> workers(threads);
+        std::vector<WorkerResult> results(threads);
+        std::vector<TraceArg> args(threads);
+        startFlag = false;
+        for (unsigned int i = 0; i < threads; ++i)
+        {
+            args[i].trace = &trace;
+            args[i].repeats = 20;
+            args[i].result = &results[i];
+            workers[i].Start(&TraceWorker, &args[i]);
+        }
+        startFlag = true;
+        for (unsigned int i = 0; i < threads; ++i)
+            workers[i].Join();
+        const double aggregate = Report(threads, &results[0], baseline);
+        if (1 == threads)
+            baseline = aggregate;
+    }
+    cout << endl;
+
+    assert( (!Loki::AllocatorSingleton<>::IsCorrupted()) );
+}
+
+} // end namespace MtBench
+
+#endif // LOKI_CLASS_LEVEL_THREADING
+
+// ----------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
 {
     DoSingleThreadTest();
 
 #if defined(LOKI_CLASS_LEVEL_THREADING)
     DoClassLockTest();
+    MtBench::DoMultiThreadedTest( argc > 1 ? argv[1] : 0 );
+#else
+    (void)argc;
+    (void)argv;
 #endif
 
     return 0;
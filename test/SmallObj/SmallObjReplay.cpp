@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Replay driver for SmallObjAllocator traces.
+//
+// A program built with LOKI_SMALL_OBJECT_ALLOC_TRACE records its pool
+// operations with SmallObjTracer::Start / Stop.  This driver re-executes such
+// a trace against the allocator as configured in this build, so chunk-size
+// and magazine-depth choices are judged against a real workload instead of a
+// synthetic loop:
+//
+//     SmallObjReplay <trace-file> [size:chunkSize:reserve:maxChunks]...
+//
+// Each optional size:chunkSize:reserve:maxChunks argument is applied through
+// SmallObjAllocator::ConfigureSizeClass before the replay starts; rebuild
+// with -DLOKI_DEFAULT_CHUNK_SIZE=... (or the thread-cache / magazine macros)
+// to evaluate compile-time choices.  The replay is single-threaded and
+// preserves the recorded global order; the per-record thread id is reported
+// in the workload summary but not re-threaded.
+//
+// ----------------------------------------------------------------------------
+
+// Only for the declaration of SmallObjTracer::Record describing the trace
+// file format; this program records nothing and never calls Start.
+#define LOKI_SMALL_OBJECT_ALLOC_TRACE
+
+#include <loki/SmallObj.h>
+#include "../benchmark.h"
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+typedef Loki::SmallObjTracer::Record Record;
+typedef Loki::AllocatorSingleton<> Alloc;
+
+// ----------------------------------------------------------------------------
+
+static bool LoadTrace( const char * path, vector< Record > & records )
+{
+    FILE * file = fopen( path, "rb" );
+    if ( 0 == file )
+    {
+        cout << "cannot open trace file '" << path << "'" << endl;
+        return false;
+    }
+    unsigned char header[ 8 ] = { 0 };
+    if ( ( sizeof( header ) != fread( header, 1, sizeof( header ), file ) )
+        || ( 'L' != header[ 0 ] ) || ( 'K' != header[ 1 ] )
+        || ( 'S' != header[ 2 ] ) || ( 'O' != header[ 3 ] ) )
+    {
+        cout << "'" << path << "' is not a SmallObjTracer trace" << endl;
+        fclose( file );
+        return false;
+    }
+    if ( ( 1 != header[ 4 ] ) || ( sizeof( Record ) != header[ 5 ] )
+        || ( sizeof( size_t ) != header[ 6 ] ) )
+    {
+        cout << "trace format or platform width mismatch; "
+            "replay on the platform that recorded the trace" << endl;
+        fclose( file );
+        return false;
+    }
+    Record record;
+    while ( 1 == fread( &record, sizeof( record ), 1, file ) )
+        records.push_back( record );
+    fclose( file );
+    return !records.empty();
+}
+
+// ----------------------------------------------------------------------------
+
+/// One replay pass over the whole trace.  Returns false when the trace is
+/// inconsistent (a free without a matching allocation).
+static bool ReplayOnce( const vector< Record > & records,
+    unsigned long & failedAllocs )
+{
+    Alloc & allocator = Alloc::Instance();
+    map< size_t, pair< void *, unsigned int > > live;
+    bool consistent = true;
+    for ( vector< Record >::const_iterator it = records.begin();
+        it != records.end(); ++it )
+    {
+        if ( Loki::SmallObjTracer::OpAllocate == it->op )
+        {
+            void * p = allocator.Allocate( it->size, false );
+            if ( 0 == p )
+            {
+                ++failedAllocs;
+                continue;
+            }
+            live[ it->slot ] = make_pair( p, it->size );
+        }
+        else
+        {
+            map< size_t, pair< void *, unsigned int > >::iterator found =
+                live.find( it->slot );
+            if ( live.end() == found )
+            {
+                consistent = false;
+                continue;
+            }
+            allocator.Deallocate( found->second.first, found->second.second );
+            live.erase( found );
+        }
+    }
+    // anything still live at the end of the trace dies now, off the clock
+    // of nothing - leftovers are part of the workload too
+    for ( map< size_t, pair< void *, unsigned int > >::iterator it =
+        live.begin(); it != live.end(); ++it )
+        allocator.Deallocate( it->second.first, it->second.second );
+    return consistent;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, char * argv[] )
+{
+    if ( argc < 2 )
+    {
+        cout << "usage: " << argv[ 0 ]
+            << " <trace-file> [size:chunkSize:reserve:maxChunks]..." << endl;
+        return 1;
+    }
+
+    vector< Record > records;
+    if ( !LoadTrace( argv[ 1 ], records ) )
+        return 1;
+
+    // summarize the workload before touching the allocator
+    map< unsigned int, unsigned long > sizeHistogram;
+    unsigned long allocs = 0;
+    unsigned long frees = 0;
+    unsigned int threadsSeen = 0;
+    bool threadPresent[ 256 ] = { false };
+    for ( vector< Record >::const_iterator it = records.begin();
+        it != records.end(); ++it )
+    {
+        if ( Loki::SmallObjTracer::OpAllocate == it->op )
+        {
+            ++allocs;
+            ++sizeHistogram[ it->size ];
+        }
+        else
+            ++frees;
+        if ( !threadPresent[ it->thread ] )
+        {
+            threadPresent[ it->thread ] = true;
+            ++threadsSeen;
+        }
+    }
+    cout << "trace: " << records.size() << " records, " << allocs
+        << " allocations, " << frees << " frees, recorded on "
+        << threadsSeen << " thread(s)" << endl;
+    cout << "size classes:";
+    for ( map< unsigned int, unsigned long >::const_iterator it =
+        sizeHistogram.begin(); it != sizeHistogram.end(); ++it )
+        cout << "  " << it->first << "B x" << it->second;
+    cout << endl;
+
+    // apply per-size-class configuration before the allocator's first use
+    for ( int arg = 2; arg < argc; ++arg )
+    {
+        unsigned long size = 0;
+        unsigned long chunkSize = 0;
+        unsigned long reserve = 0;
+        unsigned long maxChunks = 0;
+        if ( 4 != sscanf( argv[ arg ], "%lu:%lu:%lu:%lu",
+            &size, &chunkSize, &reserve, &maxChunks ) )
+        {
+            cout << "bad configuration argument '" << argv[ arg ] << "'" << endl;
+            return 1;
+        }
+        if ( !Alloc::Instance().ConfigureSizeClass( size, chunkSize,
+            reserve, maxChunks ) )
+        {
+            cout << "ConfigureSizeClass refused " << argv[ arg ] << endl;
+            return 1;
+        }
+        cout << "configured size " << size << ": chunkSize " << chunkSize
+            << ", reserve " << reserve << ", maxChunks " << maxChunks << endl;
+    }
+
+    // one warm-up pass which also validates the trace, then timed passes
+    unsigned long failedAllocs = 0;
+    if ( !ReplayOnce( records, failedAllocs ) )
+        cout << "warning: trace frees blocks it never allocated; "
+            "those records are skipped" << endl;
+
+    const unsigned long runs = 5;
+    ::std::vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        ReplayOnce( records, failedAllocs );
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / records.size() );
+    }
+    const double nsPerOp = LokiBench::Median( samples );
+
+    cout << "replay: " << nsPerOp << " ns/op median of " << runs << " runs";
+    if ( 0 != failedAllocs )
+        cout << ", " << failedAllocs << " failed allocations";
+    cout << endl;
+
+    if ( Alloc::IsCorrupted() )
+    {
+        cout << "allocator corrupted after replay" << endl;
+        return 1;
+    }
+    Alloc::ClearExtraMemory();
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
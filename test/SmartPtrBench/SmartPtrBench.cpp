@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// Measures the policy space of SmartPtr and StrongPtr, so the choice of an
+// ownership policy rests on ns/op from this codebase instead of guesses.
+// For every policy the single-threaded table reports
+//   - create     construct a pointer around a fresh pointee and release it;
+//   - copy       copy the pointer (DeepCopy pays a Clone here) and drop it;
+//   - transfer   hand ownership over via Swap - what a move costs;
+//   - deref      read through operator->.
+// The multithreaded stress then has several threads copy, dereference and
+// drop the same shared object as fast as they can, which is where the
+// atomic policies (RefCountedAtomic, RefLinkedAtomic) should prove their
+// gains against the mutex-based ones (RefCountedMTAdj,
+// LockableTwoRefCounts).
+//
+// The mutex-based policies and AtomicTwoRefCounts only exist under a Loki
+// threading macro, and the library must be built with the same macro, e.g.
+//     make CPPFLAGS=-DLOKI_CLASS_LEVEL_THREADING       (here and in src/)
+// A stock single-threaded build still measures everything else, including
+// the atomic policies, which rely on the compiler builtins alone.
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/SmartPtr.h>
+#include <loki/StrongPtr.h>
+#include "../benchmark.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#if defined(LOKI_CLASS_LEVEL_THREADING) || defined(LOKI_OBJECT_LEVEL_THREADING)
+    #define SMARTPTR_BENCH_MUTEX_POLICIES
+#endif
+
+// The stress needs only a native thread, not a Loki threading model; the
+// atomic policies are exercised even in a stock build.
+#if defined(SMARTPTR_BENCH_MUTEX_POLICIES) || !defined(_MSC_VER)
+    #define SMARTPTR_BENCH_THREADS
+    #if defined(_WIN32)
+        #include <process.h>
+        #include <windows.h>
+    #else
+        #include <pthread.h>
+    #endif
+#endif
+
+using namespace std;
+
+static const unsigned long runs = 5;
+static const unsigned long iterations = 200000;
+
+// ----------------------------------------------------------------------------
+
+/// The pointee: intrusively countable for IntrusiveRefCounted and clonable
+/// for DeepCopy, so one class serves every policy.
+struct Thing : public Loki::IntrusiveRefCount
+{
+    int value;
+    Thing( void ) : value( 42 ) {}
+    Thing * Clone( void ) const { return new Thing( *this ); }
+};
+
+// ----------------------------------------------------------------------------
+
+/// ns per construct-and-release of a pointer around a fresh pointee; the
+/// pointee's new/delete is part of the price, identical for every policy.
+template < class Ptr >
+double TimeCreate( void )
+{
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        for ( unsigned long i = 0; i < iterations; ++i )
+        {
+            Ptr p( new Thing );
+            LokiBench::DoNotOptimize( p );
+        }
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / iterations );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// ns per copy-and-drop of an existing pointer.
+template < class Ptr >
+double TimeCopy( void )
+{
+    Ptr original( new Thing );
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        for ( unsigned long i = 0; i < iterations; ++i )
+        {
+            Ptr copy( original );
+            LokiBench::DoNotOptimize( copy );
+        }
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / iterations );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// ns per ownership transfer via Swap - the repeated swap is two transfers,
+/// so the loop body counts double.
+template < class Ptr >
+double TimeTransfer( void )
+{
+    Ptr a( new Thing );
+    Ptr b( new Thing );
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        for ( unsigned long i = 0; i < iterations; ++i )
+        {
+            a.Swap( b );
+            LokiBench::DoNotOptimize( a );
+        }
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / iterations );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// ns per read through operator->.
+template < class Ptr >
+double TimeDeref( void )
+{
+    Ptr p( new Thing );
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        long sum = 0;
+        watch.Start();
+        for ( unsigned long i = 0; i < iterations; ++i )
+            sum += p->value;
+        watch.Stop();
+        LokiBench::DoNotOptimize( sum );
+        samples.push_back( watch.Nanoseconds() / iterations );
+    }
+    return LokiBench::Median( samples );
+}
+
+template < class Ptr >
+void BenchPointer( const char * policy )
+{
+    ::std::printf( "    %-22s %9.1f %9.1f %9.1f %9.1f\n", policy,
+        TimeCreate< Ptr >(), TimeCopy< Ptr >(),
+        TimeTransfer< Ptr >(), TimeDeref< Ptr >() );
+}
+
+// ----------------------------------------------------------------------------
+
+#ifdef SMARTPTR_BENCH_THREADS
+
+namespace MtBench
+{
+    volatile bool startFlag = false;
+
+    inline void WaitForStart( void )
+    {
+        while ( !startFlag ) {}
+    }
+
+    /// Copies the shared pointer, dereferences the copy and drops it, as a
+    /// request handler holding a shared object for its lifetime would.
+    template < class Ptr >
+    struct ShareWorker
+    {
+        const Ptr * shared;
+        double nsPerOp;
+
+        static void * Run( void * self )
+        {
+            ShareWorker * worker = static_cast< ShareWorker * >( self );
+            WaitForStart();
+            LokiBench::Stopwatch watch;
+            long sum = 0;
+            watch.Start();
+            for ( unsigned long i = 0; i < iterations; ++i )
+            {
+                Ptr copy( *worker->shared );
+                sum += copy->value;
+            }
+            watch.Stop();
+            LokiBench::DoNotOptimize( sum );
+            worker->nsPerOp = watch.Nanoseconds() / iterations;
+            return 0;
+        }
+    };
+
+    class BenchThread
+    {
+    public:
+        void Start( void * ( *callback )( void * ), void * parameter )
+        {
+#if defined(_WIN32)
+            handle_ = ( HANDLE )_beginthreadex( 0, 0,
+                ( unsigned ( __stdcall * )( void * ) )callback, parameter, 0, 0 );
+#else
+            ::pthread_create( &handle_, 0, callback, parameter );
+#endif
+        }
+        void Join( void )
+        {
+#if defined(_WIN32)
+            ::WaitForSingleObject( handle_, INFINITE );
+            ::CloseHandle( handle_ );
+#else
+            ::pthread_join( handle_, 0 );
+#endif
+        }
+    private:
+#if defined(_WIN32)
+        HANDLE handle_;
+#else
+        pthread_t handle_;
+#endif
+    };
+
+    /// Worst thread's ns per copy-deref-drop with threadCount threads
+    /// hammering one shared object.
+    template < class Ptr >
+    double RunThreads( unsigned int threadCount )
+    {
+        Ptr shared( new Thing );
+        ::std::vector< ShareWorker< Ptr > > workers( threadCount );
+        ::std::vector< BenchThread > threads( threadCount );
+        startFlag = false;
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            workers[ t ].shared = &shared;
+            threads[ t ].Start( &ShareWorker< Ptr >::Run, &workers[ t ] );
+        }
+        startFlag = true;
+        double worst = 0.0;
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            threads[ t ].Join();
+            if ( workers[ t ].nsPerOp > worst )
+                worst = workers[ t ].nsPerOp;
+        }
+        return worst;
+    }
+
+    template < class Ptr >
+    void BenchShared( const char * policy )
+    {
+        ::std::printf( "    %-22s %9.1f %9.1f %9.1f\n", policy,
+            RunThreads< Ptr >( 1 ), RunThreads< Ptr >( 2 ),
+            RunThreads< Ptr >( 4 ) );
+    }
+}
+
+#endif // SMARTPTR_BENCH_THREADS
+
+// ----------------------------------------------------------------------------
+
+typedef Loki::SmartPtr< Thing > RefCountedPtr;
+typedef Loki::SmartPtr< Thing, Loki::RefLinked > RefLinkedPtr;
+typedef Loki::SmartPtr< Thing, Loki::DeepCopy > DeepCopyPtr;
+typedef Loki::SmartPtr< Thing, Loki::IntrusiveRefCounted > IntrusivePtr;
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+typedef Loki::SmartPtr< Thing, Loki::RefCountedAtomic > RefCountedAtomicPtr;
+typedef Loki::SmartPtr< Thing, Loki::RefLinkedAtomic > RefLinkedAtomicPtr;
+#endif
+typedef Loki::StrongPtr< Thing > TwoRefCountsPtr;
+#ifdef SMARTPTR_BENCH_MUTEX_POLICIES
+typedef Loki::SmartPtr< Thing,
+    Loki::RefCountedMTAdj< Loki::ClassLevelLockable >::RefCountedMT >
+    RefCountedMTPtr;
+typedef Loki::StrongPtr< Thing, true, Loki::LockableTwoRefCounts >
+    LockableTwoRefCountsPtr;
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+typedef Loki::StrongPtr< Thing, true, Loki::AtomicTwoRefCounts >
+    AtomicTwoRefCountsPtr;
+#endif
+#endif
+
+int main( void )
+{
+    cout << "SmartPtr / StrongPtr policy matrix (ns per operation)" << endl;
+    cout << endl;
+
+    ::std::printf( "    %-22s %9s %9s %9s %9s\n",
+        "policy", "create", "copy", "transfer", "deref" );
+    BenchPointer< RefCountedPtr >( "RefCounted" );
+    BenchPointer< RefLinkedPtr >( "RefLinked" );
+    BenchPointer< DeepCopyPtr >( "DeepCopy" );
+    BenchPointer< IntrusivePtr >( "IntrusiveRefCounted" );
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+    BenchPointer< RefCountedAtomicPtr >( "RefCountedAtomic" );
+    BenchPointer< RefLinkedAtomicPtr >( "RefLinkedAtomic" );
+#endif
+    BenchPointer< TwoRefCountsPtr >( "TwoRefCounts" );
+#ifdef SMARTPTR_BENCH_MUTEX_POLICIES
+    BenchPointer< RefCountedMTPtr >( "RefCountedMTAdj" );
+    BenchPointer< LockableTwoRefCountsPtr >( "LockableTwoRefCounts" );
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+    BenchPointer< AtomicTwoRefCountsPtr >( "AtomicTwoRefCounts" );
+#endif
+#else
+    cout << endl
+         << "  (build with a LOKI threading macro for RefCountedMTAdj,"
+         << endl
+         << "   LockableTwoRefCounts and AtomicTwoRefCounts)" << endl;
+#endif
+
+#ifdef SMARTPTR_BENCH_THREADS
+    cout << endl
+         << "  Shared-object stress: copy, deref, drop one shared pointee"
+         << endl << "  (worst thread, ns per operation)" << endl;
+    ::std::printf( "    %-22s %9s %9s %9s\n",
+        "policy", "1 thread", "2 threads", "4 threads" );
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+    MtBench::BenchShared< RefCountedAtomicPtr >( "RefCountedAtomic" );
+    MtBench::BenchShared< RefLinkedAtomicPtr >( "RefLinkedAtomic" );
+#endif
+#ifdef SMARTPTR_BENCH_MUTEX_POLICIES
+    MtBench::BenchShared< RefCountedMTPtr >( "RefCountedMTAdj" );
+    MtBench::BenchShared< LockableTwoRefCountsPtr >( "LockableTwoRefCounts" );
+#ifdef LOKI_SMARTPTR_ATOMIC_REFCOUNT
+    MtBench::BenchShared< AtomicTwoRefCountsPtr >( "AtomicTwoRefCounts" );
+#endif
+#endif
+#endif // SMARTPTR_BENCH_THREADS
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+// ----------------------------------------------------------------------------
+//
+// yasli::vector exists to be faster than std::vector, through the
+// move-traits protocol dispatch of yasli_protocols.h; this benchmark is
+// the proof - or the regression alarm.  For each element type it times,
+// in ns per element:
+//   - push_back    growth from empty with no reserve, where every
+//                  reallocation relocates the whole array;
+//   - insert-mid   single-element inserts in the middle, all shifting;
+//   - erase-mid    single-element erases from the middle;
+//   - resize       alternating grow and shrink cycles.
+// The element types walk the protocol's cases:
+//   - int          a non-class: both libraries relocate raw bits;
+//   - Point        a plain class, which the default (safe) traits move
+//                  one copy construction at a time;
+//   - MovablePoint the same three doubles, but with move_traits
+//                  specialized to memmove_traits - the line of code the
+//                  whole machinery asks its users to write;
+//   - Heavy        deep-copying owner of a heap block, safe traits for
+//                  everyone, measuring plain abstraction overhead.
+// The int section adds a yasli/realloc row - vector backed by
+// mallocator, whose allocator_traits grow through realloc and can often
+// extend in place - to evaluate the realloc-growth feature by itself.
+// A final section pushes vectors of vectors: the nested specialization
+// in yasli_vector.h makes the inner vectors relocatable, the classic
+// relocation-heavy workload where std::vector deep-copies on growth.
+//
+// ----------------------------------------------------------------------------
+
+#include <loki/yasli/yasli_vector.h>
+#include "../benchmark.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static const unsigned long runs = 5;
+
+// ----------------------------------------------------------------------------
+
+/// A plain class: three doubles behind a constructor.  is_class is
+/// true, so the unspecialized protocol moves it the safe way.
+struct Point
+{
+    double x, y, z;
+    Point( void ) : x( 0 ), y( 0 ), z( 0 ) {}
+    explicit Point( double seed ) : x( seed ), y( seed + 1 ), z( seed + 2 ) {}
+};
+
+/// The same three doubles; the specializations below tell yasli its
+/// bits may be relocated wholesale.
+struct MovablePoint
+{
+    double x, y, z;
+    MovablePoint( void ) : x( 0 ), y( 0 ), z( 0 ) {}
+    explicit MovablePoint( double seed ) : x( seed ), y( seed + 1 ), z( seed + 2 ) {}
+};
+
+/// Owns a heap block and copies deep: no protocol can relocate it, so
+/// this type measures the bare container overhead.
+struct Heavy
+{
+    int * block;
+    Heavy( void ) : block( new int[ 16 ] )
+    {
+        ::std::memset( block, 0, 16 * sizeof(int) );
+    }
+    Heavy( const Heavy & rhs ) : block( new int[ 16 ] )
+    {
+        ::std::memcpy( block, rhs.block, 16 * sizeof(int) );
+    }
+    Heavy & operator = ( const Heavy & rhs )
+    {
+        ::std::memcpy( block, rhs.block, 16 * sizeof(int) );
+        return *this;
+    }
+    ~Heavy( void )
+    {
+        delete [] block;
+    }
+};
+
+namespace yasli_nstd
+{
+    template <> struct is_memcopyable< MovablePoint >
+    {
+        enum { value = true };
+    };
+}
+
+namespace yasli_protocols
+{
+    template <> struct move_traits< MovablePoint >
+        : public memmove_traits< MovablePoint >
+    {
+    };
+}
+
+// ----------------------------------------------------------------------------
+
+inline void MakeElem( size_t seed, int & elem )
+{
+    elem = static_cast< int >( seed );
+}
+
+inline void MakeElem( size_t seed, Point & elem )
+{
+    elem = Point( static_cast< double >( seed ) );
+}
+
+inline void MakeElem( size_t seed, MovablePoint & elem )
+{
+    elem = MovablePoint( static_cast< double >( seed ) );
+}
+
+inline void MakeElem( size_t seed, Heavy & elem )
+{
+    elem.block[ 0 ] = static_cast< int >( seed );
+}
+
+// ----------------------------------------------------------------------------
+
+/// Median ns per element for growing from empty, no reserve: the price
+/// of the appends plus every relocation along the doubling curve.
+template < class Vec >
+double TimePushBack( size_t count )
+{
+    typename Vec::value_type elem;
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Vec v;
+        watch.Start();
+        for ( size_t i = 0; i < count; ++i )
+        {
+            MakeElem( i, elem );
+            v.push_back( elem );
+        }
+        watch.Stop();
+        LokiBench::DoNotOptimize( v );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( count ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per insert of ops single elements in the middle of a
+/// vector holding base elements; every insert shifts half the array.
+template < class Vec >
+double TimeInsertMid( size_t base, size_t ops )
+{
+    typename Vec::value_type elem;
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Vec v;
+        for ( size_t i = 0; i < base; ++i )
+        {
+            MakeElem( i, elem );
+            v.push_back( elem );
+        }
+        watch.Start();
+        for ( size_t i = 0; i < ops; ++i )
+        {
+            MakeElem( base + i, elem );
+            v.insert( v.begin() + static_cast< ptrdiff_t >( v.size() / 2 ), elem );
+        }
+        watch.Stop();
+        LokiBench::DoNotOptimize( v );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( ops ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per erase of ops single elements from the middle.
+template < class Vec >
+double TimeEraseMid( size_t base, size_t ops )
+{
+    typename Vec::value_type elem;
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Vec v;
+        for ( size_t i = 0; i < base; ++i )
+        {
+            MakeElem( i, elem );
+            v.push_back( elem );
+        }
+        watch.Start();
+        for ( size_t i = 0; i < ops; ++i )
+            v.erase( v.begin() + static_cast< ptrdiff_t >( v.size() / 2 ) );
+        watch.Stop();
+        LokiBench::DoNotOptimize( v );
+        samples.push_back( watch.Nanoseconds() / static_cast< double >( ops ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+/// Median ns per element over alternating resize cycles: grow to count,
+/// shrink to half, eight times.
+template < class Vec >
+double TimeResize( size_t count )
+{
+    const unsigned long cycles = 8;
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Vec v;
+        watch.Start();
+        for ( unsigned long c = 0; c < cycles; ++c )
+        {
+            v.resize( count );
+            v.resize( count / 2 );
+        }
+        watch.Stop();
+        LokiBench::DoNotOptimize( v );
+        samples.push_back( watch.Nanoseconds()
+            / static_cast< double >( count * cycles ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+// ----------------------------------------------------------------------------
+
+template < class Vec >
+void BenchOneVector( const char * container, size_t pushCount,
+    size_t base, size_t ops )
+{
+    ::std::printf( "    %-14s %10.1f %10.1f %10.1f %10.1f\n", container,
+        TimePushBack< Vec >( pushCount ),
+        TimeInsertMid< Vec >( base, ops ),
+        TimeEraseMid< Vec >( base, ops ),
+        TimeResize< Vec >( pushCount ) );
+}
+
+template < class Elem >
+void BenchElemType( const char * elemName, size_t pushCount,
+    size_t base, size_t ops, bool reallocRow )
+{
+    ::std::printf( "  %s elements (ns per element)\n", elemName );
+    ::std::printf( "    %-14s %10s %10s %10s %10s\n",
+        "container", "push_back", "insert-mid", "erase-mid", "resize" );
+    BenchOneVector< yasli::vector< Elem > >( "yasli",
+        pushCount, base, ops );
+    if ( reallocRow )
+        BenchOneVector< yasli::vector< Elem, yasli_nstd::mallocator< Elem > > >(
+            "yasli/realloc", pushCount, base, ops );
+    BenchOneVector< std::vector< Elem > >( "std",
+        pushCount, base, ops );
+    ::std::printf( "\n" );
+}
+
+// ----------------------------------------------------------------------------
+
+/// The relocation-heavy finale: growing an outer vector whose elements
+/// are vectors.  yasli relocates the inner vectors by memmove through
+/// the nested move_traits specialization; std::vector of C++98 copies
+/// every inner buffer on every growth step.
+template < class Outer, class Inner >
+double TimeNested( size_t outerCount, size_t innerSize )
+{
+    Inner inner;
+    for ( size_t i = 0; i < innerSize; ++i )
+        inner.push_back( static_cast< int >( i ) );
+    vector< double > samples;
+    LokiBench::Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        Outer outer;
+        watch.Start();
+        for ( size_t i = 0; i < outerCount; ++i )
+            outer.push_back( inner );
+        watch.Stop();
+        LokiBench::DoNotOptimize( outer );
+        samples.push_back( watch.Nanoseconds()
+            / static_cast< double >( outerCount ) );
+    }
+    return LokiBench::Median( samples );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( void )
+{
+    const size_t pushCount = 65536;
+    const size_t base = 8192;
+    const size_t ops = 2048;
+
+    cout << "yasli::vector versus std::vector" << endl << endl;
+
+    BenchElemType< int >( "int", pushCount, base, ops, true );
+    BenchElemType< Point >( "plain class", pushCount, base, ops, false );
+    BenchElemType< MovablePoint >( "relocatable class", pushCount, base, ops, false );
+    BenchElemType< Heavy >( "non-trivial", pushCount, base, ops, false );
+
+    ::std::printf( "  vector of 64-int vectors, %lu pushed (ns per push)\n",
+        static_cast< unsigned long >( 4096 ) );
+    ::std::printf( "    %-14s %10s\n", "container", "push_back" );
+    ::std::printf( "    %-14s %10.1f\n", "yasli",
+        TimeNested< yasli::vector< yasli::vector< int > >,
+                    yasli::vector< int > >( 4096, 64 ) );
+    ::std::printf( "    %-14s %10.1f\n", "std",
+        TimeNested< std::vector< std::vector< int > >,
+                    std::vector< int > >( 4096, 64 ) );
+
+    return 0;
+}
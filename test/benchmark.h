@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// The Loki Library
+// Copyright (c) 2009 by Rich Sposato
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+/// @file benchmark.h Measurement core shared by the Loki benchmarks.
+///
+/// The old test/SmallObj/timer.h measured with clock(), whose granularity is
+/// around ten milliseconds - fine for a million-iteration loop, useless for
+/// nanosecond-scale paths like one Functor invocation or one SmartPtr copy.
+/// This header provides what every benchmark needs and none should reinvent:
+///  - a monotonic nanosecond clock and a raw cycle counter,
+///  - compiler barriers so measured code is neither hoisted nor discarded,
+///  - warmed-up, repeated measurement returning the median of several runs,
+///  - a drop-in replacement for the old Timer with the same printing so the
+///    existing benchmark output stays comparable.
+/// Everything lives in namespace LokiBench and depends only on the standard
+/// library and the platform clock.
+
+#ifndef LOKI_TEST_BENCHMARK_H
+#define LOKI_TEST_BENCHMARK_H
+
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <cmath>
+
+#if defined( _MSC_VER )
+    #include <windows.h>
+    #include <intrin.h>
+#else
+    #include <time.h>
+#endif
+
+
+namespace LokiBench
+{
+
+#if defined( _MSC_VER )
+    typedef unsigned __int64 CountType;
+#else
+    typedef unsigned long long CountType;
+#endif
+
+// ----------------------------------------------------------------------------
+
+/** Returns the monotonic clock in nanoseconds.  Only differences are
+ meaningful.  Resolution is whatever the platform's best steady clock gives -
+ tens of nanoseconds on common systems, against the ~10ms of clock().
+ */
+inline CountType NowNanoseconds( void )
+{
+#if defined( _MSC_VER )
+    static LARGE_INTEGER frequency = { 0 };
+    if ( 0 == frequency.QuadPart )
+        ::QueryPerformanceFrequency( &frequency );
+    LARGE_INTEGER counter;
+    ::QueryPerformanceCounter( &counter );
+    return static_cast< CountType >(
+        counter.QuadPart * 1000000000.0 / frequency.QuadPart );
+#else
+    timespec now;
+    ::clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast< CountType >( now.tv_sec ) * 1000000000u
+        + static_cast< CountType >( now.tv_nsec );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+/** Returns the processor's cycle counter where one exists, the nanosecond
+ clock otherwise.  Cycles are the right unit when counting what one operation
+ costs; beware that on old multi-socket machines the counters of different
+ processors may not be synchronized, so pin the benchmark thread.
+ */
+inline CountType ReadCycles( void )
+{
+#if defined( _MSC_VER )
+    return __rdtsc();
+#elif defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+    unsigned int lo, hi;
+    __asm__ __volatile__ ( "rdtsc" : "=a" ( lo ), "=d" ( hi ) );
+    return ( static_cast< CountType >( hi ) << 32 ) | lo;
+#else
+    return NowNanoseconds();
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+/** Keeps the value alive in the eyes of the optimizer, so a computed result
+ the benchmark otherwise ignores is not deleted along with the code computing
+ it.  Costs no instruction with gcc; with other compilers it costs one store.
+ */
+template < typename T >
+inline void DoNotOptimize( T & value )
+{
+#if defined( __GNUC__ )
+    __asm__ __volatile__ ( "" : : "g" ( &value ) : "memory" );
+#else
+    static volatile const void * sink;
+    sink = &value;
+#endif
+}
+
+/** Forces the compiler to assume all memory changed, so stores are neither
+ moved out of the measured region nor deferred past the stop of the clock.
+ */
+inline void ClobberMemory( void )
+{
+#if defined( __GNUC__ )
+    __asm__ __volatile__ ( "" : : : "memory" );
+#elif defined( _MSC_VER )
+    ::_ReadWriteBarrier();
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+/** @class Stopwatch
+ Measures one interval in both nanoseconds and cycles.  Start and Stop place
+ compiler barriers so measured code cannot drift outside the interval.
+ */
+class Stopwatch
+{
+public:
+
+    Stopwatch( void ) : ns0_( 0 ), ns1_( 0 ), cycles0_( 0 ), cycles1_( 0 ) {}
+
+    void Start( void )
+    {
+        ClobberMemory();
+        ns0_ = NowNanoseconds();
+        cycles0_ = ReadCycles();
+    }
+
+    void Stop( void )
+    {
+        ClobberMemory();
+        cycles1_ = ReadCycles();
+        ns1_ = NowNanoseconds();
+    }
+
+    double Nanoseconds( void ) const
+    {
+        return static_cast< double >( ns1_ - ns0_ );
+    }
+
+    double Cycles( void ) const
+    {
+        return static_cast< double >( cycles1_ - cycles0_ );
+    }
+
+private:
+    CountType ns0_;
+    CountType ns1_;
+    CountType cycles0_;
+    CountType cycles1_;
+};
+
+// ----------------------------------------------------------------------------
+
+/// Returns the median of the measurements - the honest middle of repeated
+/// runs, unlike the mean which one descheduling can ruin.
+inline double Median( ::std::vector< double > & runs )
+{
+    if ( runs.empty() )
+        return 0.0;
+    ::std::sort( runs.begin(), runs.end() );
+    const ::std::size_t middle = runs.size() / 2;
+    if ( 1 == ( runs.size() % 2 ) )
+        return runs[ middle ];
+    return ( runs[ middle - 1 ] + runs[ middle ] ) / 2.0;
+}
+
+// ----------------------------------------------------------------------------
+
+/** Measures a callable and returns the median nanoseconds per iteration.
+ The operation runs warmupIterations times unmeasured first - so caches,
+ branch predictors and lazy singletons settle - and then runs times for
+ iterations each, clocked with Stopwatch; the median run wins.  The operation
+ is any function or functor callable as op().  Use DoNotOptimize inside the
+ operation when its result would otherwise be dead.
+ */
+template < class Operation >
+double MeasureNsPerIteration( Operation op, unsigned long iterations,
+    unsigned long runs = 5, unsigned long warmupIterations = 1000 )
+{
+    for ( unsigned long w = 0; w < warmupIterations; ++w )
+        op();
+    ::std::vector< double > samples;
+    samples.reserve( runs );
+    Stopwatch watch;
+    for ( unsigned long r = 0; r < runs; ++r )
+    {
+        watch.Start();
+        for ( unsigned long i = 0; i < iterations; ++i )
+            op();
+        watch.Stop();
+        samples.push_back( watch.Nanoseconds() / iterations );
+    }
+    return Median( samples );
+}
+
+// ----------------------------------------------------------------------------
+
+/** @class Timer
+ Drop-in replacement for the Timer of test/SmallObj/timer.h with the same
+ member names and print format, but running on the monotonic nanosecond clock
+ instead of clock().  Times are reported in milliseconds; relative time and
+ speed-up factors against the stored baseline t100 work exactly as before, so
+ old and new benchmark outputs stay comparable.
+ */
+class Timer
+{
+public:
+
+    Timer()
+    {
+        t100 = 0;
+    }
+
+    void start()
+    {
+        watch_.Start();
+    }
+
+    void stop()
+    {
+        watch_.Stop();
+    }
+
+    /// Elapsed milliseconds of the last interval.
+    double t()
+    {
+        return watch_.Nanoseconds() / 1000000.0;
+    }
+
+    double sec(double t)
+    {
+        return floor(100.0*t/1000.0 )/100.0;
+    }
+
+    int rel(double t)
+    {
+        return ( t100==0 ? 100 : static_cast<int>(floor(100.0*t/t100+0.5)) );
+    }
+
+    double speedup(double t)
+    {
+        return (t!=0 ? floor(100.0*(t100!=0?t100:t)/t+0.5)/100 : 1);
+    }
+
+    double t100;
+
+    void print(double t, const char* s)
+    {
+        std::cout << s << "\tseconds: " << sec(t) << "\trelative time: " << rel(t) << "%\tspeed-up factor: " << speedup(t) << "" << std::endl;
+    }
+
+private:
+    Stopwatch watch_;
+};
+
+// ----------------------------------------------------------------------------
+
+} // end namespace LokiBench
+
+#endif // end file guardian
@@ -956,6 +956,34 @@ void Compare()
             const my_string tested(Test(sample, 1, false));
             checkResults(reference, tested);
         }
+        {
+            srand(t);
+            typedef VectorStringStorage<char, std::allocator<char> >
+                Storage;
+            typedef flex_string<
+                char,
+                std::char_traits<char>,
+                std::allocator<char>,
+                CompactStringOpt<Storage, 23>
+            > my_string;
+            static my_string sample;
+            const my_string tested(Test(sample, 1, false));
+            checkResults(reference, tested);
+        }
+        {
+            srand(t);
+            typedef AllocatorStringStorage<char, std::allocator<char> >
+                Storage;
+            typedef flex_string<
+                char,
+                std::char_traits<char>,
+                std::allocator<char>,
+                SegmentedStringOpt<Storage, 64>
+            > my_string;
+            static my_string sample;
+            const my_string tested(Test(sample, 1, false));
+            checkResults(reference, tested);
+        }
         {
             srand(t);
             typedef SimpleStringStorage<char, std::allocator<char> >